@@ -0,0 +1,274 @@
+/**
+    benchAuth.c - Measure logins with and without the verified credential cache
+
+    Models clients that send Basic credentials with every request. Each login verifies the password via the route
+    auth store and creates the authenticated session as httpLogin does for a request. The slow store models a store
+    with an expensive password hash such as PAM by iterating MD5. Before timing, cached logins are checked to reject
+    wrong passwords and to be invalidated by removing users, changing roles and expiry, and routes with the same realm
+    but different users are checked not to share verified credentials.
+
+        internal    Internal store which verifies with a single MD5. Not cached.
+        slow        Expensive store without the cache
+        cached      Expensive store with the cache
+
+    Build from the repository top directory after building the libraries:
+
+        gcc -O2 -o benchAuth bench/benchAuth.c -Ilinux-x64-default/inc -Llinux-x64-default/bin -lhttp -lmpr \
+            -lpcre -lpthread -lm -ldl -Wl,-rpath,linux-x64-default/bin
+
+    Usage: benchAuth [users [iterations]]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "http.h"
+
+/*********************************** Locals ***********************************/
+
+#define ROUNDS      1000
+#define REALM       "example.com"
+
+static Http         *http;
+static HttpConn     *conn;
+static char         **users;
+static int          verifications;
+
+/************************************* Code ***********************************/
+
+static double now()
+{
+    struct timeval  tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+static char *slowHash(cchar *username, cchar *password)
+{
+    char    *hash;
+    int     i;
+
+    hash = mprGetMD5(sfmt("%s:%s:%s", username, REALM, password));
+    for (i = 1; i < ROUNDS; i++) {
+        hash = mprGetMD5(hash);
+    }
+    return hash;
+}
+
+
+static bool slowVerifyUser(HttpConn *conn, cchar *username, cchar *password)
+{
+    HttpAuth    *auth;
+
+    verifications++;
+    auth = conn->rx->route->auth;
+    if (!conn->user && (conn->user = mprLookupKey(auth->userCache, username)) == 0) {
+        return 0;
+    }
+    return smatch(slowHash(username, password), conn->user->password);
+}
+
+
+static HttpRoute *createRoute(cchar *store, int count)
+{
+    HttpRoute   *route;
+    char        *password;
+    int         i;
+
+    route = httpCreateRoute(0);
+    httpSetAuthRealm(route->auth, REALM);
+    httpSetAuthType(route->auth, "basic", 0);
+    httpSetAuthStore(route->auth, store);
+    httpAddRole(route->auth, "user", "view");
+    for (i = 0; i < count; i++) {
+        if (smatch(store, "slow")) {
+            password = slowHash(users[i], "secret");
+        } else {
+            password = mprGetMD5(sfmt("%s:%s:%s", users[i], REALM, "secret"));
+        }
+        httpAddUser(route->auth, users[i], password, "user");
+    }
+    return route;
+}
+
+
+/*
+    Login as for a new request on the route
+ */
+static bool login(HttpRoute *route, cchar *username, cchar *password)
+{
+    if (conn->rx) {
+        httpDestroyRx(conn->rx);
+        httpDestroyTx(conn->tx);
+    }
+    conn->rx = httpCreateRx(conn);
+    conn->tx = httpCreateTx(conn, NULL);
+    conn->rx->route = route;
+    conn->user = 0;
+    conn->encoded = 0;
+    return httpLogin(conn, username, password);
+}
+
+
+static int verify(int count)
+{
+    HttpRoute   *route, *other;
+    int         errors, prior;
+
+    errors = 0;
+    route = createRoute("slow", count);
+    mprAddRoot(route);
+
+    /* The second login is verified from the cache */
+    prior = verifications;
+    if (!login(route, users[0], "secret") || !login(route, users[0], "secret") || verifications != prior + 1) {
+        errors++;
+    }
+    if (!conn->user || !smatch(conn->user->name, users[0])) {
+        errors++;
+    }
+    /* Wrong passwords are always verified and rejected */
+    prior = verifications;
+    if (login(route, users[0], "wrong") || login(route, users[0], "wrong") || verifications != prior + 2) {
+        errors++;
+    }
+    /* A route with the same realm and store but different users does not share verified credentials */
+    other = createRoute("slow", 0);
+    mprAddRoot(other);
+    if (login(other, users[0], "secret")) {
+        errors++;
+    }
+    /* Role changes flush the cache */
+    login(route, users[1], "secret");
+    prior = verifications;
+    httpAddRole(route->auth, "admin", "view edit");
+    if (!login(route, users[1], "secret") || verifications != prior + 1) {
+        errors++;
+    }
+    /* Removed users are rejected */
+    httpRemoveUser(route->auth, users[1]);
+    if (login(route, users[1], "secret")) {
+        errors++;
+    }
+    /* Expired credentials are verified again */
+    httpSetAuthCache(http, 1, 0);
+    login(route, users[2], "secret");
+    mprSleep(5);
+    prior = verifications;
+    if (!login(route, users[2], "secret") || verifications != prior + 1) {
+        errors++;
+    }
+    httpSetAuthCache(http, HTTP_AUTH_CACHE_TTL, 0);
+    mprRemoveRoot(other);
+    mprRemoveRoot(route);
+    return errors;
+}
+
+
+static void bench(cchar *name, int count, int iterations)
+{
+    HttpRoute   *route;
+    HttpStats   before, after;
+    double      start, elapsed;
+    int         i, found;
+
+    httpSetAuthStoreCache("slow", smatch(name, "cached"));
+    route = createRoute(smatch(name, "internal") ? "internal" : "slow", count);
+    mprAddRoot(route);
+    httpGetStats(&before);
+    found = 0;
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        found += login(route, users[i % count], "secret");
+        if ((i % 100) == 0) {
+            mprYield(0);
+        }
+    }
+    elapsed = now() - start;
+    httpGetStats(&after);
+    after.authHits -= before.authHits;
+    after.authMisses -= before.authMisses;
+    printf("%-8s %8d %12.2f %14.0f %8.1f%% %12.1f\n", name, count, elapsed * 1e6 / iterations, iterations / elapsed,
+        (after.authHits + after.authMisses) ? after.authHits * 100.0 / (after.authHits + after.authMisses) : 0.0,
+        (after.authSavedTime - before.authSavedTime) / 1000.0);
+    if (found != iterations) {
+        printf("Unexpected login count %d\n", found);
+    }
+    mprRemoveRoot(route);
+}
+
+
+int main(int argc, char **argv)
+{
+    int     count, iterations, errors, i;
+
+    count = (argc > 1) ? atoi(argv[1]) : 100;
+    iterations = (argc > 2) ? atoi(argv[2]) : 20000;
+    if (count < 3) {
+        count = 100;
+    }
+    if (iterations <= 0) {
+        iterations = 20000;
+    }
+    mprCreate(argc, argv, 0);
+    mprStart();
+    http = httpCreate(HTTP_SERVER_SIDE | HTTP_CLIENT_SIDE);
+    httpAddAuthStore("slow", slowVerifyUser);
+    httpSetAuthStoreCache("slow", 1);
+    conn = httpCreateConn(http, NULL, NULL);
+    mprAddRoot(conn);
+    users = mprAlloc(count * sizeof(char*));
+    mprAddRoot(users);
+    for (i = 0; i < count; i++) {
+        users[i] = sfmt("user-%d", i);
+        mprHold(users[i]);
+    }
+    if ((errors = verify(count)) != 0) {
+        printf("Auth cache verification failed with %d errors\n", errors);
+        return 1;
+    }
+    printf("%-8s %8s %12s %14s %9s %12s\n", "Store", "Users", "usec/login", "logins/sec", "hits", "msec saved");
+    bench("internal", count, iterations);
+    bench("slow", count, iterations / 10);
+    bench("cached", count, iterations);
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -0,0 +1,241 @@
+/**
+    benchBatch.c - Measure client request throughput for blocking requests against an asynchronous request batch
+
+    Starts an in-process HTTP server and issues small GET requests over loopback from a single client thread:
+        blocking    One request at a time via httpRequest
+        batch       Requests issued concurrently via httpBatchRequest and completed via callbacks
+
+    Batch tests are run with the client connection pool so completed keep-alive sockets are reused by queued requests.
+    The latency columns are measured from when each request was issued, so include time spent queued.
+
+    Build from the repository top directory after building the libraries:
+
+        gcc -O2 -o benchBatch bench/benchBatch.c -Ilinux-x64-default/inc -Llinux-x64-default/bin -lhttp -lmpr \
+            -lpcre -lpthread -lm -ldl -Wl,-rpath,linux-x64-default/bin
+
+    Usage: benchBatch [requests [concurrency]]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "http.h"
+
+/*********************************** Locals ***********************************/
+
+#define BENCH_PORT      18282
+#define BENCH_URI       "http://127.0.0.1:18282/hello"
+
+typedef struct Bench {
+    int     requests;                   /* Requests per test */
+    int     concurrency;                /* Requests in flight */
+} Bench;
+
+typedef struct Result {
+    MprTicks    *latency;               /* Per request latency */
+    int         count;                  /* Completed requests */
+    int         errors;                 /* Failed requests */
+} Result;
+
+static Http     *http;
+
+/************************************* Code ***********************************/
+
+static void hello(HttpConn *conn)
+{
+    httpSetContentType(conn, "text/plain");
+    httpWrite(conn->writeq, "Hello World\n");
+    httpFinalize(conn);
+}
+
+
+static double now()
+{
+    struct timeval  tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+static int compareTicks(cvoid *a, cvoid *b)
+{
+    MprTicks    x, y;
+
+    x = *(MprTicks*) a;
+    y = *(MprTicks*) b;
+    return (x < y) ? -1 : (x > y);
+}
+
+
+static void report(cchar *mode, Bench *bench, int concurrency, Result *result, double secs)
+{
+    MprTicks    *lat;
+    int         n;
+
+    lat = result->latency;
+    n = result->count;
+    qsort(lat, n, sizeof(MprTicks), compareTicks);
+    printf("%-10s %8d %10d %8d %12.0f %8d %8d %8d\n", mode, concurrency, n, result->errors, n / secs, 
+        n ? (int) lat[n / 2] : 0, n ? (int) lat[n * 99 / 100] : 0, n ? (int) lat[n - 1] : 0);
+    fflush(stdout);
+}
+
+
+static void runBlocking(Bench *bench)
+{
+    Result      result;
+    MprTicks    mark;
+    double      start;
+    char        *response, *err;
+    int         i, requests;
+
+    /* Blocking requests are slow to issue, so use fewer */
+    requests = min(bench->requests, 2000);
+    memset(&result, 0, sizeof(result));
+    result.latency = malloc(requests * sizeof(MprTicks));
+    start = now();
+    for (i = 0; i < requests; i++) {
+        mark = mprGetTicks();
+        if (httpRequest("GET", BENCH_URI, NULL, &response, &err) != 200) {
+            result.errors++;
+        } else {
+            result.latency[result.count++] = mprGetTicks() - mark;
+        }
+    }
+    report("blocking", bench, 1, &result, now() - start);
+    free(result.latency);
+}
+
+
+static void batchDone(HttpBatchRequest *req)
+{
+    Result      *result;
+
+    result = req->data;
+    if (req->status != 200) {
+        result->errors++;
+    } else {
+        result->latency[result->count++] = mprGetTicks() - (req->deadline - MPR_MAX_TIMEOUT);
+    }
+}
+
+
+static void runBatch(Bench *bench, int concurrency)
+{
+    HttpBatch   *batch;
+    Result      result;
+    double      start;
+    int         i;
+
+    memset(&result, 0, sizeof(result));
+    result.latency = malloc(bench->requests * sizeof(MprTicks));
+    httpSetClientPool(http, concurrency, 60 * MPR_TICKS_PER_SEC);
+
+    batch = httpCreateBatch(NULL, concurrency);
+    mprAddRoot(batch);
+    start = now();
+    for (i = 0; i < bench->requests; i++) {
+        /* A long deadline is used so the issue time can be recovered from it */
+        httpBatchRequest(batch, "GET", BENCH_URI, NULL, MPR_MAX_TIMEOUT, batchDone, &result);
+    }
+    if (httpWaitBatch(batch, 120 * MPR_TICKS_PER_SEC) < 0) {
+        fprintf(stderr, "Batch did not complete\n");
+    }
+    report("batch", bench, concurrency, &result, now() - start);
+    mprRemoveRoot(batch);
+    httpSetClientPool(http, 0, 0);
+    free(result.latency);
+}
+
+
+static void runBench(Bench *bench)
+{
+    int     concurrency;
+
+    printf("%-10s %8s %10s %8s %12s %8s %8s %8s\n", "Mode", "Inflight", "Requests", "Errors", "Requests/s", 
+        "p50 ms", "p99 ms", "max ms");
+    runBlocking(bench);
+    for (concurrency = 10; concurrency < bench->concurrency; concurrency *= 10) {
+        runBatch(bench, concurrency);
+    }
+    runBatch(bench, bench->concurrency);
+}
+
+
+int main(int argc, char **argv)
+{
+    HttpEndpoint    *endpoint;
+    HttpLimits      *limits;
+    HttpRoute       *route;
+    Bench           bench;
+
+    bench.requests = (argc > 1) ? atoi(argv[1]) : 10000;
+    bench.concurrency = (argc > 2) ? atoi(argv[2]) : bench.requests;
+    if (bench.requests <= 0 || bench.concurrency <= 0) {
+        fprintf(stderr, "Usage: benchBatch [requests [concurrency]]\n");
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    /* The MPR services events on its own thread. The benchmark client runs on the main thread */
+    mprCreate(argc, argv, 0);
+    mprStart();
+    http = httpCreate(HTTP_SERVER_SIDE | HTTP_CLIENT_SIDE);
+
+    limits = http->serverLimits;
+    limits->connectionsMax = limits->requestMax = limits->clientMax = MAXINT;
+    limits->requestsPerClientMax = MAXINT;
+    limits->keepAliveMax = MAXINT;
+    http->clientLimits->keepAliveMax = MAXINT;
+
+    if ((endpoint = httpCreateConfiguredEndpoint(".", ".", "127.0.0.1", BENCH_PORT)) == 0) {
+        fprintf(stderr, "Cannot create endpoint\n");
+        return 1;
+    }
+    route = httpGetHostDefaultRoute(mprGetFirstItem(endpoint->hosts));
+    httpSetRouteHandler(route, "actionHandler");
+    httpDefineAction("/hello", hello);
+    if (httpStartEndpoint(endpoint) < 0) {
+        fprintf(stderr, "Cannot start endpoint\n");
+        return 1;
+    }
+    runBench(&bench);
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
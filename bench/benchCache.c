@@ -0,0 +1,279 @@
+/**
+    benchCache.c - Measure MprCache throughput and latency with concurrent readers and writers
+
+    Worker threads read and write a shared cache while the cache pruning timer runs. Throughput
+    and the worst case latency of a single operation are reported. The pruner runs frequently and a tenth of the
+    items have a short lifespan so expired items are continually pruned. Before timing, eviction, expiry and numeric
+    items are checked.
+
+        read        90% reads and 10% writes
+        evict       50% reads and 50% writes with the key limit set to half the keys in use
+        inc         Increment a set of counters with mprIncCache
+
+    Build from the repository top directory after building the libraries:
+
+        gcc -O2 -o benchCache bench/benchCache.c -Ilinux-x64-default/inc -Llinux-x64-default/bin -lmpr \
+            -lpthread -lm -ldl -Wl,-rpath,linux-x64-default/bin
+
+    Usage: benchCache [keys [seconds]]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "mpr.h"
+
+/*********************************** Locals ***********************************/
+
+#define COUNTERS        64
+#define LIFESPAN        (60 * 1000)
+#define SHORT_LIFESPAN  50
+#define RESOLUTION      100
+
+typedef struct Worker {
+    MprCache    *cache;
+    cchar       *test;
+    int         seed;
+    int64       ops;
+    double      maxLatency;
+} Worker;
+
+static char         **keys;
+static int          numKeys;
+static char         *value;
+static volatile int stopping;
+static volatile int running;
+
+/************************************* Code ***********************************/
+
+static double now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static int verify()
+{
+    MprCache    *cache;
+    MprTime     modified;
+    char        key[32];
+    int64       version;
+    int         i, count, errors;
+
+    cache = mprCreateCache(0);
+    mprAddRoot(cache);
+    errors = 0;
+
+    /* Numeric items */
+    if (mprIncCache(cache, "n", 5) != 5 || mprIncCache(cache, "n", -2) != 3 || !smatch(mprReadCache(cache, "n", 0, 0), "3")) {
+        errors++;
+    }
+    mprWriteCache(cache, "s", "10", 0, LIFESPAN, 0, 0);
+    if (mprIncCache(cache, "s", 1) != 11 || mprIncCache(cache, "s", 0) != 11) {
+        errors++;
+    }
+    mprWriteCache(cache, "n", "text", 0, LIFESPAN, 0, 0);
+    if (!smatch(mprReadCache(cache, "n", 0, 0), "text")) {
+        errors++;
+    }
+    mprWriteCache(cache, "s", "x", 0, LIFESPAN, 0, MPR_CACHE_APPEND);
+    if (!smatch(mprReadCache(cache, "s", 0, 0), "11x")) {
+        errors++;
+    }
+    /* Versions */
+    mprReadCache(cache, "s", &modified, &version);
+    if (mprWriteCache(cache, "s", "y", 0, LIFESPAN, version + 1, 0) != MPR_ERR_BAD_STATE ||
+            mprWriteCache(cache, "s", "y", 0, LIFESPAN, version, 0) <= 0 || mprWriteCache(cache, "s", "z", 0, LIFESPAN, 0, MPR_CACHE_ADD) != 0) {
+        errors++;
+    }
+    /* Expiry */
+    mprWriteCache(cache, "short", "value", 0, 1, 0, 0);
+    mprSleep(5);
+    if (mprReadCache(cache, "short", 0, 0) != 0) {
+        errors++;
+    }
+    /* Removal */
+    if (!mprRemoveCache(cache, "s") || mprRemoveCache(cache, "s") || mprReadCache(cache, "s", 0, 0) != 0) {
+        errors++;
+    }
+    mprRemoveCache(cache, NULL);
+    mprGetCacheStats(cache, &count, NULL);
+    if (count != 0) {
+        errors++;
+    }
+    /* Least recently used items are evicted first */
+    mprSetCacheLimits(cache, 1000, 0, 0, 0);
+    mprWriteCache(cache, "first", "value", 0, LIFESPAN, 0, 0);
+    for (i = 0; i < 5000; i++) {
+        fmt(key, sizeof(key), "key-%d", i);
+        mprWriteCache(cache, key, "value", 0, LIFESPAN, 0, 0);
+        mprReadCache(cache, "first", 0, 0);
+    }
+    mprGetCacheStats(cache, &count, NULL);
+    if (count > 1000 || mprReadCache(cache, "first", 0, 0) == 0 || mprReadCache(cache, "key-4999", 0, 0) == 0 ||
+            mprReadCache(cache, "key-0", 0, 0) != 0) {
+        errors++;
+    }
+    mprRemoveRoot(cache);
+    return errors;
+}
+
+
+static void workerMain(Worker *wp, MprThread *tp)
+{
+    MprCache    *cache;
+    double      start, elapsed;
+    uint        seed;
+    int         index;
+
+    cache = wp->cache;
+    seed = wp->seed;
+    while (!stopping) {
+        seed = seed * 1103515245 + 12345;
+        index = (seed >> 8) % numKeys;
+        start = now();
+        if (smatch(wp->test, "inc")) {
+            mprIncCache(cache, keys[index % COUNTERS], 1);
+        } else if ((seed >> 4) % 100 < (smatch(wp->test, "read") ? 90 : 50)) {
+            mprReadCache(cache, keys[index], 0, 0);
+        } else {
+            mprWriteCache(cache, keys[index], value, 0, (index % 10) ? LIFESPAN : SHORT_LIFESPAN, 0, 0);
+        }
+        elapsed = now() - start;
+        if (elapsed > wp->maxLatency) {
+            wp->maxLatency = elapsed;
+        }
+        if ((++wp->ops % 256) == 0) {
+            mprYield(0);
+        }
+    }
+    mprAtomicAdd(&running, -1);
+}
+
+
+static void bench(cchar *test, int threads, int seconds)
+{
+    MprCache    *cache;
+    MprThread   *tp;
+    MprList     *workers;
+    Worker      *wp;
+    double      start, elapsed, maxLatency;
+    int64       ops;
+    int         i;
+
+    cache = mprCreateCache(0);
+    mprAddRoot(cache);
+    mprSetCacheLimits(cache, smatch(test, "evict") ? numKeys / 2 : 0, 0, 0, RESOLUTION);
+    for (i = 0; i < numKeys; i++) {
+        mprWriteCache(cache, keys[i], value, 0, (i % 10) ? LIFESPAN : SHORT_LIFESPAN, 0, 0);
+    }
+    workers = mprCreateList(threads, 0);
+    mprAddRoot(workers);
+    stopping = 0;
+    running = threads;
+    for (i = 0; i < threads; i++) {
+        wp = mprAllocZeroed(sizeof(Worker));
+        wp->cache = cache;
+        wp->test = test;
+        wp->seed = i + 1;
+        mprAddItem(workers, wp);
+        tp = mprCreateThread("worker", workerMain, wp, 0);
+        mprStartThread(tp);
+    }
+    start = now();
+    mprSleep(seconds * 1000);
+    stopping = 1;
+    while (running > 0) {
+        mprSleep(1);
+    }
+    elapsed = now() - start;
+    ops = 0;
+    maxLatency = 0;
+    for (ITERATE_ITEMS(workers, wp, i)) {
+        ops += wp->ops;
+        maxLatency = max(maxLatency, wp->maxLatency);
+    }
+    printf("%-8s %8d %14.0f %14.1f\n", test, threads, ops / elapsed, maxLatency * 1e6);
+    mprRemoveRoot(workers);
+    mprRemoveRoot(cache);
+    mprDestroyCache(cache);
+}
+
+
+int main(int argc, char **argv)
+{
+    int     seconds, errors, i;
+
+    numKeys = (argc > 1) ? atoi(argv[1]) : 100000;
+    seconds = (argc > 2) ? atoi(argv[2]) : 2;
+    if (numKeys <= COUNTERS) {
+        numKeys = 100000;
+    }
+    if (seconds <= 0) {
+        seconds = 2;
+    }
+    mprCreate(argc, argv, 0);
+    mprStart();
+    if ((errors = verify()) != 0) {
+        printf("Cache verification failed with %d errors\n", errors);
+        return 1;
+    }
+    keys = mprAlloc(numKeys * sizeof(char*));
+    mprAddRoot(keys);
+    for (i = 0; i < numKeys; i++) {
+        keys[i] = sfmt("/cache/key/%d", i);
+        mprHold(keys[i]);
+    }
+    value = mprAlloc(257);
+    memset(value, 'v', 256);
+    value[256] = '\0';
+    mprAddRoot(value);
+
+    printf("%-8s %8s %14s %14s\n", "Test", "Threads", "ops/sec", "max usec");
+    bench("read", 1, seconds);
+    bench("read", 4, seconds);
+    bench("evict", 1, seconds);
+    bench("evict", 4, seconds);
+    bench("inc", 4, seconds);
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
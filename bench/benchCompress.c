@@ -0,0 +1,184 @@
+/**
+    benchCompress.c - Measure bytes on the wire against CPU cost for dynamic response compression
+
+    Streams representative response bodies through zlib in pipeline packet sized pieces using the same stream
+    parameters as the compressFilter, and reports the compressed size, ratio and throughput for each level.
+
+        html        Generated HTML table markup
+        json        Generated JSON array of records
+        random      Incompressible data (as for images and archives which the filter skips)
+
+    Build from the repository top directory:
+
+        gcc -O2 -o benchCompress bench/benchCompress.c -lz
+
+    Usage: benchCompress [kilobytes [iterations]]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    <stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <sys/time.h>
+#include    <zlib.h>
+
+/*********************************** Locals ***********************************/
+
+#define PACKET_SIZE     (32 * 1024)         /* Pipeline packet size (BIT_MAX_QBUFFER) */
+
+typedef struct Sample {
+    char    *name;
+    char    *data;
+    size_t  len;
+} Sample;
+
+/************************************* Code ***********************************/
+
+static double now()
+{
+    struct timeval  tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+static char *fill(char *buf, size_t size, int kind)
+{
+    size_t      len;
+    unsigned    seed;
+    int         i;
+
+    len = 0;
+    seed = 1;
+    for (i = 0; len < size; i++) {
+        if (kind == 0) {
+            len += snprintf(&buf[len], size - len,
+                "<tr class=\"row\"><td>%d</td><td><a href=\"/item/%d\">Item %d</a></td><td>%u</td></tr>\n",
+                i, i, i, (seed = seed * 1103515245 + 12345) % 1000);
+        } else if (kind == 1) {
+            seed = seed * 1103515245 + 12345;
+            len += snprintf(&buf[len], size - len,
+                "{\"id\":%d,\"name\":\"item %d\",\"price\":%u.%02u,\"inStock\":%s},", i, i,
+                seed % 1000, (seed >> 10) % 100, (seed & 0x100) ? "true" : "false");
+        } else {
+            seed = seed * 1103515245 + 12345;
+            buf[len++] = (char) (seed >> 16);
+        }
+    }
+    return buf;
+}
+
+
+/*
+    Compress in packet sized pieces with Z_NO_FLUSH and finish the stream, as the filter does for a response
+ */
+static size_t compressSample(Sample *sp, int level, unsigned char *out, size_t outSize)
+{
+    z_stream    zs;
+    size_t      pos, total, len;
+    int         flush;
+
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, level, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return 0;
+    }
+    total = 0;
+    for (pos = 0, flush = Z_NO_FLUSH; flush != Z_FINISH; pos += len) {
+        len = (sp->len - pos < PACKET_SIZE) ? sp->len - pos : PACKET_SIZE;
+        flush = (pos + len >= sp->len) ? Z_FINISH : Z_NO_FLUSH;
+        zs.next_in = (Bytef*) &sp->data[pos];
+        zs.avail_in = (uInt) len;
+        do {
+            zs.next_out = out;
+            zs.avail_out = (uInt) outSize;
+            deflate(&zs, flush);
+            total += outSize - zs.avail_out;
+        } while (zs.avail_out == 0);
+    }
+    deflateEnd(&zs);
+    return total;
+}
+
+
+int main(int argc, char **argv)
+{
+    Sample      samples[3];
+    unsigned char *out;
+    double      start, elapsed;
+    size_t      size, wire;
+    int         kilobytes, iterations, i, level, iter;
+
+    kilobytes = (argc > 1) ? atoi(argv[1]) : 64;
+    iterations = (argc > 2) ? atoi(argv[2]) : 200;
+    if (kilobytes <= 0) {
+        kilobytes = 64;
+    }
+    if (iterations <= 0) {
+        iterations = 200;
+    }
+    size = (size_t) kilobytes * 1024;
+    samples[0].name = "html";
+    samples[1].name = "json";
+    samples[2].name = "random";
+    for (i = 0; i < 3; i++) {
+        samples[i].data = fill(malloc(size + 256), size, i);
+        samples[i].len = size;
+    }
+    out = malloc(PACKET_SIZE);
+
+    printf("%-8s %6s %10s %10s %8s %12s %12s\n", "Content", "Level", "Bytes", "Wire", "Ratio", "MB/s", "usec/resp");
+    for (i = 0; i < 3; i++) {
+        printf("%-8s %6s %10d %10d %8.2f %12s %12s\n", samples[i].name, "none", (int) size, (int) size, 1.0, "-", "-");
+        for (level = 1; level <= 9; level += (level == 1) ? 2 : 3) {
+            start = now();
+            for (iter = 0, wire = 0; iter < iterations; iter++) {
+                wire = compressSample(&samples[i], level, out, PACKET_SIZE);
+            }
+            elapsed = now() - start;
+            printf("%-8s %6d %10d %10d %8.2f %12.1f %12.1f\n", samples[i].name, level, (int) size, (int) wire,
+                (double) size / wire, (double) size * iterations / elapsed / (1024 * 1024),
+                elapsed * 1e6 / iterations);
+        }
+    }
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -0,0 +1,261 @@
+/**
+    benchCrypto.c - Benchmark bulk AES-CBC and AES-GCM throughput
+
+    Measures encrypt and decrypt throughput of the EST AES-CBC and AES-GCM implementations using the portable
+    table code and, where the CPU supports it, AES-NI and PCLMULQDQ. Known answer tests are run first so a
+    broken implementation is not benchmarked.
+
+    Build from the repository top directory after building the libraries:
+
+        gcc -O2 -o benchCrypto bench/benchCrypto.c -Ilinux-x64-default/inc -Llinux-x64-default/bin -lest \
+            -Wl,-rpath,linux-x64-default/bin
+
+    Usage: benchCrypto [megabytes]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "est.h"
+
+/*********************************** Locals ***********************************/
+
+#define BUF_SIZE    (16 * 1024)         /* Size of a TLS record */
+
+/*
+    GCM test case 4 from the GCM specification
+ */
+static char *gcmKey = "feffe9928665731c6d6a8f9467308308";
+static char *gcmIv = "cafebabefacedbaddecaf888";
+static char *gcmAdd = "feedfacedeadbeeffeedfacedeadbeefabaddad2";
+static char *gcmPlain = 
+    "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+    "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39";
+static char *gcmCipher = 
+    "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+    "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091";
+static char *gcmTag = "5bc94fbc3221a5db94fae95ae7121a47";
+
+/*
+    FIPS-197 appendix C.1 and C.3
+ */
+static char *aesPlain = "00112233445566778899aabbccddeeff";
+static char *aes128Cipher = "69c4e0d86a7b0430d8cdb78070b4c55a";
+static char *aes256Cipher = "8ea2b7ca516745bfeafc49904b496089";
+
+/***************************** Forward Declarations ***************************/
+
+static double elapsed(struct timeval *start);
+static int fromHex(char *hex, uchar *buf);
+
+/************************************* Code ***********************************/
+
+static int fromHex(char *hex, uchar *buf)
+{
+    uint    c;
+    int     len;
+
+    for (len = 0; hex[0] && hex[1]; hex += 2, len++) {
+        sscanf(hex, "%2x", &c);
+        buf[len] = (uchar) c;
+    }
+    return len;
+}
+
+
+static int selfTest(void)
+{
+    aes_context     aes;
+    gcm_context     gcm;
+    uchar           key[32], iv[16], add[32], plain[64], cipher[64], expect[64], tag[16], out[64];
+    int             i, len, addLen, ivLen;
+
+    for (i = 0; i < 32; i++) {
+        key[i] = (uchar) i;
+    }
+    fromHex(aesPlain, plain);
+    aes_setkey_enc(&aes, key, 128);
+    aes_crypt_ecb(&aes, AES_ENCRYPT, plain, out);
+    fromHex(aes128Cipher, expect);
+    if (memcmp(out, expect, 16) != 0) {
+        return -1;
+    }
+    aes_setkey_dec(&aes, key, 128);
+    aes_crypt_ecb(&aes, AES_DECRYPT, expect, out);
+    if (memcmp(out, plain, 16) != 0) {
+        return -1;
+    }
+    aes_setkey_enc(&aes, key, 256);
+    aes_crypt_ecb(&aes, AES_ENCRYPT, plain, out);
+    fromHex(aes256Cipher, expect);
+    if (memcmp(out, expect, 16) != 0) {
+        return -1;
+    }
+    aes_setkey_dec(&aes, key, 256);
+    aes_crypt_ecb(&aes, AES_DECRYPT, expect, out);
+    if (memcmp(out, plain, 16) != 0) {
+        return -1;
+    }
+
+    fromHex(gcmKey, key);
+    ivLen = fromHex(gcmIv, iv);
+    addLen = fromHex(gcmAdd, add);
+    len = fromHex(gcmPlain, plain);
+    fromHex(gcmCipher, expect);
+    gcm_setkey(&gcm, key, 128);
+    gcm_crypt_and_tag(&gcm, GCM_ENCRYPT, len, iv, ivLen, add, addLen, plain, cipher, 16, tag);
+    if (memcmp(cipher, expect, len) != 0) {
+        return -1;
+    }
+    fromHex(gcmTag, expect);
+    if (memcmp(tag, expect, 16) != 0) {
+        return -1;
+    }
+    if (gcm_auth_decrypt(&gcm, len, iv, ivLen, add, addLen, tag, 16, cipher, out) != 0 || 
+            memcmp(out, plain, len) != 0) {
+        return -1;
+    }
+    tag[0] ^= 1;
+    if (gcm_auth_decrypt(&gcm, len, iv, ivLen, add, addLen, tag, 16, cipher, out) != EST_ERR_GCM_AUTH_FAILED) {
+        return -1;
+    }
+    gcm_free(&gcm);
+    return 0;
+}
+
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval  now;
+
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - start->tv_sec) + (now.tv_usec - start->tv_usec) / 1e6;
+}
+
+
+static void report(char *impl, char *name, int keysize, int megabytes, struct timeval *start)
+{
+    double  secs;
+
+    secs = elapsed(start);
+    printf("%-8s %-12s %4d %10.1f MB/s\n", impl, name, keysize, megabytes / secs);
+}
+
+
+static void bench(char *impl, int megabytes)
+{
+    aes_context     aes;
+    gcm_context     gcm;
+    struct timeval  start;
+    uchar           key[32], iv[16], add[13], tag[16], *buf;
+    int             i, count, keysize;
+
+    buf = malloc(BUF_SIZE);
+    memset(buf, 0x61, BUF_SIZE);
+    memset(key, 0x42, sizeof(key));
+    memset(iv, 0x24, sizeof(iv));
+    memset(add, 0x17, sizeof(add));
+    count = megabytes * (1024 * 1024 / BUF_SIZE);
+
+    for (keysize = 128; keysize <= 256; keysize += 128) {
+        aes_setkey_enc(&aes, key, keysize);
+        gettimeofday(&start, NULL);
+        for (i = 0; i < count; i++) {
+            aes_crypt_cbc(&aes, AES_ENCRYPT, BUF_SIZE, iv, buf, buf);
+        }
+        report(impl, "cbc-encrypt", keysize, megabytes, &start);
+
+        aes_setkey_dec(&aes, key, keysize);
+        gettimeofday(&start, NULL);
+        for (i = 0; i < count; i++) {
+            aes_crypt_cbc(&aes, AES_DECRYPT, BUF_SIZE, iv, buf, buf);
+        }
+        report(impl, "cbc-decrypt", keysize, megabytes, &start);
+
+        gcm_setkey(&gcm, key, keysize);
+        gettimeofday(&start, NULL);
+        for (i = 0; i < count; i++) {
+            gcm_crypt_and_tag(&gcm, GCM_ENCRYPT, BUF_SIZE, iv, 12, add, sizeof(add), buf, buf, 16, tag);
+        }
+        report(impl, "gcm-encrypt", keysize, megabytes, &start);
+
+        gettimeofday(&start, NULL);
+        for (i = 0; i < count; i++) {
+            gcm_crypt_and_tag(&gcm, GCM_DECRYPT, BUF_SIZE, iv, 12, add, sizeof(add), buf, buf, 16, tag);
+        }
+        report(impl, "gcm-decrypt", keysize, megabytes, &start);
+        gcm_free(&gcm);
+    }
+    free(buf);
+}
+
+
+int main(int argc, char **argv)
+{
+    int     megabytes;
+
+    megabytes = (argc > 1) ? atoi(argv[1]) : 64;
+    if (megabytes <= 0) {
+        megabytes = 64;
+    }
+#if defined(EST_HAVE_AESNI)
+    aesni_enable(0);
+#endif
+    if (selfTest() < 0) {
+        fprintf(stderr, "Self test failed for the table implementation\n");
+        return 1;
+    }
+    printf("%-8s %-12s %4s %15s\n", "Impl", "Cipher", "Bits", "Throughput");
+    bench("table", megabytes);
+
+#if defined(EST_HAVE_AESNI)
+    aesni_enable(1);
+    if (aesni_supports(AESNI_AES)) {
+        if (selfTest() < 0) {
+            fprintf(stderr, "Self test failed for the AES-NI implementation\n");
+            return 1;
+        }
+        bench(aesni_supports(AESNI_CLMUL) ? "aesni" : "aes-only", megabytes);
+    } else {
+        printf("AES-NI is not supported by this CPU\n");
+    }
+#endif
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
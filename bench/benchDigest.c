@@ -0,0 +1,423 @@
+/**
+    benchDigest.c - Measure server digest authentication verification
+
+    Each verification parses a client Authorization header, checks the nonce and computes the expected response as a
+    server does for each request using digest authentication. The legacy variant is the previous implementation which
+    clones each header field and builds the nonce and digests from formatted heap strings. Before timing, replayed and
+    out of order nonce counts, forged nonces, wrong passwords and stale nonces are checked.
+
+        legacy      Previous parser, base64 nonce and formatted MD5 digests
+        digest      In-place parser, signed nonce with replay protection and stack MD5 digests
+
+    Build from the repository top directory after building the libraries:
+
+        gcc -O2 -o benchDigest bench/benchDigest.c -Ilinux-x64-default/inc -Llinux-x64-default/bin -lhttp -lmpr \
+            -lpcre -lpthread -lm -ldl -Wl,-rpath,linux-x64-default/bin
+
+    Usage: benchDigest [iterations]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "http.h"
+
+/*********************************** Locals ***********************************/
+
+#define REALM       "example.com"
+#define USER        "joshua"
+#define PASSWORD    "pass1"
+#define URI         "/protected/index.html"
+#define CNONCE      "0a4f113b"
+#define NONCES      4096                    /* Size of the server nonce table */
+
+typedef struct LegacyData {
+    char    *algorithm;
+    char    *cnonce;
+    char    *domain;
+    char    *nc;
+    char    *nonce;
+    char    *opaque;
+    char    *qop;
+    char    *realm;
+    char    *stale;
+    char    *uri;
+} LegacyData;
+
+static HttpConn     *conn;
+static HttpRoute    *route;
+static char         *ha1;
+static char         *method;
+
+/************************************* Code ***********************************/
+
+static double now()
+{
+    struct timeval  tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+/*
+    Start a new request on the connection
+ */
+static void prepRequest(cchar *details)
+{
+    if (conn->rx) {
+        httpDestroyRx(conn->rx);
+        httpDestroyTx(conn->tx);
+    }
+    conn->rx = httpCreateRx(conn);
+    conn->tx = httpCreateTx(conn, NULL);
+    conn->rx->route = route;
+    conn->rx->method = method;
+    conn->rx->authDetails = (char*) details;
+    conn->user = 0;
+    conn->encoded = 0;
+    conn->authData = 0;
+}
+
+
+/*
+    Get a nonce from a login challenge
+ */
+static char *getNonce()
+{
+    cchar   *header, *start;
+
+    prepRequest(NULL);
+    httpDigestLogin(conn);
+    if ((header = mprLookupKey(conn->tx->headers, "WWW-Authenticate")) == 0 ||
+            (start = scontains(header, "nonce=\"")) == 0) {
+        return 0;
+    }
+    start += 7;
+    return snclone(start, schr(start, '"') - start);
+}
+
+
+static char *createHeader(cchar *nonce, int nc, cchar *password)
+{
+    char    *response, *ha2, *pha1;
+
+    pha1 = password ? mprGetMD5(sfmt("%s:%s:%s", USER, REALM, password)) : ha1;
+    ha2 = mprGetMD5(sfmt("GET:%s", URI));
+    response = mprGetMD5(sfmt("%s:%s:%08x:%s:auth:%s", pha1, nonce, nc, CNONCE, ha2));
+    return sfmt("username=\"%s\", realm=\"%s\", nonce=\"%s\", uri=\"%s\", algorithm=MD5, response=\"%s\", "
+        "opaque=\"799d5\", qop=auth, nc=%08x, cnonce=\"%s\"", USER, REALM, nonce, URI, response, nc, CNONCE);
+}
+
+
+/*
+    Verify as the internal auth store does. Returns 1 if verified, 0 if the response is wrong, -1 if rejected and
+    -2 if the nonce is stale.
+ */
+static int verifyHeader(cchar *details)
+{
+    cchar   *username, *password;
+    int     rc;
+
+    prepRequest(details);
+    if ((rc = httpDigestParse(conn, &username, &password)) < 0) {
+        return -1;
+    }
+    if (!username) {
+        return -2;
+    }
+    return smatch(password, conn->rx->passwordDigest);
+}
+
+
+/*
+    Get the sequence number from a nonce. This is the hex issue time followed by the hex sequence number.
+ */
+static uint getSeq(cchar *nonce)
+{
+    return (uint) stoiradix(snclone(&nonce[8], 8), 16, NULL);
+}
+
+
+static int verify()
+{
+    char    *nonce, *first, *forged;
+    uint    seq;
+    int     errors, i;
+
+    errors = 0;
+    if ((nonce = getNonce()) == 0) {
+        printf("Cannot get a nonce\n");
+        return 1;
+    }
+    /* Each nonce count is accepted once */
+    if (verifyHeader(createHeader(nonce, 1, 0)) != 1 || verifyHeader(createHeader(nonce, 1, 0)) != -1) {
+        errors++;
+    }
+    /* Counts may arrive out of order within the window */
+    if (verifyHeader(createHeader(nonce, 5, 0)) != 1 || verifyHeader(createHeader(nonce, 3, 0)) != 1 ||
+            verifyHeader(createHeader(nonce, 3, 0)) != -1 || verifyHeader(createHeader(nonce, 2, 0)) != 1) {
+        errors++;
+    }
+    if (verifyHeader(createHeader(nonce, 100, 0)) != 1 || verifyHeader(createHeader(nonce, 50, 0)) != -1) {
+        errors++;
+    }
+    /* A wrong password does not consume the count */
+    if (verifyHeader(createHeader(nonce, 101, "wrong")) != 0 || verifyHeader(createHeader(nonce, 101, 0)) != 1) {
+        errors++;
+    }
+    /* Forged nonces are rejected */
+    forged = sclone(nonce);
+    forged[20] = (forged[20] == '0') ? '1' : '0';
+    if (verifyHeader(createHeader(forged, 1, 0)) != -1) {
+        errors++;
+    }
+    forged = sclone(nonce);
+    forged[15] = (forged[15] == '0') ? '1' : '0';
+    if (verifyHeader(createHeader(forged, 1, 0)) != -1) {
+        errors++;
+    }
+    /* Back-quoted values are parsed */
+    if (verifyHeader(sreplace(createHeader(nonce, 102, 0), "username=\"" USER, "username=\"jo\\shua")) != 1) {
+        errors++;
+    }
+    /* Anonymous challenges do not displace the nonce. A later nonce that authenticates in its slot makes it stale. */
+    first = nonce;
+    seq = getSeq(first);
+    for (i = 0; i < NONCES * 2; i++) {
+        if ((nonce = getNonce()) == 0 || getSeq(nonce) == seq + NONCES) {
+            break;
+        }
+    }
+    if (!nonce || verifyHeader(createHeader(first, 200, 0)) != 1 || verifyHeader(createHeader(nonce, 1, 0)) != 1 ||
+            verifyHeader(createHeader(first, 201, 0)) != -2) {
+        errors++;
+    }
+    return errors;
+}
+
+
+/*
+    Previous implementation
+ */
+static int legacyParse(HttpConn *conn, cchar **username, cchar **password)
+{
+    HttpRx      *rx;
+    LegacyData  *dp;
+    MprTime     when;
+    char        *value, *tok, *key, *cp, *sp, *decoded, *whenStr;
+    cchar       *secret, *realm;
+    int         seenComma;
+
+    rx = conn->rx;
+    *password = *username = NULL;
+    dp = mprAllocStruct(LegacyData);
+    key = sclone(rx->authDetails);
+    while (*key) {
+        while (*key && isspace((uchar) *key)) {
+            key++;
+        }
+        tok = key;
+        while (*tok && !isspace((uchar) *tok) && *tok != ',' && *tok != '=') {
+            tok++;
+        }
+        *tok++ = '\0';
+        while (isspace((uchar) *tok)) {
+            tok++;
+        }
+        seenComma = 0;
+        if (*tok == '\"') {
+            value = ++tok;
+            while (*tok != '\"' && *tok != '\0') {
+                tok++;
+            }
+        } else {
+            value = tok;
+            while (*tok != ',' && *tok != '\0') {
+                tok++;
+            }
+            seenComma++;
+        }
+        *tok++ = '\0';
+        if (strchr(value, '\\')) {
+            for (cp = sp = value; *sp; sp++) {
+                if (*sp == '\\') {
+                    sp++;
+                }
+                *cp++ = *sp++;
+            }
+            *cp = '\0';
+        }
+        if (scaselesscmp(key, "algorithm") == 0) {
+            dp->algorithm = sclone(value);
+        } else if (scaselesscmp(key, "cnonce") == 0) {
+            dp->cnonce = sclone(value);
+        } else if (scaselesscmp(key, "nc") == 0) {
+            dp->nc = sclone(value);
+        } else if (scaselesscmp(key, "nonce") == 0) {
+            dp->nonce = sclone(value);
+        } else if (scaselesscmp(key, "opaque") == 0) {
+            dp->opaque = sclone(value);
+        } else if (scaselesscmp(key, "qop") == 0) {
+            dp->qop = sclone(value);
+        } else if (scaselesscmp(key, "realm") == 0) {
+            dp->realm = sclone(value);
+        } else if (scaselesscmp(key, "response") == 0) {
+            *password = sclone(value);
+        } else if (scaselesscmp(key, "uri") == 0) {
+            dp->uri = sclone(value);
+        } else if (scaselesscmp(key, "username") == 0) {
+            *username = sclone(value);
+        }
+        key = tok;
+        if (!seenComma) {
+            while (*key && *key != ',') {
+                key++;
+            }
+            if (*key) {
+                key++;
+            }
+        }
+    }
+    if ((decoded = mprDecode64(dp->nonce)) == 0) {
+        return MPR_ERR_BAD_STATE;
+    }
+    secret = stok(decoded, ":", &tok);
+    realm = stok(NULL, ":", &tok);
+    whenStr = stok(NULL, ":", &tok);
+    when = (MprTime) stoiradix(whenStr, 16, NULL);
+    if (!smatch(secret, conn->http->secret) || !smatch(realm, route->auth->realm) || !smatch(dp->qop, "auth") ||
+            (when + (5 * 60 * 1000)) < mprGetTime()) {
+        return MPR_ERR_BAD_STATE;
+    }
+    conn->user = mprLookupKey(route->auth->userCache, *username);
+    rx->passwordDigest = mprGetMD5(sfmt("%s:%s:%s:%s:%s:%s", sclone(conn->user->password), dp->nonce, dp->nc,
+        dp->cnonce, dp->qop, mprGetMD5(sfmt("%s:%s", rx->method, dp->uri))));
+    return 0;
+}
+
+
+static void bench(cchar *name, int iterations)
+{
+    MprList     *headers;
+    cchar       *username, *password, *nonce;
+    double      start, elapsed;
+    int         i, found, legacy;
+
+    legacy = smatch(name, "legacy");
+    headers = mprCreateList(iterations, 0);
+    mprAddRoot(headers);
+    if (legacy) {
+        nonce = mprEncode64(sfmt("%s:%s:%Lx:%Lx", conn->http->secret, REALM, mprGetTime(), (int64) 1));
+    } else {
+        nonce = getNonce();
+    }
+    for (i = 0; i < iterations; i++) {
+        mprAddItem(headers, createHeader(nonce, i + 1, 0));
+    }
+    found = 0;
+    prepRequest(NULL);
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        /* Only reset the request authentication state so the timing excludes creating the request */
+        conn->rx->authDetails = mprGetItem(headers, i);
+        conn->rx->passwordDigest = 0;
+        conn->user = 0;
+        conn->encoded = 0;
+        if (legacy) {
+            if (legacyParse(conn, &username, &password) == 0) {
+                found += smatch(password, conn->rx->passwordDigest);
+            }
+        } else if (httpDigestParse(conn, &username, &password) == 0) {
+            found += smatch(password, conn->rx->passwordDigest);
+        }
+        if ((i % 1000) == 0) {
+            mprYield(0);
+        }
+    }
+    elapsed = now() - start;
+    printf("%-8s %12.2f %14.0f\n", name, elapsed * 1e6 / iterations, iterations / elapsed);
+    if (found != iterations) {
+        printf("Unexpected verification count %d\n", found);
+    }
+    mprRemoveRoot(headers);
+}
+
+
+int main(int argc, char **argv)
+{
+    Http        *http;
+    HttpHost    *host;
+    int         iterations, errors;
+
+    iterations = (argc > 1) ? atoi(argv[1]) : 200000;
+    if (iterations <= 0) {
+        iterations = 200000;
+    }
+    mprCreate(argc, argv, 0);
+    mprStart();
+    http = httpCreate(HTTP_SERVER_SIDE | HTTP_CLIENT_SIDE);
+    host = httpCreateHost();
+    httpSetHostName(host, "localhost");
+    route = httpCreateRoute(host);
+    mprAddRoot(route);
+    httpSetAuthRealm(route->auth, REALM);
+    httpSetAuthType(route->auth, "digest", 0);
+    ha1 = mprGetMD5(sfmt("%s:%s:%s", USER, REALM, PASSWORD));
+    mprAddRoot(ha1);
+    method = sclone("GET");
+    mprAddRoot(method);
+    httpAddUser(route->auth, USER, ha1, 0);
+
+    conn = httpCreateConn(http, NULL, NULL);
+    mprAddRoot(conn);
+    conn->host = host;
+    conn->ip = sclone("127.0.0.1");
+    conn->endpoint = httpCreateEndpoint("127.0.0.1", 0, NULL);
+
+    if ((errors = verify()) != 0) {
+        printf("Digest verification failed with %d errors\n", errors);
+        return 1;
+    }
+    printf("%-8s %12s %14s\n", "Test", "usec/verify", "verify/sec");
+    bench("legacy", iterations);
+    bench("digest", iterations);
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -0,0 +1,273 @@
+/**
+    benchHash.c - Measure the chained MprHash against the open addressing MPR_HASH_OPEN variant
+
+    Models the request-local tables: each iteration creates a caseless table, adds a typical set of request headers,
+    looks up present and absent headers and walks the table as httpGetHeaders does. A second test measures a large
+    table with inserts, lookups and removals. Before timing, the open table is checked against the chained table
+    with a random sequence of adds, duplicates, removals and lookups.
+
+        chained     Default table with a mutex (mprCreateHash flags 0)
+        own         Chained table without a mutex (MPR_HASH_OWN)
+        open        Open addressing table with inline entries (MPR_HASH_OPEN)
+
+    Build from the repository top directory after building the libraries:
+
+        gcc -O2 -o benchHash bench/benchHash.c -Ilinux-x64-default/inc -Llinux-x64-default/bin -lhttp -lmpr \
+            -lpcre -lpthread -lm -ldl -Wl,-rpath,linux-x64-default/bin
+
+    Usage: benchHash [iterations]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "http.h"
+
+/*********************************** Locals ***********************************/
+
+#define LARGE_KEYS  4096
+
+static cchar *headers[] = {
+    "Host", "User-Agent", "Accept", "Accept-Language", "Accept-Encoding", "Connection", "Cookie", "Referer",
+    "Cache-Control", "If-None-Match", "If-Modified-Since", "Upgrade-Insecure-Requests", "Sec-Fetch-Dest",
+    "Sec-Fetch-Mode", "Sec-Fetch-Site", "DNT", 0
+};
+
+static cchar *lookups[] = {
+    "host", "accept-encoding", "connection", "cookie", "if-none-match", "if-modified-since", "content-length",
+    "content-type", "authorization", "range", "user-agent", "referer", 0
+};
+
+typedef struct Variant {
+    cchar   *name;
+    int     flags;
+} Variant;
+
+static Variant variants[] = {
+    { "chained", 0 },
+    { "own", MPR_HASH_OWN },
+    { "open", MPR_HASH_OPEN },
+    { 0, 0 }
+};
+
+static char *largeKeys[LARGE_KEYS];
+
+/************************************* Code ***********************************/
+
+static double now()
+{
+    struct timeval  tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+/*
+    Apply the same random operations to a chained and an open table and compare the results
+ */
+static int verify()
+{
+    MprHash     *chained, *open;
+    MprKey      *kp;
+    char        key[32];
+    uint        seed;
+    int         i, op, count, errors;
+
+    chained = mprCreateHash(0, MPR_HASH_CASELESS | MPR_HASH_STATIC_VALUES);
+    open = mprCreateHash(0, MPR_HASH_CASELESS | MPR_HASH_STATIC_VALUES | MPR_HASH_OPEN);
+    mprAddRoot(chained);
+    mprAddRoot(open);
+    errors = 0;
+    seed = 1;
+    for (i = 0; i < 200000; i++) {
+        seed = seed * 1103515245 + 12345;
+        op = (seed >> 16) % 10;
+        fmt(key, sizeof(key), (seed & 0x100) ? "Key-%d" : "key-%d", (seed >> 20) % 600);
+        if (op < 5) {
+            mprAddKey(chained, key, (void*) (ssize) (i + 1));
+            mprAddKey(open, key, (void*) (ssize) (i + 1));
+        } else if (op < 8) {
+            if ((mprRemoveKey(chained, key) == 0) != (mprRemoveKey(open, key) == 0)) {
+                errors++;
+            }
+        } else if (mprLookupKey(chained, key) != mprLookupKey(open, key)) {
+            errors++;
+        }
+        if (mprGetHashLength(chained) != mprGetHashLength(open)) {
+            errors++;
+        }
+        if ((i % 1000) == 0) {
+            mprYield(0);
+        }
+    }
+    /* Iteration must visit each entry once, including when removing entries during the walk */
+    for (count = 0, kp = 0; (kp = mprGetNextKey(open, kp)) != 0; count++) {
+        if (mprLookupKey(chained, kp->key) != kp->data) {
+            errors++;
+        }
+        if (count & 1) {
+            mprRemoveKey(open, kp->key);
+        }
+    }
+    if (count != mprGetHashLength(chained) || mprGetHashLength(open) != count - count / 2) {
+        errors++;
+    }
+    /* Duplicates are all visible to iteration */
+    mprAddDuplicateKey(open, "Set-Cookie", "a=1");
+    mprAddDuplicateKey(open, "Set-Cookie", "b=2");
+    for (count = 0, kp = 0; (kp = mprGetNextKey(open, kp)) != 0; ) {
+        if (smatch(kp->key, "Set-Cookie")) {
+            count++;
+        }
+    }
+    if (count != 2 || mprLookupKey(open, "set-cookie") == 0) {
+        errors++;
+    }
+    mprRemoveRoot(chained);
+    mprRemoveRoot(open);
+    return errors;
+}
+
+
+static void benchRequest(Variant *vp, int iterations)
+{
+    MprHash     *hash;
+    MprKey      *kp;
+    double      start, elapsed;
+    ssize       len;
+    int         i, j, found;
+
+    found = 0;
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        hash = mprCreateHash(HTTP_SMALL_HASH_SIZE, MPR_HASH_CASELESS | vp->flags);
+        for (j = 0; headers[j]; j++) {
+            mprAddKey(hash, headers[j], "value");
+        }
+        for (j = 0; lookups[j]; j++) {
+            if (mprLookupKey(hash, lookups[j])) {
+                found++;
+            }
+        }
+        for (len = 0, kp = 0; (kp = mprGetNextKey(hash, kp)) != 0; ) {
+            len += slen(kp->key) + slen(kp->data) + 4;
+        }
+        if ((i % 1000) == 0) {
+            mprYield(0);
+        }
+    }
+    elapsed = now() - start;
+    printf("%-8s %-8s %12.1f %14.0f\n", "request", vp->name, elapsed * 1e9 / iterations,
+        iterations / elapsed);
+    if (found != iterations * 8) {
+        printf("Unexpected lookup count %d\n", found);
+    }
+}
+
+
+static void benchLarge(Variant *vp, int rounds)
+{
+    MprHash     *hash;
+    double      start, elapsed;
+    int         i, r, found;
+
+    found = 0;
+    start = now();
+    for (r = 0; r < rounds; r++) {
+        hash = mprCreateHash(0, vp->flags);
+        mprAddRoot(hash);
+        for (i = 0; i < LARGE_KEYS; i++) {
+            mprAddKey(hash, largeKeys[i], largeKeys[i]);
+        }
+        for (i = 0; i < LARGE_KEYS; i++) {
+            if (mprLookupKey(hash, largeKeys[(i * 7) % LARGE_KEYS])) {
+                found++;
+            }
+        }
+        for (i = 0; i < LARGE_KEYS; i += 2) {
+            mprRemoveKey(hash, largeKeys[i]);
+        }
+        for (i = 0; i < LARGE_KEYS; i++) {
+            if (mprLookupKey(hash, largeKeys[i])) {
+                found++;
+            }
+        }
+        mprRemoveRoot(hash);
+        mprYield(0);
+    }
+    elapsed = now() - start;
+    printf("%-8s %-8s %12.1f %14.0f\n", "large", vp->name, elapsed * 1e9 / (rounds * LARGE_KEYS * 3.5),
+        rounds * LARGE_KEYS * 3.5 / elapsed);
+    if (found != rounds * (LARGE_KEYS + LARGE_KEYS / 2)) {
+        printf("Unexpected lookup count %d\n", found);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    Variant     *vp;
+    int         iterations, i, errors;
+
+    iterations = (argc > 1) ? atoi(argv[1]) : 1000000;
+    if (iterations <= 0) {
+        iterations = 1000000;
+    }
+    mprCreate(argc, argv, 0);
+    mprStart();
+    httpCreate(HTTP_SERVER_SIDE);
+    for (i = 0; i < LARGE_KEYS; i++) {
+        largeKeys[i] = sfmt("/path/to/resource/%d", i);
+        mprAddRoot(largeKeys[i]);
+    }
+    if ((errors = verify()) != 0) {
+        printf("Open table verification failed with %d errors\n", errors);
+        return 1;
+    }
+    printf("%-8s %-8s %12s %14s\n", "Test", "Table", "nsec/op", "ops/sec");
+    for (vp = variants; vp->name; vp++) {
+        benchRequest(vp, iterations);
+    }
+    for (vp = variants; vp->name; vp++) {
+        benchLarge(vp, max(iterations / 5000, 10));
+    }
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -0,0 +1,383 @@
+/**
+    benchHttp2.c - Compare request rates of HTTP/1.1 keep-alive connections and multiplexed HTTP/2 streams
+
+    Starts an in-process HTTP server with a small action and drives it over loopback using:
+        http/1.1        One request at a time on each keep-alive connection
+        http/2          Many concurrent streams on each HTTP/2 connection (prior knowledge)
+
+    Build from the repository top directory after building the libraries:
+
+        gcc -O2 -o benchHttp2 bench/benchHttp2.c -Ilinux-x64-default/inc -Llinux-x64-default/bin -lhttp -lmpr \
+            -lpcre -lpthread -lm -ldl -Wl,-rpath,linux-x64-default/bin
+
+    Usage: benchHttp2 [requests [connections [streams]]]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "http.h"
+#include    <pthread.h>
+
+/*********************************** Locals ***********************************/
+
+#define BENCH_PORT      18280
+#define MODE_HTTP1      0
+#define MODE_HTTP2      1
+
+static char *modeNames[] = { "http/1.1", "http/2" };
+
+typedef struct Client {
+    int             mode;
+    int             requests;           /* Requests to issue on this connection */
+    int             streams;            /* Concurrent HTTP/2 streams */
+    int             completed;
+    double          latency;            /* Total seconds of request latency */
+    pthread_t       tid;
+} Client;
+
+typedef struct Bench {
+    int     requests;
+    int     connections;
+    int     streams;
+} Bench;
+
+static uchar    headerBlock[128];       /* HPACK encoded request headers */
+static int      headerLen;
+
+/************************************* Code ***********************************/
+
+static void benchAction(HttpConn *conn)
+{
+    httpSetContentType(conn, "text/plain");
+    httpWrite(conn->writeq, "Hello World\n");
+    httpFinalize(conn);
+}
+
+
+static double now()
+{
+    struct timeval  tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+static int connectServer()
+{
+    struct sockaddr_in  addr;
+    int                 fd, one;
+
+    if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(BENCH_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+
+static int writeAll(int fd, cchar *buf, ssize len)
+{
+    ssize   rc;
+
+    while (len > 0) {
+        if ((rc = write(fd, buf, len)) <= 0) {
+            return -1;
+        }
+        buf += rc;
+        len -= rc;
+    }
+    return 0;
+}
+
+
+/*
+    Literal header field without indexing (RFC 7541 section 6.2.2)
+ */
+static void addHeader(cchar *name, cchar *value)
+{
+    headerBlock[headerLen++] = 0;
+    headerBlock[headerLen++] = (uchar) slen(name);
+    memcpy(&headerBlock[headerLen], name, slen(name));
+    headerLen += (int) slen(name);
+    headerBlock[headerLen++] = (uchar) slen(value);
+    memcpy(&headerBlock[headerLen], value, slen(value));
+    headerLen += (int) slen(value);
+}
+
+
+static void putFrame(uchar *buf, int len, int type, int flags, int id)
+{
+    buf[0] = (uchar) (len >> 16);
+    buf[1] = (uchar) (len >> 8);
+    buf[2] = (uchar) len;
+    buf[3] = (uchar) type;
+    buf[4] = (uchar) flags;
+    buf[5] = (uchar) (id >> 24);
+    buf[6] = (uchar) (id >> 16);
+    buf[7] = (uchar) (id >> 8);
+    buf[8] = (uchar) id;
+}
+
+
+/*
+    Issue requests one at a time on a keep-alive connection
+ */
+static void runHttp1(Client *client, int fd)
+{
+    char    buf[16 * 1024], *request, *end, *cp;
+    double  start;
+    ssize   len, nbytes, need;
+
+    request = "GET /bench HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    for (len = 0; client->completed < client->requests; ) {
+        start = now();
+        if (writeAll(fd, request, slen(request)) < 0) {
+            return;
+        }
+        for (need = -1; need < 0 || len < need; ) {
+            if ((nbytes = read(fd, &buf[len], sizeof(buf) - len - 1)) <= 0) {
+                return;
+            }
+            len += nbytes;
+            buf[len] = '\0';
+            if (need < 0 && (end = strstr(buf, "\r\n\r\n")) != 0) {
+                cp = strstr(buf, "Content-Length:");
+                need = (end - buf) + 4 + ((cp && cp < end) ? atoi(&cp[15]) : 0);
+            }
+        }
+        len -= need;
+        memmove(buf, &buf[need], len);
+        client->latency += now() - start;
+        client->completed++;
+    }
+}
+
+
+/*
+    Keep up to client->streams requests in flight on one HTTP/2 connection
+ */
+static void runHttp2(Client *client, int fd)
+{
+    uchar   buf[64 * 1024], out[64 * 1024], *frame;
+    double  *started;
+    ssize   len, nbytes, olen;
+    int     issued, inflight, id, type, flags, flen;
+
+    started = calloc(client->requests + 1, sizeof(double));
+    memcpy(out, HTTP2_PREFACE, HTTP2_PREFACE_SIZE);
+    putFrame(&out[HTTP2_PREFACE_SIZE], 0, HTTP2_SETTINGS_FRAME, 0, 0);
+    olen = HTTP2_PREFACE_SIZE + HTTP2_FRAME_HEADER_SIZE;
+    issued = inflight = 0;
+    len = 0;
+
+    while (client->completed < client->requests) {
+        while (inflight < client->streams && issued < client->requests &&
+                (olen + HTTP2_FRAME_HEADER_SIZE + headerLen) < (ssize) sizeof(out)) {
+            id = issued * 2 + 1;
+            putFrame(&out[olen], headerLen, HTTP2_HEADERS_FRAME, HTTP2_END_STREAM_FLAG | HTTP2_END_HEADERS_FLAG, id);
+            memcpy(&out[olen + HTTP2_FRAME_HEADER_SIZE], headerBlock, headerLen);
+            olen += HTTP2_FRAME_HEADER_SIZE + headerLen;
+            started[issued++] = now();
+            inflight++;
+        }
+        if (olen > 0) {
+            if (writeAll(fd, (char*) out, olen) < 0) {
+                break;
+            }
+            olen = 0;
+        }
+        if ((nbytes = read(fd, &buf[len], sizeof(buf) - len)) <= 0) {
+            break;
+        }
+        len += nbytes;
+        for (frame = buf; (len - (frame - buf)) >= HTTP2_FRAME_HEADER_SIZE; frame += HTTP2_FRAME_HEADER_SIZE + flen) {
+            flen = (frame[0] << 16) | (frame[1] << 8) | frame[2];
+            if ((len - (frame - buf)) < HTTP2_FRAME_HEADER_SIZE + flen) {
+                break;
+            }
+            type = frame[3];
+            flags = frame[4];
+            id = ((frame[5] & 0x7F) << 24) | (frame[6] << 16) | (frame[7] << 8) | frame[8];
+            if (type == HTTP2_SETTINGS_FRAME && !(flags & HTTP2_ACK_FLAG)) {
+                putFrame(&out[olen], 0, HTTP2_SETTINGS_FRAME, HTTP2_ACK_FLAG, 0);
+                olen += HTTP2_FRAME_HEADER_SIZE;
+
+            } else if (type == HTTP2_DATA_FRAME && flen > 0) {
+                /* Return flow control credit for the connection. Streams are short-lived. */
+                putFrame(&out[olen], 4, HTTP2_WINDOW_FRAME, 0, 0);
+                out[olen + 9] = (uchar) (flen >> 24);
+                out[olen + 10] = (uchar) (flen >> 16);
+                out[olen + 11] = (uchar) (flen >> 8);
+                out[olen + 12] = (uchar) flen;
+                olen += HTTP2_FRAME_HEADER_SIZE + 4;
+
+            } else if (type == HTTP2_GOAWAY_FRAME || type == HTTP2_RESET_FRAME) {
+                fprintf(stderr, "Stream %d failed, frame type %d\n", id, type);
+                client->completed = client->requests;
+                break;
+            }
+            if ((type == HTTP2_DATA_FRAME || type == HTTP2_HEADERS_FRAME) && (flags & HTTP2_END_STREAM_FLAG)) {
+                client->latency += now() - started[id / 2];
+                client->completed++;
+                inflight--;
+            }
+        }
+        len -= frame - buf;
+        memmove(buf, frame, len);
+    }
+    free(started);
+}
+
+
+static void *runClient(void *data)
+{
+    Client  *client;
+    int     fd;
+
+    client = (Client*) data;
+    if ((fd = connectServer()) < 0) {
+        fprintf(stderr, "Cannot connect to server\n");
+        return 0;
+    }
+    if (client->mode == MODE_HTTP1) {
+        runHttp1(client, fd);
+    } else {
+        runHttp2(client, fd);
+    }
+    close(fd);
+    return 0;
+}
+
+
+static void *runBench(void *data)
+{
+    Bench   *bench;
+    Client  *clients;
+    double  start, secs, latency;
+    int     mode, i, completed;
+
+    bench = (Bench*) data;
+    clients = calloc(bench->connections, sizeof(Client));
+
+    printf("%-10s %12s %8s %10s %12s %12s\n", "Mode", "Connections", "Streams", "Requests", "Requests/s", "Latency ms");
+    for (mode = MODE_HTTP1; mode <= MODE_HTTP2; mode++) {
+        start = now();
+        for (i = 0; i < bench->connections; i++) {
+            memset(&clients[i], 0, sizeof(Client));
+            clients[i].mode = mode;
+            clients[i].requests = bench->requests / bench->connections;
+            clients[i].streams = (mode == MODE_HTTP2) ? bench->streams : 1;
+            pthread_create(&clients[i].tid, NULL, runClient, &clients[i]);
+        }
+        completed = 0;
+        latency = 0;
+        for (i = 0; i < bench->connections; i++) {
+            pthread_join(clients[i].tid, NULL);
+            completed += clients[i].completed;
+            latency += clients[i].latency;
+        }
+        secs = now() - start;
+        printf("%-10s %12d %8d %10d %12.0f %12.3f\n", modeNames[mode], bench->connections,
+            clients[0].streams, completed, completed / secs, completed ? latency * 1000 / completed : 0);
+    }
+    free(clients);
+    exit(0);
+    return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+    HttpEndpoint    *endpoint;
+    HttpRoute       *route;
+    HttpLimits      *limits;
+    pthread_t       tid;
+    Bench           bench;
+
+    bench.requests = (argc > 1) ? atoi(argv[1]) : 100000;
+    bench.connections = (argc > 2) ? atoi(argv[2]) : 4;
+    bench.streams = (argc > 3) ? atoi(argv[3]) : 16;
+    if (bench.requests <= 0 || bench.connections <= 0 || bench.streams <= 0) {
+        fprintf(stderr, "Usage: benchHttp2 [requests [connections [streams]]]\n");
+        return 1;
+    }
+    addHeader(":method", "GET");
+    addHeader(":path", "/bench");
+    addHeader(":scheme", "http");
+    addHeader(":authority", "localhost");
+    signal(SIGPIPE, SIG_IGN);
+
+    mprCreate(argc, argv, MPR_USER_EVENTS_THREAD);
+    mprStart();
+    httpCreate(HTTP_SERVER_SIDE);
+    if ((endpoint = httpCreateConfiguredEndpoint(".", ".", "127.0.0.1", BENCH_PORT)) == 0) {
+        fprintf(stderr, "Cannot create endpoint\n");
+        return 1;
+    }
+    route = httpGetHostDefaultRoute(mprGetFirstItem(endpoint->hosts));
+    httpAddRouteFilter(route, "rangeFilter", NULL, HTTP_STAGE_TX);
+    httpAddRouteFilter(route, "chunkFilter", NULL, HTTP_STAGE_RX | HTTP_STAGE_TX);
+    httpSetRouteHandler(route, "actionHandler");
+    httpDefineAction("/bench", benchAction);
+
+    /* All clients connect from the loopback address */
+    limits = httpGraduateLimits(route, NULL);
+    limits->requestsPerClientMax = MAXINT;
+    limits->keepAliveMax = MAXINT;
+    limits->streamsMax = bench.streams;
+    if (httpStartEndpoint(endpoint) < 0) {
+        fprintf(stderr, "Cannot start endpoint\n");
+        return 1;
+    }
+    pthread_create(&tid, NULL, runBench, &bench);
+    mprServiceEvents(-1, 0);
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -0,0 +1,309 @@
+/**
+    benchIntern.c - Measure interned atoms against copied strings for the per-request HTTP vocabulary
+
+    Models the strings the request parser handles for a typical browser request: the method, the header names and the
+    document extension, followed by matching the method against a set of routes. The copy variant is the previous
+    implementation that copies each string and matches methods via the route methods hash. The atom variant uses the
+    interned atoms and the route method mask as the parser and router now do. Before timing, atoms are checked to be
+    unique pointers, header tables holding shared atom keys are checked to survive garbage collection and route method
+    masks are checked to match as the methods hash did.
+
+        copy        Copy the method, header names and extension. Match methods via the route methods hash.
+        atom        Use atoms for the method, header names and extension. Match methods via the route method mask.
+
+    Build from the repository top directory after building the libraries:
+
+        gcc -O2 -o benchIntern bench/benchIntern.c -Ilinux-x64-default/inc -Llinux-x64-default/bin -lhttp -lmpr \
+            -lpcre -lpthread -lm -ldl -Wl,-rpath,linux-x64-default/bin
+
+    Usage: benchIntern [routes [iterations]]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "http.h"
+
+/*********************************** Locals ***********************************/
+
+static cchar *headers[] = {
+    "Host", "Connection", "Cache-Control", "Upgrade-Insecure-Requests", "User-Agent", "Accept", "Accept-Encoding",
+    "Accept-Language", "Cookie", "X-Request-Id", 0
+};
+
+static cchar *methods[] = { "GET", "GET", "GET", "POST", "HEAD", "get", 0 };
+
+static cchar *routeMethods[] = { "GET,POST", "GET", "POST", "DELETE,PUT", "*", "GET,PROPFIND", 0 };
+
+static MprList  *routes;
+
+/************************************* Code ***********************************/
+
+static double now()
+{
+    struct timeval  tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+/*
+    Previous route method check
+ */
+static bool matchMethodHash(HttpRoute *route, cchar *method, int flags)
+{
+    if (!mprLookupKey(route->methods, method)) {
+        if (!mprLookupKey(route->methods, "*")) {
+            if (!(flags & HTTP_HEAD && mprLookupKey(route->methods, "GET"))) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+
+/*
+    Route method check as done by the router
+ */
+static bool matchMethodMask(HttpRoute *route, cchar *method, int flags)
+{
+    int     methodFlag;
+
+    if ((methodFlag = flags & HTTP_METHOD_MASK) != 0) {
+        return (route->methodMask & methodFlag) || (methodFlag & HTTP_HEAD && route->methodMask & HTTP_GET);
+    }
+    return mprLookupKey(route->methods, method) || mprLookupKey(route->methods, "*");
+}
+
+
+/*
+    Previous extension parsing
+ */
+static char *copyPathExt(cchar *path)
+{
+    char    *ep, *ext;
+
+    if ((ext = strrchr(path, '.')) != 0) {
+        ext = sclone(++ext);
+        for (ep = ext; *ep && isalnum((uchar) *ep); ep++) {
+            ;
+        }
+        *ep = '\0';
+    }
+    return ext;
+}
+
+
+static int verify()
+{
+    HttpRoute   *route;
+    MprHash     *open, *chained;
+    MprKey      *kp;
+    cchar       **cp, *atom;
+    char        key[32];
+    int         errors, i, flags;
+
+    errors = 0;
+    /* Atoms are unique pointers and other strings are copied */
+    if (httpLookupAtom("Content-Type") != httpIntern(sclone("Content-Type")) ||
+            httpLookupAtom("content-type") != httpInternBlock("content-type: text/html", 12) ||
+            httpLookupAtom("Content-type") || httpLookupAtom("X-Request-Id")) {
+        errors++;
+    }
+    if (httpGetPathExt("/index.html") != httpLookupAtom("html") || !smatch(httpGetPathExt("/a.b/file.xyz?q"), "xyz") ||
+            !smatch(httpGetPathExt("/file.html5"), "html5") || httpGetPathExt("/file")) {
+        errors++;
+    }
+    atom = httpAddAtom(sclone("X-Request-Id"));
+    if (atom != httpLookupAtom("X-Request-Id") || atom != httpAddAtom("X-Request-Id")) {
+        errors++;
+    }
+    /* Shared atom keys survive collection in tables that mark their keys */
+    open = mprCreateHash(HTTP_SMALL_HASH_SIZE, MPR_HASH_CASELESS | MPR_HASH_OPEN);
+    chained = mprCreateHash(HTTP_SMALL_HASH_SIZE, MPR_HASH_CASELESS);
+    mprAddRoot(open);
+    mprAddRoot(chained);
+    for (i = 0; i < 100; i++) {
+        for (cp = headers; *cp; cp++) {
+            fmt(key, sizeof(key), "%s-%d", *cp, i);
+            mprAddSharedKey(open, httpAddAtom(key), sclone(*cp));
+            mprAddSharedKey(chained, httpLookupAtom(key), sclone(*cp));
+        }
+    }
+    mprRequestGC(MPR_GC_FORCE | MPR_GC_COMPLETE);
+    for (ITERATE_KEYS(open, kp)) {
+        if (kp->key != httpLookupAtom(kp->key) || !sstarts(kp->key, kp->data)) {
+            errors++;
+        }
+    }
+    for (ITERATE_KEYS(chained, kp)) {
+        if (kp->key != httpLookupAtom(kp->key) || !sstarts(kp->key, kp->data)) {
+            errors++;
+        }
+    }
+    if (mprGetHashLength(open) != 1000 || mprGetHashLength(chained) != 1000) {
+        errors++;
+    }
+    mprRemoveRoot(chained);
+    mprRemoveRoot(open);
+
+    /* Method masks match as the methods hash */
+    for (i = 0; routeMethods[i]; i++) {
+        route = httpCreateRoute(0);
+        httpSetRouteMethods(route, routeMethods[i]);
+        for (cp = methods; *cp; cp++) {
+            flags = httpGetMethodFlag(*cp);
+            if (matchMethodHash(route, *cp, flags) != matchMethodMask(route, *cp, flags)) {
+                errors++;
+            }
+        }
+        if (matchMethodHash(route, "PROPFIND", 0) != matchMethodMask(route, "PROPFIND", 0)) {
+            errors++;
+        }
+    }
+    route = httpCreateRoute(0);
+    httpSetRouteMethods(route, "GET, POST");
+    if (route->methodMask != (HTTP_GET | HTTP_POST)) {
+        errors++;
+    }
+    httpRemoveRouteMethods(route, "POST");
+    httpAddRouteMethods(route, "PUT");
+    if (route->methodMask != (HTTP_GET | HTTP_PUT)) {
+        errors++;
+    }
+    httpAddRouteMethods(route, "ALL");
+    if (route->methodMask != HTTP_METHOD_MASK) {
+        errors++;
+    }
+    if (httpGetMethodFlag("DELETE") != HTTP_DELETE || httpGetMethodFlag("delete") || httpGetMethodFlag("PROPFIND")) {
+        errors++;
+    }
+    return errors;
+}
+
+
+static void bench(cchar *name, int iterations)
+{
+    HttpRoute   *route;
+    MprHash     *table;
+    cchar       **cp, *atom, *method, *ext;
+    double      start, elapsed;
+    int         i, next, flags, matched, atoms;
+
+    atoms = smatch(name, "atom");
+    matched = 0;
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        method = methods[i % 5];
+        if (atoms) {
+            if ((method = httpLookupAtom(method)) == 0) {
+                method = supper(methods[i % 5]);
+            }
+        } else {
+            method = supper(method);
+        }
+        flags = httpGetMethodFlag(method);
+        table = mprCreateHash(HTTP_SMALL_HASH_SIZE, MPR_HASH_CASELESS | MPR_HASH_OPEN);
+        for (cp = headers; *cp; cp++) {
+            if (atoms && (atom = httpLookupAtom(*cp)) != 0) {
+                mprAddSharedKey(table, atom, sclone("value"));
+            } else {
+                mprAddKey(table, *cp, sclone("value"));
+            }
+        }
+        ext = atoms ? httpGetPathExt("/app/index.html") : copyPathExt("/app/index.html");
+        for (ITERATE_ITEMS(routes, route, next)) {
+            if (atoms ? matchMethodMask(route, method, flags) : matchMethodHash(route, method, flags)) {
+                matched++;
+                break;
+            }
+        }
+        if (ext == 0 || (i % 100) == 0) {
+            mprYield(0);
+        }
+    }
+    elapsed = now() - start;
+    printf("%-8s %8d %12.3f %14.0f\n", name, mprGetListLength(routes), elapsed * 1e6 / iterations, iterations / elapsed);
+    if (matched != iterations) {
+        printf("Unexpected match count %d\n", matched);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    HttpRoute   *route;
+    int         count, iterations, errors, i;
+
+    count = (argc > 1) ? atoi(argv[1]) : 20;
+    iterations = (argc > 2) ? atoi(argv[2]) : 1000000;
+    if (count <= 0) {
+        count = 20;
+    }
+    if (iterations <= 0) {
+        iterations = 1000000;
+    }
+    mprCreate(argc, argv, 0);
+    mprStart();
+    httpCreate(HTTP_SERVER_SIDE);
+    if ((errors = verify()) != 0) {
+        printf("Intern verification failed with %d errors\n", errors);
+        return 1;
+    }
+    /* Requests match only the last route so every route is checked */
+    routes = mprCreateList(count, 0);
+    mprAddRoot(routes);
+    for (i = 0; i < count; i++) {
+        route = httpCreateRoute(0);
+        if (i == count - 1) {
+            httpSetRouteMethods(route, "GET,POST,HEAD");
+        } else {
+            httpSetRouteMethods(route, (i % 2) ? "DELETE" : "OPTIONS,TRACE");
+        }
+        mprAddItem(routes, route);
+    }
+
+    printf("%-8s %8s %12s %14s\n", "Test", "Routes", "usec/req", "requests/sec");
+    bench("copy", iterations);
+    bench("atom", iterations);
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
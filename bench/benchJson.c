@@ -0,0 +1,280 @@
+/**
+    benchJson.c - Measure the streaming JSON tape parser against mprDeserialize
+
+    Generates JSON request bodies and delivers them in packet sized pieces. The deserialize variant joins the pieces
+    and calls mprDeserialize as httpAddBodyParams did. The tape variants write each piece to a JSON tape as it
+    arrives and then either query a few values, or convert the complete tape to an object tree. Before timing, the
+    tape results are checked against mprDeserialize for a set of documents written in pieces of every size.
+
+        deserialize Join the packets and build the object tree with mprDeserialize
+        tape        Parse the packets into a tape
+        query       Parse into a tape and query three values with mprQueryJsonTape
+        hash        Parse into a tape and convert to an object tree with mprJsonTapeToHash
+
+    The MPR is compiled into the benchmark with allocation statistics enabled to count allocations per document.
+    Build from the repository top directory:
+
+        gcc -O2 -fPIC -DBIT_MPR_ALLOC_STATS=1 -o benchJson bench/benchJson.c src/deps/mpr/mprLib.c \
+            -Ilinux-x64-default/inc -lpthread -lm -ldl
+
+    Usage: benchJson [kilobytes [iterations]]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "mpr.h"
+
+/*********************************** Locals ***********************************/
+
+#define PACKET_SIZE     (16 * 1024)         /* Typical received packet size */
+
+static cchar *documents[] = {
+    "{}",
+    "[]",
+    " { \"a\" : \"1\" , \"b\":[1, 2.5e3, true, false, null], \"c\":{\"d\":{\"e\":[[],{}]}} } ",
+    "{\"name\":\"x\",\"list\":[{\"id\":1},{\"id\":2,\"tags\":[\"a\",\"b\"]}],\"empty\":\"\",\"n\":-12}",
+    "{\"trailing\":[1,2,],\"obj\":{\"a\":1,},}",
+    "{\"path\":\"C:\\\\temp\\\\\",\"unicode\":\"\\u00e9t\\u00e9\",\"tab\":\"a\\tb\"}",
+    "[\"top\", {\"level\":\"array\"}, [1, [2, [3]]]]",
+    "{\"dup\":\"first\",\"dup\":\"second\"}",
+    "{\n\t\"lines\" : \"one\",\r\n\t\"more\" : { \"x\" : 1 }\n}",
+    /* Syntax not supported by the tape is converted with mprDeserialize */
+    "{'single':'quotes'}",
+    "{unquoted: 1, key: \"value\"}",
+    "{\"a\":1 /* comment */ , \"b\":2}",
+    0
+};
+
+/************************************* Code ***********************************/
+
+static double now()
+{
+    struct timeval  tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+static uint64 allocations()
+{
+#if BIT_MPR_ALLOC_STATS
+    return MPR->heap->stats.requests;
+#else
+    return 0;
+#endif
+}
+
+
+/*
+    Generate an API request body of records with strings, numbers, booleans and nested objects. Escaped quotes are
+    not used as mprDeserialize does not support them.
+ */
+static char *createDocument(ssize size)
+{
+    MprBuf      *buf;
+    uint        seed;
+    int         i;
+
+    buf = mprCreateBuf(size + 1024, 0);
+    mprPutStringToBuf(buf, "{\"user\":\"admin\",\"token\":\"a1b2c3d4\",\"records\":[");
+    seed = 1;
+    for (i = 0; mprGetBufLength(buf) < size; i++) {
+        seed = seed * 1103515245 + 12345;
+        mprPutToBuf(buf, "%s{\"id\":%d,\"name\":\"item %d\",\"price\":%u.%02u,\"inStock\":%s,"
+            "\"tags\":[\"red\",\"large\"],\"dimensions\":{\"width\":%u,\"height\":%u},"
+            "\"description\":\"A description\\nwith escapes\\tand a path C:\\\\temp\"}",
+            i ? "," : "", i, i, seed % 1000, (seed >> 10) % 100, (seed & 0x100) ? "true" : "false",
+            (seed >> 8) % 100, (seed >> 16) % 100);
+    }
+    mprPutStringToBuf(buf, "],\"count\":\"last\"}");
+    mprAddNullToBuf(buf);
+    return sclone(mprGetBufStart(buf));
+}
+
+
+static MprJsonTape *writeTape(cchar *doc, ssize len, ssize packetSize)
+{
+    MprJsonTape     *tape;
+    ssize           pos, n;
+
+    tape = mprCreateJsonTape(len);
+    for (pos = 0; pos < len; pos += n) {
+        n = min(packetSize, len - pos);
+        mprWriteJsonTape(tape, &doc[pos], n);
+    }
+    mprFinishJsonTape(tape);
+    return tape;
+}
+
+
+static int verify()
+{
+    MprJsonTape     *tape;
+    cchar           *doc, *expected, *actual, *str;
+    ssize           len, packetSize;
+    int             i, errors;
+
+    errors = 0;
+    for (i = 0; documents[i]; i++) {
+        doc = documents[i];
+        for (str = doc; isspace((uchar) *str); str++) ;
+        expected = mprSerialize(mprDeserialize(str), 0);
+        len = slen(doc);
+        for (packetSize = 1; packetSize <= len; packetSize++) {
+            tape = writeTape(doc, len, packetSize);
+            actual = mprSerialize(mprJsonTapeToHash(tape, NULL), 0);
+            if (!smatch(actual, expected)) {
+                printf("Mismatch for document %d, packet size %d\n    %s\n    %s\n", i, (int) packetSize, expected, actual);
+                errors++;
+                break;
+            }
+        }
+        mprYield(0);
+    }
+    /* Escaped quotes and backslashes are found across packet boundaries */
+    doc = "{\"a\":\"x\\\"y\\\\\",\"b\":{\"c\":\"\\\\\\\"\"},\"d\":[1]}";
+    for (packetSize = 1; packetSize <= slen(doc); packetSize++) {
+        tape = writeTape(doc, slen(doc), packetSize);
+        if (!smatch(mprQueryJsonTape(tape, "a"), "x\\\"y\\\\") || !smatch(mprQueryJsonTape(tape, "b.c"), "\\\\\\\"") ||
+                mprQueryJsonTape(tape, "d") != 0 || mprQueryJsonTape(tape, "b.missing") != 0) {
+            printf("Escape query failed for packet size %d\n", (int) packetSize);
+            errors++;
+            break;
+        }
+    }
+    /* Incomplete and invalid documents */
+    if (mprFinishJsonTape(writeTape("{\"a\":[1,2}", 10, 3)) != MPR_ERR_BAD_FORMAT ||
+            mprFinishJsonTape(writeTape("{\"a\":\"open", 10, 4)) != MPR_ERR_BAD_FORMAT) {
+        printf("Invalid document accepted\n");
+        errors++;
+    }
+    return errors;
+}
+
+
+static void bench(cchar *name, cchar *doc, ssize len, int iterations)
+{
+    MprJsonTape     *tape;
+    MprBuf          *joined;
+    MprHash         *obj;
+    double          start, elapsed;
+    uint64          allocs;
+    ssize           pos, n;
+    int             i, found;
+
+    found = 0;
+    allocs = allocations();
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        if (smatch(name, "deserialize")) {
+            joined = mprCreateBuf(PACKET_SIZE, 0);
+            for (pos = 0; pos < len; pos += n) {
+                n = min(PACKET_SIZE, len - pos);
+                mprPutBlockToBuf(joined, &doc[pos], n);
+            }
+            mprAddNullToBuf(joined);
+            obj = mprDeserialize(mprGetBufStart(joined));
+            found += mprQueryJsonString(obj, "user") != 0;
+        } else {
+            tape = writeTape(doc, len, PACKET_SIZE);
+            if (smatch(name, "query")) {
+                found += mprQueryJsonTape(tape, "user") != 0;
+                found += mprQueryJsonTape(tape, "token") != 0;
+                found += mprQueryJsonTape(tape, "count") != 0;
+            } else if (smatch(name, "hash")) {
+                obj = mprJsonTapeToHash(tape, NULL);
+                found += mprQueryJsonString(obj, "user") != 0;
+            } else {
+                found += tape->count > 0;
+            }
+        }
+        mprYield(0);
+    }
+    elapsed = now() - start;
+    allocs = allocations() - allocs;
+    printf("%-12s %10d %12.1f %12.1f ", name, (int) len, elapsed * 1e3 / iterations,
+        len * iterations / elapsed / (1024 * 1024));
+#if BIT_MPR_ALLOC_STATS
+    printf("%12.0f\n", (double) allocs / iterations);
+#else
+    printf("%12s\n", "n/a");
+#endif
+    if (found < iterations) {
+        printf("Unexpected result count %d\n", found);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    char        *doc;
+    ssize       len;
+    int         kilobytes, iterations, errors;
+
+    kilobytes = (argc > 1) ? atoi(argv[1]) : 1024;
+    iterations = (argc > 2) ? atoi(argv[2]) : 10;
+    if (kilobytes <= 0) {
+        kilobytes = 1024;
+    }
+    if (iterations <= 0) {
+        iterations = 10;
+    }
+    mprCreate(argc, argv, 0);
+    mprStart();
+    if ((errors = verify()) != 0) {
+        printf("Tape verification failed with %d errors\n", errors);
+        return 1;
+    }
+    doc = createDocument((ssize) kilobytes * 1024);
+    mprAddRoot(doc);
+    len = slen(doc);
+
+#if !BIT_MPR_ALLOC_STATS
+    printf("Allocation counts are not available. Build with -DBIT_MPR_ALLOC_STATS=1 to count allocations.\n");
+#endif
+    printf("%-12s %10s %12s %12s %12s\n", "Parse", "Bytes", "msec/doc", "MB/sec", "allocs/doc");
+    bench("deserialize", doc, len, iterations);
+    bench("tape", doc, len, iterations);
+    bench("query", doc, len, iterations);
+    bench("hash", doc, len, iterations);
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
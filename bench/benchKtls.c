@@ -0,0 +1,288 @@
+/**
+    benchKtls.c - Compare loopback throughput of user-space TLS encryption and kernel TLS sendfile
+
+    Sends a file over a loopback TCP connection using:
+        sendfile        Plain sendfile without encryption (upper bound)
+        user-tls        Read the file and encrypt TLS 1.2 AES-128-GCM records in user space, then write
+        ktls-sendfile   Install AES-128-GCM keys into kernel TLS (TLS_TX) and use sendfile
+
+    Kernel TLS requires Linux 4.13 or later with the "tls" module loaded (see /proc/sys/net/ipv4/tcp_available_ulp).
+    If it is not available, the ktls-sendfile mode is reported as unavailable, which is the same condition under
+    which the HTTP send connector falls back to user-space encryption.
+
+    Build from the repository top directory after building the libraries:
+
+        gcc -O2 -o benchKtls bench/benchKtls.c -Ilinux-x64-default/inc -Llinux-x64-default/bin -lest -lpthread \
+            -Wl,-rpath,linux-x64-default/bin
+
+    Usage: benchKtls [megabytes]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "est.h"
+#include    <pthread.h>
+#include    <netinet/tcp.h>
+#include    <sys/sendfile.h>
+#include    <linux/tls.h>
+
+/*********************************** Locals ***********************************/
+
+#ifndef SOL_TLS
+    #define SOL_TLS     282
+#endif
+#ifndef TCP_ULP
+    #define TCP_ULP     31
+#endif
+
+#define RECORD_SIZE     (16 * 1024)     /* Max TLS plaintext record size */
+#define MODE_SENDFILE   0
+#define MODE_USER_TLS   1
+#define MODE_KTLS       2
+
+static char *modeNames[] = { "sendfile", "user-tls", "ktls-sendfile" };
+
+static uchar key[16], iv[4], seq[8];
+
+/************************************* Code ***********************************/
+
+static void *drain(void *data)
+{
+    char    buf[64 * 1024];
+    int     fd;
+
+    fd = *(int*) data;
+    while (read(fd, buf, sizeof(buf)) > 0) {}
+    return 0;
+}
+
+
+/*
+    Create a connected loopback TCP pair. Kernel TLS requires TCP.
+ */
+static int connectPair(int *client, int *server)
+{
+    struct sockaddr_in  addr;
+    socklen_t           len;
+    int                 lfd;
+
+    if ((lfd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    len = sizeof(addr);
+    if (bind(lfd, (struct sockaddr*) &addr, len) < 0 || listen(lfd, 1) < 0 ||
+            getsockname(lfd, (struct sockaddr*) &addr, &len) < 0) {
+        close(lfd);
+        return -1;
+    }
+    if ((*client = socket(AF_INET, SOCK_STREAM, 0)) < 0 || connect(*client, (struct sockaddr*) &addr, len) < 0) {
+        close(lfd);
+        return -1;
+    }
+    *server = accept(lfd, NULL, NULL);
+    close(lfd);
+    return (*server < 0) ? -1 : 0;
+}
+
+
+static int enableKtls(int fd)
+{
+    struct tls12_crypto_info_aes_gcm_128    info;
+
+    if (setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) < 0) {
+        return -1;
+    }
+    memset(&info, 0, sizeof(info));
+    info.info.version = TLS_1_2_VERSION;
+    info.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+    memcpy(info.key, key, TLS_CIPHER_AES_GCM_128_KEY_SIZE);
+    memcpy(info.salt, iv, TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+    memcpy(info.iv, seq, TLS_CIPHER_AES_GCM_128_IV_SIZE);
+    memcpy(info.rec_seq, seq, TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE);
+    return setsockopt(fd, SOL_TLS, TLS_TX, &info, sizeof(info));
+}
+
+
+static int writeAll(int fd, uchar *buf, ssize len)
+{
+    ssize   rc;
+
+    while (len > 0) {
+        if ((rc = write(fd, buf, len)) <= 0) {
+            return -1;
+        }
+        buf += rc;
+        len -= rc;
+    }
+    return 0;
+}
+
+
+/*
+    Read, encrypt and write TLS 1.2 AES-GCM records as an SSL provider does in user space
+ */
+static int sendUserTls(int fd, int file, off_t size)
+{
+    gcm_context     gcm;
+    uchar           plain[RECORD_SIZE], record[5 + 8 + RECORD_SIZE + 16], nonce[12], add[13];
+    uint64          recSeq;
+    off_t           pos;
+    ssize           len;
+    int             i;
+
+    gcm_setkey(&gcm, key, 128);
+    for (pos = 0, recSeq = 0; pos < size; pos += len, recSeq++) {
+        if ((len = pread(file, plain, RECORD_SIZE, pos)) <= 0) {
+            return -1;
+        }
+        memcpy(nonce, iv, 4);
+        for (i = 0; i < 8; i++) {
+            nonce[4 + i] = add[i] = (uchar) (recSeq >> (56 - i * 8));
+        }
+        add[8] = 23;
+        add[9] = 3;
+        add[10] = 3;
+        add[11] = (uchar) (len >> 8);
+        add[12] = (uchar) len;
+
+        record[0] = 23;
+        record[1] = 3;
+        record[2] = 3;
+        record[3] = (uchar) ((len + 24) >> 8);
+        record[4] = (uchar) (len + 24);
+        memcpy(&record[5], &nonce[4], 8);
+        gcm_crypt_and_tag(&gcm, GCM_ENCRYPT, (int) len, nonce, 12, add, 13, plain, &record[13], 16, &record[13 + len]);
+        if (writeAll(fd, record, 13 + len + 16) < 0) {
+            return -1;
+        }
+    }
+    gcm_free(&gcm);
+    return 0;
+}
+
+
+static int sendFile(int fd, int file, off_t size)
+{
+    off_t   off;
+    ssize   rc;
+
+    for (off = 0; off < size; ) {
+        if ((rc = sendfile(fd, file, &off, (size_t) (size - off))) <= 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval  now;
+
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - start->tv_sec) + (now.tv_usec - start->tv_usec) / 1e6;
+}
+
+
+int main(int argc, char **argv)
+{
+    struct timeval  start;
+    pthread_t       tid;
+    char            path[] = "/tmp/benchKtlsXXXXXX", buf[64 * 1024];
+    double          secs;
+    off_t           size;
+    int             file, client, server, megabytes, mode, i, rc;
+
+    megabytes = (argc > 1) ? atoi(argv[1]) : 256;
+    if (megabytes <= 0) {
+        megabytes = 256;
+    }
+    size = (off_t) megabytes * 1024 * 1024;
+    if ((file = mkstemp(path)) < 0) {
+        fprintf(stderr, "Cannot create %s\n", path);
+        return 1;
+    }
+    unlink(path);
+    for (i = 0; i < (int) sizeof(buf); i++) {
+        buf[i] = (char) (i * 7);
+    }
+    for (i = 0; i < (int) (size / sizeof(buf)); i++) {
+        if (write(file, buf, sizeof(buf)) != sizeof(buf)) {
+            fprintf(stderr, "Cannot write %s\n", path);
+            return 1;
+        }
+    }
+    memset(key, 0x42, sizeof(key));
+    memset(iv, 0x24, sizeof(iv));
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("%-14s %10s %10s %12s\n", "Mode", "Megabytes", "Seconds", "MB/s");
+    for (mode = MODE_SENDFILE; mode <= MODE_KTLS; mode++) {
+        if (connectPair(&client, &server) < 0) {
+            fprintf(stderr, "Cannot create loopback connection\n");
+            return 1;
+        }
+        if (mode == MODE_KTLS && enableKtls(server) < 0) {
+            printf("%-14s %s (%s)\n", modeNames[mode], "unavailable", strerror(errno));
+            close(client);
+            close(server);
+            continue;
+        }
+        pthread_create(&tid, NULL, drain, &client);
+        gettimeofday(&start, NULL);
+        rc = (mode == MODE_USER_TLS) ? sendUserTls(server, file, size) : sendFile(server, file, size);
+        shutdown(server, SHUT_WR);
+        pthread_join(tid, NULL);
+        secs = elapsed(&start);
+        close(client);
+        close(server);
+        if (rc < 0) {
+            fprintf(stderr, "%s failed: %s\n", modeNames[mode], strerror(errno));
+            return 1;
+        }
+        printf("%-14s %10d %10.3f %12.1f\n", modeNames[mode], megabytes, secs, megabytes / secs);
+    }
+    close(file);
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
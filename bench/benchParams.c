@@ -0,0 +1,281 @@
+/**
+    benchParams.c - Measure eager against lazy decoding of urlencoded form params
+
+    Posts a large urlencoded form body through httpAddBodyParams and reads a few params as a typical handler does.
+    The eager variant is the previous implementation that copies the body and decodes every key and value into the
+    params table. The lazy variants use the param index which decodes values in place only when requested.
+    Before timing, every param retrieved via httpGetParam is checked against the eager params table.
+
+        eager       Copy, tokenize and decode every param into the params table
+        lazy        Index the body and decode only the requested params (httpGetParam)
+        table       Index the body then request the complete params table (httpGetParams)
+
+    Build from the repository top directory after building the libraries:
+
+        gcc -O2 -o benchParams bench/benchParams.c -Ilinux-x64-default/inc -Llinux-x64-default/bin -lhttp -lmpr \
+            -lpcre -lpthread -lm -ldl -Wl,-rpath,linux-x64-default/bin
+
+    Usage: benchParams [fields [iterations]]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "http.h"
+
+/*********************************** Locals ***********************************/
+
+#define LOOKUPS     4
+
+static cchar *lookups[LOOKUPS] = { "field-1", "comment", "missing", "tag" };
+
+/************************************* Code ***********************************/
+
+static double now()
+{
+    struct timeval  tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+/*
+    Build a form with escaped values, a repeated key and some empty values
+ */
+static char *createForm(int fields)
+{
+    MprBuf      *buf;
+    int         i;
+
+    buf = mprCreateBuf(0, 0);
+    mprPutStringToBuf(buf, "comment=Hello+World%21+%E2%9C%93&tag=a");
+    for (i = 0; i < fields; i++) {
+        mprPutToBuf(buf, "&field-%d=value+%d+with%%20some%%2Fescapes", i, i);
+        if ((i % 50) == 0) {
+            mprPutToBuf(buf, "&tag=t%d&empty-%d=", i, i);
+        }
+    }
+    mprAddNullToBuf(buf);
+    return sclone(mprGetBufStart(buf));
+}
+
+
+/*
+    The previous eager implementation
+ */
+static MprHash *addEagerParams(cchar *buf, ssize len)
+{
+    MprHash     *vars;
+    cchar       *oldValue;
+    char        *newValue, *decoded, *keyword, *value, *tok;
+
+    vars = mprCreateHash(61, MPR_HASH_OPEN);
+    decoded = mprAlloc(len + 1);
+    decoded[len] = '\0';
+    memcpy(decoded, buf, len);
+
+    keyword = stok(decoded, "&", &tok);
+    while (keyword != 0) {
+        if ((value = strchr(keyword, '=')) != 0) {
+            *value++ = '\0';
+            value = mprUriDecode(value);
+        } else {
+            value = MPR->emptyString;
+        }
+        keyword = mprUriDecode(keyword);
+        if (*keyword) {
+            oldValue = mprLookupKey(vars, keyword);
+            if (oldValue != 0 && *oldValue) {
+                if (*value) {
+                    newValue = sjoin(oldValue, " ", value, NULL);
+                    mprAddKey(vars, keyword, newValue);
+                }
+            } else {
+                mprAddKey(vars, keyword, value);
+            }
+        }
+        keyword = stok(0, "&", &tok);
+    }
+    return vars;
+}
+
+
+/*
+    Prepare a new request with the form body queued on the read queue
+ */
+static void postForm(HttpConn *conn, cchar *form, ssize len)
+{
+    HttpPacket  *packet;
+
+    httpGetPacket(conn->readq);
+    if (conn->rx) {
+        httpDestroyRx(conn->rx);
+    }
+    conn->rx = httpCreateRx(conn);
+    conn->rx->eof = 1;
+    conn->rx->form = 1;
+    packet = httpCreateDataPacket(len);
+    mprPutBlockToBuf(packet->content, form, len);
+    httpPutForService(conn->readq, packet, HTTP_DELAY_SERVICE);
+}
+
+
+static int verify(HttpConn *conn, cchar *form, ssize len)
+{
+    MprHash     *eager, *table;
+    MprKey      *kp;
+    cchar       *value;
+    int         errors, i;
+
+    eager = addEagerParams(form, len);
+    mprAddRoot(eager);
+    errors = 0;
+
+    /* Individual lookups, including a repeated key, escapes and missing keys */
+    postForm(conn, form, len);
+    httpAddBodyParams(conn);
+    for (kp = 0; (kp = mprGetNextKey(eager, kp)) != 0; ) {
+        if ((value = httpGetParam(conn, kp->key, 0)) == 0 || !smatch(value, kp->data)) {
+            errors++;
+        }
+    }
+    for (i = 0; i < LOOKUPS; i++) {
+        if (!smatch(httpGetParam(conn, lookups[i], 0), mprLookupKey(eager, lookups[i]))) {
+            errors++;
+        }
+    }
+    /* Set params supersede indexed params. The complete table then has the same content */
+    httpSetParam(conn, "field-2", "override");
+    table = httpGetParams(conn);
+    if (!smatch(httpGetParam(conn, "field-2", 0), "override") || mprGetHashLength(table) != mprGetHashLength(eager)) {
+        errors++;
+    }
+    /* Complete table without prior lookups */
+    postForm(conn, form, len);
+    httpAddBodyParams(conn);
+    table = httpGetParams(conn);
+    for (kp = 0; (kp = mprGetNextKey(eager, kp)) != 0; ) {
+        if (!smatch(mprLookupKey(table, kp->key), kp->data)) {
+            errors++;
+        }
+    }
+    if (mprGetHashLength(table) != mprGetHashLength(eager)) {
+        errors++;
+    }
+    mprRemoveRoot(eager);
+    return errors;
+}
+
+
+static void bench(HttpConn *conn, cchar *name, cchar *form, ssize len, int iterations)
+{
+    MprHash     *vars;
+    cchar       *value;
+    double      start, elapsed;
+    int         i, j, found;
+
+    found = 0;
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        postForm(conn, form, len);
+        if (smatch(name, "eager")) {
+            vars = addEagerParams(mprGetBufStart(conn->readq->first->content), len);
+            for (j = 0; j < LOOKUPS; j++) {
+                if ((value = mprLookupKey(vars, lookups[j])) != 0) {
+                    found++;
+                }
+            }
+        } else {
+            httpAddBodyParams(conn);
+            if (smatch(name, "table")) {
+                httpGetParams(conn);
+            }
+            for (j = 0; j < LOOKUPS; j++) {
+                if ((value = httpGetParam(conn, lookups[j], 0)) != 0) {
+                    found++;
+                }
+            }
+        }
+        mprYield(0);
+    }
+    elapsed = now() - start;
+    printf("%-8s %10d %12.1f %12.1f\n", name, (int) len, elapsed * 1e6 / iterations, len * iterations / elapsed / 1e6);
+    if (found != iterations * (LOOKUPS - 1)) {
+        printf("Unexpected lookup count %d\n", found);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    Http        *http;
+    HttpConn    *conn;
+    char        *form;
+    ssize       len;
+    int         fields, iterations, errors;
+
+    fields = (argc > 1) ? atoi(argv[1]) : 2000;
+    iterations = (argc > 2) ? atoi(argv[2]) : 2000;
+    if (fields <= 0) {
+        fields = 2000;
+    }
+    if (iterations <= 0) {
+        iterations = 2000;
+    }
+    mprCreate(argc, argv, 0);
+    mprStart();
+    http = httpCreate(HTTP_CLIENT_SIDE);
+    conn = httpCreateConn(http, NULL, NULL);
+    mprAddRoot(conn);
+    form = createForm(fields);
+    mprAddRoot(form);
+    len = slen(form);
+
+    if ((errors = verify(conn, form, len)) != 0) {
+        printf("Param verification failed with %d errors\n", errors);
+        return 1;
+    }
+    printf("%-8s %10s %12s %12s\n", "Parse", "Bytes", "usec/req", "MB/sec");
+    bench(conn, "eager", form, len, iterations);
+    bench(conn, "lazy", form, len, iterations);
+    bench(conn, "table", form, len, iterations);
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
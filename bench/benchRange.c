@@ -0,0 +1,327 @@
+/**
+    benchRange.c - Measure large file range request throughput with and without the send connector
+
+    Starts an in-process HTTP server with a minimal static file handler and issues range requests for a large file
+    over loopback keep-alive connections:
+        read        Entity data is read into packets by the range filter and written by the net connector
+        sendfile    Each range is transmitted from the file by the send connector
+
+    Requests are either single ranges (as for a video seek or a resumed download) or multipart/byteranges
+    responses with several ranges.
+
+    Build from the repository top directory after building the libraries:
+
+        gcc -O2 -o benchRange bench/benchRange.c -Ilinux-x64-default/inc -Llinux-x64-default/bin -lhttp -lmpr \
+            -lpcre -lpthread -lm -ldl -Wl,-rpath,linux-x64-default/bin
+
+    Usage: benchRange [megabytes [requests [rangeKilobytes]]]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "http.h"
+#include    <pthread.h>
+
+/*********************************** Locals ***********************************/
+
+#define BENCH_PORT      18281
+#define BENCH_FILE      "benchRange.dat"
+#define MODE_READ       0
+#define MODE_SENDFILE   1
+
+static char *modeNames[] = { "read", "sendfile" };
+
+typedef struct Bench {
+    MprOff  size;                       /* File size */
+    int     requests;                   /* Requests per test */
+    int     rangeSize;                  /* Bytes per range */
+} Bench;
+
+static Http         *http;
+static HttpStage    *fileHandler;
+
+/************************************* Code ***********************************/
+
+static ssize fillFile(HttpQueue *q, HttpPacket *packet, MprOff pos, ssize size)
+{
+    HttpTx      *tx;
+    ssize       nbytes;
+
+    tx = q->conn->tx;
+    if (!tx->file && (tx->file = mprOpenFile(tx->filename, O_RDONLY | O_BINARY, 0)) == 0) {
+        return MPR_ERR_CANT_OPEN;
+    }
+    if (!packet->content && (packet->content = mprCreateBuf(size, -1)) == 0) {
+        return MPR_ERR_MEMORY;
+    }
+    if (mprSeekFile(tx->file, SEEK_SET, pos) != pos || 
+            (nbytes = mprReadFile(tx->file, mprGetBufEnd(packet->content), size)) != size) {
+        return MPR_ERR_CANT_READ;
+    }
+    mprAdjustBufEnd(packet->content, nbytes);
+    packet->esize = 0;
+    return nbytes;
+}
+
+
+static int rewriteFile(HttpConn *conn)
+{
+    httpMapFile(conn, conn->rx->route);
+    if (conn->tx->fileInfo.valid) {
+        httpSetEntityLength(conn, conn->tx->fileInfo.size);
+    }
+    return 0;
+}
+
+
+static void startFile(HttpQueue *q)
+{
+    HttpTx      *tx;
+
+    tx = q->conn->tx;
+    httpPutForService(q, httpCreateEntityPacket(0, tx->fileInfo.size, fillFile), HTTP_DELAY_SERVICE);
+    httpFinalize(q->conn);
+}
+
+
+static double now()
+{
+    struct timeval  tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+static int connectServer()
+{
+    struct sockaddr_in  addr;
+    int                 fd;
+
+    if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(BENCH_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+
+static int writeAll(int fd, cchar *buf, ssize len)
+{
+    ssize   rc;
+
+    while (len > 0) {
+        if ((rc = write(fd, buf, len)) <= 0) {
+            return -1;
+        }
+        buf += rc;
+        len -= rc;
+    }
+    return 0;
+}
+
+
+/*
+    Read one response and return the total bytes received, or -1 on errors. Responses have a Content-Length.
+ */
+static MprOff readResponse(int fd)
+{
+    char    buf[64 * 1024], *end, *cp;
+    MprOff  need, total;
+    ssize   len, nbytes;
+
+    for (len = 0, need = -1, total = 0; need < 0 || total < need; total += nbytes) {
+        if (need < 0) {
+            if ((nbytes = read(fd, &buf[len], sizeof(buf) - len - 1)) <= 0) {
+                return -1;
+            }
+            len += nbytes;
+            buf[len] = '\0';
+            if ((end = strstr(buf, "\r\n\r\n")) != 0) {
+                if (strncmp(buf, "HTTP/1.1 206", 12) != 0 || (cp = strstr(buf, "Content-Length:")) == 0 || cp > end) {
+                    fprintf(stderr, "Bad response: %.*s\n", (int) (end - buf), buf);
+                    return -1;
+                }
+                need = (end - buf) + 4 + stoi(&cp[15]);
+            }
+        } else if ((nbytes = read(fd, buf, sizeof(buf))) <= 0) {
+            return -1;
+        }
+    }
+    return total;
+}
+
+
+static void runTest(Bench *bench, int mode, int ranges)
+{
+    char        request[1024];
+    MprOff      pos, wire;
+    double      start, secs;
+    ssize       len;
+    int         fd, i, r;
+
+    /* Without a registered file handler, the pipeline uses the net connector */
+    http->fileHandler = (mode == MODE_SENDFILE) ? fileHandler : 0;
+    if ((fd = connectServer()) < 0) {
+        fprintf(stderr, "Cannot connect to server\n");
+        return;
+    }
+    srand(1);
+    wire = 0;
+    start = now();
+    for (i = 0; i < bench->requests; i++) {
+        len = snprintf(request, sizeof(request), "GET /%s HTTP/1.1\r\nHost: localhost\r\nRange: bytes=", BENCH_FILE);
+        for (r = 0, pos = 0; r < ranges; r++) {
+            /* Ascending non-overlapping ranges at random offsets */
+            pos += ((MprOff) rand() % ((bench->size / ranges) - bench->rangeSize)) / 2;
+            len += snprintf(&request[len], sizeof(request) - len, "%s%Ld-%Ld", r ? "," : "", pos, 
+                pos + bench->rangeSize - 1);
+            pos += bench->rangeSize;
+        }
+        len += snprintf(&request[len], sizeof(request) - len, "\r\n\r\n");
+        if (writeAll(fd, request, len) < 0 || (len = (ssize) readResponse(fd)) < 0) {
+            fprintf(stderr, "Request failed\n");
+            break;
+        }
+        wire += len;
+    }
+    secs = now() - start;
+    close(fd);
+    printf("%-10s %8d %10d %10d %12.0f %12.1f\n", modeNames[mode], ranges, bench->rangeSize / 1024, i, i / secs,
+        wire / secs / (1024 * 1024));
+}
+
+
+static void *runBench(void *data)
+{
+    Bench   *bench;
+    int     mode, ranges;
+
+    bench = (Bench*) data;
+    printf("%-10s %8s %10s %10s %12s %12s\n", "Mode", "Ranges", "Range KB", "Requests", "Requests/s", "MB/s");
+    for (ranges = 1; ranges <= 4; ranges += 3) {
+        for (mode = MODE_READ; mode <= MODE_SENDFILE; mode++) {
+            runTest(bench, mode, ranges);
+        }
+    }
+    unlink(BENCH_FILE);
+    exit(0);
+    return 0;
+}
+
+
+static int createFile(MprOff size)
+{
+    char    buf[64 * 1024];
+    MprOff  pos;
+    int     fd, i;
+
+    for (i = 0; i < (int) sizeof(buf); i++) {
+        buf[i] = (char) (rand() >> 8);
+    }
+    if ((fd = open(BENCH_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+        return -1;
+    }
+    for (pos = 0; pos < size; pos += sizeof(buf)) {
+        if (write(fd, buf, sizeof(buf)) != sizeof(buf)) {
+            close(fd);
+            return -1;
+        }
+    }
+    close(fd);
+    return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+    HttpEndpoint    *endpoint;
+    HttpRoute       *route;
+    HttpLimits      *limits;
+    pthread_t       tid;
+    Bench           bench;
+
+    bench.size = (MprOff) ((argc > 1) ? atoi(argv[1]) : 256) * 1024 * 1024;
+    bench.requests = (argc > 2) ? atoi(argv[2]) : 2000;
+    bench.rangeSize = ((argc > 3) ? atoi(argv[3]) : 1024) * 1024;
+    if (bench.size <= 0 || bench.requests <= 0 || bench.rangeSize <= 0 || bench.rangeSize * 8 > bench.size) {
+        fprintf(stderr, "Usage: benchRange [megabytes [requests [rangeKilobytes]]]\n");
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    if (createFile(bench.size) < 0) {
+        fprintf(stderr, "Cannot create %s\n", BENCH_FILE);
+        return 1;
+    }
+    mprCreate(argc, argv, MPR_USER_EVENTS_THREAD);
+    mprStart();
+    http = httpCreate(HTTP_SERVER_SIDE);
+    fileHandler = httpCreateHandler(http, "fileHandler", NULL);
+    fileHandler->rewrite = rewriteFile;
+    fileHandler->start = startFile;
+
+    if ((endpoint = httpCreateConfiguredEndpoint(".", ".", "127.0.0.1", BENCH_PORT)) == 0) {
+        fprintf(stderr, "Cannot create endpoint\n");
+        return 1;
+    }
+    route = httpGetHostDefaultRoute(mprGetFirstItem(endpoint->hosts));
+    httpAddRouteFilter(route, "rangeFilter", NULL, HTTP_STAGE_TX);
+    httpAddRouteFilter(route, "chunkFilter", NULL, HTTP_STAGE_RX | HTTP_STAGE_TX);
+    httpSetRouteHandler(route, "fileHandler");
+
+    limits = httpGraduateLimits(route, NULL);
+    limits->keepAliveMax = MAXINT;
+    limits->transmissionBodySize = MAXINT64;
+    if (httpStartEndpoint(endpoint) < 0) {
+        fprintf(stderr, "Cannot start endpoint\n");
+        return 1;
+    }
+    pthread_create(&tid, NULL, runBench, &bench);
+    mprServiceEvents(-1, 0);
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
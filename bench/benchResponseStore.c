@@ -0,0 +1,347 @@
+/**
+    benchResponseStore.c - Measure the persistent response store against the in-memory response cache
+
+    Cached responses are written to a persistent response store which is then reopened as it would be after a server
+    restart. Before timing, the reopened store is checked to hold the same responses and to honor expiry times and
+    removals. Damaged index entries and records are checked to be ignored, and responses are checked to survive
+    compaction.
+
+        load        Open a store holding the responses as at server startup
+        cache       Read responses from an MprCache as the in-memory response cache does
+        store       Read responses from the persistent store
+        write       Write responses to the persistent store
+
+    Build from the repository top directory after building the libraries:
+
+        gcc -O2 -o benchResponseStore bench/benchResponseStore.c -Ilinux-x64-default/inc -Llinux-x64-default/bin \
+            -lhttp -lmpr -lpcre -lpthread -lm -ldl -Wl,-rpath,linux-x64-default/bin
+
+    Usage: benchResponseStore [responses [iterations]]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "http.h"
+
+/*********************************** Locals ***********************************/
+
+#define LIFESPAN    (60 * 60 * 1000)
+#define BODY_SIZE   4096
+#define MAX_SIZE    ((MprOff) 256 * 1024 * 1024)
+
+static char     *path;
+static char     **keys;
+static char     *content;
+static ssize    contentLength;
+
+/************************************* Code ***********************************/
+
+static double now()
+{
+    struct timeval  tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+static void removeStore(cchar *file)
+{
+    unlink(file);
+    unlink(sjoin(file, ".index", NULL));
+}
+
+
+/*
+    Create a response with headers as saved by the cache filter and a body unique to the key
+ */
+static char *createContent(cchar *key, ssize *len)
+{
+    MprBuf      *buf;
+    int         i;
+
+    buf = mprCreateBuf(BODY_SIZE + 256, 0);
+    mprPutToBuf(buf, "X-Status: 200\nContent-Type: text/html\nX-Key: %s\n\n", key);
+    for (i = 0; mprGetBufLength(buf) < BODY_SIZE; i++) {
+        mprPutToBuf(buf, "<p>%s line %d</p>\n", key, i);
+    }
+    *len = mprGetBufLength(buf);
+    return mprMemdup(mprGetBufStart(buf), *len);
+}
+
+
+/*
+    Check a response matches the content including the body in the data file as sent by sendfile
+ */
+static int matchResponse(HttpCachedResponse *response, cchar *data, ssize len)
+{
+    char        *body;
+    ssize       headerLen;
+
+    if (!response) {
+        return 0;
+    }
+    headerLen = slen(response->headers);
+    if (headerLen + response->length != len || memcmp(response->headers, data, headerLen) != 0 ||
+            memcmp(response->body, &data[headerLen], response->length) != 0) {
+        return 0;
+    }
+    body = mprAlloc(response->length + 1);
+    if (pread(response->file->fd, body, response->length, response->pos) != response->length ||
+            memcmp(body, &data[headerLen], response->length) != 0) {
+        return 0;
+    }
+    return 1;
+}
+
+
+static int verify(int count)
+{
+    HttpResponseStore   *store;
+    HttpCachedResponse  *response;
+    MprFile             *file;
+    MprTime             modified;
+    char                *data, *key, junk[20];
+    ssize               len;
+    int                 errors, i;
+
+    errors = 0;
+    removeStore(path);
+    if ((store = httpOpenResponseStore(path, MAX_SIZE)) == 0) {
+        printf("Cannot create the response store %s\n", path);
+        return 1;
+    }
+    modified = mprGetTime() / MPR_TICKS_PER_SEC * MPR_TICKS_PER_SEC;
+    for (i = 0; i < count; i++) {
+        data = createContent(keys[i], &len);
+        if (httpWriteResponseStore(store, keys[i], data, len, modified, LIFESPAN) < 0) {
+            errors++;
+        }
+    }
+    httpWriteResponseStore(store, "short", "X-Status: 200\n\nshort", 20, modified, 1);
+    httpWriteResponseStore(store, "removed", "removed", 7, modified, LIFESPAN);
+    httpWriteResponseStore(store, "plain", "no headers", 10, modified, LIFESPAN);
+    httpRemoveResponseStore(store, "removed");
+    /* A superseded response */
+    data = createContent(keys[0], &len);
+    httpWriteResponseStore(store, keys[0], "X-Status: 200\n\nold", 18, modified, LIFESPAN);
+    httpWriteResponseStore(store, keys[0], data, len, modified, LIFESPAN);
+    mprSleep(5);
+
+    /* Reopen the store as after a restart */
+    store = httpOpenResponseStore(path, MAX_SIZE);
+    mprAddRoot(store);
+    for (i = 0; i < count; i++) {
+        data = createContent(keys[i], &len);
+        response = httpReadResponseStore(store, keys[i]);
+        if (!matchResponse(response, data, len) || response->modified != modified) {
+            errors++;
+        }
+    }
+    if (httpReadResponseStore(store, "short") || httpReadResponseStore(store, "removed")) {
+        errors++;
+    }
+    if ((response = httpReadResponseStore(store, "plain")) == 0 || *response->headers || response->length != 10) {
+        errors++;
+    }
+    /* A partially written index entry is ignored */
+    file = mprOpenFile(sjoin(path, ".index", NULL), O_WRONLY | O_APPEND, 0);
+    memset(junk, 0x5a, sizeof(junk));
+    mprWriteFile(file, junk, sizeof(junk));
+    mprCloseFile(file);
+    store = httpOpenResponseStore(path, MAX_SIZE);
+    mprAddRoot(store);
+    if (!httpReadResponseStore(store, keys[count - 1]) || httpWriteResponseStore(store, "after", "after", 5,
+            modified, LIFESPAN) < 0) {
+        errors++;
+    }
+    store = httpOpenResponseStore(path, MAX_SIZE);
+    mprAddRoot(store);
+    if (!httpReadResponseStore(store, "after") || !httpReadResponseStore(store, keys[count - 1])) {
+        errors++;
+    }
+    /* A damaged record is discarded when read */
+    response = httpReadResponseStore(store, keys[1]);
+    if (pwrite(response->file->fd, "X", 1, response->pos + 10) != 1) {
+        errors++;
+    }
+    store = httpOpenResponseStore(path, MAX_SIZE);
+    mprAddRoot(store);
+    if (httpReadResponseStore(store, keys[1]) || !httpReadResponseStore(store, keys[2])) {
+        errors++;
+    }
+    /* Responses survive compaction of a small store */
+    removeStore(path);
+    store = httpOpenResponseStore(path, 64 * 1024);
+    mprAddRoot(store);
+    for (i = 0; i < 200; i++) {
+        key = keys[i % 4];
+        data = createContent(key, &len);
+        if (httpWriteResponseStore(store, key, data, len, modified, LIFESPAN) < 0) {
+            errors++;
+            break;
+        }
+    }
+    store = httpOpenResponseStore(path, 64 * 1024);
+    mprAddRoot(store);
+    for (i = 0; i < 4; i++) {
+        data = createContent(keys[i], &len);
+        if (!matchResponse(httpReadResponseStore(store, keys[i]), data, len)) {
+            errors++;
+        }
+    }
+    /* A store full of current responses rejects writes */
+    for (i = 4; i < 40; i++) {
+        data = createContent(keys[i], &len);
+        httpWriteResponseStore(store, keys[i], data, len, modified, LIFESPAN);
+    }
+    if (httpWriteResponseStore(store, "full", data, len, modified, LIFESPAN) != MPR_ERR_WONT_FIT) {
+        errors++;
+    }
+    removeStore(path);
+    return errors;
+}
+
+
+static void bench(cchar *name, int count, int iterations)
+{
+    HttpResponseStore   *store;
+    HttpCachedResponse  *response;
+    MprCache            *cache;
+    cchar               *data;
+    double              start, elapsed;
+    int                 i, found;
+
+    found = 0;
+    store = 0;
+    cache = 0;
+    if (smatch(name, "cache")) {
+        cache = mprCreateCache(0);
+        mprAddRoot(cache);
+        for (i = 0; i < count; i++) {
+            mprWriteCache(cache, keys[i], content, 0, LIFESPAN, 0, 0);
+        }
+    } else if (smatch(name, "store") || smatch(name, "load")) {
+        store = httpOpenResponseStore(path, MAX_SIZE);
+        mprAddRoot(store);
+        for (i = 0; i < count; i++) {
+            httpWriteResponseStore(store, keys[i], content, contentLength, 0, LIFESPAN);
+        }
+        if (smatch(name, "load")) {
+            mprRemoveRoot(store);
+        }
+    } else {
+        removeStore(path);
+        store = httpOpenResponseStore(path, MAX_SIZE);
+        mprAddRoot(store);
+    }
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        if (smatch(name, "load")) {
+            if ((store = httpOpenResponseStore(path, MAX_SIZE)) != 0 && mprGetHashLength(store->index) == count) {
+                found++;
+            }
+            mprYield(0);
+            continue;
+        } else if (cache) {
+            data = mprReadCache(cache, keys[i % count], 0, 0);
+            found += data && strstr(data, "\n\n") != 0;
+        } else if (smatch(name, "store")) {
+            response = httpReadResponseStore(store, keys[i % count]);
+            found += response && response->length > 0;
+        } else {
+            found += httpWriteResponseStore(store, keys[i % count], content, contentLength, 0, LIFESPAN) == 0;
+        }
+        if ((i % 1000) == 0) {
+            mprYield(0);
+        }
+    }
+    elapsed = now() - start;
+    printf("%-8s %10d %12.2f %14.0f\n", name, count, elapsed * 1e6 / iterations, iterations / elapsed);
+    if (found != iterations) {
+        printf("Unexpected result count %d\n", found);
+    }
+    if (cache) {
+        mprRemoveRoot(cache);
+    } else if (store && !smatch(name, "load")) {
+        mprRemoveRoot(store);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    int     count, iterations, errors, i;
+
+    count = (argc > 1) ? atoi(argv[1]) : 10000;
+    iterations = (argc > 2) ? atoi(argv[2]) : 200000;
+    if (count < 100) {
+        count = 10000;
+    }
+    if (iterations <= 0) {
+        iterations = 200000;
+    }
+    mprCreate(argc, argv, 0);
+    mprStart();
+    httpCreate(HTTP_SERVER_SIDE);
+    path = sfmt("/tmp/benchResponseStore-%d.data", getpid());
+    mprAddRoot(path);
+    keys = mprAlloc(count * sizeof(char*));
+    mprAddRoot(keys);
+    for (i = 0; i < count; i++) {
+        keys[i] = sfmt("http::response-/page/%d", i);
+        mprHold(keys[i]);
+    }
+    if ((errors = verify(min(count, 1000))) != 0) {
+        printf("Response store verification failed with %d errors\n", errors);
+        return 1;
+    }
+    content = createContent("page", &contentLength);
+    mprAddRoot(content);
+
+    printf("%-8s %10s %12s %14s\n", "Test", "Responses", "usec/op", "ops/sec");
+    bench("write", count, count);
+    bench("load", count, 10);
+    bench("cache", count, iterations);
+    bench("store", count, iterations);
+    removeStore(path);
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
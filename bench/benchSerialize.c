@@ -0,0 +1,300 @@
+/**
+    benchSerialize.c - Measure session serialization with mprSerialize and mprSerializeInto
+
+    Models httpWriteSession for a typical session of user details, a security token and a shopping cart. Each
+    iteration serializes the session and writes it to a cache. Before timing, the output of mprSerialize and
+    mprSerializeInto is checked against the previous serializer for a set of objects and all flags.
+
+        previous    The previous serializer that appends each character to a growing buffer
+        serialize   mprSerialize which allocates a buffer sized for the estimated length
+        into        mprSerializeInto a buffer that is reused for each write
+
+    Build from the repository top directory after building the libraries:
+
+        gcc -O2 -o benchSerialize bench/benchSerialize.c -Ilinux-x64-default/inc -Llinux-x64-default/bin -lhttp -lmpr \
+            -lpcre -lpthread -lm -ldl -Wl,-rpath,linux-x64-default/bin
+
+    Usage: benchSerialize [cartItems [iterations]]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "http.h"
+
+/*********************************** Locals ***********************************/
+
+static cchar *documents[] = {
+    "{}",
+    "{a:'1'}",
+    "{name:'x',list:[{id:'1'},{id:'2',tags:['a','b']}],empty:'',nested:{a:{b:{c:[[],{}]}}}}",
+    "{path:'C:\\\\temp',quote:'it\\'s',long:'0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghij\\'klmnop'}",
+    0
+};
+
+/************************************* Code ***********************************/
+
+static double now()
+{
+    struct timeval  tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+static void quoteValue(MprBuf *buf, cchar *str)
+{
+    cchar   *cp;
+
+    mprPutCharToBuf(buf, '"');
+    for (cp = str; *cp; cp++) {
+        if (*cp == '\'') {
+            mprPutCharToBuf(buf, '\\');
+        }
+        mprPutCharToBuf(buf, *cp);
+    }
+    mprPutCharToBuf(buf, '"');
+}
+
+
+/*
+    The previous serializer
+ */
+static cchar *objToString(MprBuf *buf, MprObj *obj, int type, int flags)
+{
+    MprKey  *kp;
+    char    numbuf[32];
+    int     i, len, quotes, pretty;
+
+    pretty = flags & MPR_JSON_PRETTY;
+    quotes = flags & MPR_JSON_QUOTES;
+
+    if (type == MPR_JSON_ARRAY) {
+        mprPutCharToBuf(buf, '[');
+        if (pretty) mprPutCharToBuf(buf, '\n');
+        len = mprGetHashLength(obj);
+        for (i = 0; i < len; i++) {
+            itosbuf(numbuf, sizeof(numbuf), i, 10);
+            if (pretty) mprPutStringToBuf(buf, "    ");
+            if ((kp = mprLookupKeyEntry(obj, numbuf)) == 0) {
+                continue;
+            }
+            if (kp->type == MPR_JSON_ARRAY || kp->type == MPR_JSON_OBJ) {
+                objToString(buf, (MprObj*) kp->data, kp->type, flags);
+            } else {
+                quoteValue(buf, kp->data);
+            }
+            if ((i+1) < len) {
+                mprPutCharToBuf(buf, ',');
+            }
+            if (pretty) mprPutCharToBuf(buf, '\n');
+        }
+        mprPutCharToBuf(buf, ']');
+
+    } else if (type == MPR_JSON_OBJ) {
+        mprPutCharToBuf(buf, '{');
+        if (pretty) mprPutCharToBuf(buf, '\n');
+        for (kp = mprGetFirstKey(obj); kp; ) {
+            if (pretty) mprPutStringToBuf(buf, "    ");
+            if (quotes) mprPutCharToBuf(buf, '"');
+            mprPutStringToBuf(buf, kp->key);
+            if (quotes) mprPutCharToBuf(buf, '"');
+            if (pretty) {
+                mprPutStringToBuf(buf, ": ");
+            } else {
+                mprPutCharToBuf(buf, ':');
+            }
+            if (kp->type == MPR_JSON_ARRAY || kp->type == MPR_JSON_OBJ) {
+                objToString(buf, (MprObj*) kp->data, kp->type, flags);
+            } else {
+                quoteValue(buf, kp->data);
+            }
+            kp = mprGetNextKey(obj, kp);
+            if (kp) {
+                mprPutCharToBuf(buf, ',');
+            }
+            if (pretty) mprPutCharToBuf(buf, '\n');
+        }
+        mprPutCharToBuf(buf, '}');
+    }
+    if (pretty) mprPutCharToBuf(buf, '\n');
+    return sclone(mprGetBufStart(buf));
+}
+
+
+static cchar *previousSerialize(MprObj *obj, int flags)
+{
+    MprBuf  *buf;
+
+    buf = mprCreateBuf(0, 0);
+    objToString(buf, obj, MPR_JSON_OBJ, flags);
+    return mprGetBuf(buf);
+}
+
+
+/*
+    Create session state with user details, a security token and a cart of items
+ */
+static MprHash *createSession(int items)
+{
+    MprHash     *session, *cart, *item;
+    MprKey      *kp;
+    char        key[32];
+    int         i;
+
+    session = mprCreateHash(0, 0);
+    mprAddKey(session, HTTP_SESSION_USERNAME, sclone("joshua"));
+    mprAddKey(session, "role", sclone("administrator"));
+    mprAddKey(session, "XSRF-TOKEN", sclone("5e0f3c3a4f9d4b7e8a1c2d3e4f5a6b7c"));
+    mprAddKey(session, "lastPage", sclone("/store/catalog/garden-furniture?page=3&sort=price"));
+    cart = mprCreateHash(0, MPR_HASH_LIST);
+    for (i = 0; i < items; i++) {
+        item = mprCreateHash(0, 0);
+        mprAddKey(item, "sku", sfmt("SKU-%06d", i * 7919));
+        mprAddKey(item, "name", sfmt("Teak outdoor chair model %d, weather resistant finish", i));
+        mprAddKey(item, "quantity", itos(i % 5 + 1));
+        mprAddKey(item, "price", sfmt("%d.99", 20 + i));
+        itosbuf(key, sizeof(key), i, 10);
+        if ((kp = mprAddKey(cart, key, item)) != 0) {
+            kp->type = MPR_JSON_OBJ;
+        }
+    }
+    if ((kp = mprAddKey(session, "cart", cart)) != 0) {
+        kp->type = MPR_JSON_ARRAY;
+    }
+    return session;
+}
+
+
+static int verify(MprHash *session)
+{
+    MprBuf      *buf;
+    MprObj      *obj;
+    cchar       *expected;
+    int         i, flags, errors;
+
+    errors = 0;
+    buf = mprCreateBuf(0, 0);
+    for (i = 0; documents[i]; i++) {
+        obj = mprDeserialize(documents[i]);
+        for (flags = 0; flags <= (MPR_JSON_PRETTY | MPR_JSON_QUOTES); flags++) {
+            expected = previousSerialize(obj, flags);
+            mprPutStringToBuf(buf, "prefix");
+            if (!smatch(mprSerialize(obj, flags), expected) || mprSerializeInto(obj, buf, flags) != slen(expected) ||
+                    !smatch(mprGetBufStart(buf), sjoin("prefix", expected, NULL))) {
+                printf("Mismatch for document %d, flags %d\n    %s\n    %s\n", i, flags, expected, mprSerialize(obj, flags));
+                errors++;
+            }
+            mprFlushBuf(buf);
+        }
+    }
+    if (!smatch(mprSerialize(session, 0), previousSerialize(session, 0))) {
+        printf("Session mismatch\n");
+        errors++;
+    }
+    return errors;
+}
+
+
+static void bench(MprCache *cache, MprHash *session, cchar *name, int iterations)
+{
+    MprBuf      *buf;
+    cchar       *data;
+    double      start, elapsed;
+    ssize       len;
+    int         i;
+
+    buf = mprCreateBuf(0, 0);
+    mprAddRoot(buf);
+    len = 0;
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        if (smatch(name, "previous")) {
+            data = previousSerialize(session, 0);
+        } else if (smatch(name, "serialize")) {
+            data = mprSerialize(session, 0);
+        } else {
+            mprFlushBuf(buf);
+            mprSerializeInto(session, buf, 0);
+            data = mprGetBufStart(buf);
+        }
+        len = mprWriteCache(cache, "session", data, 0, MPR_TICKS_PER_SEC, 0, MPR_CACHE_SET);
+        if ((i % 100) == 0) {
+            mprYield(0);
+        }
+    }
+    elapsed = now() - start;
+    mprRemoveRoot(buf);
+    printf("%-10s %8d %12.2f %12.1f\n", name, (int) len, elapsed * 1e6 / iterations, len * iterations / elapsed / 1e6);
+}
+
+
+int main(int argc, char **argv)
+{
+    MprCache    *cache;
+    MprHash     *session;
+    int         items, iterations, errors;
+
+    items = (argc > 1) ? atoi(argv[1]) : 10;
+    iterations = (argc > 2) ? atoi(argv[2]) : 100000;
+    if (items < 0) {
+        items = 10;
+    }
+    if (iterations <= 0) {
+        iterations = 100000;
+    }
+    mprCreate(argc, argv, 0);
+    mprStart();
+    cache = mprCreateCache(0);
+    mprAddRoot(cache);
+    session = createSession(items);
+    mprAddRoot(session);
+
+    if ((errors = verify(session)) != 0) {
+        printf("Serialize verification failed with %d errors\n", errors);
+        return 1;
+    }
+    printf("%-10s %8s %12s %12s\n", "Serialize", "Bytes", "usec/write", "MB/sec");
+    bench(cache, session, "previous", iterations);
+    bench(cache, session, "serialize", iterations);
+    bench(cache, session, "into", iterations);
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
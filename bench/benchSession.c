@@ -0,0 +1,291 @@
+/**
+    benchSession.c - Measure the session stores against the previous JSON session cache
+
+    Models requests that read a session and write it back. The cache variant is the previous implementation that
+    serializes the session to JSON in an MprCache and deserializes it for each request. Before timing, sessions are
+    written through one shared store and read through a second store on the same file to check the binary encoding
+    and versioning as another server process would see them.
+
+        cache       Serialize to JSON in an MprCache and deserialize on each read
+        memory      Memory store retaining the decoded session objects
+        shared      Shared store where reads find the decoded session in the local copy
+        decode      Shared store where each read decodes the session written by another store
+
+    Build from the repository top directory after building the libraries:
+
+        gcc -O2 -o benchSession bench/benchSession.c -Ilinux-x64-default/inc -Llinux-x64-default/bin -lhttp -lmpr \
+            -lpcre -lpthread -lm -ldl -Wl,-rpath,linux-x64-default/bin
+
+    Usage: benchSession [sessions [iterations]]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "http.h"
+
+/*********************************** Locals ***********************************/
+
+#define LIFESPAN    (60 * 1000)
+#define MAX_SIZE    2048
+
+static cchar *document =
+    "{\"user\":\"admin\",\"role\":\"administrator\",\"csrf\":\"b6a7c1d2e3f4a5b6c7d8e9f0a1b2c3d4\","
+    "\"profile\":{\"name\":\"Example User\",\"email\":\"user@example.com\",\"locale\":\"en-US\"},"
+    "\"cart\":[{\"sku\":\"A100\",\"qty\":\"2\"},{\"sku\":\"B200\",\"qty\":\"1\"}],\"visits\":\"17\",\"empty\":\"\"}";
+
+static char     *path;
+static char     **ids;
+
+/************************************* Code ***********************************/
+
+static double now()
+{
+    struct timeval  tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+static HttpSessionStore *createShared(int sessions)
+{
+    return httpCreateSharedSessionStore(path, sessions, MAX_SIZE);
+}
+
+
+/*
+    Compare session data regardless of the order of keys
+ */
+static int sameData(MprHash *a, MprHash *b)
+{
+    MprKey      *kp, *other;
+
+    if (mprGetHashLength(a) != mprGetHashLength(b)) {
+        return 0;
+    }
+    for (ITERATE_KEYS(a, kp)) {
+        if ((other = mprLookupKeyEntry(b, kp->key)) == 0 || other->type != kp->type) {
+            return 0;
+        }
+        if (kp->type == MPR_JSON_STRING) {
+            if (!smatch(kp->data, other->data)) {
+                return 0;
+            }
+        } else if (!sameData((MprHash*) kp->data, (MprHash*) other->data)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+static int verify(int sessions)
+{
+    HttpSessionStore    *writer, *reader;
+    MprHash             *data, *result;
+    char                *big;
+    int64               version, readVersion, prior;
+    int                 errors, i;
+
+    writer = createShared(sessions);
+    reader = createShared(sessions);
+    if (!writer || !reader) {
+        printf("Cannot create the shared store %s\n", path);
+        return 1;
+    }
+    mprAddRoot(writer);
+    mprAddRoot(reader);
+    errors = 0;
+    data = mprDeserialize(document);
+
+    /* Write through one store and read through another */
+    version = 0;
+    if (writer->write(writer, "one", data, LIFESPAN, &version) < 0) {
+        errors++;
+    }
+    if ((result = reader->read(reader, "one", &readVersion)) == 0 || readVersion != version ||
+            !sameData(result, data)) {
+        errors++;
+    }
+    /* An update is seen by the other store with a new version */
+    prior = version;
+    mprAddKey(data, "visits", sclone("18"));
+    writer->write(writer, "one", data, LIFESPAN, &version);
+    if (version <= prior || (result = reader->read(reader, "one", &readVersion)) == 0 || readVersion != version ||
+            !smatch(mprLookupKey(result, "visits"), "18")) {
+        errors++;
+    }
+    /* Removal is seen by the other store */
+    reader->remove(reader, "one");
+    if (writer->read(writer, "one", &version) != 0 || reader->count(reader) != 0) {
+        errors++;
+    }
+    /* Sessions that are too large are rejected */
+    big = mprAlloc(MAX_SIZE + 1);
+    memset(big, 'x', MAX_SIZE);
+    big[MAX_SIZE] = '\0';
+    data = mprCreateHash(0, 0);
+    mprAddKey(data, "big", big);
+    version = 0;
+    if (writer->write(writer, "big", data, LIFESPAN, &version) != MPR_ERR_WONT_FIT) {
+        errors++;
+    }
+    /* Expired sessions are not returned */
+    mprAddKey(data, "big", sclone("small"));
+    version = 0;
+    writer->write(writer, "short", data, 1, &version);
+    mprSleep(5);
+    if (reader->read(reader, "short", &version) != 0) {
+        errors++;
+    }
+    for (i = 0; i < sessions; i++) {
+        writer->remove(writer, ids[i]);
+    }
+    mprRemoveRoot(reader);
+    mprRemoveRoot(writer);
+    return errors;
+}
+
+
+static void bench(cchar *name, int sessions, int iterations)
+{
+    HttpSessionStore    *store, *reader;
+    MprCache            *cache;
+    MprHash             *data;
+    cchar               *json, *id;
+    double              start, elapsed;
+    int64               version;
+    int                 i, found;
+
+    store = reader = 0;
+    cache = 0;
+    if (smatch(name, "cache")) {
+        cache = mprCreateCache(0);
+        mprAddRoot(cache);
+    } else if (smatch(name, "memory")) {
+        store = reader = httpCreateMemorySessionStore(0);
+    } else {
+        store = createShared(sessions);
+        reader = smatch(name, "decode") ? createShared(sessions) : store;
+    }
+    if (store) {
+        mprAddRoot(store);
+        mprAddRoot(reader);
+    }
+    data = mprDeserialize(document);
+    for (i = 0; i < sessions; i++) {
+        if (cache) {
+            mprWriteCache(cache, ids[i], mprSerialize(data, 0), 0, LIFESPAN, 0, MPR_CACHE_SET);
+        } else {
+            version = 0;
+            store->write(store, ids[i], data, LIFESPAN, &version);
+        }
+    }
+    found = 0;
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        id = ids[i % sessions];
+        if (cache) {
+            if ((json = mprReadCache(cache, id, 0, 0)) != 0 && (data = mprDeserialize(json)) != 0) {
+                found++;
+                mprWriteCache(cache, id, mprSerialize(data, 0), 0, LIFESPAN, 0, MPR_CACHE_SET);
+            }
+        } else if ((data = reader->read(reader, id, &version)) != 0) {
+            found++;
+            store->write(store, id, data, LIFESPAN, &version);
+        }
+        if ((i % 1000) == 0) {
+            mprYield(0);
+        }
+    }
+    elapsed = now() - start;
+    printf("%-8s %10d %12.2f %14.0f\n", name, sessions, elapsed * 1e6 / iterations, iterations / elapsed);
+    if (found != iterations) {
+        printf("Unexpected session count %d\n", found);
+    }
+    if (cache) {
+        mprRemoveRoot(cache);
+    } else {
+        for (i = 0; i < sessions; i++) {
+            store->remove(store, ids[i]);
+        }
+        mprRemoveRoot(store);
+        mprRemoveRoot(reader);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    int     sessions, iterations, errors, i;
+
+    sessions = (argc > 1) ? atoi(argv[1]) : 1000;
+    iterations = (argc > 2) ? atoi(argv[2]) : 200000;
+    if (sessions <= 0) {
+        sessions = 1000;
+    }
+    if (iterations <= 0) {
+        iterations = 200000;
+    }
+    mprCreate(argc, argv, 0);
+    mprStart();
+    httpCreate(HTTP_SERVER_SIDE);
+    path = sfmt("/tmp/benchSession-%d.shm", getpid());
+    mprAddRoot(path);
+    ids = mprAlloc(sessions * sizeof(char*));
+    mprAddRoot(ids);
+    for (i = 0; i < sessions; i++) {
+        ids[i] = mprGetMD5(sfmt("session-%d", i));
+        mprHold(ids[i]);
+    }
+    if ((errors = verify(sessions)) != 0) {
+        printf("Session store verification failed with %d errors\n", errors);
+        unlink(path);
+        return 1;
+    }
+    printf("%-8s %10s %12s %14s\n", "Store", "Sessions", "usec/req", "req/sec");
+    bench("cache", sessions, iterations);
+    bench("memory", sessions, iterations);
+    bench("shared", sessions, iterations);
+    bench("decode", sessions, iterations);
+    unlink(path);
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
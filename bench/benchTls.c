@@ -0,0 +1,266 @@
+/**
+    benchTls.c - Benchmark TLS handshake rates for full and resumed handshakes
+
+    Compares full handshakes, session ID resumption via a server session cache and stateless session ticket
+    resumption (RFC 5077) using the EST TLS stack over a local socket pair.
+
+    Build from the repository top directory after building the libraries:
+
+        gcc -O2 -o benchTls bench/benchTls.c -Ilinux-x64-default/inc -Llinux-x64-default/bin -lest -lpthread \
+            -Wl,-rpath,linux-x64-default/bin
+
+    Run from the test directory so the test certificate and key can be found:
+
+        ../benchTls [iterations]
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "est.h"
+#include    <pthread.h>
+
+/*********************************** Locals ***********************************/
+
+#define MODE_FULL       0               /* Full handshake every time */
+#define MODE_SESSION_ID 1               /* Resume via the server session cache */
+#define MODE_TICKET     2               /* Resume via session tickets */
+
+static char *modeNames[] = { "full", "session-id", "ticket" };
+
+static char *dhG = "4";
+static char *dhKey =
+    "E4004C1F94182000103D883A448B3F80"
+    "2CE4B44A83301270002C20D0321CFD00"
+    "11CCEF784C26A400F43DFB901BCA7538"
+    "F2C6B176001CF5A0FD16D2C48B1D0C1C"
+    "F6AC8E1DA6BCC3B4E1F96B0564965300"
+    "FFA1D0B601EB2800F489AA512C4B248C"
+    "01F76949A60BB7F00A40B1EAB64BDD48"
+    "E8A700D60B7F1200FA8E77B0A979DABF";
+
+typedef struct Server {
+    int             fd;
+    int             mode;
+    int             rc;
+} Server;
+
+static x509_cert        cert;
+static rsa_context      rsa;
+static ssl_ticket_keys  ticketKeys;
+static ssl_ticket_key   ticketKey;
+
+/*
+    Single entry server session cache. Sufficient as there is only one client.
+ */
+static ssl_session      cachedSession;
+static pthread_mutex_t  cacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+/***************************** Forward Declarations ***************************/
+
+static double elapsed(struct timeval *start);
+static int getSession(ssl_context *ssl);
+static int setSession(ssl_context *ssl);
+
+/************************************* Code ***********************************/
+
+static int getSession(ssl_context *ssl)
+{
+    int     rc;
+
+    rc = 1;
+    pthread_mutex_lock(&cacheLock);
+    if (ssl->resume && cachedSession.length == ssl->session->length &&
+            memcmp(cachedSession.id, ssl->session->id, cachedSession.length) == 0 &&
+            cachedSession.cipher == ssl->session->cipher) {
+        memcpy(ssl->session->master, cachedSession.master, sizeof(cachedSession.master));
+        rc = 0;
+    }
+    pthread_mutex_unlock(&cacheLock);
+    return rc;
+}
+
+
+static int setSession(ssl_context *ssl)
+{
+    pthread_mutex_lock(&cacheLock);
+    cachedSession = *ssl->session;
+    cachedSession.next = 0;
+    pthread_mutex_unlock(&cacheLock);
+    return 0;
+}
+
+
+static void *serve(void *data)
+{
+    Server          *server;
+    ssl_context     ctx;
+    ssl_session     session;
+    havege_state    hs;
+
+    server = (Server*) data;
+    memset(&session, 0, sizeof(session));
+    havege_init(&hs);
+    ssl_init(&ctx);
+    ssl_set_endpoint(&ctx, SSL_IS_SERVER);
+    ssl_set_authmode(&ctx, SSL_VERIFY_NO_CHECK);
+    ssl_set_rng(&ctx, havege_rand, &hs);
+    ssl_set_bio(&ctx, net_recv, &server->fd, net_send, &server->fd);
+    ssl_set_ciphers(&ctx, ssl_default_ciphers);
+    ssl_set_session(&ctx, 1, 0, &session);
+    if (server->mode == MODE_SESSION_ID) {
+        ssl_set_scb(&ctx, getSession, setSession);
+    }
+    ssl_set_tickets(&ctx, server->mode == MODE_TICKET);
+    ssl_set_ticket_keys(&ctx, &ticketKeys);
+    ssl_set_own_cert(&ctx, &cert, &rsa);
+    ssl_set_dh_param(&ctx, dhKey, dhG);
+    server->rc = ssl_handshake(&ctx);
+    ssl_close_notify(&ctx);
+    ssl_free(&ctx);
+    return 0;
+}
+
+
+/*
+    Run one handshake. The client session is retained across calls so later handshakes may resume.
+ */
+static int handshake(int mode, ssl_session *session, int *resumed)
+{
+    ssl_context     ctx;
+    havege_state    hs;
+    pthread_t       tid;
+    Server          server;
+    uchar           id[sizeof(session->id)];
+    int             fds[2], rc, idLen, ticketLen;
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        return -1;
+    }
+    server.fd = fds[1];
+    server.mode = mode;
+    server.rc = 0;
+    pthread_create(&tid, NULL, serve, &server);
+
+    if (mode == MODE_FULL) {
+        memset(session, 0, sizeof(ssl_session));
+    }
+    idLen = session->length;
+    ticketLen = session->ticket_len;
+    memcpy(id, session->id, sizeof(id));
+
+    havege_init(&hs);
+    ssl_init(&ctx);
+    ssl_set_endpoint(&ctx, SSL_IS_CLIENT);
+    ssl_set_authmode(&ctx, SSL_VERIFY_NO_CHECK);
+    ssl_set_rng(&ctx, havege_rand, &hs);
+    ssl_set_bio(&ctx, net_recv, &fds[0], net_send, &fds[0]);
+    ssl_set_ciphers(&ctx, ssl_default_ciphers);
+    ssl_set_session(&ctx, 1, 0, session);
+    ssl_set_tickets(&ctx, mode == MODE_TICKET);
+    rc = ssl_handshake(&ctx);
+    ssl_close_notify(&ctx);
+
+    /*
+        A resumed handshake keeps the prior session ID, or was driven by a ticket the client already held
+     */
+    *resumed = (idLen > 0 && (ticketLen > 0 || (session->length == idLen && memcmp(id, session->id, idLen) == 0)));
+
+    pthread_join(tid, NULL);
+    ssl_free(&ctx);
+    close(fds[0]);
+    close(fds[1]);
+    if (rc != 0 || server.rc != 0) {
+        fprintf(stderr, "Handshake failed, client %d, server %d\n", rc, server.rc);
+        return -1;
+    }
+    return 0;
+}
+
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval  now;
+
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - start->tv_sec) + (now.tv_usec - start->tv_usec) / 1e6;
+}
+
+
+int main(int argc, char **argv)
+{
+    ssl_session     session;
+    struct timeval  start;
+    double          secs;
+    int             i, iterations, mode, resumed, resumptions;
+
+    iterations = (argc > 1) ? atoi(argv[1]) : 200;
+    if (iterations <= 0) {
+        iterations = 200;
+    }
+    if (x509parse_crtfile(&cert, "test.crt") != 0 || x509parse_keyfile(&rsa, "test.key", 0) != 0) {
+        fprintf(stderr, "Cannot load test.crt and test.key. Run from the test directory.\n");
+        return 1;
+    }
+    memset(&ticketKey, 0x5a, sizeof(ticketKey));
+    ticketKeys.keys = &ticketKey;
+    ticketKeys.count = 1;
+    ticketKeys.lifetime = SSL_TICKET_LIFETIME;
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("%-12s %10s %10s %12s %12s\n", "Mode", "Handshakes", "Resumed", "Seconds", "Handshakes/s");
+    for (mode = MODE_FULL; mode <= MODE_TICKET; mode++) {
+        memset(&session, 0, sizeof(session));
+        memset(&cachedSession, 0, sizeof(cachedSession));
+        resumptions = 0;
+        gettimeofday(&start, NULL);
+        for (i = 0; i < iterations; i++) {
+            if (handshake(mode, &session, &resumed) < 0) {
+                return 1;
+            }
+            resumptions += resumed;
+        }
+        secs = elapsed(&start);
+        printf("%-12s %10d %10d %12.3f %12.1f\n", modeNames[mode], iterations, resumptions, secs, iterations / secs);
+    }
+    x509_free(&cert);
+    rsa_free(&rsa);
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
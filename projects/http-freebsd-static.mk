@@ -19,6 +19,7 @@ BIT_PACK_MATRIXSSL := 0
 BIT_PACK_OPENSSL   := 0
 BIT_PACK_PCRE      := 1
 BIT_PACK_SSL       := 1
+BIT_PACK_ZLIB      := 1
 
 ifeq ($(BIT_PACK_EST),1)
     BIT_PACK_SSL := 1
@@ -52,7 +53,7 @@ BIT_PACK_SSL_PATH         := ssl
 BIT_PACK_UTEST_PATH       := utest
 
 CFLAGS             += -O2 -fPIC -w
-DFLAGS             += -D_REENTRANT -DPIC $(patsubst %,-D%,$(filter BIT_%,$(MAKEFLAGS))) -DBIT_PACK_EST=$(BIT_PACK_EST) -DBIT_PACK_MATRIXSSL=$(BIT_PACK_MATRIXSSL) -DBIT_PACK_OPENSSL=$(BIT_PACK_OPENSSL) -DBIT_PACK_PCRE=$(BIT_PACK_PCRE) -DBIT_PACK_SSL=$(BIT_PACK_SSL) 
+DFLAGS             += -D_REENTRANT -DPIC $(patsubst %,-D%,$(filter BIT_%,$(MAKEFLAGS))) -DBIT_PACK_EST=$(BIT_PACK_EST) -DBIT_PACK_MATRIXSSL=$(BIT_PACK_MATRIXSSL) -DBIT_PACK_OPENSSL=$(BIT_PACK_OPENSSL) -DBIT_PACK_PCRE=$(BIT_PACK_PCRE) -DBIT_PACK_SSL=$(BIT_PACK_SSL) -DBIT_PACK_ZLIB=$(BIT_PACK_ZLIB) 
 IFLAGS             += -I$(CONFIG)/inc
 LDFLAGS            += 
 LIBPATHS           += -L$(CONFIG)/bin
@@ -150,16 +151,23 @@ clean:
 	rm -f "$(CONFIG)/obj/mprSsl.o"
 	rm -f "$(CONFIG)/obj/makerom.o"
 	rm -f "$(CONFIG)/obj/actionHandler.o"
+	rm -f "$(CONFIG)/obj/atom.o"
 	rm -f "$(CONFIG)/obj/auth.o"
 	rm -f "$(CONFIG)/obj/basic.o"
+	rm -f "$(CONFIG)/obj/batch.o"
 	rm -f "$(CONFIG)/obj/cache.o"
 	rm -f "$(CONFIG)/obj/chunkFilter.o"
+	rm -f "$(CONFIG)/obj/compressFilter.o"
 	rm -f "$(CONFIG)/obj/client.o"
 	rm -f "$(CONFIG)/obj/conn.o"
 	rm -f "$(CONFIG)/obj/digest.o"
+	rm -f "$(CONFIG)/obj/dnsCache.o"
 	rm -f "$(CONFIG)/obj/endpoint.o"
 	rm -f "$(CONFIG)/obj/error.o"
+	rm -f "$(CONFIG)/obj/fileCache.o"
 	rm -f "$(CONFIG)/obj/host.o"
+	rm -f "$(CONFIG)/obj/hpack.o"
+	rm -f "$(CONFIG)/obj/http2.o"
 	rm -f "$(CONFIG)/obj/httpService.o"
 	rm -f "$(CONFIG)/obj/log.o"
 	rm -f "$(CONFIG)/obj/monitor.o"
@@ -174,6 +182,8 @@ clean:
 	rm -f "$(CONFIG)/obj/rx.o"
 	rm -f "$(CONFIG)/obj/sendConnector.o"
 	rm -f "$(CONFIG)/obj/session.o"
+	rm -f "$(CONFIG)/obj/sessionStore.o"
+	rm -f "$(CONFIG)/obj/responseStore.o"
 	rm -f "$(CONFIG)/obj/stage.o"
 	rm -f "$(CONFIG)/obj/trace.o"
 	rm -f "$(CONFIG)/obj/tx.o"
@@ -408,6 +418,18 @@ $(CONFIG)/obj/actionHandler.o: \
 	@echo '   [Compile] $(CONFIG)/obj/actionHandler.o'
 	$(CC) -c -o $(CONFIG)/obj/actionHandler.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/actionHandler.c
 
+#
+#   atom.o
+#
+DEPS_69 += $(CONFIG)/inc/bit.h
+DEPS_69 += src/http.h
+DEPS_69 += $(CONFIG)/inc/mpr.h
+
+$(CONFIG)/obj/atom.o: \
+    src/atom.c $(DEPS_69)
+	@echo '   [Compile] $(CONFIG)/obj/atom.o'
+	$(CC) -c -o $(CONFIG)/obj/atom.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/atom.c
+
 #
 #   auth.o
 #
@@ -430,6 +452,17 @@ $(CONFIG)/obj/basic.o: \
 	@echo '   [Compile] $(CONFIG)/obj/basic.o'
 	$(CC) -c -o $(CONFIG)/obj/basic.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/basic.c
 
+#
+#   batch.o
+#
+DEPS_65 += $(CONFIG)/inc/bit.h
+DEPS_65 += src/http.h
+
+$(CONFIG)/obj/batch.o: \
+    src/batch.c $(DEPS_65)
+	@echo '   [Compile] $(CONFIG)/obj/batch.o'
+	$(CC) -c -o $(CONFIG)/obj/batch.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/batch.c
+
 #
 #   cache.o
 #
@@ -452,6 +485,17 @@ $(CONFIG)/obj/chunkFilter.o: \
 	@echo '   [Compile] $(CONFIG)/obj/chunkFilter.o'
 	$(CC) -c -o $(CONFIG)/obj/chunkFilter.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/chunkFilter.c
 
+#
+#   compressFilter.o
+#
+DEPS_63 += $(CONFIG)/inc/bit.h
+DEPS_63 += src/http.h
+
+$(CONFIG)/obj/compressFilter.o: \
+    src/compressFilter.c $(DEPS_63)
+	@echo '   [Compile] $(CONFIG)/obj/compressFilter.o'
+	$(CC) -c -o $(CONFIG)/obj/compressFilter.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/compressFilter.c
+
 #
 #   client.o
 #
@@ -485,6 +529,17 @@ $(CONFIG)/obj/digest.o: \
 	@echo '   [Compile] $(CONFIG)/obj/digest.o'
 	$(CC) -c -o $(CONFIG)/obj/digest.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/digest.c
 
+#
+#   dnsCache.o
+#
+DEPS_66 += $(CONFIG)/inc/bit.h
+DEPS_66 += src/http.h
+
+$(CONFIG)/obj/dnsCache.o: \
+    src/dnsCache.c $(DEPS_66)
+	@echo '   [Compile] $(CONFIG)/obj/dnsCache.o'
+	$(CC) -c -o $(CONFIG)/obj/dnsCache.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/dnsCache.c
+
 #
 #   endpoint.o
 #
@@ -507,6 +562,17 @@ $(CONFIG)/obj/error.o: \
 	@echo '   [Compile] $(CONFIG)/obj/error.o'
 	$(CC) -c -o $(CONFIG)/obj/error.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/error.c
 
+#
+#   fileCache.o
+#
+DEPS_64 += $(CONFIG)/inc/bit.h
+DEPS_64 += src/http.h
+
+$(CONFIG)/obj/fileCache.o: \
+    src/fileCache.c $(DEPS_64)
+	@echo '   [Compile] $(CONFIG)/obj/fileCache.o'
+	$(CC) -c -o $(CONFIG)/obj/fileCache.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/fileCache.c
+
 #
 #   host.o
 #
@@ -518,6 +584,28 @@ $(CONFIG)/obj/host.o: \
 	@echo '   [Compile] $(CONFIG)/obj/host.o'
 	$(CC) -c -o $(CONFIG)/obj/host.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/host.c
 
+#
+#   hpack.o
+#
+DEPS_61 += $(CONFIG)/inc/bit.h
+DEPS_61 += src/http.h
+
+$(CONFIG)/obj/hpack.o: \
+    src/hpack.c $(DEPS_61)
+	@echo '   [Compile] $(CONFIG)/obj/hpack.o'
+	$(CC) -c -o $(CONFIG)/obj/hpack.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/hpack.c
+
+#
+#   http2.o
+#
+DEPS_62 += $(CONFIG)/inc/bit.h
+DEPS_62 += src/http.h
+
+$(CONFIG)/obj/http2.o: \
+    src/http2.c $(DEPS_62)
+	@echo '   [Compile] $(CONFIG)/obj/http2.o'
+	$(CC) -c -o $(CONFIG)/obj/http2.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/http2.c
+
 #
 #   httpService.o
 #
@@ -672,6 +760,28 @@ $(CONFIG)/obj/session.o: \
 	@echo '   [Compile] $(CONFIG)/obj/session.o'
 	$(CC) -c -o $(CONFIG)/obj/session.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/session.c
 
+#
+#   sessionStore.o
+#
+DEPS_67 += $(CONFIG)/inc/bit.h
+DEPS_67 += src/http.h
+
+$(CONFIG)/obj/sessionStore.o: \
+    src/sessionStore.c $(DEPS_67)
+	@echo '   [Compile] $(CONFIG)/obj/sessionStore.o'
+	$(CC) -c -o $(CONFIG)/obj/sessionStore.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/sessionStore.c
+
+#
+#   responseStore.o
+#
+DEPS_68 += $(CONFIG)/inc/bit.h
+DEPS_68 += src/http.h
+
+$(CONFIG)/obj/responseStore.o: \
+    src/responseStore.c $(DEPS_68)
+	@echo '   [Compile] $(CONFIG)/obj/responseStore.o'
+	$(CC) -c -o $(CONFIG)/obj/responseStore.o $(CFLAGS) $(DFLAGS) "$(IFLAGS)" "-Isrc" src/responseStore.c
+
 #
 #   stage.o
 #
@@ -765,16 +875,23 @@ DEPS_53 += $(CONFIG)/inc/bitos.h
 DEPS_53 += $(CONFIG)/inc/http.h
 DEPS_53 += src/http.h
 DEPS_53 += $(CONFIG)/obj/actionHandler.o
+DEPS_53 += $(CONFIG)/obj/atom.o
 DEPS_53 += $(CONFIG)/obj/auth.o
 DEPS_53 += $(CONFIG)/obj/basic.o
+DEPS_53 += $(CONFIG)/obj/batch.o
 DEPS_53 += $(CONFIG)/obj/cache.o
 DEPS_53 += $(CONFIG)/obj/chunkFilter.o
+DEPS_53 += $(CONFIG)/obj/compressFilter.o
 DEPS_53 += $(CONFIG)/obj/client.o
 DEPS_53 += $(CONFIG)/obj/conn.o
 DEPS_53 += $(CONFIG)/obj/digest.o
+DEPS_53 += $(CONFIG)/obj/dnsCache.o
 DEPS_53 += $(CONFIG)/obj/endpoint.o
 DEPS_53 += $(CONFIG)/obj/error.o
+DEPS_53 += $(CONFIG)/obj/fileCache.o
 DEPS_53 += $(CONFIG)/obj/host.o
+DEPS_53 += $(CONFIG)/obj/hpack.o
+DEPS_53 += $(CONFIG)/obj/http2.o
 DEPS_53 += $(CONFIG)/obj/httpService.o
 DEPS_53 += $(CONFIG)/obj/log.o
 DEPS_53 += $(CONFIG)/obj/monitor.o
@@ -789,6 +906,8 @@ DEPS_53 += $(CONFIG)/obj/route.o
 DEPS_53 += $(CONFIG)/obj/rx.o
 DEPS_53 += $(CONFIG)/obj/sendConnector.o
 DEPS_53 += $(CONFIG)/obj/session.o
+DEPS_53 += $(CONFIG)/obj/sessionStore.o
+DEPS_53 += $(CONFIG)/obj/responseStore.o
 DEPS_53 += $(CONFIG)/obj/stage.o
 DEPS_53 += $(CONFIG)/obj/trace.o
 DEPS_53 += $(CONFIG)/obj/tx.o
@@ -799,7 +918,7 @@ DEPS_53 += $(CONFIG)/obj/webSockFilter.o
 
 $(CONFIG)/bin/libhttp.a: $(DEPS_53)
 	@echo '      [Link] $(CONFIG)/bin/libhttp.a'
-	ar -cr $(CONFIG)/bin/libhttp.a "$(CONFIG)/obj/actionHandler.o" "$(CONFIG)/obj/auth.o" "$(CONFIG)/obj/basic.o" "$(CONFIG)/obj/cache.o" "$(CONFIG)/obj/chunkFilter.o" "$(CONFIG)/obj/client.o" "$(CONFIG)/obj/conn.o" "$(CONFIG)/obj/digest.o" "$(CONFIG)/obj/endpoint.o" "$(CONFIG)/obj/error.o" "$(CONFIG)/obj/host.o" "$(CONFIG)/obj/httpService.o" "$(CONFIG)/obj/log.o" "$(CONFIG)/obj/monitor.o" "$(CONFIG)/obj/netConnector.o" "$(CONFIG)/obj/packet.o" "$(CONFIG)/obj/pam.o" "$(CONFIG)/obj/passHandler.o" "$(CONFIG)/obj/pipeline.o" "$(CONFIG)/obj/queue.o" "$(CONFIG)/obj/rangeFilter.o" "$(CONFIG)/obj/route.o" "$(CONFIG)/obj/rx.o" "$(CONFIG)/obj/sendConnector.o" "$(CONFIG)/obj/session.o" "$(CONFIG)/obj/stage.o" "$(CONFIG)/obj/trace.o" "$(CONFIG)/obj/tx.o" "$(CONFIG)/obj/uploadFilter.o" "$(CONFIG)/obj/uri.o" "$(CONFIG)/obj/var.o" "$(CONFIG)/obj/webSockFilter.o"
+	ar -cr $(CONFIG)/bin/libhttp.a "$(CONFIG)/obj/actionHandler.o" "$(CONFIG)/obj/atom.o" "$(CONFIG)/obj/auth.o" "$(CONFIG)/obj/basic.o" "$(CONFIG)/obj/batch.o" "$(CONFIG)/obj/cache.o" "$(CONFIG)/obj/chunkFilter.o" "$(CONFIG)/obj/compressFilter.o" "$(CONFIG)/obj/client.o" "$(CONFIG)/obj/conn.o" "$(CONFIG)/obj/digest.o" "$(CONFIG)/obj/dnsCache.o" "$(CONFIG)/obj/endpoint.o" "$(CONFIG)/obj/error.o" "$(CONFIG)/obj/fileCache.o" "$(CONFIG)/obj/host.o" "$(CONFIG)/obj/hpack.o" "$(CONFIG)/obj/http2.o" "$(CONFIG)/obj/httpService.o" "$(CONFIG)/obj/log.o" "$(CONFIG)/obj/monitor.o" "$(CONFIG)/obj/netConnector.o" "$(CONFIG)/obj/packet.o" "$(CONFIG)/obj/pam.o" "$(CONFIG)/obj/passHandler.o" "$(CONFIG)/obj/pipeline.o" "$(CONFIG)/obj/queue.o" "$(CONFIG)/obj/rangeFilter.o" "$(CONFIG)/obj/route.o" "$(CONFIG)/obj/rx.o" "$(CONFIG)/obj/sendConnector.o" "$(CONFIG)/obj/session.o" "$(CONFIG)/obj/sessionStore.o" "$(CONFIG)/obj/responseStore.o" "$(CONFIG)/obj/stage.o" "$(CONFIG)/obj/trace.o" "$(CONFIG)/obj/tx.o" "$(CONFIG)/obj/uploadFilter.o" "$(CONFIG)/obj/uri.o" "$(CONFIG)/obj/var.o" "$(CONFIG)/obj/webSockFilter.o"
 endif
 
 #
@@ -830,16 +949,23 @@ DEPS_55 += $(CONFIG)/inc/bitos.h
 DEPS_55 += $(CONFIG)/inc/http.h
 DEPS_55 += src/http.h
 DEPS_55 += $(CONFIG)/obj/actionHandler.o
+DEPS_55 += $(CONFIG)/obj/atom.o
 DEPS_55 += $(CONFIG)/obj/auth.o
 DEPS_55 += $(CONFIG)/obj/basic.o
+DEPS_55 += $(CONFIG)/obj/batch.o
 DEPS_55 += $(CONFIG)/obj/cache.o
 DEPS_55 += $(CONFIG)/obj/chunkFilter.o
+DEPS_55 += $(CONFIG)/obj/compressFilter.o
 DEPS_55 += $(CONFIG)/obj/client.o
 DEPS_55 += $(CONFIG)/obj/conn.o
 DEPS_55 += $(CONFIG)/obj/digest.o
+DEPS_55 += $(CONFIG)/obj/dnsCache.o
 DEPS_55 += $(CONFIG)/obj/endpoint.o
 DEPS_55 += $(CONFIG)/obj/error.o
+DEPS_55 += $(CONFIG)/obj/fileCache.o
 DEPS_55 += $(CONFIG)/obj/host.o
+DEPS_55 += $(CONFIG)/obj/hpack.o
+DEPS_55 += $(CONFIG)/obj/http2.o
 DEPS_55 += $(CONFIG)/obj/httpService.o
 DEPS_55 += $(CONFIG)/obj/log.o
 DEPS_55 += $(CONFIG)/obj/monitor.o
@@ -854,6 +980,8 @@ DEPS_55 += $(CONFIG)/obj/route.o
 DEPS_55 += $(CONFIG)/obj/rx.o
 DEPS_55 += $(CONFIG)/obj/sendConnector.o
 DEPS_55 += $(CONFIG)/obj/session.o
+DEPS_55 += $(CONFIG)/obj/sessionStore.o
+DEPS_55 += $(CONFIG)/obj/responseStore.o
 DEPS_55 += $(CONFIG)/obj/stage.o
 DEPS_55 += $(CONFIG)/obj/trace.o
 DEPS_55 += $(CONFIG)/obj/tx.o
@@ -873,6 +1001,9 @@ LIBS_55 += -lmpr
 ifeq ($(BIT_PACK_PCRE),1)
     LIBS_55 += -lpcre
 endif
+ifeq ($(BIT_PACK_ZLIB),1)
+    LIBS_55 += -lz
+endif
 
 $(CONFIG)/bin/http: $(DEPS_55)
 	@echo '      [Link] $(CONFIG)/bin/http'
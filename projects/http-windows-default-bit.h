@@ -82,6 +82,9 @@
 #ifndef BIT_HAS_UNNAMED_UNIONS
     #define BIT_HAS_UNNAMED_UNIONS 1
 #endif
+#ifndef BIT_HTTP_HTTP2
+    #define BIT_HTTP_HTTP2 1
+#endif
 #ifndef BIT_HTTP_PAM
     #define BIT_HTTP_PAM 1
 #endif
@@ -263,3 +266,6 @@
 #ifndef BIT_PACK_WINSDK
     #define BIT_PACK_WINSDK 1
 #endif
+#ifndef BIT_PACK_ZLIB
+    #define BIT_PACK_ZLIB 0
+#endif
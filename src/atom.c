@@ -0,0 +1,131 @@
+/*
+    atom.c -- Interned strings for the common HTTP vocabulary
+
+    Method names, protocol versions, header names, extensions and MIME types recur in every request. Atoms are single
+    permanent copies of these strings held in a global table. The parsers use the atom instead of allocating a copy of
+    each occurrence. Atoms are held so they are never collected and may be stored in any structure that marks its
+    strings. Equal atoms are the same pointer and may be compared by pointer.
+
+    Lookups are exact so header names are interned in canonical and lower case (as used by HTTP/2). The table is not
+    locked. Atoms must be added before requests are serviced.
+
+    Copyright (c) All Rights Reserved. See copyright notice at the bottom of the file.
+ */
+
+/********************************* Includes ***********************************/
+
+#include    "http.h"
+
+/*********************************** Locals ***********************************/
+
+#define ATOM_MAX_LEN    64                  /* Longest atom looked up via httpInternBlock */
+
+static cchar *atomWords[] = {
+    "DELETE", "GET", "HEAD", "OPTIONS", "POST", "PUT", "TRACE",
+    "HTTP/1.0", "HTTP/1.1", "HTTP/2.0",
+    "css", "gif", "htm", "html", "ico", "jpeg", "jpg", "js", "json", "png", "svg", "txt", "woff", "xml",
+    "application/json", "application/octet-stream", "application/x-www-form-urlencoded", "multipart/form-data",
+    "text/html", "text/plain",
+    0
+};
+
+static cchar *atomHeaders[] = {
+    "Accept", "Accept-Charset", "Accept-Encoding", "Accept-Language", "Authorization", "Cache-Control", "Connection",
+    "Content-Length", "Content-Range", "Content-Type", "Cookie", "DNT", "Expect", "Host", "HTTP2-Settings",
+    "If-Match", "If-Modified-Since", "If-None-Match", "If-Range", "If-Unmodified-Since", "Keep-Alive", "Origin",
+    "Pragma", "Range", "Referer", "Sec-WebSocket-Key", "Sec-WebSocket-Protocol", "Sec-WebSocket-Version", "TE",
+    "Transfer-Encoding", "Upgrade", "Upgrade-Insecure-Requests", "User-Agent", "Via", "X-Forwarded-For",
+    "X-Forwarded-Proto", "X-Requested-With",
+    0
+};
+
+/************************************ Code ************************************/
+
+PUBLIC void httpInitAtoms(Http *http)
+{
+    cchar   **cp;
+
+    http->atoms = mprCreateHash(0, MPR_HASH_OPEN | MPR_HASH_STATIC_ALL);
+    for (cp = atomWords; *cp; cp++) {
+        httpAddAtom(*cp);
+    }
+    for (cp = atomHeaders; *cp; cp++) {
+        httpAddAtom(*cp);
+        httpAddAtom(slower(*cp));
+    }
+}
+
+
+PUBLIC cchar *httpAddAtom(cchar *str)
+{
+    Http    *http;
+    char    *atom;
+
+    http = MPR->httpService;
+    if ((atom = mprLookupKey(http->atoms, str)) == 0) {
+        atom = sclone(str);
+        mprHold(atom);
+        mprAddKey(http->atoms, atom, atom);
+    }
+    return atom;
+}
+
+
+PUBLIC cchar *httpLookupAtom(cchar *str)
+{
+    Http    *http;
+
+    if (str == 0) {
+        return 0;
+    }
+    http = MPR->httpService;
+    return mprLookupKey(http->atoms, str);
+}
+
+
+PUBLIC cchar *httpIntern(cchar *str)
+{
+    cchar   *atom;
+
+    if ((atom = httpLookupAtom(str)) != 0) {
+        return atom;
+    }
+    return sclone(str);
+}
+
+
+PUBLIC cchar *httpInternBlock(cchar *str, ssize len)
+{
+    char    buf[ATOM_MAX_LEN];
+    cchar   *atom;
+
+    if (len < sizeof(buf)) {
+        memcpy(buf, str, len);
+        buf[len] = '\0';
+        if ((atom = httpLookupAtom(buf)) != 0) {
+            return atom;
+        }
+    }
+    return snclone(str, len);
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a 
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details and other copyrights.
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -8,6 +8,14 @@
 
 #include    "http.h"
 
+/*********************************** Locals ***********************************/
+
+typedef struct AuthEntry {
+    HttpUser        *user;              /* User object the credentials were verified for */
+    MprTicks        expires;            /* When the credentials must be verified again */
+    uint64          verifyTime;         /* Time taken to verify in microseconds */
+} AuthEntry;
+
 /********************************* Forwards ***********************************/
 
 #undef  GRADUATE_HASH
@@ -26,6 +34,11 @@ static void manageRole(HttpRole *role, int flags);
 static void manageUser(HttpUser *user, int flags);
 static void formLogin(HttpConn *conn);
 static bool fileVerifyUser(HttpConn *conn, cchar *username, cchar *password);
+static uint64 getMicroseconds();
+static void manageAuthCache(HttpAuthCache *cache, int flags);
+static void manageAuthEntry(AuthEntry *ep, int flags);
+static void pruneAuthCache(HttpAuthCache *cache, MprTicks now);
+static bool verifyUser(HttpConn *conn, cchar *username, cchar *password);
 
 /*********************************** Code *************************************/
 
@@ -49,6 +62,14 @@ PUBLIC void httpInitAuth(Http *http)
     httpAddAuthStore("pam", httpPamVerifyUser);
 #endif
 #endif
+#if BIT_HAS_PAM && BIT_HTTP_PAM
+    /*
+        The internal store verifies with a single MD5 which costs no more than the cache lookup
+     */
+    httpSetAuthStoreCache("system", 1);
+    httpSetAuthStoreCache("pam", 1);
+#endif
+    httpSetAuthCache(http, HTTP_AUTH_CACHE_TTL, HTTP_AUTH_CACHE_MAX);
 }
 
 
@@ -137,7 +158,7 @@ PUBLIC bool httpLogin(HttpConn *conn, cchar *username, cchar *password)
     if (auth->username) {
         username = auth->username;
     }
-    if (!(auth->store->verifyUser)(conn, username, password)) {
+    if (!verifyUser(conn, username, password)) {
         return 0;
     }
     if ((session = httpCreateSession(conn)) == 0) {
@@ -352,6 +373,22 @@ PUBLIC int httpSetAuthStoreVerify(cchar *name, HttpVerifyUser verifyUser)
         return MPR_ERR_CANT_FIND;
     }
     store->verifyUser = verifyUser;
+    httpFlushAuthCache(http);
+    return 0;
+}
+
+
+PUBLIC int httpSetAuthStoreCache(cchar *name, bool enable)
+{
+    Http            *http;
+    HttpAuthStore   *store;
+
+    http = MPR->httpService;
+    if ((store = mprLookupKey(http->authStores, name)) == 0) {
+        return MPR_ERR_CANT_FIND;
+    }
+    store->cacheable = enable;
+    httpFlushAuthCache(http);
     return 0;
 }
 
@@ -810,6 +847,179 @@ PUBLIC void httpSetConnUser(HttpConn *conn, HttpUser *user)
     conn->user = user;
 }
 
+
+/*
+    Configure the verified credential cache. Set ttl to zero to disable.
+ */
+PUBLIC int httpSetAuthCache(Http *http, MprTicks ttl, int maxEntries)
+{
+    HttpAuthCache   *cache;
+
+    if (ttl <= 0) {
+        http->authCache = 0;
+        return 0;
+    }
+    if ((cache = http->authCache) == 0) {
+        if ((cache = mprAllocObj(HttpAuthCache, manageAuthCache)) == 0) {
+            return MPR_ERR_MEMORY;
+        }
+        cache->entries = mprCreateHash(0, 0);
+        cache->mutex = mprCreateLock();
+    }
+    cache->ttl = ttl;
+    cache->maxEntries = (maxEntries > 0) ? maxEntries : HTTP_AUTH_CACHE_MAX;
+    http->authCache = cache;
+    return 0;
+}
+
+
+static void manageAuthCache(HttpAuthCache *cache, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(cache->entries);
+        mprMark(cache->mutex);
+    }
+}
+
+
+static void manageAuthEntry(AuthEntry *ep, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(ep->user);
+    }
+}
+
+
+/*
+    Discard all verified credentials. Verifications in progress are not added to the cache.
+ */
+PUBLIC void httpFlushAuthCache(Http *http)
+{
+    HttpAuthCache   *cache;
+
+    if (!http || (cache = http->authCache) == 0) {
+        return;
+    }
+    lock(cache);
+    if (mprGetHashLength(cache->entries) > 0) {
+        cache->entries = mprCreateHash(0, 0);
+    }
+    cache->generation++;
+    unlock(cache);
+}
+
+
+/*
+    Verify the user via the auth store. Successful verifications by cacheable stores are retained for a short period
+    keyed by a hash of the credentials with the per-process secret. The user set is part of the key as routes with
+    the same realm may have different users. Auto-login (no password) and digest authentication are not cached: the
+    latter is already verified by comparing digests computed when the request is parsed.
+
+    An entry is only valid for the user object it was verified for. Removing a user or replacing it with a new
+    password invalidates just that user's entries, so adding users and changing roles do not flush the cache. Roles
+    do not affect the credentials and abilities are always taken from the current user object.
+ */
+static bool verifyUser(HttpConn *conn, cchar *username, cchar *password)
+{
+    HttpAuth        *auth;
+    HttpAuthCache   *cache;
+    HttpUser        *user, *prior;
+    AuthEntry       *ep;
+    MprTicks        now;
+    uint64          start, elapsed;
+    char            *key;
+    bool            success;
+    int             generation;
+
+    auth = conn->rx->route->auth;
+    cache = conn->http->authCache;
+    if (!cache || !auth->store->cacheable || !password || conn->rx->passwordDigest || conn->encoded) {
+        return (auth->store->verifyUser)(conn, username, password);
+    }
+    key = mprGetMD5(sfmt("%s:%s:%p:%s:%s:%s", conn->http->secret, auth->store->name, auth->userCache, auth->realm,
+        username, password));
+    now = mprGetTicks();
+    lock(cache);
+    user = mprLookupKey(auth->userCache, username);
+    if ((ep = mprLookupKey(cache->entries, key)) != 0 && ep->expires > now && user && user == ep->user) {
+        cache->hits++;
+        cache->savedTime += ep->verifyTime;
+        unlock(cache);
+        if (!conn->user) {
+            conn->user = user;
+        }
+        mprLog(5, "User \"%s\" authenticated from the auth cache", username);
+        return 1;
+    }
+    cache->misses++;
+    generation = cache->generation;
+    prior = user;
+    unlock(cache);
+
+    start = getMicroseconds();
+    success = (auth->store->verifyUser)(conn, username, password);
+    elapsed = getMicroseconds() - start;
+
+    /*
+        Stores such as PAM may create the user when verifying. Do not cache if the user was replaced meanwhile.
+     */
+    lock(cache);
+    cache->verifyTime += elapsed;
+    user = mprLookupKey(auth->userCache, username);
+    if (success && generation == cache->generation && user && (!prior || prior == user)) {
+        if (mprGetHashLength(cache->entries) >= cache->maxEntries) {
+            pruneAuthCache(cache, now);
+        }
+        if ((ep = mprAllocObj(AuthEntry, manageAuthEntry)) != 0) {
+            ep->user = user;
+            ep->expires = now + cache->ttl;
+            ep->verifyTime = elapsed;
+            mprAddKey(cache->entries, key, ep);
+        }
+    }
+    unlock(cache);
+    return success;
+}
+
+
+/*
+    Remove expired entries. If none have expired, remove the entry expiring first. Caller must hold the lock.
+ */
+static void pruneAuthCache(HttpAuthCache *cache, MprTicks now)
+{
+    MprKey      *kp, *victim;
+    AuthEntry   *ep;
+    int         removed;
+
+    removed = 0;
+    victim = 0;
+    for (ITERATE_KEYS(cache->entries, kp)) {
+        ep = (AuthEntry*) kp->data;
+        if (ep->expires <= now) {
+            mprRemoveKey(cache->entries, kp->key);
+            removed++;
+        } else if (!victim || ep->expires < ((AuthEntry*) victim->data)->expires) {
+            victim = kp;
+        }
+    }
+    if (!removed && victim) {
+        mprRemoveKey(cache->entries, victim->key);
+    }
+}
+
+
+static uint64 getMicroseconds()
+{
+#if BIT_UNIX_LIKE && defined(CLOCK_MONOTONIC)
+    struct timespec     ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+    return (uint64) mprGetTicks() * 1000;
+#endif
+}
+
 #undef  GRADUATE_HASH
 
 /*
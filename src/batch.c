@@ -0,0 +1,353 @@
+/*
+    batch.c -- Asynchronous client request batches
+
+    A batch issues many client requests from a single dispatcher without dedicating a thread to each request.
+    Requests are queued and started as in-flight capacity permits. Responses are read as they arrive via connection
+    notifications and the completion callback is invoked on the batch dispatcher. Each request has a deadline and 
+    may be cancelled.
+
+    Connections are destroyed when a request completes. Keep-alive sockets are returned to the client connection
+    pool so following requests to the same host reuse warm connections.
+
+    Copyright (c) All Rights Reserved. See copyright notice at the bottom of the file.
+ */
+
+/********************************* Includes ***********************************/
+
+#include    "http.h"
+
+/********************************** Forwards **********************************/
+
+static void batchNotifier(HttpConn *conn, int event, int arg);
+static void cancelRequest(HttpBatchRequest *req, MprEvent *event);
+static void completeRequest(HttpBatchRequest *req, MprEvent *event);
+static void finishRequest(HttpBatchRequest *req, int status, cchar *error);
+static void manageBatch(HttpBatch *batch, int flags);
+static void manageBatchRequest(HttpBatchRequest *req, int flags);
+static void readResponse(HttpBatchRequest *req);
+static void scheduleStart(HttpBatch *batch);
+static void startRequest(HttpBatchRequest *req);
+static void startRequests(HttpBatch *batch, MprEvent *event);
+static void timeoutRequest(HttpBatchRequest *req, MprEvent *event);
+
+/************************************ Code ************************************/
+
+PUBLIC HttpBatch *httpCreateBatch(MprDispatcher *dispatcher, int maxActive)
+{
+    HttpBatch   *batch;
+
+    if ((batch = mprAllocObj(HttpBatch, manageBatch)) == 0) {
+        return 0;
+    }
+    batch->http = MPR->httpService;
+    batch->dispatcher = dispatcher ? dispatcher : mprCreateDispatcher("batch", 0);
+    batch->queue = mprCreateList(0, 0);
+    batch->maxActive = max(maxActive, 1);
+    return batch;
+}
+
+
+static void manageBatch(HttpBatch *batch, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(batch->http);
+        mprMark(batch->dispatcher);
+        mprMark(batch->queue);
+    }
+}
+
+
+static void manageBatchRequest(HttpBatchRequest *req, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(req->batch);
+        mprMark(req->conn);
+        mprMark(req->method);
+        mprMark(req->uri);
+        mprMark(req->body);
+        mprMark(req->response);
+        mprMark(req->error);
+        mprMark(req->timer);
+    }
+}
+
+
+/*
+    Queue a request. This may be called from any thread. The request is started on the batch dispatcher.
+ */
+PUBLIC HttpBatchRequest *httpBatchRequest(HttpBatch *batch, cchar *method, cchar *uri, cchar *body, MprTicks timeout,
+    HttpBatchCallback callback, void *data)
+{
+    HttpBatchRequest    *req;
+
+    assert(batch);
+    assert(method && *method);
+    assert(uri && *uri);
+
+    if ((req = mprAllocObj(HttpBatchRequest, manageBatchRequest)) == 0) {
+        return 0;
+    }
+    req->batch = batch;
+    req->method = sclone(method);
+    req->uri = sclone(uri);
+    req->body = body ? sclone(body) : 0;
+    req->callback = callback;
+    req->data = data;
+    if (timeout <= 0) {
+        timeout = batch->http->clientLimits->requestTimeout;
+    }
+    req->deadline = mprGetTicks() + timeout;
+    mprAtomicAdd(&batch->pending, 1);
+    mprAddItem(batch->queue, req);
+    scheduleStart(batch);
+    return req;
+}
+
+
+/*
+    Cancellation is performed on the batch dispatcher to serialize with request processing
+ */
+PUBLIC void httpCancelBatchRequest(HttpBatchRequest *req)
+{
+    if (req && !req->done && !req->cancelled) {
+        req->cancelled = 1;
+        mprCreateEvent(req->batch->dispatcher, "batchCancel", 0, cancelRequest, req, 0);
+    }
+}
+
+
+PUBLIC int httpWaitBatch(HttpBatch *batch, MprTicks timeout)
+{
+    MprTicks    mark, remaining;
+
+    mark = mprGetTicks();
+    remaining = (timeout < 0) ? MPR_MAX_TIMEOUT : timeout;
+    while (batch->pending > 0) {
+        if (timeout >= 0 && (remaining = mprGetRemainingTicks(mark, timeout)) <= 0) {
+            return MPR_ERR_TIMEOUT;
+        }
+        mprWaitForEvent(batch->dispatcher, remaining);
+    }
+    return 0;
+}
+
+
+/*
+    The flag is set under the queue lock before creating the event as the event may run before mprCreateEvent returns
+ */
+static void scheduleStart(HttpBatch *batch)
+{
+    lock(batch->queue);
+    if (!batch->starting) {
+        batch->starting = 1;
+        mprCreateEvent(batch->dispatcher, "batchStart", 0, startRequests, batch, 0);
+    }
+    unlock(batch->queue);
+}
+
+
+/*
+    Start queued requests while there is capacity. Runs on the batch dispatcher.
+ */
+static void startRequests(HttpBatch *batch, MprEvent *event)
+{
+    HttpBatchRequest    *req;
+    MprList             *queue;
+
+    queue = batch->queue;
+    lock(queue);
+    batch->starting = 0;
+    unlock(queue);
+    while (batch->active < batch->maxActive) {
+        lock(queue);
+        if ((req = mprGetItem(queue, batch->next)) == 0) {
+            /* Drained. Reset rather than removing items one at a time from the front of the list */
+            mprClearList(queue);
+            batch->next = 0;
+            unlock(queue);
+            break;
+        }
+        mprSetItem(queue, batch->next++, 0);
+        unlock(queue);
+
+        if (req->cancelled) {
+            finishRequest(req, MPR_ERR_ABORTED, "Request cancelled");
+        } else if (req->deadline <= mprGetTicks()) {
+            finishRequest(req, MPR_ERR_TIMEOUT, "Request timed out before starting");
+        } else {
+            startRequest(req);
+        }
+    }
+}
+
+
+static void startRequest(HttpBatchRequest *req)
+{
+    HttpBatch   *batch;
+    HttpConn    *conn;
+    ssize       len;
+
+    batch = req->batch;
+    if ((conn = httpCreateConn(batch->http, NULL, batch->dispatcher)) == 0) {
+        finishRequest(req, MPR_ERR_MEMORY, "Cannot create connection");
+        return;
+    }
+    req->conn = conn;
+    req->started = mprGetTicks();
+    req->response = mprCreateBuf(0, 0);
+    batch->active++;
+    req->timer = mprCreateEvent(batch->dispatcher, "batchTimeout", req->deadline - req->started, timeoutRequest, req, 0);
+
+    httpSetConnContext(conn, req);
+    httpSetAsync(conn, 1);
+    httpSetConnNotifier(conn, batchNotifier);
+    if (httpConnect(conn, req->method, req->uri, NULL) < 0) {
+        finishRequest(req, MPR_ERR_CANT_CONNECT, conn->errorMsg ? conn->errorMsg : "Cannot connect");
+        return;
+    }
+    if (req->body) {
+        len = slen(req->body);
+        httpSetContentLength(conn, len);
+        if (httpWriteBlock(conn->writeq, req->body, len, HTTP_BUFFER) != len) {
+            finishRequest(req, MPR_ERR_CANT_WRITE, "Cannot write request body");
+            return;
+        }
+    }
+    httpFinalizeOutput(conn);
+    httpEnableConnEvents(conn);
+}
+
+
+static void batchNotifier(HttpConn *conn, int event, int arg)
+{
+    HttpBatchRequest    *req;
+
+    if ((req = httpGetConnContext(conn)) == 0 || req->done) {
+        return;
+    }
+    switch (event) {
+    case HTTP_EVENT_READABLE:
+        readResponse(req);
+        break;
+
+    case HTTP_EVENT_STATE:
+        if (arg == HTTP_STATE_COMPLETE) {
+            readResponse(req);
+            finishRequest(req, httpGetStatus(conn), 0);
+        }
+        break;
+
+    case HTTP_EVENT_ERROR:
+        if (!conn->sock) {
+            finishRequest(req, MPR_ERR_CANT_CONNECT, conn->errorMsg ? conn->errorMsg : "Cannot connect");
+        } else {
+            finishRequest(req, MPR_ERR_CANT_COMPLETE, conn->errorMsg ? conn->errorMsg : "Request failed");
+        }
+        break;
+    }
+}
+
+
+static void readResponse(HttpBatchRequest *req)
+{
+    MprBuf      *buf;
+    ssize       nbytes;
+
+    buf = req->response;
+    do {
+        if (mprGetBufSpace(buf) < BIT_MAX_BUFFER && mprGrowBuf(buf, BIT_MAX_BUFFER) < 0) {
+            break;
+        }
+        if ((nbytes = httpRead(req->conn, mprGetBufEnd(buf), mprGetBufSpace(buf) - 1)) > 0) {
+            mprAdjustBufEnd(buf, nbytes);
+        }
+    } while (nbytes > 0);
+    mprAddNullToBuf(buf);
+}
+
+
+static void timeoutRequest(HttpBatchRequest *req, MprEvent *event)
+{
+    req->timer = 0;
+    finishRequest(req, MPR_ERR_TIMEOUT, "Request timed out");
+}
+
+
+static void cancelRequest(HttpBatchRequest *req, MprEvent *event)
+{
+    /* Queued requests are finished when dequeued */
+    if (req->conn) {
+        finishRequest(req, MPR_ERR_ABORTED, "Request cancelled");
+    }
+}
+
+
+/*
+    Record the request outcome. Completion is deferred to a new event as this may be called from within connection
+    processing.
+ */
+static void finishRequest(HttpBatchRequest *req, int status, cchar *error)
+{
+    if (req->done) {
+        return;
+    }
+    req->done = 1;
+    req->status = status;
+    req->error = error ? sclone(error) : 0;
+    if (req->timer) {
+        mprRemoveEvent(req->timer);
+        req->timer = 0;
+    }
+    mprCreateEvent(req->batch->dispatcher, "batchComplete", 0, completeRequest, req, 0);
+}
+
+
+/*
+    Destroy the connection and invoke the callback. A cleanly completed keep-alive socket is returned to the client
+    connection pool, otherwise the socket is closed.
+ */
+static void completeRequest(HttpBatchRequest *req, MprEvent *event)
+{
+    HttpBatch   *batch;
+    HttpConn    *conn;
+
+    batch = req->batch;
+    if ((conn = req->conn) != 0) {
+        httpSetConnNotifier(conn, 0);
+        httpSetConnContext(conn, 0);
+        httpDestroyConn(conn);
+        req->conn = 0;
+        batch->active--;
+    }
+    if (req->status > 0) {
+        batch->completed++;
+    } else {
+        batch->failed++;
+    }
+    if (req->callback) {
+        (req->callback)(req);
+    }
+    mprAtomicAdd(&batch->pending, -1);
+    scheduleStart(batch);
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a 
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details and other copyrights.
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
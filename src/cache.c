@@ -16,6 +16,7 @@
 
 static void cacheAtClient(HttpConn *conn);
 static bool fetchCachedResponse(HttpConn *conn);
+static cchar *getCachedBody(HttpConn *conn, ssize *len);
 static HttpCache *lookupCacheControl(HttpConn *conn);
 static char *makeCacheKey(HttpConn *conn);
 static void manageHttpCache(HttpCache *cache, int flags);
@@ -85,18 +86,33 @@ static int matchCacheHandler(HttpConn *conn, HttpRoute *route, int dir)
 
 static void readyCacheHandler(HttpQueue *q) 
 {
-    HttpConn    *conn;
-    HttpTx      *tx;
-    cchar       *data;
+    HttpConn            *conn;
+    HttpTx              *tx;
+    HttpCachedResponse  *response;
+    cchar               *data;
+    ssize               len;
 
     conn = q->conn;
     tx = conn->tx;
 
-    if (tx->cachedContent) {
+    if ((response = tx->cachedResponse) != 0 && tx->connector == conn->http->sendConnector) {
+        /*
+            Persistent cached response. Send the body from the store data file.
+         */
+        mprTrace(3, "cacheHandler: send cached content for '%s'", conn->rx->uri);
+        setHeadersFromCache(conn, response->headers);
+        tx->length = response->length;
+        tx->file = response->file;
+        tx->flags |= HTTP_TX_SHARED_FILE;
+        if (response->length > 0) {
+            httpPutForService(q, httpCreateEntityPacket(response->pos, response->length, 0), HTTP_DELAY_SERVICE);
+        }
+
+    } else if (tx->cachedContent || tx->cachedResponse) {
         mprTrace(3, "cacheHandler: write cached content for '%s'", conn->rx->uri);
-        if ((data = setHeadersFromCache(conn, tx->cachedContent)) != 0) {
-            tx->length = slen(data);
-            httpWriteString(q, data);
+        if ((data = getCachedBody(conn, &len)) != 0) {
+            tx->length = len;
+            httpWriteBlock(q, data, len, HTTP_BUFFER);
         }
     }
     httpFinalize(conn);
@@ -143,8 +159,8 @@ static void outgoingCacheFilterService(HttpQueue *q)
     if (mprLookupKey(conn->tx->headers, "X-SendCache") != 0) {
         if (fetchCachedResponse(conn)) {
             mprLog(3, "cacheFilter: write cached content for '%s'", conn->rx->uri);
-            cachedData = setHeadersFromCache(conn, tx->cachedContent);
-            tx->length = slen(cachedData);
+            cachedData = getCachedBody(conn, &size);
+            tx->length = size;
         }
     }
     for (packet = httpGetPacket(q); packet; packet = httpGetPacket(q)) {
@@ -293,12 +309,16 @@ static void cacheAtClient(HttpConn *conn)
  */
 static bool fetchCachedResponse(HttpConn *conn)
 {
-    HttpTx      *tx;
-    MprTime     modified, when;
-    cchar       *value, *key, *tag;
-    int         status, cacheOk, canUseClientCache;
+    HttpTx              *tx;
+    HttpResponseStore   *store;
+    MprTime             modified, when;
+    cchar               *value, *key, *tag;
+    int                 status, cacheOk, canUseClientCache, found;
 
     tx = conn->tx;
+    store = conn->host->responseStore;
+    modified = 0;
+    found = 0;
 
     /*
         Transparent caching. Manual caching must manually call httpWriteCached()
@@ -308,7 +328,17 @@ static bool fetchCachedResponse(HttpConn *conn)
             (scontains(value, "max-age=0") == 0 || scontains(value, "no-cache") == 0)) {
         mprLog(3, "Client reload. Cache-control header '%s' rejects use of cached content.", value);
 
+    } else if (store) {
+        if ((tx->cachedResponse = httpReadResponseStore(store, key)) != 0) {
+            /* Set the length now so the pipeline can select the send connector */
+            modified = tx->cachedResponse->modified;
+            tx->length = tx->cachedResponse->length;
+            found = 1;
+        }
     } else if ((tx->cachedContent = mprReadCache(conn->host->responseCache, key, &modified, 0)) != 0) {
+        found = 1;
+    }
+    if (found) {
         /*
             See if a NotModified response can be served. This is much faster than sending the response.
             Observe headers:
@@ -359,32 +389,48 @@ static void saveCachedResponse(HttpConn *conn)
         Truncate modified time to get a 1 sec resolution. This is the resolution for If-Modified headers.
      */
     modified = mprGetTime() / MPR_TICKS_PER_SEC * MPR_TICKS_PER_SEC;
-    mprWriteCache(conn->host->responseCache, makeCacheKey(conn), mprGetBufStart(buf), modified, 
-        tx->cache->serverLifespan, 0, 0);
+    if (conn->host->responseStore) {
+        httpWriteResponseStore(conn->host->responseStore, makeCacheKey(conn), mprGetBufStart(buf), mprGetBufLength(buf),
+            modified, tx->cache->serverLifespan);
+    } else {
+        mprWriteCache(conn->host->responseCache, makeCacheKey(conn), mprGetBufStart(buf), modified, 
+            tx->cache->serverLifespan, 0, 0);
+    }
 }
 
 
 PUBLIC ssize httpWriteCached(HttpConn *conn)
 {
+    HttpTx      *tx;
     MprTime     modified;
-    cchar       *cacheKey, *data, *content;
+    cchar       *cacheKey, *data;
+    ssize       len;
 
-    if (!conn->tx->cache) {
+    tx = conn->tx;
+    if (!tx->cache) {
         return MPR_ERR_CANT_FIND;
     }
     cacheKey = makeCacheKey(conn);
-    if ((content = mprReadCache(conn->host->responseCache, cacheKey, &modified, 0)) == 0) {
+    modified = 0;
+    if (conn->host->responseStore) {
+        if ((tx->cachedResponse = httpReadResponseStore(conn->host->responseStore, cacheKey)) != 0) {
+            modified = tx->cachedResponse->modified;
+        }
+    } else {
+        tx->cachedContent = mprReadCache(conn->host->responseCache, cacheKey, &modified, 0);
+    }
+    if (!tx->cachedContent && !tx->cachedResponse) {
         mprLog(3, "No cached data for ", cacheKey);
         return 0;
     }
     mprLog(5, "Used cached ", cacheKey);
-    data = setHeadersFromCache(conn, content);
+    data = getCachedBody(conn, &len);
     httpSetHeader(conn, "Etag", mprGetMD5(cacheKey));
     httpSetHeader(conn, "Last-Modified", mprFormatUniversalTime(MPR_HTTP_DATE, modified));
-    conn->tx->cacheBuffer = 0;
-    httpWriteString(conn->writeq, data);
+    tx->cacheBuffer = 0;
+    httpWriteBlock(conn->writeq, data, len, HTTP_BUFFER);
     httpFinalize(conn);
-    return slen(data);
+    return len;
 }
 
 
@@ -392,6 +438,7 @@ PUBLIC ssize httpUpdateCache(HttpConn *conn, cchar *uri, cchar *data, MprTicks l
 {
     cchar   *key;
     ssize   len;
+    int     rc;
 
     len = slen(data);
     if (len > conn->limits->cacheItemSize) {
@@ -401,6 +448,16 @@ PUBLIC ssize httpUpdateCache(HttpConn *conn, cchar *uri, cchar *data, MprTicks l
         lifespan = conn->rx->route->lifespan;
     }
     key = sfmt("http::response-%s", uri);
+    if (conn->host->responseStore) {
+        if (data == 0 || lifespan <= 0) {
+            httpRemoveResponseStore(conn->host->responseStore, key);
+            return 0;
+        }
+        if ((rc = httpWriteResponseStore(conn->host->responseStore, key, data, len, mprGetTime(), lifespan)) < 0) {
+            return rc;
+        }
+        return len;
+    }
     if (data == 0 || lifespan <= 0) {
         mprRemoveCache(conn->host->responseCache, key);
         return 0;
@@ -533,6 +590,26 @@ static char *makeCacheKey(HttpConn *conn)
 }
 
 
+/*
+    Set the headers from the retrieved cached content and return the response body
+ */
+static cchar *getCachedBody(HttpConn *conn, ssize *len)
+{
+    HttpTx      *tx;
+    cchar       *data;
+
+    tx = conn->tx;
+    if (tx->cachedResponse) {
+        setHeadersFromCache(conn, tx->cachedResponse->headers);
+        *len = tx->cachedResponse->length;
+        return tx->cachedResponse->body;
+    }
+    data = setHeadersFromCache(conn, tx->cachedContent);
+    *len = slen(data);
+    return data;
+}
+
+
 /*
     Parse cached content of the form:  headers \n\n data
     Set headers in the current request and return a reference to the data portion
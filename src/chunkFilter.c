@@ -10,6 +10,7 @@
 
 /********************************** Forwards **********************************/
 
+static bool hasRangeFilter(HttpTx *tx);
 static int matchChunk(HttpConn *conn, HttpRoute *route, int dir);
 static void openChunk(HttpQueue *q);
 static void outgoingChunkService(HttpQueue *q);
@@ -50,11 +51,15 @@ static int matchChunk(HttpConn *conn, HttpRoute *route, int dir)
     if (dir & HTTP_STAGE_TX) {
         /* 
             If content length is defined, don't need chunking. Also disable chunking if explicitly turned off vi 
-            the X_APPWEB_CHUNK_SIZE header which may set the chunk size to zero.
+            the X_APPWEB_CHUNK_SIZE header which may set the chunk size to zero. If the entity length is known, 
+            the range filter computes the length of a ranged response when it starts.
          */
         if (tx->length >= 0 || tx->chunkSize == 0) {
             return HTTP_ROUTE_REJECT;
         }
+        if (tx->outputRanges && tx->entityLength >= 0 && hasRangeFilter(tx)) {
+            return HTTP_ROUTE_REJECT;
+        }
         return HTTP_ROUTE_OK;
     } else {
         return HTTP_ROUTE_OK;
@@ -62,6 +67,23 @@ static int matchChunk(HttpConn *conn, HttpRoute *route, int dir)
 }
 
 
+/*
+    Test if the range filter was selected for the output pipeline. Route filters are clones so match by name.
+ */
+static bool hasRangeFilter(HttpTx *tx)
+{
+    HttpStage   *stage;
+    int         next;
+
+    for (ITERATE_ITEMS(tx->outputPipeline, stage, next)) {
+        if (smatch(stage->name, "rangeFilter")) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
 static void openChunk(HttpQueue *q)
 {
     HttpConn    *conn;
@@ -192,6 +214,11 @@ static void outgoingChunkService(HttpQueue *q)
                 if (q->count > 0) {
                     tx->length = q->count;
                 }
+#if BIT_HTTP_HTTP2
+            } else if (conn->net) {
+                /* HTTP/2 uses DATA frames and forbids chunked transfer encoding */
+                tx->chunkSize = 0;
+#endif
             } else {
                 tx->chunkSize = min(conn->limits->chunkSize, q->max);
             }
@@ -8,8 +8,21 @@
 
 #include    "http.h"
 
+/*********************************** Locals ***********************************/
+
+typedef struct PooledSocket {
+    MprSocket       *sock;              /* Idle connected socket */
+    MprTicks        lastUsed;           /* When the socket was returned to the pool */
+    int             keepAliveCount;     /* Remaining keep-alive requests permitted on the socket */
+} PooledSocket;
+
 /********************************* Forwards ***********************************/
 
+static PooledSocket *getPooledSocket(Http *http, cchar *ip, int port, bool secure, struct MprSsl *ssl);
+static bool isIdleSocket(MprSocket *sp);
+static void manageClientPool(HttpClientPool *pool, int flags);
+static void managePooledSocket(PooledSocket *ps, int flags);
+static char *poolKey(cchar *ip, int port, bool secure, struct MprSsl *ssl);
 static void setDefaultHeaders(HttpConn *conn);
 
 /*********************************** Code *************************************/
@@ -19,6 +32,8 @@ static HttpConn *openConnection(HttpConn *conn, struct MprSsl *ssl)
     Http        *http;
     HttpUri     *uri;
     MprSocket   *sp;
+    PooledSocket *ps;
+    cchar       *addr;
     char        *ip;
     int         port, rc, level;
 
@@ -37,10 +52,24 @@ static HttpConn *openConnection(HttpConn *conn, struct MprSsl *ssl)
     if (port == 0) {
         port = (uri->secure) ? 443 : 80;
     }
+#if BIT_PACK_SSL
+    if (uri->secure && !ssl && http->clientPool) {
+        /* Share the default SSL configuration so secure sockets can be pooled */
+        lock(http->clientPool);
+        if (!http->clientPool->ssl) {
+            http->clientPool->ssl = mprCreateSsl(0);
+        }
+        ssl = http->clientPool->ssl;
+        unlock(http->clientPool);
+    }
+#endif
     if (conn && conn->sock) {
         if (conn->keepAliveCount-- <= 0 || port != conn->port || strcmp(ip, conn->ip) != 0 || 
                 uri->secure != (conn->sock->ssl != 0) || conn->sock->ssl != ssl) {
-            httpCloseConn(conn);
+            conn->keepAliveCount++;
+            if (!httpReturnClientSocket(conn)) {
+                httpCloseConn(conn);
+            }
         } else {
             mprLog(4, "Http: reusing keep-alive socket on: %s:%d", ip, port);
         }
@@ -48,11 +77,30 @@ static HttpConn *openConnection(HttpConn *conn, struct MprSsl *ssl)
     if (conn->sock) {
         return conn;
     }
+    if ((ps = getPooledSocket(http, ip, port, uri->secure, ssl)) != 0) {
+        mprLog(4, "Http: reusing pooled socket on: %s:%d", ip, port);
+        conn->sock = ps->sock;
+        conn->ip = sclone(ip);
+        conn->port = port;
+        conn->secure = uri->secure;
+        conn->keepAliveCount = ps->keepAliveCount - 1;
+#if BIT_HTTP_WEB_SOCKETS
+        if (uri->webSockets && httpUpgradeWebSocket(conn) < 0) {
+            conn->errorMsg = conn->sock->errorMsg;
+            return 0;
+        }
+#endif
+        return conn;
+    }
+    if ((addr = httpResolveHost(http, ip)) == 0) {
+        httpError(conn, HTTP_CODE_COMMS_ERROR, "Cannot resolve host %s", ip);
+        return 0;
+    }
     if ((sp = mprCreateSocket()) == 0) {
         httpError(conn, HTTP_CODE_COMMS_ERROR, "Cannot create socket for %s", uri->uri);
         return 0;
     }
-    if ((rc = mprConnectSocket(sp, ip, port, MPR_SOCKET_NODELAY)) < 0) {
+    if ((rc = mprConnectSocket(sp, addr, port, MPR_SOCKET_NODELAY)) < 0) {
         httpError(conn, HTTP_CODE_COMMS_ERROR, "Cannot open socket on %s:%d", ip, port);
         return 0;
     }
@@ -91,6 +139,184 @@ static HttpConn *openConnection(HttpConn *conn, struct MprSsl *ssl)
 }
 
 
+/*
+    Enable pooling of idle client keep-alive sockets. Set maxPerHost to zero to disable.
+ */
+PUBLIC int httpSetClientPool(Http *http, int maxPerHost, MprTicks idleTimeout)
+{
+    HttpClientPool  *pool;
+
+    if (maxPerHost <= 0) {
+        if ((pool = http->clientPool) != 0) {
+            pool->idleTimeout = -1;
+            httpPruneClientPool(http);
+        }
+        http->clientPool = 0;
+        return 0;
+    }
+    if ((pool = http->clientPool) == 0) {
+        if ((pool = mprAllocObj(HttpClientPool, manageClientPool)) == 0) {
+            return MPR_ERR_MEMORY;
+        }
+        pool->hosts = mprCreateHash(0, 0);
+        pool->mutex = mprCreateLock();
+    }
+    pool->maxPerHost = maxPerHost;
+    pool->idleTimeout = max(idleTimeout, 0);
+    http->clientPool = pool;
+    return 0;
+}
+
+
+static void manageClientPool(HttpClientPool *pool, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(pool->hosts);
+        mprMark(pool->ssl);
+        mprMark(pool->mutex);
+    }
+}
+
+
+static void managePooledSocket(PooledSocket *ps, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(ps->sock);
+    }
+}
+
+
+static char *poolKey(cchar *ip, int port, bool secure, struct MprSsl *ssl)
+{
+    return sfmt("%s://%s:%d/%p", secure ? "https" : "http", ip, port, secure ? ssl : 0);
+}
+
+
+/*
+    Return the connection socket to the client pool. Only sockets from cleanly completed keep-alive requests are
+    pooled. Returns true if the socket was taken by the pool.
+ */
+PUBLIC bool httpReturnClientSocket(HttpConn *conn)
+{
+    HttpClientPool  *pool;
+    PooledSocket    *ps;
+    MprSocket       *sp;
+    MprList         *list;
+    char            *key;
+
+    if (!conn->http || (pool = conn->http->clientPool) == 0 || (sp = conn->sock) == 0 || conn->endpoint) {
+        return 0;
+    }
+    if (conn->keepAliveCount <= 0 || conn->error || conn->connError || conn->upgraded || 
+            (conn->state != HTTP_STATE_COMPLETE && conn->state != HTTP_STATE_BEGIN) ||
+            (conn->input && httpGetPacketLength(conn->input) > 0) || mprIsSocketEof(sp)) {
+        return 0;
+    }
+#if BIT_HTTP_HTTP2
+    if (conn->h2 || conn->net) {
+        return 0;
+    }
+#endif
+    key = poolKey(conn->ip, conn->port, conn->secure, sp->ssl);
+    lock(pool);
+    if ((list = mprLookupKey(pool->hosts, key)) == 0) {
+        list = mprCreateList(pool->maxPerHost, 0);
+        mprAddKey(pool->hosts, key, list);
+    }
+    if (mprGetListLength(list) >= pool->maxPerHost || (ps = mprAllocObj(PooledSocket, managePooledSocket)) == 0) {
+        unlock(pool);
+        return 0;
+    }
+    mprRemoveSocketHandler(sp);
+    ps->sock = sp;
+    ps->lastUsed = conn->http->now;
+    ps->keepAliveCount = conn->keepAliveCount;
+    mprAddItem(list, ps);
+    pool->count++;
+    unlock(pool);
+    conn->sock = 0;
+    mprLog(4, "Http: returned keep-alive socket to pool for %s:%d", conn->ip, conn->port);
+    return 1;
+}
+
+
+/*
+    Checkout the most recently used idle socket for the host. Expired sockets and sockets closed by the peer
+    are discarded.
+ */
+static PooledSocket *getPooledSocket(Http *http, cchar *ip, int port, bool secure, struct MprSsl *ssl)
+{
+    HttpClientPool  *pool;
+    PooledSocket    *ps;
+    MprList         *list;
+
+    if ((pool = http->clientPool) == 0) {
+        return 0;
+    }
+    lock(pool);
+    if ((list = mprLookupKey(pool->hosts, poolKey(ip, port, secure, ssl))) != 0) {
+        while ((ps = mprPopItem(list)) != 0) {
+            pool->count--;
+            if ((ps->lastUsed + pool->idleTimeout) >= http->now && isIdleSocket(ps->sock)) {
+                pool->hits++;
+                unlock(pool);
+                return ps;
+            }
+            mprCloseSocket(ps->sock, 0);
+        }
+    }
+    pool->misses++;
+    unlock(pool);
+    return 0;
+}
+
+
+/*
+    An idle keep-alive socket must not be readable. Readable means the peer closed the connection or sent
+    unexpected data.
+ */
+static bool isIdleSocket(MprSocket *sp)
+{
+    if (sp->fd == INVALID_SOCKET || mprIsSocketEof(sp)) {
+        return 0;
+    }
+    return mprWaitForSingleIO((int) sp->fd, MPR_READABLE, 0) == 0;
+}
+
+
+/*
+    Close idle sockets that have exceeded the pool idle timeout. Returns the number of sockets remaining.
+ */
+PUBLIC int httpPruneClientPool(Http *http)
+{
+    HttpClientPool  *pool;
+    PooledSocket    *ps;
+    MprList         *list;
+    MprKey          *kp;
+    int             next;
+
+    if ((pool = http->clientPool) == 0) {
+        return 0;
+    }
+    lock(pool);
+    for (ITERATE_KEY_DATA(pool->hosts, kp, list)) {
+        for (next = 0; (ps = mprGetNextItem(list, &next)) != 0; ) {
+            if (pool->idleTimeout < 0 || (ps->lastUsed + pool->idleTimeout) < http->now) {
+                mprCloseSocket(ps->sock, 0);
+                mprRemoveItem(list, ps);
+                pool->count--;
+                next--;
+            }
+        }
+        if (mprGetListLength(list) == 0) {
+            mprRemoveKey(pool->hosts, kp->key);
+        }
+    }
+    unlock(pool);
+    return pool->count;
+}
+
+
 static void setDefaultHeaders(HttpConn *conn)
 {
     HttpAuthType    *ap;
@@ -296,6 +522,7 @@ PUBLIC int httpRequest(cchar *method, cchar *uri, cchar *data, char **response,
     HttpConn    *conn;
     ssize       len;
     char        *dummy;
+    int         status;
 
     http = MPR->httpService;
 
@@ -334,8 +561,12 @@ PUBLIC int httpRequest(cchar *method, cchar *uri, cchar *data, char **response,
         return MPR_ERR_BAD_STATE;
     }
     *response = httpReadString(conn);
+    status = httpGetStatus(conn);
+
+    /* Destroy now so the socket can be returned to the client pool */
+    httpDestroyConn(conn);
     mprRemoveRoot(conn);
-    return httpGetStatus(conn);
+    return status;
 }
 
 
@@ -0,0 +1,801 @@
+/*
+    compressFilter.c - Compress response content using the gzip or deflate content encodings.
+
+    The filter negotiates the content encoding via the Accept-Encoding request header and compresses response data
+    as packets stream through the pipeline. It is enabled per route via httpSetRouteDynamicCompression. Content that
+    is already compressed, or is smaller than the route's minimum size, is passed through unmodified. The filter
+    precedes the range and chunk filters so compressed output is chunked (or framed for HTTP/2) like any other
+    response of unknown length.
+
+    This file also provides the compressed variant cache for static files. When enabled via httpSetCompressCache, the
+    first eligible request for a compressible static file queues compression on a worker thread and the result is
+    stored in the cache directory. Later requests are mapped to the compressed variant so it can be transmitted by
+    the send connector without copying.
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************* Includes ***********************************/
+
+#include    "http.h"
+
+#if BIT_PACK_ZLIB
+#include    <zlib.h>
+
+/********************************** Locals ************************************/
+
+#define COMPRESS_NONE       0
+#define COMPRESS_GZIP       1
+#define COMPRESS_DEFLATE    2
+
+/*
+    Mime types that are already compressed or are streamed and must not be delayed by compression.
+    Entries ending with "/" match all subtypes.
+ */
+static cchar *skipTypes[] = {
+    "image/",
+    "audio/",
+    "video/",
+    "font/woff",
+    "application/font-woff",
+    "application/gzip",
+    "application/x-gzip",
+    "application/zip",
+    "application/x-compress",
+    "application/x-bzip2",
+    "application/x-xz",
+    "application/x-7z-compressed",
+    "application/x-rar-compressed",
+    "application/pdf",
+    "application/octet-stream",
+    "text/event-stream",
+    0
+};
+
+#define VARIANT_PENDING     0           /* Compression is queued or running */
+#define VARIANT_READY       1           /* Variant file is complete */
+#define VARIANT_FAILED      2           /* Cannot compress. Serve the identity content */
+
+#define VARIANT_MAX_JOBS    4           /* Maximum concurrent compression jobs */
+
+typedef struct Variant {
+    HttpVariants    *cache;             /* Owning cache */
+    char            *key;               /* Key of device, inode and encoding */
+    char            *source;            /* Source filename. Null for variants found in the cache directory */
+    char            *path;              /* Variant filename. Includes the key and the source size and mtime */
+    char            *tmp;               /* Temporary filename while compressing */
+    MprOff          size;               /* Variant size */
+    MprOff          sourceSize;         /* Size of the source file that was compressed */
+    MprTime         sourceModified;     /* Modification time of the source file that was compressed */
+    MprTicks        lastUsed;           /* Time of last use for LRU eviction */
+    int             level;              /* Compression level */
+    int             state;              /* Compression state */
+    int             inuse;              /* Requests sending the variant */
+    int             removed;            /* Removed from the cache. The file is removed when no longer in use */
+} Variant;
+
+typedef struct Compress {
+    z_stream        zs;                     /* Zlib stream state */
+    HttpPacket      *out;                   /* Output packet being filled */
+    MprOff          total;                  /* Total compressed output */
+    int             encoding;               /* Selected content encoding */
+    int             decided;                /* Compression decision has been made */
+    int             active;                 /* Zlib stream is initialized */
+} Compress;
+
+/********************************** Forwards **********************************/
+
+static void closeCompress(HttpQueue *q);
+static void compressVariant(Variant *vp, MprWorker *worker);
+static void evictVariants(HttpVariants *cache);
+static void removeVariant(HttpVariants *cache, Variant *vp);
+static void scanVariants(HttpVariants *cache);
+static void manageVariant(Variant *vp, int flags);
+static void manageVariants(HttpVariants *cache, int flags);
+static void compressData(HttpQueue *q, Compress *cp, cchar *data, ssize len, int flush);
+static bool decideCompress(HttpQueue *q, Compress *cp);
+static bool hasChunkFilter(HttpQueue *q);
+static void manageCompress(Compress *cp, int flags);
+static int matchCompress(HttpConn *conn, HttpRoute *route, int dir);
+static void openCompress(HttpQueue *q);
+static void outgoingCompressService(HttpQueue *q);
+static int selectEncoding(cchar *accept);
+
+/*********************************** Code *************************************/
+
+PUBLIC int httpOpenCompressFilter(Http *http)
+{
+    HttpStage     *filter;
+
+    mprTrace(5, "Open compress filter");
+    if ((filter = httpCreateFilter(http, "compressFilter", NULL)) == 0) {
+        return MPR_ERR_CANT_CREATE;
+    }
+    http->compressFilter = filter;
+    filter->match = matchCompress;
+    filter->open = openCompress;
+    filter->close = closeCompress;
+    filter->outgoingService = outgoingCompressService;
+    return 0;
+}
+
+
+/*
+    Test what can be known before the handler generates content. The response content type and length are
+    determined later by the first service call.
+ */
+static int matchCompress(HttpConn *conn, HttpRoute *route, int dir)
+{
+    HttpRx      *rx;
+    HttpTx      *tx;
+
+    rx = conn->rx;
+    tx = conn->tx;
+
+    if (!(dir & HTTP_STAGE_TX) || route->compressLevel <= 0 || !conn->endpoint || conn->upgraded || rx->upgrade) {
+        return HTTP_ROUTE_REJECT;
+    }
+    if (tx->ext && !httpIsCompressibleMime(mprLookupMime(route->mimeTypes, tx->ext))) {
+        return HTTP_ROUTE_REJECT;
+    }
+    if (mprLookupKey(tx->headers, "Content-Encoding")) {
+        /* Pre-compressed file or variant. Vary is already defined */
+        return HTTP_ROUTE_REJECT;
+    }
+    /* The response varies by encoding even if this request is not compressed */
+    httpAppendHeaderString(conn, "Vary", "Accept-Encoding");
+    if ((rx->flags & HTTP_HEAD) || tx->outputRanges) {
+        /* Ranges apply to the identity content */
+        return HTTP_ROUTE_REJECT;
+    }
+    if (selectEncoding(rx->acceptEncoding) == COMPRESS_NONE) {
+        return HTTP_ROUTE_REJECT;
+    }
+    return HTTP_ROUTE_OK;
+}
+
+
+static void openCompress(HttpQueue *q)
+{
+    HttpConn    *conn;
+    Compress    *cp;
+
+    conn = q->conn;
+    q->packetSize = min(conn->limits->bufferSize, q->max);
+    if ((cp = mprAllocObj(Compress, manageCompress)) == 0) {
+        return;
+    }
+    cp->encoding = selectEncoding(conn->rx->acceptEncoding);
+    q->queueData = cp;
+}
+
+
+static void closeCompress(HttpQueue *q)
+{
+    Compress    *cp;
+
+    /* Release zlib memory promptly rather than waiting for the garbage collector */
+    if ((cp = q->queueData) != 0 && cp->active) {
+        deflateEnd(&cp->zs);
+        cp->active = 0;
+    }
+}
+
+
+static void manageCompress(Compress *cp, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(cp->out);
+
+    } else if (flags & MPR_MANAGE_FREE) {
+        if (cp->active) {
+            deflateEnd(&cp->zs);
+        }
+    }
+}
+
+
+static void outgoingCompressService(HttpQueue *q)
+{
+    HttpPacket  *packet;
+    Compress    *cp;
+
+    if ((cp = q->queueData) == 0) {
+        httpDefaultOutgoingServiceStage(q);
+        return;
+    }
+    if (!cp->decided && !decideCompress(q, cp)) {
+        /* Wait for more data */
+        return;
+    }
+    if (cp->encoding == COMPRESS_NONE) {
+        httpDefaultOutgoingServiceStage(q);
+        return;
+    }
+    for (packet = httpGetPacket(q); packet; packet = httpGetPacket(q)) {
+        if (packet->flags & HTTP_PACKET_DATA) {
+            if (!httpWillNextQueueAcceptSize(q, httpGetPacketLength(packet))) {
+                httpPutBackPacket(q, packet);
+                return;
+            }
+            if (packet->content) {
+                compressData(q, cp, mprGetBufStart(packet->content), httpGetPacketLength(packet), Z_NO_FLUSH);
+            }
+        } else if (packet->flags & HTTP_PACKET_END) {
+            compressData(q, cp, NULL, 0, Z_FINISH);
+            httpPutPacketToNext(q, packet);
+        } else {
+            httpPutPacketToNext(q, packet);
+        }
+    }
+}
+
+
+/*
+    Decide whether to compress the response once the handler has defined the headers and either written the minimum
+    compressible size or completed the response. Return false to wait for more data.
+ */
+static bool decideCompress(HttpQueue *q, Compress *cp)
+{
+    HttpConn    *conn;
+    HttpRoute   *route;
+    HttpTx      *tx;
+    cchar       *mimeType;
+    ssize       minSize;
+    bool        all;
+
+    conn = q->conn;
+    tx = conn->tx;
+    route = conn->rx->route;
+
+    all = (q->last && (q->last->flags & HTTP_PACKET_END)) || conn->error;
+    minSize = min(route->compressMin, q->max);
+    if (!all && q->count < minSize && tx->length < 0) {
+        return 0;
+    }
+    cp->decided = 1;
+
+    if ((mimeType = mprLookupKey(tx->headers, "Content-Type")) == 0 && tx->ext) {
+        mimeType = mprLookupMime(route->mimeTypes, tx->ext);
+    }
+    if (conn->error || tx->status < 200 || tx->status == HTTP_CODE_NO_CONTENT ||
+            tx->status == HTTP_CODE_PARTIAL || tx->status == HTTP_CODE_NOT_MODIFIED ||
+            (tx->flags & (HTTP_TX_NO_BODY | HTTP_TX_USE_OWN_HEADERS)) ||
+            mprLookupKey(tx->headers, "Content-Encoding") || !httpIsCompressibleMime(mimeType) ||
+            (tx->length >= 0 && tx->length < minSize) || (all && q->count < minSize) ||
+            (!all && !conn->net && !hasChunkFilter(q))) {
+        cp->encoding = COMPRESS_NONE;
+        return 1;
+    }
+    /*
+        Negative window bits select a raw deflate stream. Adding 16 selects a gzip wrapper.
+        The HTTP "deflate" encoding is the zlib wrapped format.
+     */
+    if (deflateInit2(&cp->zs, route->compressLevel, Z_DEFLATED,
+            (cp->encoding == COMPRESS_GZIP) ? MAX_WBITS + 16 : MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        cp->encoding = COMPRESS_NONE;
+        return 1;
+    }
+    cp->active = 1;
+    httpSetHeaderString(conn, "Content-Encoding", (cp->encoding == COMPRESS_GZIP) ? "gzip" : "deflate");
+    httpRemoveHeader(conn, "Content-Length");
+    /*
+        The compressed length is only known here if the response is complete. Otherwise, the chunk filter
+        (or HTTP/2 framing) delimits the response.
+     */
+    tx->length = -1;
+    if (tx->etag && !sstarts(tx->etag, "W/")) {
+        tx->etag = sfmt("W/%s", tx->etag);
+    }
+    return 1;
+}
+
+
+/*
+    Deflate data into output packets and send full packets downstream. Z_FINISH flushes all output and
+    completes the stream.
+ */
+static void compressData(HttpQueue *q, Compress *cp, cchar *data, ssize len, int flush)
+{
+    HttpConn    *conn;
+    MprBuf      *buf;
+    ssize       room, count;
+    int         rc;
+
+    conn = q->conn;
+    cp->zs.next_in = (Bytef*) data;
+    cp->zs.avail_in = (uInt) len;
+    do {
+        if (!cp->out) {
+            cp->out = httpCreateDataPacket(q->packetSize);
+        }
+        buf = cp->out->content;
+        room = mprGetBufSpace(buf);
+        cp->zs.next_out = (Bytef*) mprGetBufEnd(buf);
+        cp->zs.avail_out = (uInt) room;
+        if ((rc = deflate(&cp->zs, flush)) == Z_STREAM_ERROR) {
+            httpError(conn, HTTP_ABORT | HTTP_CODE_INTERNAL_SERVER_ERROR, "Cannot compress response");
+            return;
+        }
+        count = room - cp->zs.avail_out;
+        mprAdjustBufEnd(buf, count);
+        cp->total += count;
+        if (mprGetBufSpace(buf) == 0) {
+            httpPutPacketToNext(q, cp->out);
+            cp->out = 0;
+        }
+    } while (cp->zs.avail_out == 0 || (flush == Z_FINISH && rc != Z_STREAM_END));
+
+    if (flush == Z_FINISH) {
+        if (cp->out && httpGetPacketLength(cp->out) > 0) {
+            httpPutPacketToNext(q, cp->out);
+        }
+        cp->out = 0;
+        deflateEnd(&cp->zs);
+        cp->active = 0;
+        if (!(conn->tx->flags & HTTP_TX_HEADERS_CREATED) && conn->tx->chunkSize <= 0) {
+            /* The complete response was compressed before the headers were written */
+            conn->tx->length = cp->total;
+        }
+        mprTrace(6, "compressFilter: %Ld bytes in, %Ld bytes out", (int64) cp->zs.total_in, (int64) cp->total);
+    }
+}
+
+
+static bool hasChunkFilter(HttpQueue *q)
+{
+    HttpQueue   *nextQ;
+
+    for (nextQ = q->nextQ; nextQ && nextQ != q->conn->connectorq; nextQ = nextQ->nextQ) {
+        /* Route filters are clones of the registered stage */
+        if (smatch(nextQ->stage->name, "chunkFilter")) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+PUBLIC bool httpIsCompressibleMime(cchar *mimeType)
+{
+    cchar   **type;
+
+    if (mimeType == 0) {
+        return 1;
+    }
+    for (type = skipTypes; *type; type++) {
+        if (sncaselesscmp(mimeType, *type, slen(*type)) == 0) {
+            /* SVG is text */
+            return sstarts(mimeType, "image/svg") ? 1 : 0;
+        }
+    }
+    return 1;
+}
+
+
+/*
+    Parse the Accept-Encoding header and prefer gzip over deflate. Encodings with a quality of zero are refused.
+ */
+static int selectEncoding(cchar *accept)
+{
+    char    *item, *params, *tok, *qp;
+    int     gzip, deflate, any, ok;
+
+    if (accept == 0 || *accept == '\0') {
+        return COMPRESS_NONE;
+    }
+    gzip = deflate = any = 0;
+    for (item = stok(sclone(accept), ",", &tok); item; item = stok(NULL, ",", &tok)) {
+        ok = 1;
+        if ((params = schr(item, ';')) != 0) {
+            *params++ = '\0';
+            if ((qp = scontains(params, "q=")) != 0 && strtod(&qp[2], NULL) <= 0) {
+                ok = -1;
+            }
+        }
+        item = strim(item, " \t", MPR_TRIM_BOTH);
+        if (scaselessmatch(item, "gzip") || scaselessmatch(item, "x-gzip")) {
+            gzip = ok;
+        } else if (scaselessmatch(item, "deflate")) {
+            deflate = ok;
+        } else if (smatch(item, "*")) {
+            any = ok;
+        }
+    }
+    if (gzip > 0 || (gzip == 0 && any > 0)) {
+        return COMPRESS_GZIP;
+    }
+    if (deflate > 0 || (deflate == 0 && any > 0)) {
+        return COMPRESS_DEFLATE;
+    }
+    return COMPRESS_NONE;
+}
+
+/************************************ Variants ********************************/
+/*
+    Enable the compressed variant cache. Variants are stored in the given directory which is created if required.
+    Variants left by a prior run are counted against the size bound.
+ */
+PUBLIC int httpSetCompressCache(Http *http, cchar *dir, MprOff maxSize)
+{
+    HttpVariants    *cache;
+
+    if (dir == 0 || *dir == '\0' || maxSize <= 0) {
+        http->variants = 0;
+        return 0;
+    }
+    if (mprMakeDir(dir, 0700, -1, -1, 1) < 0) {
+        mprError("Cannot create compressed variant cache directory %s", dir);
+        return MPR_ERR_CANT_CREATE;
+    }
+    if ((cache = mprAllocObj(HttpVariants, manageVariants)) == 0) {
+        return MPR_ERR_MEMORY;
+    }
+    cache->dir = sclone(dir);
+    cache->items = mprCreateHash(0, 0);
+    cache->mutex = mprCreateLock();
+    cache->maxSize = maxSize;
+    scanVariants(cache);
+    http->variants = cache;
+    return 0;
+}
+
+
+/*
+    Load the variants in the cache directory. Variant filenames are "dev-inode-encoding-size-mtime.gz" where the
+    size and mtime are of the source file. Incomplete and unrecognized files are removed. If the directory holds 
+    more than the size bound, the oldest variants are evicted.
+ */
+static void scanVariants(HttpVariants *cache)
+{
+    MprDirEntry     *dp;
+    MprList         *files;
+    Variant         *vp, *prior;
+    MprTicks        now;
+    MprTime         seconds;
+    int64           dev, inode, size, modified;
+    char            *path, *name, *tok;
+    int             next;
+
+    if ((files = mprGetPathFiles(cache->dir, MPR_PATH_NODIRS | MPR_PATH_RELATIVE)) == 0) {
+        return;
+    }
+    now = mprGetTicks();
+    seconds = mprGetTime() / MPR_TICKS_PER_SEC;
+    for (ITERATE_ITEMS(files, dp, next)) {
+        path = mprJoinPath(cache->dir, dp->name);
+        name = sclone(dp->name);
+        dev = stoiradix(stok(name, "-", &tok), 16, NULL);
+        inode = stoiradix(stok(0, "-", &tok), 16, NULL);
+        stok(0, "-", &tok);
+        size = stoiradix(stok(0, "-", &tok), 16, NULL);
+        modified = stoiradix(stok(0, "-", &tok), 16, NULL);
+        if (!smatch(dp->name, sfmt("%Lx-%Lx-gzip-%Lx-%Lx.gz", dev, inode, size, modified))) {
+            /* Incomplete variant or not a variant */
+            unlink(path);
+            continue;
+        }
+        if ((vp = mprAllocObj(Variant, manageVariant)) == 0) {
+            break;
+        }
+        vp->cache = cache;
+        vp->key = sfmt("%Lx-%Lx-gzip", dev, inode);
+        vp->path = path;
+        vp->size = dp->size;
+        vp->sourceSize = size;
+        vp->sourceModified = modified;
+        vp->lastUsed = now - (seconds - dp->lastModified) * MPR_TICKS_PER_SEC;
+        vp->state = VARIANT_READY;
+        if ((prior = mprLookupKey(cache->items, vp->key)) != 0) {
+            /* Keep the variant of the most recent version of the source */
+            if (prior->sourceModified > vp->sourceModified ||
+                    (prior->sourceModified == vp->sourceModified && prior->lastUsed >= vp->lastUsed)) {
+                unlink(vp->path);
+                continue;
+            }
+            removeVariant(cache, prior);
+        }
+        mprAddKey(cache->items, vp->key, vp);
+        cache->size += vp->size;
+    }
+    evictVariants(cache);
+    mprLog(4, "Compressed variant cache %s holds %d variants, %Ld bytes", cache->dir, mprGetHashLength(cache->items),
+        cache->size);
+}
+
+
+static void manageVariants(HttpVariants *cache, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(cache->dir);
+        mprMark(cache->items);
+        mprMark(cache->mutex);
+    }
+}
+
+
+static void manageVariant(Variant *vp, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(vp->cache);
+        mprMark(vp->key);
+        mprMark(vp->source);
+        mprMark(vp->path);
+        mprMark(vp->tmp);
+    }
+}
+
+
+/*
+    Map the request filename to a compressed variant if one is ready. Otherwise queue compression of the file so
+    subsequent requests can use the variant. Called by httpMapFile after the file info and ETag are known. The variant
+    is held by the request until httpReleaseCompressedVariant so its file is not removed while being sent.
+ */
+PUBLIC void httpMapCompressedVariant(HttpConn *conn, HttpRoute *route)
+{
+    HttpVariants    *cache;
+    HttpTx          *tx;
+    MprPath         *info, vinfo;
+    Variant         *vp;
+    char            *key;
+
+    tx = conn->tx;
+    info = &tx->fileInfo;
+    cache = conn->http->variants;
+    if (!cache || route->compressLevel <= 0 || !info->valid || !info->isReg || tx->outputRanges || tx->variant ||
+            info->size < max(route->compressMin, 1) || info->size > cache->maxSize / 4 ||
+            mprLookupKey(tx->headers, "Content-Encoding") ||
+            !httpIsCompressibleMime(mprLookupMime(route->mimeTypes, tx->ext))) {
+        return;
+    }
+    if (selectEncoding(conn->rx->acceptEncoding) != COMPRESS_GZIP) {
+        return;
+    }
+    key = sfmt("%Lx-%Lx-gzip", info->dev, info->inode);
+
+    lock(cache);
+    if ((vp = mprLookupKey(cache->items, key)) != 0 &&
+            (vp->sourceSize != info->size || vp->sourceModified != info->mtime)) {
+        /* The file has been modified since it was compressed */
+        if (vp->state == VARIANT_PENDING) {
+            unlock(cache);
+            return;
+        }
+        removeVariant(cache, vp);
+        vp = 0;
+    }
+    if (vp == 0) {
+        if ((vp = mprAllocObj(Variant, manageVariant)) == 0) {
+            unlock(cache);
+            return;
+        }
+        vp->cache = cache;
+        vp->key = key;
+        vp->source = sclone(tx->filename);
+        vp->path = mprJoinPath(cache->dir, sfmt("%s-%Lx-%Lx.gz", key, info->size, (int64) info->mtime));
+        vp->sourceSize = info->size;
+        vp->sourceModified = info->mtime;
+        vp->level = route->compressLevel;
+        vp->state = VARIANT_PENDING;
+        if (mprGetPathInfo(vp->path, &vinfo) == 0 && vinfo.isReg) {
+            /* Variant created by another process sharing the cache directory */
+            vp->state = VARIANT_READY;
+            vp->size = vinfo.size;
+            cache->size += vp->size;
+            mprAddKey(cache->items, key, vp);
+            evictVariants(cache);
+
+        } else if (cache->pending < VARIANT_MAX_JOBS) {
+            vp->tmp = sfmt("%s.%d.tmp", vp->path, getpid());
+            mprAddKey(cache->items, key, vp);
+            cache->pending++;
+            if (mprStartWorker((MprWorkerProc) compressVariant, vp) < 0) {
+                /* No workers available. Retry on a later request */
+                cache->pending--;
+                mprRemoveKey(cache->items, key);
+            }
+        }
+    }
+    if (vp->state != VARIANT_READY || vp->removed) {
+        unlock(cache);
+        return;
+    }
+    vp->lastUsed = conn->http->now;
+    vp->inuse++;
+    tx->variant = vp;
+    unlock(cache);
+
+    if (httpGetCachedPathInfo(conn, vp->path, &vinfo, NULL) < 0 || !vinfo.isReg) {
+        /* Removed externally */
+        lock(cache);
+        if (!vp->removed) {
+            removeVariant(cache, vp);
+        }
+        unlock(cache);
+        httpReleaseCompressedVariant(tx);
+        return;
+    }
+    /* Keep the identity ETag, weakened as for dynamic compression */
+    tx->filename = vp->path;
+    *info = vinfo;
+    if (tx->etag && !sstarts(tx->etag, "W/")) {
+        tx->etag = sfmt("W/%s", tx->etag);
+    }
+    httpSetHeaderString(conn, "Content-Encoding", "gzip");
+    httpAppendHeaderString(conn, "Vary", "Accept-Encoding");
+}
+
+
+/*
+    Release the compressed variant held by a request. If the variant was removed from the cache while in use, the
+    file is removed now unless a newer variant for the same source has the same filename.
+ */
+PUBLIC void httpReleaseCompressedVariant(HttpTx *tx)
+{
+    HttpVariants    *cache;
+    Variant         *vp, *current;
+
+    if ((vp = tx->variant) == 0) {
+        return;
+    }
+    tx->variant = 0;
+    cache = vp->cache;
+    lock(cache);
+    if (--vp->inuse == 0 && vp->removed) {
+        current = mprLookupKey(cache->items, vp->key);
+        if (!current || !smatch(current->path, vp->path)) {
+            unlink(vp->path);
+        }
+    }
+    unlock(cache);
+}
+
+
+/*
+    Worker to compress a static file into a variant. This touches only the variant and uses no MPR allocations while
+    compressing so it can yield to the garbage collector for the duration.
+ */
+static void compressVariant(Variant *vp, MprWorker *worker)
+{
+    HttpVariants    *cache;
+    z_stream        zs;
+    uchar           *in, *out;
+    ssize           len;
+    MprOff          total;
+    int             ifd, ofd, flush, rc, ok;
+
+    cache = vp->cache;
+    ok = 0;
+    total = 0;
+    in = out = 0;
+    ofd = -1;
+    memset(&zs, 0, sizeof(zs));
+
+    mprYield(MPR_YIELD_STICKY);
+    if ((ifd = open(vp->source, O_RDONLY | O_BINARY)) >= 0 &&
+            (ofd = open(vp->tmp, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0600)) >= 0 &&
+            (in = malloc(BIT_MAX_QBUFFER)) != 0 && (out = malloc(BIT_MAX_QBUFFER)) != 0 &&
+            deflateInit2(&zs, vp->level, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK) {
+        ok = 1;
+        do {
+            if ((len = read(ifd, in, BIT_MAX_QBUFFER)) < 0) {
+                ok = 0;
+                break;
+            }
+            flush = (len == 0) ? Z_FINISH : Z_NO_FLUSH;
+            zs.next_in = in;
+            zs.avail_in = (uInt) len;
+            do {
+                zs.next_out = out;
+                zs.avail_out = BIT_MAX_QBUFFER;
+                rc = deflate(&zs, flush);
+                len = BIT_MAX_QBUFFER - zs.avail_out;
+                if (rc == Z_STREAM_ERROR || (len > 0 && write(ofd, out, len) != len)) {
+                    ok = 0;
+                    break;
+                }
+                total += len;
+            } while (zs.avail_out == 0);
+        } while (ok && flush != Z_FINISH);
+        deflateEnd(&zs);
+    }
+    if (ifd >= 0) {
+        close(ifd);
+    }
+    if (ofd >= 0) {
+        close(ofd);
+    }
+    free(in);
+    free(out);
+    if (ok && rename(vp->tmp, vp->path) < 0) {
+        ok = 0;
+    }
+    if (!ok) {
+        unlink(vp->tmp);
+    }
+    mprResetYield();
+
+    lock(cache);
+    cache->pending--;
+    if (ok) {
+        vp->state = VARIANT_READY;
+        vp->size = total;
+        vp->lastUsed = mprGetTicks();
+        cache->size += total;
+        evictVariants(cache);
+    } else {
+        vp->state = VARIANT_FAILED;
+    }
+    unlock(cache);
+    mprTrace(4, "Compressed variant %s for %s, %Ld bytes", vp->path, vp->source, total);
+}
+
+
+/*
+    Evict least recently used variants while over the size bound. Variants not in use by a request are evicted first.
+    Caller must hold the cache lock.
+ */
+static void evictVariants(HttpVariants *cache)
+{
+    MprKey      *kp;
+    Variant     *vp, *oldest;
+
+    while (cache->size > cache->maxSize) {
+        oldest = 0;
+        for (ITERATE_KEYS(cache->items, kp)) {
+            vp = (Variant*) kp->data;
+            if (vp->state != VARIANT_READY) {
+                continue;
+            }
+            if (!oldest || (vp->inuse == 0 && oldest->inuse > 0) ||
+                    ((vp->inuse == 0) == (oldest->inuse == 0) && vp->lastUsed < oldest->lastUsed)) {
+                oldest = vp;
+            }
+        }
+        if (!oldest) {
+            break;
+        }
+        removeVariant(cache, oldest);
+    }
+}
+
+
+/*
+    Remove a ready variant from the cache. The file is removed immediately unless requests are sending it, in which
+    case it is removed by the last request to release it. Caller must hold the cache lock.
+ */
+static void removeVariant(HttpVariants *cache, Variant *vp)
+{
+    if (vp->state == VARIANT_READY) {
+        cache->size -= vp->size;
+    }
+    if (mprLookupKey(cache->items, vp->key) == vp) {
+        mprRemoveKey(cache->items, vp->key);
+    }
+    vp->removed = 1;
+    if (vp->inuse == 0) {
+        unlink(vp->path);
+    }
+}
+
+#endif /* BIT_PACK_ZLIB */
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details and other copyrights.
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
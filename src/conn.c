@@ -76,10 +76,25 @@ PUBLIC void httpDestroyConn(HttpConn *conn)
 {
     if (conn->http) {
         assert(conn->http);
+#if BIT_HTTP_HTTP2
+        if (conn->h2) {
+            httpDestroyHttp2(conn);
+        }
+#endif
         HTTP_NOTIFY(conn, HTTP_EVENT_DESTROY, 0);
         httpRemoveConn(conn->http, conn);
+        if (!conn->endpoint) {
+            httpReturnClientSocket(conn);
+        }
         if (conn->endpoint) {
+#if BIT_HTTP_HTTP2
+            /* HTTP/2 streams share the network connection */
+            if (!conn->net) {
+                httpMonitorEvent(conn, HTTP_COUNTER_ACTIVE_CONNECTIONS, -1);
+            }
+#else
             httpMonitorEvent(conn, HTTP_COUNTER_ACTIVE_CONNECTIONS, -1);
+#endif
             if (conn->activeRequest) {
                 httpMonitorEvent(conn, HTTP_COUNTER_ACTIVE_REQUESTS, -1);
                 conn->activeRequest = 0;
@@ -148,11 +163,17 @@ static void manageConn(HttpConn *conn, int flags)
         mprMark(conn->headersCallbackArg);
 
         mprMark(conn->authType);
+#if BIT_HTTP_HTTP2
+        mprMark(conn->net);
+        mprMark(conn->h2);
+#endif
         mprMark(conn->authData);
         mprMark(conn->username);
         mprMark(conn->password);
 
     } else if (flags & MPR_MANAGE_FREE) {
+        /* The socket may also be freed by this collection, so it cannot be pooled */
+        conn->keepAliveCount = 0;
         httpDestroyConn(conn);
     }
 }
@@ -409,6 +430,12 @@ PUBLIC void httpEvent(HttpConn *conn, MprEvent *event)
     mprTrace(6, "httpEvent for fd %d, mask %d", conn->sock->fd, event->mask);
     conn->lastActivity = conn->http->now;
 
+#if BIT_HTTP_HTTP2
+    if (conn->h2) {
+        httpHttp2Event(conn, event);
+        return;
+    }
+#endif
     if (event->mask & MPR_WRITABLE) {
         writeEvent(conn);
     }
@@ -443,10 +470,20 @@ static void readEvent(HttpConn *conn)
     } else if (nbytes < 0 && mprIsSocketEof(conn->sock)) {
         conn->errorMsg = conn->sock->errorMsg;
         conn->keepAliveCount = 0;
+        if (!conn->endpoint && HTTP_STATE_BEGIN < conn->state && conn->state < HTTP_STATE_PARSED) {
+            /* Server closed the connection before responding. Raise an error so async clients are notified */
+            httpError(conn, HTTP_ABORT | HTTP_CODE_COMMS_ERROR, "Connection lost");
+            return;
+        }
         if (conn->state < HTTP_STATE_PARSED || conn->state == HTTP_STATE_COMPLETE) {
             return;
         }
     }
+#if BIT_HTTP_HTTP2
+    if (conn->endpoint && conn->state == HTTP_STATE_CONNECTED && httpStartHttp2(conn)) {
+        return;
+    }
+#endif
     do {
         if (!httpPumpRequest(conn, conn->input)) {
             break;
@@ -550,6 +587,12 @@ PUBLIC void httpEnableConnEvents(HttpConn *conn)
     if (!conn->async || !sp || conn->delay) {
         return;
     }
+#if BIT_HTTP_HTTP2
+    if (conn->net || conn->h2) {
+        httpEnableHttp2Events(conn->net ? conn->net : conn);
+        return;
+    }
+#endif
     tx = conn->tx;
     rx = conn->rx;
     eventMask = 0;
@@ -49,6 +49,9 @@
 #ifndef BIT_EST_AES
     #define BIT_EST_AES 1
 #endif
+#ifndef BIT_EST_AESNI
+    #define BIT_EST_AESNI 1
+#endif
 #ifndef BIT_EST_BIGNUM
     #define BIT_EST_BIGNUM 1
 #endif
@@ -64,6 +67,9 @@
 #ifndef BIT_EST_DHM
     #define BIT_EST_DHM 1
 #endif
+#ifndef BIT_EST_GCM
+    #define BIT_EST_GCM 1
+#endif
 #ifndef BIT_EST_GEN_PRIME
     #define BIT_EST_GEN_PRIME 1
 #endif
@@ -1651,6 +1657,7 @@ extern "C" {
 #define EST_ERR_SSL_BAD_HS_CERTIFICATE_VERIFY         -0xD000
 #define EST_ERR_SSL_BAD_HS_CHANGE_CIPHER_SPEC         -0xD800
 #define EST_ERR_SSL_BAD_HS_FINISHED                   -0xE000
+#define EST_ERR_SSL_ASYNC_PENDING                     -0xE800
 
 /*
     Various constants
@@ -1712,6 +1719,7 @@ typedef struct EstCipher {
 #define SSL_HS_HELLO_REQUEST            0
 #define SSL_HS_CLIENT_HELLO             1
 #define SSL_HS_SERVER_HELLO             2
+#define SSL_HS_NEW_SESSION_TICKET       4
 #define SSL_HS_CERTIFICATE             11
 #define SSL_HS_SERVER_KEY_EXCHANGE     12
 #define SSL_HS_CERTIFICATE_REQUEST     13
@@ -1725,6 +1733,21 @@ typedef struct EstCipher {
  */
 #define TLS_EXT_SERVERNAME              0
 #define TLS_EXT_SERVERNAME_HOSTNAME     0
+#define TLS_EXT_ALPN                    16
+#define TLS_EXT_SESSION_TICKET          35
+
+#define SSL_MAX_ALPN_LEN                32  /**< Maximum length of a negotiated ALPN protocol name */
+
+/*
+    Session tickets (RFC 5077)
+ */
+#define SSL_MAX_TICKET_LEN              256     /**< Max size of a session ticket */
+#define SSL_TICKET_KEY_LEN              48      /**< Size of a ticket key: name, HMAC secret and AES key */
+#define SSL_TICKET_LIFETIME             3600    /**< Default ticket lifetime in seconds */
+
+#define SSL_MAX_RSA_LEN                 512     /**< Max RSA modulus size in bytes for asynchronous operations */
+#define SSL_ASYNC_DECRYPT               1       /**< Asynchronous decryption of the premaster secret */
+#define SSL_ASYNC_SIGN                  2       /**< Asynchronous signature of the server key exchange */
 
 /*
     SSL state machine
@@ -1760,9 +1783,29 @@ struct _ssl_session {
     int length;         /**< session id length  */
     uchar id[32];       /**< session identifier */
     uchar master[48];   /**< the master secret  */
+    int ticket_len;     /**< (client) session ticket length */
+    uchar ticket[SSL_MAX_TICKET_LEN];   /**< (client) session ticket issued by the server */
     ssl_session *next;  /**< next session entry */
 };
 
+/*
+    Session ticket encryption key. The layout matches the common 48 byte ticket key file format.
+ */
+typedef struct {
+    uchar name[16];     /**< key name sent in the clear to select the key */
+    uchar hmac_key[16]; /**< HMAC-SHA256 secret */
+    uchar aes_key[16];  /**< AES-128-CBC key */
+} ssl_ticket_key;
+
+/*
+    Session ticket key ring. The first key is used to issue tickets. Other keys are only used to decrypt tickets.
+ */
+typedef struct {
+    ssl_ticket_key *keys;   /**< array of ticket keys */
+    int count;              /**< number of keys       */
+    int lifetime;           /**< ticket lifetime in seconds */
+} ssl_ticket_keys;
+
 struct _ssl_context {
     /*
         Miscellaneous
@@ -1869,6 +1912,35 @@ struct _ssl_context {
      */
     uchar *hostname;
     ulong hostname_len;
+
+    /*
+        Session tickets (RFC 5077)
+     */
+    int use_tickets;                /**< offer (client) or accept (server) session tickets */
+    ssl_ticket_keys *ticket_keys;   /**< (server) ticket key ring */
+    int ticket_offered;             /**< (server) client supports session tickets */
+    int new_ticket;                 /**< a NewSessionTicket message is pending */
+    int in_ticket_len;              /**< (server) length of the ticket presented by the client */
+    uchar in_ticket[SSL_MAX_TICKET_LEN];    /**< (server) ticket presented by the client */
+
+    /*
+        Application layer protocol negotiation (RFC 7301)
+     */
+    const char *alpn;               /**< (server) comma separated protocols in order of preference */
+    char alpn_chosen[SSL_MAX_ALPN_LEN];     /**< negotiated protocol. Empty if none. */
+
+    /*
+        Asynchronous private key operations
+     */
+    int async;                      /**< (server) return private key operations to the caller */
+    int async_op;                   /**< pending operation: SSL_ASYNC_DECRYPT or SSL_ASYNC_SIGN */
+    int async_done;                 /**< the pending operation has completed */
+    int async_rc;                   /**< result of the completed operation */
+    int async_msglen;               /**< length of the partially written handshake message */
+    int async_in_len;               /**< length of the operation input */
+    int async_out_len;              /**< length of the operation output */
+    uchar async_in[SSL_MAX_RSA_LEN];    /**< operation input */
+    uchar async_out[SSL_MAX_RSA_LEN];   /**< operation output */
 };
 
 #ifdef __cplusplus
@@ -1941,6 +2013,70 @@ extern "C" {
      */
     PUBLIC void ssl_set_scb(ssl_context *ssl, int (*s_get)(ssl_context*), int (*s_set)(ssl_context*));
 
+    /**
+       @brief          Enable session tickets (RFC 5077)
+       @param ssl      SSL context
+       @param enable   if 1, clients offer session tickets and servers with a ticket key ring issue and accept tickets
+     */
+    PUBLIC void ssl_set_tickets(ssl_context *ssl, int enable);
+
+    /**
+       @brief          Set the session ticket key ring (server)
+       @param ssl      SSL context
+       @param keys     ticket key ring. The first key is used to issue new tickets.
+       @note           The key ring must remain valid for the life of the SSL context
+     */
+    PUBLIC void ssl_set_ticket_keys(ssl_context *ssl, ssl_ticket_keys *keys);
+
+    /**
+       @brief          Set the application protocols to negotiate via ALPN (server)
+       @param ssl      SSL context
+       @param protocols comma separated protocol names in order of preference. For example: "h2,http/1.1"
+       @note           The string must remain valid for the life of the SSL context
+     */
+    PUBLIC void ssl_set_alpn(ssl_context *ssl, const char *protocols);
+
+    /**
+       @brief          Return the application protocol negotiated via ALPN
+       @param ssl      SSL context
+       @return         the protocol name or NULL if none was negotiated
+     */
+    PUBLIC const char *ssl_get_alpn(ssl_context *ssl);
+
+    /**
+       @brief          Enable asynchronous private key operations (server)
+       @details        If enabled, ssl_handshake returns EST_ERR_SSL_ASYNC_PENDING instead of performing a private
+                       key operation. The caller runs the operation described by async_op and async_in via 
+                       ssl_async_run, possibly on another thread, then calls ssl_async_complete and resumes the 
+                       handshake.
+       @param ssl      SSL context
+       @param enable   1 to enable, 0 to perform private key operations inline
+     */
+    PUBLIC void ssl_set_async(ssl_context *ssl, int enable);
+
+    /**
+       @brief          Run an asynchronous private key operation
+       @details        This does not access the SSL context and is safe to call from any thread
+       @param rsa      RSA private key
+       @param op       SSL_ASYNC_DECRYPT or SSL_ASYNC_SIGN
+       @param input    operation input
+       @param ilen     length of the input
+       @param output   buffer for the output. Must be at least SSL_MAX_RSA_LEN bytes.
+       @param olen     set to the length of the output
+       @return         0 if successful, or a specific RSA error code
+     */
+    PUBLIC int ssl_async_run(rsa_context *rsa, int op, uchar *input, int ilen, uchar *output, int *olen);
+
+    /**
+       @brief          Supply the result of an asynchronous private key operation
+       @param ssl      SSL context
+       @param rc       result code returned by ssl_async_run
+       @param output   operation output
+       @param olen     length of the output
+       @return         0 if successful, or EST_ERR_SSL_BAD_INPUT_DATA if no operation is pending
+     */
+    PUBLIC int ssl_async_complete(ssl_context *ssl, int rc, uchar *output, int olen);
+
     /**
        @brief          Set the session resuming flag, timeout and data
        @param ssl      SSL context
@@ -2074,6 +2210,9 @@ extern "C" {
     PUBLIC int ssl_parse_finished(ssl_context *ssl);
     PUBLIC int ssl_write_finished(ssl_context *ssl);
 
+    PUBLIC int ssl_parse_ticket(ssl_context *ssl, ssl_session *session, uchar *ticket, int len);
+    PUBLIC int ssl_write_ticket(ssl_context *ssl, uchar *ticket, int *len);
+
 #if EMBEDTHIS || 1
     PUBLIC int *ssl_create_ciphers(cchar *cipherSuite);
 #endif
@@ -2125,6 +2264,7 @@ extern "C" {
  */
 typedef struct {
     int     nr;         /**< number of rounds */
+    int     ni;         /**< round keys are in AES-NI byte format */
     ulong   *rk;        /**< AES round keys */
     ulong   buf[68];    /**<  unaligned data */
 } aes_context;
@@ -2195,6 +2335,288 @@ extern "C" {
 #endif
 #endif
 
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a 
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details and other copyrights.
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
+
+/************************************************************************/
+/*
+    Start of file "src/aesni.h"
+ */
+/************************************************************************/
+
+/*
+    aesni.h -- Intel AES-NI and PCLMULQDQ support
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+#ifndef EST_AESNI_H
+#define EST_AESNI_H
+
+/*
+    The AES-NI code uses compiler intrinsics with per-function target attributes so the library does not need to be
+    compiled with -maes. The instructions are only used if the CPU reports support at runtime.
+ */
+#if BIT_EST_AESNI && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+        (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#ifndef EST_HAVE_AESNI
+#define EST_HAVE_AESNI
+#endif
+
+#define AESNI_AES       0x02000000      /**< CPUID.1:ECX AES instructions */
+#define AESNI_CLMUL     0x00000002      /**< CPUID.1:ECX PCLMULQDQ instruction */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /**
+       @brief          AES-NI detection routine
+       @param what     AESNI_AES or AESNI_CLMUL
+       @return         1 if the CPU supports the feature and it is enabled, 0 otherwise
+     */
+    PUBLIC int aesni_supports(int what);
+
+    /**
+       @brief          Enable or disable use of AES-NI and PCLMULQDQ
+       @details        Contexts keyed after this call use the selected implementation. Used by benchmarks and tests
+                       to compare against the portable table implementation.
+       @param enable   Set to 0 to disable and 1 to enable (the default)
+       @return         The prior setting
+     */
+    PUBLIC int aesni_enable(int enable);
+
+    /**
+       @brief          Convert an AES encryption key schedule to AES-NI format
+       @param ctx      AES context keyed by aes_setkey_enc
+     */
+    PUBLIC void aesni_setkey_enc(aes_context *ctx);
+
+    /**
+       @brief          Create an AES-NI decryption key schedule
+       @param ctx      AES context to be initialized
+       @param enc      AES context holding the AES-NI encryption key schedule
+     */
+    PUBLIC void aesni_setkey_dec(aes_context *ctx, aes_context *enc);
+
+    /**
+       @brief          AES-NI AES-ECB block en(de)cryption
+       @param ctx      AES context
+       @param mode     AES_ENCRYPT or AES_DECRYPT
+       @param input    16-byte input block
+       @param output   16-byte output block
+     */
+    PUBLIC void aesni_crypt_ecb(aes_context *ctx, int mode, uchar input[16], uchar output[16]);
+
+    /**
+       @brief          AES-NI AES-CBC buffer en(de)cryption
+       @param ctx      AES context
+       @param mode     AES_ENCRYPT or AES_DECRYPT
+       @param length   length of the input data
+       @param iv       initialization vector (updated after use)
+       @param input    buffer holding the input data
+       @param output   buffer holding the output data
+     */
+    PUBLIC void aesni_crypt_cbc(aes_context *ctx, int mode, int length, uchar iv[16], uchar *input, uchar *output);
+
+#if BIT_EST_GCM
+    /**
+       @brief          GCM multiplication in GF(2^128) using PCLMULQDQ
+       @param c        Result of a * b
+       @param a        First operand in GCM byte order
+       @param b        Second operand in GCM byte order
+     */
+    PUBLIC void aesni_gcm_mult(uchar c[16], uchar a[16], uchar b[16]);
+
+    /**
+       @brief          GCM counter mode encryption and GHASH of whole blocks
+       @param aes      AES context holding the AES-NI encryption key schedule
+       @param mode     GCM_ENCRYPT or GCM_DECRYPT
+       @param blocks   number of 16-byte blocks to process
+       @param y        counter block (updated after use)
+       @param acc      GHASH accumulator (updated after use)
+       @param h        hash subkey
+       @param input    buffer holding the input data
+       @param output   buffer for the output data
+     */
+    PUBLIC void aesni_gcm_crypt(aes_context *aes, int mode, int blocks, uchar y[16], uchar acc[16], uchar h[16],
+            uchar *input, uchar *output);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif              /* EST_HAVE_AESNI */
+#endif              /* aesni.h */
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a 
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details and other copyrights.
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
+
+/************************************************************************/
+/*
+    Start of file "src/gcm.h"
+ */
+/************************************************************************/
+
+/*
+    gcm.h -- Galois/Counter Mode (NIST SP 800-38D) for AES
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+#ifndef EST_GCM_H
+#define EST_GCM_H
+
+#if BIT_EST_GCM
+
+#define GCM_ENCRYPT     1
+#define GCM_DECRYPT     0
+
+#define EST_ERR_GCM_BAD_INPUT                         -0x0010
+#define EST_ERR_GCM_AUTH_FAILED                       -0x0012
+
+/**
+    @brief GCM context structure
+ */
+typedef struct {
+    aes_context aes;            /**< AES encryption context */
+    uint64  HL[16];             /**< Precalculated low half of the hash subkey table */
+    uint64  HH[16];             /**< Precalculated high half of the hash subkey table */
+    uchar   H[16];              /**< Hash subkey */
+    uchar   base_ectr[16];      /**< Encrypted initial counter block for the tag */
+    uchar   y[16];              /**< Counter block */
+    uchar   buf[16];            /**< GHASH accumulator */
+    uint64  len;                /**< Length of the encrypted data */
+    uint64  add_len;            /**< Length of the additional data */
+    int     mode;               /**< GCM_ENCRYPT or GCM_DECRYPT */
+    int     clmul;              /**< Use PCLMULQDQ for GHASH */
+} gcm_context;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /**
+       @brief          GCM key schedule
+       @param ctx      GCM context to be initialized
+       @param key      encryption key
+       @param keysize  must be 128, 192 or 256
+       @return         0 if successful, or EST_ERR_GCM_BAD_INPUT
+     */
+    PUBLIC int gcm_setkey(gcm_context *ctx, uchar *key, int keysize);
+
+    /**
+       @brief          Start a GCM encryption or decryption operation
+       @param ctx      GCM context
+       @param mode     GCM_ENCRYPT or GCM_DECRYPT
+       @param iv       initialization vector
+       @param iv_len   length of the IV. 12 bytes is recommended.
+       @param add      additional authenticated data
+       @param add_len  length of the additional data
+       @return         0 if successful, or EST_ERR_GCM_BAD_INPUT
+     */
+    PUBLIC int gcm_starts(gcm_context *ctx, int mode, uchar *iv, int iv_len, uchar *add, int add_len);
+
+    /**
+       @brief          Encrypt or decrypt data. 
+       @details        All calls except the last must supply a multiple of 16 bytes.
+       @param ctx      GCM context
+       @param length   length of the input data
+       @param input    buffer holding the input data
+       @param output   buffer for the output data. May be the same as input.
+       @return         0 if successful, or EST_ERR_GCM_BAD_INPUT
+     */
+    PUBLIC int gcm_update(gcm_context *ctx, int length, uchar *input, uchar *output);
+
+    /**
+       @brief          Finish a GCM operation and generate the authentication tag
+       @param ctx      GCM context
+       @param tag      buffer for the tag
+       @param tag_len  length of the tag to generate. Must be between 4 and 16.
+       @return         0 if successful, or EST_ERR_GCM_BAD_INPUT
+     */
+    PUBLIC int gcm_finish(gcm_context *ctx, uchar *tag, int tag_len);
+
+    /**
+       @brief          GCM buffer encryption or decryption with tag generation
+       @param ctx      GCM context
+       @param mode     GCM_ENCRYPT or GCM_DECRYPT
+       @param length   length of the input data
+       @param iv       initialization vector
+       @param iv_len   length of the IV
+       @param add      additional authenticated data
+       @param add_len  length of the additional data
+       @param input    buffer holding the input data
+       @param output   buffer for the output data
+       @param tag_len  length of the tag to generate
+       @param tag      buffer for the tag
+       @return         0 if successful, or EST_ERR_GCM_BAD_INPUT
+     */
+    PUBLIC int gcm_crypt_and_tag(gcm_context *ctx, int mode, int length, uchar *iv, int iv_len, uchar *add, 
+            int add_len, uchar *input, uchar *output, int tag_len, uchar *tag);
+
+    /**
+       @brief          GCM buffer authenticated decryption
+       @details        The output is zeroed if authentication fails.
+       @param ctx      GCM context
+       @param length   length of the input data
+       @param iv       initialization vector
+       @param iv_len   length of the IV
+       @param add      additional authenticated data
+       @param add_len  length of the additional data
+       @param tag      tag to verify
+       @param tag_len  length of the tag
+       @param input    buffer holding the input data
+       @param output   buffer for the output data
+       @return         0 if successful, EST_ERR_GCM_AUTH_FAILED if the tag does not match or EST_ERR_GCM_BAD_INPUT
+     */
+    PUBLIC int gcm_auth_decrypt(gcm_context *ctx, int length, uchar *iv, int iv_len, uchar *add, int add_len, 
+            uchar *tag, int tag_len, uchar *input, uchar *output);
+
+    /**
+       @brief          Clear a GCM context
+       @param ctx      GCM context to clear
+     */
+    PUBLIC void gcm_free(gcm_context *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+#endif              /* BIT_EST_GCM */
+#endif              /* gcm.h */
+
 /*
     @copy   default
 
@@ -450,6 +450,8 @@ void aes_setkey_enc(aes_context * ctx, uchar *key, int keysize)
         return;
     }
 
+    ctx->ni = 0;
+
     //  MOB - don't use defined
 #if defined(PADLOCK_ALIGN16)
     ctx->rk = RK = PADLOCK_ALIGN16(ctx->buf);
@@ -518,6 +520,11 @@ void aes_setkey_enc(aes_context * ctx, uchar *key, int keysize)
     default:
         break;
     }
+#if defined(EST_HAVE_AESNI)
+    if (aesni_supports(AESNI_AES)) {
+        aesni_setkey_enc(ctx);
+    }
+#endif
 }
 
 
@@ -543,7 +550,16 @@ void aes_setkey_dec(aes_context * ctx, uchar *key, int keysize)
     default:
         return;
     }
+    ctx->ni = 0;
 
+#if defined(EST_HAVE_AESNI)
+    if (aesni_supports(AESNI_AES)) {
+        aes_setkey_enc(&cty, key, keysize);
+        aesni_setkey_dec(ctx, &cty);
+        memset(&cty, 0, sizeof(aes_context));
+        return;
+    }
+#endif
     //  MOB - don't use defined
 #if defined(PADLOCK_ALIGN16)
     ctx->rk = RK = PADLOCK_ALIGN16(ctx->buf);
@@ -631,6 +647,12 @@ void aes_crypt_ecb(aes_context * ctx, int mode, uchar input[16], uchar output[16
     int     i;
     ulong   *RK, X0, X1, X2, X3, Y0, Y1, Y2, Y3;
 
+#if defined(EST_HAVE_AESNI)
+    if (ctx->ni) {
+        aesni_crypt_ecb(ctx, mode, input, output);
+        return;
+    }
+#endif
 //  MOB - don't use EST_HAVE_X86
 #if BIT_EST_PADLOCK && defined(EST_HAVE_X86)
     if (padlock_supports(PADLOCK_ACE)) {
@@ -724,6 +746,12 @@ void aes_crypt_cbc(aes_context *ctx, int mode, int length, uchar iv[16], uchar *
     int     i;
     uchar   temp[16];
 
+#if defined(EST_HAVE_AESNI)
+    if (ctx->ni) {
+        aesni_crypt_cbc(ctx, mode, length, iv, input, output);
+        return;
+    }
+#endif
 #if BIT_EST_PADLOCK && defined(EST_HAVE_X86)
     if (padlock_supports(PADLOCK_ACE)) {
         if (padlock_xcryptcbc(ctx, mode, length, iv, input, output) == 0)
@@ -800,6 +828,346 @@ void aes_crypt_cfb128(aes_context *ctx, int mode, int length, int *iv_off, uchar
 
 #endif
 
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a 
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details and other copyrights.
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
+
+/************************************************************************/
+/*
+    Start of file "src/aesni.c"
+ */
+/************************************************************************/
+
+/*
+    aesni.c -- AES-NI and PCLMULQDQ support for x86 processors
+
+    http://software.intel.com/sites/default/files/article/165683/aes-wp-2012-09-22-v01.pdf
+    http://software.intel.com/sites/default/files/article/165685/clmul-wp-rev-2.02-2014-04-20.pdf
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+
+#if defined(EST_HAVE_AESNI)
+
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+
+#define AESNI_TARGET __attribute__((target("aes,pclmul,sse2,ssse3")))
+
+static int aesni_flags = -1;
+static int aesni_enabled = 1;
+
+/*
+    AES-NI detection routine
+ */
+int aesni_supports(int what)
+{
+    uint    eax, ebx, ecx, edx;
+
+    if (aesni_flags == -1) {
+        aesni_flags = __get_cpuid(1, &eax, &ebx, &ecx, &edx) ? (int) ecx : 0;
+    }
+    return aesni_enabled && (aesni_flags & what) ? 1 : 0;
+}
+
+
+int aesni_enable(int enable)
+{
+    int     prior;
+
+    prior = aesni_enabled;
+    aesni_enabled = enable;
+    return prior;
+}
+
+
+/*
+    Convert the portable key schedule into the byte order expected by the AES instructions
+ */
+void aesni_setkey_enc(aes_context *ctx)
+{
+    uchar   keys[240];
+    int     i;
+
+    for (i = 0; i < (ctx->nr + 1) * 4; i++) {
+        keys[i * 4] = (uchar) (ctx->rk[i]);
+        keys[i * 4 + 1] = (uchar) (ctx->rk[i] >> 8);
+        keys[i * 4 + 2] = (uchar) (ctx->rk[i] >> 16);
+        keys[i * 4 + 3] = (uchar) (ctx->rk[i] >> 24);
+    }
+    ctx->rk = ctx->buf;
+    memcpy(ctx->rk, keys, (ctx->nr + 1) * 16);
+    memset(keys, 0, sizeof(keys));
+    ctx->ni = 1;
+}
+
+
+/*
+    The decryption schedule is the encryption schedule reversed with InvMixColumns applied to the inner round keys
+ */
+AESNI_TARGET void aesni_setkey_dec(aes_context *ctx, aes_context *enc)
+{
+    __m128i     *ek, *dk;
+    int         i, nr;
+
+    nr = enc->nr;
+    ek = (__m128i*) enc->rk;
+    dk = (__m128i*) ctx->buf;
+    _mm_storeu_si128(&dk[0], _mm_loadu_si128(&ek[nr]));
+    for (i = 1; i < nr; i++) {
+        _mm_storeu_si128(&dk[i], _mm_aesimc_si128(_mm_loadu_si128(&ek[nr - i])));
+    }
+    _mm_storeu_si128(&dk[nr], _mm_loadu_si128(&ek[0]));
+    ctx->nr = nr;
+    ctx->rk = ctx->buf;
+    ctx->ni = 1;
+}
+
+
+/*
+    AES-NI AES-ECB block en(de)cryption
+ */
+AESNI_TARGET void aesni_crypt_ecb(aes_context *ctx, int mode, uchar input[16], uchar output[16])
+{
+    __m128i     *rk, b;
+    int         i, nr;
+
+    rk = (__m128i*) ctx->rk;
+    nr = ctx->nr;
+    b = _mm_xor_si128(_mm_loadu_si128((__m128i*) input), _mm_loadu_si128(&rk[0]));
+    if (mode == AES_DECRYPT) {
+        for (i = 1; i < nr; i++) {
+            b = _mm_aesdec_si128(b, _mm_loadu_si128(&rk[i]));
+        }
+        b = _mm_aesdeclast_si128(b, _mm_loadu_si128(&rk[nr]));
+    } else {
+        for (i = 1; i < nr; i++) {
+            b = _mm_aesenc_si128(b, _mm_loadu_si128(&rk[i]));
+        }
+        b = _mm_aesenclast_si128(b, _mm_loadu_si128(&rk[nr]));
+    }
+    _mm_storeu_si128((__m128i*) output, b);
+}
+
+
+/*
+    AES-NI AES-CBC buffer en(de)cryption. Encryption is inherently serial. Decryption processes four blocks at a 
+    time to hide the latency of the AES instructions.
+ */
+AESNI_TARGET void aesni_crypt_cbc(aes_context *ctx, int mode, int length, uchar iv[16], uchar *input, uchar *output)
+{
+    __m128i     rk[15], b, b0, b1, b2, b3, c0, c1, c2, c3, prior;
+    int         i, nr;
+
+    nr = ctx->nr;
+    for (i = 0; i <= nr; i++) {
+        rk[i] = _mm_loadu_si128(&((__m128i*) ctx->rk)[i]);
+    }
+    prior = _mm_loadu_si128((__m128i*) iv);
+
+    if (mode == AES_DECRYPT) {
+        for (; length >= 64; length -= 64, input += 64, output += 64) {
+            c0 = _mm_loadu_si128((__m128i*) input);
+            c1 = _mm_loadu_si128((__m128i*) (input + 16));
+            c2 = _mm_loadu_si128((__m128i*) (input + 32));
+            c3 = _mm_loadu_si128((__m128i*) (input + 48));
+            b0 = _mm_xor_si128(c0, rk[0]);
+            b1 = _mm_xor_si128(c1, rk[0]);
+            b2 = _mm_xor_si128(c2, rk[0]);
+            b3 = _mm_xor_si128(c3, rk[0]);
+            for (i = 1; i < nr; i++) {
+                b0 = _mm_aesdec_si128(b0, rk[i]);
+                b1 = _mm_aesdec_si128(b1, rk[i]);
+                b2 = _mm_aesdec_si128(b2, rk[i]);
+                b3 = _mm_aesdec_si128(b3, rk[i]);
+            }
+            b0 = _mm_aesdeclast_si128(b0, rk[nr]);
+            b1 = _mm_aesdeclast_si128(b1, rk[nr]);
+            b2 = _mm_aesdeclast_si128(b2, rk[nr]);
+            b3 = _mm_aesdeclast_si128(b3, rk[nr]);
+            _mm_storeu_si128((__m128i*) output, _mm_xor_si128(b0, prior));
+            _mm_storeu_si128((__m128i*) (output + 16), _mm_xor_si128(b1, c0));
+            _mm_storeu_si128((__m128i*) (output + 32), _mm_xor_si128(b2, c1));
+            _mm_storeu_si128((__m128i*) (output + 48), _mm_xor_si128(b3, c2));
+            prior = c3;
+        }
+        for (; length > 0; length -= 16, input += 16, output += 16) {
+            c0 = _mm_loadu_si128((__m128i*) input);
+            b = _mm_xor_si128(c0, rk[0]);
+            for (i = 1; i < nr; i++) {
+                b = _mm_aesdec_si128(b, rk[i]);
+            }
+            b = _mm_aesdeclast_si128(b, rk[nr]);
+            _mm_storeu_si128((__m128i*) output, _mm_xor_si128(b, prior));
+            prior = c0;
+        }
+    } else {
+        for (; length > 0; length -= 16, input += 16, output += 16) {
+            b = _mm_xor_si128(_mm_loadu_si128((__m128i*) input), prior);
+            b = _mm_xor_si128(b, rk[0]);
+            for (i = 1; i < nr; i++) {
+                b = _mm_aesenc_si128(b, rk[i]);
+            }
+            prior = _mm_aesenclast_si128(b, rk[nr]);
+            _mm_storeu_si128((__m128i*) output, prior);
+        }
+    }
+    _mm_storeu_si128((__m128i*) iv, prior);
+}
+
+
+#if BIT_EST_GCM
+/*
+    GCM multiplication using carry-less multiply on byte swapped operands. GCM uses a bit-reflected representation,
+    so the product is shifted left by one bit and then reduced modulo x^128 + x^7 + x^2 + x + 1. 
+    See algorithm 1 and figure 5 of the Intel carry-less multiplication white paper.
+ */
+static AESNI_TARGET __m128i gfmul(__m128i x, __m128i y)
+{
+    __m128i     t2, t3, t4, t5, t6, t7, t8, t9;
+
+    /*
+        Schoolbook 128 x 128 bit carry-less multiply into t6:t3
+     */
+    t3 = _mm_clmulepi64_si128(x, y, 0x00);
+    t4 = _mm_clmulepi64_si128(x, y, 0x10);
+    t5 = _mm_clmulepi64_si128(x, y, 0x01);
+    t6 = _mm_clmulepi64_si128(x, y, 0x11);
+    t4 = _mm_xor_si128(t4, t5);
+    t5 = _mm_slli_si128(t4, 8);
+    t4 = _mm_srli_si128(t4, 8);
+    t3 = _mm_xor_si128(t3, t5);
+    t6 = _mm_xor_si128(t6, t4);
+
+    /*
+        Shift the 256 bit product left by one bit for the reflected representation
+     */
+    t7 = _mm_srli_epi32(t3, 31);
+    t8 = _mm_srli_epi32(t6, 31);
+    t3 = _mm_slli_epi32(t3, 1);
+    t6 = _mm_slli_epi32(t6, 1);
+    t9 = _mm_srli_si128(t7, 12);
+    t8 = _mm_slli_si128(t8, 4);
+    t7 = _mm_slli_si128(t7, 4);
+    t3 = _mm_or_si128(t3, t7);
+    t6 = _mm_or_si128(t6, t8);
+    t6 = _mm_or_si128(t6, t9);
+
+    /*
+        Reduce modulo the GCM polynomial
+     */
+    t7 = _mm_slli_epi32(t3, 31);
+    t8 = _mm_slli_epi32(t3, 30);
+    t9 = _mm_slli_epi32(t3, 25);
+    t7 = _mm_xor_si128(t7, t8);
+    t7 = _mm_xor_si128(t7, t9);
+    t8 = _mm_srli_si128(t7, 4);
+    t7 = _mm_slli_si128(t7, 12);
+    t3 = _mm_xor_si128(t3, t7);
+    t2 = _mm_srli_epi32(t3, 1);
+    t4 = _mm_srli_epi32(t3, 2);
+    t5 = _mm_srli_epi32(t3, 7);
+    t2 = _mm_xor_si128(t2, t4);
+    t2 = _mm_xor_si128(t2, t5);
+    t2 = _mm_xor_si128(t2, t8);
+    t3 = _mm_xor_si128(t3, t2);
+    return _mm_xor_si128(t6, t3);
+}
+
+
+AESNI_TARGET void aesni_gcm_mult(uchar c[16], uchar a[16], uchar b[16])
+{
+    __m128i     swap, x, y;
+
+    swap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    x = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*) a), swap);
+    y = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*) b), swap);
+    _mm_storeu_si128((__m128i*) c, _mm_shuffle_epi8(gfmul(x, y), swap));
+}
+
+
+/*
+    Set a 32-bit big endian counter block
+ */
+static void aesni_set_counter(uchar *block, uchar y[16], uint counter)
+{
+    memcpy(block, y, 12);
+    block[12] = (uchar) (counter >> 24);
+    block[13] = (uchar) (counter >> 16);
+    block[14] = (uchar) (counter >> 8);
+    block[15] = (uchar) counter;
+}
+
+
+/*
+    Fused GCM counter mode encryption and GHASH for whole blocks. Four counter blocks are encrypted at a time to
+    hide the latency of the AES instructions.
+ */
+AESNI_TARGET void aesni_gcm_crypt(aes_context *aes, int mode, int blocks, uchar y[16], uchar acc[16], uchar h[16],
+        uchar *input, uchar *output)
+{
+    __m128i     rk[15], swap, hh, x, b[4], in, out;
+    uchar       ctr[64];
+    uint        counter;
+    int         i, j, n, nr;
+
+    nr = aes->nr;
+    for (i = 0; i <= nr; i++) {
+        rk[i] = _mm_loadu_si128(&((__m128i*) aes->rk)[i]);
+    }
+    swap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    hh = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*) h), swap);
+    x = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*) acc), swap);
+    counter = ((uint) y[12] << 24) | ((uint) y[13] << 16) | ((uint) y[14] << 8) | y[15];
+
+    while (blocks > 0) {
+        n = min(blocks, 4);
+        for (j = 0; j < n; j++) {
+            aesni_set_counter(&ctr[j * 16], y, ++counter);
+            b[j] = _mm_xor_si128(_mm_loadu_si128((__m128i*) &ctr[j * 16]), rk[0]);
+        }
+        for (i = 1; i < nr; i++) {
+            for (j = 0; j < n; j++) {
+                b[j] = _mm_aesenc_si128(b[j], rk[i]);
+            }
+        }
+        for (j = 0; j < n; j++) {
+            b[j] = _mm_aesenclast_si128(b[j], rk[nr]);
+            in = _mm_loadu_si128((__m128i*) input);
+            out = _mm_xor_si128(b[j], in);
+            _mm_storeu_si128((__m128i*) output, out);
+            x = gfmul(_mm_xor_si128(x, _mm_shuffle_epi8(mode == GCM_DECRYPT ? in : out, swap)), hh);
+            input += 16;
+            output += 16;
+        }
+        blocks -= n;
+    }
+    aesni_set_counter(y, y, counter);
+    _mm_storeu_si128((__m128i*) acc, _mm_shuffle_epi8(x, swap));
+}
+#endif /* BIT_EST_GCM */
+
+#endif /* EST_HAVE_AESNI */
+
 /*
     @copy   default
 
@@ -4742,111 +5110,479 @@ void dhm_free(dhm_context * ctx)
 
 /************************************************************************/
 /*
-    Start of file "src/havege.c"
+    Start of file "src/gcm.c"
  */
 /************************************************************************/
 
 /*
-    havege.c -- Hardware Volatile Entropy Gathering and Expansion
+    gcm.c -- Galois/Counter Mode for AES
 
-    The HAVEGE RNG was designed by Andre Seznec in 2002.
-    http://www.irisa.fr/caps/projects/hipsor/publi.php
+    http://csrc.nist.gov/publications/nistpubs/800-38D/SP-800-38D.pdf
+    http://csrc.nist.gov/groups/ST/toolkit/BCM/documents/proposedmodes/gcm/gcm-revised-spec.pdf
+
+    GHASH uses PCLMULQDQ when available, otherwise Shoup's 4-bit table method.
 
     Copyright (c) All Rights Reserved. See details at the end of the file.
  */
 
 
-#if BIT_EST_HAVEGE
+#if BIT_EST_GCM
 
-/* Undefine for windows */
-#undef IN
+/*
+    32-bit integer manipulation macros (big endian)
+ */
+#ifndef GET_ULONG_BE
+#define GET_ULONG_BE(n,b,i)                     \
+{                                               \
+    (n) = ( (ulong) (b)[(i)    ] << 24 )        \
+        | ( (ulong) (b)[(i) + 1] << 16 )        \
+        | ( (ulong) (b)[(i) + 2] <<  8 )        \
+        | ( (ulong) (b)[(i) + 3]       );       \
+}
+#endif
+
+#ifndef PUT_ULONG_BE
+#define PUT_ULONG_BE(n,b,i)                     \
+{                                               \
+    (b)[(i)    ] = (uchar) ( (n) >> 24 );       \
+    (b)[(i) + 1] = (uchar) ( (n) >> 16 );       \
+    (b)[(i) + 2] = (uchar) ( (n) >>  8 );       \
+    (b)[(i) + 3] = (uchar) ( (n)       );       \
+}
+#endif
 
 /*
-   On average, one iteration accesses two 8-word blocks in the havege WALK table, and generates 16 words in the RES array.
-  
-   The data read in the WALK table is updated and permuted after each use. The result of the hardware clock counter read is
-   used for this update.
-  
-   25 conditional tests are present. The conditional tests are grouped in two nested groups of 12 conditional tests and 1
-   test that controls the permutation; on average, there should be 6 tests executed and 3 of them should be mispredicted.
+    Reduction constants for the 4-bit table method
  */
+static const uint64 gcm_last4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
 
-#define SWAP(X,Y) { int *T = X; X = Y; Y = T; }
 
-#define TST1_ENTER if( PTEST & 1 ) { PTEST ^= 3; PTEST >>= 1;
-#define TST2_ENTER if( PTEST & 1 ) { PTEST ^= 3; PTEST >>= 1;
+/*
+    Precompute multiples of the hash subkey H for the 4-bit table method
+ */
+static void gcm_gen_table(gcm_context *ctx)
+{
+    uint64      hi, lo, vh, vl, *HiH, *HiL;
+    ulong       t;
+    int         i, j;
 
-#define TST1_LEAVE U1++; }
-#define TST2_LEAVE U2++; }
+    GET_ULONG_BE(t, ctx->H, 0);
+    hi = t;
+    GET_ULONG_BE(t, ctx->H, 4);
+    lo = t;
+    vh = (hi << 32) | lo;
 
-#define ONE_ITERATION                                   \
-                                                        \
-    PTEST = PT1 >> 20;                                  \
-                                                        \
-    TST1_ENTER  TST1_ENTER  TST1_ENTER  TST1_ENTER      \
-    TST1_ENTER  TST1_ENTER  TST1_ENTER  TST1_ENTER      \
-    TST1_ENTER  TST1_ENTER  TST1_ENTER  TST1_ENTER      \
-                                                        \
-    TST1_LEAVE  TST1_LEAVE  TST1_LEAVE  TST1_LEAVE      \
-    TST1_LEAVE  TST1_LEAVE  TST1_LEAVE  TST1_LEAVE      \
-    TST1_LEAVE  TST1_LEAVE  TST1_LEAVE  TST1_LEAVE      \
-                                                        \
-    PTX = (PT1 >> 18) & 7;                              \
-    PT1 &= 0x1FFF;                                      \
-    PT2 &= 0x1FFF;                                      \
-    CLK = (int) hardclock();                            \
-                                                        \
-    i = 0;                                              \
-    A = &WALK[PT1    ]; RES[i++] ^= *A;                 \
-    B = &WALK[PT2    ]; RES[i++] ^= *B;                 \
-    C = &WALK[PT1 ^ 1]; RES[i++] ^= *C;                 \
-    D = &WALK[PT2 ^ 4]; RES[i++] ^= *D;                 \
-                                                        \
-    IN = (*A >> (1)) ^ (*A << (31)) ^ CLK;              \
-    *A = (*B >> (2)) ^ (*B << (30)) ^ CLK;              \
-    *B = IN ^ U1;                                       \
-    *C = (*C >> (3)) ^ (*C << (29)) ^ CLK;              \
-    *D = (*D >> (4)) ^ (*D << (28)) ^ CLK;              \
-                                                        \
-    A = &WALK[PT1 ^ 2]; RES[i++] ^= *A;                 \
-    B = &WALK[PT2 ^ 2]; RES[i++] ^= *B;                 \
-    C = &WALK[PT1 ^ 3]; RES[i++] ^= *C;                 \
-    D = &WALK[PT2 ^ 6]; RES[i++] ^= *D;                 \
-                                                        \
-    if( PTEST & 1 ) SWAP( A, C );                       \
-                                                        \
-    IN = (*A >> (5)) ^ (*A << (27)) ^ CLK;              \
-    *A = (*B >> (6)) ^ (*B << (26)) ^ CLK;              \
-    *B = IN; CLK = (int) hardclock();                   \
-    *C = (*C >> (7)) ^ (*C << (25)) ^ CLK;              \
-    *D = (*D >> (8)) ^ (*D << (24)) ^ CLK;              \
-                                                        \
-    A = &WALK[PT1 ^ 4];                                 \
-    B = &WALK[PT2 ^ 1];                                 \
-                                                        \
-    PTEST = PT2 >> 1;                                   \
-                                                        \
-    PT2 = (RES[(i - 8) ^ PTY] ^ WALK[PT2 ^ PTY ^ 7]);   \
-    PT2 = ((PT2 & 0x1FFF) & (~8)) ^ ((PT1 ^ 8) & 0x8);  \
-    PTY = (PT2 >> 10) & 7;                              \
-                                                        \
-    TST2_ENTER  TST2_ENTER  TST2_ENTER  TST2_ENTER      \
-    TST2_ENTER  TST2_ENTER  TST2_ENTER  TST2_ENTER      \
-    TST2_ENTER  TST2_ENTER  TST2_ENTER  TST2_ENTER      \
-                                                        \
-    TST2_LEAVE  TST2_LEAVE  TST2_LEAVE  TST2_LEAVE      \
-    TST2_LEAVE  TST2_LEAVE  TST2_LEAVE  TST2_LEAVE      \
-    TST2_LEAVE  TST2_LEAVE  TST2_LEAVE  TST2_LEAVE      \
-                                                        \
-    C = &WALK[PT1 ^ 5];                                 \
-    D = &WALK[PT2 ^ 5];                                 \
-                                                        \
-    RES[i++] ^= *A;                                     \
-    RES[i++] ^= *B;                                     \
-    RES[i++] ^= *C;                                     \
-    RES[i++] ^= *D;                                     \
-                                                        \
-    IN = (*A >> ( 9)) ^ (*A << (23)) ^ CLK;             \
+    GET_ULONG_BE(t, ctx->H, 8);
+    hi = t;
+    GET_ULONG_BE(t, ctx->H, 12);
+    lo = t;
+    vl = (hi << 32) | lo;
+
+    ctx->HL[8] = vl;
+    ctx->HH[8] = vh;
+    ctx->HH[0] = 0;
+    ctx->HL[0] = 0;
+
+    for (i = 4; i > 0; i >>= 1) {
+        t = (ulong) (vl & 1) * 0xe1000000U;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ ((uint64) t << 32);
+        ctx->HL[i] = vl;
+        ctx->HH[i] = vh;
+    }
+    for (i = 2; i < 16; i <<= 1) {
+        HiL = ctx->HL + i;
+        HiH = ctx->HH + i;
+        vh = *HiH;
+        vl = *HiL;
+        for (j = 1; j < i; j++) {
+            HiH[j] = vh ^ ctx->HH[j];
+            HiL[j] = vl ^ ctx->HL[j];
+        }
+    }
+}
+
+
+/*
+    Multiply x by H in GF(2^128)
+ */
+static void gcm_mult(gcm_context *ctx, uchar x[16], uchar output[16])
+{
+    uint64      zh, zl;
+    uchar       lo, hi, rem;
+    int         i;
+
+#if defined(EST_HAVE_AESNI)
+    if (ctx->clmul) {
+        aesni_gcm_mult(output, x, ctx->H);
+        return;
+    }
+#endif
+    lo = x[15] & 0xf;
+    zh = ctx->HH[lo];
+    zl = ctx->HL[lo];
+
+    for (i = 15; i >= 0; i--) {
+        lo = x[i] & 0xf;
+        hi = (x[i] >> 4) & 0xf;
+        if (i != 15) {
+            rem = (uchar) zl & 0xf;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4);
+            zh ^= gcm_last4[rem] << 48;
+            zh ^= ctx->HH[lo];
+            zl ^= ctx->HL[lo];
+        }
+        rem = (uchar) zl & 0xf;
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4);
+        zh ^= gcm_last4[rem] << 48;
+        zh ^= ctx->HH[hi];
+        zl ^= ctx->HL[hi];
+    }
+    PUT_ULONG_BE((ulong) (zh >> 32), output, 0);
+    PUT_ULONG_BE((ulong) zh, output, 4);
+    PUT_ULONG_BE((ulong) (zl >> 32), output, 8);
+    PUT_ULONG_BE((ulong) zl, output, 12);
+}
+
+
+int gcm_setkey(gcm_context *ctx, uchar *key, int keysize)
+{
+    if (keysize != 128 && keysize != 192 && keysize != 256) {
+        return EST_ERR_GCM_BAD_INPUT;
+    }
+    memset(ctx, 0, sizeof(gcm_context));
+    aes_setkey_enc(&ctx->aes, key, keysize);
+    aes_crypt_ecb(&ctx->aes, AES_ENCRYPT, ctx->H, ctx->H);
+#if defined(EST_HAVE_AESNI)
+    ctx->clmul = aesni_supports(AESNI_CLMUL);
+#endif
+    if (!ctx->clmul) {
+        gcm_gen_table(ctx);
+    }
+    return 0;
+}
+
+
+int gcm_starts(gcm_context *ctx, int mode, uchar *iv, int iv_len, uchar *add, int add_len)
+{
+    uchar   work[16], *p;
+    int     i, n;
+
+    if (iv_len <= 0 || add_len < 0 || (add_len > 0 && add == 0)) {
+        return EST_ERR_GCM_BAD_INPUT;
+    }
+    memset(ctx->y, 0, sizeof(ctx->y));
+    memset(ctx->buf, 0, sizeof(ctx->buf));
+    ctx->mode = mode;
+    ctx->len = 0;
+    ctx->add_len = 0;
+
+    if (iv_len == 12) {
+        memcpy(ctx->y, iv, iv_len);
+        ctx->y[15] = 1;
+    } else {
+        /*
+            Other IV lengths are hashed to form the initial counter block
+         */
+        for (p = iv, n = iv_len; n > 0; n -= 16, p += 16) {
+            for (i = 0; i < min(n, 16); i++) {
+                ctx->y[i] ^= p[i];
+            }
+            gcm_mult(ctx, ctx->y, ctx->y);
+        }
+        memset(work, 0, sizeof(work));
+        PUT_ULONG_BE((ulong) iv_len * 8, work, 12);
+        for (i = 0; i < 16; i++) {
+            ctx->y[i] ^= work[i];
+        }
+        gcm_mult(ctx, ctx->y, ctx->y);
+    }
+    aes_crypt_ecb(&ctx->aes, AES_ENCRYPT, ctx->y, ctx->base_ectr);
+
+    ctx->add_len = add_len;
+    for (p = add, n = add_len; n > 0; n -= 16, p += 16) {
+        for (i = 0; i < min(n, 16); i++) {
+            ctx->buf[i] ^= p[i];
+        }
+        gcm_mult(ctx, ctx->buf, ctx->buf);
+    }
+    return 0;
+}
+
+
+int gcm_update(gcm_context *ctx, int length, uchar *input, uchar *output)
+{
+    uint64  ectr64[2], in[2], out[2], acc[2];
+    uchar   *ectr;
+    int     i, n;
+
+    if (length < 0 || (ctx->len & 0xf)) {
+        return EST_ERR_GCM_BAD_INPUT;
+    }
+    ctx->len += length;
+    ectr = (uchar*) ectr64;
+#if defined(EST_HAVE_AESNI)
+    if (ctx->clmul && ctx->aes.ni && length >= 16) {
+        n = length / 16;
+        aesni_gcm_crypt(&ctx->aes, ctx->mode, n, ctx->y, ctx->buf, ctx->H, input, output);
+        input += n * 16;
+        output += n * 16;
+        length -= n * 16;
+    }
+#endif
+    for (; length > 0; length -= 16, input += 16, output += 16) {
+        n = min(length, 16);
+
+        /*
+            Increment the 32-bit big endian counter
+         */
+        for (i = 16; i > 12; i--) {
+            if (++ctx->y[i - 1] != 0) {
+                break;
+            }
+        }
+        aes_crypt_ecb(&ctx->aes, AES_ENCRYPT, ctx->y, ectr);
+        if (n == 16) {
+            /*
+                Whole blocks are processed a word at a time
+             */
+            memcpy(in, input, 16);
+            memcpy(acc, ctx->buf, 16);
+            out[0] = ectr64[0] ^ in[0];
+            out[1] = ectr64[1] ^ in[1];
+            memcpy(output, out, 16);
+            if (ctx->mode == GCM_DECRYPT) {
+                acc[0] ^= in[0];
+                acc[1] ^= in[1];
+            } else {
+                acc[0] ^= out[0];
+                acc[1] ^= out[1];
+            }
+            memcpy(ctx->buf, acc, 16);
+        } else if (ctx->mode == GCM_DECRYPT) {
+            for (i = 0; i < n; i++) {
+                ctx->buf[i] ^= input[i];
+                output[i] = ectr[i] ^ input[i];
+            }
+        } else {
+            for (i = 0; i < n; i++) {
+                output[i] = ectr[i] ^ input[i];
+                ctx->buf[i] ^= output[i];
+            }
+        }
+        gcm_mult(ctx, ctx->buf, ctx->buf);
+    }
+    return 0;
+}
+
+
+int gcm_finish(gcm_context *ctx, uchar *tag, int tag_len)
+{
+    uchar   work[16];
+    uint64  abits, cbits;
+    int     i;
+
+    if (tag_len < 4 || tag_len > 16) {
+        return EST_ERR_GCM_BAD_INPUT;
+    }
+    memcpy(tag, ctx->base_ectr, tag_len);
+    abits = ctx->add_len * 8;
+    cbits = ctx->len * 8;
+    if (abits || cbits) {
+        PUT_ULONG_BE((ulong) (abits >> 32), work, 0);
+        PUT_ULONG_BE((ulong) abits, work, 4);
+        PUT_ULONG_BE((ulong) (cbits >> 32), work, 8);
+        PUT_ULONG_BE((ulong) cbits, work, 12);
+        for (i = 0; i < 16; i++) {
+            ctx->buf[i] ^= work[i];
+        }
+        gcm_mult(ctx, ctx->buf, ctx->buf);
+        for (i = 0; i < tag_len; i++) {
+            tag[i] ^= ctx->buf[i];
+        }
+    }
+    return 0;
+}
+
+
+int gcm_crypt_and_tag(gcm_context *ctx, int mode, int length, uchar *iv, int iv_len, uchar *add, int add_len,
+        uchar *input, uchar *output, int tag_len, uchar *tag)
+{
+    int     rc;
+
+    if ((rc = gcm_starts(ctx, mode, iv, iv_len, add, add_len)) != 0) {
+        return rc;
+    }
+    if ((rc = gcm_update(ctx, length, input, output)) != 0) {
+        return rc;
+    }
+    return gcm_finish(ctx, tag, tag_len);
+}
+
+
+int gcm_auth_decrypt(gcm_context *ctx, int length, uchar *iv, int iv_len, uchar *add, int add_len, uchar *tag, 
+        int tag_len, uchar *input, uchar *output)
+{
+    uchar   check[16];
+    int     i, diff, rc;
+
+    if ((rc = gcm_crypt_and_tag(ctx, GCM_DECRYPT, length, iv, iv_len, add, add_len, input, output, tag_len, 
+            check)) != 0) {
+        return rc;
+    }
+    /*
+        Compare in constant time
+     */
+    for (diff = 0, i = 0; i < tag_len; i++) {
+        diff |= tag[i] ^ check[i];
+    }
+    if (diff != 0) {
+        memset(output, 0, length);
+        return EST_ERR_GCM_AUTH_FAILED;
+    }
+    return 0;
+}
+
+
+void gcm_free(gcm_context *ctx)
+{
+    memset(ctx, 0, sizeof(gcm_context));
+}
+
+#endif /* BIT_EST_GCM */
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a 
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details and other copyrights.
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
+
+/************************************************************************/
+/*
+    Start of file "src/havege.c"
+ */
+/************************************************************************/
+
+/*
+    havege.c -- Hardware Volatile Entropy Gathering and Expansion
+
+    The HAVEGE RNG was designed by Andre Seznec in 2002.
+    http://www.irisa.fr/caps/projects/hipsor/publi.php
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+
+#if BIT_EST_HAVEGE
+
+/* Undefine for windows */
+#undef IN
+
+/*
+   On average, one iteration accesses two 8-word blocks in the havege WALK table, and generates 16 words in the RES array.
+  
+   The data read in the WALK table is updated and permuted after each use. The result of the hardware clock counter read is
+   used for this update.
+  
+   25 conditional tests are present. The conditional tests are grouped in two nested groups of 12 conditional tests and 1
+   test that controls the permutation; on average, there should be 6 tests executed and 3 of them should be mispredicted.
+ */
+
+#define SWAP(X,Y) { int *T = X; X = Y; Y = T; }
+
+#define TST1_ENTER if( PTEST & 1 ) { PTEST ^= 3; PTEST >>= 1;
+#define TST2_ENTER if( PTEST & 1 ) { PTEST ^= 3; PTEST >>= 1;
+
+#define TST1_LEAVE U1++; }
+#define TST2_LEAVE U2++; }
+
+#define ONE_ITERATION                                   \
+                                                        \
+    PTEST = PT1 >> 20;                                  \
+                                                        \
+    TST1_ENTER  TST1_ENTER  TST1_ENTER  TST1_ENTER      \
+    TST1_ENTER  TST1_ENTER  TST1_ENTER  TST1_ENTER      \
+    TST1_ENTER  TST1_ENTER  TST1_ENTER  TST1_ENTER      \
+                                                        \
+    TST1_LEAVE  TST1_LEAVE  TST1_LEAVE  TST1_LEAVE      \
+    TST1_LEAVE  TST1_LEAVE  TST1_LEAVE  TST1_LEAVE      \
+    TST1_LEAVE  TST1_LEAVE  TST1_LEAVE  TST1_LEAVE      \
+                                                        \
+    PTX = (PT1 >> 18) & 7;                              \
+    PT1 &= 0x1FFF;                                      \
+    PT2 &= 0x1FFF;                                      \
+    CLK = (int) hardclock();                            \
+                                                        \
+    i = 0;                                              \
+    A = &WALK[PT1    ]; RES[i++] ^= *A;                 \
+    B = &WALK[PT2    ]; RES[i++] ^= *B;                 \
+    C = &WALK[PT1 ^ 1]; RES[i++] ^= *C;                 \
+    D = &WALK[PT2 ^ 4]; RES[i++] ^= *D;                 \
+                                                        \
+    IN = (*A >> (1)) ^ (*A << (31)) ^ CLK;              \
+    *A = (*B >> (2)) ^ (*B << (30)) ^ CLK;              \
+    *B = IN ^ U1;                                       \
+    *C = (*C >> (3)) ^ (*C << (29)) ^ CLK;              \
+    *D = (*D >> (4)) ^ (*D << (28)) ^ CLK;              \
+                                                        \
+    A = &WALK[PT1 ^ 2]; RES[i++] ^= *A;                 \
+    B = &WALK[PT2 ^ 2]; RES[i++] ^= *B;                 \
+    C = &WALK[PT1 ^ 3]; RES[i++] ^= *C;                 \
+    D = &WALK[PT2 ^ 6]; RES[i++] ^= *D;                 \
+                                                        \
+    if( PTEST & 1 ) SWAP( A, C );                       \
+                                                        \
+    IN = (*A >> (5)) ^ (*A << (27)) ^ CLK;              \
+    *A = (*B >> (6)) ^ (*B << (26)) ^ CLK;              \
+    *B = IN; CLK = (int) hardclock();                   \
+    *C = (*C >> (7)) ^ (*C << (25)) ^ CLK;              \
+    *D = (*D >> (8)) ^ (*D << (24)) ^ CLK;              \
+                                                        \
+    A = &WALK[PT1 ^ 4];                                 \
+    B = &WALK[PT2 ^ 1];                                 \
+                                                        \
+    PTEST = PT2 >> 1;                                   \
+                                                        \
+    PT2 = (RES[(i - 8) ^ PTY] ^ WALK[PT2 ^ PTY ^ 7]);   \
+    PT2 = ((PT2 & 0x1FFF) & (~8)) ^ ((PT1 ^ 8) & 0x8);  \
+    PTY = (PT2 >> 10) & 7;                              \
+                                                        \
+    TST2_ENTER  TST2_ENTER  TST2_ENTER  TST2_ENTER      \
+    TST2_ENTER  TST2_ENTER  TST2_ENTER  TST2_ENTER      \
+    TST2_ENTER  TST2_ENTER  TST2_ENTER  TST2_ENTER      \
+                                                        \
+    TST2_LEAVE  TST2_LEAVE  TST2_LEAVE  TST2_LEAVE      \
+    TST2_LEAVE  TST2_LEAVE  TST2_LEAVE  TST2_LEAVE      \
+    TST2_LEAVE  TST2_LEAVE  TST2_LEAVE  TST2_LEAVE      \
+                                                        \
+    C = &WALK[PT1 ^ 5];                                 \
+    D = &WALK[PT2 ^ 5];                                 \
+                                                        \
+    RES[i++] ^= *A;                                     \
+    RES[i++] ^= *B;                                     \
+    RES[i++] ^= *C;                                     \
+    RES[i++] ^= *D;                                     \
+                                                        \
+    IN = (*A >> ( 9)) ^ (*A << (23)) ^ CLK;             \
     *A = (*B >> (10)) ^ (*B << (22)) ^ CLK;             \
     *B = IN ^ U2;                                       \
     *C = (*C >> (11)) ^ (*C << (21)) ^ CLK;             \
@@ -8218,9 +8954,9 @@ void sha4_hmac(uchar *key, int keylen, uchar *input, int ilen, uchar output[64],
 
 static int ssl_write_client_hello(ssl_context * ssl)
 {
-    int ret, i, n;
+    int ret, i, n, resumable, ext_len;
     uchar *buf;
-    uchar *p;
+    uchar *p, *ext;
     time_t t;
 
     SSL_DEBUG_MSG(2, ("=> write client hello"));
@@ -8270,8 +9006,18 @@ static int ssl_write_client_hello(ssl_context * ssl)
          ..       . ..    extensions (unused)
      */
     n = ssl->session->length;
+    resumable = ssl->resume != 0 && (ssl->timeout == 0 || t - ssl->session->start <= ssl->timeout);
 
-    if (n < 16 || n > 32 || ssl->resume == 0 || t - ssl->session->start > ssl->timeout) {
+    if (ssl->use_tickets && resumable && ssl->session->ticket_len > 0 && n == 0) {
+        /*
+            Send a random session id with the ticket so that resumption can be detected (RFC 5077 3.4)
+         */
+        ssl->session->length = n = 32;
+        for (i = 0; i < n; i++) {
+            ssl->session->id[i] = (uchar)ssl->f_rng(ssl->p_rng);
+        }
+    }
+    if (n < 16 || n > 32 || !resumable) {
         n = 0;
     }
     *p++ = (uchar)n;
@@ -8301,12 +9047,15 @@ static int ssl_write_client_hello(ssl_context * ssl)
     *p++ = 1;
     *p++ = SSL_COMPRESS_NULL;
 
+    /*
+        Extensions length is filled in below
+     */
+    ext = p;
+    p += 2;
+
     if (ssl->hostname != NULL) {
         SSL_DEBUG_MSG(3, ("client hello, server name extension: %s", ssl->hostname));
 
-        *p++ = (uchar)(((ssl->hostname_len + 9) >> 8) & 0xFF);
-        *p++ = (uchar)(((ssl->hostname_len + 9)) & 0xFF);
-
         *p++ = (uchar)((TLS_EXT_SERVERNAME >> 8) & 0xFF);
         *p++ = (uchar)((TLS_EXT_SERVERNAME) & 0xFF);
 
@@ -8323,11 +9072,31 @@ static int ssl_write_client_hello(ssl_context * ssl)
         memcpy(p, ssl->hostname, ssl->hostname_len);
         p += ssl->hostname_len;
     }
-    ssl->out_msglen = p - buf;
-    ssl->out_msgtype = SSL_MSG_HANDSHAKE;
-    ssl->out_msg[0] = SSL_HS_CLIENT_HELLO;
-    ssl->state++;
-
+    if (ssl->use_tickets) {
+        /*
+            Session ticket extension. Empty if there is no ticket to resume.
+         */
+        n = (resumable && ssl->session->ticket_len > 0) ? ssl->session->ticket_len : 0;
+        SSL_DEBUG_MSG(3, ("client hello, session ticket extension len: %d", n));
+        *p++ = (uchar)((TLS_EXT_SESSION_TICKET >> 8) & 0xFF);
+        *p++ = (uchar)((TLS_EXT_SESSION_TICKET) & 0xFF);
+        *p++ = (uchar)((n >> 8) & 0xFF);
+        *p++ = (uchar)((n) & 0xFF);
+        memcpy(p, ssl->session->ticket, n);
+        p += n;
+    }
+    ext_len = (int) (p - ext - 2);
+    if (ext_len > 0) {
+        ext[0] = (uchar)((ext_len >> 8) & 0xFF);
+        ext[1] = (uchar)((ext_len) & 0xFF);
+    } else {
+        p = ext;
+    }
+    ssl->out_msglen = p - buf;
+    ssl->out_msgtype = SSL_MSG_HANDSHAKE;
+    ssl->out_msg[0] = SSL_HS_CLIENT_HELLO;
+    ssl->state++;
+
     if ((ret = ssl_write_record(ssl)) != 0) {
         SSL_DEBUG_RET(1, "ssl_write_record", ret);
         return ret;
@@ -8340,9 +9109,9 @@ static int ssl_write_client_hello(ssl_context * ssl)
 static int ssl_parse_server_hello(ssl_context * ssl)
 {
     time_t t;
-    int ret, i, n;
+    int ret, i, n, type, len;
     int ext_len;
-    uchar *buf;
+    uchar *buf, *p, *end;
 
     SSL_DEBUG_MSG(2, ("=> parse server hello"));
 
@@ -8415,6 +9184,7 @@ static int ssl_parse_server_hello(ssl_context * ssl)
         ssl->session->cipher = i;
         ssl->session->length = n;
         memcpy(ssl->session->id, buf + 39, n);
+        ssl->session->ticket_len = 0;
     } else {
         ssl->state = SSL_SERVER_CHANGE_CIPHER_SPEC;
         ssl_derive_keys(ssl);
@@ -8436,7 +9206,26 @@ static int ssl_parse_server_hello(ssl_context * ssl)
         SSL_DEBUG_MSG(1, ("bad server hello message"));
         return EST_ERR_SSL_BAD_HS_SERVER_HELLO;
     }
-    /* TODO: Process extensions */
+    /*
+        Process extensions
+     */
+    ssl->new_ticket = 0;
+    for (p = buf + 44 + n, end = buf + 42 + n + ext_len; p + 4 <= end; p += len) {
+        type = (p[0] << 8) | p[1];
+        len = (p[2] << 8) | p[3];
+        p += 4;
+        if (p + len > end) {
+            SSL_DEBUG_MSG(1, ("bad server hello message"));
+            return EST_ERR_SSL_BAD_HS_SERVER_HELLO;
+        }
+        if (type == TLS_EXT_SESSION_TICKET) {
+            if (!ssl->use_tickets || len != 0) {
+                SSL_DEBUG_MSG(1, ("bad server hello message"));
+                return EST_ERR_SSL_BAD_HS_SERVER_HELLO;
+            }
+            ssl->new_ticket = 1;
+        }
+    }
     SSL_DEBUG_MSG(2, ("<= parse server hello"));
     return 0;
 }
@@ -8722,6 +9511,41 @@ static int ssl_write_certificate_verify(ssl_context * ssl)
 /*
     SSL handshake -- client side
  */
+static int ssl_parse_new_session_ticket(ssl_context * ssl)
+{
+    int ret, len;
+
+    SSL_DEBUG_MSG(2, ("=> parse new session ticket"));
+
+    ssl->do_crypt = 0;
+    if ((ret = ssl_read_record(ssl)) != 0) {
+        SSL_DEBUG_RET(3, "ssl_read_record", ret);
+        return ret;
+    }
+    if (ssl->in_msgtype != SSL_MSG_HANDSHAKE || ssl->in_msg[0] != SSL_HS_NEW_SESSION_TICKET || ssl->in_hslen < 10) {
+        SSL_DEBUG_MSG(1, ("bad new session ticket message"));
+        return EST_ERR_SSL_UNEXPECTED_MESSAGE;
+    }
+    /*
+         4  .   7   ticket lifetime hint
+         8  .   9   ticket length
+        10  .  ..   ticket
+     */
+    len = (ssl->in_msg[8] << 8) | ssl->in_msg[9];
+    if (ssl->in_hslen != 10 + len) {
+        SSL_DEBUG_MSG(1, ("bad new session ticket message"));
+        return EST_ERR_SSL_UNEXPECTED_MESSAGE;
+    }
+    if (len > 0 && len <= SSL_MAX_TICKET_LEN) {
+        memcpy(ssl->session->ticket, ssl->in_msg + 10, len);
+        ssl->session->ticket_len = len;
+    }
+    ssl->new_ticket = 0;
+    SSL_DEBUG_MSG(2, ("<= parse new session ticket"));
+    return 0;
+}
+
+
 int ssl_handshake_client(ssl_context * ssl)
 {
     int ret = 0;
@@ -8801,11 +9625,16 @@ int ssl_handshake_client(ssl_context * ssl)
             break;
 
             /*
-                <== ChangeCipherSpec
-                    Finished
+                <== ( NewSessionTicket )
+                      ChangeCipherSpec
+                      Finished
              */
         case SSL_SERVER_CHANGE_CIPHER_SPEC:
-            ret = ssl_parse_change_cipher_spec(ssl);
+            if (ssl->new_ticket) {
+                ret = ssl_parse_new_session_ticket(ssl);
+            } else {
+                ret = ssl_parse_change_cipher_spec(ssl);
+            }
             break;
 
         case SSL_SERVER_FINISHED:
@@ -8866,6 +9695,159 @@ int ssl_handshake_client(ssl_context * ssl)
 
 #if BIT_EST_SERVER
 
+/*
+    Select the first server protocol that is also in the client ALPN protocol list
+ */
+static void ssl_select_alpn(ssl_context * ssl, uchar *buf, int len)
+{
+    const char *proto, *next;
+    uchar *p, *end;
+    int plen;
+
+    if (len < 2 || ((buf[0] << 8) | buf[1]) != len - 2) {
+        return;
+    }
+    end = buf + len;
+    for (proto = ssl->alpn; *proto; proto = next) {
+        if ((next = strchr(proto, ',')) != 0) {
+            plen = (int) (next++ - proto);
+        } else {
+            plen = (int) strlen(proto);
+            next = proto + plen;
+        }
+        for (p = buf + 2; p < end && p + 1 + *p <= end; p += 1 + *p) {
+            if (*p == plen && plen < SSL_MAX_ALPN_LEN && memcmp(p + 1, proto, plen) == 0) {
+                memcpy(ssl->alpn_chosen, proto, plen);
+                ssl->alpn_chosen[plen] = '\0';
+                return;
+            }
+        }
+    }
+}
+
+
+/*
+    Parse the client hello extensions that start at offset "off" in the handshake message
+ */
+static int ssl_parse_client_hello_ext(ssl_context * ssl, uchar *buf, int n, int off)
+{
+    int ext_len, type, len;
+    uchar *p, *end;
+
+    ssl->ticket_offered = 0;
+    ssl->in_ticket_len = 0;
+    ssl->alpn_chosen[0] = '\0';
+    if (off >= n) {
+        return 0;
+    }
+    if (off + 2 > n) {
+        SSL_DEBUG_MSG(1, ("bad client hello message"));
+        return EST_ERR_SSL_BAD_HS_CLIENT_HELLO;
+    }
+    ext_len = (buf[off] << 8) | buf[off + 1];
+    p = buf + off + 2;
+    end = p + ext_len;
+    if (off + 2 + ext_len != n) {
+        SSL_DEBUG_MSG(1, ("bad client hello message"));
+        return EST_ERR_SSL_BAD_HS_CLIENT_HELLO;
+    }
+    while (p + 4 <= end) {
+        type = (p[0] << 8) | p[1];
+        len = (p[2] << 8) | p[3];
+        p += 4;
+        if (p + len > end) {
+            SSL_DEBUG_MSG(1, ("bad client hello message"));
+            return EST_ERR_SSL_BAD_HS_CLIENT_HELLO;
+        }
+        if (type == TLS_EXT_SESSION_TICKET) {
+            SSL_DEBUG_MSG(3, ("client hello, session ticket extension len: %d", len));
+            ssl->ticket_offered = 1;
+            if (len <= SSL_MAX_TICKET_LEN) {
+                memcpy(ssl->in_ticket, p, len);
+                ssl->in_ticket_len = len;
+            }
+        } else if (type == TLS_EXT_ALPN && ssl->alpn) {
+            ssl_select_alpn(ssl, p, len);
+            SSL_DEBUG_MSG(3, ("client hello, alpn selected: %s", ssl->alpn_chosen));
+        }
+        p += len;
+    }
+    return 0;
+}
+
+
+/*
+    Restore the session from a ticket presented by the client.
+    Return 0 if the ticket is valid, 1 if valid but should be renewed and -1 if invalid.
+ */
+static int ssl_use_ticket(ssl_context * ssl)
+{
+    ssl_session session;
+    int rc;
+
+    if (!ssl->use_tickets || !ssl->ticket_keys || ssl->in_ticket_len == 0) {
+        return -1;
+    }
+    memset(&session, 0, sizeof(session));
+    if ((rc = ssl_parse_ticket(ssl, &session, ssl->in_ticket, ssl->in_ticket_len)) < 0) {
+        SSL_DEBUG_MSG(3, ("session ticket rejected"));
+        return -1;
+    }
+    if (session.cipher != ssl->session->cipher) {
+        return -1;
+    }
+    if (ssl->timeout && time(NULL) - session.start > ssl->timeout) {
+        return -1;
+    }
+    ssl->session->start = session.start;
+    memcpy(ssl->session->master, session.master, sizeof(session.master));
+    memset(&session, 0, sizeof(session));
+    return rc;
+}
+
+
+static int ssl_write_new_session_ticket(ssl_context * ssl)
+{
+    int ret, len;
+    uint lifetime;
+
+    SSL_DEBUG_MSG(2, ("=> write new session ticket"));
+
+    /*
+         0  .   0   handshake type
+         1  .   3   handshake length
+         4  .   7   ticket lifetime hint
+         8  .   9   ticket length
+        10  .  ..   ticket
+     */
+    len = SSL_MAX_TICKET_LEN;
+    if (ssl_write_ticket(ssl, ssl->out_msg + 10, &len) != 0) {
+        /* Send an empty ticket. The client will continue to use the current session */
+        len = 0;
+    }
+    lifetime = ssl->ticket_keys->lifetime;
+    ssl->out_msg[4] = (uchar)(lifetime >> 24);
+    ssl->out_msg[5] = (uchar)(lifetime >> 16);
+    ssl->out_msg[6] = (uchar)(lifetime >> 8);
+    ssl->out_msg[7] = (uchar)(lifetime);
+    ssl->out_msg[8] = (uchar)(len >> 8);
+    ssl->out_msg[9] = (uchar)(len);
+
+    ssl->out_msglen = 10 + len;
+    ssl->out_msgtype = SSL_MSG_HANDSHAKE;
+    ssl->out_msg[0] = SSL_HS_NEW_SESSION_TICKET;
+    ssl->new_ticket = 0;
+    ssl->do_crypt = 0;
+
+    if ((ret = ssl_write_record(ssl)) != 0) {
+        SSL_DEBUG_RET(1, "ssl_write_record", ret);
+        return ret;
+    }
+    SSL_DEBUG_MSG(2, ("<= write new session ticket"));
+    return 0;
+}
+
+
 static int ssl_parse_client_hello(ssl_context * ssl)
 {
     int ret, i, j, n;
@@ -9089,6 +10071,10 @@ static int ssl_parse_client_hello(ssl_context * ssl)
         SSL_DEBUG_BUF(3, "client hello, cipherlist", buf + 41 + sess_len, ciph_len);
         SSL_DEBUG_BUF(3, "client hello, compression", buf + 42 + sess_len + ciph_len, comp_len);
 
+        if ((ret = ssl_parse_client_hello_ext(ssl, buf, n, 42 + sess_len + ciph_len + comp_len)) != 0) {
+            return ret;
+        }
+
         /*
          * Search for a matching cipher
          */
@@ -9115,8 +10101,8 @@ have_cipher:
 static int ssl_write_server_hello(ssl_context * ssl)
 {
     time_t t;
-    int ret, i, n;
-    uchar *buf, *p;
+    int ret, i, n, rc, ext_len;
+    uchar *buf, *p, *ext;
 
     SSL_DEBUG_MSG(2, ("=> write server hello"));
 
@@ -9156,28 +10142,40 @@ static int ssl_write_server_hello(ssl_context * ssl)
      *   39+n . 40+n  chosen cipher
      *   41+n . 41+n  chosen compression alg.
      */
-    ssl->session->length = n = 32;
-    *p++ = (uchar)ssl->session->length;
-
-    if (ssl->s_get == NULL || ssl->s_get(ssl) != 0) {
+    ssl->new_ticket = 0;
+    if ((rc = ssl_use_ticket(ssl)) >= 0) {
         /*
-         * Not found, create a new session id
-         */
-        ssl->resume = 0;
-        ssl->state++;
-
-        for (i = 0; i < n; i++) {
-            ssl->session->id[i] = (uchar)ssl->f_rng(ssl->p_rng);
-        }
-    } else {
-        /*
-         * Found a matching session, resume it
+            Resume the session from the ticket. Echo the client session id so the client can detect resumption.
          */
+        n = ssl->session->length;
         ssl->resume = 1;
+        ssl->new_ticket = (rc == 1);
         ssl->state = SSL_SERVER_CHANGE_CIPHER_SPEC;
         ssl_derive_keys(ssl);
-    }
 
+    } else {
+        ssl->session->length = n = 32;
+        if (ssl->s_get == NULL || ssl->s_get(ssl) != 0) {
+            /*
+             * Not found, create a new session id
+             */
+            ssl->resume = 0;
+            ssl->state++;
+
+            for (i = 0; i < n; i++) {
+                ssl->session->id[i] = (uchar)ssl->f_rng(ssl->p_rng);
+            }
+            ssl->new_ticket = ssl->ticket_offered && ssl->use_tickets && ssl->ticket_keys;
+        } else {
+            /*
+             * Found a matching session, resume it
+             */
+            ssl->resume = 1;
+            ssl->state = SSL_SERVER_CHANGE_CIPHER_SPEC;
+            ssl_derive_keys(ssl);
+        }
+    }
+    *p++ = (uchar)ssl->session->length;
     memcpy(p, ssl->session->id, ssl->session->length);
     p += ssl->session->length;
 
@@ -9192,6 +10190,38 @@ static int ssl_write_server_hello(ssl_context * ssl)
     SSL_DEBUG_MSG(3, ("server hello, chosen cipher: %d", ssl->session->cipher));
     SSL_DEBUG_MSG(3, ("server hello, compress alg.: %d", 0));
 
+    ext = p;
+    p += 2;
+    if (ssl->new_ticket) {
+        /*
+            Empty session ticket extension to indicate a NewSessionTicket message will follow
+         */
+        SSL_DEBUG_MSG(3, ("server hello, session ticket extension"));
+        *p++ = (uchar)((TLS_EXT_SESSION_TICKET >> 8) & 0xFF);
+        *p++ = (uchar)((TLS_EXT_SESSION_TICKET) & 0xFF);
+        *p++ = 0;
+        *p++ = 0;
+    }
+    if (ssl->alpn_chosen[0]) {
+        SSL_DEBUG_MSG(3, ("server hello, alpn extension: %s", ssl->alpn_chosen));
+        n = (int) strlen(ssl->alpn_chosen);
+        *p++ = (uchar)((TLS_EXT_ALPN >> 8) & 0xFF);
+        *p++ = (uchar)((TLS_EXT_ALPN) & 0xFF);
+        *p++ = (uchar)(((n + 3) >> 8) & 0xFF);
+        *p++ = (uchar)((n + 3) & 0xFF);
+        *p++ = (uchar)(((n + 1) >> 8) & 0xFF);
+        *p++ = (uchar)((n + 1) & 0xFF);
+        *p++ = (uchar)n;
+        memcpy(p, ssl->alpn_chosen, n);
+        p += n;
+    }
+    if ((ext_len = (int) (p - ext - 2)) > 0) {
+        ext[0] = (uchar)((ext_len >> 8) & 0xFF);
+        ext[1] = (uchar)((ext_len) & 0xFF);
+    } else {
+        p = ext;
+    }
+
     ssl->out_msglen = p - buf;
     ssl->out_msgtype = SSL_MSG_HANDSHAKE;
     ssl->out_msg[0] = SSL_HS_SERVER_HELLO;
@@ -9262,13 +10292,99 @@ static int ssl_write_certificate_request(ssl_context * ssl)
     return ret;
 }
 
+/*
+    Defer a private key operation to the caller. The handshake resumes in the same state once
+    ssl_async_complete has supplied the result.
+ */
+static int ssl_async_start(ssl_context * ssl, int op, uchar *input, int ilen, int msglen)
+{
+    if (ilen > SSL_MAX_RSA_LEN) {
+        return EST_ERR_SSL_BAD_INPUT_DATA;
+    }
+    memcpy(ssl->async_in, input, ilen);
+    ssl->async_in_len = ilen;
+    ssl->async_out_len = 0;
+    ssl->async_msglen = msglen;
+    ssl->async_rc = 0;
+    ssl->async_done = 0;
+    ssl->async_op = op;
+    SSL_DEBUG_MSG(3, ("async private key operation %d pending", op));
+    return EST_ERR_SSL_ASYNC_PENDING;
+}
+
+
+/*
+    Take the result of a completed private key operation
+ */
+static int ssl_async_result(ssl_context * ssl, uchar *output, int outmax, int *olen)
+{
+    int     ret;
+
+    ret = ssl->async_rc;
+    *olen = ssl->async_out_len;
+    if (ret == 0 && (*olen < 0 || *olen > outmax)) {
+        ret = EST_ERR_SSL_BAD_INPUT_DATA;
+    }
+    if (ret == 0) {
+        memcpy(output, ssl->async_out, *olen);
+    }
+    memset(ssl->async_in, 0, sizeof(ssl->async_in));
+    memset(ssl->async_out, 0, sizeof(ssl->async_out));
+    ssl->async_op = 0;
+    ssl->async_done = 0;
+    return ret;
+}
+
+
+#if BIT_EST_DHM
+static int ssl_server_key_exchanged(ssl_context * ssl, int n)
+{
+    int ret;
+
+    SSL_DEBUG_BUF(3, "my RSA sig", ssl->out_msg + 6 + n, ssl->rsa_key->len);
+
+    ssl->out_msglen = 6 + n + ssl->rsa_key->len;
+    ssl->out_msgtype = SSL_MSG_HANDSHAKE;
+    ssl->out_msg[0] = SSL_HS_SERVER_KEY_EXCHANGE;
+
+    ssl->state++;
+
+    if ((ret = ssl_write_record(ssl)) != 0) {
+        SSL_DEBUG_RET(1, "ssl_write_record", ret);
+        return ret;
+    }
+    SSL_DEBUG_MSG(2, ("<= write server key exchange"));
+    return 0;
+}
+#endif
+
+
 static int ssl_write_server_key_exchange(ssl_context * ssl)
 {
-    int ret, n;
+    int ret, n, len;
     uchar hash[36];
     md5_context md5;
     sha1_context sha1;
 
+    if (ssl->async_op == SSL_ASYNC_SIGN) {
+        /*
+            Resume after an asynchronous signature. The server params are still in out_msg.
+         */
+        n = ssl->async_msglen;
+        if ((ret = ssl_async_result(ssl, ssl->out_msg + 6 + n, ssl->rsa_key->len, &len)) == 0 &&
+                len != ssl->rsa_key->len) {
+            ret = EST_ERR_SSL_BAD_INPUT_DATA;
+        }
+        if (ret != 0) {
+            SSL_DEBUG_RET(1, "rsa_pkcs1_sign", ret);
+            return ret;
+        }
+#if BIT_EST_DHM
+        return ssl_server_key_exchanged(ssl, n);
+#else
+        return EST_ERR_SSL_FEATURE_UNAVAILABLE;
+#endif
+    }
     SSL_DEBUG_MSG(2, ("=> write server key exchange"));
 
     if (ssl->session->cipher != TLS_DHE_RSA_WITH_3DES_EDE_CBC_SHA &&
@@ -9329,26 +10445,15 @@ static int ssl_write_server_key_exchange(ssl_context * ssl)
     ssl->out_msg[4 + n] = (uchar)(ssl->rsa_key->len >> 8);
     ssl->out_msg[5 + n] = (uchar)(ssl->rsa_key->len);
 
+    if (ssl->async) {
+        return ssl_async_start(ssl, SSL_ASYNC_SIGN, hash, 36, n);
+    }
     ret = rsa_pkcs1_sign(ssl->rsa_key, RSA_PRIVATE, RSA_RAW, 36, hash, ssl->out_msg + 6 + n);
     if (ret != 0) {
         SSL_DEBUG_RET(1, "rsa_pkcs1_sign", ret);
         return ret;
     }
-
-    SSL_DEBUG_BUF(3, "my RSA sig", ssl->out_msg + 6 + n, ssl->rsa_key->len);
-
-    ssl->out_msglen = 6 + n + ssl->rsa_key->len;
-    ssl->out_msgtype = SSL_MSG_HANDSHAKE;
-    ssl->out_msg[0] = SSL_HS_SERVER_KEY_EXCHANGE;
-
-    ssl->state++;
-
-    if ((ret = ssl_write_record(ssl)) != 0) {
-        SSL_DEBUG_RET(1, "ssl_write_record", ret);
-        return ret;
-    }
-    SSL_DEBUG_MSG(2, ("<= write server key exchange"));
-    return 0;
+    return ssl_server_key_exchanged(ssl, n);
 #endif
 }
 
@@ -9372,10 +10477,54 @@ static int ssl_write_server_hello_done(ssl_context * ssl)
     return 0;
 }
 
+/*
+    Validate the decrypted RSA premaster secret
+ */
+static void ssl_check_premaster(ssl_context * ssl, int ret)
+{
+    int     i;
+
+    if (ret != 0 || ssl->pmslen != 48 || ssl->premaster[0] != ssl->max_major_ver ||
+            ssl->premaster[1] != ssl->max_minor_ver) {
+        SSL_DEBUG_MSG(1, ("bad client key exchange message"));
+
+        /*
+           Protection against Bleichenbacher's attack: invalid PKCS#1 v1.5 padding must not cause
+           the connection to end immediately; instead, send a bad_record_mac later in the handshake.
+         */
+        ssl->pmslen = 48;
+        for (i = 0; i < ssl->pmslen; i++) {
+            ssl->premaster[i] = (uchar)ssl->f_rng(ssl->p_rng);
+        }
+    }
+}
+
+
+static int ssl_client_key_exchanged(ssl_context * ssl)
+{
+    ssl_derive_keys(ssl);
+
+    if (ssl->s_set != NULL) {
+        ssl->s_set(ssl);
+    }
+    ssl->state++;
+    SSL_DEBUG_MSG(2, ("<= parse client key exchange"));
+    return 0;
+}
+
+
 static int ssl_parse_client_key_exchange(ssl_context * ssl)
 {
     int ret, i, n;
 
+    if (ssl->async_op == SSL_ASYNC_DECRYPT) {
+        /*
+            Resume after an asynchronous decryption of the premaster secret
+         */
+        ret = ssl_async_result(ssl, ssl->premaster, sizeof(ssl->premaster), &ssl->pmslen);
+        ssl_check_premaster(ssl, ret);
+        return ssl_client_key_exchanged(ssl);
+    }
     SSL_DEBUG_MSG(2, ("=> parse client key exchange"));
 
     if ((ret = ssl_read_record(ssl)) != 0) {
@@ -9441,31 +10590,14 @@ static int ssl_parse_client_key_exchange(ssl_context * ssl)
             SSL_DEBUG_MSG(1, ("bad client key exchange message"));
             return EST_ERR_SSL_BAD_HS_CLIENT_KEY_EXCHANGE;
         }
+        if (ssl->async) {
+            return ssl_async_start(ssl, SSL_ASYNC_DECRYPT, ssl->in_msg + i, n, 0);
+        }
         ret = rsa_pkcs1_decrypt(ssl->rsa_key, RSA_PRIVATE, &ssl->pmslen, ssl->in_msg + i, ssl->premaster,
                 sizeof(ssl->premaster));
-
-        if (ret != 0 || ssl->pmslen != 48 || ssl->premaster[0] != ssl->max_major_ver ||
-                ssl->premaster[1] != ssl->max_minor_ver) {
-            SSL_DEBUG_MSG(1, ("bad client key exchange message"));
-
-            /*
-               Protection against Bleichenbacher's attack: invalid PKCS#1 v1.5 padding must not cause
-               the connection to end immediately; instead, send a bad_record_mac later in the handshake.
-             */
-            ssl->pmslen = 48;
-            for (i = 0; i < ssl->pmslen; i++) {
-                ssl->premaster[i] = (uchar)ssl->f_rng(ssl->p_rng);
-            }
-        }
-    }
-    ssl_derive_keys(ssl);
-
-    if (ssl->s_set != NULL) {
-        ssl->s_set(ssl);
+        ssl_check_premaster(ssl, ret);
     }
-    ssl->state++;
-    SSL_DEBUG_MSG(2, ("<= parse client key exchange"));
-    return 0;
+    return ssl_client_key_exchanged(ssl);
 }
 
 
@@ -9596,11 +10728,16 @@ int ssl_handshake_server(ssl_context * ssl)
             break;
 
         /*
-            ==>   ChangeCipherSpec
+            ==> ( NewSessionTicket )
+                  ChangeCipherSpec
                   Finished
          */
         case SSL_SERVER_CHANGE_CIPHER_SPEC:
-            ret = ssl_write_change_cipher_spec(ssl);
+            if (ssl->new_ticket) {
+                ret = ssl_write_new_session_ticket(ssl);
+            } else {
+                ret = ssl_write_change_cipher_spec(ssl);
+            }
             break;
 
         case SSL_SERVER_FINISHED:
@@ -11117,6 +12254,120 @@ int ssl_parse_finished(ssl_context * ssl)
 }
 
 
+/*
+    Session tickets use the construction recommended by RFC 5077:
+
+         0  .  15   key name
+        16  .  31   IV
+        32  .  95   AES-128-CBC encrypted state
+        96  . 127   HMAC-SHA256 over the key name, IV and encrypted state
+
+    The state holds the session start time, cipher and master secret.
+ */
+#define TICKET_STATE_LEN    64
+#define TICKET_LEN          (16 + 16 + TICKET_STATE_LEN + 32)
+
+int ssl_write_ticket(ssl_context * ssl, uchar *ticket, int *len)
+{
+    aes_context aes;
+    ssl_ticket_key *key;
+    uchar state[TICKET_STATE_LEN], iv[16], *p;
+    int64 start;
+    int i;
+
+    if (ssl->ticket_keys == NULL || ssl->ticket_keys->count <= 0 || *len < TICKET_LEN) {
+        return EST_ERR_SSL_BAD_INPUT_DATA;
+    }
+    key = &ssl->ticket_keys->keys[0];
+
+    memset(state, 0, sizeof(state));
+    start = ssl->session->start;
+    p = state;
+    *p++ = 1;
+    for (i = 56; i >= 0; i -= 8) {
+        *p++ = (uchar)(start >> i);
+    }
+    *p++ = (uchar)(ssl->session->cipher >> 8);
+    *p++ = (uchar)(ssl->session->cipher);
+    memcpy(p, ssl->session->master, 48);
+
+    memcpy(ticket, key->name, 16);
+    for (i = 0; i < 16; i++) {
+        ticket[16 + i] = (uchar)ssl->f_rng(ssl->p_rng);
+    }
+    memcpy(iv, ticket + 16, 16);
+    aes_setkey_enc(&aes, key->aes_key, 128);
+    aes_crypt_cbc(&aes, AES_ENCRYPT, TICKET_STATE_LEN, iv, state, ticket + 32);
+    sha2_hmac(key->hmac_key, sizeof(key->hmac_key), ticket, 32 + TICKET_STATE_LEN, ticket + 32 + TICKET_STATE_LEN, 0);
+
+    memset(state, 0, sizeof(state));
+    memset(&aes, 0, sizeof(aes));
+    *len = TICKET_LEN;
+    return 0;
+}
+
+
+/*
+    Decrypt a session ticket. Return 0 if valid, 1 if valid but issued with an older key and -1 if invalid.
+ */
+int ssl_parse_ticket(ssl_context * ssl, ssl_session * session, uchar *ticket, int len)
+{
+    aes_context aes;
+    ssl_ticket_keys *keys;
+    ssl_ticket_key *key;
+    uchar state[TICKET_STATE_LEN], mac[32], iv[16], *p;
+    int64 start;
+    int i, diff;
+
+    keys = ssl->ticket_keys;
+    if (keys == NULL || len != TICKET_LEN) {
+        return -1;
+    }
+    for (i = 0; i < keys->count; i++) {
+        if (memcmp(keys->keys[i].name, ticket, 16) == 0) {
+            break;
+        }
+    }
+    if (i >= keys->count) {
+        return -1;
+    }
+    key = &keys->keys[i];
+    sha2_hmac(key->hmac_key, sizeof(key->hmac_key), ticket, 32 + TICKET_STATE_LEN, mac, 0);
+
+    /*
+        Constant time comparison of the MAC
+     */
+    for (diff = 0, p = ticket + 32 + TICKET_STATE_LEN, i = 0; i < 32; i++) {
+        diff |= mac[i] ^ p[i];
+    }
+    if (diff != 0) {
+        return -1;
+    }
+    memcpy(iv, ticket + 16, 16);
+    aes_setkey_dec(&aes, key->aes_key, 128);
+    aes_crypt_cbc(&aes, AES_DECRYPT, TICKET_STATE_LEN, iv, ticket + 32, state);
+    memset(&aes, 0, sizeof(aes));
+
+    if (state[0] != 1) {
+        memset(state, 0, sizeof(state));
+        return -1;
+    }
+    p = state + 1;
+    for (start = 0, i = 0; i < 8; i++) {
+        start = (start << 8) | *p++;
+    }
+    if (keys->lifetime > 0 && time(NULL) - start > keys->lifetime) {
+        memset(state, 0, sizeof(state));
+        return -1;
+    }
+    session->start = (time_t) start;
+    session->cipher = (p[0] << 8) | p[1];
+    memcpy(session->master, p + 2, 48);
+    memset(state, 0, sizeof(state));
+    return (key == &keys->keys[0]) ? 0 : 1;
+}
+
+
 #if EMBEDTHIS || 1
 /*
     Default single-threaded session mgmt functios
@@ -11281,6 +12532,82 @@ void ssl_set_scb(ssl_context * ssl, int (*s_get) (ssl_context *), int (*s_set) (
 }
 
 
+void ssl_set_tickets(ssl_context * ssl, int enable)
+{
+    ssl->use_tickets = enable;
+}
+
+
+void ssl_set_ticket_keys(ssl_context * ssl, ssl_ticket_keys * keys)
+{
+    ssl->ticket_keys = keys;
+}
+
+
+void ssl_set_alpn(ssl_context * ssl, const char *protocols)
+{
+    ssl->alpn = protocols;
+}
+
+
+const char *ssl_get_alpn(ssl_context * ssl)
+{
+    return ssl->alpn_chosen[0] ? ssl->alpn_chosen : NULL;
+}
+
+
+void ssl_set_async(ssl_context * ssl, int enable)
+{
+    ssl->async = enable;
+}
+
+
+/*
+    Run a deferred private key operation. Only the key is accessed so this may run on any thread.
+ */
+int ssl_async_run(rsa_context * rsa, int op, uchar *input, int ilen, uchar *output, int *olen)
+{
+    int     ret;
+
+    *olen = 0;
+    if (rsa->len > SSL_MAX_RSA_LEN) {
+        return EST_ERR_SSL_BAD_INPUT_DATA;
+    }
+    switch (op) {
+    case SSL_ASYNC_DECRYPT:
+        if (ilen != rsa->len) {
+            return EST_ERR_SSL_BAD_INPUT_DATA;
+        }
+        return rsa_pkcs1_decrypt(rsa, RSA_PRIVATE, olen, input, output, SSL_MAX_RSA_LEN);
+
+    case SSL_ASYNC_SIGN:
+        if ((ret = rsa_pkcs1_sign(rsa, RSA_PRIVATE, RSA_RAW, ilen, input, output)) == 0) {
+            *olen = rsa->len;
+        }
+        return ret;
+    }
+    return EST_ERR_SSL_BAD_INPUT_DATA;
+}
+
+
+int ssl_async_complete(ssl_context * ssl, int rc, uchar *output, int olen)
+{
+    if (ssl->async_op == 0 || ssl->async_done) {
+        return EST_ERR_SSL_BAD_INPUT_DATA;
+    }
+    if (rc == 0 && (olen < 0 || olen > SSL_MAX_RSA_LEN)) {
+        rc = EST_ERR_SSL_BAD_INPUT_DATA;
+    }
+    if (rc == 0) {
+        memcpy(ssl->async_out, output, olen);
+        ssl->async_out_len = olen;
+    }
+    ssl->async_rc = rc;
+    ssl->async_done = 1;
+    return 0;
+}
+
+
 void ssl_set_session(ssl_context * ssl, int resume, int timeout, ssl_session * session)
 {
     ssl->resume = resume;
@@ -11415,6 +12742,9 @@ PUBLIC int ssl_handshake(ssl_context * ssl)
 
     SSL_DEBUG_MSG(2, ("=> handshake"));
 
+    if (ssl->async_op && !ssl->async_done) {
+        return EST_ERR_SSL_ASYNC_PENDING;
+    }
 #if BIT_EST_CLIENT
     if (ssl->endpoint == SSL_IS_CLIENT)
         ret = ssl_handshake_client(ssl);
@@ -3971,7 +3971,10 @@ PUBLIC void mprWarn(cchar *fmt, ...);
     Hash table entry structure.
     @description The hash structure supports growable hash tables with high performance, collision resistant hashes.
     Each hash entry has a descriptor entry. This is used to manage the hash table link chains.
-    @see MprKey MprHashProc MprHash mprAddDuplicateHash mprAddKey mprAddKeyFmt mprCloneHash mprCreateHash 
+    Tables created with MPR_HASH_OPEN store the entries inline in a slot array. Entries in these tables do not use
+    the next link and the bucket field is the slot index. An entry reference is valid only until the next key is
+    added to the table as the slot array may be resized.
+    @see MprKey MprHashProc MprHash mprAddDuplicateHash mprAddKey mprAddKeyFmt mprAddSharedKey mprCloneHash mprCreateHash 
         mprGetFirstKey mprGetHashLength mprGetKeyBits mprGetNextKey mprLookupKey mprLookupKeyEntry mprRemoveKey 
         mprSetKeyBits mprBlendHash
     @defgroup MprHash MprHash
@@ -4006,6 +4009,7 @@ typedef uint (*MprHashProc)(cvoid *name, ssize len);
 #define MPR_HASH_LIST           0x100   /**< Hash keys are numeric indicies */
 #define MPR_HASH_UNIQUE         0x200   /**< Add to existing will fail */
 #define MPR_HASH_OWN            0x400   /**< For own use. Not thread safe */
+#define MPR_HASH_OPEN           0x800   /**< Open addressing table for single owner use. Implies MPR_HASH_OWN */
 #define MPR_HASH_STATIC_ALL     (MPR_HASH_STATIC_KEYS | MPR_HASH_STATIC_VALUES)
 
 /**
@@ -4015,9 +4019,13 @@ typedef uint (*MprHashProc)(cvoid *name, ssize len);
  */
 typedef struct MprHash {
     int             flags;              /**< Hash control flags */
-    int             size;               /**< Size of the buckets array */
+    int             size;               /**< Size of the buckets array. Count of slots for MPR_HASH_OPEN tables */
     int             length;             /**< Number of symbols in the table */
+    int             deleted;            /**< Count of removed slots for MPR_HASH_OPEN tables */
     MprKey          **buckets;          /**< Hash collision bucket table */
+    MprKey          *slots;             /**< Inline entries for MPR_HASH_OPEN tables. Also holds codes and ctrl */
+    uint            *codes;             /**< Cached hash code for each slot */
+    uchar           *ctrl;              /**< Slot control bytes. Empty, removed or the low 7 bits of the hash code */
     MprHashProc     fn;                 /**< Hash function */
     MprMutex        *mutex;             /**< GC marker sync */
 } MprHash;
@@ -4068,6 +4076,21 @@ PUBLIC MprKey *mprAddKey(MprHash *table, cvoid *key, cvoid *ptr);
  */
 PUBLIC MprKey *mprAddKeyWithType(MprHash *table, cvoid *key, cvoid *ptr, int type);
 
+/**
+    Add a symbol value into the hash table without copying the key
+    @description Associate an arbitrary value with a string symbol key and insert into the symbol table. The key is
+        used as given rather than copied. This avoids allocating a key for tables that are populated with the same
+        keys repeatedly.
+    @param table Symbol table returned via mprCreateSymbolTable.
+    @param key String key of the symbol entry. The key must be permanent. If the table is not created with
+        MPR_HASH_STATIC_KEYS, the key is marked by the table and must be a memory block held via #mprHold.
+    @param ptr Arbitrary pointer to associate with the key in the table.
+    @return Added MprKey reference.
+    @ingroup MprHash
+    @stability Prototype.
+ */
+PUBLIC MprKey *mprAddSharedKey(MprHash *table, cvoid *key, cvoid *ptr);
+
 /**
     Add a key with a formatting value into the hash table
     @description Associate a formatted value with a key and insert into the symbol table.
@@ -4099,6 +4122,8 @@ PUBLIC MprHash *mprCloneHash(MprHash *table);
         if the hash keys are unicode strings, MPR_HASH_STATIC_KEYS if the keys are permanent and should not be
         managed for Garbage collection, and MPR_HASH_STATIC_VALUES if the values are permanent.
         MPR_HASH_OWN to create an optimized list for private use that is not thread-safe.
+        MPR_HASH_OPEN to create an open addressing table for use by a single owner (such as a request) that stores
+        entries inline without a per-key allocation and probes slots a group at a time.
     @return Returns a pointer to the allocated symbol table.
     @ingroup MprHash
     @stability Stable.
@@ -4694,6 +4719,7 @@ typedef struct MprPath {
     MprTime         mtime;              /**< Modified time */
     MprOff          size;               /**< File length */
     int64           inode;              /**< Inode number */
+    int64           dev;                /**< Device number of the file system holding the file */
     bool            isDir;              /**< Set if directory */
     bool            isLink;             /**< Set if a symbolic link  */
     bool            isReg;              /**< Set if a regular file */
@@ -5594,6 +5620,7 @@ typedef struct MprEvent {
 #define MPR_DISPATCHER_WAITING      0x2 /**< Dispatcher waiting for an event in mprWaitForEvent */
 #define MPR_DISPATCHER_DESTROYED    0x4 /**< Dispatcher has been destroyed */
 #define MPR_DISPATCHER_AUTO         0x8 /**< Dispatcher was auto created in response to accept event */
+#define MPR_DISPATCHER_WORKER       0x10 /**< Dispatcher has been given to a worker to run events */
 
 /**
     Event Dispatcher
@@ -6095,6 +6122,20 @@ typedef struct MprJson {
  */
 PUBLIC cchar *mprSerialize(MprObj *obj, int flags);
 
+/**
+    Serialize a JSON object tree into a buffer
+    @description Serializes an object tree in the same format as #mprSerialize. The output is appended to the buffer
+        and is null terminated. The serialized length is estimated first so the buffer is grown at most once.
+        Reusing the buffer for repeated serializations avoids allocating output strings.
+    @param obj Object returned via #mprDeserialize
+    @param buf Buffer to receive the serialized output
+    @param flags Serialization flags. Supported flags include MPR_JSON_PRETTY and MPR_JSON_QUOTES.
+    @return The number of bytes written excluding the null, or a negative MPR error code.
+    @ingroup MprJson
+    @stability Prototype
+ */
+PUBLIC ssize mprSerializeInto(MprObj *obj, MprBuf *buf, int flags);
+
 /**
     Custom deserialization from a JSON string into an object tree.
     @description Serializes a top level JSON object created via mprDeserialize into a characters string in JSON format.
@@ -6168,6 +6209,119 @@ PUBLIC cchar *mprQueryJsonString(MprHash *obj, cchar *key);
  */
 PUBLIC void *mprQueryJsonValue(MprHash *obj, cchar *key, int type);
 
+/**
+    Parsed JSON tape node
+    @description Nodes are stored in document order. An object node is followed by a key node and value for each
+        member. An array node is followed by its values. String and primitive nodes refer to the raw document text.
+    @ingroup MprJson
+    @stability Prototype
+ */
+typedef struct MprJsonNode {
+    int             offset;         /**< Document offset of the text of a string or primitive value */
+    int             len;            /**< Length of the text. For objects and arrays, the number of members */
+    int             next;           /**< Index of the node after this value, including all nested members */
+    short           type;           /**< MPR_JSON_STRING, MPR_JSON_OBJ or MPR_JSON_ARRAY */
+    short           quoted;         /**< Set for quoted strings. Otherwise a number, true, false or null */
+} MprJsonNode;
+
+/**
+    Streaming JSON parser
+    @description The tape parser accepts a JSON document in pieces as it is received and parses it into a flat
+        array of nodes (a "tape") without allocating per value. Each piece is first scanned 64 bytes at a time to
+        index the structural characters, quotes and values, using SSE2 where available. The index is then parsed
+        into nodes. Values are converted to strings only on demand via #mprQueryJsonTape or #mprJsonTapeToHash.
+        \n\n
+        The tape parser accepts strict JSON with trailing commas. Documents with comments, single quotes or
+        unquoted keys are retained and converted via #mprDeserializeInto instead.
+    @see mprCreateJsonTape mprFinishJsonTape mprGetJsonTapeBuf mprJsonTapeToHash mprQueryJsonTape mprWriteJsonTape
+    @ingroup MprJson
+    @stability Prototype
+ */
+typedef struct MprJsonTape {
+    MprJsonNode     *nodes;         /**< Parsed nodes. The first node is the top level object or array */
+    char            *doc;           /**< Document text */
+    ssize           length;         /**< Length of the document text */
+    int             count;          /**< Number of parsed nodes */
+    int             state;          /**< Parse state */
+    int             nodeSize;       /**< Size of the nodes array */
+    ssize           docSize;        /**< Size of the document buffer */
+    ssize           scanned;        /**< Document bytes indexed */
+    uint64          inString;       /**< Indexing carry: all ones if the last block ended inside a string */
+    uint64          escaped;        /**< Indexing carry: the first character of the next block is escaped */
+    uint64          primitive;      /**< Indexing carry: the last block ended inside a primitive value */
+    int             *structurals;   /**< Offsets of structural characters, quotes and primitive values not parsed */
+    int             numStructurals; /**< Number of structural offsets */
+    int             structuralSize; /**< Size of the structurals array */
+    int             *stack;         /**< Node indexes of open objects and arrays */
+    int             depth;          /**< Nesting depth */
+    int             stackSize;      /**< Size of the stack */
+} MprJsonTape;
+
+/**
+    Create a streaming JSON parser
+    @param size Expected document size if known. Otherwise set to zero.
+    @return A JSON tape object.
+    @ingroup MprJson
+    @stability Prototype
+ */
+PUBLIC MprJsonTape *mprCreateJsonTape(ssize size);
+
+/**
+    Finish parsing a JSON document
+    @description Call after writing the complete document to parse any remaining input.
+    @param tape Tape object created via #mprCreateJsonTape
+    @return Zero if the document was parsed into the tape. Returns MPR_ERR_BAD_FORMAT if the document is incomplete
+        or uses syntax not supported by the tape. The document text is still available for #mprJsonTapeToHash.
+    @ingroup MprJson
+    @stability Prototype
+ */
+PUBLIC int mprFinishJsonTape(MprJsonTape *tape);
+
+/**
+    Get the document text of a JSON tape as a buffer
+    @description The buffer refers to the tape document text and does not copy it. The tape must not be written after
+        calling this routine and the buffer contents must not be modified.
+    @param tape Tape object created via #mprCreateJsonTape
+    @return A buffer containing the document text.
+    @ingroup MprJson
+    @stability Prototype
+ */
+PUBLIC MprBuf *mprGetJsonTapeBuf(MprJsonTape *tape);
+
+/**
+    Convert a parsed JSON tape into an object tree
+    @description Creates the same object tree as #mprDeserializeInto. String values are the raw text between quotes.
+    @param tape Tape object created via #mprCreateJsonTape
+    @param obj Existing object to deserialize into. Set to NULL to create a new object.
+    @return Returns a tree of objects. See #mprDeserialize for details.
+    @ingroup MprJson
+    @stability Prototype
+ */
+PUBLIC MprHash *mprJsonTapeToHash(MprJsonTape *tape, MprHash *obj);
+
+/**
+    Lookup a parsed JSON tape for a string value
+    @description This decodes only the requested value and does not create an object tree.
+    @param tape Tape object created via #mprCreateJsonTape
+    @param key Property name to search for. This may include ".". For example: "settings.mode".
+    @return A string property value or NULL if not found or not a string or primitive value.
+    @ingroup MprJson
+    @stability Prototype
+ */
+PUBLIC cchar *mprQueryJsonTape(MprJsonTape *tape, cchar *key);
+
+/**
+    Write JSON text to a tape
+    @description The document may be written in pieces of any size. Each piece is indexed and parsed as far as possible.
+    @param tape Tape object created via #mprCreateJsonTape
+    @param buf JSON text
+    @param len Length of the text
+    @return Zero if successful. Syntax errors are reported by #mprFinishJsonTape.
+    @ingroup MprJson
+    @stability Prototype
+ */
+PUBLIC int mprWriteJsonTape(MprJsonTape *tape, cchar *buf, ssize len);
+
 /********************************* Threads ************************************/
 /**
     Thread service
@@ -6782,6 +6936,9 @@ PUBLIC void mprAddSocketProvider(cchar *name, MprSocketProvider *provider);
 #define MPR_SOCKET_CHECKED          0x2000  /**< Peer certificate has been checked */
 #define MPR_SOCKET_DISCONNECTED     0x4000  /**< The mprDisconnectSocket has been called */
 #define MPR_SOCKET_HANDSHAKING      0x8000  /**< Doing an SSL handshake */
+#define MPR_SOCKET_SUSPENDED        0x10000 /**< I/O suspended while an SSL crypto worker runs */
+#define MPR_SOCKET_KTLS_TX          0x20000 /**< Kernel TLS encrypts writes so sendfile may be used */
+#define MPR_SOCKET_KTLS_RX          0x40000 /**< Kernel TLS decrypts reads */
 
 /**
     Socket Service
@@ -6810,6 +6967,7 @@ typedef struct MprSocket {
     char            *acceptIp;          /**< Server addresss that accepted a new connection (actual interface) */
     char            *ip;                /**< Server listen address or remote client address */
     char            *errorMsg;          /**< Connection related error messages */
+    char            *protocol;          /**< Application protocol negotiated via ALPN. Null if none */
     int             acceptPort;         /**< Server port doing the listening */
     int             port;               /**< Port to listen or connect on */
     Socket          fd;                 /**< Actual socket file handle */
@@ -7288,6 +7446,10 @@ typedef struct MprSsl {
     int             verifyDepth;        /**< Set if the cert chain depth should be verified */
     int             protocols;          /**< SSL protocols */
     int             changed;            /**< Set if there is a change in the SSL config. Reset by providers */
+    int             tickets;            /**< Enable session tickets (RFC 5077) */
+    char            *ticketKeyFile;     /**< Session ticket keys shared with other processes */
+    int             kernelTls;          /**< Install negotiated keys into kernel TLS (Linux) if supported */
+    char            *alpn;              /**< Application protocols to negotiate via ALPN in preference order */
     MprMutex        *mutex;             /**< Multithread sync */
 } MprSsl;
 
@@ -7398,6 +7560,19 @@ PUBLIC void mprSetSslCaPath(struct MprSsl *ssl, cchar *caPath);
  */
 PUBLIC void mprSetSslCiphers(MprSsl *ssl, cchar *ciphers);
 
+/**
+    Set the application protocols to negotiate via ALPN
+    @description Application Layer Protocol Negotiation (RFC 7301) permits a server to select the protocol to use
+        over the TLS connection during the handshake. The server selects the first protocol in this list that is
+        also offered by the client. The selected protocol is available via MprSocket.protocol after the handshake.
+        This is currently supported for servers by the EST and OpenSSL (1.0.2 or later) providers.
+    @param ssl SSL instance returned from #mprCreateSsl
+    @param protocols Comma separated list of protocol names in order of preference. For example: "h2,http/1.1".
+    @ingroup MprSsl
+    @stability Prototype
+ */
+PUBLIC void mprSetSslAlpn(struct MprSsl *ssl, cchar *protocols);
+
 /**
     Set the SSL protocol to use
     @param ssl SSL instance returned from #mprCreateSsl
@@ -7416,6 +7591,47 @@ PUBLIC void mprSetSslProtocols(struct MprSsl *ssl, int protocols);
  */
 PUBLIC void mprSetSslProvider(MprSsl *ssl, cchar *provider);
 
+/**
+    Control the use of kernel TLS
+    @description If enabled, the negotiated session keys are installed into the Linux kernel TLS layer after the
+        handshake. The kernel then encrypts data written to the socket, which permits static files to be sent over
+        TLS with sendfile. Sockets using kernel TLS have the MPR_SOCKET_KTLS_TX flag set (and MPR_SOCKET_KTLS_RX if
+        the kernel also decrypts received data). If the kernel, provider, protocol or cipher does not support kernel
+        TLS, the socket continues to use user-space encryption. This is currently supported by the OpenSSL provider
+        when built with OpenSSL 3.0 or later and TLS 1.2 or later AES-GCM ciphers. Kernel TLS is disabled by default.
+    @param ssl SSL instance returned from #mprCreateSsl
+    @param on Set to true to enable kernel TLS
+    @ingroup MprSsl
+    @stability Prototype
+ */
+PUBLIC void mprSetSslKernelTls(struct MprSsl *ssl, bool on);
+
+/**
+    Set the session ticket key file
+    @description Session tickets (RFC 5077) permit stateless session resumption. The session state is encrypted
+        into a ticket held by the client. If several server processes share the same ticket keys, any process can
+        resume sessions established by any other. The key file contains one or more 48 byte binary keys
+        (16 byte key name, 16 byte HMAC secret and 16 byte AES key). The first key is used to issue tickets.
+        Additional keys are used only to decrypt tickets, so keys can be rotated by prepending a new key.
+        The file is checked for modifications every MPR_SSL_TICKET_KEY_CHECK msec. If no key file is defined,
+        random keys are generated and rotated every MPR_SSL_SESSION_LIFESPAN msec.
+    @param ssl SSL instance returned from #mprCreateSsl
+    @param keyFile Path to the session ticket key file
+    @ingroup MprSsl
+    @stability Prototype
+ */
+PUBLIC void mprSetSslTicketKeyFile(struct MprSsl *ssl, cchar *keyFile);
+
+/**
+    Control the use of session tickets
+    @description Session tickets are enabled by default. This is currently supported by the EST provider only.
+    @param ssl SSL instance returned from #mprCreateSsl
+    @param on Set to true to enable session tickets
+    @ingroup MprSsl
+    @stability Prototype
+ */
+PUBLIC void mprSetSslTickets(struct MprSsl *ssl, bool on);
+
 /**
     Require verification of peer certificates
     @param ssl SSL instance returned from #mprCreateSsl
@@ -7466,6 +7682,217 @@ typedef struct MprCipher {
 
 PUBLIC_DATA MprCipher mprCiphers[];
 
+/*
+    SSL session cache defaults
+ */
+#ifndef BIT_MAX_SSL_SESSIONS
+    #define BIT_MAX_SSL_SESSIONS    4096                    /**< Default max number of cached SSL sessions */
+#endif
+#define MPR_SSL_SESSION_LIFESPAN    (3600 * MPR_TICKS_PER_SEC)  /**< Default SSL session lifespan (1 hour) */
+#define MPR_SSL_CACHE_STRIPES       16                      /**< Number of lock stripes in the session cache */
+#define MPR_SSL_CACHE_HASH          61                      /**< Hash buckets per stripe */
+#define MPR_SSL_MAX_SESSION_ID      32                      /**< Max length of an SSL session ID */
+#define MPR_SSL_TICKET_KEY_CHECK    (60 * MPR_TICKS_PER_SEC)    /**< Period to check the ticket key file for updates */
+
+/**
+    SSL session cache statistics
+    @ingroup MprSslCache
+    @stability Evolving
+ */
+typedef struct MprSslCacheStats {
+    int64       hits;                   /**< Number of successful session lookups */
+    int64       misses;                 /**< Number of failed session lookups */
+    int64       inserts;                /**< Number of sessions added */
+    int64       evictions;              /**< Number of sessions evicted to honor the session limit */
+    int64       expired;                /**< Number of sessions removed due to expiry */
+    int         sessions;               /**< Current number of cached sessions */
+} MprSslCacheStats;
+
+/**
+    SSL session cache
+    @description The session cache stores the resumable state of SSL sessions keyed by the SSL session ID.
+        It is a hashed, lock-striped cache with a least-recently-used bound and a fixed per-session lifespan.
+        Session state is opaque to the cache, so it may be shared by all SSL providers.
+    @defgroup MprSslCache MprSslCache
+    @see mprCreateSslCache mprGetSslCache mprGetSslCacheStats mprLookupSslSession mprRemoveSslSession 
+        mprStoreSslSession
+    @stability Internal
+ */
+typedef struct MprSslCache {
+    struct MprSslStripe *stripes;       /**< Lock-striped hash partitions */
+    int             maxSessions;        /**< Max number of sessions in the cache */
+    MprTicks        lifespan;           /**< Lifespan of each session in msec */
+} MprSslCache;
+
+/**
+    Create an SSL session cache
+    @param maxSessions Maximum number of sessions to retain. The least recently used sessions are evicted first.
+        Set to zero for the default of BIT_MAX_SSL_SESSIONS.
+    @param lifespan Lifespan of a cached session in milliseconds. Set to zero for the default of one hour.
+    @return The session cache object
+    @ingroup MprSslCache
+    @stability Evolving
+ */
+PUBLIC MprSslCache *mprCreateSslCache(int maxSessions, MprTicks lifespan);
+
+/**
+    Get the default SSL session cache shared by all SSL providers
+    @return The default session cache object
+    @ingroup MprSslCache
+    @stability Evolving
+ */
+PUBLIC MprSslCache *mprGetSslCache();
+
+/**
+    Get the SSL session cache statistics
+    @description Use this to monitor the session resumption hit rate and whether the cache is large enough.
+        Pass the cache returned by #mprGetSslCache for the statistics of the cache shared by all SSL providers.
+    @param cache Session cache object returned from #mprCreateSslCache or #mprGetSslCache
+    @param stats Reference to a statistics structure to receive the statistics
+    @ingroup MprSslCache
+    @stability Evolving
+ */
+PUBLIC void mprGetSslCacheStats(MprSslCache *cache, MprSslCacheStats *stats);
+
+/**
+    Lookup an SSL session
+    @description Copy the state for a cached session into the supplied buffer. Expired sessions are removed and
+        are not returned.
+    @param cache Session cache object returned from #mprCreateSslCache
+    @param id Session ID
+    @param idLen Length of the session ID. Must be less than or equal to MPR_SSL_MAX_SESSION_ID.
+    @param buf Buffer to receive the session state
+    @param bufsize Size of buf
+    @return The length of the session state. Returns MPR_ERR_CANT_FIND if the session cannot be found, or
+        MPR_ERR_WONT_FIT if the buffer is too small.
+    @ingroup MprSslCache
+    @stability Evolving
+ */
+PUBLIC ssize mprLookupSslSession(MprSslCache *cache, cuchar *id, ssize idLen, void *buf, ssize bufsize);
+
+/**
+    Remove an SSL session from the cache
+    @param cache Session cache object returned from #mprCreateSslCache
+    @param id Session ID
+    @param idLen Length of the session ID
+    @ingroup MprSslCache
+    @stability Evolving
+ */
+PUBLIC void mprRemoveSslSession(MprSslCache *cache, cuchar *id, ssize idLen);
+
+/**
+    Store an SSL session in the cache
+    @description If a session with the same ID exists, it is replaced. If the cache is full, expired sessions are
+        removed and then the least recently used session is evicted.
+    @param cache Session cache object returned from #mprCreateSslCache
+    @param id Session ID
+    @param idLen Length of the session ID. Must be less than or equal to MPR_SSL_MAX_SESSION_ID.
+    @param data Opaque session state to store
+    @param len Length of the session state
+    @return Zero if successful, otherwise a negative MPR error code.
+    @ingroup MprSslCache
+    @stability Evolving
+ */
+PUBLIC int mprStoreSslSession(MprSslCache *cache, cuchar *id, ssize idLen, cvoid *data, ssize len);
+
+/*
+    SSL crypto worker defaults
+ */
+#ifndef BIT_MAX_SSL_CRYPTO_WORKERS
+    #define BIT_MAX_SSL_CRYPTO_WORKERS  2                   /**< Default max concurrent SSL crypto workers */
+#endif
+#define MPR_SSL_CRYPTO_QUEUE        1024                    /**< Max queued crypto jobs before running inline */
+
+/**
+    SSL crypto job callback
+    @description Called on a crypto worker thread to run an expensive SSL operation such as a private key 
+        decryption or signature. The callback must only access state owned by the job.
+    @param data Job data supplied to #mprStartSslJob
+    @ingroup MprSslCrypto
+    @stability Internal
+ */
+typedef void (*MprSslJobProc)(void *data);
+
+/**
+    SSL crypto worker statistics
+    @ingroup MprSslCrypto
+    @stability Evolving
+ */
+typedef struct MprSslCryptoStats {
+    int64       submitted;              /**< Jobs queued for the crypto workers */
+    int64       completed;              /**< Jobs completed by the crypto workers */
+    int64       overflow;               /**< Jobs run on the caller's thread because the queue was full */
+    int64       handshakes;             /**< Completed server handshakes */
+    MprTicks    queueTime;              /**< Total time jobs waited for a crypto worker */
+    MprTicks    cryptoTime;             /**< Total time spent running jobs */
+    MprTicks    handshakeTime;          /**< Total elapsed time of completed server handshakes */
+    MprTicks    maxHandshakeTime;       /**< Longest completed server handshake */
+    int         workers;                /**< Max concurrent crypto workers */
+    int         active;                 /**< Crypto workers currently running jobs */
+    int         queued;                 /**< Jobs currently waiting for a crypto worker */
+    int         maxQueued;              /**< High water mark of waiting jobs */
+} MprSslCryptoStats;
+
+/**
+    SSL crypto workers
+    @description Server SSL handshakes require private key operations that may take several milliseconds. Rather than
+        run these on the socket's dispatcher and stall I/O for other connections, SSL providers may suspend the 
+        socket and run the operation on a bounded pool of crypto workers. The socket resumes on its dispatcher when
+        the job completes.
+    @defgroup MprSslCrypto MprSslCrypto
+    @see mprGetSslCryptoStats mprRecordSslHandshake mprSetSslCryptoWorkers mprStartSslJob
+    @stability Internal
+ */
+typedef struct MprSslCrypto {
+    MprList         *queue;             /**< Jobs waiting for a crypto worker */
+    MprList         *running;           /**< Jobs running on a crypto worker */
+    MprMutex        *mutex;             /**< Multithread sync */
+    MprSslCryptoStats stats;            /**< Crypto worker statistics. Also holds the worker limit. */
+} MprSslCrypto;
+
+/**
+    Get the SSL crypto worker statistics
+    @param stats Reference to a statistics structure to receive the current statistics
+    @ingroup MprSslCrypto
+    @stability Evolving
+ */
+PUBLIC void mprGetSslCryptoStats(MprSslCryptoStats *stats);
+
+/**
+    Record the completion of a server SSL handshake for the crypto statistics
+    @param elapsed Elapsed time of the handshake
+    @ingroup MprSslCrypto
+    @stability Internal
+ */
+PUBLIC void mprRecordSslHandshake(MprTicks elapsed);
+
+/**
+    Set the number of SSL crypto workers
+    @description The crypto workers are drawn from the MPR worker pool. This sets the max number that may run crypto 
+        jobs concurrently. 
+    @param workers Max number of concurrent crypto workers. Set to zero to run SSL crypto operations on the socket
+        dispatcher.
+    @ingroup MprSslCrypto
+    @stability Evolving
+ */
+PUBLIC void mprSetSslCryptoWorkers(int workers);
+
+/**
+    Run an SSL crypto job on a crypto worker
+    @description The socket is suspended so no I/O events are delivered while the job runs. When the job completes, 
+        the socket is resumed and a readable I/O event is delivered on the socket's dispatcher so the provider can 
+        continue the handshake.
+    @param sp Socket awaiting the job
+    @param proc Job callback to run on a crypto worker
+    @param data Job data. This is retained until the job completes.
+    @return Zero if the job was queued. Returns MPR_ERR_BUSY if crypto workers are disabled, the queue is full or 
+        no worker thread is available. In that case, the socket is not suspended and the caller should run the job 
+        itself.
+    @ingroup MprSslCrypto
+    @stability Internal
+ */
+PUBLIC int mprStartSslJob(MprSocket *sp, MprSslJobProc proc, void *data);
+
 /******************************* Worker Threads *******************************/
 /**
     Worker thread callback signature
@@ -7716,6 +8143,49 @@ PUBLIC char *mprGetMD5(cchar *str);
  */
 PUBLIC char *mprGetMD5WithPrefix(cchar *buf, ssize len, cchar *prefix);
 
+#define MPR_MD5_HEX_SIZE    33          /**< Size of a hex MD5 checksum buffer including the trailing null */
+
+/**
+    MD5 checksum state for incremental checksums
+    @ingroup Mpr
+    @stability Prototype
+ */
+typedef struct MprMD5 {
+    uint    state[4];
+    uint    count[2];
+    uchar   buffer[64];
+} MprMD5;
+
+/**
+    Begin an incremental MD5 checksum
+    @description Use #mprUpdateMD5 to add data and #mprFinalizeMD5 to obtain the checksum. This does not allocate
+        memory and the state may be on the stack.
+    @param md5 MD5 state
+    @ingroup Mpr
+    @stability Prototype
+ */
+PUBLIC void mprInitMD5(MprMD5 *md5);
+
+/**
+    Add data to an incremental MD5 checksum
+    @param md5 MD5 state initialized by #mprInitMD5
+    @param buf Data to add
+    @param len Size of the data. Set to -1 if buf is a null terminated string.
+    @ingroup Mpr
+    @stability Prototype
+ */
+PUBLIC void mprUpdateMD5(MprMD5 *md5, cchar *buf, ssize len);
+
+/**
+    Complete an incremental MD5 checksum
+    @param md5 MD5 state initialized by #mprInitMD5. The state is cleared.
+    @param result Buffer of at least MPR_MD5_HEX_SIZE bytes to receive the null terminated hex checksum
+    @return The result buffer
+    @ingroup Mpr
+    @stability Prototype
+ */
+PUBLIC char *mprFinalizeMD5(MprMD5 *md5, char *result);
+
 /**
     Get an SHA1 checksum
     @param str String to examine
@@ -8404,23 +8874,42 @@ PUBLIC ssize mprWriteCmdBlock(MprCmd *cmd, int channel, char *buf, ssize bufsize
     In-memory caching. The MprCache provides a fast, in-memory caching of cache items. Cache items are string key / value 
     pairs. Cache items have a configurable lifespan and the Cache manager will automatically prune expired items. 
     Items also have an associated version number that can be used when writing to do transactional writes.
+    Keys are distributed over shards that are locked separately. The key and memory limits apply to the whole cache.
+    When a write exceeds the limits, the least recently used items in the shard being written are discarded first.
     @defgroup MprCache MprCache
     @see mprCreateCache mprDestroyCache mprExpireCache mprIncCache mprReadCache mprRemoveCache mprSetCacheLimits 
         mprWriteCache 
     @stability Internal
  */
 typedef struct MprCache {
-    MprHash         *store;             /**< Key/value store */
-    MprMutex        *mutex;             /**< Cache lock */
+    struct MprCacheShard **shards;      /**< Lock striped key/value stores */
+    int             numShards;          /**< Number of shards */
+    MprMutex        *mutex;             /**< Lock for the pruning timer */
     MprEvent        *timer;             /**< Pruning timer */
     MprTicks        lifespan;           /**< Default lifespan (msec) */
     int             resolution;         /**< Frequence for pruner */
-    ssize           usedMem;            /**< Memory in use for keys and data */
     ssize           maxKeys;            /**< Max number of keys */
     ssize           maxMem;             /**< Max memory for session data */
+    volatile int64  numKeys;            /**< Number of keys in all shards */
+    volatile int64  usedMem;            /**< Memory in use for keys and data in all shards */
     struct MprCache *shared;            /**< Shared common cache */
 } MprCache;
 
+/**
+    Cache shard. Items are kept in least recently used order for eviction.
+    @ingroup MprCache
+    @stability Internal
+ */
+typedef struct MprCacheShard {
+    struct MprCache *cache;             /**< Owning cache */
+    MprHash         *store;             /**< Key/value store */
+    MprMutex        *mutex;             /**< Shard lock */
+    struct CacheItem *oldest;           /**< Least recently used item */
+    struct CacheItem *newest;           /**< Most recently used item */
+    struct CacheItem *cursor;           /**< Next item to examine for expiry */
+    ssize           usedMem;            /**< Memory in use for keys and data */
+} MprCacheShard;
+
 /**
     Create a new cache object
     @param options Set of option flags. Select from #MPR_CACHE_SHARED, #MPR_CACHE_ADD, #MPR_CACHE_ADD, #MPR_CACHE_SET,
@@ -8464,6 +8953,8 @@ PUBLIC void mprGetCacheStats(MprCache *cache, int *numKeys, ssize *mem);
 
 /**
     Increment a numeric cache item
+    @description Numeric items are stored as integers. If the item does not exist, it is created with the default lifespan.
+        If the item has a string value, the value is converted to a number. Use an amount of zero to read the value.
     @param cache The cache instance object returned from #mprCreateCache.
     @param key Cache item key
     @param amount Numeric amount to increment the cache item. This may be a negative number to decrement the item.
@@ -8509,9 +9000,11 @@ PUBLIC bool mprRemoveCache(MprCache *cache, cchar *key);
 /**
     Set the cache resource limits
     @param cache The cache instance object returned from #mprCreateCache.
-    @param keys Set the maximum number of keys the cache can store
+    @param keys Set the maximum number of keys the cache can store. This limit applies to all shards together.
     @param lifespan Set the default lifespan for cache items in milliseconds
-    @param memory Memory limit in bytes for all cache keys and items.
+    @param memory Memory limit in bytes for all cache keys and items. This limit applies to all shards together.
+        Items are evicted from the shard being written first and then from other shards that are not locked by
+        other threads, so the cache may briefly exceed the limits while other shards are busy.
     @param resolution Set the cache item pruner resolution. This defines how frequently the cache manager will check
         items for expiration.
     @ingroup MprCache
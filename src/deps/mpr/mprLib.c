@@ -4287,34 +4287,57 @@ PUBLIC ssize mprPutStringToWideBuf(MprBuf *bp, cchar *str)
 
 static MprCache *shared;                /* Singleton shared cache */
 
+/*
+    Items are linked in least recently used order. The links are not marked as all items are held by the store.
+ */
 typedef struct CacheItem
 {
     char        *key;                   /* Original key */
-    char        *data;                  /* Cache data */
+    char        *data;                  /* Cache data. For numeric items, the formatted number once read */
+    struct CacheItem *older;            /* Next older item in the shard */
+    struct CacheItem *newer;            /* Next newer item in the shard */
+    int64       number;                 /* Value for numeric items */
     MprTicks    lifespan;               /* Lifespan after each access to key (msec) */
     MprTicks    lastAccessed;           /* Last accessed time */
     MprTicks    expires;                /* Fixed expiry date. If zero, key is imortal. */
     MprTime     lastModified;           /* Last update time. This is an MprTime and records world-time. */
     int64       version;
+    ssize       size;                   /* Memory accounted for the key and data */
+    int         numeric;                /* Item value is the number */
 } CacheItem;
 
 #define CACHE_TIMER_PERIOD      (60 * MPR_TICKS_PER_SEC)
 #define CACHE_LIFESPAN          (86400 * MPR_TICKS_PER_SEC)
-#define CACHE_HASH_SIZE         257
+#define CACHE_SHARDS            16
+#define CACHE_PRUNE_SAMPLE      64      /* Items examined per shard per prune pass */
+#define CACHE_PRUNE_PASSES      16      /* Maximum passes per shard per timer tick */
 
 /*********************************** Forwards *********************************/
 
+static MprCache *getCache(MprCache *cache);
+static MprCacheShard *getShard(MprCache *cache, cchar *key);
+static void clearShard(MprCacheShard *shard);
+static void evictItems(MprCache *cache, MprCacheShard *shard, CacheItem *keep);
+static void linkItem(MprCacheShard *shard, CacheItem *item);
 static void manageCache(MprCache *cache, int flags);
 static void manageCacheItem(CacheItem *item, int flags);
+static void manageCacheShard(MprCacheShard *shard, int flags);
+static bool overLimits(MprCache *cache);
 static void pruneCache(MprCache *cache, MprEvent *event);
-static void removeItem(MprCache *cache, CacheItem *item);
+static int pruneShard(MprCacheShard *shard, MprTicks now, int *examined);
+static void removeItem(MprCacheShard *shard, CacheItem *item);
+static void setItemSize(MprCacheShard *shard, CacheItem *item);
+static void startPruner(MprCache *cache);
+static void touchItem(MprCacheShard *shard, CacheItem *item);
+static void unlinkItem(MprCacheShard *shard, CacheItem *item);
 
 /************************************* Code ***********************************/
 
 PUBLIC MprCache *mprCreateCache(int options)
 {
-    MprCache    *cache;
-    int         wantShared;
+    MprCache        *cache;
+    MprCacheShard   *shard;
+    int             i, wantShared;
 
     if ((cache = mprAllocObj(MprCache, manageCache)) == 0) {
         return 0;
@@ -4324,7 +4347,19 @@ PUBLIC MprCache *mprCreateCache(int options)
         cache->shared = shared;
     } else {
         cache->mutex = mprCreateLock();
-        cache->store = mprCreateHash(CACHE_HASH_SIZE, 0);
+        if ((cache->shards = mprAllocZeroed(CACHE_SHARDS * sizeof(MprCacheShard*))) == 0) {
+            return 0;
+        }
+        for (i = 0; i < CACHE_SHARDS; i++) {
+            if ((shard = mprAllocObj(MprCacheShard, manageCacheShard)) == 0) {
+                return 0;
+            }
+            shard->cache = cache;
+            shard->store = mprCreateHash(0, MPR_HASH_OPEN | MPR_HASH_STATIC_KEYS);
+            shard->mutex = mprCreateLock();
+            cache->shards[i] = shard;
+            cache->numShards++;
+        }
         cache->maxMem = MAXSSIZE;
         cache->maxKeys = MAXSSIZE;
         cache->resolution = CACHE_TIMER_PERIOD;
@@ -4352,89 +4387,116 @@ PUBLIC void *mprDestroyCache(MprCache *cache)
 }
 
 
+static MprCache *getCache(MprCache *cache)
+{
+    if (cache->shared) {
+        cache = cache->shared;
+        assert(cache == shared);
+    }
+    return cache;
+}
+
+
+static MprCacheShard *getShard(MprCache *cache, cchar *key)
+{
+    return cache->shards[shash(key, slen(key)) % cache->numShards];
+}
+
+
 /*
     Set expires to zero to remove
  */
 PUBLIC int mprExpireCacheItem(MprCache *cache, cchar *key, MprTicks expires)
 {
-    CacheItem   *item;
+    MprCacheShard   *shard;
+    CacheItem       *item;
 
     assert(cache);
     assert(key && *key);
 
-    if (cache->shared) {
-        cache = cache->shared;
-        assert(cache == shared);
-    }
-    lock(cache);
-    if ((item = mprLookupKey(cache->store, key)) == 0) {
-        unlock(cache);
+    cache = getCache(cache);
+    shard = getShard(cache, key);
+    lock(shard);
+    if ((item = mprLookupKey(shard->store, key)) == 0) {
+        unlock(shard);
         return MPR_ERR_CANT_FIND;
     }
     if (expires == 0) {
-        removeItem(cache, item);
+        removeItem(shard, item);
     } else {
         item->expires = expires;
     }
-    unlock(cache);
+    unlock(shard);
     return 0;
 }
 
 
 PUBLIC int64 mprIncCache(MprCache *cache, cchar *key, int64 amount)
 {
-    CacheItem   *item;
-    int64       value;
+    MprCacheShard   *shard;
+    CacheItem       *item;
+    int64           value;
 
     assert(cache);
     assert(key && *key);
 
-    if (cache->shared) {
-        cache = cache->shared;
-        assert(cache == shared);
-    }
-    value = amount;
-
-    lock(cache);
-    if ((item = mprLookupKey(cache->store, key)) == 0) {
+    cache = getCache(cache);
+    shard = getShard(cache, key);
+    lock(shard);
+    if ((item = mprLookupKey(shard->store, key)) == 0) {
         if ((item = mprAllocObj(CacheItem, manageCacheItem)) == 0) {
+            unlock(shard);
             return 0;
         }
+        item->key = sclone(key);
+        item->lifespan = cache->lifespan;
+        item->numeric = 1;
+        mprAddKey(shard->store, item->key, item);
+        mprAtomicAdd64(&cache->numKeys, 1);
+        linkItem(shard, item);
     } else {
-        value += stoi(item->data);
+        if (!item->numeric) {
+            item->number = stoi(item->data);
+            item->numeric = 1;
+        }
+        touchItem(shard, item);
     }
-    if (item->data) {
-        cache->usedMem -= slen(item->data);
+    value = item->number += amount;
+    if (amount) {
+        item->data = 0;
+        item->version++;
     }
-    item->data = itos(value);
-    cache->usedMem += slen(item->data);
-    item->version++;
+    setItemSize(shard, item);
     item->lastAccessed = mprGetTicks();
     item->expires = item->lastAccessed + item->lifespan;
-    unlock(cache);
+    evictItems(cache, shard, item);
+    unlock(shard);
+    startPruner(cache);
     return value;
 }
 
 
 PUBLIC char *mprReadCache(MprCache *cache, cchar *key, MprTime *modified, int64 *version)
 {
-    CacheItem   *item;
-    char        *result;
+    MprCacheShard   *shard;
+    CacheItem       *item;
+    MprTicks        now;
+    char            *result;
 
     assert(cache);
     assert(key && *key);
 
-    if (cache->shared) {
-        cache = cache->shared;
-        assert(cache == shared);
-    }
-    lock(cache);
-    if ((item = mprLookupKey(cache->store, key)) == 0) {
-        unlock(cache);
+    cache = getCache(cache);
+    shard = getShard(cache, key);
+    now = mprGetTicks();
+    lock(shard);
+    if ((item = mprLookupKey(shard->store, key)) == 0) {
+        unlock(shard);
         return 0;
     }
-    if (item->expires && item->expires <= mprGetTicks()) {
-        unlock(cache);
+    if (item->expires && item->expires <= now) {
+        removeItem(shard, item);
+        unlock(shard);
         return 0;
     }
     if (version) {
@@ -4443,43 +4505,50 @@ PUBLIC char *mprReadCache(MprCache *cache, cchar *key, MprTime *modified, int64
     if (modified) {
         *modified = item->lastModified;
     }
-    item->lastAccessed = mprGetTicks();
+    if (item->numeric && !item->data) {
+        item->data = itos(item->number);
+    }
+    item->lastAccessed = now;
     item->expires = item->lastAccessed + item->lifespan;
+    touchItem(shard, item);
     result = item->data;
-    unlock(cache);
+    unlock(shard);
     return result;
 }
 
 
 PUBLIC bool mprRemoveCache(MprCache *cache, cchar *key)
 {
-    CacheItem   *item;
-    bool        result;
+    MprCacheShard   *shard;
+    CacheItem       *item;
+    bool            result;
+    int             i;
 
     assert(cache);
-    assert(key && *key);
 
-    if (cache->shared) {
-        cache = cache->shared;
-        assert(cache == shared);
-    }
-    lock(cache);
+    cache = getCache(cache);
+    result = 0;
     if (key) {
-        if ((item = mprLookupKey(cache->store, key)) != 0) {
-            cache->usedMem -= (slen(key) + slen(item->data));
-            mprRemoveKey(cache->store, key);
+        shard = getShard(cache, key);
+        lock(shard);
+        if ((item = mprLookupKey(shard->store, key)) != 0) {
+            removeItem(shard, item);
             result = 1;
-        } else {
-            result = 0;
         }
+        unlock(shard);
 
     } else {
         /* Remove all keys */
-        result = mprGetHashLength(cache->store) ? 1 : 0;
-        cache->store = mprCreateHash(CACHE_HASH_SIZE, 0);
-        cache->usedMem = 0;
+        for (i = 0; i < cache->numShards; i++) {
+            shard = cache->shards[i];
+            lock(shard);
+            if (mprGetHashLength(shard->store)) {
+                result = 1;
+            }
+            clearShard(shard);
+            unlock(shard);
+        }
     }
-    unlock(cache);
     return result;
 }
 
@@ -4488,10 +4557,7 @@ PUBLIC void mprSetCacheLimits(MprCache *cache, int64 keys, MprTicks lifespan, in
 {
     assert(cache);
 
-    if (cache->shared) {
-        cache = cache->shared;
-        assert(cache == shared);
-    }
+    cache = getCache(cache);
     if (keys > 0) {
         cache->maxKeys = (ssize) keys;
         if (cache->maxKeys <= 0) {
@@ -4518,20 +4584,18 @@ PUBLIC void mprSetCacheLimits(MprCache *cache, int64 keys, MprTicks lifespan, in
 
 PUBLIC ssize mprWriteCache(MprCache *cache, cchar *key, cchar *value, MprTime modified, MprTicks lifespan, int64 version, int options)
 {
-    CacheItem   *item;
-    MprKey      *kp;
-    ssize       len, oldLen;
-    int         exists, add, set, prepend, append, throw;
+    MprCacheShard   *shard;
+    CacheItem       *item;
+    MprKey          *kp;
+    ssize           len;
+    int             exists, add, set, prepend, append;
 
     assert(cache);
     assert(key && *key);
     assert(value);
 
-    if (cache->shared) {
-        cache = cache->shared;
-        assert(cache == shared);
-    }
-    exists = add = prepend = append = throw = 0;
+    cache = getCache(cache);
+    exists = add = prepend = append = 0;
     add = options & MPR_CACHE_ADD;
     append = options & MPR_CACHE_APPEND;
     prepend = options & MPR_CACHE_PREPEND;
@@ -4539,32 +4603,41 @@ PUBLIC ssize mprWriteCache(MprCache *cache, cchar *key, cchar *value, MprTime mo
     if ((add + append + prepend) == 0) {
         set = 1;
     }
-    lock(cache);
-    if ((kp = mprLookupKeyEntry(cache->store, key)) != 0) {
+    shard = getShard(cache, key);
+    lock(shard);
+    if ((kp = mprLookupKeyEntry(shard->store, key)) != 0) {
         exists++;
         item = (CacheItem*) kp->data;
         if (version) {
             if (item->version != version) {
-                unlock(cache);
+                unlock(shard);
                 return MPR_ERR_BAD_STATE;
             }
         }
+        if (add) {
+            unlock(shard);
+            return 0;
+        }
+        if (item->numeric) {
+            if (!item->data) {
+                item->data = itos(item->number);
+            }
+            item->numeric = 0;
+        }
+        touchItem(shard, item);
     } else {
         if ((item = mprAllocObj(CacheItem, manageCacheItem)) == 0) {
-            unlock(cache);
+            unlock(shard);
             return 0;
         }
-        mprAddKey(cache->store, key, item);
         item->key = sclone(key);
+        item->lifespan = cache->lifespan;
+        mprAddKey(shard->store, item->key, item);
+        mprAtomicAdd64(&cache->numKeys, 1);
+        linkItem(shard, item);
         set = 1;
     }
-    oldLen = (item->data) ? (slen(item->key) + slen(item->data)) : 0;
-    if (set) {
-        item->data = sclone(value);
-    } else if (add) {
-        if (exists) {
-            return 0;
-        }
+    if (set || add) {
         item->data = sclone(value);
     } else if (append) {
         item->data = sjoin(item->data, value, NULL);
@@ -4578,37 +4651,182 @@ PUBLIC ssize mprWriteCache(MprCache *cache, cchar *key, cchar *value, MprTime mo
     item->lastAccessed = mprGetTicks();
     item->expires = item->lastAccessed + item->lifespan;
     item->version++;
-    len = slen(item->key) + slen(item->data);
-    cache->usedMem += (len - oldLen);
+    setItemSize(shard, item);
+    len = item->size;
+    evictItems(cache, shard, item);
+    unlock(shard);
+    startPruner(cache);
+    return len;
+}
 
+
+static void startPruner(MprCache *cache)
+{
     if (cache->timer == 0) {
-        mprTrace(5, "Start Cache pruner with resolution %d", cache->resolution);
-        cache->timer = mprCreateTimerEvent(MPR->dispatcher, "localCacheTimer", cache->resolution, pruneCache, cache, 
-            MPR_EVENT_STATIC_DATA); 
+        lock(cache);
+        if (cache->timer == 0) {
+            mprTrace(5, "Start Cache pruner with resolution %d", cache->resolution);
+            cache->timer = mprCreateTimerEvent(MPR->dispatcher, "localCacheTimer", cache->resolution, pruneCache, cache, 
+                MPR_EVENT_STATIC_DATA); 
+        }
+        unlock(cache);
     }
-    unlock(cache);
-    return len;
 }
 
 
-static void removeItem(MprCache *cache, CacheItem *item)
+/*
+    Link an item as the most recently used. Caller must hold the shard lock.
+ */
+static void linkItem(MprCacheShard *shard, CacheItem *item)
 {
-    assert(cache);
+    item->newer = 0;
+    item->older = shard->newest;
+    if (shard->newest) {
+        shard->newest->newer = item;
+    } else {
+        shard->oldest = item;
+    }
+    shard->newest = item;
+}
+
+
+static void unlinkItem(MprCacheShard *shard, CacheItem *item)
+{
+    if (shard->cursor == item) {
+        shard->cursor = item->newer;
+    }
+    if (item->older) {
+        item->older->newer = item->newer;
+    } else {
+        shard->oldest = item->newer;
+    }
+    if (item->newer) {
+        item->newer->older = item->older;
+    } else {
+        shard->newest = item->older;
+    }
+    item->older = item->newer = 0;
+}
+
+
+static void touchItem(MprCacheShard *shard, CacheItem *item)
+{
+    if (shard->newest != item) {
+        unlinkItem(shard, item);
+        linkItem(shard, item);
+    }
+}
+
+
+static void setItemSize(MprCacheShard *shard, CacheItem *item)
+{
+    ssize   size;
+
+    size = slen(item->key) + (item->numeric ? sizeof(int64) : slen(item->data));
+    shard->usedMem += size - item->size;
+    mprAtomicAdd64(&shard->cache->usedMem, size - item->size);
+    item->size = size;
+}
+
+
+/*
+    Caller must hold the shard lock
+ */
+static void removeItem(MprCacheShard *shard, CacheItem *item)
+{
+    assert(shard);
     assert(item);
 
-    lock(cache);
-    mprRemoveKey(cache->store, item->key);
-    cache->usedMem -= (slen(item->key) + slen(item->data));
-    unlock(cache);
+    unlinkItem(shard, item);
+    mprRemoveKey(shard->store, item->key);
+    shard->usedMem -= item->size;
+    mprAtomicAdd64(&shard->cache->numKeys, -1);
+    mprAtomicAdd64(&shard->cache->usedMem, -item->size);
+}
+
+
+static void clearShard(MprCacheShard *shard)
+{
+    mprAtomicAdd64(&shard->cache->numKeys, -mprGetHashLength(shard->store));
+    mprAtomicAdd64(&shard->cache->usedMem, -shard->usedMem);
+    shard->store = mprCreateHash(0, MPR_HASH_OPEN | MPR_HASH_STATIC_KEYS);
+    shard->oldest = shard->newest = shard->cursor = 0;
+    shard->usedMem = 0;
+}
+
+
+/*
+    Test if the cache exceeds its key or memory limits. The counts are kept for the whole cache.
+ */
+static bool overLimits(MprCache *cache)
+{
+    return cache->numKeys > cache->maxKeys || cache->usedMem > cache->maxMem;
+}
+
+
+/*
+    Discard the least recently used items while the cache exceeds its limits. Items are discarded from the shard being
+    written first, then from other shards that can be locked without waiting. Caller must hold the shard lock.
+ */
+static void evictItems(MprCache *cache, MprCacheShard *shard, CacheItem *keep)
+{
+    MprCacheShard   *other;
+    int             i;
+
+    while (overLimits(cache) && shard->oldest && shard->oldest != keep) {
+        mprTrace(5, "Cache too big, prune key %s", shard->oldest->key);
+        removeItem(shard, shard->oldest);
+    }
+    for (i = 0; i < cache->numShards && overLimits(cache); i++) {
+        other = cache->shards[i];
+        if (other == shard || !mprTryLock(other->mutex)) {
+            continue;
+        }
+        while (overLimits(cache) && other->oldest) {
+            mprTrace(5, "Cache too big, prune key %s", other->oldest->key);
+            removeItem(other, other->oldest);
+        }
+        unlock(other);
+    }
+}
+
+
+/*
+    Examine a sample of items for expiry, continuing from where the previous pass stopped. Returns the number of
+    expired items removed. Caller must hold the shard lock.
+ */
+static int pruneShard(MprCacheShard *shard, MprTicks now, int *examined)
+{
+    CacheItem   *item, *next;
+    int         expired;
+
+    expired = *examined = 0;
+    if (!shard->cursor) {
+        shard->cursor = shard->oldest;
+    }
+    for (item = shard->cursor; item && *examined < CACHE_PRUNE_SAMPLE; item = next) {
+        next = item->newer;
+        if (item->expires && item->expires <= now) {
+            mprTrace(5, "Cache prune expired key %s", item->key);
+            removeItem(shard, item);
+            expired++;
+        }
+        (*examined)++;
+    }
+    shard->cursor = item;
+    return expired;
 }
 
 
+/*
+    Expired items are pruned incrementally. Each tick examines a sample of items in each shard and continues while
+    a quarter or more of the sample has expired. Items are also removed when found expired on access.
+ */
 static void pruneCache(MprCache *cache, MprEvent *event)
 {
-    MprTicks        when, factor;
-    MprKey          *kp;
-    CacheItem       *item;
-    ssize           excessKeys;
+    MprCacheShard   *shard;
+    MprTicks        now;
+    int             i, pass, expired, examined, count;
 
     if (!cache) {
         cache = shared;
@@ -4616,58 +4834,36 @@ static void pruneCache(MprCache *cache, MprEvent *event)
             return;
         }
     }
-    if (event) {
-        when = mprGetTicks();
-    } else {
-        /* Expire all items by setting event to NULL */
-        when = MAXINT64;
-    }
-    if (mprTryLock(cache->mutex)) {
-        /*
-            Check for expired items
-         */
-        for (kp = 0; (kp = mprGetNextKey(cache->store, kp)) != 0; ) {
-            item = (CacheItem*) kp->data;
-            mprTrace(6, "Cache: \"%s\" lifespan %d, expires in %d secs", item->key, 
-                    item->lifespan / 1000, (item->expires - when) / 1000);
-            if (item->expires && item->expires <= when) {
-                mprTrace(5, "Cache prune expired key %s", kp->key);
-                removeItem(cache, item);
-            }
+    cache = getCache(cache);
+    count = 0;
+    now = mprGetTicks();
+    for (i = 0; i < cache->numShards; i++) {
+        shard = cache->shards[i];
+        if (!event) {
+            /* Expire all items */
+            lock(shard);
+            clearShard(shard);
+            unlock(shard);
+            continue;
         }
-        assert(cache->usedMem >= 0);
-
-        /*
-            If too many keys or too much memory used, prune keys that expire soonest.
-         */
-        if (cache->maxKeys < MAXSSIZE || cache->maxMem < MAXSSIZE) {
-            /*
-                Look for those expiring in the next 5 minutes, then 20 mins, then 80 ...
-             */
-            excessKeys = mprGetHashLength(cache->store) - cache->maxKeys;
-            factor = 5 * 60 * MPR_TICKS_PER_SEC; 
-            when += factor;
-            while (excessKeys > 0 || cache->usedMem > cache->maxMem) {
-                for (kp = 0; (kp = mprGetNextKey(cache->store, kp)) != 0; ) {
-                    item = (CacheItem*) kp->data;
-                    if (item->expires && item->expires <= when) {
-                        mprTrace(5, "Cache too big execess keys %Ld, mem %Ld, prune key %s", 
-                                excessKeys, (cache->maxMem - cache->usedMem), kp->key);
-                        removeItem(cache, item);
-                    }
+        if (mprTryLock(shard->mutex)) {
+            for (pass = 0; pass < CACHE_PRUNE_PASSES; pass++) {
+                expired = pruneShard(shard, now, &examined);
+                if (examined < CACHE_PRUNE_SAMPLE || expired < (examined / 4)) {
+                    break;
                 }
-                factor *= 4;
-                when += factor;
-            }
-        }
-        assert(cache->usedMem >= 0);
-
-        if (mprGetHashLength(cache->store) == 0) {
-            if (event) {
-                mprRemoveEvent(event);
-                cache->timer = 0;
             }
+            assert(shard->usedMem >= 0);
+            count += mprGetHashLength(shard->store);
+            unlock(shard);
+        } else {
+            count++;
         }
+    }
+    if (count == 0 && event) {
+        lock(cache);
+        mprRemoveEvent(event);
+        cache->timer = 0;
         unlock(cache);
     }
 }
@@ -4681,8 +4877,13 @@ PUBLIC void mprPruneCache(MprCache *cache)
 
 static void manageCache(MprCache *cache, int flags) 
 {
+    int     i;
+
     if (flags & MPR_MANAGE_MARK) {
-        mprMark(cache->store);
+        mprMark(cache->shards);
+        for (i = 0; i < cache->numShards; i++) {
+            mprMark(cache->shards[i]);
+        }
         mprMark(cache->mutex);
         mprMark(cache->timer);
         mprMark(cache->shared);
@@ -4695,6 +4896,15 @@ static void manageCache(MprCache *cache, int flags)
 }
 
 
+static void manageCacheShard(MprCacheShard *shard, int flags) 
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(shard->store);
+        mprMark(shard->mutex);
+    }
+}
+
+
 static void manageCacheItem(CacheItem *item, int flags) 
 {
     if (flags & MPR_MANAGE_MARK) {
@@ -4706,11 +4916,25 @@ static void manageCacheItem(CacheItem *item, int flags)
 
 PUBLIC void mprGetCacheStats(MprCache *cache, int *numKeys, ssize *mem)
 {
+    MprCacheShard   *shard;
+    ssize           used;
+    int             i, count;
+
+    cache = getCache(cache);
+    count = 0;
+    used = 0;
+    for (i = 0; i < cache->numShards; i++) {
+        shard = cache->shards[i];
+        lock(shard);
+        count += mprGetHashLength(shard->store);
+        used += shard->usedMem;
+        unlock(shard);
+    }
     if (numKeys) {
-        *numKeys = mprGetHashLength(cache->store);
+        *numKeys = count;
     }
     if (mem) {
-        *mem = cache->usedMem;
+        *mem = used;
     }
 }
 
@@ -6888,11 +7112,7 @@ static uchar PADDING[64] = {
     (a) += (b); \
 }
 
-typedef struct {
-    uint state[4];
-    uint count[2];
-    uchar buffer[64];
-} MD5CONTEXT;
+typedef MprMD5 MD5CONTEXT;
 
 /******************************* Base 64 Data *********************************/
 
@@ -7129,25 +7349,13 @@ PUBLIC char *mprGetMD5(cchar *s)
 PUBLIC char *mprGetMD5WithPrefix(cchar *buf, ssize length, cchar *prefix)
 {
     MD5CONTEXT      context;
-    uchar           hash[CRYPT_HASH_SIZE];
-    cchar           *hex = "0123456789abcdef";
-    char            *r, *str;
-    char            result[(CRYPT_HASH_SIZE * 2) + 1];
+    char            *str;
+    char            result[MPR_MD5_HEX_SIZE];
     ssize           len;
-    int             i;
-
-    if (length < 0) {
-        length = slen(buf);
-    }
-    initMD5(&context);
-    update(&context, (uchar*) buf, (uint) length);
-    finalizeMD5(hash, &context);
 
-    for (i = 0, r = result; i < 16; i++) {
-        *r++ = hex[hash[i] >> 4];
-        *r++ = hex[hash[i] & 0xF];
-    }
-    *r = '\0';
+    mprInitMD5(&context);
+    mprUpdateMD5(&context, buf, length);
+    mprFinalizeMD5(&context, result);
     len = (prefix) ? slen(prefix) : 0;
     str = mprAlloc(sizeof(result) + len);
     if (str) {
@@ -7160,6 +7368,41 @@ PUBLIC char *mprGetMD5WithPrefix(cchar *buf, ssize length, cchar *prefix)
 }
 
 
+PUBLIC void mprInitMD5(MprMD5 *md5)
+{
+    initMD5(md5);
+}
+
+
+PUBLIC void mprUpdateMD5(MprMD5 *md5, cchar *buf, ssize len)
+{
+    if (len < 0) {
+        len = slen(buf);
+    }
+    update(md5, (uchar*) buf, (uint) len);
+}
+
+
+/*
+    Write the hex checksum into the caller's buffer which must be at least MPR_MD5_HEX_SIZE bytes
+ */
+PUBLIC char *mprFinalizeMD5(MprMD5 *md5, char *result)
+{
+    uchar       hash[CRYPT_HASH_SIZE];
+    cchar       *hex = "0123456789abcdef";
+    char        *r;
+    int         i;
+
+    finalizeMD5(hash, md5);
+    for (i = 0, r = result; i < CRYPT_HASH_SIZE; i++) {
+        *r++ = hex[hash[i] >> 4];
+        *r++ = hex[hash[i] & 0xF];
+    }
+    *r = '\0';
+    return result;
+}
+
+
 /*
     MD5 initialization. Begins an MD5 operation, writing a new context.
  */ 
@@ -8329,6 +8572,7 @@ static int getPathInfo(MprDiskFileSystem *fs, cchar *path, MprPath *info)
     info->owner = s.st_uid;
     info->group = s.st_gid;
     info->inode = s.st_ino;
+    info->dev = s.st_dev;
     info->isDir = (s.st_mode & S_IFDIR) != 0;
     info->isReg = (s.st_mode & S_IFREG) != 0;
     info->isLink = 0;
@@ -8376,6 +8620,7 @@ static int getPathInfo(MprDiskFileSystem *fs, cchar *path, MprPath *info)
     info->owner = s.st_uid;
     info->group = s.st_gid;
     info->inode = s.st_ino;
+    info->dev = s.st_dev;
     info->isDir = (s.st_mode & S_IFDIR) != 0;
     info->isReg = (s.st_mode & S_IFREG) != 0;
     info->isLink = 0;
@@ -8436,6 +8681,7 @@ static int getPathInfo(MprDiskFileSystem *fs, cchar *path, MprPath *info)
     info->ctime = s.st_ctime;
     info->mtime = s.st_mtime;
     info->inode = s.st_ino;
+    info->dev = s.st_dev;
     info->isDir = S_ISDIR(s.st_mode);
     info->isReg = S_ISREG(s.st_mode);
     info->perms = s.st_mode & 07777;
@@ -8464,6 +8710,7 @@ static int getPathInfo(MprDiskFileSystem *fs, cchar *path, MprPath *info)
     info->ctime = s.st_ctime;
     info->mtime = s.st_mtime;
     info->inode = s.st_ino;
+    info->dev = s.st_dev;
     info->isDir = S_ISDIR(s.st_mode);
     info->isReg = S_ISREG(s.st_mode);
     info->perms = s.st_mode & 07777;
@@ -8872,12 +9119,26 @@ PUBLIC int mprServiceEvents(MprTicks timeout, int flags)
         mprServiceSignals();
 
         while ((dp = getNextReadyDispatcher(es)) != NULL) {
+            /*
+                The dispatcher is owned by the worker until it is dequeued after running events. A thread in
+                mprWaitForEvent may have claimed the dispatcher since it was selected.
+             */
+            lock(es);
+            if (isRunning(dp)) {
+                unlock(es);
+                continue;
+            }
             queueDispatcher(es->runQ, dp);
+            dp->flags |= MPR_DISPATCHER_WORKER;
+            unlock(es);
             if (dp->flags & MPR_DISPATCHER_IMMEDIATE) {
                 dispatchEventsWorker(dp);
 
             } else if (mprStartWorker((MprWorkerProc) dispatchEventsWorker, dp) < 0) {
+                lock(es);
+                dp->flags &= ~MPR_DISPATCHER_WORKER;
                 queueDispatcher(es->pendingQ, dp);
+                unlock(es);
                 continue;
             }
             if (justOne) {
@@ -8938,7 +9199,9 @@ PUBLIC int mprWaitForEvent(MprDispatcher *dispatcher, MprTicks timeout)
 
     lock(es);
     wasRunning = isRunning(dispatcher);
-    runEvents = (!wasRunning || !dispatcher->owner || dispatcher->owner == thread);
+    /* A dispatcher given to a worker has no owner until the worker starts running events */
+    runEvents = (!wasRunning || dispatcher->owner == thread ||
+        (!dispatcher->owner && !(dispatcher->flags & MPR_DISPATCHER_WORKER)));
     if (runEvents && !wasRunning) {
         queueDispatcher(es->runQ, dispatcher);
     }
@@ -8960,7 +9223,9 @@ PUBLIC int mprWaitForEvent(MprDispatcher *dispatcher, MprTicks timeout)
 
         nevents = mprWaitForCond(dispatcher->cond, delay);
         mprResetYield();
+        lock(es);
         dispatcher->flags &= ~MPR_DISPATCHER_WAITING;
+        unlock(es);
 
         if (nevents == 0) {
             if (runEvents) {
@@ -9170,9 +9435,15 @@ static int dispatchEvents(MprDispatcher *dispatcher)
  */
 static void dispatchEventsWorker(MprDispatcher *dispatcher)
 {
+    MprEventService     *es;
+
     dispatchEvents(dispatcher);
     if (!(dispatcher->flags == MPR_DISPATCHER_DESTROYED)) {
+        es = dispatcher->service;
+        lock(es);
+        dispatcher->flags &= ~MPR_DISPATCHER_WORKER;
         dequeueDispatcher(dispatcher);
+        unlock(es);
         mprScheduleDispatcher(dispatcher);
     }
 }
@@ -11140,12 +11411,20 @@ PUBLIC void mprSetPathNewline(cchar *path, cchar *newline)
     This module is not thread-safe. It is the callers responsibility to perform all thread synchronization.
     There is locking solely for the purpose of synchronization with the GC marker()
 
+    Tables created with MPR_HASH_OPEN use open addressing for single owner tables such as request headers. The entries
+    are stored inline in a power of two sized slot array with a cached hash code and a control byte per slot. The
+    control byte holds the low 7 bits of the hash code for a full slot so that a group of 16 slots can be tested with
+    one SIMD compare before any key is compared. Removed slots are marked as deleted so iteration may continue while
+    keys are removed.
+
     Copyright (c) All Rights Reserved. See details at the end of the file.
  */
 
 /********************************** Includes **********************************/
 
-
+#if __SSE2__
+    #include <emmintrin.h>
+#endif
 
 /********************************** Defines ***********************************/
 
@@ -11153,11 +11432,28 @@ PUBLIC void mprSetPathNewline(cchar *path, cchar *newline)
     #define BIT_MAX_HASH 23           /* Default initial hash size */
 #endif
 
+#define HASH_GROUP      16            /* Slots probed together for MPR_HASH_OPEN tables */
+#define HASH_EMPTY      0x80          /* Control byte for an empty slot */
+#define HASH_DELETED    0xFE          /* Control byte for a removed slot */
+#define HASH_FULL(c)    (((c) & 0x80) == 0)
+
+#define ADD_DUPLICATE   0x1           /* Add even if the key exists */
+#define ADD_SHARED      0x2           /* Use the caller's permanent key rather than a copy */
+
 /********************************** Forwards **********************************/
 
+static MprKey *addKey(MprHash *hash, cvoid *key, cvoid *ptr, int flags);
+static MprKey *addOpenKey(MprHash *hash, cvoid *key, cvoid *ptr, int flags);
+static uint availableGroup(uchar *ctrl);
 static void *dupKey(MprHash *hash, cvoid *key);
+static int findOpenKey(MprHash *hash, cvoid *key, uint code);
+static int findOpenSlot(MprHash *hash, uint code);
 static MprKey *lookupHash(int *index, MprKey **prevSp, MprHash *hash, cvoid *key);
+static int lowestBit(uint bits);
 static void manageHashTable(MprHash *hash, int flags);
+static uint matchGroup(uchar *ctrl, int value);
+static uint openHashCode(MprHash *hash, cvoid *key);
+static int resizeOpenHash(MprHash *hash, int size);
 
 /*********************************** Code *************************************/
 /*
@@ -11168,17 +11464,24 @@ PUBLIC MprHash *mprCreateHash(int hashSize, int flags)
 {
     MprHash     *hash;
 
-    if ((hash = mprAllocObjNoZero(MprHash, manageHashTable)) == 0) {
+    if ((hash = mprAllocObj(MprHash, manageHashTable)) == 0) {
         return 0;
     }
     if (hashSize < BIT_MAX_HASH) {
         hashSize = BIT_MAX_HASH;
     }
-    if ((hash->buckets = mprAllocZeroed(sizeof(MprKey*) * hashSize)) == 0) {
-        return NULL;
+    if (flags & MPR_HASH_OPEN) {
+        flags |= MPR_HASH_OWN;
+        if (resizeOpenHash(hash, hashSize) < 0) {
+            return NULL;
+        }
+    } else {
+        if ((hash->buckets = mprAllocZeroed(sizeof(MprKey*) * hashSize)) == 0) {
+            return NULL;
+        }
+        hash->size = hashSize;
     }
     hash->flags = flags | MPR_OBJ_HASH;
-    hash->size = hashSize;
     hash->length = 0;
     if (!(flags & MPR_HASH_OWN)) {
         hash->mutex = mprCreateLock();
@@ -11213,6 +11516,22 @@ static void manageHashTable(MprHash *hash, int flags)
     if (flags & MPR_MANAGE_MARK) {
         mprMark(hash->mutex);
         mprMark(hash->buckets);
+        if (hash->slots) {
+            /* Codes and ctrl are in the same block */
+            mprMark(hash->slots);
+            for (i = 0; i < hash->size; i++) {
+                if (HASH_FULL(hash->ctrl[i])) {
+                    sp = &hash->slots[i];
+                    if (!(hash->flags & MPR_HASH_STATIC_VALUES)) {
+                        mprMark(sp->data);
+                    }
+                    if (!(hash->flags & MPR_HASH_STATIC_KEYS)) {
+                        mprMark(sp->key);
+                    }
+                }
+            }
+            return;
+        }
         lock(hash);
         for (i = 0; i < hash->size; i++) {
             for (sp = (MprKey*) hash->buckets[i]; sp; sp = sp->next) {
@@ -11243,13 +11562,31 @@ static void manageHashTable(MprHash *hash, int flags)
  */
 PUBLIC MprKey *mprAddKey(MprHash *hash, cvoid *key, cvoid *ptr)
 {
-    MprKey      *sp, *prevSp;
+    return addKey(hash, key, ptr, 0);
+}
+
+
+/*
+    Add a key without copying it. The key must be permanent: a held block if the table marks keys.
+ */
+PUBLIC MprKey *mprAddSharedKey(MprHash *hash, cvoid *key, cvoid *ptr)
+{
+    return addKey(hash, key, ptr, ADD_SHARED);
+}
+
+
+static MprKey *addKey(MprHash *hash, cvoid *key, cvoid *ptr, int flags)
+{
+    MprKey      *sp, *prevSp;
     int         index;
 
     if (hash == 0) {
         assert(hash);
         return 0;
     }
+    if (hash->flags & MPR_HASH_OPEN) {
+        return addOpenKey(hash, key, ptr, flags);
+    }
     lock(hash);
     if ((sp = lookupHash(&index, &prevSp, hash, key)) != 0) {
         if (hash->flags & MPR_HASH_UNIQUE) {
@@ -11271,7 +11608,7 @@ PUBLIC MprKey *mprAddKey(MprHash *hash, cvoid *key, cvoid *ptr)
         return 0;
     }
     sp->data = ptr;
-    if (!(hash->flags & MPR_HASH_STATIC_KEYS)) {
+    if (!(hash->flags & MPR_HASH_STATIC_KEYS) && !(flags & ADD_SHARED)) {
         sp->key = dupKey(hash, key);
     } else {
         sp->key = (void*) key;
@@ -11322,6 +11659,9 @@ PUBLIC MprKey *mprAddDuplicateKey(MprHash *hash, cvoid *key, cvoid *ptr)
     assert(hash);
     assert(key);
 
+    if (hash->flags & MPR_HASH_OPEN) {
+        return addOpenKey(hash, key, ptr, ADD_DUPLICATE);
+    }
     if ((sp = mprAllocStructNoZero(MprKey)) == 0) {
         return 0;
     }
@@ -11351,6 +11691,23 @@ PUBLIC int mprRemoveKey(MprHash *hash, cvoid *key)
     assert(hash);
     assert(key);
 
+    if (hash->flags & MPR_HASH_OPEN) {
+        if ((index = findOpenKey(hash, key, 0)) < 0) {
+            return MPR_ERR_CANT_FIND;
+        }
+        /*
+            A slot may be marked empty if its group has an empty slot as no probe can have continued past the group.
+            The entry is left intact so an iteration in progress can continue from it.
+         */
+        if (matchGroup(&hash->ctrl[index & ~(HASH_GROUP - 1)], HASH_EMPTY)) {
+            hash->ctrl[index] = HASH_EMPTY;
+        } else {
+            hash->ctrl[index] = HASH_DELETED;
+            hash->deleted++;
+        }
+        hash->length--;
+        return 0;
+    }
     lock(hash);
     if ((sp = lookupHash(&index, &prevSp, hash, key)) == 0) {
         unlock(hash);
@@ -11456,6 +11813,15 @@ static MprKey *lookupHash(int *bucketIndex, MprKey **prevSp, MprHash *hash, cvoi
     if (key == 0 || hash == 0) {
         return 0;
     }
+    if (hash->flags & MPR_HASH_OPEN) {
+        if ((index = findOpenKey(hash, key, 0)) < 0) {
+            return 0;
+        }
+        if (bucketIndex) {
+            *bucketIndex = index;
+        }
+        return &hash->slots[index];
+    }
     if (hash->length > hash->size) {
         hashSize = getHashSize(hash->length * 4 / 3);
         if (hash->size < hashSize) {
@@ -11538,6 +11904,14 @@ PUBLIC MprKey *mprGetFirstKey(MprHash *hash)
     if (!hash) {
         return 0;
     }
+    if (hash->flags & MPR_HASH_OPEN) {
+        for (i = 0; i < hash->size; i++) {
+            if (HASH_FULL(hash->ctrl[i])) {
+                return &hash->slots[i];
+            }
+        }
+        return 0;
+    }
     for (i = 0; i < hash->size; i++) {
         if ((sp = (MprKey*) hash->buckets[i]) != 0) {
             return sp;
@@ -11561,6 +11935,14 @@ PUBLIC MprKey *mprGetNextKey(MprHash *hash, MprKey *last)
     if (last == 0) {
         return mprGetFirstKey(hash);
     }
+    if (hash->flags & MPR_HASH_OPEN) {
+        for (i = last->bucket + 1; i < hash->size; i++) {
+            if (HASH_FULL(hash->ctrl[i])) {
+                return &hash->slots[i];
+            }
+        }
+        return 0;
+    }
     if (last->next) {
         return last->next;
     }
@@ -11584,6 +11966,224 @@ static void *dupKey(MprHash *hash, cvoid *key)
 }
 
 
+/*
+    Return a bit mask of the slots in a group of HASH_GROUP control bytes that match the value
+ */
+static uint matchGroup(uchar *ctrl, int value)
+{
+#if __SSE2__
+    return (uint) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i*) ctrl), _mm_set1_epi8((char) value)));
+#else
+    uint    bits;
+    int     i;
+
+    for (bits = 0, i = 0; i < HASH_GROUP; i++) {
+        if (ctrl[i] == (uchar) value) {
+            bits |= 1 << i;
+        }
+    }
+    return bits;
+#endif
+}
+
+
+/*
+    Return a bit mask of the empty or removed slots in a group
+ */
+static uint availableGroup(uchar *ctrl)
+{
+#if __SSE2__
+    return (uint) _mm_movemask_epi8(_mm_loadu_si128((__m128i*) ctrl));
+#else
+    uint    bits;
+    int     i;
+
+    for (bits = 0, i = 0; i < HASH_GROUP; i++) {
+        if (!HASH_FULL(ctrl[i])) {
+            bits |= 1 << i;
+        }
+    }
+    return bits;
+#endif
+}
+
+
+static int lowestBit(uint bits)
+{
+#if __GNUC__
+    return __builtin_ctz(bits);
+#else
+    int     i;
+
+    for (i = 0; !(bits & 1); i++) {
+        bits >>= 1;
+    }
+    return i;
+#endif
+}
+
+
+/*
+    Mix the hash code as the string hash functions do not distribute the low bits well
+ */
+static uint openHashCode(MprHash *hash, cvoid *key)
+{
+    uint    code;
+
+    code = hash->fn(key, slen(key));
+    code ^= code >> 16;
+    code *= 0x45d9f3b;
+    code ^= code >> 16;
+    return code;
+}
+
+
+/*
+    Find the slot holding a key. The low 7 bits of the code are stored in the control byte, the remaining bits
+    select the first group to probe. Groups are probed in a triangular sequence which visits every group when the
+    number of groups is a power of two. Returns the slot index or -1 if not found.
+ */
+static int findOpenKey(MprHash *hash, cvoid *key, uint code)
+{
+    uchar   *group;
+    uint    bits, mask;
+    int     pos, step, i;
+
+    if (code == 0) {
+        code = openHashCode(hash, key);
+    }
+    mask = hash->size - 1;
+    pos = (int) ((code >> 7) & mask & ~(HASH_GROUP - 1));
+    for (step = HASH_GROUP; step <= hash->size; step += HASH_GROUP) {
+        group = &hash->ctrl[pos];
+        for (bits = matchGroup(group, code & 0x7F); bits; bits &= bits - 1) {
+            i = pos + lowestBit(bits);
+            if (hash->codes[i] == code) {
+                if (hash->flags & MPR_HASH_CASELESS) {
+                    if (scaselessmatch(hash->slots[i].key, key)) {
+                        return i;
+                    }
+                } else if (smatch(hash->slots[i].key, key)) {
+                    return i;
+                }
+            }
+        }
+        if (matchGroup(group, HASH_EMPTY)) {
+            break;
+        }
+        pos = (pos + step) & mask;
+    }
+    return -1;
+}
+
+
+/*
+    Find an empty or removed slot for a new key with the given code
+ */
+static int findOpenSlot(MprHash *hash, uint code)
+{
+    uint    bits, mask;
+    int     pos, step;
+
+    mask = hash->size - 1;
+    pos = (int) ((code >> 7) & mask & ~(HASH_GROUP - 1));
+    for (step = HASH_GROUP; ; step += HASH_GROUP) {
+        if ((bits = availableGroup(&hash->ctrl[pos])) != 0) {
+            return pos + lowestBit(bits);
+        }
+        pos = (pos + step) & mask;
+    }
+}
+
+
+/*
+    Allocate a slot array for at least the given number of slots and reinsert the current entries using the cached
+    hash codes. The slots, codes and control bytes are allocated as one block.
+ */
+static int resizeOpenHash(MprHash *hash, int size)
+{
+    MprKey  *oldSlots;
+    uchar   *oldCtrl, *block;
+    uint    *oldCodes;
+    int     oldSize, i, index;
+
+    size = max(size, HASH_GROUP);
+    for (i = HASH_GROUP; i < size; i <<= 1) { }
+    size = i;
+
+    if ((block = mprAlloc(size * (sizeof(MprKey) + sizeof(uint) + 1))) == 0) {
+        return MPR_ERR_MEMORY;
+    }
+    oldSlots = hash->slots;
+    oldCodes = hash->codes;
+    oldCtrl = hash->ctrl;
+    oldSize = hash->size;
+
+    hash->slots = (MprKey*) block;
+    hash->codes = (uint*) &block[size * sizeof(MprKey)];
+    hash->ctrl = &block[size * (sizeof(MprKey) + sizeof(uint))];
+    hash->size = size;
+    hash->deleted = 0;
+    memset(hash->ctrl, HASH_EMPTY, size);
+
+    if (oldSlots) {
+        for (i = 0; i < oldSize; i++) {
+            if (HASH_FULL(oldCtrl[i])) {
+                index = findOpenSlot(hash, oldCodes[i]);
+                hash->slots[index] = oldSlots[i];
+                hash->slots[index].bucket = index;
+                hash->codes[index] = oldCodes[i];
+                hash->ctrl[index] = oldCtrl[i];
+            }
+        }
+    }
+    return 0;
+}
+
+
+/*
+    Add a key to an open addressing table. The table is kept at most 7/8 full including removed slots so every
+    probe sequence ends at an empty slot.
+ */
+static MprKey *addOpenKey(MprHash *hash, cvoid *key, cvoid *ptr, int flags)
+{
+    MprKey  *sp;
+    uint    code;
+    int     index, size;
+
+    code = openHashCode(hash, key);
+    if (!(flags & ADD_DUPLICATE) && (index = findOpenKey(hash, key, code)) >= 0) {
+        if (hash->flags & MPR_HASH_UNIQUE) {
+            return 0;
+        }
+        sp = &hash->slots[index];
+        sp->data = ptr;
+        return sp;
+    }
+    if ((hash->length + hash->deleted + 1) * 8 > hash->size * 7) {
+        /* Grow if more than half full otherwise rehash at the same size to discard removed slots */
+        size = ((hash->length + 1) * 2 > hash->size) ? hash->size * 2 : hash->size;
+        if (resizeOpenHash(hash, size) < 0) {
+            return 0;
+        }
+    }
+    index = findOpenSlot(hash, code);
+    if (hash->ctrl[index] == HASH_DELETED) {
+        hash->deleted--;
+    }
+    sp = &hash->slots[index];
+    sp->next = 0;
+    sp->data = ptr;
+    sp->key = (hash->flags & MPR_HASH_STATIC_KEYS || flags & ADD_SHARED) ? (void*) key : dupKey(hash, key);
+    sp->type = 0;
+    sp->bucket = index;
+    hash->codes[index] = code;
+    hash->ctrl[index] = code & 0x7F;
+    hash->length++;
+    return sp;
+}
+
+
 PUBLIC MprHash *mprCreateHashFromWords(cchar *str)
 {
     MprHash     *hash;
@@ -11673,10 +12273,47 @@ PUBLIC char *mprHashKeysToString(MprHash *hash, cchar *join)
 
 
 
+#if __SSE2__
+    #include <emmintrin.h>
+#endif
+
+/*********************************** Locals ***********************************/
+
+#define TAPE_BLOCK          64          /* Bytes indexed per block. One bit per byte in a uint64 mask */
+
+/*
+    Tape parse states
+ */
+#define TAPE_VALUE          1           /* Expect a value */
+#define TAPE_VALUE_OR_END   2           /* Expect the first array value or "]" */
+#define TAPE_KEY            3           /* Expect an object key or "}" */
+#define TAPE_COLON          4           /* Expect ":" after a key */
+#define TAPE_NEXT           5           /* Expect "," or the end of the object or array */
+#define TAPE_DONE           6           /* Parsed the top level object or array */
+#define TAPE_FAILED         7           /* Syntax not supported by the tape */
+
+
 /****************************** Forward Declarations **************************/
 
+static MprJsonNode *addNode(MprJsonTape *tape, int container);
 static MprObj *deserialize(MprJson *jp, MprObj *obj);
 static char advanceToken(MprJson *jp);
+static void classifyBlock(cchar *block, uint64 *quote, uint64 *backslash, uint64 *op, uint64 *space);
+static ssize estimateJson(MprObj *obj, int type, int flags);
+static uint64 findEscaped(uint64 backslash, uint64 *carry);
+static int indexBlock(MprJsonTape *tape, cchar *block);
+static void indexTape(MprJsonTape *tape, int finish);
+static int lowestBit64(uint64 bits);
+static MprHash *makeTapeObj(MprJsonNode *np);
+static void manageJsonTape(MprJsonTape *tape, int flags);
+static int parseStructural(MprJsonTape *tape, int index, int finish);
+static void parseTape(MprJsonTape *tape, int finish);
+static uint64 prefixXor(uint64 bits);
+static char *putJsonMember(MprBuf *buf, char *cp, MprKey *kp, int withKey, int flags);
+static char *quoteJson(char *cp, cchar *str, ssize len);
+static char *reserveJson(MprBuf *buf, char *cp, ssize need);
+static int serializeJson(MprBuf *buf, MprObj *obj, int type, int flags);
+static void tapeToHash(MprJsonTape *tape, int index, MprHash *obj);
 static cchar *findEndKeyword(MprJson *jp, cchar *str);
 static cchar *findQuote(cchar *tok, int quote);
 static MprObj *makeObj(MprJson *jp, bool list);
@@ -11918,243 +12555,885 @@ static cchar *parseValue(MprJson *jp)
 }
 
 
-static int setValue(MprJson *jp, MprObj *obj, int index, cchar *key, cchar *value, int type)
+static int setValue(MprJson *jp, MprObj *obj, int index, cchar *key, cchar *value, int type)
+{
+    MprKey  *kp;
+    char    keybuf[32];
+
+    if (index >= 0) {
+        itosbuf(keybuf, sizeof(keybuf), index, 10);
+        key = keybuf;
+    }
+    if ((kp = mprAddKey(obj, key, value)) == 0) {
+        return MPR_ERR_MEMORY;
+    }
+    kp->type = type;
+    return 0;
+}
+
+
+static MprObj *makeObj(MprJson *jp, bool list)
+{
+    MprHash     *hash;
+
+    if ((hash = mprCreateHash(0, 0)) == 0) {
+        return 0;
+    }
+    if (list) {
+        hash->flags |= MPR_HASH_LIST;
+    }
+    return hash;
+}
+
+
+/*
+    Estimate the serialized length of an object tree excluding escapes. This permits the output buffer to be sized once.
+ */
+static ssize estimateJson(MprObj *obj, int type, int flags)
+{
+    MprKey  *kp;
+    ssize   size;
+
+    size = 4;
+    if (type != MPR_JSON_ARRAY && type != MPR_JSON_OBJ) {
+        return size;
+    }
+    for (ITERATE_KEYS(obj, kp)) {
+        if (kp->key == 0 || kp->data == 0) {
+            continue;
+        }
+        /* Indent, quotes, separator, comma and new line */
+        size += 12;
+        if (type == MPR_JSON_OBJ) {
+            size += slen(kp->key);
+        }
+        if (kp->type == MPR_JSON_ARRAY || kp->type == MPR_JSON_OBJ) {
+            size += estimateJson((MprObj*) kp->data, kp->type, flags);
+        } else {
+            size += slen(kp->data);
+        }
+    }
+    return size;
+}
+
+
+/*
+    Ensure there is room for the given length at the write position. Returns the (possibly moved) write position.
+ */
+static char *reserveJson(MprBuf *buf, char *cp, ssize need)
+{
+    buf->end = cp;
+    if ((buf->endbuf - cp) < need && mprGrowBuf(buf, need) < 0) {
+        return 0;
+    }
+    return buf->end;
+}
+
+
+/*
+    Write a quoted string value. Single quotes are escaped. Strings are scanned and copied 16 bytes at a time.
+    The caller must reserve twice the string length plus the quotes.
+ */
+static char *quoteJson(char *cp, cchar *str, ssize len)
+{
+    cchar   *end;
+#if __SSE2__
+    __m128i chunk, quote;
+    int     i;
+#endif
+
+    end = &str[len];
+    *cp++ = '"';
+#if __SSE2__
+    quote = _mm_set1_epi8('\'');
+    while ((end - str) >= 16) {
+        chunk = _mm_loadu_si128((const __m128i*) str);
+        _mm_storeu_si128((__m128i*) cp, chunk);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)) == 0) {
+            str += 16;
+            cp += 16;
+            continue;
+        }
+        for (i = 0; i < 16; i++, str++) {
+            if (*str == '\'') {
+                *cp++ = '\\';
+            }
+            *cp++ = *str;
+        }
+    }
+#endif
+    for (; str < end; str++) {
+        if (*str == '\'') {
+            *cp++ = '\\';
+        }
+        *cp++ = *str;
+    }
+    *cp++ = '"';
+    return cp;
+}
+
+
+/*
+    Write an object or array member. On return, there is room for at least 8 more bytes at the write position.
+ */
+static char *putJsonMember(MprBuf *buf, char *cp, MprKey *kp, int withKey, int flags)
+{
+    ssize   klen, vlen;
+    int     nested;
+
+    nested = (kp->type == MPR_JSON_ARRAY || kp->type == MPR_JSON_OBJ);
+    klen = withKey ? slen(kp->key) : 0;
+    vlen = nested ? 0 : slen(kp->data);
+    if ((cp = reserveJson(buf, cp, klen + vlen * 2 + 16)) == 0) {
+        return 0;
+    }
+    if (flags & MPR_JSON_PRETTY) {
+        memcpy(cp, "    ", 4);
+        cp += 4;
+    }
+    if (withKey) {
+        if (flags & MPR_JSON_QUOTES) *cp++ = '"';
+        memcpy(cp, kp->key, klen);
+        cp += klen;
+        if (flags & MPR_JSON_QUOTES) *cp++ = '"';
+        *cp++ = ':';
+        if (flags & MPR_JSON_PRETTY) *cp++ = ' ';
+    }
+    if (nested) {
+        buf->end = cp;
+        if (serializeJson(buf, (MprObj*) kp->data, kp->type, flags) < 0) {
+            return 0;
+        }
+        return reserveJson(buf, buf->end, 8);
+    }
+    return quoteJson(cp, kp->data, vlen);
+}
+
+
+/*
+    Supports hashes where properties are strings or hashes of strings. N-level nest is supported.
+    Output is written directly at the end of the buffer.
+ */
+static int serializeJson(MprBuf *buf, MprObj *obj, int type, int flags)
+{
+    MprKey  *kp;
+    char    numbuf[32], *cp;
+    int     i, len, pretty;
+
+    pretty = flags & MPR_JSON_PRETTY;
+    if ((cp = reserveJson(buf, buf->end, 8)) == 0) {
+        return MPR_ERR_MEMORY;
+    }
+    if (type == MPR_JSON_ARRAY) {
+        *cp++ = '[';
+        if (pretty) *cp++ = '\n';
+        len = mprGetHashLength(obj);
+        for (i = 0; i < len; i++) {
+            itosbuf(numbuf, sizeof(numbuf), i, 10);
+            if ((kp = mprLookupKeyEntry(obj, numbuf)) == 0) {
+                assert(kp);
+                continue;
+            }
+            if ((cp = putJsonMember(buf, cp, kp, 0, flags)) == 0) {
+                return MPR_ERR_MEMORY;
+            }
+            if ((i+1) < len) {
+                *cp++ = ',';
+            }
+            if (pretty) *cp++ = '\n';
+        }
+        *cp++ = ']';
+
+    } else if (type == MPR_JSON_OBJ) {
+        *cp++ = '{';
+        if (pretty) *cp++ = '\n';
+        for (kp = mprGetFirstKey(obj); kp; ) {
+            if (kp->key == 0 || kp->data == 0) {
+                kp = mprGetNextKey(obj, kp);
+                continue;
+            }
+            if ((cp = putJsonMember(buf, cp, kp, 1, flags)) == 0) {
+                return MPR_ERR_MEMORY;
+            }
+            kp = mprGetNextKey(obj, kp);
+            if (kp) {
+                *cp++ = ',';
+            }
+            if (pretty) *cp++ = '\n';
+        }
+        *cp++ = '}';
+    }
+    if (pretty) *cp++ = '\n';
+    buf->end = cp;
+    return 0;
+}
+
+
+/*
+    Serialize into JSON format at the end of a buffer. The buffer is sized once for the estimated length.
+ */
+PUBLIC ssize mprSerializeInto(MprObj *obj, MprBuf *buf, int flags)
+{
+    ssize   len, size;
+
+    len = mprGetBufLength(buf);
+    size = estimateJson(obj, MPR_JSON_OBJ, flags) + 1;
+    if (mprGetBufSpace(buf) < size && mprGrowBuf(buf, size - mprGetBufSpace(buf)) < 0) {
+        return MPR_ERR_MEMORY;
+    }
+    if (serializeJson(buf, obj, MPR_JSON_OBJ, flags) < 0) {
+        return MPR_ERR_MEMORY;
+    }
+    mprAddNullToBuf(buf);
+    return mprGetBufLength(buf) - len;
+}
+
+
+/*
+    Serialize into JSON format.
+ */
+PUBLIC cchar *mprSerialize(MprObj *obj, int flags)
+{
+    MprBuf  *buf;
+
+    if ((buf = mprCreateBuf(0, 0)) == 0) {
+        return 0;
+    }
+    if (mprSerializeInto(obj, buf, flags) < 0) {
+        return 0;
+    }
+    return mprGetBuf(buf);
+}
+
+
+static char advanceToken(MprJson *jp)
+{
+    while (isspace((uchar) *jp->tok)) {
+        if (*jp->tok == '\n') {
+            jp->lineNumber++;
+        }
+        jp->tok++;
+    }
+    return *jp->tok;
+}
+
+
+static cchar *findQuote(cchar *tok, int quote)
+{
+    cchar   *cp;
+
+    assert(tok);
+    for (cp = tok; *cp; cp++) {
+        if (*cp == quote && (cp == tok || *cp != '\\')) {
+            return cp;
+        }
+    }
+    return 0;
+}
+
+
+static cchar *findEndKeyword(MprJson *jp, cchar *str)
+{
+    cchar   *cp, *etok;
+
+    assert(str);
+    for (cp = jp->tok; *cp; cp++) {
+        if ((etok = strpbrk(cp, " \t\n\r:,}]")) != 0) {
+            if (etok == jp->tok || *etok != '\\') {
+                return etok;
+            }
+        }
+    }
+    return &str[strlen(str)];
+}
+
+
+static void jsonParseError(MprJson *jp, cchar *msg)
+{
+    if (jp->path) {
+        mprTrace(4, "%s\nIn file '%s' at line %d", msg, jp->path, jp->lineNumber);
+    } else {
+        mprTrace(4, "%s\nAt line %d", msg, jp->lineNumber);
+    }
+}
+
+
+PUBLIC void mprJsonParseError(MprJson *jp, cchar *fmt, ...)
+{
+    va_list     args;
+    cchar       *msg;
+
+    va_start(args, fmt);
+    msg = sfmtv(fmt, args);
+    (jp->callback.parseError)(jp, msg);
+    va_end(args);
+}
+
+
+/*
+    Currently only works for MprHash implementations
+ */
+PUBLIC cchar *mprQueryJsonString(MprHash *obj, cchar *key)
+{
+    MprKey  *kp;
+    char    *property, *tok;
+
+    for (property = stok(sclone(key), ".", &tok); property; property = stok(0, ".", &tok)) {
+        if ((kp = mprLookupKeyEntry(obj, property)) == 0) {
+            return 0;
+        }
+        if (tok == 0) {
+            return (kp->type == MPR_JSON_STRING) ? kp->data : NULL;
+        }
+        if (kp->type != MPR_JSON_OBJ) {
+            return 0;
+        }
+        obj = (MprHash*) kp->data;
+    }
+    return 0;
+}
+
+
+/*
+    Currently only works for MprHash implementations
+ */
+PUBLIC void *mprQueryJsonValue(MprHash *obj, cchar *key, int type)
+{
+    MprKey  *kp;
+    char    *property, *tok;
+
+    for (property = stok(sclone(key), ".", &tok); property; property = stok(0, ".", &tok)) {
+        if ((kp = mprLookupKeyEntry(obj, property)) == 0) {
+            return 0;
+        }
+        if (tok == 0) {
+            return (void*) ((kp->type == type) ? kp->data : NULL);
+        }
+        if (kp->type != MPR_JSON_OBJ) {
+            return 0;
+        }
+        obj = (MprHash*) kp->data;
+    }
+    return 0;
+}
+
+
+/*
+    Streaming JSON tape parser. Input is appended to the document buffer and indexed in 64 byte blocks (stage one).
+    Each block is classified into bit masks of quotes, backslashes, structural characters and white space. Escaped
+    quotes are removed and a prefix XOR of the quote mask yields the characters inside strings. The offsets of
+    structural characters outside strings, all quotes and the first character of primitive values are appended to
+    the structurals index. The index is then parsed into nodes (stage two). Carries between blocks and the parser
+    state allow the document to be written in pieces of any size.
+ */
+PUBLIC MprJsonTape *mprCreateJsonTape(ssize size)
+{
+    MprJsonTape     *tape;
+
+    if ((tape = mprAllocObj(MprJsonTape, manageJsonTape)) == 0) {
+        return 0;
+    }
+    tape->docSize = max(size, 0) + 1;
+    tape->nodeSize = (int) min(max(size / 16, 64), MAXINT / 2);
+    tape->structuralSize = TAPE_BLOCK * 16;
+    tape->stackSize = 16;
+    tape->doc = mprAlloc(tape->docSize);
+    tape->nodes = mprAlloc(tape->nodeSize * sizeof(MprJsonNode));
+    tape->structurals = mprAlloc(tape->structuralSize * sizeof(int));
+    tape->stack = mprAlloc(tape->stackSize * sizeof(int));
+    if (!tape->doc || !tape->nodes || !tape->structurals || !tape->stack) {
+        return 0;
+    }
+    tape->doc[0] = '\0';
+    tape->state = TAPE_VALUE;
+    return tape;
+}
+
+
+static void manageJsonTape(MprJsonTape *tape, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(tape->nodes);
+        mprMark(tape->doc);
+        mprMark(tape->structurals);
+        mprMark(tape->stack);
+    }
+}
+
+
+PUBLIC int mprWriteJsonTape(MprJsonTape *tape, cchar *buf, ssize len)
+{
+    if (len <= 0) {
+        return 0;
+    }
+    if ((tape->length + len) >= tape->docSize) {
+        tape->docSize = max(tape->docSize * 2, tape->length + len + 1);
+        if ((tape->doc = mprRealloc(tape->doc, tape->docSize)) == 0) {
+            return MPR_ERR_MEMORY;
+        }
+    }
+    memcpy(&tape->doc[tape->length], buf, len);
+    tape->length += len;
+    tape->doc[tape->length] = '\0';
+    if (tape->state != TAPE_FAILED) {
+        indexTape(tape, 0);
+        parseTape(tape, 0);
+    }
+    return 0;
+}
+
+
+PUBLIC int mprFinishJsonTape(MprJsonTape *tape)
+{
+    if (tape->state != TAPE_FAILED) {
+        indexTape(tape, 1);
+        parseTape(tape, 1);
+    }
+    if (tape->state != TAPE_DONE) {
+        tape->state = TAPE_FAILED;
+        return MPR_ERR_BAD_FORMAT;
+    }
+    return 0;
+}
+
+
+PUBLIC MprBuf *mprGetJsonTapeBuf(MprJsonTape *tape)
+{
+    MprBuf      *bp;
+
+    if ((bp = mprAllocObj(MprBuf, manageBuf)) == 0) {
+        return 0;
+    }
+    bp->data = bp->start = tape->doc;
+    bp->end = &tape->doc[tape->length];
+    bp->endbuf = &tape->doc[tape->docSize];
+    bp->buflen = tape->docSize;
+    bp->maxsize = -1;
+    bp->growBy = BIT_MAX_BUFFER;
+    return bp;
+}
+
+
+/*
+    Stage one: index all complete blocks. When finishing, the final partial block is padded with spaces.
+ */
+static void indexTape(MprJsonTape *tape, int finish)
 {
-    MprKey  *kp;
-    char    keybuf[32];
+    char    block[TAPE_BLOCK];
+    ssize   remaining;
 
-    if (index >= 0) {
-        itosbuf(keybuf, sizeof(keybuf), index, 10);
-        key = keybuf;
+    while ((tape->scanned + TAPE_BLOCK) <= tape->length) {
+        if (indexBlock(tape, &tape->doc[tape->scanned]) < 0) {
+            return;
+        }
     }
-    if ((kp = mprAddKey(obj, key, value)) == 0) {
-        return MPR_ERR_MEMORY;
+    remaining = tape->length - tape->scanned;
+    if (finish && remaining > 0) {
+        memset(block, ' ', sizeof(block));
+        memcpy(block, &tape->doc[tape->scanned], remaining);
+        indexBlock(tape, block);
     }
-    kp->type = type;
-    return 0;
 }
 
 
-static MprObj *makeObj(MprJson *jp, bool list)
+static int indexBlock(MprJsonTape *tape, cchar *block)
 {
-    MprHash     *hash;
+    uint64  quote, backslash, op, space, escaped, inString, primitive, bits;
+    int     offset, *sp;
 
-    if ((hash = mprCreateHash(0, 0)) == 0) {
-        return 0;
+    if ((tape->numStructurals + TAPE_BLOCK) > tape->structuralSize) {
+        tape->structuralSize *= 2;
+        if ((tape->structurals = mprRealloc(tape->structurals, tape->structuralSize * sizeof(int))) == 0) {
+            tape->state = TAPE_FAILED;
+            return MPR_ERR_MEMORY;
+        }
     }
-    if (list) {
-        hash->flags |= MPR_HASH_LIST;
+    classifyBlock(block, &quote, &backslash, &op, &space);
+
+    escaped = findEscaped(backslash, &tape->escaped);
+    quote &= ~escaped;
+    inString = prefixXor(quote) ^ tape->inString;
+    tape->inString = (uint64) ((int64) inString >> 63);
+
+    primitive = ~(op | space | quote | inString);
+    bits = (op & ~inString) | quote | (primitive & ~((primitive << 1) | tape->primitive));
+    tape->primitive = primitive >> 63;
+
+    offset = (int) tape->scanned;
+    sp = &tape->structurals[tape->numStructurals];
+    while (bits) {
+        *sp++ = offset + lowestBit64(bits);
+        bits &= bits - 1;
     }
-    return hash;
+    tape->numStructurals = (int) (sp - tape->structurals);
+    tape->scanned += TAPE_BLOCK;
+    return 0;
 }
 
 
-static void quoteValue(MprBuf *buf, cchar *str)
+/*
+    Compute bit masks for the quotes, backslashes, structural operators and white space in a block
+ */
+static void classifyBlock(cchar *block, uint64 *quote, uint64 *backslash, uint64 *op, uint64 *space)
 {
-    cchar   *cp;
+#if __SSE2__
+    __m128i     chunk, ops, ws;
+    uint64      q, b, o, s;
+    int         i;
+
+    q = b = o = s = 0;
+    for (i = 0; i < TAPE_BLOCK; i += 16) {
+        chunk = _mm_loadu_si128((const __m128i*) &block[i]);
+        ops = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('{')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('}'))),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('[')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8(']'))));
+        ops = _mm_or_si128(ops,
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8(','))));
+        ws = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))));
+        q |= (uint64) (uint) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))) << i;
+        b |= (uint64) (uint) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))) << i;
+        o |= (uint64) (uint) _mm_movemask_epi8(ops) << i;
+        s |= (uint64) (uint) _mm_movemask_epi8(ws) << i;
+    }
+    *quote = q;
+    *backslash = b;
+    *op = o;
+    *space = s;
+#else
+    uint64      bit;
+    int         i;
 
-    mprPutCharToBuf(buf, '"');
-    for (cp = str; *cp; cp++) {
-        if (*cp == '\'') {
-            mprPutCharToBuf(buf, '\\');
+    *quote = *backslash = *op = *space = 0;
+    for (i = 0, bit = 1; i < TAPE_BLOCK; i++, bit <<= 1) {
+        switch (block[i]) {
+        case '"':
+            *quote |= bit;
+            break;
+        case '\\':
+            *backslash |= bit;
+            break;
+        case '{': case '}': case '[': case ']': case ':': case ',':
+            *op |= bit;
+            break;
+        case ' ': case '\t': case '\n': case '\r':
+            *space |= bit;
+            break;
         }
-        mprPutCharToBuf(buf, *cp);
     }
-    mprPutCharToBuf(buf, '"');
+#endif
 }
 
 
 /*
-    Supports hashes where properties are strings or hashes of strings. N-level nest is supported.
+    Return a mask of the characters escaped by an odd length sequence of backslashes. The carry is set if the next
+    block starts with an escaped character.
  */
-static cchar *objToString(MprBuf *buf, MprObj *obj, int type, int flags)
+static uint64 findEscaped(uint64 backslash, uint64 *carry)
 {
-    MprKey  *kp;
-    char    numbuf[32];
-    int     i, len, quotes, pretty;
-
-    pretty = flags & MPR_JSON_PRETTY;
-    quotes = flags & MPR_JSON_QUOTES;
-
-    if (type == MPR_JSON_ARRAY) {
-        mprPutCharToBuf(buf, '[');
-        if (pretty) mprPutCharToBuf(buf, '\n');
-        len = mprGetHashLength(obj);
-        for (i = 0; i < len; i++) {
-            itosbuf(numbuf, sizeof(numbuf), i, 10);
-            if (pretty) mprPutStringToBuf(buf, "    ");
-            if ((kp = mprLookupKeyEntry(obj, numbuf)) == 0) {
-                assert(kp);
-                continue;
-            }
-            if (kp->type == MPR_JSON_ARRAY || kp->type == MPR_JSON_OBJ) {
-                objToString(buf, (MprObj*) kp->data, kp->type, flags);
-            } else {
-                quoteValue(buf, kp->data);
-            }
-            if ((i+1) < len) {
-                mprPutCharToBuf(buf, ',');
-            }
-            if (pretty) mprPutCharToBuf(buf, '\n');
-        }
-        mprPutCharToBuf(buf, ']');
+    uint64  even, followsEscape, oddStarts, evenSequences;
 
-    } else if (type == MPR_JSON_OBJ) {
-        mprPutCharToBuf(buf, '{');
-        if (pretty) mprPutCharToBuf(buf, '\n');
-        for (kp = mprGetFirstKey(obj); kp; ) {
-            if (kp->key == 0 || kp->data == 0) continue;
-            if (pretty) mprPutStringToBuf(buf, "    ");
-            if (quotes) mprPutCharToBuf(buf, '"');
-            mprPutStringToBuf(buf, kp->key);
-            if (quotes) mprPutCharToBuf(buf, '"');
-            if (pretty) {
-                mprPutStringToBuf(buf, ": ");
-            } else {
-                mprPutCharToBuf(buf, ':');
-            }
-            if (kp->type == MPR_JSON_ARRAY || kp->type == MPR_JSON_OBJ) {
-                objToString(buf, (MprObj*) kp->data, kp->type, flags);
-            } else {
-                quoteValue(buf, kp->data);
-            }
-            kp = mprGetNextKey(obj, kp);
-            if (kp) {
-                mprPutCharToBuf(buf, ',');
-            }
-            if (pretty) mprPutCharToBuf(buf, '\n');
-        }
-        mprPutCharToBuf(buf, '}');
-    }
-    if (pretty) mprPutCharToBuf(buf, '\n');
-    return sclone(mprGetBufStart(buf));
+    even = 0x5555555555555555ULL;
+    backslash &= ~*carry;
+    followsEscape = (backslash << 1) | *carry;
+    oddStarts = backslash & ~even & ~followsEscape;
+    evenSequences = oddStarts + backslash;
+    *carry = evenSequences < oddStarts;
+    return (even ^ (evenSequences << 1)) & followsEscape;
 }
 
 
 /*
-    Serialize into JSON format.
+    Set each bit to the XOR of itself and all lower bits. For a quote mask, this sets the bits inside strings.
  */
-PUBLIC cchar *mprSerialize(MprObj *obj, int flags)
+static uint64 prefixXor(uint64 bits)
 {
-    MprBuf  *buf;
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
 
-    if ((buf = mprCreateBuf(0, 0)) == 0) {
-        return 0;
+
+static int lowestBit64(uint64 bits)
+{
+#if __GNUC__
+    return __builtin_ctzll(bits);
+#else
+    int     i;
+
+    for (i = 0; !(bits & 1); i++) {
+        bits >>= 1;
     }
-    objToString(buf, obj, MPR_JSON_OBJ, flags);
-    return mprGetBuf(buf);
+    return i;
+#endif
 }
 
 
-static char advanceToken(MprJson *jp)
+/*
+    Stage two: parse the indexed structurals into nodes. Strings require the closing quote and primitive values require
+    the following delimiter, so parsing stops at the last complete value unless finishing.
+ */
+static void parseTape(MprJsonTape *tape, int finish)
 {
-    while (isspace((uchar) *jp->tok)) {
-        if (*jp->tok == '\n') {
-            jp->lineNumber++;
+    int     i, n;
+
+    for (i = 0; i < tape->numStructurals && tape->state != TAPE_FAILED; i += n) {
+        if ((n = parseStructural(tape, i, finish)) == 0) {
+            break;
         }
-        jp->tok++;
     }
-    return *jp->tok;
+    if (tape->state == TAPE_FAILED) {
+        tape->numStructurals = 0;
+    } else if (i > 0) {
+        tape->numStructurals -= i;
+        memmove(tape->structurals, &tape->structurals[i], tape->numStructurals * sizeof(int));
+    }
 }
 
 
-static cchar *findQuote(cchar *tok, int quote)
+/*
+    Parse the structural at the given index. Returns the number of structurals consumed or zero if more input is required.
+ */
+static int parseStructural(MprJsonTape *tape, int index, int finish)
 {
-    cchar   *cp;
+    MprJsonNode     *np;
+    char            *doc;
+    ssize           end;
+    int             pos, c, state, top;
 
-    assert(tok);
-    for (cp = tok; *cp; cp++) {
-        if (*cp == quote && (cp == tok || *cp != '\\')) {
-            return cp;
+    doc = tape->doc;
+    pos = tape->structurals[index];
+    state = tape->state;
+    top = tape->depth > 0 ? tape->stack[tape->depth - 1] : -1;
+    c = doc[pos];
+
+    switch (c) {
+    case '{':
+    case '[':
+        if (state != TAPE_VALUE && state != TAPE_VALUE_OR_END) {
+            break;
+        }
+        if ((np = addNode(tape, top >= 0 && tape->nodes[top].type == MPR_JSON_ARRAY ? top : -1)) == 0) {
+            break;
+        }
+        np->type = (c == '{') ? MPR_JSON_OBJ : MPR_JSON_ARRAY;
+        if (tape->depth >= tape->stackSize) {
+            tape->stackSize *= 2;
+            if ((tape->stack = mprRealloc(tape->stack, tape->stackSize * sizeof(int))) == 0) {
+                break;
+            }
+        }
+        tape->stack[tape->depth++] = tape->count - 1;
+        tape->state = (c == '{') ? TAPE_KEY : TAPE_VALUE_OR_END;
+        return 1;
+
+    case '}':
+    case ']':
+        if (top < 0 || tape->nodes[top].type != ((c == '}') ? MPR_JSON_OBJ : MPR_JSON_ARRAY)) {
+            break;
+        }
+        if (state != TAPE_NEXT && state != ((c == '}') ? TAPE_KEY : TAPE_VALUE) && state != TAPE_VALUE_OR_END) {
+            break;
+        }
+        tape->nodes[top].next = tape->count;
+        tape->depth--;
+        tape->state = tape->depth > 0 ? TAPE_NEXT : TAPE_DONE;
+        return 1;
+
+    case ':':
+        if (state != TAPE_COLON) {
+            break;
+        }
+        tape->state = TAPE_VALUE;
+        return 1;
+
+    case ',':
+        if (state != TAPE_NEXT) {
+            break;
+        }
+        tape->state = (tape->nodes[top].type == MPR_JSON_OBJ) ? TAPE_KEY : TAPE_VALUE;
+        return 1;
+
+    case '"':
+        if ((index + 1) >= tape->numStructurals) {
+            if (finish) {
+                break;
+            }
+            return 0;
+        }
+        if ((state != TAPE_KEY && state != TAPE_VALUE && state != TAPE_VALUE_OR_END) || top < 0) {
+            break;
+        }
+        if ((np = addNode(tape, state == TAPE_KEY || tape->nodes[top].type == MPR_JSON_ARRAY ? top : -1)) == 0) {
+            break;
+        }
+        np->type = MPR_JSON_STRING;
+        np->quoted = 1;
+        np->offset = pos + 1;
+        np->len = tape->structurals[index + 1] - pos - 1;
+        tape->state = (state == TAPE_KEY) ? TAPE_COLON : TAPE_NEXT;
+        return 2;
+
+    default:
+        /* Primitive value: number, true, false or null. Other syntax is left for mprDeserialize */
+        if ((state != TAPE_VALUE && state != TAPE_VALUE_OR_END) || top < 0 || c == '/' || c == '\'') {
+            break;
+        }
+        for (end = pos; end < tape->length && !strchr(" \t\r\n,:{}[]\"", doc[end]); end++) ;
+        if (end >= tape->length && !finish) {
+            return 0;
         }
+        if ((np = addNode(tape, tape->nodes[top].type == MPR_JSON_ARRAY ? top : -1)) == 0) {
+            break;
+        }
+        np->type = MPR_JSON_STRING;
+        np->offset = pos;
+        np->len = (int) (end - pos);
+        tape->state = TAPE_NEXT;
+        return 1;
     }
+    tape->state = TAPE_FAILED;
     return 0;
 }
 
 
-static cchar *findEndKeyword(MprJson *jp, cchar *str)
+/*
+    Append a node and count it as a member of the given container
+ */
+static MprJsonNode *addNode(MprJsonTape *tape, int container)
 {
-    cchar   *cp, *etok;
+    MprJsonNode     *np;
 
-    assert(str);
-    for (cp = jp->tok; *cp; cp++) {
-        if ((etok = strpbrk(cp, " \t\n\r:,}]")) != 0) {
-            if (etok == jp->tok || *etok != '\\') {
-                return etok;
-            }
+    if (tape->count >= tape->nodeSize) {
+        tape->nodeSize *= 2;
+        if ((tape->nodes = mprRealloc(tape->nodes, tape->nodeSize * sizeof(MprJsonNode))) == 0) {
+            return 0;
         }
     }
-    return &str[strlen(str)];
+    if (container >= 0) {
+        tape->nodes[container].len++;
+    }
+    np = &tape->nodes[tape->count++];
+    np->offset = np->len = 0;
+    np->next = tape->count;
+    np->quoted = 0;
+    return np;
 }
 
 
-static void jsonParseError(MprJson *jp, cchar *msg)
+/*
+    Create an object tree from the tape. If the tape parse failed, the document is deserialized instead.
+ */
+PUBLIC MprHash *mprJsonTapeToHash(MprJsonTape *tape, MprHash *obj)
 {
-    if (jp->path) {
-        mprTrace(4, "%s\nIn file '%s' at line %d", msg, jp->path, jp->lineNumber);
-    } else {
-        mprTrace(4, "%s\nAt line %d", msg, jp->lineNumber);
+    cchar   *str;
+
+    if (tape->state != TAPE_DONE) {
+        for (str = tape->doc; isspace((uchar) *str); str++) ;
+        return mprDeserializeInto(str, obj);
     }
+    if (!obj) {
+        obj = makeTapeObj(&tape->nodes[0]);
+    }
+    tapeToHash(tape, 0, obj);
+    return obj;
 }
 
 
-PUBLIC void mprJsonParseError(MprJson *jp, cchar *fmt, ...)
+/*
+    Create an object or array hash sized for the number of members counted by the tape
+ */
+static MprHash *makeTapeObj(MprJsonNode *np)
 {
-    va_list     args;
-    cchar       *msg;
+    MprHash     *hash;
 
-    va_start(args, fmt);
-    msg = sfmtv(fmt, args);
-    (jp->callback.parseError)(jp, msg);
-    va_end(args);
+    if ((hash = mprCreateHash(np->len, 0)) == 0) {
+        return 0;
+    }
+    if (np->type == MPR_JSON_ARRAY) {
+        hash->flags |= MPR_HASH_LIST;
+    }
+    return hash;
 }
 
 
-/*
-    Currently only works for MprHash implementations
- */
-PUBLIC cchar *mprQueryJsonString(MprHash *obj, cchar *key)
+static void tapeToHash(MprJsonTape *tape, int index, MprHash *obj)
 {
-    MprKey  *kp;
-    char    *property, *tok;
+    MprJsonNode     *np, *vp, *kp;
+    MprHash         *child;
+    MprKey          *key;
+    cchar           *name;
+    char            keybuf[64];
+    int             i, n;
 
-    for (property = stok(sclone(key), ".", &tok); property; property = stok(0, ".", &tok)) {
-        if ((kp = mprLookupKeyEntry(obj, property)) == 0) {
-            return 0;
+    np = &tape->nodes[index];
+    for (i = index + 1, n = 0; i < np->next; i = vp->next, n++) {
+        if (np->type == MPR_JSON_OBJ) {
+            /* The document text is not modified as it may be shared. Hashes duplicate the key. */
+            kp = &tape->nodes[i++];
+            if (kp->len < (int) sizeof(keybuf)) {
+                memcpy(keybuf, &tape->doc[kp->offset], kp->len);
+                keybuf[kp->len] = '\0';
+                name = keybuf;
+            } else {
+                name = snclone(&tape->doc[kp->offset], kp->len);
+            }
+        } else {
+            itosbuf(keybuf, sizeof(keybuf), n, 10);
+            name = keybuf;
         }
-        if (tok == 0) {
-            return (kp->type == MPR_JSON_STRING) ? kp->data : NULL;
+        vp = &tape->nodes[i];
+        if (vp->type == MPR_JSON_STRING) {
+            key = mprAddKey(obj, name, snclone(&tape->doc[vp->offset], vp->len));
+        } else {
+            child = makeTapeObj(vp);
+            tapeToHash(tape, i, child);
+            key = mprAddKey(obj, name, child);
         }
-        if (kp->type != MPR_JSON_OBJ) {
-            return 0;
+        if (key) {
+            key->type = vp->type;
         }
-        obj = (MprHash*) kp->data;
     }
-    return 0;
 }
 
 
-/*
-    Currently only works for MprHash implementations
- */
-PUBLIC void *mprQueryJsonValue(MprHash *obj, cchar *key, int type)
+PUBLIC cchar *mprQueryJsonTape(MprJsonTape *tape, cchar *key)
 {
-    MprKey  *kp;
-    char    *property, *tok;
+    MprJsonNode     *np, *kp;
+    char            *property, *tok;
+    ssize           len;
+    int             i, index, found;
 
+    if (tape->state != TAPE_DONE) {
+        return mprQueryJsonString(mprJsonTapeToHash(tape, NULL), key);
+    }
+    index = 0;
     for (property = stok(sclone(key), ".", &tok); property; property = stok(0, ".", &tok)) {
-        if ((kp = mprLookupKeyEntry(obj, property)) == 0) {
+        np = &tape->nodes[index];
+        if (np->type != MPR_JSON_OBJ) {
             return 0;
         }
-        if (tok == 0) {
-            return (void*) ((kp->type == type) ? kp->data : NULL);
+        len = slen(property);
+        found = -1;
+        for (i = index + 1; i < np->next; i = tape->nodes[i + 1].next) {
+            kp = &tape->nodes[i];
+            if (kp->len == len && memcmp(&tape->doc[kp->offset], property, len) == 0) {
+                /* The last duplicate wins as for mprDeserialize */
+                found = i + 1;
+            }
         }
-        if (kp->type != MPR_JSON_OBJ) {
+        if (found < 0) {
             return 0;
         }
-        obj = (MprHash*) kp->data;
+        index = found;
     }
-    return 0;
+    np = &tape->nodes[index];
+    return (np->type == MPR_JSON_STRING) ? snclone(&tape->doc[np->offset], np->len) : 0;
 }
 
 
@@ -19788,6 +21067,7 @@ static void manageSocket(MprSocket *sp, int flags)
     if (flags & MPR_MANAGE_MARK) {
         mprMark(sp->service);
         mprMark(sp->errorMsg);
+        mprMark(sp->protocol);
         mprMark(sp->handler);
         mprMark(sp->acceptIp);
         mprMark(sp->ip);
@@ -19991,13 +21271,26 @@ PUBLIC MprWaitHandler *mprAddSocketHandler(MprSocket *sp, int mask, MprDispatche
     if (sp->handler) {
         mprRemoveWaitHandler(sp->handler);
     }
+    lock(sp);
     if (sp->flags & MPR_SOCKET_BUFFERED_READ) {
         mask |= MPR_READABLE;
     }
     if (sp->flags & MPR_SOCKET_BUFFERED_WRITE) {
         mask |= MPR_WRITABLE;
     }
-    sp->handler = mprCreateWaitHandler((int) sp->fd, mask, dispatcher, proc, data, flags);
+    if ((sp->handler = mprCreateWaitHandler((int) sp->fd, mask, dispatcher, proc, data, flags)) != 0) {
+        if (sp->flags & MPR_SOCKET_SUSPENDED) {
+            /*
+                Create with the requested mask so the handler can be recalled, but deliver no events until the 
+                SSL crypto job completes
+             */
+            mprWaitOn(sp->handler, 0);
+
+        } else if ((mask & MPR_READABLE) && (sp->flags & MPR_SOCKET_BUFFERED_READ)) {
+            mprRecallWaitHandler(sp->handler);
+        }
+    }
+    unlock(sp);
     return sp->handler;
 }
 
@@ -20040,18 +21333,24 @@ PUBLIC void mprEnableSocketEvents(MprSocket *sp, int mask)
 {
     assert(sp->handler);
     if (sp->handler) {
+        if (sp->flags & MPR_SOCKET_SUSPENDED) {
+            /* Events are enabled when the SSL crypto job completes */
+            mprWaitOn(sp->handler, 0);
+            return;
+        }
         if (sp->flags & MPR_SOCKET_BUFFERED_READ) {
             mask |= MPR_READABLE;
         }
         if (sp->flags & MPR_SOCKET_BUFFERED_WRITE) {
             mask |= MPR_WRITABLE;
         }
+        /*
+            Set the desired mask before recalling as the recall only fires for handlers that want readable events
+         */
+        mprWaitOn(sp->handler, mask);
         if (sp->flags & (MPR_SOCKET_BUFFERED_READ | MPR_SOCKET_BUFFERED_WRITE)) {
-            if (sp->handler) {
-                mprRecallWaitHandler(sp->handler);
-            }
+            mprRecallWaitHandler(sp->handler);
         }
-        mprWaitOn(sp->handler, mask);
     }
 }
 
@@ -21269,6 +22568,8 @@ static void manageSsl(MprSsl *ssl, int flags)
         mprMark(ssl->config);
         mprMark(ssl->provider);
         mprMark(ssl->providerName);
+        mprMark(ssl->ticketKeyFile);
+        mprMark(ssl->alpn);
     }
 }
 
@@ -21284,6 +22585,7 @@ PUBLIC MprSsl *mprCreateSsl(int server)
         return 0;
     }
     ssl->protocols = MPR_PROTO_TLSV1 | MPR_PROTO_TLSV11 | MPR_PROTO_TLSV12;
+    ssl->tickets = 1;
 
     /*
         The default for servers is not to verify client certificates.
@@ -21416,6 +22718,14 @@ PUBLIC void mprAddSslCiphers(MprSsl *ssl, cchar *ciphers)
 }
 
 
+PUBLIC void mprSetSslAlpn(MprSsl *ssl, cchar *protocols)
+{
+    assert(ssl);
+    ssl->alpn = (protocols && *protocols) ? sclone(protocols) : 0;
+    ssl->changed = 1;
+}
+
+
 PUBLIC void mprSetSslCiphers(MprSsl *ssl, cchar *ciphers)
 {
     assert(ssl);
@@ -21474,6 +22784,30 @@ PUBLIC void mprSetSslProvider(MprSsl *ssl, cchar *provider)
 }
 
 
+PUBLIC void mprSetSslKernelTls(MprSsl *ssl, bool on)
+{
+    assert(ssl);
+    ssl->kernelTls = on;
+    ssl->changed = 1;
+}
+
+
+PUBLIC void mprSetSslTicketKeyFile(MprSsl *ssl, cchar *keyFile)
+{
+    assert(ssl);
+    ssl->ticketKeyFile = (keyFile && *keyFile) ? sclone(keyFile) : 0;
+    ssl->changed = 1;
+}
+
+
+PUBLIC void mprSetSslTickets(MprSsl *ssl, bool on)
+{
+    assert(ssl);
+    ssl->tickets = on;
+    ssl->changed = 1;
+}
+
+
 PUBLIC void mprVerifySslPeer(MprSsl *ssl, bool on)
 {
     if (ssl) {
@@ -26685,6 +28019,8 @@ static MprWaitHandler *initWaitHandler(MprWaitHandler *wp, int fd, int mask, Mpr
     wp->service         = ws;
     wp->flags           = flags;
 
+#if !MPR_EVENT_EPOLL
+    /* Epoll maps descriptors via a growable list and is not limited by FD_SETSIZE */
     if (mprGetListLength(ws->handlers) >= FD_SETSIZE) {
         mprTrace(6, "io: Too many io handlers: %d", FD_SETSIZE);
         return 0;
@@ -26693,6 +28029,7 @@ static MprWaitHandler *initWaitHandler(MprWaitHandler *wp, int fd, int mask, Mpr
     if (fd >= FD_SETSIZE) {
         mprError("File descriptor %d exceeds max io of %d", fd, FD_SETSIZE);
     }
+#endif
 #endif
     if (mask) {
         if (mprAddItem(ws->handlers, wp) < 0) {
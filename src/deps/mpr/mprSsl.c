@@ -797,6 +797,10 @@ typedef struct EstConfig {
     x509_cert       ca;                 /* Certificate authority bundle to verify peer */
     int             *ciphers;           /* Set of acceptable ciphers */
     char            *dhKey;             /* DH keys */
+    ssl_ticket_keys *ticketKeys;        /* Session ticket key ring */
+    MprTime         keysModified;       /* Modification time of the ticket key file */
+    MprTicks        keysChecked;        /* When the ticket key file was last checked */
+    MprTicks        keysCreated;        /* When the generated ticket keys were created */
 } EstConfig;
 
 /*
@@ -809,8 +813,25 @@ typedef struct EstSocket {
     havege_state    hs;                 /* Random HAVEGE state */
     ssl_context     ctx;                /* SSL state */
     ssl_session     session;            /* SSL sessions */
+    ssl_ticket_keys *ticketKeys;        /* Ticket keys in use by this socket */
+    uchar           peerId[20];         /* Client session cache key for the peer */
+    struct EstJob   *job;               /* Private key operation running on a crypto worker */
 } EstSocket;
 
+/*
+    Private key operation for a crypto worker. This holds copies of the operation input and output so the worker 
+    never touches the socket's SSL context.
+ */
+typedef struct EstJob {
+    EstConfig       *cfg;               /* Configuration holding the private key */
+    int             op;                 /* SSL_ASYNC_DECRYPT or SSL_ASYNC_SIGN */
+    int             rc;                 /* Operation result */
+    int             ilen;               /* Length of input */
+    int             olen;               /* Length of output */
+    uchar           in[SSL_MAX_RSA_LEN];
+    uchar           out[SSL_MAX_RSA_LEN];
+} EstJob;
+
 static MprSocketProvider *estProvider;  /* EST socket provider */
 static EstConfig *defaultEstConfig;     /* Default configuration */
 
@@ -830,21 +851,26 @@ static char *dhKey =
     "E8A700D60B7F1200FA8E77B0A979DABF";
 
 /*
-    Thread-safe session list
+    Thread-safe session cache
  */
-static MprList *sessions;
+static MprSslCache *sessions;
 
 /***************************** Forward Declarations ***************************/
 
 static void     closeEst(MprSocket *sp, bool gracefully);
 static void     disconnectEst(MprSocket *sp);
 static void     estTrace(void *fp, int level, char *str);
+static ssl_ticket_keys *getTicketKeys(EstConfig *cfg, MprSsl *ssl);
+static int      startEstJob(MprSocket *sp);
 static int      handshakeEst(MprSocket *sp);
+static void     storeEstSession(MprSocket *sp);
 static char     *getEstState(MprSocket *sp);
 static void     manageEstConfig(EstConfig *cfg, int flags);
+static void     manageEstJob(EstJob *job, int flags);
 static void     manageEstProvider(MprSocketProvider *provider, int flags);
 static void     manageEstSocket(EstSocket *ssp, int flags);
 static ssize    readEst(MprSocket *sp, void *buf, ssize len);
+static void     runEstJob(EstJob *job);
 static int      upgradeEst(MprSocket *sp, MprSsl *sslConfig, cchar *peerName);
 static ssize    writeEst(MprSocket *sp, cvoid *buf, ssize len);
 
@@ -867,7 +893,7 @@ PUBLIC int mprCreateEstModule()
     estProvider->writeSocket = writeEst;
     estProvider->socketState = getEstState;
     mprAddSocketProvider("est", estProvider);
-    sessions = mprCreateList(0, 0);
+    sessions = mprGetSslCache();
 
     if ((defaultEstConfig = mprAllocObj(EstConfig, manageEstConfig)) == 0) {
         return MPR_ERR_MEMORY;
@@ -894,7 +920,7 @@ static void manageEstProvider(MprSocketProvider *provider, int flags)
 static void manageEstConfig(EstConfig *cfg, int flags)
 {
     if (flags & MPR_MANAGE_MARK) {
-        ;
+        mprMark(cfg->ticketKeys);
 
     } else if (flags & MPR_MANAGE_FREE) {
         rsa_free(&cfg->rsa);
@@ -913,6 +939,8 @@ static void manageEstSocket(EstSocket *est, int flags)
     if (flags & MPR_MANAGE_MARK) {
         mprMark(est->cfg);
         mprMark(est->sock);
+        mprMark(est->ticketKeys);
+        mprMark(est->job);
 
     } else if (flags & MPR_MANAGE_FREE) {
         ssl_free(&est->ctx);
@@ -920,6 +948,17 @@ static void manageEstSocket(EstSocket *est, int flags)
 }
 
 
+static void manageEstJob(EstJob *job, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(job->cfg);
+
+    } else if (flags & MPR_MANAGE_FREE) {
+        memset(job->out, 0, sizeof(job->out));
+    }
+}
+
+
 static void closeEst(MprSocket *sp, bool gracefully)
 {
     EstSocket       *est;
@@ -939,6 +978,7 @@ static int upgradeEst(MprSocket *sp, MprSsl *ssl, cchar *peerName)
 {
     EstSocket   *est;
     EstConfig   *cfg;
+    char        *key;
     int         verifyMode;
 
     assert(sp);
@@ -987,6 +1027,16 @@ static int upgradeEst(MprSocket *sp, MprSsl *ssl, cchar *peerName)
                 unlock(ssl);
                 return MPR_ERR_CANT_READ;
             }
+            if (cfg->rsa.len <= SSL_MAX_RSA_LEN) {
+                /*
+                    The first private key operation caches the CRT Montgomery constants in the key. Do it now so 
+                    concurrent crypto workers only read the key.
+                 */
+                uchar   warm[SSL_MAX_RSA_LEN];
+                memset(warm, 0, cfg->rsa.len);
+                warm[cfg->rsa.len - 1] = 2;
+                rsa_private(&cfg->rsa, warm, warm);
+            }
         }
         if (verifyMode != SSL_VERIFY_NO_CHECK) {
             if (!ssl->caFile) {
@@ -1004,6 +1054,9 @@ static int upgradeEst(MprSocket *sp, MprSsl *ssl, cchar *peerName)
         cfg->dhKey = defaultEstConfig->dhKey;
         cfg->ciphers = ssl_create_ciphers(ssl->ciphers);
     }
+    if (ssl->tickets && (sp->flags & MPR_SOCKET_SERVER)) {
+        est->ticketKeys = getTicketKeys(cfg, ssl);
+    }
     unlock(ssl);
 
     //  TODO - convert to proper entropy source API
@@ -1021,14 +1074,35 @@ static int upgradeEst(MprSocket *sp, MprSsl *ssl, cchar *peerName)
     ssl_set_scb(&est->ctx, getSession, setSession);
     ssl_set_ciphers(&est->ctx, cfg->ciphers);
 
-    ssl_set_session(&est->ctx, 1, 0, &est->session);
     memset(&est->session, 0, sizeof(ssl_session));
+    if (!(sp->flags & MPR_SOCKET_SERVER)) {
+        /*
+            Resume a prior session with this peer if one is cached. The key includes the peer name and the
+            configuration used to verify it, so a session verified under one configuration is not resumed by another.
+         */
+        key = sfmt("est:%s:%d:%s:%d:%d:%s", peerName ? peerName : sp->ip, sp->port, ssl->caFile ? ssl->caFile : "",
+            ssl->verifyPeer, ssl->verifyIssuer, ssl->certFile ? ssl->certFile : "");
+        sha1((uchar*) key, (int) slen(key), est->peerId);
+        mprLookupSslSession(sessions, est->peerId, sizeof(est->peerId), &est->session, sizeof(ssl_session));
+    }
+    ssl_set_session(&est->ctx, 1, 0, &est->session);
+    ssl_set_tickets(&est->ctx, ssl->tickets);
+    ssl_set_ticket_keys(&est->ctx, est->ticketKeys);
+    if (ssl->alpn && (sp->flags & MPR_SOCKET_SERVER)) {
+        ssl_set_alpn(&est->ctx, ssl->alpn);
+    }
 
     ssl_set_ca_chain(&est->ctx, ssl->caFile ? &cfg->ca : NULL, (char*) peerName);
     if (ssl->keyFile && ssl->certFile) {
         ssl_set_own_cert(&est->ctx, &cfg->cert, &cfg->rsa);
     }
     ssl_set_dh_param(&est->ctx, dhKey, dhG);
+    if ((sp->flags & MPR_SOCKET_SERVER) && !mprGetSocketBlockingMode(sp) && cfg->rsa.len <= SSL_MAX_RSA_LEN) {
+        /*
+            Run private key operations on the crypto workers so they do not stall the dispatcher
+         */
+        ssl_set_async(&est->ctx, 1);
+    }
     est->started = mprGetTicks();
 
     if (handshakeEst(sp) < 0) {
@@ -1051,13 +1125,27 @@ static void disconnectEst(MprSocket *sp)
 static int handshakeEst(MprSocket *sp)
 {
     EstSocket   *est;
-    int         rc, vrc, trusted;
+    int         rc, vrc, trusted, suspended;
 
     est = (EstSocket*) sp->sslSocket;
     assert(!(est->ctx.state == SSL_HANDSHAKE_OVER));
     rc = 0;
     trusted = 1;
 
+    if (est->job) {
+        lock(sp);
+        suspended = sp->flags & MPR_SOCKET_SUSPENDED;
+        unlock(sp);
+        if (suspended) {
+            return 0;
+        }
+        /*
+            The crypto worker has finished. Clear the buffered read flag used to resume the socket.
+         */
+        ssl_async_complete(&est->ctx, est->job->rc, est->job->out, est->job->olen);
+        est->job = 0;
+        mprHiddenSocketData(sp, 0, MPR_READABLE);
+    }
     sp->flags |= MPR_SOCKET_HANDSHAKING;
     while (est->ctx.state != SSL_HANDSHAKE_OVER && (rc = ssl_handshake(&est->ctx)) != 0) {
         if (rc == EST_ERR_NET_TRY_AGAIN) {
@@ -1066,12 +1154,32 @@ static int handshakeEst(MprSocket *sp)
             }
             continue;
         }
+        if (rc == EST_ERR_SSL_ASYNC_PENDING) {
+            if (startEstJob(sp) == 0) {
+                return 0;
+            }
+            continue;
+        }
         /* Error */
         break;
     }
     sp->flags &= ~MPR_SOCKET_HANDSHAKING;
     mprLog(4, "Est handshake complete in %,d msec", mprGetTicks() - est->started);
 
+    if (rc == 0 && (sp->flags & MPR_SOCKET_SERVER)) {
+        mprRecordSslHandshake(mprGetTicks() - est->started);
+    }
+    if (rc == 0 && ssl_get_alpn(&est->ctx)) {
+        sp->protocol = sclone(ssl_get_alpn(&est->ctx));
+    }
+    if (rc == 0 && sp->ssl->kernelTls) {
+        /*
+            Kernel TLS requires TLS 1.2 or later with an AEAD cipher. EST negotiates TLS 1.1 or earlier CBC ciphers,
+            so the socket continues to use user-space encryption.
+         */
+        mprLog(4, "EST: kernel TLS is not supported for cipher %s", ssl_get_cipher(&est->ctx));
+    }
+
     /*
         Analyze the handshake result
      */
@@ -1121,6 +1229,7 @@ static int handshakeEst(MprSocket *sp)
                This allows self-signed certs.
              */
             if (!sp->ssl->verifyIssuer && !trusted) {
+                storeEstSession(sp);
                 return 1;
             } else {
                 sp->flags |= MPR_SOCKET_EOF;
@@ -1134,10 +1243,67 @@ static int handshakeEst(MprSocket *sp)
         mprLog(3, "EST: Certificate verified");
 #endif
     }
+    storeEstSession(sp);
+    return 1;
+}
+
+
+/*
+    Save the client session (and any session ticket) for resumption on the next connection to this peer. 
+    This is only called once the peer certificate has passed verification.
+ */
+static void storeEstSession(MprSocket *sp)
+{
+    EstSocket   *est;
+
+    est = (EstSocket*) sp->sslSocket;
+    if (!(sp->flags & MPR_SOCKET_SERVER)) {
+        est->session.next = 0;
+        mprStoreSslSession(sessions, est->peerId, sizeof(est->peerId), &est->session, sizeof(ssl_session));
+    }
+}
+
+
+/*
+    Start a pending private key operation on a crypto worker. Return 0 if the job was started and the socket is 
+    suspended. Otherwise the operation is run on this thread, completed, and 1 is returned.
+ */
+static int startEstJob(MprSocket *sp)
+{
+    EstSocket   *est;
+    EstJob      *job;
+    ssl_context *ctx;
+
+    est = (EstSocket*) sp->sslSocket;
+    ctx = &est->ctx;
+    if ((job = mprAllocObj(EstJob, manageEstJob)) != 0) {
+        job->cfg = est->cfg;
+        job->op = ctx->async_op;
+        job->ilen = ctx->async_in_len;
+        memcpy(job->in, ctx->async_in, job->ilen);
+        est->job = job;
+        if (mprStartSslJob(sp, (MprSslJobProc) runEstJob, job) == 0) {
+            return 0;
+        }
+        est->job = 0;
+        runEstJob(job);
+        ssl_async_complete(ctx, job->rc, job->out, job->olen);
+    } else {
+        ssl_async_complete(ctx, MPR_ERR_MEMORY, 0, 0);
+    }
     return 1;
 }
 
 
+/*
+    Run a private key operation. This runs on a crypto worker and must only access the job.
+ */
+static void runEstJob(EstJob *job)
+{
+    job->rc = ssl_async_run(&job->cfg->rsa, job->op, job->in, job->ilen, job->out, &job->olen);
+}
+
+
 /*
     Return the number of bytes read. Return -1 on errors and EOF. Distinguish EOF via mprIsSocketEof.
     If non-blocking, may return zero if no data or still handshaking.
@@ -1268,60 +1434,120 @@ static char *getEstState(MprSocket *sp)
 
 
 /*
-    Thread-safe session management
+    Session management via the shared, thread-safe SSL session cache
  */
 static int getSession(ssl_context *ssl)
 {
-    ssl_session     *sp;
-    time_t          t;
-    int             next;
+    ssl_session     cached;
 
-    t = time(NULL);
     if (!ssl->resume) {
         return 1;
     }
-    for (ITERATE_ITEMS(sessions, sp, next)) {
-        if (ssl->timeout && (t - sp->start) > ssl->timeout) {
-            continue;
-        }
-        if (ssl->session->cipher != sp->cipher || ssl->session->length != sp->length) {
-            continue;
-        }
-        if (memcmp(ssl->session->id, sp->id, sp->length) != 0) {
-            continue;
-        }
-        memcpy(ssl->session->master, sp->master, sizeof(ssl->session->master));
-        return 0;
+    if (mprLookupSslSession(sessions, ssl->session->id, ssl->session->length, &cached, sizeof(cached)) != sizeof(cached)) {
+        return 1;
     }
-    return 1;
+    if (ssl->session->cipher != cached.cipher || ssl->session->length != cached.length) {
+        return 1;
+    }
+    if (ssl->timeout && (time(NULL) - cached.start) > ssl->timeout) {
+        return 1;
+    }
+    memcpy(ssl->session->master, cached.master, sizeof(ssl->session->master));
+    return 0;
 }
 
 
 static int setSession(ssl_context *ssl)
 {
-    time_t          t;
-    ssl_session     *sp;
-    int             next;
+    ssl_session     session;
 
-    t = time(NULL);
-    for (ITERATE_ITEMS(sessions, sp, next)) {
-        if (ssl->timeout != 0 && (t - sp->start) > ssl->timeout) {
-            /* expired, reuse this slot */
-            break;  
-        }
-        if (memcmp(ssl->session->id, sp->id, sp->length) == 0) {
-            /* client reconnected */
-            break;  
-        }
+    session = *ssl->session;
+    session.next = 0;
+    if (mprStoreSslSession(sessions, session.id, session.length, &session, sizeof(session)) < 0) {
+        return 1;
+    }
+    return 0;
+}
+
+
+static ssl_ticket_keys *allocTicketKeys(int count)
+{
+    ssl_ticket_keys     *keys;
+
+    if ((keys = mprAllocZeroed(sizeof(ssl_ticket_keys) + count * sizeof(ssl_ticket_key))) == 0) {
+        return 0;
+    }
+    keys->keys = (ssl_ticket_key*) &keys[1];
+    keys->count = count;
+    keys->lifetime = (int) (sessions->lifespan / MPR_TICKS_PER_SEC);
+    return keys;
+}
+
+
+/*
+    Load the session ticket keys from the ticket key file
+ */
+static ssl_ticket_keys *loadTicketKeys(cchar *path)
+{
+    ssl_ticket_keys     *keys;
+    char                *data;
+    ssize               len;
+
+    if ((data = mprReadPathContents(path, &len)) == 0) {
+        mprError("EST: Cannot read session ticket key file %s", path);
+        return 0;
+    }
+    if (len <= 0 || (len % SSL_TICKET_KEY_LEN) != 0) {
+        mprError("EST: Session ticket key file %s must contain one or more %d byte keys", path, SSL_TICKET_KEY_LEN);
+        memset(data, 0, len);
+        return 0;
+    }
+    if ((keys = allocTicketKeys((int) (len / SSL_TICKET_KEY_LEN))) != 0) {
+        memcpy(keys->keys, data, len);
     }
-    if (sp == NULL) {
-        if ((sp = mprAlloc(sizeof(ssl_session))) == 0) {
-            return 1;
+    memset(data, 0, len);
+    return keys;
+}
+
+
+/*
+    Get the current session ticket keys. Keys are either loaded from the ticket key file so they can be shared with 
+    other processes, or are generated and rotated periodically. The prior generated key is retained to decrypt
+    outstanding tickets. Key rings are never modified once created, so sockets may safely retain a reference.
+    Caller must hold the ssl lock.
+ */
+static ssl_ticket_keys *getTicketKeys(EstConfig *cfg, MprSsl *ssl)
+{
+    ssl_ticket_keys     *keys;
+    MprPath             info;
+    MprTicks            now;
+
+    now = mprGetTicks();
+    if (ssl->ticketKeyFile) {
+        if (cfg->ticketKeys == 0 || (now - cfg->keysChecked) >= MPR_SSL_TICKET_KEY_CHECK) {
+            cfg->keysChecked = now;
+            if (mprGetPathInfo(ssl->ticketKeyFile, &info) == 0 && (cfg->ticketKeys == 0 || info.mtime != cfg->keysModified)) {
+                if ((keys = loadTicketKeys(ssl->ticketKeyFile)) != 0) {
+                    mprLog(3, "EST: Loaded %d session ticket keys from %s", keys->count, ssl->ticketKeyFile);
+                    cfg->ticketKeys = keys;
+                    cfg->keysModified = info.mtime;
+                }
+            }
+        }
+    } else if (cfg->ticketKeys == 0 || (now - cfg->keysCreated) >= sessions->lifespan) {
+        if ((keys = allocTicketKeys(cfg->ticketKeys ? 2 : 1)) != 0) {
+            if (mprGetRandomBytes((char*) &keys->keys[0], sizeof(ssl_ticket_key), 0) < 0) {
+                mprError("EST: Cannot generate session ticket keys");
+                return cfg->ticketKeys;
+            }
+            if (cfg->ticketKeys) {
+                keys->keys[1] = cfg->ticketKeys->keys[0];
+            }
+            cfg->ticketKeys = keys;
+            cfg->keysCreated = now;
         }
-        mprAddItem(sessions, sp);
     }
-    memcpy(sp, ssl->session, sizeof(ssl_session));
-    return 0;
+    return cfg->ticketKeys;
 }
 
 
@@ -1418,6 +1644,10 @@ typedef struct CRYPTO_dynlock_value DynLock;
 
 /***************************** Forward Declarations ***************************/
 
+static void     checkKernelTls(MprSocket *sp);
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L
+static int      selectOssAlpn(SSL *handle, cuchar **out, uchar *outlen, cuchar *in, uint inlen, void *arg);
+#endif
 static void     closeOss(MprSocket *sp, bool gracefully);
 static int      configureCertificateFiles(MprSsl *ssl, SSL_CTX *ctx, char *key, char *cert);
 static OpenConfig *createOpenSslConfig(MprSocket *sp);
@@ -1430,6 +1660,9 @@ static void     manageOpenProvider(MprSocketProvider *provider, int flags);
 static void     manageOpenSocket(OpenSocket *ssp, int flags);
 static ssize    readOss(MprSocket *sp, void *buf, ssize len);
 static RSA      *rsaCallback(SSL *ssl, int isExport, int keyLength);
+static SSL_SESSION *getOssSession(SSL *handle, uchar *id, int idLen, int *copy);
+static int      newOssSession(SSL *handle, SSL_SESSION *session);
+static void     removeOssSession(SSL_CTX *context, SSL_SESSION *session);
 static int      upgradeOss(MprSocket *sp, MprSsl *ssl, cchar *peerName);
 static int      verifyX509Certificate(int ok, X509_STORE_CTX *ctx);
 static ssize    writeOss(MprSocket *sp, cvoid *buf, ssize len);
@@ -1601,10 +1834,23 @@ static OpenConfig *createOpenSslConfig(MprSocket *sp)
         return 0;
     }
     SSL_CTX_set_app_data(context, (void*) ssl);
-    SSL_CTX_sess_set_cache_size(context, 512);
     RAND_bytes(resume, sizeof(resume));
     SSL_CTX_set_session_id_context(context, resume, sizeof(resume));
 
+    /*
+        Use the shared MPR session cache instead of the OpenSSL internal cache
+     */
+    SSL_CTX_set_session_cache_mode(context, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_sess_set_new_cb(context, newOssSession);
+    SSL_CTX_sess_set_get_cb(context, getOssSession);
+    SSL_CTX_sess_set_remove_cb(context, removeOssSession);
+
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L
+    if (ssl->alpn) {
+        SSL_CTX_set_alpn_select_cb(context, selectOssAlpn, ssl);
+    }
+#endif
+
     verifyMode = (sp->flags & MPR_SOCKET_SERVER && !ssl->verifyPeer) ? SSL_VERIFY_NONE : 
         SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT;
 
@@ -1662,6 +1908,12 @@ static OpenConfig *createOpenSslConfig(MprSocket *sp)
     SSL_CTX_set_options(context, SSL_OP_NO_SESSION_RESUMPTION_ON_RENEGOTIATION);
 #endif
     SSL_CTX_set_mode(context, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_AUTO_RETRY);
+#ifdef SSL_OP_ENABLE_KTLS
+    if (ssl->kernelTls) {
+        /* OpenSSL installs the keys into the kernel after the handshake if the kernel and cipher support it */
+        SSL_CTX_set_options(context, SSL_OP_ENABLE_KTLS);
+    }
+#endif
 
     /*
         Select the required protocols
@@ -1683,6 +1935,39 @@ static OpenConfig *createOpenSslConfig(MprSocket *sp)
 }
 
 
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L
+/*
+    Select the first configured ALPN protocol that is also offered by the client
+ */
+static int selectOssAlpn(SSL *handle, cuchar **out, uchar *outlen, cuchar *in, uint inlen, void *arg)
+{
+    MprSsl      *ssl;
+    cuchar      *p, *end;
+    cchar       *proto, *next;
+    ssize       len;
+
+    ssl = arg;
+    end = &in[inlen];
+    for (proto = ssl->alpn; *proto; proto = next) {
+        if ((next = schr(proto, ',')) != 0) {
+            len = next++ - proto;
+        } else {
+            len = slen(proto);
+            next = &proto[len];
+        }
+        for (p = in; p < end && &p[1 + *p] <= end; p += 1 + *p) {
+            if (*p == len && memcmp(&p[1], proto, len) == 0) {
+                *out = &p[1];
+                *outlen = *p;
+                return SSL_TLSEXT_ERR_OK;
+            }
+        }
+    }
+    return SSL_TLSEXT_ERR_NOACK;
+}
+#endif
+
+
 /*
     Configure the SSL certificate information using key and cert files
  */
@@ -1880,6 +2165,29 @@ static void disconnectOss(MprSocket *sp)
 }
 
 
+/*
+    Test if OpenSSL installed the session keys into kernel TLS. If so, the kernel encrypts data written to the socket
+    and sendfile may be used.
+ */
+static void checkKernelTls(MprSocket *sp)
+{
+#ifdef SSL_OP_ENABLE_KTLS
+    OpenSocket  *osp;
+
+    osp = (OpenSocket*) sp->sslSocket;
+    if (sp->ssl->kernelTls) {
+        if (BIO_get_ktls_send(SSL_get_wbio(osp->handle))) {
+            sp->flags |= MPR_SOCKET_KTLS_TX;
+        }
+        if (BIO_get_ktls_recv(SSL_get_rbio(osp->handle))) {
+            sp->flags |= MPR_SOCKET_KTLS_RX;
+        }
+        mprLog(4, "OpenSSL: kernel TLS %s", (sp->flags & MPR_SOCKET_KTLS_TX) ? "enabled" : "not supported for this cipher");
+    }
+#endif
+}
+
+
 static int checkCert(MprSocket *sp)
 {
     MprSsl      *ssl;
@@ -1980,6 +2288,17 @@ static ssize readOss(MprSocket *sp, void *buf, ssize len)
         if (checkCert(sp) < 0) {
             return MPR_ERR_BAD_STATE;
         }
+        checkKernelTls(sp);
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L
+        {
+            cuchar  *alpn;
+            uint    alpnLen;
+            SSL_get0_alpn_selected(osp->handle, &alpn, &alpnLen);
+            if (alpnLen > 0) {
+                sp->protocol = snclone((cchar*) alpn, alpnLen);
+            }
+        }
+#endif
         sp->flags |= MPR_SOCKET_CHECKED;
     }
     if (rc <= 0) {
@@ -2163,6 +2482,52 @@ static ssize flushOss(MprSocket *sp)
 }
 
  
+/*
+    Save a new session in the shared session cache. Sessions are stored in DER format.
+ */
+static int newOssSession(SSL *handle, SSL_SESSION *session)
+{
+    uchar       buf[BIT_MAX_BUFFER], *bp;
+    cuchar      *id;
+    uint        idLen;
+    int         len;
+
+    if ((len = i2d_SSL_SESSION(session, NULL)) <= 0 || len > sizeof(buf)) {
+        return 0;
+    }
+    bp = buf;
+    i2d_SSL_SESSION(session, &bp);
+    id = SSL_SESSION_get_id(session, &idLen);
+    mprStoreSslSession(mprGetSslCache(), id, idLen, buf, len);
+    return 0;
+}
+
+
+static SSL_SESSION *getOssSession(SSL *handle, uchar *id, int idLen, int *copy)
+{
+    uchar           buf[BIT_MAX_BUFFER];
+    const uchar     *bp;
+    ssize           len;
+
+    *copy = 0;
+    if ((len = mprLookupSslSession(mprGetSslCache(), id, idLen, buf, sizeof(buf))) <= 0) {
+        return 0;
+    }
+    bp = buf;
+    return d2i_SSL_SESSION(NULL, &bp, (long) len);
+}
+
+
+static void removeOssSession(SSL_CTX *context, SSL_SESSION *session)
+{
+    cuchar      *id;
+    uint        idLen;
+
+    id = SSL_SESSION_get_id(session, &idLen);
+    mprRemoveSslSession(mprGetSslCache(), id, idLen);
+}
+
+
 static ulong sslThreadId()
 {
     return (long) mprGetCurrentOsThread();
@@ -3068,6 +3433,576 @@ PUBLIC int mprGetSslCipherCode(cchar *cipher)
     return 0;
 }
 
+
+/*********************************** Session Cache ****************************/
+/*
+    Cached session. The session ID and state are stored inline after the header.
+ */
+typedef struct SslSession {
+    struct SslSession   *next;          /* Hash chain */
+    struct SslSession   *prevLru;       /* More recently used session */
+    struct SslSession   *nextLru;       /* Less recently used session */
+    MprTicks            expires;        /* When the session expires */
+    uint                hash;           /* Cached hash of the session ID */
+    int                 idLen;          /* Length of the session ID */
+    ssize               len;            /* Length of the session state */
+    uchar               id[MPR_SSL_MAX_SESSION_ID];
+    uchar               data[1];        /* Session state */
+} SslSession;
+
+/*
+    Cache partition. Each stripe has its own lock, hash table and LRU list.
+ */
+typedef struct MprSslStripe {
+    MprMutex        *mutex;
+    SslSession      *buckets[MPR_SSL_CACHE_HASH];
+    SslSession      *head;              /* Most recently used */
+    SslSession      *tail;              /* Least recently used */
+    int             count;
+    MprSslCacheStats stats;
+} MprSslStripe;
+
+static MprSslCache *defaultSslCache;
+
+static void manageSslCache(MprSslCache *cache, int flags);
+static void unlinkSslSession(MprSslStripe *stripe, SslSession *sess);
+
+
+PUBLIC MprSslCache *mprCreateSslCache(int maxSessions, MprTicks lifespan)
+{
+    MprSslCache     *cache;
+    int             i;
+
+    if ((cache = mprAllocObj(MprSslCache, manageSslCache)) == 0) {
+        return 0;
+    }
+    if ((cache->stripes = mprAllocZeroed(sizeof(MprSslStripe) * MPR_SSL_CACHE_STRIPES)) == 0) {
+        return 0;
+    }
+    for (i = 0; i < MPR_SSL_CACHE_STRIPES; i++) {
+        cache->stripes[i].mutex = mprCreateLock();
+    }
+    cache->maxSessions = maxSessions > 0 ? maxSessions : BIT_MAX_SSL_SESSIONS;
+    cache->lifespan = lifespan > 0 ? lifespan : MPR_SSL_SESSION_LIFESPAN;
+    return cache;
+}
+
+
+PUBLIC MprSslCache *mprGetSslCache()
+{
+    if (defaultSslCache == 0) {
+        if ((defaultSslCache = mprCreateSslCache(0, 0)) != 0) {
+            mprAddRoot(defaultSslCache);
+        }
+    }
+    return defaultSslCache;
+}
+
+
+static void manageSslCache(MprSslCache *cache, int flags)
+{
+    MprSslStripe    *stripe;
+    SslSession      *sess;
+    int             i;
+
+    if (flags & MPR_MANAGE_MARK) {
+        if (cache->stripes) {
+            mprMark(cache->stripes);
+            for (i = 0; i < MPR_SSL_CACHE_STRIPES; i++) {
+                stripe = &cache->stripes[i];
+                mprMark(stripe->mutex);
+                for (sess = stripe->head; sess; sess = sess->nextLru) {
+                    mprMark(sess);
+                }
+            }
+        }
+    }
+}
+
+
+static MprSslStripe *getSslStripe(MprSslCache *cache, uint hash)
+{
+    return &cache->stripes[(hash / MPR_SSL_CACHE_HASH) % MPR_SSL_CACHE_STRIPES];
+}
+
+
+/*
+    Find a session in a stripe. Caller must hold the stripe lock.
+ */
+static SslSession *findSslSession(MprSslStripe *stripe, uint hash, cuchar *id, ssize idLen)
+{
+    SslSession  *sess;
+
+    for (sess = stripe->buckets[hash % MPR_SSL_CACHE_HASH]; sess; sess = sess->next) {
+        if (sess->hash == hash && sess->idLen == idLen && memcmp(sess->id, id, idLen) == 0) {
+            return sess;
+        }
+    }
+    return 0;
+}
+
+
+/*
+    Move a session to the head of the LRU list. Caller must hold the stripe lock.
+ */
+static void touchSslSession(MprSslStripe *stripe, SslSession *sess)
+{
+    if (stripe->head == sess) {
+        return;
+    }
+    if (sess->prevLru) {
+        sess->prevLru->nextLru = sess->nextLru;
+    }
+    if (sess->nextLru) {
+        sess->nextLru->prevLru = sess->prevLru;
+    }
+    if (stripe->tail == sess) {
+        stripe->tail = sess->prevLru;
+    }
+    sess->prevLru = 0;
+    sess->nextLru = stripe->head;
+    if (stripe->head) {
+        stripe->head->prevLru = sess;
+    }
+    stripe->head = sess;
+    if (stripe->tail == 0) {
+        stripe->tail = sess;
+    }
+}
+
+
+/*
+    Remove a session from the hash chain and LRU list. Caller must hold the stripe lock.
+ */
+static void unlinkSslSession(MprSslStripe *stripe, SslSession *sess)
+{
+    SslSession  **pp;
+
+    for (pp = &stripe->buckets[sess->hash % MPR_SSL_CACHE_HASH]; *pp; pp = &(*pp)->next) {
+        if (*pp == sess) {
+            *pp = sess->next;
+            break;
+        }
+    }
+    if (sess->prevLru) {
+        sess->prevLru->nextLru = sess->nextLru;
+    } else {
+        stripe->head = sess->nextLru;
+    }
+    if (sess->nextLru) {
+        sess->nextLru->prevLru = sess->prevLru;
+    } else {
+        stripe->tail = sess->prevLru;
+    }
+    sess->next = sess->prevLru = sess->nextLru = 0;
+    stripe->count--;
+}
+
+
+/*
+    Remove expired sessions from the cold end of the LRU list. Sessions all have the same lifespan, so the walk stops
+    at the first session that has not expired. Sessions that were used recently are ahead of that point even if
+    they expire sooner, and are removed by sweepSslSessions or when looked up. Caller must hold the stripe lock.
+ */
+static void expireSslSessions(MprSslStripe *stripe, MprTicks now)
+{
+    while (stripe->tail && stripe->tail->expires <= now) {
+        unlinkSslSession(stripe, stripe->tail);
+        stripe->stats.expired++;
+    }
+}
+
+
+/*
+    Remove all expired sessions from a stripe. This walks the entire stripe and is only used when the stripe is full
+    to avoid evicting live sessions while expired sessions remain. Caller must hold the stripe lock.
+ */
+static void sweepSslSessions(MprSslStripe *stripe, MprTicks now)
+{
+    SslSession  *sess, *prev;
+
+    for (sess = stripe->tail; sess; sess = prev) {
+        prev = sess->prevLru;
+        if (sess->expires <= now) {
+            unlinkSslSession(stripe, sess);
+            stripe->stats.expired++;
+        }
+    }
+}
+
+
+PUBLIC ssize mprLookupSslSession(MprSslCache *cache, cuchar *id, ssize idLen, void *buf, ssize bufsize)
+{
+    MprSslStripe    *stripe;
+    SslSession      *sess;
+    ssize           len;
+    uint            hash;
+
+    assert(cache);
+    assert(id);
+    assert(buf);
+
+    if (idLen <= 0 || idLen > MPR_SSL_MAX_SESSION_ID) {
+        return MPR_ERR_BAD_ARGS;
+    }
+    hash = shash((cchar*) id, idLen);
+    stripe = getSslStripe(cache, hash);
+
+    lock(stripe);
+    if ((sess = findSslSession(stripe, hash, id, idLen)) == 0) {
+        stripe->stats.misses++;
+        unlock(stripe);
+        return MPR_ERR_CANT_FIND;
+    }
+    if (sess->expires <= mprGetTicks()) {
+        unlinkSslSession(stripe, sess);
+        stripe->stats.expired++;
+        stripe->stats.misses++;
+        unlock(stripe);
+        return MPR_ERR_CANT_FIND;
+    }
+    if (sess->len > bufsize) {
+        stripe->stats.misses++;
+        unlock(stripe);
+        return MPR_ERR_WONT_FIT;
+    }
+    memcpy(buf, sess->data, sess->len);
+    len = sess->len;
+    touchSslSession(stripe, sess);
+    stripe->stats.hits++;
+    unlock(stripe);
+    return len;
+}
+
+
+PUBLIC int mprStoreSslSession(MprSslCache *cache, cuchar *id, ssize idLen, cvoid *data, ssize len)
+{
+    MprSslStripe    *stripe;
+    SslSession      *sess, *old;
+    MprTicks        now;
+    uint            hash;
+    int             limit;
+
+    assert(cache);
+    assert(id);
+    assert(data);
+
+    if (idLen <= 0 || idLen > MPR_SSL_MAX_SESSION_ID || len <= 0) {
+        return MPR_ERR_BAD_ARGS;
+    }
+    if ((sess = mprAlloc(sizeof(SslSession) + len)) == 0) {
+        return MPR_ERR_MEMORY;
+    }
+    hash = shash((cchar*) id, idLen);
+    memset(sess, 0, sizeof(SslSession));
+    memcpy(sess->id, id, idLen);
+    memcpy(sess->data, data, len);
+    sess->idLen = (int) idLen;
+    sess->len = len;
+    sess->hash = hash;
+    now = mprGetTicks();
+    sess->expires = now + cache->lifespan;
+
+    stripe = getSslStripe(cache, hash);
+    limit = max(cache->maxSessions / MPR_SSL_CACHE_STRIPES, 1);
+
+    lock(stripe);
+    if ((old = findSslSession(stripe, hash, id, idLen)) != 0) {
+        unlinkSslSession(stripe, old);
+    }
+    expireSslSessions(stripe, now);
+    if (stripe->count >= limit) {
+        sweepSslSessions(stripe, now);
+    }
+    while (stripe->count >= limit && stripe->tail) {
+        unlinkSslSession(stripe, stripe->tail);
+        stripe->stats.evictions++;
+    }
+    sess->next = stripe->buckets[hash % MPR_SSL_CACHE_HASH];
+    stripe->buckets[hash % MPR_SSL_CACHE_HASH] = sess;
+    touchSslSession(stripe, sess);
+    stripe->count++;
+    stripe->stats.inserts++;
+    unlock(stripe);
+    return 0;
+}
+
+
+PUBLIC void mprRemoveSslSession(MprSslCache *cache, cuchar *id, ssize idLen)
+{
+    MprSslStripe    *stripe;
+    SslSession      *sess;
+    uint            hash;
+
+    assert(cache);
+
+    if (idLen <= 0 || idLen > MPR_SSL_MAX_SESSION_ID) {
+        return;
+    }
+    hash = shash((cchar*) id, idLen);
+    stripe = getSslStripe(cache, hash);
+    lock(stripe);
+    if ((sess = findSslSession(stripe, hash, id, idLen)) != 0) {
+        unlinkSslSession(stripe, sess);
+    }
+    unlock(stripe);
+}
+
+
+PUBLIC void mprGetSslCacheStats(MprSslCache *cache, MprSslCacheStats *stats)
+{
+    MprSslStripe    *stripe;
+    int             i;
+
+    assert(cache);
+    assert(stats);
+
+    memset(stats, 0, sizeof(MprSslCacheStats));
+    for (i = 0; i < MPR_SSL_CACHE_STRIPES; i++) {
+        stripe = &cache->stripes[i];
+        lock(stripe);
+        stats->hits += stripe->stats.hits;
+        stats->misses += stripe->stats.misses;
+        stats->inserts += stripe->stats.inserts;
+        stats->evictions += stripe->stats.evictions;
+        stats->expired += stripe->stats.expired;
+        stats->sessions += stripe->count;
+        unlock(stripe);
+    }
+}
+
+
+/*********************************** Crypto Workers ***************************/
+/*
+    Job waiting for or running on a crypto worker
+ */
+typedef struct SslJob {
+    MprSocket       *sock;              /* Socket suspended awaiting the job */
+    MprSslJobProc   proc;               /* Job callback */
+    void            *data;              /* Job data */
+    MprTicks        queued;             /* When the job was queued */
+} SslJob;
+
+static MprSslCrypto *sslCrypto;
+
+static void cryptoWorker(void *data, MprWorker *worker);
+static MprSslCrypto *getSslCrypto();
+static void manageSslCrypto(MprSslCrypto *crypto, int flags);
+static void manageSslJob(SslJob *job, int flags);
+static void resumeSslSocket(MprSocket *sp, MprEvent *event);
+
+
+static MprSslCrypto *getSslCrypto()
+{
+    if (sslCrypto == 0) {
+        if ((sslCrypto = mprAllocObj(MprSslCrypto, manageSslCrypto)) == 0) {
+            return 0;
+        }
+        sslCrypto->queue = mprCreateList(0, 0);
+        sslCrypto->running = mprCreateList(0, 0);
+        sslCrypto->mutex = mprCreateLock();
+        sslCrypto->stats.workers = BIT_MAX_SSL_CRYPTO_WORKERS;
+        mprAddRoot(sslCrypto);
+    }
+    return sslCrypto;
+}
+
+
+static void manageSslCrypto(MprSslCrypto *crypto, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(crypto->queue);
+        mprMark(crypto->running);
+        mprMark(crypto->mutex);
+    }
+}
+
+
+static void manageSslJob(SslJob *job, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(job->sock);
+        mprMark(job->data);
+    }
+}
+
+
+PUBLIC void mprSetSslCryptoWorkers(int workers)
+{
+    MprSslCrypto    *crypto;
+
+    if ((crypto = getSslCrypto()) != 0) {
+        lock(crypto);
+        crypto->stats.workers = max(workers, 0);
+        unlock(crypto);
+    }
+}
+
+
+PUBLIC void mprGetSslCryptoStats(MprSslCryptoStats *stats)
+{
+    MprSslCrypto    *crypto;
+
+    memset(stats, 0, sizeof(MprSslCryptoStats));
+    if ((crypto = getSslCrypto()) != 0) {
+        lock(crypto);
+        *stats = crypto->stats;
+        stats->queued = mprGetListLength(crypto->queue);
+        unlock(crypto);
+    }
+}
+
+
+PUBLIC void mprRecordSslHandshake(MprTicks elapsed)
+{
+    MprSslCrypto    *crypto;
+
+    if ((crypto = getSslCrypto()) != 0) {
+        lock(crypto);
+        crypto->stats.handshakes++;
+        crypto->stats.handshakeTime += elapsed;
+        crypto->stats.maxHandshakeTime = max(crypto->stats.maxHandshakeTime, elapsed);
+        unlock(crypto);
+    }
+}
+
+
+/*
+    Queue a job for the crypto workers and suspend I/O on the socket until it completes. A new worker is started if 
+    the worker limit permits, otherwise a running worker will take the job when it finishes its current job.
+ */
+PUBLIC int mprStartSslJob(MprSocket *sp, MprSslJobProc proc, void *data)
+{
+    MprSslCrypto    *crypto;
+    SslJob          *job;
+    int             queued, start;
+
+    if ((crypto = getSslCrypto()) == 0) {
+        return MPR_ERR_MEMORY;
+    }
+    if ((job = mprAllocObj(SslJob, manageSslJob)) == 0) {
+        return MPR_ERR_MEMORY;
+    }
+    job->sock = sp;
+    job->proc = proc;
+    job->data = data;
+    job->queued = mprGetTicks();
+
+    lock(crypto);
+    queued = mprGetListLength(crypto->queue);
+    if (crypto->stats.workers <= 0 || queued >= MPR_SSL_CRYPTO_QUEUE) {
+        if (crypto->stats.workers > 0) {
+            crypto->stats.overflow++;
+        }
+        unlock(crypto);
+        return MPR_ERR_BUSY;
+    }
+    /*
+        Suspend before queueing as a running worker may take the job immediately. The socket handler need not be 
+        disabled here: mprEnableSocketEvents will not enable a suspended socket.
+     */
+    lock(sp);
+    sp->flags |= MPR_SOCKET_SUSPENDED;
+    unlock(sp);
+
+    mprAddItem(crypto->queue, job);
+    crypto->stats.submitted++;
+    crypto->stats.maxQueued = max(crypto->stats.maxQueued, queued + 1);
+    start = crypto->stats.active < crypto->stats.workers;
+    if (start) {
+        crypto->stats.active++;
+    }
+    unlock(crypto);
+
+    if (start && mprStartWorker((MprWorkerProc) cryptoWorker, crypto) < 0) {
+        /*
+            No worker threads available. Unless a running worker has already taken the job, withdraw it so the 
+            caller can run it on this thread.
+         */
+        lock(crypto);
+        crypto->stats.active--;
+        if (mprRemoveItem(crypto->queue, job) >= 0) {
+            crypto->stats.submitted--;
+            crypto->stats.overflow++;
+            unlock(crypto);
+            lock(sp);
+            sp->flags &= ~MPR_SOCKET_SUSPENDED;
+            unlock(sp);
+            return MPR_ERR_BUSY;
+        }
+        unlock(crypto);
+    }
+    return 0;
+}
+
+
+/*
+    Run queued crypto jobs until the queue is empty
+ */
+static void cryptoWorker(void *data, MprWorker *worker)
+{
+    MprSslCrypto    *crypto;
+    MprSocket       *sp;
+    MprWaitHandler  *handler;
+    SslJob          *job;
+    MprTicks        started, elapsed;
+
+    crypto = data;
+    while (1) {
+        lock(crypto);
+        if ((job = mprGetFirstItem(crypto->queue)) == 0) {
+            crypto->stats.active--;
+            unlock(crypto);
+            break;
+        }
+        mprRemoveItemAtPos(crypto->queue, 0);
+        mprAddItem(crypto->running, job);
+        started = mprGetTicks();
+        crypto->stats.queueTime += started - job->queued;
+        unlock(crypto);
+
+        /*
+            The job is retained by the running list and only touches its own state, so yield to permit garbage 
+            collection while it runs
+         */
+        mprYield(MPR_YIELD_STICKY);
+        (job->proc)(job->data);
+        mprResetYield();
+
+        elapsed = mprGetTicks() - started;
+        lock(crypto);
+        crypto->stats.completed++;
+        crypto->stats.cryptoTime += elapsed;
+        unlock(crypto);
+
+        /*
+            Resume the socket. If the socket has no wait handler yet, mprAddSocketHandler will see the buffered read
+            flag and recall the handler.
+         */
+        sp = job->sock;
+        lock(sp);
+        sp->flags &= ~MPR_SOCKET_SUSPENDED;
+        sp->flags |= MPR_SOCKET_BUFFERED_READ;
+        handler = (sp->flags & MPR_SOCKET_CLOSED) ? 0 : sp->handler;
+        unlock(sp);
+        if (handler) {
+            mprCreateEvent(handler->dispatcher, "sslResume", 0, resumeSslSocket, sp, 0);
+        }
+        mprRemoveItem(crypto->running, job);
+    }
+}
+
+
+/*
+    Re-enable I/O on a socket after a crypto job. This runs on the socket's dispatcher.
+ */
+static void resumeSslSocket(MprSocket *sp, MprEvent *event)
+{
+    if (sp->handler && !(sp->flags & (MPR_SOCKET_CLOSED | MPR_SOCKET_SUSPENDED))) {
+        mprEnableSocketEvents(sp, MPR_READABLE);
+    }
+}
+
 /*
     @copy   default
 
@@ -1,6 +1,15 @@
 /*
     digest.c - Digest Authorization
 
+    Nonces are signed with the per-process secret and carry their issue time and a sequence number. Issuing a nonce
+    does not use any server state. The nonce counts (nc) used with a nonce are tracked in a fixed table indexed by
+    sequence from the first request that authenticates with it, so anonymous requests cannot displace the nonces of
+    authenticated clients. A slot only moves to later sequence numbers, so a displaced nonce cannot be tracked again
+    and replayed. A nonce is stale once it expires or its slot is taken by a later authenticated nonce, and the client
+    is asked to retry with a fresh nonce. The trade-off is that authenticated clients share the table, so more than
+    DIGEST_NONCES clients authenticating within the nonce lifespan will cause some clients to retry. The authorization
+    header is tokenized in place and digests are computed into stack buffers.
+
     Copyright (c) All Rights Reserved. See details at the end of the file.
  */
 
@@ -9,11 +18,18 @@
 #include    "http.h"
 
 /********************************** Defines ***********************************/
+
+#define DIGEST_LIFESPAN     (5 * 60)        /* Nonce lifespan in seconds */
+#define DIGEST_NONCES       4096            /* Authenticated nonces tracked for replay protection. Must be a power of 2 */
+#define DIGEST_NONCE_SIZE   48              /* Hex issue time, sequence and signature */
+#define DIGEST_WINDOW       32              /* Nonce counts below the highest that may arrive out of order */
+
 /*
-    Per-request digest authorization data
+    Per-request digest authorization data. The fields point into the parsed copy of the header details.
  */
 typedef struct DigestData 
 {
+    char    *details;
     char    *algorithm;
     char    *cnonce;
     char    *domain;
@@ -24,14 +40,38 @@ typedef struct DigestData
     char    *realm;
     char    *stale;
     char    *uri;
+    int     count;                      /* Client request count for the nc field */
 } DigestData;
 
+/*
+    Nonce counts for an authenticated nonce. The window has a bit for each of the counts below the highest that have
+    been used, with bit zero for the highest.
+ */
+typedef struct DigestNonce {
+    uint    seq;                        /* Nonce sequence number. Zero if unused */
+    uint    nc;                         /* Highest nonce count used */
+    uint    window;                     /* Recently used nonce counts */
+} DigestNonce;
+
+typedef struct HttpDigest {
+    DigestNonce     *nonces;            /* Authenticated nonces indexed by sequence */
+    uint            next;               /* Last nonce sequence issued */
+    MprMutex        *mutex;             /* Multithread sync */
+} HttpDigest;
+
 /********************************** Forwards **********************************/
 
+static bool acceptNonceCount(HttpConn *conn, uint seq, uint nc);
+static void addField(MprMD5 *md5, cchar *value);
 static char *calcDigest(HttpConn *conn, DigestData *dp, cchar *username);
-static char *createDigestNonce(HttpConn *conn, cchar *secret, cchar *realm);
+static char *createDigestNonce(HttpConn *conn, cchar *realm, char *nonce);
+static HttpDigest *getDigest(Http *http);
+static void manageDigest(HttpDigest *digest, int flags);
 static void manageDigestData(DigestData *dp, int flags);
-static int parseDigestNonce(char *nonce, cchar **secret, cchar **realm, MprTime *when);
+static bool matchDigest(cchar *a, cchar *b, ssize len);
+static bool parseDigestNonce(HttpConn *conn, cchar *nonce, cchar *realm, uint *when, uint *seq);
+static bool parseHex(cchar *str, int len, uint *result);
+static void signNonce(cchar *secret, cchar *realm, cchar *nonce, char *result);
 
 /*********************************** Code *************************************/
 /*
@@ -41,10 +81,9 @@ PUBLIC int httpDigestParse(HttpConn *conn, cchar **username, cchar **password)
 {
     HttpRx      *rx;
     DigestData  *dp;
-    MprTime     when;
-    char        *value, *tok, *key, *cp, *sp;
-    cchar       *secret, *realm;
-    int         seenComma;
+    char        *cp, *key, *end, *value, *dest;
+    cchar       *user, *response;
+    uint        when, seq, nc;
 
     rx = conn->rx;
     if (password) {
@@ -57,47 +96,56 @@ PUBLIC int httpDigestParse(HttpConn *conn, cchar **username, cchar **password)
         return 0;
     }
     dp = conn->authData = mprAllocObj(DigestData, manageDigestData);
-    key = sclone(rx->authDetails);
+    cp = dp->details = sclone(rx->authDetails);
+    user = response = 0;
 
-    while (*key) {
-        while (*key && isspace((uchar) *key)) {
-            key++;
+    while (*cp) {
+        while (*cp == ',' || isspace((uchar) *cp)) {
+            cp++;
+        }
+        if (*cp == '\0') {
+            break;
         }
-        tok = key;
-        while (*tok && !isspace((uchar) *tok) && *tok != ',' && *tok != '=') {
-            tok++;
+        key = cp;
+        while (*cp && *cp != '=' && *cp != ',' && !isspace((uchar) *cp)) {
+            cp++;
         }
-        *tok++ = '\0';
-
-        while (isspace((uchar) *tok)) {
-            tok++;
+        end = cp;
+        while (isspace((uchar) *cp)) {
+            cp++;
         }
-        seenComma = 0;
-        if (*tok == '\"') {
-            value = ++tok;
-            while (*tok != '\"' && *tok != '\0') {
-                tok++;
-            }
-        } else {
-            value = tok;
-            while (*tok != ',' && *tok != '\0') {
-                tok++;
-            }
-            seenComma++;
+        if (*cp != '=') {
+            /* Ignore keywords without values */
+            *end = '\0';
+            continue;
+        }
+        *end = '\0';
+        cp++;
+        while (isspace((uchar) *cp)) {
+            cp++;
         }
-        *tok++ = '\0';
 
-        /*
-            Handle back-quoting
-         */
-        if (strchr(value, '\\')) {
-            for (cp = sp = value; *sp; sp++) {
-                if (*sp == '\\') {
-                    sp++;
+        if (*cp == '\"') {
+            /* Remove quotes and back-quoting in place */
+            value = dest = ++cp;
+            while (*cp && *cp != '\"') {
+                if (*cp == '\\' && cp[1]) {
+                    cp++;
                 }
-                *cp++ = *sp++;
+                *dest++ = *cp++;
+            }
+            if (*cp) {
+                cp++;
+            }
+            *dest = '\0';
+        } else {
+            value = cp;
+            while (*cp && *cp != ',' && !isspace((uchar) *cp)) {
+                cp++;
+            }
+            if (*cp) {
+                *cp++ = '\0';
             }
-            *cp = '\0';
         }
 
         /*
@@ -106,70 +154,63 @@ PUBLIC int httpDigestParse(HttpConn *conn, cchar **username, cchar **password)
         switch (tolower((uchar) *key)) {
         case 'a':
             if (scaselesscmp(key, "algorithm") == 0) {
-                dp->algorithm = sclone(value);
-                break;
-            } else if (scaselesscmp(key, "auth-param") == 0) {
-                break;
+                dp->algorithm = value;
             }
             break;
 
         case 'c':
             if (scaselesscmp(key, "cnonce") == 0) {
-                dp->cnonce = sclone(value);
+                dp->cnonce = value;
             }
             break;
 
         case 'd':
             if (scaselesscmp(key, "domain") == 0) {
-                dp->domain = sclone(value);
-                break;
+                dp->domain = value;
             }
             break;
 
         case 'n':
             if (scaselesscmp(key, "nc") == 0) {
-                dp->nc = sclone(value);
+                dp->nc = value;
             } else if (scaselesscmp(key, "nonce") == 0) {
-                dp->nonce = sclone(value);
+                dp->nonce = value;
             }
             break;
 
         case 'o':
             if (scaselesscmp(key, "opaque") == 0) {
-                dp->opaque = sclone(value);
+                dp->opaque = value;
             }
             break;
 
         case 'q':
             if (scaselesscmp(key, "qop") == 0) {
-                dp->qop = sclone(value);
+                dp->qop = value;
             }
             break;
 
         case 'r':
             if (scaselesscmp(key, "realm") == 0) {
-                dp->realm = sclone(value);
+                dp->realm = value;
             } else if (scaselesscmp(key, "response") == 0) {
                 /* Store the response digest in the password field. This is MD5(user:realm:password) */
-                if (password) {
-                    *password = sclone(value);
-                }
+                response = value;
                 conn->encoded = 1;
             }
             break;
 
         case 's':
             if (scaselesscmp(key, "stale") == 0) {
-                break;
+                dp->stale = value;
             }
+            break;
 
         case 'u':
             if (scaselesscmp(key, "uri") == 0) {
-                dp->uri = sclone(value);
+                dp->uri = value;
             } else if (scaselesscmp(key, "username") == 0 || scaselesscmp(key, "user") == 0) {
-                if (username) {
-                    *username = sclone(value);
-                }
+                user = value;
             }
             break;
 
@@ -177,21 +218,18 @@ PUBLIC int httpDigestParse(HttpConn *conn, cchar **username, cchar **password)
             /*  Just ignore keywords we don't understand */
             ;
         }
-        key = tok;
-        if (!seenComma) {
-            while (*key && *key != ',') {
-                key++;
-            }
-            if (*key) {
-                key++;
-            }
-        }
     }
-    if (username && *username == 0) {
-        return MPR_ERR_BAD_FORMAT;
+    if (username) {
+        if (user == 0) {
+            return MPR_ERR_BAD_FORMAT;
+        }
+        *username = sclone(user);
     }
-    if (password && *password == 0) {
-        return MPR_ERR_BAD_FORMAT;
+    if (password) {
+        if (response == 0) {
+            return MPR_ERR_BAD_FORMAT;
+        }
+        *password = sclone(response);
     }
     if (dp->realm == 0 || dp->nonce == 0 || dp->uri == 0) {
         return MPR_ERR_BAD_FORMAT;
@@ -200,26 +238,40 @@ PUBLIC int httpDigestParse(HttpConn *conn, cchar **username, cchar **password)
         return MPR_ERR_BAD_FORMAT;
     }
     if (conn->endpoint) {
-        realm = secret = 0;
-        when = 0;
-        parseDigestNonce(dp->nonce, &secret, &realm, &when);
-        if (!smatch(secret, secret)) {
+        if (!username || !password) {
+            return MPR_ERR_BAD_ARGS;
+        }
+        nc = 0;
+        if (!parseDigestNonce(conn, dp->nonce, rx->route->auth->realm, &when, &seq)) {
             mprTrace(2, "Access denied: Nonce mismatch\n");
             return MPR_ERR_BAD_STATE;
 
-        } else if (!smatch(realm, rx->route->auth->realm)) {
-            mprTrace(2, "Access denied: Realm mismatch\n");
-            return MPR_ERR_BAD_STATE;
-
         } else if (dp->qop && !smatch(dp->qop, "auth")) {
             mprTrace(2, "Access denied: Bad qop\n");
             return MPR_ERR_BAD_STATE;
 
-        } else if ((when + (5 * 60)) < time(0)) {
-            mprTrace(2, "Access denied: Nonce is stale\n");
+        } else if (dp->qop && (slen(dp->nc) != 8 || !parseHex(dp->nc, 8, &nc) || nc == 0)) {
+            mprTrace(2, "Access denied: Bad nonce count\n");
             return MPR_ERR_BAD_STATE;
+
+        } else if ((when + DIGEST_LIFESPAN) < (uint) time(0) || !acceptNonceCount(conn, seq, 0)) {
+            /* Not a login failure. Ask the client to retry with a fresh nonce */
+            mprTrace(2, "Access denied: Nonce is stale\n");
+            dp->stale = "TRUE";
+            *username = *password = NULL;
+            return 0;
         }
         rx->passwordDigest = calcDigest(conn, dp, *username);
+
+        /*
+            Record the nonce count only for a correct response so other clients cannot consume counts or take slots
+         */
+        if (dp->qop && rx->passwordDigest && slen(*password) == MPR_MD5_HEX_SIZE - 1 &&
+                matchDigest(*password, rx->passwordDigest, MPR_MD5_HEX_SIZE - 1) && !acceptNonceCount(conn, seq, nc)) {
+            mprTrace(2, "Access denied: Nonce count replayed\n");
+            rx->passwordDigest = 0;
+            return MPR_ERR_BAD_STATE;
+        }
     } else {
         if (dp->domain == 0 || dp->opaque == 0 || dp->algorithm == 0 || dp->stale == 0) {
             return MPR_ERR_BAD_FORMAT;
@@ -232,16 +284,7 @@ PUBLIC int httpDigestParse(HttpConn *conn, cchar **username, cchar **password)
 static void manageDigestData(DigestData *dp, int flags)
 {
     if (flags & MPR_MANAGE_MARK) {
-        mprMark(dp->algorithm);
-        mprMark(dp->cnonce);
-        mprMark(dp->domain);
-        mprMark(dp->nc);
-        mprMark(dp->nonce);
-        mprMark(dp->opaque);
-        mprMark(dp->qop);
-        mprMark(dp->realm);
-        mprMark(dp->stale);
-        mprMark(dp->uri);
+        mprMark(dp->details);
     }
 }
 
@@ -252,20 +295,25 @@ static void manageDigestData(DigestData *dp, int flags)
 PUBLIC void httpDigestLogin(HttpConn *conn)
 {
     HttpAuth    *auth;
-    char        *nonce, *opaque;
+    DigestData  *dp;
+    char        nonce[DIGEST_NONCE_SIZE + 1], *opaque;
+    cchar       *stale;
 
     auth = conn->rx->route->auth;
-    nonce = createDigestNonce(conn, conn->http->secret, auth->realm);
+    createDigestNonce(conn, auth->realm, nonce);
+    dp = conn->authData;
+    stale = (dp && smatch(dp->stale, "TRUE")) ? "TRUE" : "FALSE";
     /* Opaque is unused, set to anything */
     opaque = "799d5";
 
     if (smatch(auth->qop, "none")) {
-        httpSetHeader(conn, "WWW-Authenticate", "Digest realm=\"%s\", nonce=\"%s\"", auth->realm, nonce);
+        httpSetHeader(conn, "WWW-Authenticate", "Digest realm=\"%s\", nonce=\"%s\", stale=%s", auth->realm, nonce,
+            stale);
     } else {
         /* Value of null defaults to "auth" */
         httpSetHeader(conn, "WWW-Authenticate", "Digest realm=\"%s\", domain=\"%s\", "
-            "qop=\"auth\", nonce=\"%s\", opaque=\"%s\", algorithm=\"MD5\", stale=\"FALSE\"", 
-            auth->realm, conn->host->name, nonce, opaque);
+            "qop=\"auth\", nonce=\"%s\", opaque=\"%s\", algorithm=\"MD5\", stale=\"%s\"", 
+            auth->realm, conn->host->name, nonce, opaque, stale);
     }
     httpSetContentType(conn, "text/plain");
     httpError(conn, HTTP_CODE_UNAUTHORIZED, "Access Denied. Login required");
@@ -282,6 +330,7 @@ PUBLIC bool httpDigestSetHeaders(HttpConn *conn, cchar *username, cchar *passwor
     HttpTx      *tx;
     DigestData  *dp;
     char        *ha1, *ha2, *digest, *cnonce;
+    int         nc;
 
     http = conn->http;
     tx = conn->tx;
@@ -289,15 +338,16 @@ PUBLIC bool httpDigestSetHeaders(HttpConn *conn, cchar *username, cchar *passwor
         /* Need to await a failing auth response */
         return 0;
     }
-    cnonce = sfmt("%s:%s:%x", http->secret, dp->realm, (int) http->now);
+    cnonce = mprGetMD5(sfmt("%s:%s:%x", http->secret, dp->realm, (int) http->now));
     ha1 = mprGetMD5(sfmt("%s:%s:%s", username, dp->realm, password));
     ha2 = mprGetMD5(sfmt("%s:%s", tx->method, tx->parsedUri->path));
     if (smatch(dp->qop, "auth")) {
-        digest = mprGetMD5(sfmt("%s:%s:%08x:%s:%s:%s", ha1, dp->nonce, dp->nc, cnonce, dp->qop, ha2));
+        nc = ++dp->count;
+        digest = mprGetMD5(sfmt("%s:%s:%08x:%s:%s:%s", ha1, dp->nonce, nc, cnonce, dp->qop, ha2));
         httpAddHeader(conn, "Authorization", "Digest username=\"%s\", realm=\"%s\", domain=\"%s\", "
             "algorithm=\"MD5\", qop=\"%s\", cnonce=\"%s\", nc=\"%08x\", nonce=\"%s\", opaque=\"%s\", "
             "stale=\"FALSE\", uri=\"%s\", response=\"%s\"", username, dp->realm, dp->domain, dp->qop, 
-            cnonce, dp->nc, dp->nonce, dp->opaque, tx->parsedUri->path, digest);
+            cnonce, nc, dp->nonce, dp->opaque, tx->parsedUri->path, digest);
     } else {
         digest = mprGetMD5(sfmt("%s:%s:%s", ha1, dp->nonce, ha2));
         httpAddHeader(conn, "Authorization", "Digest username=\"%s\", realm=\"%s\", nonce=\"%s\", "
@@ -307,30 +357,170 @@ PUBLIC bool httpDigestSetHeaders(HttpConn *conn, cchar *username, cchar *passwor
 }
 
 
+static HttpDigest *getDigest(Http *http)
+{
+    HttpDigest  *digest;
+
+    if ((digest = http->digest) == 0) {
+        lock(http);
+        if ((digest = http->digest) == 0) {
+            if ((digest = mprAllocObj(HttpDigest, manageDigest)) != 0) {
+                digest->nonces = mprAllocZeroed(DIGEST_NONCES * sizeof(DigestNonce));
+                digest->mutex = mprCreateLock();
+                http->digest = digest;
+            }
+        }
+        unlock(http);
+    }
+    return digest;
+}
+
+
+static void manageDigest(HttpDigest *digest, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(digest->nonces);
+        mprMark(digest->mutex);
+    }
+}
+
+
 /*
-    Create a nonce value for digest authentication (RFC 2617)
+    Create a nonce value for digest authentication (RFC 2617) in the supplied buffer. The nonce is the hex issue time
+    and sequence number followed by a signature of these with the secret and realm.
  */ 
-static char *createDigestNonce(HttpConn *conn, cchar *secret, cchar *realm)
+static char *createDigestNonce(HttpConn *conn, cchar *realm, char *nonce)
 {
-    static int64 next = 0;
+    HttpDigest  *digest;
+    uint        seq;
 
     assert(realm && *realm);
-    return mprEncode64(sfmt("%s:%s:%Lx:%Lx", secret, realm, mprGetTime(), next++));
+    seq = 0;
+    if ((digest = getDigest(conn->http)) != 0) {
+        lock(digest);
+        if ((seq = ++digest->next) == 0) {
+            seq = ++digest->next;
+        }
+        unlock(digest);
+    }
+    fmt(nonce, DIGEST_NONCE_SIZE + 1, "%08x%08x", (uint) time(0), seq);
+    signNonce(conn->http->secret, realm, nonce, &nonce[16]);
+    return nonce;
 }
 
 
-static int parseDigestNonce(char *nonce, cchar **secret, cchar **realm, MprTime *when)
+/*
+    Verify the nonce signature and extract the issue time and sequence number
+ */
+static bool parseDigestNonce(HttpConn *conn, cchar *nonce, cchar *realm, uint *when, uint *seq)
 {
-    char    *tok, *decoded, *whenStr;
+    char    signature[MPR_MD5_HEX_SIZE];
 
-    if ((decoded = mprDecode64(nonce)) == 0) {
-        return MPR_ERR_CANT_READ;
+    if (slen(nonce) != DIGEST_NONCE_SIZE || !parseHex(nonce, 8, when) || !parseHex(&nonce[8], 8, seq)) {
+        return 0;
     }
-    *secret = stok(decoded, ":", &tok);
-    *realm = stok(NULL, ":", &tok);
-    whenStr = stok(NULL, ":", &tok);
-    *when = (MprTime) stoiradix(whenStr, 16, NULL); 
-    return 0;
+    signNonce(conn->http->secret, realm, nonce, signature);
+    return matchDigest(signature, &nonce[16], MPR_MD5_HEX_SIZE - 1);
+}
+
+
+/*
+    Sign the first 16 characters of the nonce. The result buffer must be at least MPR_MD5_HEX_SIZE bytes.
+ */
+static void signNonce(cchar *secret, cchar *realm, cchar *nonce, char *result)
+{
+    MprMD5      md5;
+
+    mprInitMD5(&md5);
+    mprUpdateMD5(&md5, secret, -1);
+    addField(&md5, realm);
+    mprUpdateMD5(&md5, ":", 1);
+    mprUpdateMD5(&md5, nonce, 16);
+    mprFinalizeMD5(&md5, result);
+}
+
+
+/*
+    Test if a nonce has not been displaced by a later nonce and record the nonce count if non-zero. Recording the first
+    count takes the slot for the nonce. A count is accepted once and only if it is higher than the highest count or is
+    one of the recent lower counts not yet used.
+ */
+static bool acceptNonceCount(HttpConn *conn, uint seq, uint nc)
+{
+    HttpDigest  *digest;
+    DigestNonce *np;
+    uint        shift, bit;
+    bool        accepted;
+
+    if ((digest = getDigest(conn->http)) == 0 || seq == 0) {
+        return 0;
+    }
+    lock(digest);
+    np = &digest->nonces[seq & (DIGEST_NONCES - 1)];
+    if (np->seq != seq && np->seq && (int) (np->seq - seq) > 0) {
+        accepted = 0;
+    } else if (nc == 0) {
+        accepted = 1;
+    } else if (np->seq != seq) {
+        np->seq = seq;
+        np->nc = nc;
+        np->window = 1;
+        accepted = 1;
+    } else if (nc > np->nc) {
+        shift = nc - np->nc;
+        np->window = (shift >= DIGEST_WINDOW) ? 1 : ((np->window << shift) | 1);
+        np->nc = nc;
+        accepted = 1;
+    } else if ((np->nc - nc) < DIGEST_WINDOW && !(np->window & (bit = 1U << (np->nc - nc)))) {
+        np->window |= bit;
+        accepted = 1;
+    } else {
+        accepted = 0;
+    }
+    unlock(digest);
+    return accepted;
+}
+
+
+static bool parseHex(cchar *str, int len, uint *result)
+{
+    uint    value;
+    int     c, i;
+
+    for (value = 0, i = 0; i < len; i++) {
+        c = tolower((uchar) str[i]);
+        if (c >= '0' && c <= '9') {
+            value = (value << 4) | (c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            value = (value << 4) | (c - 'a' + 10);
+        } else {
+            return 0;
+        }
+    }
+    *result = value;
+    return 1;
+}
+
+
+/*
+    Compare digests in time independent of the content
+ */
+static bool matchDigest(cchar *a, cchar *b, ssize len)
+{
+    ssize   i;
+    int     diff;
+
+    for (diff = 0, i = 0; i < len; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+
+static void addField(MprMD5 *md5, cchar *value)
+{
+    mprUpdateMD5(md5, ":", 1);
+    mprUpdateMD5(md5, value, -1);
 }
 
 
@@ -340,36 +530,37 @@ static int parseDigestNonce(char *nonce, cchar **secret, cchar **realm, MprTime
 static char *calcDigest(HttpConn *conn, DigestData *dp, cchar *username)
 {
     HttpAuth    *auth;
-    char        *digestBuf, *ha1, *ha2;
+    MprMD5      md5;
+    char        ha2[MPR_MD5_HEX_SIZE], digest[MPR_MD5_HEX_SIZE];
 
     auth = conn->rx->route->auth;
     if (!conn->user) {
         conn->user = mprLookupKey(auth->userCache, username);
     }
-    assert(conn->user && conn->user->password);
     if (conn->user == 0 || conn->user->password == 0) {
         return 0;
     }
-
-    /*
-        Compute HA1. Password is already expected to be in the HA1 format MD5(username:realm:password).
-     */
-    ha1 = sclone(conn->user->password);
-
     /*
         HA2
      */ 
-    ha2 = mprGetMD5(sfmt("%s:%s", conn->rx->method, dp->uri));
+    mprInitMD5(&md5);
+    mprUpdateMD5(&md5, conn->rx->method, -1);
+    addField(&md5, dp->uri);
+    mprFinalizeMD5(&md5, ha2);
 
     /*
-        H(HA1:nonce:HA2)
+        H(HA1:nonce:HA2). HA1 is the user password which is already in the format MD5(username:realm:password).
      */
-    if (scmp(dp->qop, "auth") == 0) {
-        digestBuf = sfmt("%s:%s:%s:%s:%s:%s", ha1, dp->nonce, dp->nc, dp->cnonce, dp->qop, ha2);
-    } else {
-        digestBuf = sfmt("%s:%s:%s", ha1, dp->nonce, ha2);
+    mprInitMD5(&md5);
+    mprUpdateMD5(&md5, conn->user->password, -1);
+    addField(&md5, dp->nonce);
+    if (dp->qop) {
+        addField(&md5, dp->nc);
+        addField(&md5, dp->cnonce);
+        addField(&md5, dp->qop);
     }
-    return mprGetMD5(digestBuf);
+    addField(&md5, ha2);
+    return sclone(mprFinalizeMD5(&md5, digest));
 }
 
 /*
@@ -0,0 +1,360 @@
+/*
+    dnsCache.c -- Host name resolution cache for outbound client connections
+
+    Resolved addresses are cached for a configurable period so new client connections do not call the blocking system
+    resolver. Failed lookups are cached for a shorter period. Entries nearing expiry are refreshed on a worker thread
+    while the current addresses continue to be used. Hosts with multiple addresses are used in round-robin order.
+    IPv4 addresses are preferred as they are by the MPR socket layer.
+
+    Entries may be preloaded from a hosts-style file. Preloaded entries do not expire.
+
+    Copyright (c) All Rights Reserved. See copyright notice at the bottom of the file.
+ */
+
+/********************************* Includes ***********************************/
+
+#include    "http.h"
+
+/*********************************** Locals ***********************************/
+
+typedef struct DnsEntry {
+    char            *host;              /* Host name */
+    MprList         *addresses;         /* Numeric addresses. Empty for a negative entry */
+    MprTicks        expires;            /* When the entry must be resolved again */
+    int             next;               /* Next address for round-robin */
+    int             preloaded;          /* Entry loaded from a hosts file. Never expires */
+    int             refreshing;         /* Refresh in progress on a worker */
+} DnsEntry;
+
+/********************************** Forwards **********************************/
+
+static DnsEntry *createEntry(cchar *host);
+static bool isNumericAddress(cchar *host);
+static void manageDnsCache(HttpDnsCache *cache, int flags);
+static void manageDnsEntry(DnsEntry *ep, int flags);
+static void pruneDnsCache(HttpDnsCache *cache, MprTicks now);
+static void refreshEntry(DnsEntry *ep, MprWorker *worker);
+static MprList *resolve(HttpDnsCache *cache, cchar *host);
+static void updateEntry(HttpDnsCache *cache, DnsEntry *ep, MprList *addresses, MprTicks now);
+
+/************************************ Code ************************************/
+/*
+    Enable the resolver cache. Set ttl to zero to disable.
+ */
+PUBLIC int httpSetDnsCache(Http *http, MprTicks ttl, MprTicks negativeTtl)
+{
+    HttpDnsCache    *cache;
+
+    if (ttl <= 0) {
+        http->dnsCache = 0;
+        return 0;
+    }
+    if ((cache = http->dnsCache) == 0) {
+        if ((cache = mprAllocObj(HttpDnsCache, manageDnsCache)) == 0) {
+            return MPR_ERR_MEMORY;
+        }
+        cache->hosts = mprCreateHash(0, MPR_HASH_CASELESS);
+        cache->mutex = mprCreateLock();
+        cache->maxHosts = HTTP_DNS_MAX_HOSTS;
+    }
+    cache->ttl = ttl;
+    cache->negativeTtl = max(negativeTtl, 0);
+    http->dnsCache = cache;
+    return 0;
+}
+
+
+static void manageDnsCache(HttpDnsCache *cache, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(cache->hosts);
+        mprMark(cache->mutex);
+    }
+}
+
+
+static void manageDnsEntry(DnsEntry *ep, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(ep->host);
+        mprMark(ep->addresses);
+    }
+}
+
+
+/*
+    Preload entries from a hosts-style file. Each line has an address followed by one or more host names.
+    Comments start with "#". Returns the number of host names loaded.
+ */
+PUBLIC int httpLoadDnsHosts(Http *http, cchar *path)
+{
+    HttpDnsCache    *cache;
+    DnsEntry        *ep;
+    char            *content, *line, *tok, *addr, *host, *cp;
+    int             count;
+
+    if ((cache = http->dnsCache) == 0) {
+        return MPR_ERR_BAD_STATE;
+    }
+    if ((content = mprReadPathContents(path, NULL)) == 0) {
+        return MPR_ERR_CANT_READ;
+    }
+    count = 0;
+    lock(cache);
+    for (line = stok(content, "\r\n", &tok); line; line = stok(NULL, "\r\n", &tok)) {
+        if ((cp = schr(line, '#')) != 0) {
+            *cp = '\0';
+        }
+        if ((addr = stok(line, " \t", &cp)) == 0 || !isNumericAddress(addr)) {
+            continue;
+        }
+        while ((host = stok(NULL, " \t", &cp)) != 0) {
+            if ((ep = mprLookupKey(cache->hosts, host)) == 0 || !ep->preloaded) {
+                ep = createEntry(host);
+                ep->preloaded = 1;
+                mprAddKey(cache->hosts, ep->host, ep);
+            }
+            mprAddItem(ep->addresses, sclone(addr));
+            count++;
+        }
+    }
+    unlock(cache);
+    return count;
+}
+
+
+/*
+    Resolve a host name to a numeric address for connecting. Returns the host unchanged if the cache is disabled or
+    the host is already numeric. Returns NULL if the host cannot be resolved.
+ */
+PUBLIC cchar *httpResolveHost(Http *http, cchar *host)
+{
+    HttpDnsCache    *cache;
+    DnsEntry        *ep;
+    MprList         *addresses;
+    MprTicks        now;
+    cchar           *addr;
+    int             len;
+
+    if ((cache = http->dnsCache) == 0 || !host || isNumericAddress(host)) {
+        return host;
+    }
+    now = mprGetTicks();
+    lock(cache);
+    if ((ep = mprLookupKey(cache->hosts, host)) != 0 && (ep->preloaded || ep->expires > now)) {
+        if ((len = mprGetListLength(ep->addresses)) == 0) {
+            cache->negativeHits++;
+            unlock(cache);
+            return 0;
+        }
+        cache->hits++;
+        addr = mprGetItem(ep->addresses, ep->next++ % len);
+        if (!ep->preloaded && !ep->refreshing && (ep->expires - now) < (cache->ttl / 4)) {
+            /* Refresh in the background before expiry. If no worker is available, retry on the next lookup */
+            ep->refreshing = 1;
+            if (mprStartWorker((MprWorkerProc) refreshEntry, ep) < 0) {
+                ep->refreshing = 0;
+            }
+        }
+        unlock(cache);
+        return addr;
+    }
+    cache->misses++;
+    unlock(cache);
+
+    addresses = resolve(cache, host);
+
+    /* Resolving may be slow, so entry lifespans start when the answer is received */
+    now = mprGetTicks();
+    lock(cache);
+    if ((ep = mprLookupKey(cache->hosts, host)) == 0) {
+        if (mprGetHashLength(cache->hosts) >= cache->maxHosts) {
+            pruneDnsCache(cache, now);
+        }
+        ep = createEntry(host);
+        mprAddKey(cache->hosts, ep->host, ep);
+    }
+    updateEntry(cache, ep, addresses, now);
+    addr = (len = mprGetListLength(ep->addresses)) > 0 ? mprGetItem(ep->addresses, ep->next++ % len) : 0;
+    unlock(cache);
+    return addr;
+}
+
+
+static DnsEntry *createEntry(cchar *host)
+{
+    DnsEntry    *ep;
+
+    if ((ep = mprAllocObj(DnsEntry, manageDnsEntry)) == 0) {
+        return 0;
+    }
+    ep->host = sclone(host);
+    ep->addresses = mprCreateList(0, 0);
+    return ep;
+}
+
+
+/*
+    Install resolved addresses. A failed refresh of a valid entry retains the prior addresses. Caller must hold the lock.
+ */
+static void updateEntry(HttpDnsCache *cache, DnsEntry *ep, MprList *addresses, MprTicks now)
+{
+    if (ep->preloaded) {
+        return;
+    }
+    if (mprGetListLength(addresses) > 0) {
+        ep->addresses = addresses;
+        ep->expires = now + cache->ttl;
+    } else if (ep->expires <= now || mprGetListLength(ep->addresses) == 0) {
+        ep->addresses = addresses;
+        ep->expires = now + cache->negativeTtl;
+    }
+}
+
+
+static void refreshEntry(DnsEntry *ep, MprWorker *worker)
+{
+    HttpDnsCache    *cache;
+    MprList         *addresses;
+
+    if ((cache = ((Http*) MPR->httpService)->dnsCache) == 0) {
+        return;
+    }
+    addresses = resolve(cache, ep->host);
+    lock(cache);
+    updateEntry(cache, ep, addresses, mprGetTicks());
+    ep->refreshing = 0;
+    cache->refreshes++;
+    unlock(cache);
+}
+
+
+/*
+    Resolve a host name via the system resolver and return a list of unique numeric addresses
+ */
+static MprList *resolve(HttpDnsCache *cache, cchar *host)
+{
+    struct addrinfo     hints, *res, *r;
+    MprList             *addresses;
+    MprTicks            mark, elapsed;
+    char                addr[64], *ip;
+    int                 rc, next, family;
+
+    addresses = mprCreateList(0, 0);
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    res = 0;
+    mark = mprGetTicks();
+
+    /* The system resolver may block. Yield so the garbage collector is not delayed. No allocations while yielded. */
+    mprYield(MPR_YIELD_STICKY);
+    rc = getaddrinfo(host, NULL, &hints, &res);
+    mprResetYield();
+
+    if (rc == 0) {
+        /* As for mprGetSocketInfo, prefer IPv4. IPv6 addresses are used only if the host has no IPv4 address. */
+        for (family = AF_INET, r = res; r; r = r->ai_next) {
+            if (r->ai_family == AF_INET) {
+                break;
+            }
+            if (r->ai_family == AF_INET6) {
+                family = AF_INET6;
+            }
+        }
+        if (r) {
+            family = AF_INET;
+        }
+        for (r = res; r; r = r->ai_next) {
+            if (r->ai_family != family || 
+                    getnameinfo(r->ai_addr, (int) r->ai_addrlen, addr, sizeof(addr), NULL, 0, NI_NUMERICHOST) != 0) {
+                continue;
+            }
+            for (next = 0; (ip = mprGetNextItem(addresses, &next)) != 0; ) {
+                if (smatch(ip, addr)) {
+                    break;
+                }
+            }
+            if (!ip) {
+                mprAddItem(addresses, sclone(addr));
+            }
+        }
+        freeaddrinfo(res);
+    }
+    elapsed = mprGetTicks() - mark;
+    lock(cache);
+    cache->lookups++;
+    cache->lookupTime += elapsed;
+    cache->maxLookupTime = max(cache->maxLookupTime, elapsed);
+    unlock(cache);
+    if (rc != 0) {
+        mprLog(3, "Http: cannot resolve host %s", host);
+    }
+    return addresses;
+}
+
+
+static bool isNumericAddress(cchar *host)
+{
+    struct addrinfo     hints, *res;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_flags = AI_NUMERICHOST;
+    res = 0;
+    if (getaddrinfo(host, NULL, &hints, &res) != 0) {
+        return 0;
+    }
+    freeaddrinfo(res);
+    return 1;
+}
+
+
+/*
+    Remove expired entries. If none have expired, remove one entry. Caller must hold the lock.
+ */
+static void pruneDnsCache(HttpDnsCache *cache, MprTicks now)
+{
+    MprKey      *kp;
+    DnsEntry    *ep, *victim;
+    int         removed;
+
+    removed = 0;
+    victim = 0;
+    for (ITERATE_KEYS(cache->hosts, kp)) {
+        ep = (DnsEntry*) kp->data;
+        if (ep->preloaded || ep->refreshing) {
+            continue;
+        }
+        if (ep->expires <= now) {
+            mprRemoveKey(cache->hosts, kp->key);
+            removed++;
+        } else if (!victim || ep->expires < victim->expires) {
+            victim = ep;
+        }
+    }
+    if (!removed && victim) {
+        mprRemoveKey(cache->hosts, victim->host);
+    }
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a 
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details and other copyrights.
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
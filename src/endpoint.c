@@ -347,6 +347,12 @@ PUBLIC int httpSecureEndpoint(HttpEndpoint *endpoint, struct MprSsl *ssl)
 {
 #if BIT_PACK_SSL
     endpoint->ssl = ssl;
+#if BIT_HTTP_HTTP2
+    if (ssl && !ssl->alpn && endpoint->http->serverLimits->streamsMax > 0) {
+        /* Offer HTTP/2 to clients via ALPN. Clients then send the HTTP/2 connection preface. */
+        mprSetSslAlpn(ssl, "h2,http/1.1");
+    }
+#endif
     return 0;
 #else
     return MPR_ERR_BAD_STATE;
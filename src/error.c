@@ -16,6 +16,12 @@ static char *formatErrorv(HttpConn *conn, int status, cchar *fmt, va_list args);
 
 PUBLIC void httpDisconnect(HttpConn *conn)
 {
+#if BIT_HTTP_HTTP2
+    if (conn->net) {
+        /* Reset the stream rather than the shared network connection */
+        httpResetHttp2Stream(conn, HTTP2_CANCEL);
+    } else
+#endif
     if (conn->sock) {
         mprDisconnectSocket(conn->sock);
     }
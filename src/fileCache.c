@@ -0,0 +1,380 @@
+/*
+    fileCache.c -- Open file and path information cache for static content
+
+    Caches the path information, ETag and an open file descriptor for static files so that requests for hot files
+    need not stat and open the file each time. Entries are revalidated after a configurable period by testing the
+    inode, size and modification time. Failed lookups are also cached so probing for mapped extensions is cheap.
+
+    The cached file descriptor is shared by concurrent requests. This is safe for the send connector which transmits
+    using positioned sendfile calls that do not use or modify the file position.
+
+    Optionally, the content of small files is held in memory. The send connector then writes the response headers
+    and file content with a single vectored write without accessing the file system. Memory use is bounded and the
+    content of the least recently used files is discarded first.
+
+    Copyright (c) All Rights Reserved. See copyright notice at the bottom of the file.
+ */
+
+/********************************* Includes ***********************************/
+
+#include    "http.h"
+
+/*********************************** Locals ***********************************/
+
+typedef struct CachedFile {
+    char            *path;              /* Filename */
+    char            *etag;              /* ETag derived from the inode, size and mtime */
+    char            *data;              /* File content for small files */
+    MprFile         *file;              /* Shared open file. Opened on first send */
+    MprPath         info;               /* Path information. May be invalid if the path does not exist */
+    MprTicks        checked;            /* When the path was last tested */
+    MprTicks        lastUsed;           /* When the entry was last used */
+} CachedFile;
+
+/********************************** Forwards **********************************/
+
+static void discardContent(HttpFileCache *cache, CachedFile *cp);
+static CachedFile *getCachedFile(HttpConn *conn, cchar *path);
+static void manageCachedFile(CachedFile *cp, int flags);
+static void manageFileCache(HttpFileCache *cache, int flags);
+static void pruneContent(HttpFileCache *cache, CachedFile *keep);
+static void pruneFileCache(HttpFileCache *cache, MprTicks now);
+static char *readContent(cchar *path, MprOff size);
+
+/************************************ Code ************************************/
+/*
+    Enable caching of path information and open files. Set maxFiles to zero to disable.
+ */
+PUBLIC int httpSetFileCache(Http *http, int maxFiles, MprTicks revalidate)
+{
+    HttpFileCache   *cache;
+
+    if (maxFiles <= 0) {
+        http->fileCache = 0;
+        return 0;
+    }
+    if ((cache = mprAllocObj(HttpFileCache, manageFileCache)) == 0) {
+        return MPR_ERR_MEMORY;
+    }
+    cache->files = mprCreateHash(maxFiles, 0);
+    cache->mutex = mprCreateLock();
+    cache->maxFiles = maxFiles;
+    cache->revalidate = max(revalidate, 0);
+    http->fileCache = cache;
+    return 0;
+}
+
+
+/*
+    Hold the content of small files in memory. Requires the file cache.
+ */
+PUBLIC int httpSetFileCacheContent(Http *http, ssize maxFileSize, MprOff maxMemory)
+{
+    HttpFileCache   *cache;
+
+    if ((cache = http->fileCache) == 0) {
+        return MPR_ERR_BAD_STATE;
+    }
+    lock(cache);
+    cache->maxFileSize = max(maxFileSize, 0);
+    cache->maxMemory = max(maxMemory, 0);
+    pruneContent(cache, NULL);
+    unlock(cache);
+    return 0;
+}
+
+
+static void manageFileCache(HttpFileCache *cache, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(cache->files);
+        mprMark(cache->mutex);
+    }
+}
+
+
+static void manageCachedFile(CachedFile *cp, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(cp->path);
+        mprMark(cp->etag);
+        mprMark(cp->data);
+        mprMark(cp->file);
+    }
+}
+
+
+/*
+    Get the path information for a file and optionally the file ETag. Returns zero if the path exists.
+    This is a caching replacement for mprGetPathInfo.
+ */
+PUBLIC int httpGetCachedPathInfo(HttpConn *conn, cchar *path, MprPath *info, cchar **etag)
+{
+    HttpFileCache   *cache;
+    CachedFile      *cp;
+    int             rc;
+
+    if ((cache = conn->http->fileCache) == 0) {
+        rc = mprGetPathInfo(path, info);
+        if (etag) {
+            *etag = (rc == 0) ? sfmt("\"%Lx-%Lx-%Lx\"", (int64) info->inode, (int64) info->size,
+                (int64) info->mtime) : 0;
+        }
+        return rc;
+    }
+    lock(cache);
+    if ((cp = getCachedFile(conn, path)) == 0) {
+        unlock(cache);
+        return mprGetPathInfo(path, info);
+    }
+    *info = cp->info;
+    if (etag) {
+        *etag = cp->etag;
+    }
+    unlock(cache);
+    return info->valid ? 0 : MPR_ERR_CANT_ACCESS;
+}
+
+
+/*
+    Open the response file for sending. If the file cache is enabled, the open file is shared with other requests
+    and the HTTP_TX_SHARED_FILE flag is set so the file is not closed when the request completes.
+ */
+PUBLIC MprFile *httpOpenCachedFile(HttpConn *conn, cchar *path)
+{
+    HttpFileCache   *cache;
+    CachedFile      *cp;
+    MprFile         *file;
+
+    if ((cache = conn->http->fileCache) != 0) {
+        lock(cache);
+        if ((cp = getCachedFile(conn, path)) != 0 && cp->info.valid && cp->info.isReg) {
+            if (!cp->file) {
+                cp->file = mprOpenFile(path, O_RDONLY | O_BINARY, 0);
+            }
+            if ((file = cp->file) != 0) {
+                conn->tx->flags |= HTTP_TX_SHARED_FILE;
+                unlock(cache);
+                return file;
+            }
+        }
+        unlock(cache);
+    }
+    return mprOpenFile(path, O_RDONLY | O_BINARY, 0);
+}
+
+
+/*
+    Get the in-memory content for a small file. The file must match the request file info. Returns NULL if the file
+    is not eligible or cannot be read.
+ */
+PUBLIC char *httpGetCachedFileData(HttpConn *conn, cchar *path)
+{
+    HttpFileCache   *cache;
+    CachedFile      *cp;
+    MprPath         *info;
+    char            *data;
+
+    if ((cache = conn->http->fileCache) == 0 || cache->maxFileSize <= 0) {
+        return 0;
+    }
+    info = &conn->tx->fileInfo;
+    if (!info->valid || info->size <= 0 || info->size > cache->maxFileSize) {
+        return 0;
+    }
+    lock(cache);
+    if ((cp = getCachedFile(conn, path)) == 0 || !cp->info.valid || !cp->info.isReg || 
+            cp->info.inode != info->inode || cp->info.size != info->size || cp->info.mtime != info->mtime) {
+        unlock(cache);
+        return 0;
+    }
+    if ((data = cp->data) != 0) {
+        cache->contentHits++;
+        unlock(cache);
+        return data;
+    }
+    cache->contentMisses++;
+    unlock(cache);
+
+    /* Read without holding the lock */
+    if ((data = readContent(path, info->size)) == 0) {
+        return 0;
+    }
+    lock(cache);
+    if (mprLookupKey(cache->files, path) == cp && !cp->data && cp->info.inode == info->inode && 
+            cp->info.size == info->size && cp->info.mtime == info->mtime) {
+        cp->data = data;
+        cache->memory += cp->info.size;
+        pruneContent(cache, cp);
+    }
+    unlock(cache);
+    return data;
+}
+
+
+static char *readContent(cchar *path, MprOff size)
+{
+    MprFile     *file;
+    char        *data;
+    ssize       len, nbytes;
+
+    if ((file = mprOpenFile(path, O_RDONLY | O_BINARY, 0)) == 0) {
+        return 0;
+    }
+    if ((data = mprAlloc((ssize) size + 1)) == 0) {
+        mprCloseFile(file);
+        return 0;
+    }
+    for (len = 0; len < size; len += nbytes) {
+        if ((nbytes = mprReadFile(file, &data[len], (ssize) size - len)) <= 0) {
+            mprCloseFile(file);
+            return 0;
+        }
+    }
+    data[len] = '\0';
+    mprCloseFile(file);
+    return data;
+}
+
+
+/*
+    Discard the content of the least recently used files while over the memory limit. Caller must hold the lock.
+ */
+static void pruneContent(HttpFileCache *cache, CachedFile *keep)
+{
+    MprKey      *kp;
+    CachedFile  *cp, *oldest;
+
+    while (cache->memory > cache->maxMemory) {
+        oldest = 0;
+        for (ITERATE_KEYS(cache->files, kp)) {
+            cp = (CachedFile*) kp->data;
+            if (cp->data && cp != keep && (!oldest || cp->lastUsed < oldest->lastUsed)) {
+                oldest = cp;
+            }
+        }
+        if (!oldest) {
+            if (keep && keep->data) {
+                discardContent(cache, keep);
+            }
+            break;
+        }
+        discardContent(cache, oldest);
+    }
+}
+
+
+/*
+    Requests still using the content retain a reference until they complete. Caller must hold the lock.
+ */
+static void discardContent(HttpFileCache *cache, CachedFile *cp)
+{
+    if (cp->data) {
+        cache->memory -= cp->info.size;
+        cp->data = 0;
+    }
+}
+
+
+/*
+    Lookup or create the cache entry for a path and revalidate if required. Caller must hold the cache lock.
+ */
+static CachedFile *getCachedFile(HttpConn *conn, cchar *path)
+{
+    HttpFileCache   *cache;
+    CachedFile      *cp;
+    MprPath         info;
+    MprTicks        now;
+
+    cache = conn->http->fileCache;
+    now = conn->http->now;
+
+    if ((cp = mprLookupKey(cache->files, path)) != 0) {
+        /* The time is only updated periodically, so a zero period must always revalidate */
+        if (cache->revalidate > 0 && (cp->checked + cache->revalidate) >= now) {
+            cp->lastUsed = now;
+            cache->hits++;
+            return cp;
+        }
+        cache->misses++;
+        mprGetPathInfo(path, &info);
+        if (info.valid != cp->info.valid || info.inode != cp->info.inode || info.size != cp->info.size ||
+                info.mtime != cp->info.mtime) {
+            /* Modified. The open file is closed when requests using it complete */
+            discardContent(cache, cp);
+            cp->info = info;
+            cp->file = 0;
+            cp->etag = 0;
+            if (info.valid) {
+                cp->etag = sfmt("\"%Lx-%Lx-%Lx\"", (int64) info.inode, (int64) info.size, (int64) info.mtime);
+            }
+        }
+        cp->checked = cp->lastUsed = now;
+        return cp;
+    }
+    if (mprGetHashLength(cache->files) >= cache->maxFiles) {
+        pruneFileCache(cache, now);
+    }
+    cache->misses++;
+    if ((cp = mprAllocObj(CachedFile, manageCachedFile)) == 0) {
+        return 0;
+    }
+    cp->path = sclone(path);
+    mprGetPathInfo(path, &cp->info);
+    if (cp->info.valid) {
+        cp->etag = sfmt("\"%Lx-%Lx-%Lx\"", (int64) cp->info.inode, (int64) cp->info.size, (int64) cp->info.mtime);
+    }
+    cp->checked = cp->lastUsed = now;
+    mprAddKey(cache->files, cp->path, cp);
+    return cp;
+}
+
+
+/*
+    Make room for a new entry. Remove all entries that are due for revalidation and have not been used since.
+    If none qualify, remove the least recently used entry. Caller must hold the cache lock.
+ */
+static void pruneFileCache(HttpFileCache *cache, MprTicks now)
+{
+    MprKey      *kp;
+    CachedFile  *cp, *oldest;
+    int         removed;
+
+    oldest = 0;
+    removed = 0;
+    for (ITERATE_KEYS(cache->files, kp)) {
+        cp = (CachedFile*) kp->data;
+        if ((cp->lastUsed + cache->revalidate) < now) {
+            discardContent(cache, cp);
+            mprRemoveKey(cache->files, kp->key);
+            removed++;
+        } else if (!oldest || cp->lastUsed < oldest->lastUsed) {
+            oldest = cp;
+        }
+    }
+    if (!removed && oldest) {
+        discardContent(cache, oldest);
+        mprRemoveKey(cache->files, oldest->path);
+    }
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a 
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details and other copyrights.
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
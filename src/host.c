@@ -65,6 +65,7 @@ PUBLIC HttpHost *httpCloneHost(HttpHost *parent)
      */
     host->parent = parent;
     host->responseCache = parent->responseCache;
+    host->responseStore = parent->responseStore;
     host->routes = parent->routes;
     host->flags = parent->flags | HTTP_HOST_VHOST;
     host->protocol = parent->protocol;
@@ -81,6 +82,7 @@ static void manageHost(HttpHost *host, int flags)
         mprMark(host->ip);
         mprMark(host->parent);
         mprMark(host->responseCache);
+        mprMark(host->responseStore);
         mprMark(host->routes);
         mprMark(host->defaultRoute);
         mprMark(host->protocol);
@@ -269,6 +271,8 @@ PUBLIC int httpAddRoute(HttpHost *host, HttpRoute *route)
         } else {
             thisRoute = mprAddItem(host->routes, route);
         }
+        /* The new route is the last of its group. Otherwise a failed segment match restarts at the first route. */
+        route->nextGroup = thisRoute + 1;
         if (thisRoute > 0) {
             prev = mprGetItem(host->routes, thisRoute - 1);
             if (!smatch(prev->startSegment, route->startSegment)) {
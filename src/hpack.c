@@ -0,0 +1,603 @@
+/*
+    hpack.c - HPACK header compression for HTTP/2 (RFC 7541)
+
+    The static table, dynamic table and canonical Huffman code are implemented here. A header table is used in one
+    direction only: an HTTP/2 connection has one table for decoding and another for encoding.
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************* Includes ***********************************/
+
+#include    "http.h"
+
+#if BIT_HTTP_HTTP2
+/*********************************** Locals ***********************************/
+
+#define HPACK_ENTRY_OVERHEAD    32          /* Per entry overhead defined by RFC 7541 section 4.1 */
+#define HPACK_STATIC_COUNT      61          /* Number of static table entries */
+#define HPACK_MAX_INT           0x0FFFFFFF  /* Largest integer accepted when decoding */
+#define HPACK_MIN_CODE          5           /* Shortest Huffman code length */
+#define HPACK_MAX_CODE          30          /* Longest Huffman code length */
+#define HPACK_EOS               256         /* End of string symbol */
+
+typedef struct HpackEntry {
+    cchar   *name;
+    cchar   *value;
+} HpackEntry;
+
+/*
+    Static table. Index 1 is the first entry.
+ */
+static HpackEntry staticTable[HPACK_STATIC_COUNT] = {
+    { ":authority", "" },
+    { ":method", "GET" },
+    { ":method", "POST" },
+    { ":path", "/" },
+    { ":path", "/index.html" },
+    { ":scheme", "http" },
+    { ":scheme", "https" },
+    { ":status", "200" },
+    { ":status", "204" },
+    { ":status", "206" },
+    { ":status", "304" },
+    { ":status", "400" },
+    { ":status", "404" },
+    { ":status", "500" },
+    { "accept-charset", "" },
+    { "accept-encoding", "gzip, deflate" },
+    { "accept-language", "" },
+    { "accept-ranges", "" },
+    { "accept", "" },
+    { "access-control-allow-origin", "" },
+    { "age", "" },
+    { "allow", "" },
+    { "authorization", "" },
+    { "cache-control", "" },
+    { "content-disposition", "" },
+    { "content-encoding", "" },
+    { "content-language", "" },
+    { "content-length", "" },
+    { "content-location", "" },
+    { "content-range", "" },
+    { "content-type", "" },
+    { "cookie", "" },
+    { "date", "" },
+    { "etag", "" },
+    { "expect", "" },
+    { "expires", "" },
+    { "from", "" },
+    { "host", "" },
+    { "if-match", "" },
+    { "if-modified-since", "" },
+    { "if-none-match", "" },
+    { "if-range", "" },
+    { "if-unmodified-since", "" },
+    { "last-modified", "" },
+    { "link", "" },
+    { "location", "" },
+    { "max-forwards", "" },
+    { "proxy-authenticate", "" },
+    { "proxy-authorization", "" },
+    { "range", "" },
+    { "referer", "" },
+    { "refresh", "" },
+    { "retry-after", "" },
+    { "server", "" },
+    { "set-cookie", "" },
+    { "strict-transport-security", "" },
+    { "transfer-encoding", "" },
+    { "user-agent", "" },
+    { "vary", "" },
+    { "via", "" },
+    { "www-authenticate", "" },
+};
+
+/*
+    Huffman code (RFC 7541 Appendix B) indexed by symbol. The code is canonical: codes of the same length are
+    consecutive and are assigned in symbol order.
+ */
+typedef struct HpackCode {
+    uint    code;
+    int     bits;
+} HpackCode;
+
+static HpackCode huffCodes[257] = {
+    { 0x00001ff8, 13 }, { 0x007fffd8, 23 }, { 0x0fffffe2, 28 }, { 0x0fffffe3, 28 },
+    { 0x0fffffe4, 28 }, { 0x0fffffe5, 28 }, { 0x0fffffe6, 28 }, { 0x0fffffe7, 28 },
+    { 0x0fffffe8, 28 }, { 0x00ffffea, 24 }, { 0x3ffffffc, 30 }, { 0x0fffffe9, 28 },
+    { 0x0fffffea, 28 }, { 0x3ffffffd, 30 }, { 0x0fffffeb, 28 }, { 0x0fffffec, 28 },
+    { 0x0fffffed, 28 }, { 0x0fffffee, 28 }, { 0x0fffffef, 28 }, { 0x0ffffff0, 28 },
+    { 0x0ffffff1, 28 }, { 0x0ffffff2, 28 }, { 0x3ffffffe, 30 }, { 0x0ffffff3, 28 },
+    { 0x0ffffff4, 28 }, { 0x0ffffff5, 28 }, { 0x0ffffff6, 28 }, { 0x0ffffff7, 28 },
+    { 0x0ffffff8, 28 }, { 0x0ffffff9, 28 }, { 0x0ffffffa, 28 }, { 0x0ffffffb, 28 },
+    { 0x00000014,  6 }, { 0x000003f8, 10 }, { 0x000003f9, 10 }, { 0x00000ffa, 12 },
+    { 0x00001ff9, 13 }, { 0x00000015,  6 }, { 0x000000f8,  8 }, { 0x000007fa, 11 },
+    { 0x000003fa, 10 }, { 0x000003fb, 10 }, { 0x000000f9,  8 }, { 0x000007fb, 11 },
+    { 0x000000fa,  8 }, { 0x00000016,  6 }, { 0x00000017,  6 }, { 0x00000018,  6 },
+    { 0x00000000,  5 }, { 0x00000001,  5 }, { 0x00000002,  5 }, { 0x00000019,  6 },
+    { 0x0000001a,  6 }, { 0x0000001b,  6 }, { 0x0000001c,  6 }, { 0x0000001d,  6 },
+    { 0x0000001e,  6 }, { 0x0000001f,  6 }, { 0x0000005c,  7 }, { 0x000000fb,  8 },
+    { 0x00007ffc, 15 }, { 0x00000020,  6 }, { 0x00000ffb, 12 }, { 0x000003fc, 10 },
+    { 0x00001ffa, 13 }, { 0x00000021,  6 }, { 0x0000005d,  7 }, { 0x0000005e,  7 },
+    { 0x0000005f,  7 }, { 0x00000060,  7 }, { 0x00000061,  7 }, { 0x00000062,  7 },
+    { 0x00000063,  7 }, { 0x00000064,  7 }, { 0x00000065,  7 }, { 0x00000066,  7 },
+    { 0x00000067,  7 }, { 0x00000068,  7 }, { 0x00000069,  7 }, { 0x0000006a,  7 },
+    { 0x0000006b,  7 }, { 0x0000006c,  7 }, { 0x0000006d,  7 }, { 0x0000006e,  7 },
+    { 0x0000006f,  7 }, { 0x00000070,  7 }, { 0x00000071,  7 }, { 0x00000072,  7 },
+    { 0x000000fc,  8 }, { 0x00000073,  7 }, { 0x000000fd,  8 }, { 0x00001ffb, 13 },
+    { 0x0007fff0, 19 }, { 0x00001ffc, 13 }, { 0x00003ffc, 14 }, { 0x00000022,  6 },
+    { 0x00007ffd, 15 }, { 0x00000003,  5 }, { 0x00000023,  6 }, { 0x00000004,  5 },
+    { 0x00000024,  6 }, { 0x00000005,  5 }, { 0x00000025,  6 }, { 0x00000026,  6 },
+    { 0x00000027,  6 }, { 0x00000006,  5 }, { 0x00000074,  7 }, { 0x00000075,  7 },
+    { 0x00000028,  6 }, { 0x00000029,  6 }, { 0x0000002a,  6 }, { 0x00000007,  5 },
+    { 0x0000002b,  6 }, { 0x00000076,  7 }, { 0x0000002c,  6 }, { 0x00000008,  5 },
+    { 0x00000009,  5 }, { 0x0000002d,  6 }, { 0x00000077,  7 }, { 0x00000078,  7 },
+    { 0x00000079,  7 }, { 0x0000007a,  7 }, { 0x0000007b,  7 }, { 0x00007ffe, 15 },
+    { 0x000007fc, 11 }, { 0x00003ffd, 14 }, { 0x00001ffd, 13 }, { 0x0ffffffc, 28 },
+    { 0x000fffe6, 20 }, { 0x003fffd2, 22 }, { 0x000fffe7, 20 }, { 0x000fffe8, 20 },
+    { 0x003fffd3, 22 }, { 0x003fffd4, 22 }, { 0x003fffd5, 22 }, { 0x007fffd9, 23 },
+    { 0x003fffd6, 22 }, { 0x007fffda, 23 }, { 0x007fffdb, 23 }, { 0x007fffdc, 23 },
+    { 0x007fffdd, 23 }, { 0x007fffde, 23 }, { 0x00ffffeb, 24 }, { 0x007fffdf, 23 },
+    { 0x00ffffec, 24 }, { 0x00ffffed, 24 }, { 0x003fffd7, 22 }, { 0x007fffe0, 23 },
+    { 0x00ffffee, 24 }, { 0x007fffe1, 23 }, { 0x007fffe2, 23 }, { 0x007fffe3, 23 },
+    { 0x007fffe4, 23 }, { 0x001fffdc, 21 }, { 0x003fffd8, 22 }, { 0x007fffe5, 23 },
+    { 0x003fffd9, 22 }, { 0x007fffe6, 23 }, { 0x007fffe7, 23 }, { 0x00ffffef, 24 },
+    { 0x003fffda, 22 }, { 0x001fffdd, 21 }, { 0x000fffe9, 20 }, { 0x003fffdb, 22 },
+    { 0x003fffdc, 22 }, { 0x007fffe8, 23 }, { 0x007fffe9, 23 }, { 0x001fffde, 21 },
+    { 0x007fffea, 23 }, { 0x003fffdd, 22 }, { 0x003fffde, 22 }, { 0x00fffff0, 24 },
+    { 0x001fffdf, 21 }, { 0x003fffdf, 22 }, { 0x007fffeb, 23 }, { 0x007fffec, 23 },
+    { 0x001fffe0, 21 }, { 0x001fffe1, 21 }, { 0x003fffe0, 22 }, { 0x001fffe2, 21 },
+    { 0x007fffed, 23 }, { 0x003fffe1, 22 }, { 0x007fffee, 23 }, { 0x007fffef, 23 },
+    { 0x000fffea, 20 }, { 0x003fffe2, 22 }, { 0x003fffe3, 22 }, { 0x003fffe4, 22 },
+    { 0x007ffff0, 23 }, { 0x003fffe5, 22 }, { 0x003fffe6, 22 }, { 0x007ffff1, 23 },
+    { 0x03ffffe0, 26 }, { 0x03ffffe1, 26 }, { 0x000fffeb, 20 }, { 0x0007fff1, 19 },
+    { 0x003fffe7, 22 }, { 0x007ffff2, 23 }, { 0x003fffe8, 22 }, { 0x01ffffec, 25 },
+    { 0x03ffffe2, 26 }, { 0x03ffffe3, 26 }, { 0x03ffffe4, 26 }, { 0x07ffffde, 27 },
+    { 0x07ffffdf, 27 }, { 0x03ffffe5, 26 }, { 0x00fffff1, 24 }, { 0x01ffffed, 25 },
+    { 0x0007fff2, 19 }, { 0x001fffe3, 21 }, { 0x03ffffe6, 26 }, { 0x07ffffe0, 27 },
+    { 0x07ffffe1, 27 }, { 0x03ffffe7, 26 }, { 0x07ffffe2, 27 }, { 0x00fffff2, 24 },
+    { 0x001fffe4, 21 }, { 0x001fffe5, 21 }, { 0x03ffffe8, 26 }, { 0x03ffffe9, 26 },
+    { 0x0ffffffd, 28 }, { 0x07ffffe3, 27 }, { 0x07ffffe4, 27 }, { 0x07ffffe5, 27 },
+    { 0x000fffec, 20 }, { 0x00fffff3, 24 }, { 0x000fffed, 20 }, { 0x001fffe6, 21 },
+    { 0x003fffe9, 22 }, { 0x001fffe7, 21 }, { 0x001fffe8, 21 }, { 0x007ffff3, 23 },
+    { 0x003fffea, 22 }, { 0x003fffeb, 22 }, { 0x01ffffee, 25 }, { 0x01ffffef, 25 },
+    { 0x00fffff4, 24 }, { 0x00fffff5, 24 }, { 0x03ffffea, 26 }, { 0x007ffff4, 23 },
+    { 0x03ffffeb, 26 }, { 0x07ffffe6, 27 }, { 0x03ffffec, 26 }, { 0x03ffffed, 26 },
+    { 0x07ffffe7, 27 }, { 0x07ffffe8, 27 }, { 0x07ffffe9, 27 }, { 0x07ffffea, 27 },
+    { 0x07ffffeb, 27 }, { 0x0ffffffe, 28 }, { 0x07ffffec, 27 }, { 0x07ffffed, 27 },
+    { 0x07ffffee, 27 }, { 0x07ffffef, 27 }, { 0x07fffff0, 27 }, { 0x03ffffee, 26 },
+    { 0x3fffffff, 30 },
+};
+
+/*
+    Huffman decoding tables indexed by code length. Built from huffCodes on first use.
+ */
+static uint     huffFirst[HPACK_MAX_CODE + 1];      /* First code of each length */
+static int      huffCount[HPACK_MAX_CODE + 1];      /* Number of codes of each length */
+static int      huffOffset[HPACK_MAX_CODE + 1];     /* Index into huffSymbols of the first code of each length */
+static short    huffSymbols[257];                   /* Symbols ordered by code */
+static int      huffReady;
+
+/*
+    Headers with values that are rarely repeated are not added to the dynamic table when encoding
+ */
+static cchar *uniqueHeaders[] = {
+    "content-length", "content-range", "date", "etag", "expires", "last-modified", "location", "set-cookie", 0
+};
+
+/***************************** Forward Declarations ***************************/
+
+static void addEntry(HttpHpack *hp, MprKeyValue *kp);
+static int decodeHuff(cuchar *data, ssize len, MprBuf *buf);
+static int decodeInt(cuchar **pp, cuchar *end, int prefix, uint *value);
+static char *decodeString(cuchar **pp, cuchar *end);
+static void encodeInt(MprBuf *buf, int first, int prefix, uint value);
+static void encodeString(MprBuf *buf, cchar *str);
+static void initHuff(void);
+static MprKeyValue *lookupEntry(HttpHpack *hp, uint index);
+static void manageHpack(HttpHpack *hp, int flags);
+
+/************************************* Code ***********************************/
+
+PUBLIC HttpHpack *httpCreateHpack(ssize max)
+{
+    HttpHpack   *hp;
+
+    if (!huffReady) {
+        initHuff();
+    }
+    if ((hp = mprAllocObj(HttpHpack, manageHpack)) == 0) {
+        return 0;
+    }
+    hp->entries = mprCreateList(0, 0);
+    hp->max = max;
+    return hp;
+}
+
+
+static void manageHpack(HttpHpack *hp, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(hp->entries);
+    }
+}
+
+
+static void initHuff(void)
+{
+    int     len, sym, index;
+
+    for (sym = 0; sym <= HPACK_EOS; sym++) {
+        huffCount[huffCodes[sym].bits]++;
+    }
+    for (index = 0, len = HPACK_MIN_CODE; len <= HPACK_MAX_CODE; len++) {
+        huffOffset[len] = index;
+        index += huffCount[len];
+    }
+    for (len = HPACK_MIN_CODE; len <= HPACK_MAX_CODE; len++) {
+        huffFirst[len] = ~0U;
+    }
+    memset(huffCount, 0, sizeof(huffCount));
+    for (sym = 0; sym <= HPACK_EOS; sym++) {
+        len = huffCodes[sym].bits;
+        if (huffCount[len] == 0) {
+            huffFirst[len] = huffCodes[sym].code;
+        }
+        huffSymbols[huffOffset[len] + huffCount[len]++] = (short) sym;
+    }
+    huffReady = 1;
+}
+
+
+PUBLIC void httpSetHpackSize(HttpHpack *hp, ssize max)
+{
+    MprKeyValue     *kp;
+
+    if (max != hp->max) {
+        hp->max = max;
+        hp->update = 1;
+    }
+    while (hp->size > hp->max && (kp = mprGetLastItem(hp->entries)) != 0) {
+        hp->size -= slen(kp->key) + slen(kp->value) + HPACK_ENTRY_OVERHEAD;
+        mprRemoveLastItem(hp->entries);
+    }
+}
+
+
+/*
+    Add an entry to the front of the dynamic table and evict the oldest entries to fit.
+    An entry larger than the table empties the table and is not added.
+ */
+static void addEntry(HttpHpack *hp, MprKeyValue *kp)
+{
+    MprKeyValue     *old;
+    ssize           size;
+
+    size = slen(kp->key) + slen(kp->value) + HPACK_ENTRY_OVERHEAD;
+    while (hp->size + size > hp->max && (old = mprGetLastItem(hp->entries)) != 0) {
+        hp->size -= slen(old->key) + slen(old->value) + HPACK_ENTRY_OVERHEAD;
+        mprRemoveLastItem(hp->entries);
+    }
+    if (size <= hp->max) {
+        mprInsertItemAtPos(hp->entries, 0, kp);
+        hp->size += size;
+    }
+}
+
+
+static MprKeyValue *lookupEntry(HttpHpack *hp, uint index)
+{
+    HpackEntry  *ep;
+
+    if (index == 0) {
+        return 0;
+    }
+    if (index <= HPACK_STATIC_COUNT) {
+        ep = &staticTable[index - 1];
+        return mprCreateKeyPair(ep->name, ep->value, 0);
+    }
+    return mprGetItem(hp->entries, (int) (index - HPACK_STATIC_COUNT - 1));
+}
+
+
+PUBLIC int httpHpackDecode(HttpHpack *hp, MprList *headers, cuchar *data, ssize len, ssize max)
+{
+    MprKeyValue     *kp;
+    cuchar          *p, *end;
+    char            *name, *value;
+    ssize           total;
+    uint            index;
+    int             c, prefix;
+
+    p = data;
+    end = &data[len];
+    total = 0;
+    while (p < end) {
+        c = *p;
+        if (c & 0x80) {
+            /* Indexed header field */
+            if (decodeInt(&p, end, 7, &index) < 0 || (kp = lookupEntry(hp, index)) == 0) {
+                return MPR_ERR_BAD_FORMAT;
+            }
+        } else if ((c & 0xE0) == 0x20) {
+            /* Dynamic table size update */
+            if (decodeInt(&p, end, 5, &index) < 0 || index > HTTP2_TABLE_SIZE) {
+                return MPR_ERR_BAD_FORMAT;
+            }
+            httpSetHpackSize(hp, index);
+            hp->update = 0;
+            continue;
+        } else {
+            /* Literal header field with incremental indexing (0x40), without indexing (0x00) or never indexed (0x10) */
+            prefix = (c & 0x40) ? 6 : 4;
+            if (decodeInt(&p, end, prefix, &index) < 0) {
+                return MPR_ERR_BAD_FORMAT;
+            }
+            if (index) {
+                if ((kp = lookupEntry(hp, index)) == 0) {
+                    return MPR_ERR_BAD_FORMAT;
+                }
+                name = kp->key;
+            } else if ((name = decodeString(&p, end)) == 0) {
+                return MPR_ERR_BAD_FORMAT;
+            }
+            if ((value = decodeString(&p, end)) == 0) {
+                return MPR_ERR_BAD_FORMAT;
+            }
+            kp = mprCreateKeyPair(name, value, 0);
+            if (c & 0x40) {
+                addEntry(hp, kp);
+            }
+        }
+        total += slen(kp->key) + slen(kp->value);
+        if (total > max) {
+            return MPR_ERR_WONT_FIT;
+        }
+        mprAddItem(headers, kp);
+    }
+    return 0;
+}
+
+
+/*
+    Decode an integer with an N-bit prefix (RFC 7541 section 5.1)
+ */
+static int decodeInt(cuchar **pp, cuchar *end, int prefix, uint *value)
+{
+    cuchar  *p;
+    uint    max, v;
+    int     shift;
+
+    p = *pp;
+    max = (1 << prefix) - 1;
+    v = *p++ & max;
+    if (v == max) {
+        for (shift = 0; ; shift += 7) {
+            if (p >= end || shift > 21) {
+                return MPR_ERR_BAD_FORMAT;
+            }
+            v += (*p & 0x7F) << shift;
+            if (!(*p++ & 0x80)) {
+                break;
+            }
+        }
+        if (v > HPACK_MAX_INT) {
+            return MPR_ERR_BAD_FORMAT;
+        }
+    }
+    *pp = p;
+    *value = v;
+    return 0;
+}
+
+
+/*
+    Decode a string literal (RFC 7541 section 5.2)
+ */
+static char *decodeString(cuchar **pp, cuchar *end)
+{
+    MprBuf  *buf;
+    cuchar  *p;
+    uint    len;
+    int     huff;
+
+    p = *pp;
+    if (p >= end) {
+        return 0;
+    }
+    huff = *p & 0x80;
+    if (decodeInt(&p, end, 7, &len) < 0 || len > (uint) (end - p)) {
+        return 0;
+    }
+    *pp = p + len;
+    if (!huff) {
+        return snclone((cchar*) p, len);
+    }
+    buf = mprCreateBuf(len * 8 / 5 + 1, -1);
+    if (decodeHuff(p, len, buf) < 0) {
+        return 0;
+    }
+    mprAddNullToBuf(buf);
+    return sclone(mprGetBufStart(buf));
+}
+
+
+static int decodeHuff(cuchar *data, ssize len, MprBuf *buf)
+{
+    cuchar  *end;
+    uint64  bits;
+    uint    code;
+    int     count, codeLen, sym;
+
+    bits = 0;
+    count = 0;
+    for (end = &data[len]; data < end; data++) {
+        bits = (bits << 8) | *data;
+        count += 8;
+        while (count >= HPACK_MIN_CODE) {
+            sym = -1;
+            for (codeLen = HPACK_MIN_CODE; codeLen <= count && codeLen <= HPACK_MAX_CODE; codeLen++) {
+                code = (uint) (bits >> (count - codeLen)) & ((1U << codeLen) - 1);
+                if (huffCount[codeLen] && code >= huffFirst[codeLen] && code - huffFirst[codeLen] < (uint) huffCount[codeLen]) {
+                    sym = huffSymbols[huffOffset[codeLen] + code - huffFirst[codeLen]];
+                    break;
+                }
+            }
+            if (sym < 0) {
+                if (count >= HPACK_MAX_CODE) {
+                    return MPR_ERR_BAD_FORMAT;
+                }
+                break;
+            }
+            if (sym == HPACK_EOS) {
+                return MPR_ERR_BAD_FORMAT;
+            }
+            mprPutCharToBuf(buf, sym);
+            count -= codeLen;
+        }
+    }
+    /*
+        Padding must be shorter than 8 bits and be the most significant bits of EOS (all ones)
+     */
+    if (count >= 8 || (bits & ((1U << count) - 1)) != ((1U << count) - 1)) {
+        return MPR_ERR_BAD_FORMAT;
+    }
+    return 0;
+}
+
+
+PUBLIC void httpHpackEncode(HttpHpack *hp, MprBuf *buf, cchar *name, cchar *value)
+{
+    MprKeyValue     *kp;
+    HpackEntry      *ep;
+    cchar           **up;
+    int             index, nameIndex, next, unique;
+
+    if (hp->update) {
+        encodeInt(buf, 0x20, 5, (uint) hp->max);
+        hp->update = 0;
+    }
+    index = nameIndex = 0;
+    for (ep = staticTable; ep < &staticTable[HPACK_STATIC_COUNT]; ep++) {
+        if (strcmp(ep->name, name) == 0) {
+            if (!nameIndex) {
+                nameIndex = (int) (ep - staticTable) + 1;
+            }
+            if (strcmp(ep->value, value) == 0) {
+                index = (int) (ep - staticTable) + 1;
+                break;
+            }
+        }
+    }
+    if (!index) {
+        for (next = 0; (kp = mprGetNextItem(hp->entries, &next)) != 0; ) {
+            if (strcmp(kp->key, name) == 0) {
+                if (!nameIndex) {
+                    nameIndex = HPACK_STATIC_COUNT + next;
+                }
+                if (strcmp(kp->value, value) == 0) {
+                    index = HPACK_STATIC_COUNT + next;
+                    break;
+                }
+            }
+        }
+    }
+    if (index) {
+        encodeInt(buf, 0x80, 7, index);
+        return;
+    }
+    for (unique = 0, up = uniqueHeaders; *up; up++) {
+        if (strcmp(*up, name) == 0) {
+            unique = 1;
+            break;
+        }
+    }
+    if (unique) {
+        encodeInt(buf, 0x00, 4, nameIndex);
+    } else {
+        encodeInt(buf, 0x40, 6, nameIndex);
+        addEntry(hp, mprCreateKeyPair(name, value, 0));
+    }
+    if (!nameIndex) {
+        encodeString(buf, name);
+    }
+    encodeString(buf, value);
+}
+
+
+static void encodeInt(MprBuf *buf, int first, int prefix, uint value)
+{
+    uint    max;
+
+    max = (1 << prefix) - 1;
+    if (value < max) {
+        mprPutCharToBuf(buf, first | value);
+        return;
+    }
+    mprPutCharToBuf(buf, first | max);
+    for (value -= max; value >= 0x80; value >>= 7) {
+        mprPutCharToBuf(buf, (value & 0x7F) | 0x80);
+    }
+    mprPutCharToBuf(buf, value);
+}
+
+
+/*
+    Encode a string literal using the Huffman code if that is shorter
+ */
+static void encodeString(MprBuf *buf, cchar *str)
+{
+    cuchar      *cp;
+    uint64      bits;
+    ssize       len, huffLen;
+    int         count;
+
+    len = slen(str);
+    for (huffLen = 0, cp = (cuchar*) str; *cp; cp++) {
+        huffLen += huffCodes[*cp].bits;
+    }
+    huffLen = (huffLen + 7) / 8;
+    if (huffLen >= len) {
+        encodeInt(buf, 0x00, 7, (uint) len);
+        mprPutBlockToBuf(buf, str, len);
+        return;
+    }
+    encodeInt(buf, 0x80, 7, (uint) huffLen);
+    bits = 0;
+    count = 0;
+    for (cp = (cuchar*) str; *cp; cp++) {
+        bits = (bits << huffCodes[*cp].bits) | huffCodes[*cp].code;
+        count += huffCodes[*cp].bits;
+        while (count >= 8) {
+            count -= 8;
+            mprPutCharToBuf(buf, (int) (bits >> count) & 0xFF);
+        }
+    }
+    if (count > 0) {
+        /* Pad with the most significant bits of EOS */
+        mprPutCharToBuf(buf, (int) ((bits << (8 - count)) | ((1 << (8 - count)) - 1)) & 0xFF);
+    }
+}
+
+#endif /* BIT_HTTP_HTTP2 */
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details and other copyrights.
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -12,11 +12,50 @@
 
 /*********************************** Locals ***********************************/
 
+/*
+    Latency histogram in microseconds. Values below HIST_SUB_COUNT are recorded exactly. Larger values are recorded in a
+    bucket per power of two that is divided into HIST_HALF_COUNT linear sub-buckets, giving better than 2% precision.
+ */
+#define HIST_SUB_BITS   7
+#define HIST_SUB_COUNT  (1 << HIST_SUB_BITS)
+#define HIST_HALF_COUNT (HIST_SUB_COUNT / 2)
+#define HIST_MAX_BITS   40
+#define HIST_SIZE       (HIST_SUB_COUNT + (HIST_MAX_BITS - HIST_SUB_BITS) * HIST_HALF_COUNT)
+
+typedef struct Histogram {
+    uint64          counts[HIST_SIZE];  /* Count of values per bucket */
+    uint64          count;              /* Total count of values */
+    uint64          max;                /* Maximum value */
+    double          sum;                /* Sum of values for the mean */
+} Histogram;
+
+/*
+    Open-loop load results. Each load thread records into its own instance which is merged when the thread completes.
+ */
+typedef struct LoadStats {
+    Histogram       latency;            /* Latency measured from the intended send time */
+    uint64          bytes;              /* Response body bytes received */
+    int             issued;             /* Requests issued */
+    int             completed;          /* Requests finished including failures */
+    int             ok;                 /* Responses with status less than 400 */
+    int             clientErrors;       /* 4xx responses */
+    int             serverErrors;       /* 5xx responses */
+    int             timeouts;           /* Requests that timed out */
+    int             connectErrors;      /* Requests that could not connect */
+    int             ioErrors;           /* Requests that failed for other reasons */
+} LoadStats;
+
 typedef struct ThreadData {
     HttpConn        *conn;
     MprDispatcher   *dispatcher;
     char            *url;
     MprList         *files;
+    HttpBatch       *batch;             /* Open-loop load request batch */
+    LoadStats       *stats;             /* Open-loop load results for this thread */
+    char            *body;              /* Open-loop load request body */
+    double          rate;               /* Open-loop target requests per second for this thread */
+    uint64          start;              /* Open-loop load start time in microseconds */
+    int             total;              /* Open-loop requests to issue */
 } ThreadData;
 
 typedef struct App {
@@ -27,6 +66,7 @@ typedef struct App {
     cchar    *cert;              /* Certificate to identify the client */
     int      chunkSize;          /* Ask for response data to be chunked in this quanta */
     char     *ciphers;           /* Set of acceptable ciphers to use for SSL */
+    int      connections;        /* Open-loop load concurrent requests per thread */
     int      continueOnErrors;   /* Continue testing even if an error occurs. Default is to stop */
     int      success;            /* Total success flag */
     int      fetchCount;         /* Total count of fetches */
@@ -37,9 +77,12 @@ typedef struct App {
     Mpr      *mpr;               /* Portable runtime */
     MprList  *headers;           /* Request headers */
     Http     *http;              /* Http service object */
+    int      duration;           /* Open-loop load duration in seconds */
     int      iterations;         /* URLs to fetch (per thread) */
+    int      json;               /* Emit open-loop load results as JSON */
     cchar    *key;               /* Private key file */
     char     *host;              /* Host to connect to */
+    LoadStats *loadStats;        /* Merged open-loop load results */
     int      loadThreads;        /* Number of threads to use for URL requests */
     char     *method;            /* HTTP method when URL on cmd line */
     int      nextArg;            /* Next arg to parse */
@@ -52,6 +95,7 @@ typedef struct App {
     char     *protocol;          /* HTTP/1.0, HTTP/1.1 */
     char     *provider;          /* SSL provider to use */
     char     *ranges;            /* Request ranges */
+    int      rate;               /* Open-loop load target requests per second. Zero for closed-loop operation */
     MprList  *requestFiles;      /* Request files */
     int      retries;            /* Times to retry a failed request */
     int      sequence;           /* Sequence requests with a custom header */
@@ -84,13 +128,23 @@ static int      doRequest(HttpConn *conn, cchar *url, MprList *files);
 static void     finishThread(MprThread *tp);
 static char     *getPassword();
 static void     initSettings();
+static uint64   getMicroseconds();
+static int      histIndex(uint64 value);
+static uint64   histValue(int index);
 static bool     isPort(cchar *name);
+static void     issueLoad(ThreadData *td, MprEvent *event);
+static void     loadResponse(HttpBatchRequest *req);
+static void     loadThread(ThreadData *td, MprThread *tp);
 static cchar    *formatOutput(HttpConn *conn, cchar *buf, ssize *count);
 static void     manageApp(App *app, int flags);
 static void     manageThreadData(ThreadData *data, int flags);
+static void     mergeStats(LoadStats *dest, LoadStats *src);
 static int      parseArgs(int argc, char **argv);
+static uint64   percentile(Histogram *hp, double pct);
 static int      processThread(HttpConn *conn, MprEvent *event);
+static void     recordLatency(Histogram *hp, uint64 value);
 static void     threadMain(void *data, MprThread *tp);
+static void     reportLoad(double elapsed);
 static char     *resolveUrl(HttpConn *conn, cchar *url);
 static int      setContentLength(HttpConn *conn, MprList *files);
 static int      showUsage();
@@ -133,7 +187,10 @@ MAIN(httpMain, int argc, char **argv, char **envp)
     processing();
     mprServiceEvents(-1, 0);
 
-    if (app->benchmark) {
+    if (app->rate > 0) {
+        reportLoad((mprGetTime() - start) / 1000.0);
+
+    } else if (app->benchmark) {
         elapsed = (double) (mprGetTime() - start);
         if (app->fetchCount == 0) {
             elapsed = 0;
@@ -168,6 +225,7 @@ static void manageApp(App *app, int flags)
         mprMark(app->http);
         mprMark(app->inFile);
         mprMark(app->key);
+        mprMark(app->loadStats);
         mprMark(app->outFile);
         mprMark(app->outFilename);
         mprMark(app->mutex);
@@ -191,6 +249,8 @@ static void initSettings()
     app->zeroOnErrors = 0;
 
     app->authType = sclone("basic");
+    app->connections = 64;
+    app->duration = 10;
     app->host = sclone("localhost");
     app->iterations = 1;
     app->loadThreads = 1;
@@ -276,6 +336,17 @@ static int parseArgs(int argc, char **argv)
             }
             ssl = 1;
 
+        } else if (smatch(argp, "--connections")) {
+            if (nextArg >= argc) {
+                return showUsage();
+            } else {
+                app->connections = atoi(argv[++nextArg]);
+                if (app->connections <= 0) {
+                    mprError("Bad connections count %d", app->connections);
+                    return MPR_ERR_BAD_ARGS;
+                }
+            }
+
         } else if (smatch(argp, "--continue") || smatch(argp, "-c")) {
             app->continueOnErrors++;
 
@@ -301,6 +372,17 @@ static int parseArgs(int argc, char **argv)
             app->retries = 0;
             app->timeout = MAXINT;
 
+        } else if (smatch(argp, "--duration")) {
+            if (nextArg >= argc) {
+                return showUsage();
+            } else {
+                app->duration = atoi(argv[++nextArg]);
+                if (app->duration <= 0) {
+                    mprError("Bad duration %d", app->duration);
+                    return MPR_ERR_BAD_ARGS;
+                }
+            }
+
         } else if (smatch(argp, "--delete")) {
             app->method = "DELETE";
 
@@ -352,6 +434,9 @@ static int parseArgs(int argc, char **argv)
                 app->iterations = atoi(argv[++nextArg]);
             }
 
+        } else if (smatch(argp, "--json")) {
+            app->json++;
+
         } else if (smatch(argp, "--key")) {
             if (nextArg >= argc) {
                 return showUsage();
@@ -435,6 +520,17 @@ static int parseArgs(int argc, char **argv)
                 }
             }
 
+        } else if (smatch(argp, "--rate")) {
+            if (nextArg >= argc) {
+                return showUsage();
+            } else {
+                app->rate = atoi(argv[++nextArg]);
+                if (app->rate <= 0) {
+                    mprError("Bad request rate %d", app->rate);
+                    return MPR_ERR_BAD_ARGS;
+                }
+            }
+
         } else if (smatch(argp, "--retries") || smatch(argp, "-r")) {
             if (nextArg >= argc) {
                 return showUsage();
@@ -601,15 +697,18 @@ static int showUsage()
         "  --cert file           # Certificate to send to the server to identify the client.\n"
         "  --chunk size          # Request response data to use this chunk size.\n"
         "  --ciphers cipher,...  # List of suitable ciphers.\n"
+        "  --connections count   # Concurrent requests per thread for --rate (default 64).\n"
         "  --continue            # Continue on errors.\n"
         "  --cookie CookieString # Define a cookie header. Multiple uses okay.\n"
         "  --data bodyData       # Body data to send with PUT or POST.\n"
         "  --debugger            # Disable timeouts to make running in a debugger easier.\n"
         "  --delete              # Use the DELETE method. Shortcut for --method DELETE..\n"
+        "  --duration secs       # Duration of the --rate load test (default 10).\n"
         "  --form string         # Form data. Must already be form-www-urlencoded.\n"
         "  --header 'key: value' # Add a custom request header.\n"
         "  --host hostName       # Host name or IP address for unqualified URLs.\n"
         "  --iterations count    # Number of times to fetch the URLs per thread (default 1).\n"
+        "  --json                # Emit --rate load results as JSON.\n"
         "  --key file            # Private key file.\n"
         "  --log logFile:level   # Log to the file at the verbosity level.\n"
         "  --method KIND         # HTTP request method GET|OPTIONS|POST|PUT|TRACE (default GET).\n"
@@ -622,6 +721,7 @@ static int showUsage()
         "  --protocol PROTO      # Set HTTP protocol to HTTP/1.0 or HTTP/1.1 .\n"
         "  --put                 # Use PUT method. Shortcut for --method PUT.\n"
         "  --range byteRanges    # Request a subset range of the document.\n"
+        "  --rate count          # Open-loop load test. Issue requests at this total rate per second.\n"
         "  --retries count       # Number of times to retry failing requests.\n"
         "  --sequence            # Sequence requests with a custom header.\n"
         "  --showHeaders         # Output response headers.\n"
@@ -649,6 +749,11 @@ static void processing()
     if (app->chunkSize > 0) {
         mprAddItem(app->headers, mprCreateKeyPair("X-Chunk-Size", sfmt("%d", app->chunkSize), 0));
     }
+    if (app->rate > 0) {
+        /* Reuse keep-alive sockets across the requests of the load test */
+        app->loadStats = mprAllocStruct(LoadStats);
+        httpSetClientPool(app->http, app->connections * app->loadThreads, MPR_TICKS_PER_SEC * 60);
+    }
     app->activeLoadThreads = app->loadThreads;
     app->threadData = mprCreateList(app->loadThreads, 0);
 
@@ -673,6 +778,10 @@ static void manageThreadData(ThreadData *data, int flags)
         mprMark(data->url);
         mprMark(data->files);
         mprMark(data->conn);
+        mprMark(data->dispatcher);
+        mprMark(data->batch);
+        mprMark(data->stats);
+        mprMark(data->body);
     }
 }
 
@@ -687,6 +796,10 @@ static void threadMain(void *data, MprThread *tp)
     MprEvent        e;
 
     td = tp->data;
+    if (app->rate > 0) {
+        loadThread(td, tp);
+        return;
+    }
     td->dispatcher = mprCreateDispatcher(tp->name, 0);
     td->conn = conn = httpCreateConn(app->http, NULL, td->dispatcher);
 
@@ -772,6 +885,265 @@ static int processThread(HttpConn *conn, MprEvent *event)
 }
 
 
+static uint64 getMicroseconds()
+{
+#if BIT_UNIX_LIKE && defined(CLOCK_MONOTONIC)
+    struct timespec     ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+    return (uint64) mprGetTicks() * 1000;
+#endif
+}
+
+
+/*
+    Open-loop load generation. Requests are issued at the target rate regardless of how quickly responses arrive and
+    up to app->connections requests per thread are in flight at once. Each request has an intended send time derived
+    from its sequence number. Latency is measured from that time rather than from when the request was actually sent,
+    so a stalled server is charged for the requests it delayed (coordinated omission correction).
+    The thread only sets up the load. Requests are then issued and completed by events on the thread dispatcher.
+ */
+static void loadThread(ThreadData *td, MprThread *tp)
+{
+    td->dispatcher = mprCreateDispatcher(tp->name, 0);
+    td->stats = mprAllocStruct(LoadStats);
+    td->url = resolveUrl(NULL, app->target);
+    if (app->bodyData) {
+        td->body = snclone(mprGetBufStart(app->bodyData), mprGetBufLength(app->bodyData));
+    }
+    td->rate = (double) app->rate / app->loadThreads;
+    td->total = max((int) (td->rate * app->duration), 1);
+    td->batch = httpCreateBatch(td->dispatcher, app->connections);
+    td->batch->data = td;
+    td->start = getMicroseconds();
+    mprCreateTimerEvent(td->dispatcher, "load", 1, issueLoad, td, 0);
+}
+
+
+/*
+    Timer callback to issue all requests whose intended send time has passed. Request N is intended to be sent N / rate
+    seconds after the start. Requests beyond the connection limit wait in the batch queue and retain their intended time.
+ */
+static void issueLoad(ThreadData *td, MprEvent *event)
+{
+    LoadStats   *sp;
+    int         due;
+
+    sp = td->stats;
+    due = (int) ((getMicroseconds() - td->start) * td->rate / 1000000) + 1;
+    due = min(due, td->total);
+    while (sp->issued < due) {
+        httpBatchRequest(td->batch, app->method, td->url, td->body, app->timeout, loadResponse, (void*) (ssize) sp->issued);
+        sp->issued++;
+    }
+    if (sp->issued >= td->total) {
+        mprRemoveEvent(event);
+    }
+}
+
+
+static void loadResponse(HttpBatchRequest *req)
+{
+    ThreadData  *td;
+    LoadStats   *sp;
+    uint64      intended, now;
+    int         seq, status;
+
+    td = req->batch->data;
+    sp = td->stats;
+    seq = (int) (ssize) req->data;
+    intended = td->start + (uint64) (seq * 1000000.0 / td->rate);
+    now = getMicroseconds();
+    status = req->status;
+
+    if (status > 0) {
+        recordLatency(&sp->latency, now > intended ? now - intended : 0);
+        sp->bytes += mprGetBufLength(req->response);
+        if (status < 400) {
+            sp->ok++;
+        } else if (status < 500) {
+            sp->clientErrors++;
+        } else {
+            sp->serverErrors++;
+        }
+    } else if (status == MPR_ERR_TIMEOUT) {
+        sp->timeouts++;
+    } else if (status == MPR_ERR_CANT_CONNECT) {
+        sp->connectErrors++;
+    } else {
+        sp->ioErrors++;
+    }
+    if (++sp->completed >= td->total) {
+        /* Results are merged once per thread rather than locking for each response */
+        mprLock(app->mutex);
+        mergeStats(app->loadStats, sp);
+        mprUnlock(app->mutex);
+        finishThread(mprGetCurrentThread());
+    }
+}
+
+
+static int histIndex(uint64 value)
+{
+    int     msb, shift;
+
+    if (value < HIST_SUB_COUNT) {
+        return (int) value;
+    }
+    value = min(value, ((uint64) 1 << HIST_MAX_BITS) - 1);
+    for (msb = HIST_SUB_BITS; (value >> (msb + 1)) != 0; msb++) { }
+    shift = msb - HIST_SUB_BITS + 1;
+    return HIST_SUB_COUNT + (shift - 1) * HIST_HALF_COUNT + (int) (value >> shift) - HIST_HALF_COUNT;
+}
+
+
+/*
+    Return the highest value that maps to the histogram bucket
+ */
+static uint64 histValue(int index)
+{
+    int     shift;
+
+    if (index < HIST_SUB_COUNT) {
+        return index;
+    }
+    shift = (index - HIST_SUB_COUNT) / HIST_HALF_COUNT + 1;
+    return ((uint64) ((index - HIST_SUB_COUNT) % HIST_HALF_COUNT + HIST_HALF_COUNT + 1) << shift) - 1;
+}
+
+
+static void recordLatency(Histogram *hp, uint64 value)
+{
+    hp->counts[histIndex(value)]++;
+    hp->count++;
+    hp->sum += (double) value;
+    hp->max = max(hp->max, value);
+}
+
+
+static uint64 percentile(Histogram *hp, double pct)
+{
+    uint64  target, sum;
+    int     i;
+
+    if (hp->count == 0) {
+        return 0;
+    }
+    target = max((uint64) (hp->count * pct / 100.0 + 0.5), 1);
+    for (i = 0, sum = 0; i < HIST_SIZE; i++) {
+        if ((sum += hp->counts[i]) >= target) {
+            return min(histValue(i), hp->max);
+        }
+    }
+    return hp->max;
+}
+
+
+static void mergeStats(LoadStats *dest, LoadStats *src)
+{
+    int     i;
+
+    for (i = 0; i < HIST_SIZE; i++) {
+        dest->latency.counts[i] += src->latency.counts[i];
+    }
+    dest->latency.count += src->latency.count;
+    dest->latency.sum += src->latency.sum;
+    dest->latency.max = max(dest->latency.max, src->latency.max);
+    dest->bytes += src->bytes;
+    dest->issued += src->issued;
+    dest->completed += src->completed;
+    dest->ok += src->ok;
+    dest->clientErrors += src->clientErrors;
+    dest->serverErrors += src->serverErrors;
+    dest->timeouts += src->timeouts;
+    dest->connectErrors += src->connectErrors;
+    dest->ioErrors += src->ioErrors;
+}
+
+
+/*
+    Report open-loop load results. Latencies are in milliseconds and elapsed is in seconds.
+ */
+static void reportLoad(double elapsed)
+{
+    LoadStats   *sp;
+    Histogram   *hp;
+    double      mean, p50, p90, p99, p999, p9999, most;
+    int         errors;
+
+    sp = app->loadStats;
+    hp = &sp->latency;
+    elapsed = max(elapsed, 0.001);
+    mean = hp->count ? hp->sum / hp->count / 1000.0 : 0;
+    p50 = percentile(hp, 50) / 1000.0;
+    p90 = percentile(hp, 90) / 1000.0;
+    p99 = percentile(hp, 99) / 1000.0;
+    p999 = percentile(hp, 99.9) / 1000.0;
+    p9999 = percentile(hp, 99.99) / 1000.0;
+    most = hp->max / 1000.0;
+    errors = sp->clientErrors + sp->serverErrors + sp->timeouts + sp->connectErrors + sp->ioErrors;
+    if (errors && !app->continueOnErrors) {
+        app->success = 0;
+    }
+    if (app->json) {
+        mprPrintf("{\n"
+            "    \"target\": %d,\n"
+            "    \"threads\": %d,\n"
+            "    \"connections\": %d,\n"
+            "    \"elapsed\": %.3f,\n"
+            "    \"issued\": %d,\n"
+            "    \"completed\": %d,\n"
+            "    \"throughput\": %.1f,\n"
+            "    \"bytesPerSecond\": %.1f,\n"
+            "    \"latency\": {\n"
+            "        \"mean\": %.3f,\n"
+            "        \"p50\": %.3f,\n"
+            "        \"p90\": %.3f,\n"
+            "        \"p99\": %.3f,\n"
+            "        \"p99.9\": %.3f,\n"
+            "        \"p99.99\": %.3f,\n"
+            "        \"max\": %.3f\n"
+            "    },\n"
+            "    \"errors\": {\n"
+            "        \"4xx\": %d,\n"
+            "        \"5xx\": %d,\n"
+            "        \"timeout\": %d,\n"
+            "        \"connect\": %d,\n"
+            "        \"io\": %d\n"
+            "    }\n"
+            "}\n",
+            app->rate, app->loadThreads, app->connections * app->loadThreads, elapsed, sp->issued, sp->completed,
+            sp->completed / elapsed, sp->bytes / elapsed, mean, p50, p90, p99, p999, p9999, most,
+            sp->clientErrors, sp->serverErrors, sp->timeouts, sp->connectErrors, sp->ioErrors);
+        return;
+    }
+    mprPrintf("\nTarget rate:         %13d req/sec\n", app->rate);
+    mprPrintf("Achieved rate:       %13.1f req/sec\n", sp->completed / elapsed);
+    mprPrintf("Requests issued:     %13d\n", sp->issued);
+    mprPrintf("Requests completed:  %13d\n", sp->completed);
+    mprPrintf("Time elapsed:        %13.4f sec\n", elapsed);
+    mprPrintf("Transfer rate:       %13.1f KB/sec\n", sp->bytes / elapsed / 1024);
+    mprPrintf("Load threads:        %13d\n", app->loadThreads);
+    mprPrintf("Connections:         %13d\n", app->connections * app->loadThreads);
+    mprPrintf("\nLatency (msec, corrected for coordinated omission)\n");
+    mprPrintf("  Mean:              %13.3f\n", mean);
+    mprPrintf("  50%%:               %13.3f\n", p50);
+    mprPrintf("  90%%:               %13.3f\n", p90);
+    mprPrintf("  99%%:               %13.3f\n", p99);
+    mprPrintf("  99.9%%:             %13.3f\n", p999);
+    mprPrintf("  99.99%%:            %13.3f\n", p9999);
+    mprPrintf("  Max:               %13.3f\n", most);
+    mprPrintf("\nErrors:              %13d\n", errors);
+    mprPrintf("  4xx responses:     %13d\n", sp->clientErrors);
+    mprPrintf("  5xx responses:     %13d\n", sp->serverErrors);
+    mprPrintf("  Timeouts:          %13d\n", sp->timeouts);
+    mprPrintf("  Connect errors:    %13d\n", sp->connectErrors);
+    mprPrintf("  I/O errors:        %13d\n", sp->ioErrors);
+}
+
+
 static int prepRequest(HttpConn *conn, MprList *files, int retry)
 {
     MprKeyValue     *header;
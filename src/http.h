@@ -20,6 +20,7 @@ extern "C" {
 #if !DOXYGEN
 struct Http;
 struct HttpAuth;
+struct HttpBatchRequest;
 struct HttpConn;
 struct HttpEndpoint;
 struct HttpHost;
@@ -113,6 +114,9 @@ struct HttpWebSocket;
 #ifndef BIT_MAX_ROUTE_MAP_HASH
     #define BIT_MAX_ROUTE_MAP_HASH  17                  /**< Size of the route mapping hash */
 #endif
+#ifndef BIT_MAX_STREAMS
+    #define BIT_MAX_STREAMS         100                 /**< Maximum concurrent HTTP/2 streams per connection */
+#endif
 #ifndef BIT_MAX_SESSIONS
     #define BIT_MAX_SESSIONS        100                 /**< Maximum concurrent sessions */
 #endif
@@ -122,6 +126,9 @@ struct HttpWebSocket;
 #ifndef BIT_MAX_SESSION_HASH
     #define BIT_MAX_SESSION_HASH    31                  /**< Hash table for session data */
 #endif
+#ifndef BIT_MAX_SESSION_SHARDS
+    #define BIT_MAX_SESSION_SHARDS  16                  /**< Lock stripes for the in-memory session store */
+#endif
 #ifndef BIT_MAX_TX_BODY
     #define BIT_MAX_TX_BODY         (INT_MAX)           /**< Maximum buffer for response data */
 #endif
@@ -169,6 +176,9 @@ struct HttpWebSocket;
 
 #define HTTP_RETRIES                3                   /**< Default number of retries for client requests */
 #define HTTP_DATE_FORMAT            "%a, %d %b %Y %T GMT"
+#define HTTP_AUTH_CACHE_MAX         1024                /**< Maximum verified credentials in the auth cache */
+#define HTTP_AUTH_CACHE_TTL         (30 * 1000)         /**< Time verified credentials are retained (msec) */
+#define HTTP_DNS_MAX_HOSTS          1024                /**< Maximum hosts in the resolver cache */
 #define HTTP_MAX_SECRET             16                  /**< Size of secret data for auth */
 #define HTTP_MAX_WSS_MESSAGE        (2147483647)        /**< Default max WebSockets message size (2GB) */
 #define HTTP_SMALL_HASH_SIZE        31                  /* Small hash (less than the alphabet) */
@@ -466,8 +476,9 @@ typedef struct Http {
     MprList         *hosts;                 /**< List of host objects */
     MprList         *connections;           /**< Currently open connection requests */
     MprHash         *stages;                /**< Possible stages in connection pipelines */
-    MprCache        *sessionCache;          /**< Session state cache */
+    struct HttpSessionStore *sessionStore;  /**< Session state store */
     MprHash         *statusCodes;           /**< Http status codes */
+    MprHash         *atoms;                 /**< Interned strings. See httpAddAtom */
 
     MprHash         *routeTargets;          /**< Http route target functions */
     MprHash         *routeConditions;       /**< Http route condition functions */
@@ -476,6 +487,12 @@ typedef struct Http {
     MprHash         *authTypes;             /**< Available authentication protocol types */
     MprHash         *authStores;            /**< Available password stores */
     MprHash         *dateCache;             /**< Cache of date modified times */
+    struct HttpVariants *variants;          /**< Cache of compressed static file variants */
+    struct HttpFileCache *fileCache;        /**< Cache of static file path info and open files */
+    struct HttpClientPool *clientPool;      /**< Pool of idle client keep-alive connections */
+    struct HttpDnsCache *dnsCache;          /**< Resolver cache for client connections */
+    struct HttpAuthCache *authCache;        /**< Cache of verified credentials */
+    struct HttpDigest *digest;              /**< Digest authentication nonce state */
 
     MprList         *counters;              /**< List of counters */
     MprList         *monitors;              /**< List of monitors */
@@ -490,6 +507,7 @@ typedef struct Http {
     struct HttpStage *cacheFilter;          /**< Cache filter */
     struct HttpStage *cacheHandler;         /**< Cache filter */
     struct HttpStage *chunkFilter;          /**< Chunked transfer encoding filter */
+    struct HttpStage *compressFilter;       /**< Response content compression filter */
     struct HttpStage *cgiHandler;           /**< CGI handler */
     struct HttpStage *cgiConnector;         /**< CGI connector */
     struct HttpStage *clientHandler;        /**< Client-side handler (dummy) */
@@ -498,6 +516,7 @@ typedef struct Http {
     struct HttpStage *ejsHandler;           /**< Ejscript Web Framework handler */
     struct HttpStage *espHandler;           /**< ESP Web Framework handler */
     struct HttpStage *fileHandler;          /**< Static file handler */
+    struct HttpStage *http2Connector;       /**< HTTP/2 stream connector */
     struct HttpStage *netConnector;         /**< Default network connector */
     struct HttpStage *passHandler;          /**< Pass through handler */
     struct HttpStage *phpHandler;           /**< PHP through handler */
@@ -688,6 +707,228 @@ PUBLIC struct HttpEndpoint *httpLookupEndpoint(Http *http, cchar *ip, int port);
  */
 PUBLIC void httpSetSoftware(Http *http, cchar *description);
 
+/**
+    Compressed static file variant cache
+    @description Compressible static files are compressed on a worker thread on first request and the result is
+        stored in the cache directory. Later requests from clients that accept gzip are served the compressed
+        variant via the send connector. Variants are keyed by the file device, inode and encoding. The source size and
+        modification time are kept with the variant so modified files are compressed again and the old variant is
+        removed. The total size of variants is bounded and the least recently used variants are evicted. Variants
+        left in the directory by a prior run are reused and counted against the bound. The file of a variant that is
+        evicted while requests are sending it is removed when the last request completes.
+    @ingroup Http
+    @stability Prototype
+ */
+typedef struct HttpVariants {
+    char            *dir;                   /**< Directory for variant files */
+    MprHash         *items;                 /**< Variants keyed by device, inode and encoding */
+    MprOff          size;                   /**< Total size of ready variants */
+    MprOff          maxSize;                /**< Maximum total size of variants */
+    int             pending;                /**< Compression jobs in progress */
+    MprMutex        *mutex;                 /**< Multithread sync */
+} HttpVariants;
+
+/**
+    Enable the compressed variant cache for static files
+    @description Variants are created for routes that enable dynamic compression via
+        #httpSetRouteDynamicCompression and use the route compression level and minimum size. 
+        Files larger than a quarter of the maximum cache size are not cached.
+    @param http Http object created via #httpCreate
+    @param dir Directory to store compressed variants. Set to NULL to disable the cache.
+    @param maxSize Maximum total size in bytes of stored variants.
+    @return Zero if successful, otherwise a negative MPR error code.
+    @ingroup Http
+    @stability Prototype
+ */
+PUBLIC int httpSetCompressCache(Http *http, cchar *dir, MprOff maxSize);
+
+/**
+    Static file cache
+    @description Caches path information, ETags and open files for static content to minimize per-request
+        system calls. Entries are revalidated after a period by testing the file inode, size and modification time.
+    @ingroup Http
+    @stability Prototype
+ */
+typedef struct HttpFileCache {
+    MprHash         *files;                 /**< Cached files keyed by filename */
+    MprTicks        revalidate;             /**< Period after which cached path info is tested for changes */
+    int             maxFiles;               /**< Maximum number of cached files */
+    ssize           maxFileSize;            /**< Maximum size of a file to hold in memory */
+    MprOff          maxMemory;              /**< Maximum total memory for file content */
+    MprOff          memory;                 /**< Current memory used for file content */
+    uint64          hits;                   /**< Path lookups answered without a stat */
+    uint64          misses;                 /**< Path lookups requiring a stat */
+    uint64          contentHits;            /**< Small files sent from memory */
+    uint64          contentMisses;          /**< Small files that had to be read into memory */
+    MprMutex        *mutex;                 /**< Multithread sync */
+} HttpFileCache;
+
+/**
+    Enable the static file cache
+    @description Path information, ETags and open file descriptors for static files are cached. Open files are
+        shared by concurrent requests using the send connector. Modifications to a file are detected when the
+        entry is next used after the revalidation period has expired.
+    @param http Http object created via #httpCreate
+    @param maxFiles Maximum number of files to cache. Set to zero to disable the cache.
+    @param revalidate Period in milliseconds after which a cached file is tested for modification.
+        Set to zero to test on every request while still sharing open files.
+    @return Zero if successful, otherwise a negative MPR error code.
+    @ingroup Http
+    @stability Prototype
+ */
+PUBLIC int httpSetFileCache(Http *http, int maxFiles, MprTicks revalidate);
+
+/**
+    Enable in-memory caching of small static files
+    @description The content of files up to the given size is held in memory by the static file cache. The send
+        connector transmits the response headers and content in a single vectored write without file system access.
+        The file cache must first be enabled via #httpSetFileCache. When the memory limit is exceeded, the content
+        of the least recently used files is discarded.
+    @param http Http object created via #httpCreate
+    @param maxFileSize Maximum size of a file to hold in memory. Set to zero to disable.
+    @param maxMemory Maximum total memory to use for file content.
+    @return Zero if successful, otherwise a negative MPR error code.
+    @ingroup Http
+    @stability Prototype
+ */
+PUBLIC int httpSetFileCacheContent(Http *http, ssize maxFileSize, MprOff maxMemory);
+
+/**
+    Client connection pool
+    @description Idle keep-alive client sockets are retained in a process-wide pool when a client connection is
+        destroyed or retargeted. Sockets are keyed by scheme, host, port and SSL configuration so that #httpConnect
+        transparently reuses a warm socket to the same server.
+    @ingroup Http
+    @stability Prototype
+ */
+typedef struct HttpClientPool {
+    MprHash         *hosts;                 /**< Lists of idle sockets keyed by scheme, host, port and SSL config */
+    struct MprSsl   *ssl;                   /**< Default SSL configuration for secure pooled connections */
+    MprTicks        idleTimeout;            /**< Time an idle socket may remain in the pool */
+    int             maxPerHost;             /**< Maximum idle sockets per host */
+    int             count;                  /**< Current idle sockets in the pool */
+    uint64          hits;                   /**< Connections that reused a pooled socket */
+    uint64          misses;                 /**< Connections that required a new socket */
+    MprMutex        *mutex;                 /**< Multithread sync */
+} HttpClientPool;
+
+/**
+    Enable the client connection pool
+    @description When enabled, keep-alive sockets from completed client requests are returned to the pool rather
+        than being closed. A pooled socket is tested on checkout and discarded if the peer has closed the connection
+        or sent unexpected data. Sockets idle for longer than the idle timeout are closed.
+    @param http Http object created via #httpCreate
+    @param maxPerHost Maximum number of idle sockets to retain for each host. Set to zero to disable the pool.
+    @param idleTimeout Time in milliseconds an idle socket may remain in the pool.
+    @return Zero if successful, otherwise a negative MPR error code.
+    @ingroup Http
+    @stability Prototype
+ */
+PUBLIC int httpSetClientPool(Http *http, int maxPerHost, MprTicks idleTimeout);
+
+/**
+    Client resolver cache
+    @description Caches host name resolutions for outbound client connections so new connections do not block in the
+        system resolver. Failed lookups are cached for a shorter period. Entries are refreshed on a worker thread
+        before they expire and hosts with multiple addresses are used in round-robin order.
+    @ingroup Http
+    @stability Prototype
+ */
+typedef struct HttpDnsCache {
+    MprHash         *hosts;                 /**< Cache entries keyed by host name */
+    MprTicks        ttl;                    /**< Time resolved addresses are retained */
+    MprTicks        negativeTtl;            /**< Time failed lookups are retained */
+    int             maxHosts;               /**< Maximum number of cached hosts */
+    uint64          hits;                   /**< Lookups answered from the cache */
+    uint64          negativeHits;           /**< Lookups answered by a cached failure */
+    uint64          misses;                 /**< Lookups requiring a blocking resolution */
+    uint64          refreshes;              /**< Background refreshes */
+    uint64          lookups;                /**< Calls to the system resolver */
+    MprTicks        lookupTime;             /**< Total time in the system resolver */
+    MprTicks        maxLookupTime;          /**< Longest system resolver call */
+    MprMutex        *mutex;                 /**< Multithread sync */
+} HttpDnsCache;
+
+/**
+    Enable the client resolver cache
+    @param http Http object created via #httpCreate
+    @param ttl Time in milliseconds to retain resolved addresses. Set to zero to disable the cache.
+    @param negativeTtl Time in milliseconds to retain failed lookups.
+    @return Zero if successful, otherwise a negative MPR error code.
+    @ingroup Http
+    @stability Prototype
+ */
+PUBLIC int httpSetDnsCache(Http *http, MprTicks ttl, MprTicks negativeTtl);
+
+/**
+    Preload the client resolver cache
+    @description Load entries from a hosts-style file. Each line contains a numeric address followed by one or more
+        host names. Text following "#" is ignored. Preloaded entries do not expire. This is useful for tests.
+        The resolver cache must first be enabled via #httpSetDnsCache.
+    @param http Http object created via #httpCreate
+    @param path Hosts file path
+    @return The number of host names loaded, otherwise a negative MPR error code.
+    @ingroup Http
+    @stability Prototype
+ */
+PUBLIC int httpLoadDnsHosts(Http *http, cchar *path);
+
+/**
+    Resolve a host name for a client connection
+    @description Uses the resolver cache if enabled. Multiple addresses for a host are returned in round-robin order.
+    @param http Http object created via #httpCreate
+    @param host Host name or numeric address
+    @return A numeric address or the host unchanged if the cache is disabled or the host is numeric. 
+        Returns NULL if the host cannot be resolved.
+    @ingroup Http
+    @stability Prototype
+ */
+PUBLIC cchar *httpResolveHost(Http *http, cchar *host);
+
+/**
+    Add an atom
+    @description Atoms are permanent interned strings. Equal atoms are the same pointer and may be compared by pointer.
+        Common method names, header names, extensions and MIME types are defined when the Http service is created.
+        Atoms must be added before requests are serviced.
+    @param str String to intern
+    @return The atom for the string
+    @ingroup Http
+    @stability Prototype
+ */
+PUBLIC cchar *httpAddAtom(cchar *str);
+
+/**
+    Lookup an atom
+    @param str String to lookup. The match is exact including case.
+    @return The atom for the string or NULL if the string is not an atom.
+    @ingroup Http
+    @stability Prototype
+ */
+PUBLIC cchar *httpLookupAtom(cchar *str);
+
+/**
+    Intern a string
+    @description Return the atom for the string if one is defined. Otherwise return an allocated copy of the string.
+        The result must not be modified.
+    @param str String to intern
+    @return An atom or a copy of the string
+    @ingroup Http
+    @stability Prototype
+ */
+PUBLIC cchar *httpIntern(cchar *str);
+
+/**
+    Intern a block of characters
+    @description Return the atom for the block if one is defined. Otherwise return an allocated string copy of the
+        block. The result must not be modified.
+    @param str Characters to intern. Need not be null terminated.
+    @param len Number of characters in the block
+    @return An atom or a copy of the block
+    @ingroup Http
+    @stability Prototype
+ */
+PUBLIC cchar *httpInternBlock(cchar *str, ssize len);
+
 /* Internal APIs */
 PUBLIC void httpAddConn(Http *http, struct HttpConn *conn);
 PUBLIC struct HttpEndpoint *httpGetFirstEndpoint(Http *http);
@@ -697,6 +938,9 @@ PUBLIC void httpRemoveEndpoint(Http *http, struct HttpEndpoint *endpoint);
 PUBLIC void httpAddHost(Http *http, struct HttpHost *host);
 PUBLIC void httpRemoveHost(Http *http, struct HttpHost *host);
 PUBLIC void httpDefineRouteBuiltins();
+PUBLIC void httpInitAtoms(Http *http);
+PUBLIC int httpPruneClientPool(Http *http);
+PUBLIC bool httpReturnClientSocket(struct HttpConn *conn);
 
 /*********************************** HttpStats ********************************/
 /** 
@@ -729,6 +973,25 @@ typedef struct HttpStats {
     uint64  totalRequests;              /**< Total requests served */
     uint64  totalConnections;           /**< Total connections accepted */
 
+    uint64  fileCacheHits;              /**< Static file cache lookups not requiring a stat */
+    uint64  fileCacheMisses;            /**< Static file cache lookups requiring a stat */
+    uint64  fileContentHits;            /**< Small static files sent from memory */
+    uint64  fileContentMisses;          /**< Small static files read into memory */
+    uint64  fileContentMemory;          /**< Memory used for small static file content */
+    int     fileCacheFiles;             /**< Current files in the static file cache */
+
+    uint64  dnsHits;                    /**< Client resolver cache hits including cached failures */
+    uint64  dnsMisses;                  /**< Client resolver cache misses */
+    uint64  dnsLookups;                 /**< Calls to the system resolver */
+    uint64  dnsLookupTime;              /**< Total time in the system resolver in milliseconds */
+    uint64  dnsMaxLookupTime;           /**< Longest system resolver call in milliseconds */
+
+    uint64  authHits;                   /**< Logins verified from the auth cache */
+    uint64  authMisses;                 /**< Logins verified by the auth store */
+    uint64  authVerifyTime;             /**< Total time in auth store verification in microseconds */
+    uint64  authSavedTime;              /**< Verification time saved by auth cache hits in microseconds */
+    int     authCacheEntries;           /**< Current verified credentials in the auth cache */
+
     int     regions;                    /**< Current memory region count */
     int     cpus;
 } HttpStats;
@@ -777,6 +1040,7 @@ typedef struct HttpLimits {
     int      requestsPerClientMax;      /**< Maximum number of requests per client IP */
     int      processMax;                /**< Maximum number of processes (CGI) */
     int      sessionMax;                /**< Maximum number of sessions */
+    int      streamsMax;                /**< Maximum number of concurrent HTTP/2 streams per connection. Zero disables HTTP/2 */
 
     MprTicks inactivityTimeout;         /**< Timeout for keep-alive and idle requests (msec) */
     MprTicks requestParseTimeout;       /**< Time a request can take to parse the request headers (msec) */
@@ -2086,6 +2350,9 @@ PUBLIC ssize httpFilterChunkData(HttpQueue *q, HttpPacket *packet);
 PUBLIC int httpOpenActionHandler(Http *http);
 PUBLIC int httpOpenChunkFilter(Http *http);
 PUBLIC int httpOpenCacheHandler(Http *http);
+PUBLIC int httpOpenCompressFilter(Http *http);
+PUBLIC bool httpIsCompressibleMime(cchar *mimeType);
+PUBLIC int httpOpenHttp2Connector(Http *http);
 PUBLIC int httpOpenPassHandler(Http *http);
 PUBLIC int httpOpenRangeFilter(Http *http);
 PUBLIC int httpOpenNetConnector(Http *http);
@@ -2308,6 +2575,17 @@ typedef struct HttpConn {
     HttpHeadersCallback headersCallback;    /**< Callback to fill headers */
     void            *headersCallbackArg;    /**< Arg to fillHeaders */
 
+    /*
+        HTTP/2. A network connection owns the socket and the protocol state (h2). Each request stream is a separate
+        HttpConn that references the network connection (net).
+     */
+    struct HttpConn *net;                   /**< Network connection owning the socket (HTTP/2 streams only) */
+    struct HttpH2   *h2;                    /**< HTTP/2 protocol state (HTTP/2 network connections only) */
+    int             streamId;               /**< HTTP/2 stream identifier */
+    int             streamFlags;            /**< HTTP/2 stream state flags */
+    ssize           streamWindow;           /**< HTTP/2 stream flow control window for sending */
+    ssize           streamCredit;           /**< HTTP/2 stream received bytes not yet returned to the peer */
+
     uint64          startMark;              /**< High resolution tick time of request */
 } HttpConn;
 
@@ -2953,8 +3231,30 @@ typedef struct HttpAuthType {
 typedef struct HttpAuthStore {
     char            *name;          /**< Authentication password store name: 'system', 'file' */
     HttpVerifyUser  verifyUser;
+    bool            cacheable;      /**< Successful verifications may be retained in the auth cache */
 } HttpAuthStore;
 
+/**
+    Verified credential cache
+    @description Retains successful password verifications for a short period so clients that send credentials with
+        every request do not repeat an expensive verification such as a PAM conversation. Entries are keyed by a
+        keyed hash of the store, user set, realm, username and password so passwords are not retained. The cache
+        is flushed when users or roles are added or removed. Only stores enabled via #httpSetAuthStoreCache are cached.
+    @ingroup HttpAuth
+    @stability Prototype
+ */
+typedef struct HttpAuthCache {
+    MprHash         *entries;               /**< Verified credentials keyed by keyed hash */
+    MprTicks        ttl;                    /**< Time verified credentials are retained */
+    int             maxEntries;             /**< Maximum number of cached credentials */
+    int             generation;             /**< Incremented when the cache is flushed */
+    uint64          hits;                   /**< Logins verified from the cache */
+    uint64          misses;                 /**< Logins verified by the auth store */
+    uint64          verifyTime;             /**< Total time in auth store verification in microseconds */
+    uint64          savedTime;              /**< Verification time saved by cache hits in microseconds */
+    MprMutex        *mutex;                 /**< Multithread sync */
+} HttpAuthCache;
+
 /** 
     User Authorization. A user has a name, password and a set of roles. These roles define a set of abilities.
     @see HttpAuth
@@ -3048,6 +3348,41 @@ PUBLIC int httpAddAuthStore(cchar *name, HttpVerifyUser verifyUser);
   */
 PUBLIC int httpSetAuthStoreVerify(cchar *name, HttpVerifyUser verifyUser);
 
+/**
+    Enable caching of verified credentials for an authentication store
+    @description Successful verifications by the store are retained in the auth cache. Only enable this for stores
+        whose verification callback has no side effects other than locating the user in the route user cache.
+    @param name Name of the authentication store
+    @param enable Set to true to cache verified credentials
+    @return Zero if successful, otherwise a negative MPR error code
+    @ingroup HttpAuth
+    @stability Prototype
+  */
+PUBLIC int httpSetAuthStoreCache(cchar *name, bool enable);
+
+/**
+    Configure the verified credential cache
+    @description The cache is enabled by default with a lifespan of HTTP_AUTH_CACHE_TTL.
+    @param http Http object created via #httpCreate
+    @param ttl Time in milliseconds to retain verified credentials. Set to zero to disable the cache.
+    @param maxEntries Maximum number of cached credentials. Set to zero for the default.
+    @return Zero if successful, otherwise a negative MPR error code.
+    @ingroup HttpAuth
+    @stability Prototype
+ */
+PUBLIC int httpSetAuthCache(Http *http, MprTicks ttl, int maxEntries);
+
+/**
+    Flush the verified credential cache
+    @description Verified credentials are tied to the user object, so removing or replacing a user invalidates only
+        that user's entries. Call this if passwords are changed by other means, for example by modifying a user
+        object or in the system password database.
+    @param http Http object created via #httpCreate
+    @ingroup HttpAuth
+    @stability Prototype
+ */
+PUBLIC void httpFlushAuthCache(Http *http);
+
 /**
     Add a role
     @description This creates the role with given abilities. Ability words can also be other roles.
@@ -3481,6 +3816,106 @@ PUBLIC ssize httpUpdateCache(HttpConn *conn, cchar *uri, cchar *data, MprTicks l
   */
 PUBLIC ssize httpWriteCached(HttpConn *conn);
 
+/**
+    Persistent response store
+    @description The persistent store holds cached responses in a memory mapped data file so cached content survives
+        server restarts. Records are appended to the data file and a fixed size entry for each record is appended to
+        a companion index file. The store is loaded by reading the index. Records and index entries are checksummed
+        so records that were partially written when the server stopped are ignored.
+    @see httpOpenResponseStore httpSetPersistentCache
+    @ingroup HttpCache
+    @stability Internal
+ */
+typedef struct HttpResponseStore {
+    char            *path;                  /**< Data file path. The index file path has a ".index" extension */
+    void            *data;                  /**< Current data file mapping */
+    MprHash         *index;                 /**< Location of the live records by cache key */
+    MprMutex        *mutex;                 /**< Multithread sync */
+    MprOff          maxSize;                /**< Maximum size of the data file */
+    MprOff          liveSize;               /**< Size of the live records */
+} HttpResponseStore;
+
+/**
+    Response retrieved from a persistent response store
+    @description The body is not copied. It refers to the mapped data file which is retained while the response
+        is referenced. The body may also be sent from the data file via sendfile.
+    @ingroup HttpCache
+    @stability Internal
+ */
+typedef struct HttpCachedResponse {
+    void            *data;                  /**< Data file mapping holding the response */
+    MprFile         *file;                  /**< Data file to send the body from */
+    char            *headers;               /**< Cached response headers terminated by a blank line. May be empty */
+    cchar           *body;                  /**< Response body in the mapped data file */
+    MprOff          pos;                    /**< Offset of the body in the data file */
+    ssize           length;                 /**< Length of the body */
+    MprTime         modified;               /**< Time the response was cached */
+} HttpCachedResponse;
+
+/**
+    Open a persistent response store
+    @description Open the data and index files for the store, creating them if required. Existing records that have
+        not expired are loaded from the index. If the files are missing, damaged or from different generations of the
+        store, a new empty store is created.
+    @param path Path to the data file. The index file is created with a ".index" extension.
+    @param maxSize Maximum size of the data file. The file is compacted when full.
+    @return The response store object or null if the store cannot be created.
+    @ingroup HttpCache
+    @stability Internal
+ */
+PUBLIC HttpResponseStore *httpOpenResponseStore(cchar *path, MprOff maxSize);
+
+/**
+    Read a response from a persistent response store
+    @param store Store object created via #httpOpenResponseStore
+    @param key Cache key
+    @return The cached response or null if there is no current response for the key. The content of a record is
+        verified against its checksum when it is first read.
+    @ingroup HttpCache
+    @stability Internal
+ */
+PUBLIC HttpCachedResponse *httpReadResponseStore(HttpResponseStore *store, cchar *key);
+
+/**
+    Remove a response from a persistent response store
+    @param store Store object created via #httpOpenResponseStore
+    @param key Cache key
+    @return True if the response was removed
+    @ingroup HttpCache
+    @stability Internal
+ */
+PUBLIC bool httpRemoveResponseStore(HttpResponseStore *store, cchar *key);
+
+/**
+    Write a response to a persistent response store
+    @param store Store object created via #httpOpenResponseStore
+    @param key Cache key
+    @param content Response content. Headers may precede the body and are separated from it by a blank line.
+    @param len Length of the content
+    @param modified Time the response was created
+    @param lifespan Lifespan of the response in milliseconds. The expiry time is recorded in the store so the
+        lifespan is honored if the store is reopened.
+    @return Zero if successful. Returns MPR_ERR_WONT_FIT if the store is full of current responses.
+    @ingroup HttpCache
+    @stability Internal
+ */
+PUBLIC int httpWriteResponseStore(HttpResponseStore *store, cchar *key, cchar *content, ssize len, MprTime modified,
+    MprTicks lifespan);
+
+/**
+    Store cached responses for a host persistently
+    @description Server-side cached responses are held in a persistent response store instead of the in-memory
+        response cache. The cached responses are available after the server restarts. Cached response bodies are sent
+        from the mapped data file and may be transmitted via sendfile.
+    @param host Host object
+    @param path Path to the store data file
+    @param maxSize Maximum size of the data file
+    @return Zero if successful.
+    @ingroup HttpCache
+    @stability Evolving
+ */
+PUBLIC int httpSetPersistentCache(struct HttpHost *host, cchar *path, MprOff maxSize);
+
 /******************************** Action Handler *************************************/
 /**
     Action handler callback signature
@@ -3560,8 +3995,8 @@ PUBLIC void httpSetStreaming(struct HttpHost *host, cchar *mime, cchar *uri, boo
         httpDefineRouteCondition httpDefineRouteTarget httpDefineRouteUpdate httpFinalizeRoute httpGetRouteData 
         httpGetRouteDir httpLink httpLookupRouteErrorDocument httpMakePath httpResetRoutePipeline 
         httpSetRouteAuth httpSetRouteAutoDelete httpSetRouteCompression httpSetRouteConnector httpSetRouteData 
-        httpSetRouteDefaultLanguage httpSetRouteDocuments httpSetRouteFlags httpSetRouteHandler httpSetRouteHost 
-        httpSetRouteIndex httpSetRouteMethods httpSetRouteName httpSetRouteVar httpSetRoutePattern 
+        httpSetRouteDefaultLanguage httpSetRouteDocuments httpSetRouteDynamicCompression httpSetRouteFlags 
+        httpSetRouteHandler httpSetRouteHost httpSetRouteIndex httpSetRouteMethods httpSetRouteName httpSetRouteVar httpSetRoutePattern 
         httpSetRoutePrefix httpSetRouteScript httpSetRouteSource httpSetRouteTarget httpSetRouteWorkers httpTemplate 
         httpSetTrace httpSetTraceFilter httpTokenize httpTokenizev 
     @stability Internal
@@ -3602,6 +4037,8 @@ typedef struct HttpRoute {
     MprList         *handlers;              /**< List of handlers for this route */
     HttpStage       *connector;             /**< Network connector to use */
     MprHash         *map;                   /**< Map of alternate extensions (gzip|minified) */
+    int             compressLevel;          /**< Dynamic compression level (1-9). Zero disables compression */
+    ssize           compressMin;            /**< Minimum response size to dynamically compress */
     MprHash         *mappings;              /**< Runtime filename mappings */
     MprHash         *data;                  /**< Hash of extra data configuration */
     MprHash         *vars;                  /**< Route variables. Used to expand Path ${token} refrerences */
@@ -3640,6 +4077,7 @@ typedef struct HttpRoute {
     int             workers;                /**< Number of workers to use for this route */
 
     MprHash         *methods;               /**< Matching HTTP methods */
+    int             methodMask;             /**< Matching HTTP methods as rx method flags */
     MprList         *params;                /**< Matching param field data */
     MprList         *requestHeaders;        /**< Required request header values */
     MprList         *conditions;            /**< Route conditions */
@@ -4311,6 +4749,13 @@ PUBLIC char *httpMakePath(HttpRoute *route, cchar *dir, cchar *path);
  */
 PUBLIC void httpMapFile(HttpConn *conn, HttpRoute *route);
 
+/* Internal */
+PUBLIC int httpGetCachedPathInfo(HttpConn *conn, cchar *path, MprPath *info, cchar **etag);
+PUBLIC void httpMapCompressedVariant(HttpConn *conn, HttpRoute *route);
+PUBLIC void httpReleaseCompressedVariant(struct HttpTx *tx);
+PUBLIC char *httpGetCachedFileData(HttpConn *conn, cchar *path);
+PUBLIC MprFile *httpOpenCachedFile(HttpConn *conn, cchar *path);
+
 /**
     Remove HTTP methods for the route
     @description This removes supported HTTP methods from this route
@@ -4419,6 +4864,21 @@ PUBLIC void httpSetRouteDefaultLanguage(HttpRoute *route, cchar *language);
  */
 PUBLIC void httpSetRouteDocuments(HttpRoute *route, cchar *path);
 
+/**
+    Control dynamic content compression for the route
+    @description This enables the compressFilter to compress responses using the gzip or deflate content encodings
+        as they are generated. The encoding is negotiated with the client via the Accept-Encoding header and the
+        response is marked with a "Vary: Accept-Encoding" header. Content types that are already compressed
+        (images, audio, video and archives) and responses smaller than the minimum size are not compressed.
+        Compression is disabled by default. This is independent of serving pre-compressed "gz" files.
+    @param route Route to modify
+    @param level Compression level from 1 (fastest) to 9 (smallest). Set to zero to disable compression.
+    @param minSize Minimum response size in bytes to compress. Smaller responses are sent without compression.
+    @ingroup HttpRoute
+    @stability Prototype
+ */
+PUBLIC void httpSetRouteDynamicCompression(HttpRoute *route, int level, ssize minSize);
+
 #if DEPRECATED || 1
 PUBLIC void httpSetRouteDir(HttpRoute *route, cchar *path);
 #endif
@@ -4831,11 +5291,117 @@ PUBLIC char *httpExpandUri(HttpConn *conn, cchar *str);
  */
 typedef struct HttpSession {
     char            *id;                        /**< Session ID key */
-    MprCache        *cache;                     /**< Cache store reference */
+    struct HttpSessionStore *store;             /**< Session store reference */
     MprTicks        lifespan;                   /**< Session inactivity timeout (msecs) */
     MprHash         *data;                      /**< Session data */
+    MprHash         *changes;                   /**< Keys modified or removed since the session was read */
+    int64           version;                    /**< Store version of the session data */
+    int             dirty;                      /**< Session data modified and must be written */
+    int             shared;                     /**< Session data is shared with the store and must be copied to modify */
 } HttpSession;
 
+/**
+    Read a session from a session store
+    @param store Session store
+    @param id Session ID
+    @param version Set to the version of the session data
+    @return The session data. This may be shared with the store and other requests and must not be modified.
+        Returns null if the session does not exist or has expired.
+    @ingroup HttpSession
+    @stability Prototype
+ */
+typedef MprHash *(*HttpSessionRead)(struct HttpSessionStore *store, cchar *id, int64 *version);
+
+/**
+    Write a session to a session store
+    @description The write is a compare and set. It only succeeds if the stored version of the session is the
+        version that was read. This detects concurrent requests for the one session writing over each other.
+    @param store Session store
+    @param id Session ID
+    @param data Session data. The store may retain a reference, so the data must not be modified after writing.
+    @param lifespan Session inactivity timeout
+    @param version On entry, the version returned when the session was read or zero for a new session.
+        Set to the new version of the session data if successful.
+    @return Zero if successful, otherwise a negative MPR error code. Returns MPR_ERR_BAD_STATE if the session has
+        been written with another version since it was read.
+    @ingroup HttpSession
+    @stability Prototype
+ */
+typedef int (*HttpSessionWrite)(struct HttpSessionStore *store, cchar *id, MprHash *data, MprTicks lifespan,
+    int64 *version);
+
+/**
+    Remove a session from a session store
+    @param store Session store
+    @param id Session ID
+    @ingroup HttpSession
+    @stability Prototype
+ */
+typedef void (*HttpSessionRemove)(struct HttpSessionStore *store, cchar *id);
+
+/**
+    Count the sessions in a session store
+    @param store Session store
+    @return The number of sessions. Expired sessions may be included until they are pruned.
+    @ingroup HttpSession
+    @stability Prototype
+ */
+typedef int (*HttpSessionCount)(struct HttpSessionStore *store);
+
+/**
+    Session store backend.
+    @description Session stores hold session data between requests. The "memory" store keeps decoded session
+        objects in lock striped tables. The "shared" store keeps encoded sessions in a shared memory segment so
+        that several server processes on one host can share sessions.
+    @ingroup HttpSession
+    @stability Prototype
+ */
+typedef struct HttpSessionStore {
+    char                *name;                  /**< Store name: "memory" or "shared" */
+    HttpSessionRead     read;                   /**< Read session callback */
+    HttpSessionWrite    write;                  /**< Write session callback */
+    HttpSessionRemove   remove;                 /**< Remove session callback */
+    HttpSessionCount    count;                  /**< Count sessions callback */
+    void                *data;                  /**< Backend state. Must be a managed reference */
+} HttpSessionStore;
+
+/**
+    Create an in-memory session store
+    @description Session data is retained as decoded objects which are shared by requests for the session until
+        modified. Sessions are divided over a number of lock stripes so requests for different sessions rarely
+        contend. Each write increments the session version and fails if the session was written since it was read.
+    @param shards Number of lock stripes. Set to zero for the default.
+    @return A session store
+    @ingroup HttpSession
+    @stability Prototype
+ */
+PUBLIC HttpSessionStore *httpCreateMemorySessionStore(int shards);
+
+/**
+    Create a shared memory session store
+    @description Sessions are encoded in a compact binary form in fixed size slots of a memory mapped file. The file
+        is created if required and may be opened by several server processes on one host to share sessions.
+        Each process retains the decoded session objects and only decodes a session again if its version changes.
+        This store is only supported on Unix-like systems.
+    @param path Path of the file to map. The file should be on a memory backed file system such as /dev/shm.
+    @param maxSessions Maximum number of sessions.
+    @param maxSize Maximum encoded size of a single session.
+    @return A session store or null if the file cannot be created or mapped.
+    @ingroup HttpSession
+    @stability Prototype
+ */
+PUBLIC HttpSessionStore *httpCreateSharedSessionStore(cchar *path, int maxSessions, ssize maxSize);
+
+/**
+    Set the session store
+    @description The default store is an in-memory session store. Sessions in the previous store are not migrated.
+    @param http Http service object
+    @param store Session store created via #httpCreateMemorySessionStore or #httpCreateSharedSessionStore
+    @ingroup HttpSession
+    @stability Prototype
+ */
+PUBLIC void httpSetSessionStore(Http *http, HttpSessionStore *store);
+
 /**
     Allocate a new session state object.
     @param conn Http connection object
@@ -4892,7 +5458,8 @@ PUBLIC char *httpGetSessionID(HttpConn *conn);
 
 /**
     Get an object from the session state store.
-    @description Retrieve an object from the session state store by deserializing all properties.
+    @description Retrieve an object from the session state store.
+        The object may be modified by the caller, so the session is marked as modified and will be written.
     @param conn Http connection object
     @param key Session state key
     @ingroup HttpSession
@@ -4935,10 +5502,10 @@ PUBLIC int httpSetSessionVar(HttpConn *conn, cchar *name, cchar *value);
 
 /**
     Set an object into the session state store.
-    @description Store an object in the session state store by serializing all properties.
+    @description Store a copy of an object in the session state store.
     @param conn Http connection object
     @param key Session state key
-    @param value Object to serialize
+    @param value Object to store
     @ingroup HttpSession
     @stability Evolving
  */
@@ -4947,6 +5514,9 @@ PUBLIC int httpSetSessionObj(HttpConn *conn, cchar *key, MprHash *value);
 /**
     Write the session state to persistent data storage
     @description This is called internally by the ESP handler at the completion of any processing.
+        The session is only written to the session store if it has been modified. If another request has written
+        the session since it was read, the variables set or removed by this request are applied to the stored
+        session and the write is retried. Variables modified by both requests take the value from this request.
     @param conn Http connection object
     @stability Prototype
     @ingroup HttpSession
@@ -5062,6 +5632,9 @@ PUBLIC void httpRemoveUploadFile(HttpConn *conn, cchar *id);
 #define HTTP_ADDED_QUERY_PARAMS 0x400       /**< Query added to params */
 #define HTTP_ADDED_BODY_PARAMS  0x800       /**< Body data added to params */
 #define HTTP_EXPECT_CONTINUE    0x1000      /**< Client expects an HTTP 100 Continue response */
+#define HTTP_ADDED_JSON_PARAMS  0x2000      /**< JSON body tape converted to params */
+
+#define HTTP_METHOD_MASK        0x7F        /**< Mask of the method flags */
 
 /*  
     Incoming chunk encoding states
@@ -5159,6 +5732,8 @@ typedef struct HttpRx {
     HttpRange       *inputRange;            /**< Specified range for rx (post) data */
     char            *passwordDigest;        /**< User password digest for authentication */
     char            *paramString;           /**< Cached param data as a string */
+    struct HttpParamIndex *paramIndex;      /**< Index of query and form params not yet decoded */
+    MprJsonTape     *jsonTape;              /**< Buffered JSON request body parsed as received */
 
     /*  
         Upload details
@@ -5180,7 +5755,8 @@ typedef struct HttpRx {
 
 /**
     Add parameters from the request query string.
-    @description This adds query data to the request params
+    @description This adds query data to the request params. The query is indexed and each value is decoded
+        only when first requested via #httpGetParam.
     @param conn HttpConn connection object
     @ingroup HttpRx
     @stability Internal
@@ -5190,7 +5766,9 @@ PUBLIC void httpAddQueryParams(HttpConn *conn);
 
 /**
     Add parameters from the request body content.
-    @description This adds query data to the request params
+    @description This adds www-url encoded form data to the request params. The params are indexed in a copy of
+        the body content and each value is decoded only when first requested via #httpGetParam. The body content
+        is not modified.
     @param conn HttpConn connection object
     @ingroup HttpRx
     @stability Internal
@@ -5269,7 +5847,8 @@ PUBLIC cchar *httpGetParam(HttpConn *conn, cchar *var, cchar *defaultValue);
     Get the request params table
     @description This call gets the form var table for the current request.
         Query data and www-url encoded form data is entered into the table after decoding.
-        Use #mprLookupKey to retrieve data from the table.
+        Use #mprLookupKey to retrieve data from the table. This decodes all params. To retrieve individual
+        params, #httpGetParam is faster as it decodes only the requested value.
     @param conn HttpConn connection object
     @return #MprHash instance containing the form vars
     @ingroup HttpRx
@@ -5472,6 +6051,16 @@ PUBLIC void httpSetParam(HttpConn *conn, cchar *var, cchar *value);
  */
 PUBLIC void httpSetIntParam(HttpConn *conn, cchar *var, int value);
 
+/**
+    Get the rx method flag for a method
+    @param method Method name in upper case
+    @return The method flag. One of HTTP_DELETE, HTTP_GET, HTTP_HEAD, HTTP_OPTIONS, HTTP_POST, HTTP_PUT or HTTP_TRACE.
+        Returns zero for other methods.
+    @ingroup HttpRx
+    @stability Prototype
+ */
+PUBLIC int httpGetMethodFlag(cchar *method);
+
 /**
     Set a new HTTP method for processing
     @description This modifies the request method to alter request processing. The original method is preserved in
@@ -5551,6 +6140,7 @@ PUBLIC void httpProcessWriteEvent(HttpConn *conn);
 #define HTTP_TX_SENDFILE            0x4     /**< Relay output via Send connector */
 #define HTTP_TX_USE_OWN_HEADERS     0x8     /**< Skip adding default headers */
 #define HTTP_TX_NO_LENGTH           0x10    /**< Don't emit a content length (used for TRACE) */
+#define HTTP_TX_SHARED_FILE         0x20    /**< Transmit file is shared via the file cache and must not be closed */
 
 /** 
     Http Tx
@@ -5600,6 +6190,7 @@ typedef struct HttpTx {
     MprBuf          *cacheBuffer;           /**< Response caching buffer */
     ssize           cacheBufferLength;      /**< Current size of the cache buffer data */
     cchar           *cachedContent;         /**< Retrieved cached response to send */
+    HttpCachedResponse *cachedResponse;     /**< Retrieved persistent cached response to send */
 
     HttpRange       *outputRanges;          /**< Data ranges for tx data */
     HttpRange       *currentRange;          /**< Current range being fullfilled */
@@ -5611,6 +6202,8 @@ typedef struct HttpTx {
 
     /* File information for file-based handlers */
     MprFile         *file;                  /**< File to be served */
+    void            *variant;               /**< Compressed variant held while being served */
+    char            *fileData;              /**< In-memory content of a small cached file to be served */
     MprPath         fileInfo;               /**< File information if there is a real file to serve */
     ssize           headerSize;             /**< Size of the header written */
 
@@ -6052,6 +6645,115 @@ PUBLIC void httpWriteHeaders(HttpQueue *q, HttpPacket *packet);
  */
 PUBLIC ssize httpWriteUploadData(HttpConn *conn, MprList *formData, MprList *fileData);
 
+/********************************** HttpBatch ***********************************/
+/**
+    Batch request completion callback
+    @description Invoked on the batch dispatcher when a request completes, fails, times out or is cancelled.
+        The request status is the HTTP status or a negative MPR error code.
+    @param req Batch request object
+    @ingroup HttpBatch
+    @stability Prototype
+ */
+typedef void (*HttpBatchCallback)(struct HttpBatchRequest *req);
+
+/**
+    Asynchronous client request batch
+    @description A batch issues many client requests concurrently from a single dispatcher without blocking a
+        thread per request. Requests are queued and started as in-flight capacity permits. Each request has a deadline
+        and may be cancelled. Completed keep-alive connections are returned to the client connection pool (see
+        #httpSetClientPool) so queued requests to the same host reuse warm sockets.
+        All request processing and callbacks run on the batch dispatcher.
+    @defgroup HttpBatch HttpBatch
+    @see httpBatchRequest httpCancelBatchRequest httpCreateBatch httpWaitBatch
+    @stability Prototype
+ */
+typedef struct HttpBatch {
+    Http            *http;                  /**< Http service object */
+    MprDispatcher   *dispatcher;            /**< Dispatcher serializing all batch activity */
+    MprList         *queue;                 /**< Requests waiting to start */
+    int             starting;               /**< Event to start queued requests is pending */
+    int             next;                   /**< Index of the next queued request to start */
+    int             active;                 /**< Requests in flight */
+    int             maxActive;              /**< Maximum requests in flight */
+    volatile int    pending;                /**< Requests queued or in flight */
+    int             completed;              /**< Requests completed with a response */
+    int             failed;                 /**< Requests that failed, timed out or were cancelled */
+    void            *data;                  /**< Unmanaged user data */
+} HttpBatch;
+
+/**
+    Batch request
+    @ingroup HttpBatch
+    @stability Prototype
+ */
+typedef struct HttpBatchRequest {
+    HttpBatch       *batch;                 /**< Owning batch */
+    struct HttpConn *conn;                  /**< Connection while the request is in flight */
+    char            *method;                /**< HTTP method */
+    char            *uri;                   /**< Request URI */
+    char            *body;                  /**< Optional request body */
+    MprBuf          *response;              /**< Response body */
+    char            *error;                 /**< Error message if the request failed */
+    MprEvent        *timer;                 /**< Deadline timer */
+    MprTicks        deadline;               /**< Time by which the request must complete */
+    MprTicks        started;                /**< Time the request was started */
+    HttpBatchCallback callback;             /**< Completion callback */
+    void            *data;                  /**< Unmanaged user data */
+    int             status;                 /**< HTTP status or negative MPR error code */
+    int             done;                   /**< Request has completed */
+    int             cancelled;              /**< Cancellation requested */
+} HttpBatchRequest;
+
+/**
+    Create a request batch
+    @param dispatcher Dispatcher to serialize all batch activity. Set to NULL to create a dedicated dispatcher.
+    @param maxActive Maximum number of requests in flight. Further requests are queued.
+    @return A batch object
+    @ingroup HttpBatch
+    @stability Prototype
+ */
+PUBLIC HttpBatch *httpCreateBatch(MprDispatcher *dispatcher, int maxActive);
+
+/**
+    Issue an asynchronous request
+    @description The request is queued and started on the batch dispatcher. This call does not block.
+    @param batch Batch object created via #httpCreateBatch
+    @param method HTTP method to use
+    @param uri URI to request
+    @param body Optional request body. Set to null for GET requests.
+    @param timeout Time in milliseconds for the request to complete, including time spent queued. 
+        Set to zero to use the default request timeout.
+    @param callback Completion callback. May be null.
+    @param data Unmanaged user data for the callback.
+    @return The request object
+    @ingroup HttpBatch
+    @stability Prototype
+ */
+PUBLIC HttpBatchRequest *httpBatchRequest(HttpBatch *batch, cchar *method, cchar *uri, cchar *body, MprTicks timeout,
+    HttpBatchCallback callback, void *data);
+
+/**
+    Cancel a batch request
+    @description The request is aborted and the callback is invoked with the status MPR_ERR_ABORTED.
+        Does nothing if the request has already completed.
+    @param req Request object returned by #httpBatchRequest
+    @ingroup HttpBatch
+    @stability Prototype
+ */
+PUBLIC void httpCancelBatchRequest(HttpBatchRequest *req);
+
+/**
+    Wait for all batch requests to complete
+    @description Services the batch dispatcher on the calling thread until all requests have completed or the timeout
+        expires.
+    @param batch Batch object created via #httpCreateBatch
+    @param timeout Time in milliseconds to wait. Set to -1 to wait forever.
+    @return Zero if all requests completed, otherwise MPR_ERR_TIMEOUT.
+    @ingroup HttpBatch
+    @stability Prototype
+ */
+PUBLIC int httpWaitBatch(HttpBatch *batch, MprTicks timeout);
+
 /********************************* HttpEndpoint ***********************************/
 /*  
     Endpoint flags
@@ -6304,6 +7006,7 @@ typedef struct HttpHost {
     int             port;                   /**< Port address portion parsed from name */
     struct HttpHost *parent;                /**< Parent host to inherit aliases, dirs, routes */
     MprCache        *responseCache;         /**< Response content caching store */
+    HttpResponseStore *responseStore;      /**< Persistent response store. Used instead of responseCache if set */
     MprList         *routes;                /**< List of Route defintions */
     HttpRoute       *defaultRoute;          /**< Default route for the host */
     HttpEndpoint    *defaultEndpoint;       /**< Default endpoint for host */
@@ -6766,6 +7469,247 @@ PUBLIC int httpUpgradeWebSocket(HttpConn *conn);
  */
 PUBLIC bool httpWebSocketOrderlyClosed(HttpConn *conn);
 
+/************************************ HTTP/2 ***************************************/
+/**
+    HTTP/2 protocol engine implementing RFC 7540 with HPACK header compression (RFC 7541).
+    @description HTTP/2 multiplexes concurrent requests as streams over a single network connection. The network
+    connection owns the socket and exchanges binary frames with the peer. Each stream is serviced by a separate
+    HttpConn with its own Rx, Tx and request pipeline, so handlers and filters are unchanged. A stream writes its
+    response via the HTTP/2 connector which frames output and observes the per-stream and per-connection flow
+    control windows. HTTP/2 is selected via ALPN for TLS endpoints and, for cleartext endpoints, via the client
+    connection preface (prior knowledge) or an "Upgrade: h2c" request. The maximum number of concurrent streams
+    is defined by HttpLimits.streamsMax. Setting this limit to zero disables HTTP/2.
+    @defgroup HttpH2 HttpH2
+    @see httpCreateHpack httpCreateHttp2Headers httpDestroyHttp2 httpEnableHttp2Events httpHpackDecode
+        httpHpackEncode httpHttp2Event httpResetHttp2Stream httpSetHpackSize httpStartHttp2 httpUpgradeHttp2
+    @stability Prototype
+ */
+typedef struct HttpH2 {
+    MprList         *streams;               /**< Active stream connections */
+    struct HttpHpack *decoder;              /**< Header table for received header blocks */
+    struct HttpHpack *encoder;              /**< Header table for sent header blocks */
+    MprBuf          *headerBlock;           /**< Header block fragments being accumulated */
+    HttpPacket      *first;                 /**< First frame queued for output */
+    HttpPacket      *last;                  /**< Last frame queued for output */
+    MprIOVec        iovec[BIT_MAX_IOVEC];   /**< I/O vector for writing frames */
+    ssize           outCount;               /**< Bytes queued for output */
+    ssize           sendWindow;             /**< Connection flow control window for sending */
+    ssize           recvCredit;             /**< Received bytes not yet returned to the peer via WINDOW_UPDATE */
+    ssize           recvWindow;             /**< Connection flow control window advertised to the peer */
+    ssize           peerWindow;             /**< Initial stream window specified by the peer */
+    ssize           peerFrameSize;          /**< Maximum frame size accepted by the peer */
+    ssize           window;                 /**< Initial stream window advertised to the peer */
+    int             headerStream;           /**< Stream ID of a header block continued by CONTINUATION frames */
+    int             headerFlags;            /**< Flags of the HEADERS frame starting the header block */
+    int             lastStream;             /**< Highest stream ID received from the peer */
+    int             preface;                /**< Connection preface has been received */
+    int             processing;             /**< Processing received frames. Output is flushed when complete */
+    int             goaway;                 /**< GOAWAY has been sent or received */
+} HttpH2;
+
+#define HTTP2_PREFACE               "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+#define HTTP2_PREFACE_SIZE          24          /**< Length of the client connection preface */
+#define HTTP2_FRAME_HEADER_SIZE     9           /**< Size of a frame header */
+#define HTTP2_FRAME_SIZE            16384       /**< Default and accepted maximum frame payload size */
+#define HTTP2_WINDOW                65535       /**< Default flow control window */
+#define HTTP2_MAX_WINDOW            0x7FFFFFFF  /**< Maximum flow control window */
+#define HTTP2_TABLE_SIZE            4096        /**< Default HPACK dynamic table size */
+
+/*
+    Frame types
+ */
+#define HTTP2_DATA_FRAME            0x0
+#define HTTP2_HEADERS_FRAME         0x1
+#define HTTP2_PRIORITY_FRAME        0x2
+#define HTTP2_RESET_FRAME           0x3
+#define HTTP2_SETTINGS_FRAME        0x4
+#define HTTP2_PUSH_FRAME            0x5
+#define HTTP2_PING_FRAME            0x6
+#define HTTP2_GOAWAY_FRAME          0x7
+#define HTTP2_WINDOW_FRAME          0x8
+#define HTTP2_CONT_FRAME            0x9
+
+/*
+    Frame flags
+ */
+#define HTTP2_END_STREAM_FLAG       0x1
+#define HTTP2_ACK_FLAG              0x1
+#define HTTP2_END_HEADERS_FLAG      0x4
+#define HTTP2_PADDED_FLAG           0x8
+#define HTTP2_PRIORITY_FLAG         0x20
+
+/*
+    Settings
+ */
+#define HTTP2_HEADER_TABLE_SIZE     0x1
+#define HTTP2_ENABLE_PUSH           0x2
+#define HTTP2_MAX_STREAMS           0x3
+#define HTTP2_INITIAL_WINDOW        0x4
+#define HTTP2_MAX_FRAME_SIZE        0x5
+#define HTTP2_MAX_HEADER_SIZE       0x6
+
+/*
+    Error codes for RST_STREAM and GOAWAY
+ */
+#define HTTP2_NO_ERROR              0x0
+#define HTTP2_PROTOCOL_ERROR        0x1
+#define HTTP2_INTERNAL_ERROR        0x2
+#define HTTP2_FLOW_CONTROL_ERROR    0x3
+#define HTTP2_STREAM_CLOSED_ERROR   0x5
+#define HTTP2_FRAME_SIZE_ERROR      0x6
+#define HTTP2_REFUSED_STREAM        0x7
+#define HTTP2_CANCEL                0x8
+#define HTTP2_COMPRESSION_ERROR     0x9
+#define HTTP2_CALM_ERROR            0xB
+
+/*
+    Stream flags (HttpConn.streamFlags)
+ */
+#define HTTP2_STREAM_HEADERS_SENT   0x1         /**< Response headers have been sent */
+#define HTTP2_STREAM_END_SENT       0x2         /**< END_STREAM has been sent */
+#define HTTP2_STREAM_END_RECEIVED   0x4         /**< END_STREAM has been received */
+#define HTTP2_STREAM_RESET          0x8         /**< Stream has been reset by either peer */
+#define HTTP2_STREAM_CHUNKED        0x10        /**< Request body is presented to the stream pipeline as chunks */
+#define HTTP2_STREAM_CHUNKS         0x20        /**< At least one request body chunk has been presented */
+
+/**
+    HPACK header table
+    @description Maintains the dynamic table used to compress or decompress header blocks in one direction.
+    An HTTP/2 connection uses one table for decoding received header blocks and another for encoding sent header
+    blocks.
+    @ingroup HttpH2
+    @stability Prototype
+ */
+typedef struct HttpHpack {
+    MprList         *entries;               /**< Dynamic table entries (MprKeyValue). Most recent first */
+    ssize           size;                   /**< Current table size as defined by RFC 7541 section 4.1 */
+    ssize           max;                    /**< Maximum table size */
+    int             update;                 /**< Table size update must be signalled in the next header block */
+} HttpHpack;
+
+/**
+    Create an HPACK header table
+    @param max Maximum dynamic table size in bytes
+    @return The header table object
+    @ingroup HttpH2
+    @stability Prototype
+ */
+PUBLIC HttpHpack *httpCreateHpack(ssize max);
+
+/**
+    Create the HTTP/2 response headers for a stream
+    @description This is called by httpWriteHeaders for HTTP/2 streams after the standard response headers are
+        defined. Any alternate response body is added to the header packet. The status and headers are HPACK encoded
+        by the HTTP/2 connector when the header packet is sent.
+    @param q Queue to use for the response headers
+    @param packet Header packet
+    @ingroup HttpH2
+    @stability Prototype
+    @internal
+ */
+PUBLIC void httpCreateHttp2Headers(HttpQueue *q, HttpPacket *packet);
+
+/**
+    Destroy the HTTP/2 streams of a network connection
+    @param net Network connection owning the streams
+    @ingroup HttpH2
+    @stability Prototype
+    @internal
+ */
+PUBLIC void httpDestroyHttp2(HttpConn *net);
+
+/**
+    Enable I/O events for an HTTP/2 network connection
+    @description Any flow control credit for consumed input is returned to the peer and pending frames are written.
+    @param net Network connection
+    @ingroup HttpH2
+    @stability Prototype
+    @internal
+ */
+PUBLIC void httpEnableHttp2Events(HttpConn *net);
+
+/**
+    Decode an HPACK header block
+    @param hp Header table used to decode header blocks
+    @param headers List to receive the decoded headers as MprKeyValue items in order
+    @param data Header block
+    @param len Length of the header block
+    @param max Maximum total size of the decoded header names and values
+    @return Zero if successful. Otherwise a negative MPR error code. A decoding error is a connection error of
+        type COMPRESSION_ERROR.
+    @ingroup HttpH2
+    @stability Prototype
+ */
+PUBLIC int httpHpackDecode(HttpHpack *hp, MprList *headers, cuchar *data, ssize len, ssize max);
+
+/**
+    Encode a header field using HPACK
+    @description The header is encoded as an indexed field if it is in the static or dynamic table. Otherwise it is
+        encoded as a literal, which is added to the dynamic table unless the value is likely to be unique.
+        String literals are Huffman encoded if that is shorter.
+    @param hp Header table used to encode header blocks
+    @param buf Buffer to receive the encoded header block
+    @param name Lower case header name
+    @param value Header value
+    @ingroup HttpH2
+    @stability Prototype
+ */
+PUBLIC void httpHpackEncode(HttpHpack *hp, MprBuf *buf, cchar *name, cchar *value);
+
+/**
+    Process an I/O event on an HTTP/2 network connection
+    @param net Network connection
+    @param event I/O event
+    @ingroup HttpH2
+    @stability Prototype
+    @internal
+ */
+PUBLIC void httpHttp2Event(HttpConn *net, MprEvent *event);
+
+/**
+    Reset an HTTP/2 stream
+    @description This sends a RST_STREAM frame and aborts the stream. It is the HTTP/2 equivalent of disconnecting
+        the socket of an HTTP/1 connection.
+    @param stream Stream connection
+    @param error HTTP/2 error code
+    @ingroup HttpH2
+    @stability Prototype
+ */
+PUBLIC void httpResetHttp2Stream(HttpConn *stream, int error);
+
+/**
+    Set the maximum size of an HPACK dynamic table
+    @param hp Header table
+    @param max Maximum table size in bytes. Entries are evicted to fit.
+    @ingroup HttpH2
+    @stability Prototype
+ */
+PUBLIC void httpSetHpackSize(HttpHpack *hp, ssize max);
+
+/**
+    Start HTTP/2 on a new connection if the client sent the HTTP/2 connection preface
+    @description This implements the "prior knowledge" mode of starting HTTP/2 and is used for connections that
+        negotiated "h2" via ALPN.
+    @param conn Newly accepted connection
+    @return True if the connection is using HTTP/2 or if more data is required to determine the protocol.
+    @ingroup HttpH2
+    @stability Prototype
+    @internal
+ */
+PUBLIC bool httpStartHttp2(HttpConn *conn);
+
+/**
+    Upgrade a cleartext HTTP/1.1 connection to HTTP/2
+    @description If the parsed request asks to upgrade to "h2c", this responds with "101 Switching Protocols" and
+        services the request as HTTP/2 stream 1.
+    @param conn Connection with a parsed request
+    @return True if the connection has been upgraded
+    @ingroup HttpH2
+    @stability Prototype
+    @internal
+ */
+PUBLIC bool httpUpgradeHttp2(HttpConn *conn);
+
 /************************************ Misc *****************************************/
 /**
     Add an option to the options table
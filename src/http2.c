@@ -0,0 +1,1514 @@
+/*
+    http2.c - HTTP/2 protocol engine (RFC 7540)
+
+    An HTTP/2 network connection owns the socket and multiplexes many concurrent requests. Each request stream is
+    serviced by a separate HttpConn object that shares the socket and dispatcher of the network connection. Received
+    HEADERS and DATA frames are converted into an HTTP/1 style request that is pumped through the standard request
+    pipeline, so handlers and filters are unaware of the protocol. Responses are written by the http2Connector which
+    encodes the response headers using HPACK and splits the body into DATA frames subject to flow control.
+
+    HTTP/2 is started by the client connection preface ("prior knowledge" or after negotiating "h2" via ALPN) or by
+    upgrading a cleartext HTTP/1.1 request via "Upgrade: h2c".
+
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************* Includes ***********************************/
+
+#include    "http.h"
+
+#if BIT_HTTP_HTTP2
+/*********************************** Locals ***********************************/
+
+#define GET_UINT32(p) ((uint) (((p)[0] << 24) | ((p)[1] << 16) | ((p)[2] << 8) | (p)[3]))
+
+/*
+    Connection specific headers that must not be used with HTTP/2
+ */
+static cchar *hopHeaders[] = {
+    "connection", "http2-settings", "keep-alive", "proxy-connection", "te", "transfer-encoding", "upgrade", 0
+};
+
+static cchar *upgradeResponse = "HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n";
+
+/***************************** Forward Declarations ***************************/
+
+static int applySettings(HttpConn *net, uchar *data, ssize size);
+static HttpPacket *buildRequest(HttpConn *net, MprList *headers, int end, int *flags);
+static bool canReceive(HttpConn *stream);
+static void checkClosed(HttpConn *net);
+static void checkStream(HttpConn *stream);
+static void closeHttp2(HttpQueue *q);
+static void connError(HttpConn *net, int error, cchar *fmt, ...);
+static HttpConn *createStream(HttpConn *net, int id);
+static void destroyStream(HttpConn *stream);
+static MprBuf *encodeHeaders(HttpConn *stream);
+static bool fillEntity(HttpQueue *q, HttpPacket *packet);
+static HttpConn *findStream(HttpConn *net, int id);
+static void flushFrames(HttpConn *net);
+static bool isHopHeader(cchar *name);
+static void manageH2(HttpH2 *h2, int flags);
+static int maxStreams(HttpConn *net);
+static void openHttp2(HttpQueue *q);
+static void outgoingHttp2Service(HttpQueue *q);
+static void parseFrame(HttpConn *net, int type, int flags, int id, uchar *data, ssize size);
+static void processFrames(HttpConn *net);
+static void processHeaderBlock(HttpConn *net);
+static void pumpEvent(HttpConn *stream, MprEvent *event);
+static void pumpStream(HttpConn *stream);
+static void putUint32(MprBuf *buf, uint value);
+static void queueFrame(HttpConn *net, int type, int flags, int id, HttpPacket *packet);
+static void readFrames(HttpConn *net);
+static int removePadding(uchar **data, ssize *size);
+static void resetStream(HttpConn *stream, int error);
+static void resumeStreams(HttpConn *net);
+static void sendData(HttpQueue *q, HttpPacket *packet, bool *more);
+static void sendGoaway(HttpConn *net, int error);
+static void sendHeaders(HttpQueue *q, HttpPacket *packet);
+static void sendReset(HttpConn *net, int id, int error);
+static void sendWindowUpdate(HttpConn *net, int id, ssize increment);
+static void startHttp2(HttpConn *net);
+static void timeoutHttp2(HttpConn *net);
+static void updateWindows(HttpConn *net);
+static void addStreamInput(HttpConn *stream, uchar *data, ssize len, int end);
+
+/*********************************** Code *************************************/
+/*
+    Initialize the HTTP/2 connector. This is the connector for all HTTP/2 streams.
+ */
+PUBLIC int httpOpenHttp2Connector(Http *http)
+{
+    HttpStage     *stage;
+
+    mprTrace(5, "Open http2 connector");
+    if ((stage = httpCreateConnector(http, "http2Connector", NULL)) == 0) {
+        return MPR_ERR_CANT_CREATE;
+    }
+    stage->open = openHttp2;
+    stage->close = closeHttp2;
+    stage->outgoingService = outgoingHttp2Service;
+    http->http2Connector = stage;
+    return 0;
+}
+
+
+static void manageH2(HttpH2 *h2, int flags)
+{
+    HttpPacket  *packet;
+
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(h2->streams);
+        mprMark(h2->decoder);
+        mprMark(h2->encoder);
+        mprMark(h2->headerBlock);
+        for (packet = h2->first; packet; packet = packet->next) {
+            mprMark(packet);
+        }
+    }
+}
+
+
+/*
+    Start HTTP/2 if the client has sent the connection preface. Return true if the connection is now using HTTP/2 or
+    if more data is required to decide.
+ */
+PUBLIC bool httpStartHttp2(HttpConn *conn)
+{
+    MprBuf      *buf;
+    ssize       len;
+
+    if (!conn->input || conn->limits->streamsMax <= 0) {
+        return 0;
+    }
+    buf = conn->input->content;
+    len = min(mprGetBufLength(buf), HTTP2_PREFACE_SIZE);
+    if (len == 0 || memcmp(mprGetBufStart(buf), HTTP2_PREFACE, len) != 0) {
+        return 0;
+    }
+    if (len < HTTP2_PREFACE_SIZE) {
+        /* Partial preface. Wait for more data */
+        return 1;
+    }
+    mprLog(4, "Start HTTP/2 connection from %s:%d", conn->ip, conn->port);
+    startHttp2(conn);
+    processFrames(conn);
+    return 1;
+}
+
+
+/*
+    Upgrade a cleartext HTTP/1.1 request to HTTP/2 (RFC 7540 section 3.2). The request is serviced as stream 1
+    after the client connection preface is received.
+ */
+PUBLIC bool httpUpgradeHttp2(HttpConn *conn)
+{
+    HttpRx      *rx;
+    HttpH2      *h2;
+    HttpConn    *stream;
+    HttpPacket  *packet;
+    MprKey      *kp;
+    cchar       *settings;
+    char        *tok, *next, *cp, *decoded;
+    ssize       len;
+    int         h2c;
+
+    rx = conn->rx;
+    if (conn->secure || conn->limits->streamsMax <= 0 || conn->h2 || conn->net) {
+        return 0;
+    }
+    for (h2c = 0, tok = stok(sclone(rx->upgrade), ", \t", &next); tok; tok = stok(NULL, ", \t", &next)) {
+        if (scaselessmatch(tok, "h2c")) {
+            h2c = 1;
+            break;
+        }
+    }
+    if (!h2c || (settings = httpGetHeader(conn, "http2-settings")) == 0) {
+        return 0;
+    }
+    if (rx->length > 0 || (rx->flags & HTTP_CHUNKED)) {
+        /* Requests with a body continue using HTTP/1.1 */
+        return 0;
+    }
+    /*
+        The settings are base64url encoded without padding
+     */
+    for (cp = (char*) (settings = sclone(settings)); *cp; cp++) {
+        if (*cp == '-') {
+            *cp = '+';
+        } else if (*cp == '_') {
+            *cp = '/';
+        }
+    }
+    if ((decoded = mprDecode64Block(settings, &len, MPR_DECODE_TOKEQ)) == 0 || (len % 6) != 0) {
+        return 0;
+    }
+    mprLog(4, "Upgrade connection from %s:%d to HTTP/2", conn->ip, conn->port);
+    startHttp2(conn);
+    h2 = conn->h2;
+
+    /*
+        The 101 response must precede the server connection preface (SETTINGS)
+     */
+    packet = httpCreateDataPacket(slen(upgradeResponse));
+    mprPutStringToBuf(packet->content, upgradeResponse);
+    packet->next = h2->first;
+    h2->first = packet;
+    h2->outCount += httpGetPacketLength(packet);
+
+    /* Settings from the HTTP2-Settings header are not acknowledged */
+    if (applySettings(conn, (uchar*) decoded, len) < 0) {
+        flushFrames(conn);
+        return 1;
+    }
+    h2->lastStream = 1;
+    stream = createStream(conn, 1);
+    stream->streamFlags = HTTP2_STREAM_END_RECEIVED;
+    packet = httpCreateDataPacket(BIT_MAX_BUFFER);
+    mprPutToBuf(packet->content, "%s %s HTTP/2.0\r\n", rx->method, rx->originalUri);
+    for (kp = 0; (kp = mprGetNextKey(rx->headers, kp)) != 0; ) {
+        if (!isHopHeader(kp->key) && !scaselessmatch(kp->key, "expect")) {
+            mprPutToBuf(packet->content, "%s: %s\r\n", kp->key, (char*) kp->data);
+        }
+    }
+    mprPutStringToBuf(packet->content, "\r\n");
+    stream->input = packet;
+
+    /*
+        Reset the connection as the request is now owned by the stream. Remaining input is the client preface.
+     */
+    if (conn->activeRequest) {
+        httpMonitorEvent(conn, HTTP_COUNTER_ACTIVE_REQUESTS, -1);
+        conn->activeRequest = 0;
+    }
+    conn->rx->conn = 0;
+    conn->tx->conn = 0;
+    conn->rx = httpCreateRx(conn);
+    conn->tx = httpCreateTx(conn, NULL);
+    conn->state = HTTP_STATE_CONNECTED;
+    processFrames(conn);
+    return 1;
+}
+
+
+static void startHttp2(HttpConn *net)
+{
+    HttpH2      *h2;
+    HttpLimits  *limits;
+    HttpPacket  *packet;
+    int64       window;
+
+    limits = net->limits;
+    if ((h2 = mprAllocObj(HttpH2, manageH2)) == 0) {
+        return;
+    }
+    h2->streams = mprCreateList(0, 0);
+    h2->decoder = httpCreateHpack(HTTP2_TABLE_SIZE);
+    h2->encoder = httpCreateHpack(HTTP2_TABLE_SIZE);
+    h2->headerBlock = mprCreateBuf(BIT_MAX_BUFFER, -1);
+    h2->sendWindow = h2->peerWindow = HTTP2_WINDOW;
+    h2->peerFrameSize = HTTP2_FRAME_SIZE;
+    h2->window = min(max(limits->bufferSize, HTTP2_WINDOW), HTTP2_MAX_WINDOW);
+    net->h2 = h2;
+    net->protocol = sclone("HTTP/2.0");
+    net->keepAliveCount = 1;
+    net->timeoutCallback = timeoutHttp2;
+
+    /*
+        Server connection preface
+     */
+    packet = httpCreateDataPacket(18);
+    mprPutCharToBuf(packet->content, 0);
+    mprPutCharToBuf(packet->content, HTTP2_MAX_STREAMS);
+    putUint32(packet->content, maxStreams(net));
+    mprPutCharToBuf(packet->content, 0);
+    mprPutCharToBuf(packet->content, HTTP2_INITIAL_WINDOW);
+    putUint32(packet->content, (uint) h2->window);
+    mprPutCharToBuf(packet->content, 0);
+    mprPutCharToBuf(packet->content, HTTP2_MAX_HEADER_SIZE);
+    putUint32(packet->content, limits->headerSize);
+    queueFrame(net, HTTP2_SETTINGS_FRAME, 0, 0, packet);
+
+    window = min((int64) h2->window * maxStreams(net), HTTP2_MAX_WINDOW);
+    h2->recvWindow = HTTP2_WINDOW;
+    if (window > HTTP2_WINDOW) {
+        sendWindowUpdate(net, 0, (ssize) (window - HTTP2_WINDOW));
+        h2->recvWindow = (ssize) window;
+    }
+}
+
+
+static int maxStreams(HttpConn *net)
+{
+    return min(net->limits->streamsMax, net->limits->requestsPerClientMax);
+}
+
+
+/*
+    Inactivity timeout for the network connection. Tell the peer before disconnecting.
+ */
+static void timeoutHttp2(HttpConn *net)
+{
+    if (net->h2 && net->keepAliveCount > 0) {
+        sendGoaway(net, HTTP2_NO_ERROR);
+        flushFrames(net);
+    }
+    net->connError = 1;
+}
+
+
+PUBLIC void httpHttp2Event(HttpConn *net, MprEvent *event)
+{
+    net->lastActivity = net->http->now;
+
+    if (event->mask & MPR_WRITABLE) {
+        flushFrames(net);
+        resumeStreams(net);
+    }
+    if (event->mask & MPR_READABLE) {
+        readFrames(net);
+    }
+    checkClosed(net);
+    httpAfterEvent(net);
+}
+
+
+PUBLIC void httpEnableHttp2Events(HttpConn *net)
+{
+    HttpH2      *h2;
+    MprSocket   *sp;
+    int         eventMask;
+
+    if ((h2 = net->h2) == 0 || (sp = net->sock) == 0 || h2->processing) {
+        /* Events are enabled after processing received frames */
+        return;
+    }
+    updateWindows(net);
+    flushFrames(net);
+    checkClosed(net);
+    eventMask = MPR_READABLE;
+    if (h2->first || mprSocketHasBufferedWrite(sp)) {
+        eventMask |= MPR_WRITABLE;
+    }
+    httpSetupWaitHandler(net, eventMask);
+}
+
+
+/*
+    Abort all streams. Called when the network connection is destroyed.
+ */
+PUBLIC void httpDestroyHttp2(HttpConn *net)
+{
+    HttpH2      *h2;
+    HttpConn    *stream;
+
+    if ((h2 = net->h2) == 0) {
+        return;
+    }
+    while ((stream = mprGetFirstItem(h2->streams)) != 0) {
+        stream->streamFlags |= HTTP2_STREAM_RESET | HTTP2_STREAM_END_SENT | HTTP2_STREAM_END_RECEIVED;
+        httpDisconnect(stream);
+        destroyStream(stream);
+    }
+    h2->first = h2->last = 0;
+    h2->outCount = 0;
+}
+
+
+/*
+    Close the network connection once GOAWAY has been exchanged and all streams are complete
+ */
+static void checkClosed(HttpConn *net)
+{
+    HttpH2      *h2;
+
+    h2 = net->h2;
+    if (h2 && h2->goaway && net->keepAliveCount > 0 && mprGetListLength(h2->streams) == 0 && !h2->first) {
+        net->keepAliveCount = 0;
+        if (net->sock) {
+            mprDisconnectSocket(net->sock);
+        }
+    }
+}
+
+
+static void readFrames(HttpConn *net)
+{
+    HttpPacket  *packet;
+    MprBuf      *buf;
+    ssize       nbytes;
+
+    if ((packet = net->input) == 0) {
+        packet = net->input = httpCreateDataPacket(BIT_MAX_BUFFER);
+    }
+    buf = packet->content;
+    mprResetBufIfEmpty(buf);
+    if (mprGetBufSpace(buf) < BIT_MAX_BUFFER) {
+        mprCompactBuf(buf);
+        if (mprGetBufSpace(buf) < BIT_MAX_BUFFER && mprGrowBuf(buf, BIT_MAX_BUFFER) < 0) {
+            connError(net, HTTP2_INTERNAL_ERROR, "Cannot grow input buffer");
+            return;
+        }
+    }
+    nbytes = mprReadSocket(net->sock, mprGetBufEnd(buf), mprGetBufSpace(buf));
+    mprTrace(7, "http2: read socket %d bytes", nbytes);
+    if (nbytes > 0) {
+        mprAdjustBufEnd(buf, nbytes);
+        processFrames(net);
+
+    } else if (nbytes < 0 && mprIsSocketEof(net->sock)) {
+        net->errorMsg = net->sock->errorMsg;
+        net->keepAliveCount = 0;
+    }
+}
+
+
+/*
+    Process all complete frames in the input buffer
+ */
+static void processFrames(HttpConn *net)
+{
+    HttpH2      *h2;
+    HttpConn    *stream;
+    MprBuf      *buf;
+    uchar       *data;
+    ssize       len, size;
+
+    h2 = net->h2;
+    h2->processing = 1;
+    if (net->input) {
+        buf = net->input->content;
+        if (!h2->preface) {
+            len = min(mprGetBufLength(buf), HTTP2_PREFACE_SIZE);
+            if (memcmp(mprGetBufStart(buf), HTTP2_PREFACE, len) != 0) {
+                connError(net, HTTP2_PROTOCOL_ERROR, "Bad connection preface");
+            } else if (len == HTTP2_PREFACE_SIZE) {
+                mprAdjustBufStart(buf, HTTP2_PREFACE_SIZE);
+                h2->preface = 1;
+                if ((stream = findStream(net, 1)) != 0) {
+                    /* Upgraded request. Respond once the client has switched to HTTP/2. */
+                    pumpStream(stream);
+                }
+            }
+        }
+        while (h2->preface && net->keepAliveCount > 0 && (size = mprGetBufLength(buf)) >= HTTP2_FRAME_HEADER_SIZE) {
+            data = (uchar*) mprGetBufStart(buf);
+            len = (data[0] << 16) | (data[1] << 8) | data[2];
+            if (len > HTTP2_FRAME_SIZE) {
+                connError(net, HTTP2_FRAME_SIZE_ERROR, "Frame of %d bytes is too big", (int) len);
+                break;
+            }
+            if (size < (HTTP2_FRAME_HEADER_SIZE + len)) {
+                break;
+            }
+            mprAdjustBufStart(buf, HTTP2_FRAME_HEADER_SIZE + len);
+            parseFrame(net, data[3], data[4], GET_UINT32(&data[5]) & 0x7FFFFFFF, &data[HTTP2_FRAME_HEADER_SIZE], len);
+        }
+    }
+    /*
+        Responses generated while processing are written together
+     */
+    h2->processing = 0;
+    flushFrames(net);
+    resumeStreams(net);
+    updateWindows(net);
+    flushFrames(net);
+}
+
+
+static void parseFrame(HttpConn *net, int type, int flags, int id, uchar *data, ssize size)
+{
+    HttpH2      *h2;
+    HttpConn    *stream;
+    HttpPacket  *packet;
+    ssize       increment, frameSize;
+
+    h2 = net->h2;
+    mprTrace(6, "http2: receive frame type %d, flags 0x%x, stream %d, length %d", type, flags, id, (int) size);
+
+    if (h2->headerStream && type != HTTP2_CONT_FRAME) {
+        connError(net, HTTP2_PROTOCOL_ERROR, "Expected CONTINUATION frame");
+        return;
+    }
+    switch (type) {
+    case HTTP2_DATA_FRAME:
+        h2->recvCredit += size;
+        frameSize = size;
+        if (id == 0) {
+            connError(net, HTTP2_PROTOCOL_ERROR, "DATA frame on stream zero");
+            return;
+        }
+        if (h2->recvCredit > h2->recvWindow) {
+            connError(net, HTTP2_FLOW_CONTROL_ERROR, "DATA exceeds the connection flow control window");
+            return;
+        }
+        if ((flags & HTTP2_PADDED_FLAG) && removePadding(&data, &size) < 0) {
+            connError(net, HTTP2_PROTOCOL_ERROR, "Bad DATA frame padding");
+            return;
+        }
+        stream = findStream(net, id);
+        if (!stream || (stream->streamFlags & (HTTP2_STREAM_END_RECEIVED | HTTP2_STREAM_RESET))) {
+            if (id > h2->lastStream) {
+                connError(net, HTTP2_PROTOCOL_ERROR, "DATA frame on idle stream");
+            } else {
+                sendReset(net, id, HTTP2_STREAM_CLOSED_ERROR);
+            }
+            return;
+        }
+        stream->streamCredit += frameSize;
+        if (stream->streamCredit > h2->window) {
+            resetStream(stream, HTTP2_FLOW_CONTROL_ERROR);
+            return;
+        }
+        addStreamInput(stream, data, size, flags & HTTP2_END_STREAM_FLAG);
+        break;
+
+    case HTTP2_HEADERS_FRAME:
+        if (id == 0 || !(id & 0x1)) {
+            connError(net, HTTP2_PROTOCOL_ERROR, "Bad HEADERS stream %d", id);
+            return;
+        }
+        if ((flags & HTTP2_PADDED_FLAG) && removePadding(&data, &size) < 0) {
+            connError(net, HTTP2_PROTOCOL_ERROR, "Bad HEADERS frame padding");
+            return;
+        }
+        if (flags & HTTP2_PRIORITY_FLAG) {
+            /* Priorities are advisory and are ignored */
+            if (size < 5) {
+                connError(net, HTTP2_FRAME_SIZE_ERROR, "Bad HEADERS frame priority");
+                return;
+            }
+            data += 5;
+            size -= 5;
+        }
+        mprFlushBuf(h2->headerBlock);
+        mprPutBlockToBuf(h2->headerBlock, (char*) data, size);
+        h2->headerStream = id;
+        h2->headerFlags = flags;
+        if (flags & HTTP2_END_HEADERS_FLAG) {
+            processHeaderBlock(net);
+        }
+        break;
+
+    case HTTP2_CONT_FRAME:
+        if (id == 0 || id != h2->headerStream) {
+            connError(net, HTTP2_PROTOCOL_ERROR, "Unexpected CONTINUATION frame");
+            return;
+        }
+        if ((mprGetBufLength(h2->headerBlock) + size) > (net->limits->headerSize * 2)) {
+            connError(net, HTTP2_CALM_ERROR, "Header block is too big");
+            return;
+        }
+        mprPutBlockToBuf(h2->headerBlock, (char*) data, size);
+        if (flags & HTTP2_END_HEADERS_FLAG) {
+            processHeaderBlock(net);
+        }
+        break;
+
+    case HTTP2_PRIORITY_FRAME:
+        if (size != 5) {
+            connError(net, HTTP2_FRAME_SIZE_ERROR, "Bad PRIORITY frame");
+        }
+        break;
+
+    case HTTP2_RESET_FRAME:
+        if (size != 4 || id == 0) {
+            connError(net, (size != 4) ? HTTP2_FRAME_SIZE_ERROR : HTTP2_PROTOCOL_ERROR, "Bad RST_STREAM frame");
+            return;
+        }
+        if ((stream = findStream(net, id)) != 0) {
+            mprLog(4, "http2: stream %d reset by peer, error %d", id, GET_UINT32(data));
+            stream->streamFlags |= HTTP2_STREAM_RESET | HTTP2_STREAM_END_SENT | HTTP2_STREAM_END_RECEIVED;
+            httpDisconnect(stream);
+            pumpStream(stream);
+        } else if (id > h2->lastStream) {
+            connError(net, HTTP2_PROTOCOL_ERROR, "RST_STREAM frame on idle stream");
+        }
+        break;
+
+    case HTTP2_SETTINGS_FRAME:
+        if (id != 0) {
+            connError(net, HTTP2_PROTOCOL_ERROR, "Bad SETTINGS stream");
+        } else if (flags & HTTP2_ACK_FLAG) {
+            if (size != 0) {
+                connError(net, HTTP2_FRAME_SIZE_ERROR, "Bad SETTINGS acknowledgement");
+            }
+        } else if ((size % 6) != 0) {
+            connError(net, HTTP2_FRAME_SIZE_ERROR, "Bad SETTINGS frame size");
+        } else if (applySettings(net, data, size) == 0) {
+            queueFrame(net, HTTP2_SETTINGS_FRAME, HTTP2_ACK_FLAG, 0, NULL);
+        }
+        break;
+
+    case HTTP2_PUSH_FRAME:
+        connError(net, HTTP2_PROTOCOL_ERROR, "Clients cannot push");
+        break;
+
+    case HTTP2_PING_FRAME:
+        if (size != 8 || id != 0) {
+            connError(net, (size != 8) ? HTTP2_FRAME_SIZE_ERROR : HTTP2_PROTOCOL_ERROR, "Bad PING frame");
+        } else if (!(flags & HTTP2_ACK_FLAG)) {
+            packet = httpCreateDataPacket(8);
+            mprPutBlockToBuf(packet->content, (char*) data, 8);
+            queueFrame(net, HTTP2_PING_FRAME, HTTP2_ACK_FLAG, 0, packet);
+        }
+        break;
+
+    case HTTP2_GOAWAY_FRAME:
+        if (size < 8 || id != 0) {
+            connError(net, HTTP2_PROTOCOL_ERROR, "Bad GOAWAY frame");
+            return;
+        }
+        mprLog(4, "http2: GOAWAY received, last stream %d, error %d", GET_UINT32(data) & 0x7FFFFFFF,
+            GET_UINT32(&data[4]));
+        h2->goaway = 1;
+        break;
+
+    case HTTP2_WINDOW_FRAME:
+        if (size != 4) {
+            connError(net, HTTP2_FRAME_SIZE_ERROR, "Bad WINDOW_UPDATE frame");
+            return;
+        }
+        increment = GET_UINT32(data) & 0x7FFFFFFF;
+        if (id == 0) {
+            if (increment == 0 || (h2->sendWindow + increment) > HTTP2_MAX_WINDOW) {
+                connError(net, increment ? HTTP2_FLOW_CONTROL_ERROR : HTTP2_PROTOCOL_ERROR, "Bad window update");
+                return;
+            }
+            h2->sendWindow += increment;
+
+        } else if ((stream = findStream(net, id)) != 0) {
+            if (increment == 0 || (stream->streamWindow + increment) > HTTP2_MAX_WINDOW) {
+                resetStream(stream, increment ? HTTP2_FLOW_CONTROL_ERROR : HTTP2_PROTOCOL_ERROR);
+                return;
+            }
+            stream->streamWindow += increment;
+        }
+        break;
+
+    default:
+        /* Unknown frame types are ignored */
+        break;
+    }
+}
+
+
+static int removePadding(uchar **data, ssize *size)
+{
+    ssize   pad;
+
+    if (*size < 1) {
+        return MPR_ERR_BAD_FORMAT;
+    }
+    pad = (*data)[0];
+    if (pad >= *size) {
+        return MPR_ERR_BAD_FORMAT;
+    }
+    *data += 1;
+    *size -= 1 + pad;
+    return 0;
+}
+
+
+static int applySettings(HttpConn *net, uchar *data, ssize size)
+{
+    HttpH2      *h2;
+    HttpConn    *stream;
+    uchar       *cp;
+    ssize       delta;
+    uint        value;
+    int         field, next;
+
+    h2 = net->h2;
+    for (cp = data; cp < &data[size]; cp += 6) {
+        field = (cp[0] << 8) | cp[1];
+        value = GET_UINT32(&cp[2]);
+        switch (field) {
+        case HTTP2_HEADER_TABLE_SIZE:
+            httpSetHpackSize(h2->encoder, min(value, HTTP2_TABLE_SIZE));
+            break;
+
+        case HTTP2_ENABLE_PUSH:
+            if (value > 1) {
+                connError(net, HTTP2_PROTOCOL_ERROR, "Bad ENABLE_PUSH setting");
+                return MPR_ERR_BAD_VALUE;
+            }
+            break;
+
+        case HTTP2_INITIAL_WINDOW:
+            if (value > HTTP2_MAX_WINDOW) {
+                connError(net, HTTP2_FLOW_CONTROL_ERROR, "Bad INITIAL_WINDOW_SIZE setting");
+                return MPR_ERR_BAD_VALUE;
+            }
+            /* Adjust the window of existing streams by the difference */
+            delta = (ssize) value - h2->peerWindow;
+            h2->peerWindow = value;
+            for (next = 0; (stream = mprGetNextItem(h2->streams, &next)) != 0; ) {
+                stream->streamWindow += delta;
+            }
+            break;
+
+        case HTTP2_MAX_FRAME_SIZE:
+            if (value < HTTP2_FRAME_SIZE || value > 0xFFFFFF) {
+                connError(net, HTTP2_PROTOCOL_ERROR, "Bad MAX_FRAME_SIZE setting");
+                return MPR_ERR_BAD_VALUE;
+            }
+            h2->peerFrameSize = value;
+            break;
+
+        default:
+            /* MAX_CONCURRENT_STREAMS and MAX_HEADER_LIST_SIZE do not constrain a server. Others are ignored. */
+            break;
+        }
+    }
+    return 0;
+}
+
+
+/*
+    A complete header block has been received. Decode and start a new request or add trailers to an existing stream.
+ */
+static void processHeaderBlock(HttpConn *net)
+{
+    HttpH2      *h2;
+    HttpConn    *stream;
+    HttpPacket  *packet;
+    MprList     *headers;
+    int         id, end, flags;
+
+    h2 = net->h2;
+    id = h2->headerStream;
+    end = h2->headerFlags & HTTP2_END_STREAM_FLAG;
+    h2->headerStream = 0;
+
+    headers = mprCreateList(0, 0);
+    if (httpHpackDecode(h2->decoder, headers, (cuchar*) mprGetBufStart(h2->headerBlock),
+            mprGetBufLength(h2->headerBlock), net->limits->headerSize) < 0) {
+        connError(net, HTTP2_COMPRESSION_ERROR, "Cannot decode header block");
+        return;
+    }
+    if ((stream = findStream(net, id)) != 0) {
+        /* Trailers. These must end the stream and are ignored. */
+        if (!end || (stream->streamFlags & HTTP2_STREAM_END_RECEIVED)) {
+            resetStream(stream, HTTP2_PROTOCOL_ERROR);
+        } else {
+            addStreamInput(stream, NULL, 0, 1);
+        }
+        return;
+    }
+    if (id <= h2->lastStream) {
+        sendReset(net, id, HTTP2_STREAM_CLOSED_ERROR);
+        return;
+    }
+    h2->lastStream = id;
+    if (h2->goaway) {
+        return;
+    }
+    if (mprGetListLength(h2->streams) >= maxStreams(net)) {
+        sendReset(net, id, HTTP2_REFUSED_STREAM);
+        return;
+    }
+    if ((packet = buildRequest(net, headers, end, &flags)) == 0) {
+        sendReset(net, id, HTTP2_PROTOCOL_ERROR);
+        return;
+    }
+    if ((stream = createStream(net, id)) == 0) {
+        sendReset(net, id, HTTP2_INTERNAL_ERROR);
+        return;
+    }
+    stream->streamFlags = flags;
+    stream->input = packet;
+    pumpStream(stream);
+}
+
+
+static bool isHopHeader(cchar *name)
+{
+    cchar   **cp;
+
+    for (cp = hopHeaders; *cp; cp++) {
+        if (scaselessmatch(name, *cp)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+/*
+    Convert the decoded headers into an HTTP/1 request. If the request has a body without a content length, the body
+    is presented to the pipeline using chunked transfer encoding.
+ */
+static HttpPacket *buildRequest(HttpConn *net, MprList *headers, int end, int *flags)
+{
+    HttpPacket  *packet;
+    MprKeyValue *kp;
+    MprBuf      *buf;
+    cchar       *method, *path, *authority, *cookies, *name, *value;
+    int         next, regular, hasHost, hasLength;
+
+    method = path = authority = cookies = 0;
+    regular = hasHost = hasLength = 0;
+    buf = mprCreateBuf(BIT_MAX_BUFFER, -1);
+
+    for (next = 0; (kp = mprGetNextItem(headers, &next)) != 0; ) {
+        name = kp->key;
+        value = kp->value;
+        if (strpbrk(value, "\r\n") || strpbrk(&name[1], "\r\n: ") || *name == '\0') {
+            return 0;
+        }
+        if (*name == ':') {
+            /* Pseudo headers must precede regular headers */
+            if (regular) {
+                return 0;
+            }
+            if (smatch(name, ":method")) {
+                method = value;
+            } else if (smatch(name, ":path")) {
+                path = value;
+            } else if (smatch(name, ":authority")) {
+                authority = value;
+            } else if (!smatch(name, ":scheme")) {
+                return 0;
+            }
+            continue;
+        }
+        regular = 1;
+        if (isHopHeader(name) || smatch(name, "expect")) {
+            continue;
+        }
+        if (smatch(name, "cookie")) {
+            /* Cookies may be split into separate fields */
+            cookies = cookies ? sjoin(cookies, "; ", value, NULL) : value;
+            continue;
+        }
+        if (smatch(name, "host")) {
+            hasHost = 1;
+        } else if (smatch(name, "content-length")) {
+            hasLength = 1;
+        }
+        mprPutToBuf(buf, "%s: %s\r\n", name, value);
+    }
+    if (!method || !*method || !path || !*path || strpbrk(method, " ") || strpbrk(path, " ")) {
+        return 0;
+    }
+    packet = httpCreateDataPacket(mprGetBufLength(buf) + BIT_MAX_BUFFER);
+    mprPutToBuf(packet->content, "%s %s HTTP/2.0\r\n", method, path);
+    if (!hasHost && authority && !strpbrk(authority, " ")) {
+        mprPutToBuf(packet->content, "Host: %s\r\n", authority);
+    }
+    if (cookies) {
+        mprPutToBuf(packet->content, "Cookie: %s\r\n", cookies);
+    }
+    mprPutBlockToBuf(packet->content, mprGetBufStart(buf), mprGetBufLength(buf));
+    *flags = 0;
+    if (end) {
+        *flags |= HTTP2_STREAM_END_RECEIVED;
+    } else if (!hasLength) {
+        mprPutStringToBuf(packet->content, "Transfer-Encoding: chunked\r\n");
+        *flags |= HTTP2_STREAM_CHUNKED;
+    }
+    mprPutStringToBuf(packet->content, "\r\n");
+    return packet;
+}
+
+
+static HttpConn *createStream(HttpConn *net, int id)
+{
+    HttpConn    *stream;
+
+    if ((stream = httpCreateConn(net->http, net->endpoint, net->dispatcher)) == 0) {
+        return 0;
+    }
+    stream->net = net;
+    stream->streamId = id;
+    stream->streamWindow = net->h2->peerWindow;
+    stream->notifier = net->notifier;
+    stream->async = net->async;
+    stream->sock = net->sock;
+    stream->ip = net->ip;
+    stream->port = net->port;
+    stream->secure = net->secure;
+    stream->address = net->address;
+    stream->protocol = net->protocol;
+    stream->keepAliveCount = 0;
+    httpSetState(stream, HTTP_STATE_CONNECTED);
+    mprAddItem(net->h2->streams, stream);
+    return stream;
+}
+
+
+static HttpConn *findStream(HttpConn *net, int id)
+{
+    HttpConn    *stream;
+    int         next;
+
+    for (next = 0; (stream = mprGetNextItem(net->h2->streams, &next)) != 0; ) {
+        if (stream->streamId == id) {
+            return stream;
+        }
+    }
+    return 0;
+}
+
+
+/*
+    Add request body data to the stream input
+ */
+static void addStreamInput(HttpConn *stream, uchar *data, ssize len, int end)
+{
+    HttpPacket  *packet;
+    MprBuf      *buf;
+    int         chunked;
+
+    if ((packet = stream->input) == 0) {
+        packet = stream->input = httpCreateDataPacket(max(len + 16, BIT_MAX_BUFFER));
+    }
+    buf = packet->content;
+    chunked = stream->streamFlags & HTTP2_STREAM_CHUNKED;
+    if (len > 0) {
+        if (chunked) {
+            /* The first chunk uses the CRLF after the headers as its leading delimiter */
+            mprPutToBuf(buf, (stream->streamFlags & HTTP2_STREAM_CHUNKS) ? "\r\n%x\r\n" : "%x\r\n", (int) len);
+            stream->streamFlags |= HTTP2_STREAM_CHUNKS;
+        }
+        mprPutBlockToBuf(buf, (char*) data, len);
+    }
+    if (end) {
+        stream->streamFlags |= HTTP2_STREAM_END_RECEIVED;
+        if (chunked) {
+            mprPutStringToBuf(buf, (stream->streamFlags & HTTP2_STREAM_CHUNKS) ? "\r\n0\r\n\r\n" : "0\r\n\r\n");
+        }
+    }
+    pumpStream(stream);
+}
+
+
+static void pumpStream(HttpConn *stream)
+{
+    HttpRx      *rx;
+
+    stream->newData = httpGetPacketLength(stream->input);
+    httpPumpRequest(stream, stream->input);
+
+    rx = stream->rx;
+    if (rx && stream->state == HTTP_STATE_CONTENT && rx->remainingContent > 0 &&
+            (stream->streamFlags & (HTTP2_STREAM_END_RECEIVED | HTTP2_STREAM_CHUNKED)) == HTTP2_STREAM_END_RECEIVED &&
+            httpGetPacketLength(stream->input) == 0) {
+        httpError(stream, HTTP_ABORT | HTTP_CODE_BAD_REQUEST, "Request body is shorter than the content length");
+    }
+    checkStream(stream);
+}
+
+
+static void pumpEvent(HttpConn *stream, MprEvent *event)
+{
+    HttpConn    *net;
+
+    if ((net = stream->net) == 0) {
+        return;
+    }
+    pumpStream(stream);
+    httpEnableHttp2Events(net);
+}
+
+
+static void checkStream(HttpConn *stream)
+{
+    if (stream->net && (stream->state == HTTP_STATE_COMPLETE ||
+            ((stream->streamFlags & HTTP2_STREAM_RESET) && stream->state < HTTP_STATE_PARSED))) {
+        destroyStream(stream);
+    }
+}
+
+
+static void destroyStream(HttpConn *stream)
+{
+    HttpConn    *net;
+
+    if ((net = stream->net) == 0) {
+        return;
+    }
+    if (!(stream->streamFlags & (HTTP2_STREAM_RESET | HTTP2_STREAM_END_RECEIVED))) {
+        /* Response complete before the request body. Tell the client to stop sending. */
+        sendReset(net, stream->streamId, HTTP2_NO_ERROR);
+    }
+    mprRemoveItem(net->h2->streams, stream);
+    net->lastActivity = net->http->now;
+
+    /* The socket and dispatcher belong to the network connection */
+    stream->sock = 0;
+    stream->dispatcher = 0;
+    stream->net = 0;
+    httpDestroyConn(stream);
+}
+
+
+PUBLIC void httpResetHttp2Stream(HttpConn *stream, int error)
+{
+    HttpConn    *net;
+
+    if ((net = stream->net) == 0 || (stream->streamFlags & HTTP2_STREAM_RESET)) {
+        return;
+    }
+    stream->streamFlags |= HTTP2_STREAM_RESET;
+    if ((stream->streamFlags & (HTTP2_STREAM_END_SENT | HTTP2_STREAM_END_RECEIVED)) !=
+            (HTTP2_STREAM_END_SENT | HTTP2_STREAM_END_RECEIVED)) {
+        sendReset(net, stream->streamId, error);
+        flushFrames(net);
+    }
+    stream->streamFlags |= HTTP2_STREAM_END_SENT | HTTP2_STREAM_END_RECEIVED;
+    if (!stream->pumping) {
+        mprCreateEvent(net->dispatcher, "http2Reset", 0, pumpEvent, stream, 0);
+    }
+}
+
+
+static void resetStream(HttpConn *stream, int error)
+{
+    httpResetHttp2Stream(stream, error);
+    httpDisconnect(stream);
+}
+
+
+/*
+    Resume streams waiting for output flow control credit or space in the network connection
+ */
+static void resumeStreams(HttpConn *net)
+{
+    HttpH2      *h2;
+    HttpConn    *stream;
+    HttpTx      *tx;
+    int         next;
+
+    h2 = net->h2;
+    for (next = 0; (stream = mprGetNextItem(h2->streams, &next)) != 0; ) {
+        if (h2->outCount >= net->limits->bufferSize || h2->sendWindow <= 0) {
+            break;
+        }
+        tx = stream->tx;
+        if (stream->pumping || !tx || stream->streamWindow <= 0) {
+            continue;
+        }
+        if (tx->writeBlocked || (stream->connectorq && stream->connectorq->count > 0)) {
+            tx->writeBlocked = 0;
+            if (stream->connectorq) {
+                httpResumeQueue(stream->connectorq);
+            }
+            httpServiceQueues(stream);
+            pumpStream(stream);
+            if (stream->net == 0) {
+                /* Stream completed and was removed from the list */
+                next--;
+            }
+        }
+    }
+}
+
+
+/*
+    Return flow control credit to the peer for consumed input. As for HTTP/1 which stops reading when the read queue 
+    is full, credit for a stream is withheld while its buffered input is at or over the read queue maximum. The 
+    connection credit for that stream is also withheld so the peer cannot fill the connection with data for a stream
+    that is not reading. Credit is returned when the stream reads and re-enables events.
+ */
+static void updateWindows(HttpConn *net)
+{
+    HttpH2      *h2;
+    HttpConn    *stream;
+    ssize       held, credit;
+    int         next;
+
+    h2 = net->h2;
+    held = 0;
+    for (next = 0; (stream = mprGetNextItem(h2->streams, &next)) != 0; ) {
+        if (stream->streamCredit == 0 || (stream->streamFlags & (HTTP2_STREAM_END_RECEIVED | HTTP2_STREAM_RESET))) {
+            continue;
+        }
+        if (!canReceive(stream)) {
+            held += stream->streamCredit;
+            continue;
+        }
+        if (stream->streamCredit >= (h2->window / 2)) {
+            sendWindowUpdate(net, stream->streamId, stream->streamCredit);
+            stream->streamCredit = 0;
+        }
+    }
+    credit = h2->recvCredit - min(held, h2->recvCredit);
+    if (credit > 0 && credit >= (h2->recvWindow / 2)) {
+        sendWindowUpdate(net, 0, credit);
+        h2->recvCredit -= credit;
+    }
+}
+
+
+/*
+    Test if a stream has room to receive more body data. Input buffered before the pipeline counts against the
+    read queue maximum. Forms are read entirely before processing so are always permitted.
+ */
+static bool canReceive(HttpConn *stream)
+{
+    HttpQueue   *q;
+
+    if ((q = stream->readq) == 0 || !stream->rx || stream->rx->form) {
+        return 1;
+    }
+    return (q->count + httpGetPacketLength(stream->input)) < q->max;
+}
+
+
+/*
+    Append a frame to the output list. The frame header is stored in the packet prefix.
+ */
+static void queueFrame(HttpConn *net, int type, int flags, int id, HttpPacket *packet)
+{
+    HttpH2      *h2;
+    MprBuf      *prefix;
+    ssize       len;
+
+    h2 = net->h2;
+    if (packet == 0) {
+        packet = httpCreatePacket(0);
+    }
+    len = httpGetPacketLength(packet);
+    prefix = packet->prefix = mprCreateBuf(HTTP2_FRAME_HEADER_SIZE, HTTP2_FRAME_HEADER_SIZE);
+    mprPutCharToBuf(prefix, (int) (len >> 16) & 0xFF);
+    mprPutCharToBuf(prefix, (int) (len >> 8) & 0xFF);
+    mprPutCharToBuf(prefix, (int) len & 0xFF);
+    mprPutCharToBuf(prefix, type);
+    mprPutCharToBuf(prefix, flags);
+    putUint32(prefix, id);
+
+    packet->next = 0;
+    if (h2->last) {
+        h2->last->next = packet;
+    } else {
+        h2->first = packet;
+    }
+    h2->last = packet;
+    h2->outCount += HTTP2_FRAME_HEADER_SIZE + len;
+    mprTrace(6, "http2: send frame type %d, flags 0x%x, stream %d, length %d", type, flags, id, (int) len);
+}
+
+
+static void putUint32(MprBuf *buf, uint value)
+{
+    mprPutCharToBuf(buf, (value >> 24) & 0xFF);
+    mprPutCharToBuf(buf, (value >> 16) & 0xFF);
+    mprPutCharToBuf(buf, (value >> 8) & 0xFF);
+    mprPutCharToBuf(buf, value & 0xFF);
+}
+
+
+static void sendReset(HttpConn *net, int id, int error)
+{
+    HttpPacket  *packet;
+
+    packet = httpCreateDataPacket(4);
+    putUint32(packet->content, error);
+    queueFrame(net, HTTP2_RESET_FRAME, 0, id, packet);
+}
+
+
+static void sendGoaway(HttpConn *net, int error)
+{
+    HttpPacket  *packet;
+
+    packet = httpCreateDataPacket(8);
+    putUint32(packet->content, net->h2->lastStream);
+    putUint32(packet->content, error);
+    queueFrame(net, HTTP2_GOAWAY_FRAME, 0, 0, packet);
+    net->h2->goaway = 1;
+}
+
+
+static void sendWindowUpdate(HttpConn *net, int id, ssize increment)
+{
+    HttpPacket  *packet;
+
+    packet = httpCreateDataPacket(4);
+    putUint32(packet->content, (uint) increment);
+    queueFrame(net, HTTP2_WINDOW_FRAME, 0, id, packet);
+}
+
+
+static void connError(HttpConn *net, int error, cchar *fmt, ...)
+{
+    va_list     args;
+
+    va_start(args, fmt);
+    net->errorMsg = sfmtv(fmt, args);
+    va_end(args);
+    mprLog(3, "HTTP/2 connection error from %s: %s", net->ip, net->errorMsg);
+    if (net->keepAliveCount > 0) {
+        sendGoaway(net, error);
+    }
+    net->keepAliveCount = 0;
+    net->connError = 1;
+}
+
+
+/*
+    Write queued frames using vectored writes. Frames that cannot be written now remain queued for a writable event.
+ */
+static void flushFrames(HttpConn *net)
+{
+    HttpH2      *h2;
+    HttpPacket  *packet;
+    MprBuf      *prefix;
+    ssize       written, len;
+    int         count, errCode;
+
+    h2 = net->h2;
+    while (h2->first && net->sock) {
+        for (count = 0, packet = h2->first; packet && count < (BIT_MAX_IOVEC - 1); packet = packet->next) {
+            if (packet->prefix && (len = mprGetBufLength(packet->prefix)) > 0) {
+                h2->iovec[count].start = mprGetBufStart(packet->prefix);
+                h2->iovec[count++].len = len;
+            }
+            if ((len = httpGetPacketLength(packet)) > 0) {
+                h2->iovec[count].start = mprGetBufStart(packet->content);
+                h2->iovec[count++].len = len;
+            }
+        }
+        written = mprWriteSocketVector(net->sock, h2->iovec, count);
+        mprTrace(7, "http2: wrote %d", (int) written);
+        if (written < 0) {
+            errCode = mprGetError();
+            if (errCode != EAGAIN && errCode != EWOULDBLOCK) {
+                /* Connection lost. Discard output and close. Streams are aborted when the connection is destroyed. */
+                h2->first = h2->last = 0;
+                h2->outCount = 0;
+                net->keepAliveCount = 0;
+                net->connError = 1;
+                mprDisconnectSocket(net->sock);
+            }
+            break;
+        } else if (written == 0) {
+            break;
+        }
+        net->lastActivity = net->http->now;
+        h2->outCount -= written;
+        while (written > 0 && (packet = h2->first) != 0) {
+            if ((prefix = packet->prefix) != 0) {
+                len = min(mprGetBufLength(prefix), written);
+                mprAdjustBufStart(prefix, len);
+                written -= len;
+            }
+            if ((len = min(httpGetPacketLength(packet), written)) > 0) {
+                mprAdjustBufStart(packet->content, len);
+                written -= len;
+            }
+            if ((prefix && mprGetBufLength(prefix) > 0) || httpGetPacketLength(packet) > 0) {
+                break;
+            }
+            if ((h2->first = packet->next) == 0) {
+                h2->last = 0;
+            }
+        }
+    }
+}
+
+
+/*
+    Prepare the HTTP/2 response headers. Called by httpWriteHeaders after the standard headers are defined.
+    The headers are HPACK encoded by the connector when sent so the header table state follows the output order.
+ */
+PUBLIC void httpCreateHttp2Headers(HttpQueue *q, HttpPacket *packet)
+{
+    HttpConn    *conn;
+    HttpTx      *tx;
+    int         level;
+
+    conn = q->conn;
+    tx = conn->tx;
+    if ((level = httpShouldTrace(conn, HTTP_TRACE_TX, HTTP_TRACE_FIRST, tx->ext)) >= mprGetLogLevel(tx)) {
+        mprLog(level, "  %s %d %s (stream %d)", conn->protocol, tx->status, httpLookupStatus(conn->http, tx->status),
+            conn->streamId);
+    }
+    if (tx->altBody) {
+        /* Error responses are sent as the first data frame */
+        mprPutStringToBuf(packet->content, tx->altBody);
+        httpDiscardQueueData(tx->queue[HTTP_QUEUE_TX]->nextQ, 0);
+    }
+    q->count += httpGetPacketLength(packet);
+}
+
+
+static void openHttp2(HttpQueue *q)
+{
+    HttpConn    *conn;
+    HttpTx      *tx;
+
+    conn = q->conn;
+    tx = conn->tx;
+    if ((tx->flags & HTTP_TX_SENDFILE) && !(tx->flags & HTTP_TX_NO_BODY) && !tx->file) {
+        /* Handlers requesting sendfile generate entity packets that are read from the file */
+        if ((tx->file = mprOpenFile(tx->filename, O_RDONLY | O_BINARY, 0)) == 0) {
+            httpError(conn, HTTP_CODE_NOT_FOUND, "Cannot open document: %s, err %d", tx->filename, mprGetError());
+        }
+    }
+}
+
+
+static void closeHttp2(HttpQueue *q)
+{
+    HttpTx      *tx;
+
+    tx = q->conn->tx;
+    if (tx->file) {
+        mprCloseFile(tx->file);
+        tx->file = 0;
+    }
+}
+
+
+static void outgoingHttp2Service(HttpQueue *q)
+{
+    HttpConn    *stream, *net;
+    HttpTx      *tx;
+    HttpPacket  *packet, *prefix;
+    bool        more;
+
+    stream = q->conn;
+    tx = stream->tx;
+    if ((net = stream->net) == 0 || !net->h2 || tx->finalizedConnector) {
+        return;
+    }
+    stream->lastActivity = stream->http->now;
+    if (tx->flags & HTTP_TX_NO_BODY) {
+        httpDiscardQueueData(q, 1);
+    }
+    for (more = 1; more && (packet = q->first) != 0; ) {
+        if (packet->flags & HTTP_PACKET_HEADER) {
+            sendHeaders(q, packet);
+
+        } else if (packet->flags & HTTP_PACKET_END) {
+            httpGetPacket(q);
+            if (!(stream->streamFlags & HTTP2_STREAM_END_SENT)) {
+                queueFrame(net, HTTP2_DATA_FRAME, HTTP2_END_STREAM_FLAG, stream->streamId, NULL);
+                stream->streamFlags |= HTTP2_STREAM_END_SENT;
+            }
+            httpFinalizeConnector(stream);
+            break;
+
+        } else if (packet->prefix && mprGetBufLength(packet->prefix) > 0) {
+            /* Send a prefix (range boundary) as separate data */
+            httpGetPacket(q);
+            prefix = httpCreateDataPacket(mprGetBufLength(packet->prefix));
+            mprPutBlockToBuf(prefix->content, mprGetBufStart(packet->prefix), mprGetBufLength(packet->prefix));
+            packet->prefix = 0;
+            httpPutBackPacket(q, packet);
+            httpPutBackPacket(q, prefix);
+
+        } else {
+            sendData(q, packet, &more);
+        }
+    }
+    if (!net->h2->processing) {
+        flushFrames(net);
+    }
+    if (tx->finalizedConnector && !stream->pumping) {
+        mprCreateEvent(net->dispatcher, "http2Complete", 0, pumpEvent, stream, 0);
+    }
+}
+
+
+static void sendHeaders(HttpQueue *q, HttpPacket *packet)
+{
+    HttpConn    *stream, *net;
+    HttpTx      *tx;
+    HttpPacket  *frame;
+    MprBuf      *block;
+    ssize       len;
+    int         type, flags, end;
+
+    stream = q->conn;
+    net = stream->net;
+    tx = stream->tx;
+
+    httpWriteHeaders(q, packet);
+    httpGetPacket(q);
+    block = encodeHeaders(stream);
+    tx->headerSize = mprGetBufLength(block);
+
+    end = httpGetPacketLength(packet) == 0 && q->first && (q->first->flags & HTTP_PACKET_END);
+    flags = end ? HTTP2_END_STREAM_FLAG : 0;
+    type = HTTP2_HEADERS_FRAME;
+    do {
+        len = min(mprGetBufLength(block), net->h2->peerFrameSize);
+        frame = httpCreateDataPacket(len);
+        mprPutBlockToBuf(frame->content, mprGetBufStart(block), len);
+        mprAdjustBufStart(block, len);
+        if (mprGetBufLength(block) == 0) {
+            flags |= HTTP2_END_HEADERS_FLAG;
+        }
+        queueFrame(net, type, flags, stream->streamId, frame);
+        type = HTTP2_CONT_FRAME;
+        flags = 0;
+    } while (mprGetBufLength(block) > 0);
+
+    stream->streamFlags |= HTTP2_STREAM_HEADERS_SENT | (end ? HTTP2_STREAM_END_SENT : 0);
+    if (httpGetPacketLength(packet) > 0) {
+        /* Error response body */
+        packet->flags = HTTP_PACKET_DATA;
+        httpPutBackPacket(q, packet);
+    }
+}
+
+
+static MprBuf *encodeHeaders(HttpConn *stream)
+{
+    HttpHpack   *encoder;
+    MprBuf      *block;
+    MprKey      *kp;
+    char        *name;
+
+    encoder = stream->net->h2->encoder;
+    block = mprCreateBuf(BIT_MAX_BUFFER, -1);
+    httpHpackEncode(encoder, block, ":status", itos(stream->tx->status));
+    for (kp = 0; (kp = mprGetNextKey(stream->tx->headers, kp)) != 0; ) {
+        if (!isHopHeader(kp->key)) {
+            name = slower(kp->key);
+            httpHpackEncode(encoder, block, name, kp->data ? (cchar*) kp->data : "");
+        }
+    }
+    return block;
+}
+
+
+/*
+    Send one DATA frame subject to the stream and connection flow control windows. Set *more to false if the
+    stream must wait for credit or for the network connection to drain.
+ */
+static void sendData(HttpQueue *q, HttpPacket *packet, bool *more)
+{
+    HttpConn    *stream, *net;
+    HttpH2      *h2;
+    ssize       len, size;
+    int         end;
+
+    stream = q->conn;
+    net = stream->net;
+    h2 = net->h2;
+
+    len = packet->esize ? (ssize) packet->esize : httpGetPacketLength(packet);
+    if (len == 0) {
+        httpGetPacket(q);
+        return;
+    }
+    size = min(len, stream->streamWindow);
+    size = min(size, h2->sendWindow);
+    size = min(size, h2->peerFrameSize);
+    if (size <= 0 || h2->outCount >= net->limits->bufferSize) {
+        *more = 0;
+        return;
+    }
+    httpGetPacket(q);
+    if (size < len) {
+        httpPutBackPacket(q, httpSplitPacket(packet, size));
+    }
+    if (packet->esize && !fillEntity(q, packet)) {
+        httpError(stream, HTTP_ABORT | HTTP_CODE_INTERNAL_SERVER_ERROR, "Cannot read document");
+        *more = 0;
+        return;
+    }
+    end = q->first && (q->first->flags & HTTP_PACKET_END);
+    stream->streamWindow -= size;
+    h2->sendWindow -= size;
+    stream->tx->bytesWritten += size;
+    if (end) {
+        stream->streamFlags |= HTTP2_STREAM_END_SENT;
+    }
+    queueFrame(net, HTTP2_DATA_FRAME, end ? HTTP2_END_STREAM_FLAG : 0, stream->streamId, packet);
+}
+
+
+/*
+    Read the data for an entity packet
+ */
+static bool fillEntity(HttpQueue *q, HttpPacket *packet)
+{
+    HttpTx      *tx;
+    ssize       size;
+
+    tx = q->conn->tx;
+    size = (ssize) packet->esize;
+    if (packet->fill) {
+        if ((*packet->fill)(q, packet, packet->epos, size) < 0) {
+            return 0;
+        }
+    } else {
+        if (!tx->file || (packet->content = mprCreateBuf(size, -1)) == 0) {
+            return 0;
+        }
+        if (mprSeekFile(tx->file, SEEK_SET, packet->epos) != packet->epos ||
+                mprReadFile(tx->file, mprGetBufStart(packet->content), size) != size) {
+            return 0;
+        }
+        mprAdjustBufEnd(packet->content, size);
+    }
+    packet->esize = 0;
+    return 1;
+}
+
+#endif /* BIT_HTTP_HTTP2 */
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details and other copyrights.
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
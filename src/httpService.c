@@ -109,14 +109,21 @@ PUBLIC Http *httpCreate(int flags)
     for (code = HttpStatusCodes; code->code; code++) {
         mprAddKey(http->statusCodes, code->codeString, code);
     }
+    httpInitAtoms(http);
     httpInitAuth(http);
     httpOpenNetConnector(http);
     httpOpenSendConnector(http);
     httpOpenRangeFilter(http);
     httpOpenChunkFilter(http);
+#if BIT_PACK_ZLIB
+    httpOpenCompressFilter(http);
+#endif
 #if BIT_HTTP_WEB_SOCKETS
     httpOpenWebSockFilter(http);
 #endif
+#if BIT_HTTP_HTTP2
+    httpOpenHttp2Connector(http);
+#endif
 
     mprSetIdleCallback(isIdle);
     mprAddTerminator(terminateHttp);
@@ -126,7 +133,7 @@ PUBLIC Http *httpCreate(int flags)
         http->routeTargets = mprCreateHash(-1, MPR_HASH_STATIC_VALUES);
         http->routeConditions = mprCreateHash(-1, MPR_HASH_STATIC_VALUES);
         http->routeUpdates = mprCreateHash(-1, MPR_HASH_STATIC_VALUES);
-        http->sessionCache = mprCreateCache(MPR_CACHE_SHARED);
+        http->sessionStore = httpCreateMemorySessionStore(0);
         http->counters = mprCreateList(-1, 0);
         http->monitors = mprCreateList(-1, 0);
         http->addresses = mprCreateHash(-1, 0);
@@ -167,7 +174,7 @@ static void manageHttp(Http *http, int flags)
         mprMark(http->routeTargets);
         mprMark(http->routeConditions);
         mprMark(http->routeUpdates);
-        mprMark(http->sessionCache);
+        mprMark(http->sessionStore);
         /* Don't mark convenience stage references as they will be in http->stages */
 
         mprMark(http->clientLimits);
@@ -187,12 +194,19 @@ static void manageHttp(Http *http, int flags)
         mprMark(http->proxyHost);
         mprMark(http->authTypes);
         mprMark(http->authStores);
+        mprMark(http->atoms);
         mprMark(http->addresses);
         mprMark(http->defenses);
         mprMark(http->remedies);
         mprMark(http->monitors);
         mprMark(http->counters);
         mprMark(http->dateCache);
+        mprMark(http->variants);
+        mprMark(http->fileCache);
+        mprMark(http->clientPool);
+        mprMark(http->dnsCache);
+        mprMark(http->authCache);
+        mprMark(http->digest);
 
         /*
             Endpoints keep connections alive until a timeout. Keep marking even if no other references.
@@ -308,6 +322,7 @@ PUBLIC void httpInitLimits(HttpLimits *limits, bool serverSide)
     limits->processMax = BIT_MAX_PROCESSES;
     limits->requestsPerClientMax = BIT_MAX_REQUESTS_PER_CLIENT;
     limits->sessionMax = BIT_MAX_SESSIONS;
+    limits->streamsMax = BIT_MAX_STREAMS;
     limits->transmissionBodySize = BIT_MAX_TX_BODY;
     limits->uploadSize = BIT_MAX_UPLOAD;
     limits->uriSize = BIT_MAX_URI;
@@ -438,6 +453,12 @@ static void httpTimer(Http *http, MprEvent *event)
         limits = conn->limits;
         if (!conn->timeoutEvent) {
             abort = 0;
+#if BIT_HTTP_HTTP2
+            if (conn->h2) {
+                /* HTTP/2 network connections only expire when inactive. Streams are timed individually. */
+                abort = (conn->lastActivity + limits->inactivityTimeout) < http->now;
+            } else
+#endif
             if (conn->endpoint && HTTP_STATE_BEGIN < conn->state && conn->state < HTTP_STATE_PARSED && 
                     (conn->started + limits->requestParseTimeout) < http->now) {
                 abort = 1;
@@ -475,6 +496,9 @@ static void httpTimer(Http *http, MprEvent *event)
             }
         }
     }
+    /* Close expired pooled client sockets. The timer must continue while sockets remain */
+    active += httpPruneClientPool(http);
+
     if (active == 0) {
         mprRemoveEvent(event);
         http->timer = 0;
@@ -664,7 +688,7 @@ static void updateCurrentDate(Http *http)
 
     http->now = mprGetTicks();
     diff = http->now - http->currentTime;
-    if (diff <= MPR_TICKS_PER_SEC || diff >= MPR_TICKS_PER_SEC) {
+    if (diff >= MPR_TICKS_PER_SEC || diff < 0 || !http->currentDate) {
         /*
             Optimize and only update the string date representation once per second
          */
@@ -678,6 +702,9 @@ PUBLIC void httpGetStats(HttpStats *sp)
 {
     Http                *http;
     HttpAddress         *address;
+    HttpFileCache       *fc;
+    HttpDnsCache        *dc;
+    HttpAuthCache       *ac;
     MprKey              *kp;
     MprMemStats         *ap;
     MprWorkerStats      wstats;
@@ -704,7 +731,7 @@ PUBLIC void httpGetStats(HttpStats *sp)
     sp->activeVMs = http->activeVMs;
     sp->activeConnections = mprGetListLength(http->connections);
     sp->activeProcesses = http->activeProcesses;
-    sp->activeSessions = http->activeSessions;
+    sp->activeSessions = http->sessionStore ? http->sessionStore->count(http->sessionStore) : 0;
 
     lock(http->addresses);
     for (ITERATE_KEY_DATA(http->addresses, kp, address)) {
@@ -716,6 +743,35 @@ PUBLIC void httpGetStats(HttpStats *sp)
     sp->totalConnections = http->totalConnections;
     sp->totalSweeps = MPR->heap->iteration;
 
+    if ((fc = http->fileCache) != 0) {
+        lock(fc);
+        sp->fileCacheHits = fc->hits;
+        sp->fileCacheMisses = fc->misses;
+        sp->fileContentHits = fc->contentHits;
+        sp->fileContentMisses = fc->contentMisses;
+        sp->fileContentMemory = fc->memory;
+        sp->fileCacheFiles = mprGetHashLength(fc->files);
+        unlock(fc);
+    }
+    if ((dc = http->dnsCache) != 0) {
+        lock(dc);
+        sp->dnsHits = dc->hits + dc->negativeHits;
+        sp->dnsMisses = dc->misses;
+        sp->dnsLookups = dc->lookups;
+        sp->dnsLookupTime = dc->lookupTime;
+        sp->dnsMaxLookupTime = dc->maxLookupTime;
+        unlock(dc);
+    }
+    if ((ac = http->authCache) != 0) {
+        lock(ac);
+        sp->authHits = ac->hits;
+        sp->authMisses = ac->misses;
+        sp->authVerifyTime = ac->verifyTime;
+        sp->authSavedTime = ac->savedTime;
+        sp->authCacheEntries = mprGetHashLength(ac->entries);
+        unlock(ac);
+    }
+
 }
 
 
@@ -762,6 +818,29 @@ PUBLIC char *httpStatsReport(int flags)
         s.workersBusy, s.workersYielded, s.workersIdle, s.workersMax);
     mprPutCharToBuf(buf, '\n');
 
+    if (s.fileCacheHits + s.fileCacheMisses) {
+        mprPutToBuf(buf, "File-cache  %8d files, %5.1f%% hits\n", s.fileCacheFiles,
+            s.fileCacheHits * 100.0 / (s.fileCacheHits + s.fileCacheMisses));
+        mprPutToBuf(buf, "File-memory %8.1f MB, %5.1f%% hits\n", s.fileContentMemory / mb,
+            (s.fileContentHits + s.fileContentMisses) ? 
+            s.fileContentHits * 100.0 / (s.fileContentHits + s.fileContentMisses) : 0.0);
+        mprPutCharToBuf(buf, '\n');
+    }
+    if (s.dnsHits + s.dnsMisses) {
+        mprPutToBuf(buf, "DNS-cache   %8.1f%% hits, %d lookups\n", s.dnsHits * 100.0 / (s.dnsHits + s.dnsMisses),
+            (int) s.dnsLookups);
+        mprPutToBuf(buf, "DNS-lookup  %8.1f msec avg, %d max\n", 
+            s.dnsLookups ? s.dnsLookupTime / (double) s.dnsLookups : 0.0, (int) s.dnsMaxLookupTime);
+        mprPutCharToBuf(buf, '\n');
+    }
+    if (s.authHits + s.authMisses) {
+        mprPutToBuf(buf, "Auth-cache  %8d users, %5.1f%% hits\n", s.authCacheEntries,
+            s.authHits * 100.0 / (s.authHits + s.authMisses));
+        mprPutToBuf(buf, "Auth-verify %8.1f usec avg, %.1f msec saved\n",
+            s.authMisses ? s.authVerifyTime / (double) s.authMisses : 0.0, s.authSavedTime / 1000.0);
+        mprPutCharToBuf(buf, '\n');
+    }
+
     last = s;
     lastTime = now;
     mprAddNullToBuf(buf);
@@ -45,7 +45,9 @@ static void netClose(HttpQueue *q)
 
     tx = q->conn->tx;
     if (tx->file) {
-        mprCloseFile(tx->file);
+        if (!(tx->flags & HTTP_TX_SHARED_FILE)) {
+            mprCloseFile(tx->file);
+        }
         tx->file = 0;
     }
 }
@@ -80,7 +82,7 @@ static void netOutgoingService(HttpQueue *q)
 #if !BIT_ROM
     if (tx->flags & HTTP_TX_SENDFILE) {
         /* Relay via the send connector */
-        if (tx->file == 0) {
+        if (tx->file == 0 && tx->fileData == 0) {
             if (tx->flags & HTTP_TX_HEADERS_CREATED) {
                 tx->flags &= ~HTTP_TX_SENDFILE;
             } else {
@@ -88,7 +90,7 @@ static void netOutgoingService(HttpQueue *q)
                 httpSendOpen(q);
             }
         }
-        if (tx->file) {
+        if (tx->file || tx->fileData) {
             httpSendOutgoingService(q);
             return;
         }
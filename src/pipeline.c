@@ -64,14 +64,29 @@ PUBLIC void httpCreateTxPipeline(HttpConn *conn, HttpRoute *route)
                 if (rx->traceLevel >= 0) {
                     mprLog(rx->traceLevel, "Select output filter: \"%s\"", filter->name);
                 }
-                hasOutputFilters = 1;
+                if (!smatch(filter->name, "rangeFilter")) {
+                    /* The range filter passes file regions through so it can be used with the send connector */
+                    hasOutputFilters = 1;
+                }
             }
         }
     }
+#if BIT_HTTP_HTTP2
+    if (conn->net) {
+        /* HTTP/2 streams must use the HTTP/2 connector to frame output */
+        tx->connector = http->http2Connector;
+    }
+#endif
     if (tx->connector == 0) {
 #if !BIT_ROM
-        if (tx->handler == http->fileHandler && (rx->flags & HTTP_GET) && !hasOutputFilters && 
-                !conn->secure && httpShouldTrace(conn, HTTP_TRACE_TX, HTTP_TRACE_BODY, tx->ext) < 0) {
+        /*
+            Secure connections can only use sendfile if the kernel encrypts data written to the socket.
+            Persistent cached responses are sent from the response store data file.
+         */
+        if ((tx->handler == http->fileHandler || (tx->handler == http->cacheHandler && tx->cachedResponse)) &&
+                (rx->flags & HTTP_GET) && !hasOutputFilters && 
+                (!conn->secure || (conn->sock->flags & MPR_SOCKET_KTLS_TX)) &&
+                httpShouldTrace(conn, HTTP_TRACE_TX, HTTP_TRACE_BODY, tx->ext) < 0) {
             tx->connector = http->sendConnector;
         } else 
 #endif
@@ -252,6 +267,9 @@ PUBLIC void httpDestroyPipeline(HttpConn *conn)
                 }
             }
         }
+#if BIT_PACK_ZLIB
+        httpReleaseCompressedVariant(tx);
+#endif
     }
 }
 
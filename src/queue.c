@@ -588,6 +588,12 @@ PUBLIC ssize httpWriteBlock(HttpQueue *q, cchar *buf, ssize len, int flags)
     if (flags == 0) {
         flags = HTTP_BUFFER;
     }
+#if BIT_HTTP_HTTP2
+    if (conn->net && (flags & HTTP_BLOCK)) {
+        /* HTTP/2 streams share the dispatcher of the network connection and cannot wait for the socket */
+        flags = HTTP_BUFFER;
+    }
+#endif
     if (tx == 0 || tx->finalizedOutput) {
         return MPR_ERR_CANT_WRITE;
     }
@@ -14,11 +14,13 @@
 /********************************** Forwards **********************************/
 
 static bool applyRange(HttpQueue *q, HttpPacket *packet);
+static void computeRangeLength(HttpConn *conn);
 static void createRangeBoundary(HttpConn *conn);
 static HttpPacket *createRangePacket(HttpConn *conn, HttpRange *range);
 static HttpPacket *createFinalRangePacket(HttpConn *conn);
 static void outgoingRangeService(HttpQueue *q);
 static bool fixRangeLength(HttpConn *conn);
+static char *formatRangeBoundary(HttpConn *conn, HttpRange *range);
 static int matchRange(HttpConn *conn, HttpRoute *route, int dir);
 static void startRange(HttpQueue *q);
 
@@ -66,12 +68,17 @@ static void startRange(HttpQueue *q)
         The httpContentNotModified routine can set outputRanges to zero if returning not-modified.
      */
     if (tx->outputRanges == 0 || tx->status != HTTP_CODE_OK || !fixRangeLength(conn)) {
+        if (tx->length < 0 && tx->entityLength >= 0 && !conn->error) {
+            /* The entire entity is sent. The chunk filter was not used as this filter was to compute the length. */
+            tx->length = tx->entityLength;
+        }
         httpRemoveQueue(q);
     } else {
         tx->status = HTTP_CODE_PARTIAL;
-        if (tx->outputRanges->next) {
+        if (tx->outputRanges->next && !tx->rangeBoundary) {
             createRangeBoundary(conn);
         }
+        computeRangeLength(conn);
     }
 }
 
@@ -112,13 +119,18 @@ static bool applyRange(HttpQueue *q, HttpPacket *packet)
     HttpRange   *range;
     HttpConn    *conn;
     HttpTx      *tx;
-    MprOff      endPacket, length, gap, span;
-    ssize       count;
+    MprOff      endPacket, length, gap, span, count;
+    bool        sendfile;
 
     conn = q->conn;
     tx = conn->tx;
     range = tx->currentRange;
 
+    /*
+        Entity packets are not filled if using the send connector. It transmits each range directly from the file.
+     */
+    sendfile = packet->esize && tx->connector == conn->http->sendConnector;
+
     /*
         Process the data packet over multiple ranges ranges until all the data is processed or discarded.
         A packet may contain data or it may be empty with an associated entityLength. If empty, range packets
@@ -148,20 +160,21 @@ static bool applyRange(HttpQueue *q, HttpPacket *packet)
             /* In range */
             assert(range->start <= tx->rangePos && tx->rangePos < range->end);
             span = min(length, (range->end - tx->rangePos));
-            count = (ssize) min(span, q->nextQ->packetSize);
+            count = sendfile ? span : min(span, q->nextQ->packetSize);
             assert(count > 0);
-            if (!httpWillNextQueueAcceptSize(q, count)) {
+            if (!sendfile && !httpWillNextQueueAcceptSize(q, (ssize) count)) {
                 httpPutBackPacket(q, packet);
                 return 0;
             }
             if (length > count) {
                 /* Split packet if packet extends past range */
-                httpPutBackPacket(q, httpSplitPacket(packet, count));
+                httpPutBackPacket(q, httpSplitPacket(packet, (ssize) count));
             }
-            if (packet->fill && (*packet->fill)(q, packet, tx->rangePos, count) < 0) {
+            if (!sendfile && packet->fill && (*packet->fill)(q, packet, tx->rangePos, (ssize) count) < 0) {
                 return 0;
             }
-            if (tx->rangeBoundary) {
+            if (tx->rangeBoundary && tx->rangePos == range->start) {
+                /* Boundary precedes the first packet of the range */
                 httpPutPacketToNext(q, createRangePacket(conn, range));
             }
             httpPutPacketToNext(q, packet);
@@ -182,19 +195,51 @@ static bool applyRange(HttpQueue *q, HttpPacket *packet)
 static HttpPacket *createRangePacket(HttpConn *conn, HttpRange *range)
 {
     HttpPacket  *packet;
+
+    packet = httpCreatePacket(HTTP_RANGE_BUFSIZE);
+    packet->flags |= HTTP_PACKET_RANGE;
+    mprPutStringToBuf(packet->content, formatRangeBoundary(conn, range));
+    return packet;
+}
+
+
+static char *formatRangeBoundary(HttpConn *conn, HttpRange *range)
+{
     HttpTx      *tx;
     char        *length;
 
     tx = conn->tx;
-
     length = (tx->entityLength >= 0) ? itos(tx->entityLength) : "*";
-    packet = httpCreatePacket(HTTP_RANGE_BUFSIZE);
-    packet->flags |= HTTP_PACKET_RANGE;
-    mprPutToBuf(packet->content, 
-        "\r\n--%s\r\n"
-        "Content-Range: bytes %Ld-%Ld/%s\r\n\r\n",
+    return sfmt("\r\n--%s\r\nContent-Range: bytes %Ld-%Ld/%s\r\n\r\n", 
         tx->rangeBoundary, range->start, range->end - 1, length);
-    return packet;
+}
+
+
+/*
+    If the entity length is known, compute the response length so the response need not be chunked. This permits
+    the send connector to transmit the ranges from the file. This is done when the filter starts, as only then is
+    it known that the filter will handle the response. The ranges must already be fixed.
+ */
+static void computeRangeLength(HttpConn *conn)
+{
+    HttpTx      *tx;
+    HttpRange   *range;
+    MprOff      length;
+
+    tx = conn->tx;
+    if (tx->entityLength < 0) {
+        return;
+    }
+    length = 0;
+    if (tx->outputRanges->next) {
+        for (range = tx->outputRanges; range; range = range->next) {
+            length += slen(formatRangeBoundary(conn, range)) + (range->end - range->start);
+        }
+        length += slen(sfmt("\r\n--%s--\r\n", tx->rangeBoundary));
+    } else {
+        length = tx->outputRanges->end - tx->outputRanges->start;
+    }
+    tx->length = length;
 }
 
 
@@ -240,7 +285,7 @@ static bool fixRangeLength(HttpConn *conn)
     MprOff      length;
 
     tx = conn->tx;
-    length = tx->entityLength ? tx->entityLength : tx->length;
+    length = (tx->entityLength >= 0) ? tx->entityLength : tx->length;
 
     for (range = tx->outputRanges; range; range = range->next) {
         /*
@@ -249,7 +294,7 @@ static bool fixRangeLength(HttpConn *conn)
                 Range: -50              Last 50 bytes
                 Range: 1-               Skip first byte then emit the rest
          */
-        if (length) {
+        if (length > 0) {
             if (range->end > length) {
                 range->end = length;
             }
@@ -0,0 +1,688 @@
+/*
+    responseStore.c -- Persistent response cache store
+
+    Cached responses are appended as records to a memory mapped data file. An entry for each record, or for the
+    removal of a record, is appended to a companion index file. When the store is opened, the index is read to rebuild
+    the location of the live records without reading the record content. Expiry times are recorded as absolute times
+    so response lifespans are honored after the server restarts.
+
+    Records and index entries are checksummed. An index entry is written after its record so entries refer to complete
+    records. A partially written index entry ends the index. The record header and key are verified when the index is
+    loaded and the record content is verified when the record is first read. Damaged records are discarded.
+
+    When the data file is full, the live records are copied to new data and index files which then replace the
+    current files. Requests still sending responses from the previous data file retain it until they complete.
+    A store is used by one process at a time.
+
+    Copyright (c) All Rights Reserved. See copyright notice at the bottom of the file.
+ */
+
+/********************************* Includes ***********************************/
+
+#include    "http.h"
+
+#if BIT_UNIX_LIKE
+/*********************************** Locals ***********************************/
+
+#define STORE_MAGIC     0x48525331          /* Data and index file signature */
+#define RECORD_MAGIC    0x48524543          /* Record signature */
+#define COMPACT_FREE    8                   /* Compaction must free 1/8 of the store so it is not repeated each write */
+
+#define STORE_ALIGN(n)  (((n) + 7) & ~7)
+
+typedef struct StoreHeader {                /* Header of the data and index files */
+    uint32      magic;
+    uint32      stamp;                      /* Random stamp shared by a data file and its index */
+} StoreHeader;
+
+typedef struct RecordHeader {
+    uint32      magic;
+    uint32      checksum;                   /* Checksum of the record header and key */
+    uint32      contentChecksum;            /* Checksum of the content */
+    uint32      keyLen;                     /* Key length including the trailing null */
+    uint32      headerLen;                  /* Length of the response headers at the start of the content */
+    uint32      reserved;
+    int64       length;                     /* Content length */
+    int64       modified;                   /* Time the response was cached */
+    int64       expires;                    /* Time the response expires */
+} RecordHeader;
+
+typedef struct IndexEntry {
+    int64       pos;                        /* Offset of the record in the data file */
+    int64       size;                       /* Aligned record size. Zero if the record was removed */
+    int64       expires;                    /* Record expiry so expired records are not loaded */
+    uint32      reserved;
+    uint32      checksum;                   /* Checksum of the preceding fields. Must be last */
+} IndexEntry;
+
+typedef struct StoreData {                  /* Data file mapping. Unmapped when no longer referenced */
+    MprFile     *file;                      /* Data file */
+    MprFile     *indexFile;                 /* Index file */
+    char        *map;                       /* Mapped data file */
+    MprOff      size;                       /* Mapped size */
+    MprOff      end;                        /* Data file append position */
+    MprOff      indexEnd;                   /* Index file append position */
+} StoreData;
+
+typedef struct StoreEntry {
+    MprOff      pos;                        /* Offset of the record in the data file */
+    MprOff      size;                       /* Aligned record size */
+    MprTime     expires;                    /* Time the record expires */
+    int         verified;                   /* Content checksum has been verified */
+} StoreEntry;
+
+/********************************** Forwards **********************************/
+
+static int appendEntry(StoreData *sd, MprOff pos, MprOff size, MprTime expires);
+static uint checksum(cchar *buf, ssize len, uint sum);
+static int compactStore(HttpResponseStore *store, MprOff needed);
+static StoreData *createData(cchar *path, MprOff size);
+static ssize getHeaderLength(cchar *content, ssize len);
+static char *getIndexPath(cchar *path);
+static RecordHeader *getRecord(StoreData *sd, MprOff pos);
+static int loadStore(HttpResponseStore *store);
+static int lockData(StoreData *sd);
+static void manageCachedResponse(HttpCachedResponse *response, int flags);
+static void manageResponseStore(HttpResponseStore *store, int flags);
+static void manageStoreData(StoreData *sd, int flags);
+static int mapData(StoreData *sd, MprOff size);
+static uint recordChecksum(RecordHeader *rp);
+static void removeEntry(HttpResponseStore *store, cchar *key, StoreEntry *ep);
+
+/************************************ Code ************************************/
+
+PUBLIC HttpResponseStore *httpOpenResponseStore(cchar *path, MprOff maxSize)
+{
+    HttpResponseStore   *store;
+    int                 rc;
+
+    assert(path && *path);
+
+    if (maxSize <= (MprOff) (sizeof(StoreHeader) + sizeof(RecordHeader))) {
+        return 0;
+    }
+    if ((store = mprAllocObj(HttpResponseStore, manageResponseStore)) == 0) {
+        return 0;
+    }
+    store->path = sclone(path);
+    store->maxSize = maxSize;
+    store->mutex = mprCreateLock();
+    store->index = mprCreateHash(0, 0);
+
+    if ((rc = loadStore(store)) < 0) {
+        if (rc == MPR_ERR_BUSY) {
+            return 0;
+        }
+        mprLog(2, "Create response store %s", path);
+        store->index = mprCreateHash(0, 0);
+        store->liveSize = 0;
+        if ((store->data = createData(path, maxSize)) == 0) {
+            return 0;
+        }
+    }
+    return store;
+}
+
+
+static void manageResponseStore(HttpResponseStore *store, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(store->path);
+        mprMark(store->data);
+        mprMark(store->index);
+        mprMark(store->mutex);
+    }
+}
+
+
+static void manageStoreData(StoreData *sd, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(sd->file);
+        mprMark(sd->indexFile);
+
+    } else if (flags & MPR_MANAGE_FREE) {
+        if (sd->map) {
+            munmap(sd->map, (size_t) sd->size);
+        }
+    }
+}
+
+
+static void manageCachedResponse(HttpCachedResponse *response, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        /* The body is in the mapped data file */
+        mprMark(response->data);
+        mprMark(response->file);
+        mprMark(response->headers);
+    }
+}
+
+
+/*
+    Rebuild the index of live records from the index file. Only the record headers are read from the data file.
+ */
+static int loadStore(HttpResponseStore *store)
+{
+    StoreData       *sd;
+    StoreHeader     *header;
+    StoreEntry      *ep;
+    RecordHeader    *rp;
+    IndexEntry      *entries, *ip;
+    MprPath         info;
+    MprTime         now;
+    cchar           *key;
+    char            *index;
+    ssize           len;
+    MprOff          size;
+    int             count, i, rc;
+
+    if (mprGetPathInfo(store->path, &info) < 0 || (index = mprReadPathContents(getIndexPath(store->path), &len)) == 0) {
+        return MPR_ERR_CANT_READ;
+    }
+    header = (StoreHeader*) index;
+    if (len < (ssize) sizeof(StoreHeader) || header->magic != STORE_MAGIC || info.size < (MprOff) sizeof(StoreHeader)) {
+        return MPR_ERR_BAD_FORMAT;
+    }
+    if ((sd = mprAllocObj(StoreData, manageStoreData)) == 0) {
+        return MPR_ERR_MEMORY;
+    }
+    sd->file = mprOpenFile(store->path, O_RDWR | O_BINARY, 0);
+    sd->indexFile = mprOpenFile(getIndexPath(store->path), O_RDWR | O_BINARY, 0);
+    if (!sd->file || !sd->indexFile) {
+        return MPR_ERR_CANT_OPEN;
+    }
+    if ((rc = lockData(sd)) < 0) {
+        return rc;
+    }
+    size = max(info.size, store->maxSize);
+    if (size > info.size && ftruncate(sd->file->fd, size) < 0) {
+        return MPR_ERR_CANT_WRITE;
+    }
+    if ((rc = mapData(sd, size)) < 0) {
+        return rc;
+    }
+    if (((StoreHeader*) sd->map)->magic != STORE_MAGIC || ((StoreHeader*) sd->map)->stamp != header->stamp) {
+        mprError("Response store %s does not match its index", store->path);
+        return MPR_ERR_BAD_STATE;
+    }
+    sd->end = sizeof(StoreHeader);
+    now = mprGetTime();
+    entries = (IndexEntry*) &index[sizeof(StoreHeader)];
+    count = (int) ((len - sizeof(StoreHeader)) / sizeof(IndexEntry));
+
+    for (i = 0; i < count; i++) {
+        ip = &entries[i];
+        if (checksum((cchar*) ip, sizeof(IndexEntry) - sizeof(uint32), 0) != ip->checksum) {
+            /* Partially written entry */
+            break;
+        }
+        if ((rp = getRecord(sd, ip->pos)) == 0 || (ip->size && ip->size != STORE_ALIGN(sizeof(RecordHeader) +
+                rp->keyLen + rp->length))) {
+            mprLog(2, "Skip damaged record at %Ld in response store %s", ip->pos, store->path);
+            continue;
+        }
+        key = (cchar*) &rp[1];
+        if ((ep = mprLookupKey(store->index, key)) != 0) {
+            if (ip->size == 0 && ep->pos != ip->pos) {
+                continue;
+            }
+            /* Superseded or removed */
+            store->liveSize -= ep->size;
+            mprRemoveKey(store->index, key);
+        }
+        if (ip->size == 0) {
+            continue;
+        }
+        sd->end = max(sd->end, ip->pos + ip->size);
+        if (ip->expires <= now) {
+            continue;
+        }
+        if ((ep = mprAllocStruct(StoreEntry)) == 0) {
+            return MPR_ERR_MEMORY;
+        }
+        ep->pos = ip->pos;
+        ep->size = ip->size;
+        ep->expires = ip->expires;
+        mprAddKey(store->index, key, ep);
+        store->liveSize += ep->size;
+    }
+    sd->indexEnd = sizeof(StoreHeader) + (MprOff) i * sizeof(IndexEntry);
+    if (sd->indexEnd < len) {
+        mprLog(2, "Truncate response store index %s at entry %d", store->path, i);
+        if (ftruncate(sd->indexFile->fd, sd->indexEnd) < 0) {
+            return MPR_ERR_CANT_WRITE;
+        }
+    }
+    store->data = sd;
+    mprLog(3, "Loaded %d responses from response store %s", mprGetHashLength(store->index), store->path);
+    return 0;
+}
+
+
+/*
+    Create an empty data file and index
+ */
+static StoreData *createData(cchar *path, MprOff size)
+{
+    StoreData   *sd;
+    StoreHeader header;
+
+    if ((sd = mprAllocObj(StoreData, manageStoreData)) == 0) {
+        return 0;
+    }
+    if ((sd->file = mprOpenFile(path, O_RDWR | O_CREAT | O_BINARY, 0600)) == 0) {
+        mprError("Cannot create response store %s, errno %d", path, errno);
+        return 0;
+    }
+    if (lockData(sd) < 0) {
+        return 0;
+    }
+    if ((sd->indexFile = mprOpenFile(getIndexPath(path), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0600)) == 0) {
+        mprError("Cannot create response store index for %s, errno %d", path, errno);
+        return 0;
+    }
+    header.magic = STORE_MAGIC;
+    mprGetRandomBytes((char*) &header.stamp, sizeof(header.stamp), 0);
+    if (ftruncate(sd->file->fd, 0) < 0 || ftruncate(sd->file->fd, size) < 0 ||
+            pwrite(sd->file->fd, &header, sizeof(header), 0) != sizeof(header) ||
+            pwrite(sd->indexFile->fd, &header, sizeof(header), 0) != sizeof(header)) {
+        mprError("Cannot write response store %s, errno %d", path, errno);
+        return 0;
+    }
+    sd->end = sd->indexEnd = sizeof(StoreHeader);
+    if (mapData(sd, size) < 0) {
+        return 0;
+    }
+    return sd;
+}
+
+
+static int lockData(StoreData *sd)
+{
+    struct flock    fl;
+
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = F_WRLCK;
+    fl.l_whence = SEEK_SET;
+    if (fcntl(sd->file->fd, F_SETLK, &fl) < 0) {
+        mprError("Response store %s is in use by another process", sd->file->path);
+        return MPR_ERR_BUSY;
+    }
+    return 0;
+}
+
+
+/*
+    Map the data file for reading. Records are written via the file descriptor.
+ */
+static int mapData(StoreData *sd, MprOff size)
+{
+    char    *map;
+
+    if ((map = mmap(0, (size_t) size, PROT_READ, MAP_SHARED, sd->file->fd, 0)) == MAP_FAILED) {
+        mprError("Cannot map response store %s, errno %d", sd->file->path, errno);
+        return MPR_ERR_CANT_INITIALIZE;
+    }
+    sd->map = map;
+    sd->size = size;
+    return 0;
+}
+
+
+/*
+    Return a record if the header and key are intact
+ */
+static RecordHeader *getRecord(StoreData *sd, MprOff pos)
+{
+    RecordHeader    *rp;
+    MprOff          end;
+
+    if (pos < (MprOff) sizeof(StoreHeader) || (pos & 7) || (pos + (MprOff) sizeof(RecordHeader)) > sd->size) {
+        return 0;
+    }
+    rp = (RecordHeader*) &sd->map[pos];
+    end = pos + sizeof(RecordHeader) + rp->keyLen;
+    if (rp->magic != RECORD_MAGIC || rp->keyLen == 0 || end > sd->size || rp->length < rp->headerLen ||
+            rp->length > sd->size - end || sd->map[end - 1] != '\0' || recordChecksum(rp) != rp->checksum) {
+        return 0;
+    }
+    return rp;
+}
+
+
+PUBLIC HttpCachedResponse *httpReadResponseStore(HttpResponseStore *store, cchar *key)
+{
+    HttpCachedResponse  *response;
+    StoreData           *sd;
+    StoreEntry          *ep;
+    RecordHeader        *rp;
+    cchar               *content;
+    MprTime             now;
+
+    now = mprGetTime();
+    lock(store);
+    if ((ep = mprLookupKey(store->index, key)) == 0) {
+        unlock(store);
+        return 0;
+    }
+    sd = store->data;
+    rp = (RecordHeader*) &sd->map[ep->pos];
+    content = (cchar*) &rp[1] + rp->keyLen;
+    if (ep->expires <= now) {
+        removeEntry(store, key, ep);
+        unlock(store);
+        return 0;
+    }
+    if (!ep->verified) {
+        if (checksum(content, (ssize) rp->length, 0) != rp->contentChecksum) {
+            mprError("Discard damaged response for %s in response store %s", key, store->path);
+            removeEntry(store, key, ep);
+            unlock(store);
+            return 0;
+        }
+        ep->verified = 1;
+    }
+    if ((response = mprAllocObj(HttpCachedResponse, manageCachedResponse)) == 0) {
+        unlock(store);
+        return 0;
+    }
+    response->data = sd;
+    response->file = sd->file;
+    response->headers = snclone(content, rp->headerLen);
+    response->body = &content[rp->headerLen];
+    response->pos = ep->pos + sizeof(RecordHeader) + rp->keyLen + rp->headerLen;
+    response->length = (ssize) (rp->length - rp->headerLen);
+    response->modified = rp->modified;
+    unlock(store);
+    return response;
+}
+
+
+PUBLIC int httpWriteResponseStore(HttpResponseStore *store, cchar *key, cchar *content, ssize len, MprTime modified,
+    MprTicks lifespan)
+{
+    StoreData       *sd;
+    StoreEntry      *ep;
+    RecordHeader    *rp;
+    char            *record, *cp;
+    ssize           keyLen, size;
+    int             rc;
+
+    keyLen = slen(key) + 1;
+    size = STORE_ALIGN(sizeof(RecordHeader) + keyLen + len);
+    if (len < 0 || size > (store->maxSize - (MprOff) sizeof(StoreHeader))) {
+        return MPR_ERR_WONT_FIT;
+    }
+    if ((record = mprAlloc(size)) == 0) {
+        return MPR_ERR_MEMORY;
+    }
+    memset(record, 0, sizeof(RecordHeader));
+    rp = (RecordHeader*) record;
+    rp->magic = RECORD_MAGIC;
+    rp->keyLen = (uint32) keyLen;
+    rp->headerLen = (uint32) getHeaderLength(content, len);
+    rp->length = len;
+    rp->modified = modified;
+    rp->expires = mprGetTime() + lifespan;
+    cp = &record[sizeof(RecordHeader)];
+    memcpy(cp, key, keyLen);
+    cp += keyLen;
+    memcpy(cp, content, len);
+    memset(&cp[len], 0, size - (cp + len - record));
+    rp->contentChecksum = checksum(cp, len, 0);
+    rp->checksum = recordChecksum(rp);
+
+    lock(store);
+    if (store->data == 0) {
+        unlock(store);
+        return MPR_ERR_BAD_STATE;
+    }
+    if ((((StoreData*) store->data)->end + size) > ((StoreData*) store->data)->size &&
+            (rc = compactStore(store, size)) < 0) {
+        unlock(store);
+        return rc;
+    }
+    sd = store->data;
+    if (pwrite(sd->file->fd, record, size, sd->end) != size || appendEntry(sd, sd->end, size, rp->expires) < 0) {
+        unlock(store);
+        mprError("Cannot write to response store %s, errno %d", store->path, errno);
+        return MPR_ERR_CANT_WRITE;
+    }
+    if ((ep = mprLookupKey(store->index, key)) != 0) {
+        store->liveSize -= ep->size;
+    } else {
+        if ((ep = mprAllocStruct(StoreEntry)) == 0) {
+            unlock(store);
+            return MPR_ERR_MEMORY;
+        }
+        mprAddKey(store->index, key, ep);
+    }
+    ep->pos = sd->end;
+    ep->size = size;
+    ep->expires = rp->expires;
+    ep->verified = 1;
+    store->liveSize += size;
+    sd->end += size;
+    unlock(store);
+    return 0;
+}
+
+
+PUBLIC bool httpRemoveResponseStore(HttpResponseStore *store, cchar *key)
+{
+    StoreEntry  *ep;
+
+    lock(store);
+    if ((ep = mprLookupKey(store->index, key)) == 0) {
+        unlock(store);
+        return 0;
+    }
+    removeEntry(store, key, ep);
+    unlock(store);
+    return 1;
+}
+
+
+/*
+    Record the removal in the index. Caller must hold the lock.
+ */
+static void removeEntry(HttpResponseStore *store, cchar *key, StoreEntry *ep)
+{
+    appendEntry(store->data, ep->pos, 0, 0);
+    store->liveSize -= ep->size;
+    mprRemoveKey(store->index, key);
+}
+
+
+static int appendEntry(StoreData *sd, MprOff pos, MprOff size, MprTime expires)
+{
+    IndexEntry  entry;
+
+    memset(&entry, 0, sizeof(entry));
+    entry.pos = pos;
+    entry.size = size;
+    entry.expires = expires;
+    entry.checksum = checksum((cchar*) &entry, sizeof(IndexEntry) - sizeof(uint32), 0);
+    if (pwrite(sd->indexFile->fd, &entry, sizeof(entry), sd->indexEnd) != sizeof(entry)) {
+        return MPR_ERR_CANT_WRITE;
+    }
+    sd->indexEnd += sizeof(entry);
+    return 0;
+}
+
+
+/*
+    Copy the current records to new data and index files which then replace the current files. If the server stops
+    before both files are replaced, the files will not match and the store is recreated when next opened.
+    Caller must hold the lock.
+ */
+static int compactStore(HttpResponseStore *store, MprOff needed)
+{
+    StoreData   *sd, *prior;
+    StoreEntry  *ep, *np;
+    MprHash     *index;
+    MprKey      *kp;
+    MprTime     now;
+    MprOff      live;
+    char        *path;
+
+    prior = store->data;
+    now = mprGetTime();
+    live = 0;
+    for (ITERATE_KEYS(store->index, kp)) {
+        ep = (StoreEntry*) kp->data;
+        if (ep->expires > now) {
+            live += ep->size;
+        }
+    }
+    if ((MprOff) sizeof(StoreHeader) + live + needed > store->maxSize - store->maxSize / COMPACT_FREE) {
+        mprLog(3, "Response store %s is full", store->path);
+        return MPR_ERR_WONT_FIT;
+    }
+    path = sjoin(store->path, ".tmp", NULL);
+    if ((sd = createData(path, store->maxSize)) == 0) {
+        return MPR_ERR_CANT_CREATE;
+    }
+    index = mprCreateHash(0, 0);
+    for (ITERATE_KEYS(store->index, kp)) {
+        ep = (StoreEntry*) kp->data;
+        if (ep->expires <= now) {
+            continue;
+        }
+        if (pwrite(sd->file->fd, &prior->map[ep->pos], (size_t) ep->size, sd->end) != ep->size ||
+                appendEntry(sd, sd->end, ep->size, ep->expires) < 0) {
+            mprError("Cannot compact response store %s, errno %d", store->path, errno);
+            unlink(path);
+            unlink(getIndexPath(path));
+            return MPR_ERR_CANT_WRITE;
+        }
+        if ((np = mprAllocStruct(StoreEntry)) == 0) {
+            return MPR_ERR_MEMORY;
+        }
+        *np = *ep;
+        np->pos = sd->end;
+        mprAddKey(index, kp->key, np);
+        sd->end += ep->size;
+    }
+    if (rename(path, store->path) < 0 || rename(getIndexPath(path), getIndexPath(store->path)) < 0) {
+        mprError("Cannot replace response store %s, errno %d", store->path, errno);
+        return MPR_ERR_CANT_WRITE;
+    }
+    mprLog(3, "Compacted response store %s from %Ld to %Ld bytes", store->path, prior->end, sd->end);
+    store->data = sd;
+    store->index = index;
+    store->liveSize = live;
+    return 0;
+}
+
+
+/*
+    Return the length of the headers preceding the body. Headers are separated from the body by a blank line.
+ */
+static ssize getHeaderLength(cchar *content, ssize len)
+{
+    cchar   *cp, *end;
+
+    for (cp = content, end = &content[len - 1]; cp < end && *cp; cp++) {
+        if (cp[0] == '\n' && cp[1] == '\n') {
+            return cp - content + 2;
+        }
+    }
+    return 0;
+}
+
+
+static char *getIndexPath(cchar *path)
+{
+    return sjoin(path, ".index", NULL);
+}
+
+
+static uint recordChecksum(RecordHeader *rp)
+{
+    RecordHeader    header;
+
+    header = *rp;
+    header.checksum = 0;
+    return checksum((cchar*) &rp[1], rp->keyLen, checksum((cchar*) &header, sizeof(header), 0));
+}
+
+
+/*
+    FNV-1a hash. Pass the prior result as the sum to checksum several blocks.
+ */
+static uint checksum(cchar *buf, ssize len, uint sum)
+{
+    uchar   *cp, *end;
+
+    if (sum == 0) {
+        sum = 2166136261U;
+    }
+    for (cp = (uchar*) buf, end = &cp[len]; cp < end; cp++) {
+        sum = (sum ^ *cp) * 16777619;
+    }
+    return sum;
+}
+
+#else /* !BIT_UNIX_LIKE */
+
+PUBLIC HttpResponseStore *httpOpenResponseStore(cchar *path, MprOff maxSize)
+{
+    mprError("Persistent response stores are not supported on this platform");
+    return 0;
+}
+
+
+PUBLIC HttpCachedResponse *httpReadResponseStore(HttpResponseStore *store, cchar *key)
+{
+    return 0;
+}
+
+
+PUBLIC bool httpRemoveResponseStore(HttpResponseStore *store, cchar *key)
+{
+    return 0;
+}
+
+
+PUBLIC int httpWriteResponseStore(HttpResponseStore *store, cchar *key, cchar *content, ssize len, MprTime modified,
+    MprTicks lifespan)
+{
+    return MPR_ERR_BAD_STATE;
+}
+#endif /* BIT_UNIX_LIKE */
+
+
+PUBLIC int httpSetPersistentCache(HttpHost *host, cchar *path, MprOff maxSize)
+{
+    HttpResponseStore   *store;
+
+    if ((store = httpOpenResponseStore(path, maxSize)) == 0) {
+        return MPR_ERR_CANT_OPEN;
+    }
+    host->responseStore = store;
+    return 0;
+}
+
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details and other copyrights.
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -51,6 +51,7 @@ static int matchRequestUri(HttpConn *conn, HttpRoute *route);
 static int matchRoute(HttpConn *conn, HttpRoute *route);
 static char *qualifyName(HttpRoute *route, cchar *service, cchar *name);
 static int selectHandler(HttpConn *conn, HttpRoute *route);
+static void setMethodMask(HttpRoute *route);
 static int testCondition(HttpConn *conn, HttpRoute *route, HttpRouteOp *condition);
 static char *trimQuotes(char *str);
 static int updateRequest(HttpConn *conn, HttpRoute *route, HttpRouteOp *update);
@@ -141,11 +142,14 @@ PUBLIC HttpRoute *httpCreateInheritedRoute(HttpRoute *parent)
     route->languages = parent->languages;
     route->lifespan = parent->lifespan;
     route->methods = parent->methods;
+    route->methodMask = parent->methodMask;
     route->outputStages = parent->outputStages;
     route->params = parent->params;
     route->parent = parent;
     route->vars = parent->vars;
     route->map = parent->map;
+    route->compressLevel = parent->compressLevel;
+    route->compressMin = parent->compressMin;
     route->mappings = parent->mappings;
     route->pattern = parent->pattern;
     route->patternCompiled = parent->patternCompiled;
@@ -282,6 +286,9 @@ PUBLIC HttpRoute *httpCreateConfiguredRoute(HttpHost *host, int serverSide)
      */
     route = httpCreateRoute(host);
     http = route->http;
+#if BIT_PACK_ZLIB
+    httpAddRouteFilter(route, http->compressFilter->name, NULL, HTTP_STAGE_TX);
+#endif
     httpAddRouteFilter(route, http->rangeFilter->name, NULL, HTTP_STAGE_TX);
     httpAddRouteFilter(route, http->chunkFilter->name, NULL, HTTP_STAGE_RX | HTTP_STAGE_TX);
 #if BIT_HTTP_WEB_SOCKETS
@@ -469,6 +476,7 @@ static int matchRoute(HttpConn *conn, HttpRoute *route)
 static int matchRequestUri(HttpConn *conn, HttpRoute *route)
 {
     HttpRx      *rx;
+    int         methodFlag;
 
     assert(conn);
     assert(route);
@@ -495,12 +503,12 @@ static int matchRequestUri(HttpConn *conn, HttpRoute *route)
         return HTTP_ROUTE_REJECT;
     }
     mprTrace(6, "Check route methods \"%s\"", route->name);
-    if (!mprLookupKey(route->methods, rx->method)) {
-        if (!mprLookupKey(route->methods, "*")) {
-            if (!(rx->flags & HTTP_HEAD && mprLookupKey(route->methods, "GET"))) {
-                return HTTP_ROUTE_REJECT;
-            }
+    if ((methodFlag = rx->flags & HTTP_METHOD_MASK) != 0) {
+        if (!(route->methodMask & methodFlag) && !(methodFlag & HTTP_HEAD && route->methodMask & HTTP_GET)) {
+            return HTTP_ROUTE_REJECT;
         }
+    } else if (!mprLookupKey(route->methods, rx->method) && !mprLookupKey(route->methods, "*")) {
+        return HTTP_ROUTE_REJECT;
     }
     rx->route = route;
     return HTTP_ROUTE_OK;
@@ -657,6 +665,7 @@ PUBLIC void httpMapFile(HttpConn *conn, HttpRoute *route)
     HttpLang    *lang;
     MprPath     *info;
     MprList     *extensions;
+    cchar       *etag;
     char        *mapped, *ext, *path;
     int         next;
     bool        acceptGzip, zipped;
@@ -671,6 +680,7 @@ PUBLIC void httpMapFile(HttpConn *conn, HttpRoute *route)
     assert(rx->target);
     tx->filename = rx->target;
     info = &tx->fileInfo;
+    etag = 0;
 
     if (lang && lang->path) {
         tx->filename = mprJoinPath(lang->path, tx->filename);
@@ -693,7 +703,7 @@ PUBLIC void httpMapFile(HttpConn *conn, HttpRoute *route)
                     continue;
                 }
                 path = mprReplacePathExt(tx->filename, ext);
-                if (mprGetPathInfo(path, info) == 0) {
+                if (httpGetCachedPathInfo(conn, path, info, &etag) == 0) {
                     tx->filename = path;
                     mprAddKey(route->mappings, tx->filename, path);
                     if (zipped) {
@@ -711,20 +721,23 @@ PUBLIC void httpMapFile(HttpConn *conn, HttpRoute *route)
     }
     tx->ext = httpGetExt(conn);
     if (!info->valid) {
-        mprGetPathInfo(tx->filename, info);
+        httpGetCachedPathInfo(conn, tx->filename, info, &etag);
     }
 #if DEPRECATE || 1
     /* Deprecated in 4.4 */
     if (!info->valid && !route->map && (route->flags & HTTP_ROUTE_GZIP) && scontains(rx->acceptEncoding, "gzip")) {
         path = sjoin(tx->filename, ".gz", NULL);
-        if (mprGetPathInfo(path, info) == 0) {
+        if (httpGetCachedPathInfo(conn, path, info, &etag) == 0) {
             tx->filename = path;
         }
     }
 #endif
     if (info->valid) {
-        tx->etag = sfmt("\"%Lx-%Lx-%Lx\"", (int64) info->inode, (int64) info->size, (int64) info->mtime);
+        tx->etag = etag ? (char*) etag : sfmt("\"%Lx-%Lx-%Lx\"", (int64) info->inode, (int64) info->size, (int64) info->mtime);
     }
+#if BIT_PACK_ZLIB
+    httpMapCompressedVariant(conn, route);
+#endif
     mprTrace(7, "mapFile uri \"%s\", filename: \"%s\", extension: \"%s\"", rx->uri, tx->filename, tx->ext);
 }
 
@@ -1220,6 +1233,14 @@ PUBLIC void httpSetRouteDir(HttpRoute *route, cchar *path)
 #endif
 
 
+PUBLIC void httpSetRouteDynamicCompression(HttpRoute *route, int level, ssize minSize)
+{
+    assert(route);
+    route->compressLevel = max(0, min(level, 9));
+    route->compressMin = max(minSize, 0);
+}
+
+
 PUBLIC void httpSetRouteFlags(HttpRoute *route, int flags)
 {
     assert(route);
@@ -1311,6 +1332,7 @@ PUBLIC void httpAddRouteMethods(HttpRoute *route, cchar *methods)
     while ((method = stok(tok, ", \t\n\r", &tok)) != 0) {
         mprAddKey(route->methods, method, LTOP(1));
     }
+    setMethodMask(route);
 }
 
 
@@ -1319,10 +1341,13 @@ PUBLIC void httpRemoveRouteMethods(HttpRoute *route, cchar *methods)
     char    *method, *tok;
 
     assert(route);
+    /* Inherited methods are shared with the parent. Copy before removing so the parent method mask stays valid */
+    GRADUATE_HASH(route, methods);
     tok = sclone(methods);
     while ((method = stok(tok, ", \t\n\r", &tok)) != 0) {
         mprRemoveKey(route->methods, method);
     }
+    setMethodMask(route);
 }
 
 PUBLIC void httpSetRouteMethods(HttpRoute *route, cchar *methods)
@@ -1332,6 +1357,22 @@ PUBLIC void httpSetRouteMethods(HttpRoute *route, cchar *methods)
 }
 
 
+/*
+    Compute the rx method flags matched by the route. Other methods are matched via the methods hash.
+ */
+static void setMethodMask(HttpRoute *route)
+{
+    MprKey  *kp;
+    int     mask;
+
+    mask = 0;
+    for (ITERATE_KEYS(route->methods, kp)) {
+        mask |= smatch(kp->key, "*") ? HTTP_METHOD_MASK : httpGetMethodFlag(kp->key);
+    }
+    route->methodMask = mask;
+}
+
+
 PUBLIC void httpSetRouteName(HttpRoute *route, cchar *name)
 {
     assert(route);
@@ -1988,7 +2029,7 @@ PUBLIC char *httpTemplate(HttpConn *conn, cchar *template, MprHash *options)
                 sncopy(key, sizeof(key), cp, ep - cp);
                 if (options && (value = httpGetOption(options, key, 0)) != 0) {
                     mprPutStringToBuf(buf, value);
-                } else if ((value = mprLookupKey(conn->rx->params, key)) != 0) {
+                } else if ((value = httpGetParam(conn, key, 0)) != 0) {
                     mprPutStringToBuf(buf, value);
                 }
                 if (value == 0) {
@@ -47,7 +47,7 @@ PUBLIC HttpRx *httpCreateRx(HttpConn *conn)
     rx->pathInfo = sclone("/");
     rx->scriptName = mprEmptyString();
     rx->needInputPipeline = !conn->endpoint;
-    rx->headers = mprCreateHash(HTTP_SMALL_HASH_SIZE, MPR_HASH_CASELESS);
+    rx->headers = mprCreateHash(HTTP_SMALL_HASH_SIZE, MPR_HASH_CASELESS | MPR_HASH_OPEN);
     rx->chunkState = HTTP_CHUNK_UNCHUNKED;
     rx->traceLevel = -1;
     return rx;
@@ -95,6 +95,8 @@ static void manageRx(HttpRx *rx, int flags)
         mprMark(rx->files);
         mprMark(rx->uploadDir);
         mprMark(rx->paramString);
+        mprMark(rx->paramIndex);
+        mprMark(rx->jsonTape);
         mprMark(rx->lang);
         mprMark(rx->target);
         mprMark(rx->upgrade);
@@ -238,6 +240,11 @@ static bool parseIncoming(HttpConn *conn, HttpPacket *packet)
     if (!parseHeaders(conn, packet)) {
         return 0;
     }
+#if BIT_HTTP_HTTP2
+    if (conn->endpoint && rx->upgrade && !conn->error && httpUpgradeHttp2(conn)) {
+        return 0;
+    }
+#endif
     if (conn->endpoint) {
         httpMatchHost(conn);
         setParsedUri(conn);
@@ -307,7 +314,7 @@ static void traceRequest(HttpConn *conn, HttpPacket *packet)
     if ((cp = schr(content->start, ' ')) != 0) {
         if ((cp = schr(++cp, ' ')) != 0) {
             for (ext = --cp; ext > content->start && *ext != '.'; ext--) ;
-            ext = (*ext == '.') ? snclone(&ext[1], cp - ext) : 0;
+            ext = (*ext == '.') ? httpInternBlock(&ext[1], cp - ext) : 0;
             conn->tx->ext = ext;
         }
     }
@@ -335,56 +342,66 @@ static void traceRequest(HttpConn *conn, HttpPacket *packet)
 static void parseMethod(HttpConn *conn)
 {
     HttpRx      *rx;
-    cchar       *method;
-    int         methodFlags;
+    int         methodFlag;
 
     rx = conn->rx;
-    method = rx->method;
-    methodFlags = 0;
+    methodFlag = httpGetMethodFlag(rx->method);
+    if (methodFlag & (HTTP_POST | HTTP_PUT)) {
+        rx->needInputPipeline = 1;
+    }
+    rx->flags |= methodFlag;
+}
 
+
+/*
+    Map a method name to its rx method flag. Returns zero for other methods.
+ */
+PUBLIC int httpGetMethodFlag(cchar *method)
+{
+    if (method == 0) {
+        return 0;
+    }
     switch (method[0]) {
     case 'D':
         if (strcmp(method, "DELETE") == 0) {
-            methodFlags = HTTP_DELETE;
+            return HTTP_DELETE;
         }
         break;
 
     case 'G':
         if (strcmp(method, "GET") == 0) {
-            methodFlags = HTTP_GET;
+            return HTTP_GET;
         }
         break;
 
     case 'H':
         if (strcmp(method, "HEAD") == 0) {
-            methodFlags = HTTP_HEAD;
+            return HTTP_HEAD;
         }
         break;
 
     case 'O':
         if (strcmp(method, "OPTIONS") == 0) {
-            methodFlags = HTTP_OPTIONS;
+            return HTTP_OPTIONS;
         }
         break;
 
     case 'P':
         if (strcmp(method, "POST") == 0) {
-            methodFlags = HTTP_POST;
-            rx->needInputPipeline = 1;
+            return HTTP_POST;
 
         } else if (strcmp(method, "PUT") == 0) {
-            methodFlags = HTTP_PUT;
-            rx->needInputPipeline = 1;
+            return HTTP_PUT;
         }
         break;
 
     case 'T':
         if (strcmp(method, "TRACE") == 0) {
-            methodFlags = HTTP_TRACE;
+            return HTTP_TRACE;
         }
         break;
     }
-    rx->flags |= methodFlags;
+    return 0;
 }
 
 
@@ -396,7 +413,7 @@ static bool parseRequestLine(HttpConn *conn, HttpPacket *packet)
 {
     HttpRx      *rx;
     HttpLimits  *limits;
-    char        *uri, *protocol;
+    char        *method, *uri, *protocol;
     ssize       len;
 
     rx = conn->rx;
@@ -418,7 +435,11 @@ static bool parseRequestLine(HttpConn *conn, HttpPacket *packet)
         httpMonitorEvent(conn, HTTP_COUNTER_REQUESTS, 1);
     }
     traceRequest(conn, packet);
-    rx->originalMethod = rx->method = supper(getToken(conn, 0));
+    method = getToken(conn, 0);
+    if ((rx->method = (char*) httpLookupAtom(method)) == 0) {
+        rx->method = supper(method);
+    }
+    rx->originalMethod = rx->method;
     parseMethod(conn);
 
     uri = getToken(conn, 0);
@@ -431,7 +452,11 @@ static bool parseRequestLine(HttpConn *conn, HttpPacket *packet)
             "Bad request. URI too long. Length %d vs limit %d", len, limits->uriSize);
         return 0;
     }
-    protocol = conn->protocol = supper(getToken(conn, "\r\n"));
+    protocol = getToken(conn, "\r\n");
+    if ((conn->protocol = (char*) httpLookupAtom(protocol)) == 0) {
+        conn->protocol = supper(protocol);
+    }
+    protocol = conn->protocol;
     if (strcmp(protocol, "HTTP/1.0") == 0) {
         if (rx->flags & (HTTP_POST|HTTP_PUT)) {
             rx->remainingContent = MAXINT;
@@ -441,6 +466,11 @@ static bool parseRequestLine(HttpConn *conn, HttpPacket *packet)
         conn->protocol = protocol;
     } else if (strcmp(protocol, "HTTP/1.1") == 0) {
         conn->protocol = protocol;
+#if BIT_HTTP_HTTP2
+    } else if (strcmp(protocol, "HTTP/2.0") == 0 && conn->net) {
+        /* Request line synthesized for an HTTP/2 stream */
+        conn->protocol = protocol;
+#endif
     } else {
         conn->protocol = sclone("HTTP/1.1");
         httpBadRequestError(conn, HTTP_ABORT | HTTP_CODE_NOT_ACCEPTABLE, "Unsupported HTTP protocol");
@@ -519,7 +549,7 @@ static bool parseHeaders(HttpConn *conn, HttpPacket *packet)
     HttpLimits  *limits;
     MprBuf      *content;
     char        *cp, *key, *value, *tok, *hvalue;
-    cchar       *oldValue;
+    cchar       *atom, *oldValue;
     int         count, keepAliveHeader;
 
     rx = conn->rx;
@@ -552,7 +582,11 @@ static bool parseHeaders(HttpConn *conn, HttpPacket *packet)
         } else {
             hvalue = sclone(value);
         }
-        mprAddKey(rx->headers, key, hvalue);
+        if ((atom = httpLookupAtom(key)) != 0) {
+            mprAddSharedKey(rx->headers, atom, hvalue);
+        } else {
+            mprAddKey(rx->headers, key, hvalue);
+        }
 
         switch (tolower((uchar) key[0])) {
         case 'a':
@@ -644,7 +678,7 @@ static bool parseHeaders(HttpConn *conn, HttpPacket *packet)
                 rx->inputRange = httpCreateRange(conn, start, end);
 
             } else if (strcasecmp(key, "content-type") == 0) {
-                rx->mimeType = sclone(value);
+                rx->mimeType = (char*) httpIntern(value);
                 if (rx->flags & (HTTP_POST | HTTP_PUT)) {
                     if (conn->endpoint) {
                         rx->form = scontains(rx->mimeType, "application/x-www-form-urlencoded") != 0;
@@ -901,6 +935,9 @@ static bool processParsed(HttpConn *conn)
             if (!rx->upload) {
                 httpStartPipeline(conn);
             }
+        } else if ((rx->flags & (HTTP_POST | HTTP_PUT)) && sstarts(rx->mimeType, "application/json")) {
+            /* Parse the buffered JSON body as it arrives */
+            rx->jsonTape = mprCreateJsonTape(rx->length);
         }
 #if BIT_HTTP_WEB_SOCKETS
     } else {
@@ -1023,6 +1060,9 @@ static bool processContent(HttpConn *conn)
         if (conn->state < HTTP_STATE_COMPLETE) {
             if (rx->inputPipeline) {
                 httpPutPacketToNext(q, packet);
+            } else if (rx->jsonTape) {
+                /* The tape holds the JSON body. The packet is consumed so the body is only held once. */
+                mprWriteJsonTape(rx->jsonTape, mprGetBufStart(packet->content), httpGetPacketLength(packet));
             } else {
                 httpPutForService(q, packet, HTTP_DELAY_SERVICE);
             }
@@ -1035,6 +1075,12 @@ static bool processContent(HttpConn *conn)
         if (conn->state < HTTP_STATE_FINALIZED) {
             if (conn->endpoint) {
                 if (!rx->route) {
+                    if (rx->jsonTape && rx->jsonTape->length > 0) {
+                        /* Pass the tape document to the handler as the body without copying */
+                        packet = httpCreateDataPacket(0);
+                        packet->content = mprGetJsonTapeBuf(rx->jsonTape);
+                        httpPutForService(q, packet, HTTP_DELAY_SERVICE);
+                    }
                     httpAddBodyParams(conn);
                     mapMethod(conn);
                     httpRouteRequest(conn);
@@ -1473,7 +1519,8 @@ PUBLIC char *httpGetStatusMessage(HttpConn *conn)
 
 PUBLIC void httpSetMethod(HttpConn *conn, cchar *method)
 {
-    conn->rx->method = sclone(method);
+    conn->rx->method = (char*) httpIntern(method);
+    conn->rx->flags &= ~HTTP_METHOD_MASK;
     parseMethod(conn);
 }
 
@@ -1801,7 +1848,7 @@ PUBLIC void httpSetStageData(HttpConn *conn, cchar *key, cvoid *data)
 
     rx = conn->rx;
     if (rx->requestData == 0) {
-        rx->requestData = mprCreateHash(-1, 0);
+        rx->requestData = mprCreateHash(-1, MPR_HASH_OPEN);
     }
     mprAddKey(rx->requestData, key, data);
 }
@@ -1824,11 +1871,10 @@ PUBLIC char *httpGetPathExt(cchar *path)
     char    *ep, *ext;
 
     if ((ext = strrchr(path, '.')) != 0) {
-        ext = sclone(++ext);
-        for (ep = ext; *ep && isalnum((uchar) *ep); ep++) {
+        for (ep = ++ext; *ep && isalnum((uchar) *ep); ep++) {
             ;
         }
-        *ep = '\0';
+        ext = (char*) httpInternBlock(ext, ep - ext);
     }
     return ext;
 }
@@ -3,7 +3,11 @@
 
     The Sendfile connector supports the optimized transmission of whole static files. It uses operating system 
     sendfile APIs to eliminate reading the document into user space and multiple socket writes. The send connector 
-    is not a general purpose connector. It cannot handle dynamic data or ranged requests. It does support chunked requests.
+    is not a general purpose connector. It cannot handle dynamic data. It does support chunked requests and ranged
+    requests: the range filter passes each range as a file region and multipart boundaries are written via the I/O
+    vector before each region.
+    Over SSL, it is only used if the socket has kernel TLS transmit enabled (MPR_SOCKET_KTLS_TX) so the kernel encrypts
+    the file data. Otherwise the net connector is used and the SSL provider encrypts in user space.
 
     Copyright (c) All Rights Reserved. See details at the end of the file.
  */
@@ -55,6 +59,10 @@ PUBLIC void httpSendOpen(HttpQueue *q)
         tx->connector->open(q);
         return;
     }
+    if (tx->cachedResponse) {
+        /* The cache handler sends the response from the response store data file */
+        return;
+    }
     if (!(tx->flags & HTTP_TX_NO_BODY)) {
         assert(tx->fileInfo.valid);
         if (tx->fileInfo.size > conn->limits->transmissionBodySize) {
@@ -62,7 +70,11 @@ PUBLIC void httpSendOpen(HttpQueue *q)
                 "Http transmission aborted. File size exceeds max body of %,Ld bytes", conn->limits->transmissionBodySize);
             return;
         }
-        tx->file = mprOpenFile(tx->filename, O_RDONLY | O_BINARY, 0);
+        if ((tx->fileData = httpGetCachedFileData(conn, tx->filename)) != 0) {
+            /* Small file content is sent from memory */
+            return;
+        }
+        tx->file = httpOpenCachedFile(conn, tx->filename);
         if (tx->file == 0) {
             httpError(conn, HTTP_CODE_NOT_FOUND, "Cannot open document: %s, err %d", tx->filename, mprGetError());
         }
@@ -76,7 +88,9 @@ static void sendClose(HttpQueue *q)
 
     tx = q->conn->tx;
     if (tx->file) {
-        mprCloseFile(tx->file);
+        if (!(tx->flags & HTTP_TX_SHARED_FILE)) {
+            mprCloseFile(tx->file);
+        }
         tx->file = 0;
     }
 }
@@ -87,7 +101,7 @@ PUBLIC void httpSendOutgoingService(HttpQueue *q)
     HttpConn    *conn;
     HttpTx      *tx;
     MprFile     *file;
-    MprOff      written;
+    MprOff      count, written;
     int         errCode;
 
     conn = q->conn;
@@ -109,35 +123,44 @@ PUBLIC void httpSendOutgoingService(HttpQueue *q)
             return;
         }
     }
-    if (q->ioIndex == 0) {
-        buildSendVec(q);
-    }
     /*
-        No need to loop around as send file tries to write as much of the file as possible. 
-        If not eof, will always have the socket blocked.
+        Each pass writes the pending vector entries followed by at most one file region. Responses with multiple
+        ranges have one file region per range. Loop until the socket is full or all regions are written.
      */
-    file = q->ioFile ? tx->file : 0;
-    written = mprSendFileToSocket(conn->sock, file, q->ioPos, q->ioCount, q->iovec, q->ioIndex, NULL, 0);
-    if (written < 0) {
-        errCode = mprGetError();
-        if (errCode == EAGAIN || errCode == EWOULDBLOCK) {
-            /*  Socket full, wait for an I/O event */
-            httpSocketBlocked(conn);
-        } else {
-            if (errCode != EPIPE && errCode != ECONNRESET && errCode != ECONNABORTED && errCode != ENOTCONN) {
-                httpError(conn, HTTP_ABORT | HTTP_CODE_COMMS_ERROR, "sendConnector: error, errCode %d", errCode);
+    written = 0;
+    while (q->first && !(q->first->flags & HTTP_PACKET_END)) {
+        if (q->ioIndex == 0 && buildSendVec(q) <= 0) {
+            break;
+        }
+        count = q->ioCount;
+        file = q->ioFile ? tx->file : 0;
+        written = mprSendFileToSocket(conn->sock, file, q->ioPos, q->ioCount, q->iovec, q->ioIndex, NULL, 0);
+        if (written < 0) {
+            errCode = mprGetError();
+            if (errCode == EAGAIN || errCode == EWOULDBLOCK) {
+                /*  Socket full, wait for an I/O event */
+                httpSocketBlocked(conn);
             } else {
-                httpDisconnect(conn);
+                if (errCode != EPIPE && errCode != ECONNRESET && errCode != ECONNABORTED && errCode != ENOTCONN) {
+                    httpError(conn, HTTP_ABORT | HTTP_CODE_COMMS_ERROR, "sendConnector: error, errCode %d", errCode);
+                } else {
+                    httpDisconnect(conn);
+                }
+                httpFinalizeConnector(conn);
             }
-            httpFinalizeConnector(conn);
+            break;
+        } else if (written > 0) {
+            tx->bytesWritten += written;
+            freeSendPackets(q, written);
+            adjustSendVec(q, written);
+        }
+        if (written < count) {
+            /* Socket full */
+            break;
         }
-    } else if (written > 0) {
-        tx->bytesWritten += written;
-        freeSendPackets(q, written);
-        adjustSendVec(q, written);
     }
     mprTrace(6, "sendConnector: wrote %d, qflags %x", (int) written, q->flags);
-    if (q->first && q->first->flags & HTTP_PACKET_END) {
+    if (q->first && q->first->flags & HTTP_PACKET_END && !tx->finalizedConnector) {
         mprTrace(6, "sendConnector: end of stream. Finalize connector");
         httpFinalizeConnector(conn);
     }
@@ -217,9 +240,15 @@ static void addPacketForSend(HttpQueue *q, HttpPacket *packet)
     if (packet->prefix) {
         addToSendVector(q, mprGetBufStart(packet->prefix), mprGetBufLength(packet->prefix));
     }
-    if (packet->esize > 0) {
+    if (packet->esize > 0 && tx->fileData) {
+        /* Cached file content. Sent with the headers in one write */
+        addToSendVector(q, &tx->fileData[packet->epos], (ssize) packet->esize);
+
+    } else if (packet->esize > 0) {
+        /* File region. Ranged responses may have several, each sent by a separate sendfile */
         assert(q->ioFile == 0);
         q->ioFile = 1;
+        q->ioPos = packet->epos;
         q->ioCount += packet->esize;
 
     } else if (httpGetPacketLength(packet) > 0) {
@@ -309,8 +338,8 @@ static void adjustSendVec(HttpQueue *q, MprOff written)
         }
         written -= len;
         q->ioCount -= len;
-        for (j = i + 1; i < q->ioIndex; ) {
-            iovec[j++] = iovec[i++];
+        for (j = i + 1; j < q->ioIndex; j++) {
+            iovec[j - 1] = iovec[j];
         }
         q->ioIndex--;
         i--;
@@ -8,16 +8,25 @@
 
 #include    "http.h"
 
+/********************************** Defines ***********************************/
+
+#define SESSION_RETRIES     8               /* Attempts to merge changes into a session written concurrently */
+
 /********************************** Forwards  *********************************/
 
+static void changeSession(HttpSession *sp, cchar *key);
+static MprHash *cloneSessionData(MprHash *data);
 static void manageSession(HttpSession *sp, int flags);
+static void mergeSession(HttpSession *sp);
+static void ownSessionData(HttpSession *sp);
 
 /************************************* Code ***********************************/
 /*
     Allocate a http session state object. This keeps a local hash for session state items.
-    This is written via httpWriteSession to the backend session state store.
+    This is written via httpWriteSession to the backend session state store. Data read from the store is shared
+    until modified.
  */
-static HttpSession *allocSession(HttpConn *conn, cchar *id, cchar *data)
+static HttpSession *allocSession(HttpConn *conn, cchar *id, MprHash *data, int64 version)
 {
     HttpSession *sp;
 
@@ -29,11 +38,12 @@ static HttpSession *allocSession(HttpConn *conn, cchar *id, cchar *data)
     }
     sp->lifespan = conn->limits->sessionTimeout;
     sp->id = sclone(id);
-    sp->cache = conn->http->sessionCache;
+    sp->store = conn->http->sessionStore;
     if (data) {
-        sp->data = mprDeserialize(data);
-    }
-    if (!sp->data) {
+        sp->data = data;
+        sp->version = version;
+        sp->shared = 1;
+    } else {
         sp->data = mprCreateHash(BIT_MAX_SESSION_HASH, 0);
     }
     return sp;
@@ -46,7 +56,10 @@ static HttpSession *allocSession(HttpConn *conn, cchar *id, cchar *data)
 static HttpSession *createSession(HttpConn *conn)
 {
     Http            *http;
+    HttpSessionStore *store;
+    HttpSession     *sp;
     char            *id;
+    int             count;
     static int      nextSession = 0;
 
     assert(conn);
@@ -58,30 +71,35 @@ static HttpSession *createSession(HttpConn *conn)
     id = sfmt("%08x%08x%d", PTOI(conn->data) + PTOI(conn), (int) mprGetTicks(), nextSession++);
     id = mprGetMD5WithPrefix(id, slen(id), "::http.session::");
 
-    lock(http);
-    mprGetCacheStats(conn->http->sessionCache, &http->activeSessions, NULL);
-    if (http->activeSessions >= conn->limits->sessionMax) {
-        unlock(http);
-        httpLimitError(conn, HTTP_CODE_SERVICE_UNAVAILABLE, "Too many sessions %d/%d", http->activeSessions, conn->limits->sessionMax);
+    store = http->sessionStore;
+    if ((count = store->count(store)) >= conn->limits->sessionMax) {
+        httpLimitError(conn, HTTP_CODE_SERVICE_UNAVAILABLE, "Too many sessions %d/%d", count, conn->limits->sessionMax);
         return 0;
     }
-    unlock(http);
-
-    return allocSession(conn, id, NULL);
+    http->activeSessions = count;
+    if ((sp = allocSession(conn, id, NULL, 0)) != 0) {
+        /* New sessions are written even if empty so the session ID is valid for subsequent requests */
+        sp->dirty = 1;
+    }
+    return sp;
 }
 
 
 static HttpSession *lookupSession(HttpConn *conn)
 {
-    cchar   *data, *id;
+    HttpSessionStore    *store;
+    MprHash             *data;
+    cchar               *id;
+    int64               version;
 
     if ((id = httpGetSessionID(conn)) == 0) {
         return 0;
     }
-    if ((data = mprReadCache(conn->http->sessionCache, id, 0, 0)) == 0) {
+    store = conn->http->sessionStore;
+    if ((data = store->read(store, id, &version)) == 0) {
         return 0;
     }
-    return allocSession(conn, id, data);
+    return allocSession(conn, id, data, version);
 }
 
 
@@ -107,7 +125,7 @@ PUBLIC void httpDestroySession(HttpConn *conn)
     lock(http);
     if ((sp = httpGetSession(conn, 0)) != 0) {
         httpRemoveCookie(conn, HTTP_SESSION_COOKIE);
-        mprExpireCacheItem(sp->cache, sp->id, 0);
+        sp->store->remove(sp->store, sp->id);
         sp->id = 0;
         conn->rx->session = 0;
     }
@@ -120,9 +138,57 @@ static void manageSession(HttpSession *sp, int flags)
 {
     if (flags & MPR_MANAGE_MARK) {
         mprMark(sp->id);
-        mprMark(sp->cache);
+        mprMark(sp->store);
         mprMark(sp->data);
+        mprMark(sp->changes);
+    }
+}
+
+
+/*
+    Record a modified or removed key so the change can be merged if the session is written concurrently
+ */
+static void changeSession(HttpSession *sp, cchar *key)
+{
+    if (sp->changes == 0) {
+        sp->changes = mprCreateHash(0, MPR_HASH_STATIC_VALUES);
     }
+    mprAddKey(sp->changes, key, sp);
+    sp->dirty = 1;
+}
+
+
+/*
+    Copy session data that is shared with the store before it is modified
+ */
+static void ownSessionData(HttpSession *sp)
+{
+    if (sp->shared) {
+        sp->data = cloneSessionData(sp->data);
+        sp->shared = 0;
+    }
+}
+
+
+static MprHash *cloneSessionData(MprHash *data)
+{
+    MprHash     *clone;
+    MprKey      *kp, *cp;
+    void        *value;
+
+    if ((clone = mprCreateHash(BIT_MAX_SESSION_HASH, data->flags & MPR_HASH_LIST)) == 0) {
+        return 0;
+    }
+    for (ITERATE_KEYS(data, kp)) {
+        value = (void*) kp->data;
+        if (kp->type == MPR_JSON_OBJ || kp->type == MPR_JSON_ARRAY) {
+            value = cloneSessionData(value);
+        }
+        if ((cp = mprAddKey(clone, kp->key, value)) != 0) {
+            cp->type = kp->type;
+        }
+    }
+    return clone;
 }
 
 
@@ -165,7 +231,10 @@ PUBLIC MprHash *httpGetSessionObj(HttpConn *conn, cchar *key)
     if ((sp = httpGetSession(conn, 0)) != 0) {
         if ((kp = mprLookupKeyEntry(sp->data, key)) != 0) {
             if (kp->type == MPR_JSON_OBJ) {
-                return (MprHash*) kp->data;
+                /* The caller may modify the object */
+                ownSessionData(sp);
+                changeSession(sp, key);
+                return (MprHash*) mprLookupKey(sp->data, key);
             }
         }
     }
@@ -203,9 +272,11 @@ PUBLIC int httpSetSessionObj(HttpConn *conn, cchar *key, MprHash *obj)
     if (obj == 0) {
         httpRemoveSessionVar(conn, key);
     } else {
-        if ((kp = mprAddKey(sp->data, key, obj)) != 0) {
+        ownSessionData(sp);
+        if ((kp = mprAddKey(sp->data, key, cloneSessionData(obj))) != 0) {
             kp->type = MPR_JSON_OBJ;
         }
+        changeSession(sp, key);
     }
     return 0;
 }
@@ -220,6 +291,7 @@ PUBLIC int httpSetSessionObj(HttpConn *conn, cchar *key, MprHash *obj)
 PUBLIC int httpSetSessionVar(HttpConn *conn, cchar *key, cchar *value)
 {
     HttpSession  *sp;
+    MprKey       *kp;
 
     assert(conn);
     assert(key && *key);
@@ -230,7 +302,15 @@ PUBLIC int httpSetSessionVar(HttpConn *conn, cchar *key, cchar *value)
     if (value == 0) {
         httpRemoveSessionVar(conn, key);
     } else {
-        mprAddKey(sp->data, key, value);
+        /* Setting the same value does not require the session to be written */
+        kp = mprLookupKeyEntry(sp->data, key);
+        if (!kp || kp->type != MPR_JSON_STRING || !smatch(kp->data, value)) {
+            ownSessionData(sp);
+            if ((kp = mprAddKey(sp->data, key, sclone(value))) != 0) {
+                kp->type = MPR_JSON_STRING;
+            }
+            changeSession(sp, key);
+        }
     }
     return 0;
 }
@@ -246,24 +326,77 @@ PUBLIC int httpRemoveSessionVar(HttpConn *conn, cchar *key)
     if ((sp = httpGetSession(conn, 0)) == 0) {
         return 0;
     }
-    return mprRemoveKey(sp->data, key);
+    if (!mprLookupKeyEntry(sp->data, key)) {
+        return MPR_ERR_CANT_FIND;
+    }
+    ownSessionData(sp);
+    if (mprRemoveKey(sp->data, key) < 0) {
+        return MPR_ERR_CANT_FIND;
+    }
+    changeSession(sp, key);
+    return 0;
 }
 
 
+/*
+    Write modified sessions. Unmodified sessions need not be written as reading the session renews its lifespan.
+    If another request wrote the session since it was read, this request's changes are merged into the stored
+    session and the write is retried. The store may retain the session data, so it is shared from here on and
+    copied if modified again.
+ */
 PUBLIC int httpWriteSession(HttpConn *conn)
 {
     HttpSession     *sp;
+    int             rc, retries;
 
-    if ((sp = conn->rx->session) != 0) {
-        if (mprWriteCache(sp->cache, sp->id, mprSerialize(sp->data, 0), 0, sp->lifespan, 0, MPR_CACHE_SET) == 0) {
-            mprError("Cannot persist session cache");
+    if ((sp = conn->rx->session) != 0 && sp->dirty) {
+        for (retries = 0; ; retries++) {
+            rc = sp->store->write(sp->store, sp->id, sp->data, sp->lifespan, &sp->version);
+            if (rc != MPR_ERR_BAD_STATE || retries >= SESSION_RETRIES) {
+                break;
+            }
+            mergeSession(sp);
+        }
+        if (rc < 0) {
+            mprError("Cannot persist session state");
             return MPR_ERR_CANT_WRITE;
         }
+        sp->shared = 1;
+        sp->dirty = 0;
+        sp->changes = 0;
     }
     return 0;
 }
 
 
+/*
+    Apply the keys changed by this request to the current stored session. If the session no longer exists,
+    it is written again as a new session.
+ */
+static void mergeSession(HttpSession *sp)
+{
+    MprHash     *stored, *data;
+    MprKey      *kp, *cp, *dp;
+    int64       version;
+
+    if ((stored = sp->store->read(sp->store, sp->id, &version)) == 0) {
+        sp->version = 0;
+        return;
+    }
+    data = cloneSessionData(stored);
+    for (ITERATE_KEYS(sp->changes, kp)) {
+        if ((cp = mprLookupKeyEntry(sp->data, kp->key)) == 0) {
+            mprRemoveKey(data, kp->key);
+        } else if ((dp = mprAddKey(data, kp->key, cp->data)) != 0) {
+            dp->type = cp->type;
+        }
+    }
+    sp->data = data;
+    sp->version = version;
+    sp->shared = 0;
+}
+
+
 PUBLIC char *httpGetSessionID(HttpConn *conn)
 {
     HttpRx  *rx;
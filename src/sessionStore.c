@@ -0,0 +1,804 @@
+/*
+    sessionStore.c -- Session state stores
+
+    Session data is held between requests by a session store. The memory store retains the decoded session objects
+    so requests do not parse the session data. The objects are shared by requests for the session and are copied
+    by the session layer before they are modified. Sessions are divided over lock stripes so requests for different
+    sessions rarely contend.
+
+    The shared store places sessions in fixed size slots of a memory mapped file so several server processes on one
+    host can share sessions. Sessions are encoded in a compact binary form. Each process retains the decoded objects
+    in a memory store and only decodes a session again if its version in the shared segment has changed.
+
+    Writes are a compare and set on the session version so a write fails if another request has written the session
+    since it was read. The session layer then merges its changes into the stored session.
+
+    Copyright (c) All Rights Reserved. See copyright notice at the bottom of the file.
+ */
+
+/********************************* Includes ***********************************/
+
+#include    "http.h"
+
+/*********************************** Locals ***********************************/
+
+#define PRUNE_PERIOD    (60 * 1000)         /* Period to prune expired sessions from a memory store shard */
+
+typedef struct MemSession {
+    char            *id;                    /* Session ID */
+    MprHash         *data;                  /* Decoded session data. Not modified once stored */
+    int64           version;                /* Session version */
+    MprTicks        lifespan;               /* Inactivity timeout */
+    MprTicks        expires;                /* When the session expires */
+} MemSession;
+
+typedef struct MemShard {
+    MprHash         *sessions;              /* Sessions indexed by ID */
+    MprMutex        *mutex;                 /* Shard lock */
+    MprTicks        pruned;                 /* When the shard was last pruned */
+} MemShard;
+
+typedef struct MemStore {
+    MemShard        **shards;               /* Lock stripes */
+    int             numShards;              /* Number of shards */
+} MemStore;
+
+#if BIT_UNIX_LIKE
+#define SHM_MAGIC       0x48545353          /* Shared store file signature */
+#define SHM_BUCKET      8                   /* Slots per bucket. A session may use any free slot in its buckets */
+#define SHM_STRIPES     64                  /* Process shared locks. Buckets are assigned to locks round-robin */
+#define SHM_ID_SIZE     64                  /* Maximum session ID length including the null */
+
+typedef struct ShmHeader {
+    int             magic;                  /* SHM_MAGIC once initialized */
+    int             buckets;                /* Number of buckets */
+    int             slotSize;               /* Size of a slot including the slot header */
+    volatile int    count;                  /* Slots in use including expired sessions not yet reused */
+    volatile int64  nextVersion;            /* Version counter shared by all sessions */
+    pthread_mutex_t locks[SHM_STRIPES];     /* Bucket locks */
+} ShmHeader;
+
+/*
+    A slot is free if the length is zero. The length is set last when writing so a slot is never seen partially written.
+ */
+typedef struct ShmSlot {
+    char            id[SHM_ID_SIZE];        /* Session ID */
+    int64           version;                /* Session version */
+    MprTime         expires;                /* Expiry time. Uses the wall clock as ticks are specific to a process */
+    MprTicks        lifespan;               /* Inactivity timeout */
+    int             length;                 /* Length of the encoded session following the slot header */
+} ShmSlot;
+
+typedef struct ShmStore {
+    char            *path;                  /* Mapped file */
+    ShmHeader       *header;                /* Mapped segment */
+    char            *slots;                 /* First slot */
+    ssize           size;                   /* Size of the mapped segment */
+    int             fd;                     /* Mapped file descriptor */
+    HttpSessionStore *local;                /* Decoded sessions for this process */
+} ShmStore;
+#endif
+
+/********************************** Forwards **********************************/
+
+static HttpSessionStore *allocStore(cchar *name, void *data);
+static MemShard *getShard(MemStore *ms, cchar *id);
+static void manageMemSession(MemSession *mp, int flags);
+static void manageMemShard(MemShard *shard, int flags);
+static void manageMemStore(MemStore *ms, int flags);
+static void manageSessionStore(HttpSessionStore *store, int flags);
+static int memCount(HttpSessionStore *store);
+static MprHash *memRead(HttpSessionStore *store, cchar *id, int64 *version);
+static void memRemove(HttpSessionStore *store, cchar *id);
+static int memWrite(HttpSessionStore *store, cchar *id, MprHash *data, MprTicks lifespan, int64 *version);
+static void pruneShard(MemShard *shard, MprTicks now);
+static int64 putSession(MemStore *ms, cchar *id, MprHash *data, MprTicks lifespan, int64 version, int64 *expected);
+
+#if BIT_UNIX_LIKE
+static MprHash *decodeSession(cchar **bufp, int list);
+static ssize encodeSession(MprHash *data, char *buf, ssize size);
+static ShmSlot *findSlot(ShmStore *ss, int *buckets, cchar *id, MprTime now, int create);
+static void getBuckets(ShmStore *ss, cchar *id, int *buckets);
+static void lockBuckets(ShmStore *ss, int *buckets);
+static void lockStripe(ShmStore *ss, int stripe);
+static void manageShmStore(ShmStore *ss, int flags);
+static int mapStore(ShmStore *ss, int buckets, int slotSize);
+static int shmCount(HttpSessionStore *store);
+static MprHash *shmRead(HttpSessionStore *store, cchar *id, int64 *version);
+static void shmRemove(HttpSessionStore *store, cchar *id);
+static int shmWrite(HttpSessionStore *store, cchar *id, MprHash *data, MprTicks lifespan, int64 *version);
+static void unlockBuckets(ShmStore *ss, int *buckets);
+#endif
+
+/************************************ Code ************************************/
+
+PUBLIC void httpSetSessionStore(Http *http, HttpSessionStore *store)
+{
+    if (store) {
+        http->sessionStore = store;
+    }
+}
+
+
+static HttpSessionStore *allocStore(cchar *name, void *data)
+{
+    HttpSessionStore    *store;
+
+    if ((store = mprAllocObj(HttpSessionStore, manageSessionStore)) == 0) {
+        return 0;
+    }
+    store->name = sclone(name);
+    store->data = data;
+    return store;
+}
+
+
+static void manageSessionStore(HttpSessionStore *store, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(store->name);
+        mprMark(store->data);
+    }
+}
+
+/********************************* Memory Store *******************************/
+
+PUBLIC HttpSessionStore *httpCreateMemorySessionStore(int shards)
+{
+    HttpSessionStore    *store;
+    MemStore            *ms;
+    MemShard            *shard;
+    int                 i;
+
+    if (shards <= 0) {
+        shards = BIT_MAX_SESSION_SHARDS;
+    }
+    if ((ms = mprAllocObj(MemStore, manageMemStore)) == 0) {
+        return 0;
+    }
+    if ((ms->shards = mprAllocZeroed(shards * sizeof(MemShard*))) == 0) {
+        return 0;
+    }
+    for (i = 0; i < shards; i++) {
+        if ((shard = mprAllocObj(MemShard, manageMemShard)) == 0) {
+            return 0;
+        }
+        shard->sessions = mprCreateHash(0, MPR_HASH_OPEN | MPR_HASH_STATIC_KEYS);
+        shard->mutex = mprCreateLock();
+        shard->pruned = mprGetTicks();
+        ms->shards[i] = shard;
+        ms->numShards++;
+    }
+    if ((store = allocStore("memory", ms)) == 0) {
+        return 0;
+    }
+    store->read = memRead;
+    store->write = memWrite;
+    store->remove = memRemove;
+    store->count = memCount;
+    return store;
+}
+
+
+static void manageMemStore(MemStore *ms, int flags)
+{
+    int     i;
+
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(ms->shards);
+        for (i = 0; i < ms->numShards; i++) {
+            mprMark(ms->shards[i]);
+        }
+    }
+}
+
+
+static void manageMemShard(MemShard *shard, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(shard->sessions);
+        mprMark(shard->mutex);
+    }
+}
+
+
+static void manageMemSession(MemSession *mp, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(mp->id);
+        mprMark(mp->data);
+    }
+}
+
+
+static MemShard *getShard(MemStore *ms, cchar *id)
+{
+    return ms->shards[shash(id, slen(id)) % ms->numShards];
+}
+
+
+static MprHash *memRead(HttpSessionStore *store, cchar *id, int64 *version)
+{
+    MemShard    *shard;
+    MemSession  *mp;
+    MprHash     *data;
+    MprTicks    now;
+
+    shard = getShard(store->data, id);
+    now = mprGetTicks();
+    data = 0;
+    lock(shard);
+    if ((mp = mprLookupKey(shard->sessions, id)) != 0 && mp->expires > now) {
+        mp->expires = now + mp->lifespan;
+        *version = mp->version;
+        data = mp->data;
+    }
+    unlock(shard);
+    return data;
+}
+
+
+static int memWrite(HttpSessionStore *store, cchar *id, MprHash *data, MprTicks lifespan, int64 *version)
+{
+    int64   v;
+
+    if ((v = putSession(store->data, id, data, lifespan, 0, version)) < 0) {
+        return (int) v;
+    }
+    *version = v;
+    return 0;
+}
+
+
+/*
+    Store a session. If version is zero, the existing version is incremented. If expected is not null, the session
+    is only stored if its current version matches. Expired sessions have a current version of zero.
+    Returns the session version or MPR_ERR_BAD_STATE if the version does not match.
+ */
+static int64 putSession(MemStore *ms, cchar *id, MprHash *data, MprTicks lifespan, int64 version, int64 *expected)
+{
+    MemShard    *shard;
+    MemSession  *mp;
+    MprTicks    now;
+
+    shard = getShard(ms, id);
+    now = mprGetTicks();
+    lock(shard);
+    mp = mprLookupKey(shard->sessions, id);
+    if (expected && *expected != ((mp && mp->expires > now) ? mp->version : 0)) {
+        unlock(shard);
+        return MPR_ERR_BAD_STATE;
+    }
+    if (mp == 0) {
+        if ((now - shard->pruned) >= PRUNE_PERIOD) {
+            pruneShard(shard, now);
+        }
+        if ((mp = mprAllocObj(MemSession, manageMemSession)) == 0) {
+            unlock(shard);
+            return MPR_ERR_MEMORY;
+        }
+        mp->id = sclone(id);
+        mprAddKey(shard->sessions, mp->id, mp);
+    }
+    mp->data = data;
+    mp->lifespan = lifespan;
+    mp->expires = now + lifespan;
+    mp->version = version ? version : mp->version + 1;
+    version = mp->version;
+    unlock(shard);
+    return version;
+}
+
+
+static void memRemove(HttpSessionStore *store, cchar *id)
+{
+    MemShard    *shard;
+
+    shard = getShard(store->data, id);
+    lock(shard);
+    mprRemoveKey(shard->sessions, id);
+    unlock(shard);
+}
+
+
+/*
+    Count sessions. Shards that are due are pruned first so expired sessions do not count against the session limit.
+ */
+static int memCount(HttpSessionStore *store)
+{
+    MemStore    *ms;
+    MemShard    *shard;
+    MprTicks    now;
+    int         i, count;
+
+    ms = store->data;
+    now = mprGetTicks();
+    count = 0;
+    for (i = 0; i < ms->numShards; i++) {
+        shard = ms->shards[i];
+        lock(shard);
+        if ((now - shard->pruned) >= PRUNE_PERIOD) {
+            pruneShard(shard, now);
+        }
+        count += mprGetHashLength(shard->sessions);
+        unlock(shard);
+    }
+    return count;
+}
+
+
+/*
+    Remove expired sessions. Caller must hold the shard lock.
+ */
+static void pruneShard(MemShard *shard, MprTicks now)
+{
+    MprKey      *kp;
+    MemSession  *mp;
+
+    for (ITERATE_KEYS(shard->sessions, kp)) {
+        mp = (MemSession*) kp->data;
+        if (mp->expires <= now) {
+            mprRemoveKey(shard->sessions, kp->key);
+        }
+    }
+    shard->pruned = now;
+}
+
+/********************************* Shared Store *******************************/
+#if BIT_UNIX_LIKE
+
+PUBLIC HttpSessionStore *httpCreateSharedSessionStore(cchar *path, int maxSessions, ssize maxSize)
+{
+    HttpSessionStore    *store;
+    ShmStore            *ss;
+    int                 buckets, slotSize;
+
+    assert(path && *path);
+
+    if (maxSessions <= 0 || maxSize <= 0 || maxSize > MAXINT / 2) {
+        return 0;
+    }
+    /* Spare slots as sessions are unevenly distributed over the buckets */
+    buckets = (int) (((int64) maxSessions * 2 + SHM_BUCKET - 1) / SHM_BUCKET);
+    slotSize = (int) ((sizeof(ShmSlot) + maxSize + 7) & ~7);
+
+    if ((ss = mprAllocObj(ShmStore, manageShmStore)) == 0) {
+        return 0;
+    }
+    ss->fd = -1;
+    ss->path = sclone(path);
+    if (mapStore(ss, buckets, slotSize) < 0) {
+        return 0;
+    }
+    if ((ss->local = httpCreateMemorySessionStore(0)) == 0) {
+        return 0;
+    }
+    if ((store = allocStore("shared", ss)) == 0) {
+        return 0;
+    }
+    store->read = shmRead;
+    store->write = shmWrite;
+    store->remove = shmRemove;
+    store->count = shmCount;
+    return store;
+}
+
+
+static void manageShmStore(ShmStore *ss, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(ss->path);
+        mprMark(ss->local);
+
+    } else if (flags & MPR_MANAGE_FREE) {
+        if (ss->header) {
+            munmap((void*) ss->header, ss->size);
+        }
+        if (ss->fd >= 0) {
+            close(ss->fd);
+        }
+    }
+}
+
+
+/*
+    Map the store file. The first process to map the file initializes it while holding a file lock.
+ */
+static int mapStore(ShmStore *ss, int buckets, int slotSize)
+{
+    ShmHeader           *hp;
+    pthread_mutexattr_t attr;
+    struct flock        fl;
+    struct stat         info;
+    ssize               headerSize;
+    int                 i, rc;
+
+    headerSize = (sizeof(ShmHeader) + 63) & ~63;
+    ss->size = headerSize + (ssize) buckets * SHM_BUCKET * slotSize;
+
+    if ((ss->fd = open(ss->path, O_RDWR | O_CREAT, 0600)) < 0) {
+        mprError("Cannot open session store %s, errno %d", ss->path, errno);
+        return MPR_ERR_CANT_OPEN;
+    }
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = F_WRLCK;
+    fl.l_whence = SEEK_SET;
+    if (fcntl(ss->fd, F_SETLKW, &fl) < 0) {
+        mprError("Cannot lock session store %s, errno %d", ss->path, errno);
+        return MPR_ERR_BUSY;
+    }
+    rc = 0;
+    if (fstat(ss->fd, &info) < 0) {
+        rc = MPR_ERR_CANT_ACCESS;
+    } else if (info.st_size == 0 && ftruncate(ss->fd, ss->size) < 0) {
+        mprError("Cannot size session store %s, errno %d", ss->path, errno);
+        rc = MPR_ERR_CANT_WRITE;
+    } else if (info.st_size != 0 && info.st_size != ss->size) {
+        mprError("Session store %s was created with a different size", ss->path);
+        rc = MPR_ERR_BAD_STATE;
+    }
+    if (rc == 0) {
+        hp = mmap(0, ss->size, PROT_READ | PROT_WRITE, MAP_SHARED, ss->fd, 0);
+        if (hp == MAP_FAILED) {
+            mprError("Cannot map session store %s, errno %d", ss->path, errno);
+            rc = MPR_ERR_CANT_INITIALIZE;
+        } else {
+            ss->header = hp;
+            ss->slots = (char*) hp + headerSize;
+            if (hp->magic != SHM_MAGIC) {
+                memset(hp, 0, headerSize);
+                pthread_mutexattr_init(&attr);
+                pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+#if LINUX
+                pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+#endif
+                for (i = 0; i < SHM_STRIPES; i++) {
+                    pthread_mutex_init(&hp->locks[i], &attr);
+                }
+                pthread_mutexattr_destroy(&attr);
+                hp->buckets = buckets;
+                hp->slotSize = slotSize;
+                hp->magic = SHM_MAGIC;
+            } else if (hp->buckets != buckets || hp->slotSize != slotSize) {
+                mprError("Session store %s was created with different limits", ss->path);
+                rc = MPR_ERR_BAD_STATE;
+            }
+        }
+    }
+    fl.l_type = F_UNLCK;
+    fcntl(ss->fd, F_SETLK, &fl);
+    return rc;
+}
+
+
+/*
+    A session may be stored in either of two buckets. New sessions use the emptier bucket so buckets rarely fill.
+ */
+static void getBuckets(ShmStore *ss, cchar *id, int *buckets)
+{
+    uint    hash;
+
+    hash = shash(id, slen(id));
+    buckets[0] = hash % ss->header->buckets;
+    buckets[1] = ((hash * 0x9E3779B1) >> 7) % ss->header->buckets;
+}
+
+
+static void lockStripe(ShmStore *ss, int stripe)
+{
+    pthread_mutex_t     *mutex;
+
+    mutex = &ss->header->locks[stripe];
+#if LINUX
+    if (pthread_mutex_lock(mutex) == EOWNERDEAD) {
+        /* A process died holding the lock. Slots are written so they are always consistent */
+        pthread_mutex_consistent(mutex);
+    }
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+
+/*
+    Lock both buckets. Stripes are locked in ascending order to avoid deadlock.
+ */
+static void lockBuckets(ShmStore *ss, int *buckets)
+{
+    int     s0, s1;
+
+    s0 = buckets[0] % SHM_STRIPES;
+    s1 = buckets[1] % SHM_STRIPES;
+    lockStripe(ss, min(s0, s1));
+    if (s0 != s1) {
+        lockStripe(ss, max(s0, s1));
+    }
+}
+
+
+static void unlockBuckets(ShmStore *ss, int *buckets)
+{
+    int     s0, s1;
+
+    s0 = buckets[0] % SHM_STRIPES;
+    s1 = buckets[1] % SHM_STRIPES;
+    if (s0 != s1) {
+        pthread_mutex_unlock(&ss->header->locks[s1]);
+    }
+    pthread_mutex_unlock(&ss->header->locks[s0]);
+}
+
+
+/*
+    Find the slot for a session in its buckets. Expired slots are freed. If create is set and the session does not
+    exist, a free slot in the emptier bucket is returned. Caller must hold the bucket locks.
+ */
+static ShmSlot *findSlot(ShmStore *ss, int *buckets, cchar *id, MprTime now, int create)
+{
+    ShmHeader   *hp;
+    ShmSlot     *sp, *free[2];
+    int         used[2], i, j;
+
+    hp = ss->header;
+    for (j = 0; j < 2; j++) {
+        free[j] = 0;
+        used[j] = 0;
+        if (j == 1 && buckets[1] == buckets[0]) {
+            break;
+        }
+        for (i = 0; i < SHM_BUCKET; i++) {
+            sp = (ShmSlot*) &ss->slots[((ssize) buckets[j] * SHM_BUCKET + i) * hp->slotSize];
+            if (sp->length > 0 && sp->expires <= now) {
+                sp->length = 0;
+                mprAtomicAdd((int*) &hp->count, -1);
+            }
+            if (sp->length == 0) {
+                if (!free[j]) {
+                    free[j] = sp;
+                }
+            } else if (strcmp(sp->id, id) == 0) {
+                return sp;
+            } else {
+                used[j]++;
+            }
+        }
+    }
+    if (!create) {
+        return 0;
+    }
+    if (free[0] && free[1]) {
+        return (used[1] < used[0]) ? free[1] : free[0];
+    }
+    return free[0] ? free[0] : free[1];
+}
+
+
+static MprHash *shmRead(HttpSessionStore *store, cchar *id, int64 *version)
+{
+    ShmStore    *ss;
+    ShmSlot     *sp;
+    MprHash     *data;
+    MprTicks    lifespan;
+    MprTime     now;
+    cchar       *cp;
+    char        *encoded;
+    int64       localVersion;
+    int         buckets[2];
+
+    ss = store->data;
+    if (slen(id) >= SHM_ID_SIZE) {
+        return 0;
+    }
+    getBuckets(ss, id, buckets);
+    now = mprGetTime();
+    encoded = 0;
+
+    lockBuckets(ss, buckets);
+    if ((sp = findSlot(ss, buckets, id, now, 0)) == 0) {
+        unlockBuckets(ss, buckets);
+        ss->local->remove(ss->local, id);
+        return 0;
+    }
+    sp->expires = now + sp->lifespan;
+    *version = sp->version;
+    lifespan = sp->lifespan;
+    data = ss->local->read(ss->local, id, &localVersion);
+    if (!data || localVersion != sp->version) {
+        /* Copy the session so it is decoded without holding the locks */
+        encoded = mprMemdup((char*) &sp[1], sp->length);
+    }
+    unlockBuckets(ss, buckets);
+
+    if (encoded) {
+        cp = encoded;
+        data = decodeSession(&cp, 0);
+        putSession(ss->local->data, id, data, lifespan, *version, NULL);
+    }
+    return data;
+}
+
+
+static int shmWrite(HttpSessionStore *store, cchar *id, MprHash *data, MprTicks lifespan, int64 *version)
+{
+    ShmStore    *ss;
+    ShmHeader   *hp;
+    ShmSlot     *sp;
+    MprTime     now;
+    ssize       len, max;
+    int         buckets[2];
+
+    ss = store->data;
+    hp = ss->header;
+    max = hp->slotSize - sizeof(ShmSlot);
+    if (slen(id) >= SHM_ID_SIZE) {
+        return MPR_ERR_BAD_ARGS;
+    }
+    if ((len = encodeSession(data, 0, max)) > max) {
+        mprError("Session is too large for the shared session store: %d bytes", (int) len);
+        return MPR_ERR_WONT_FIT;
+    }
+    getBuckets(ss, id, buckets);
+    now = mprGetTime();
+
+    lockBuckets(ss, buckets);
+    if ((sp = findSlot(ss, buckets, id, now, 1)) == 0) {
+        unlockBuckets(ss, buckets);
+        mprError("Shared session store is full");
+        return MPR_ERR_TOO_MANY;
+    }
+    if (*version != (sp->length ? sp->version : 0)) {
+        /* Written by another request or process since it was read */
+        unlockBuckets(ss, buckets);
+        return MPR_ERR_BAD_STATE;
+    }
+    if (sp->length == 0) {
+        mprAtomicAdd((int*) &hp->count, 1);
+        scopy(sp->id, SHM_ID_SIZE, id);
+    }
+    sp->length = 0;
+    encodeSession(data, (char*) &sp[1], max);
+    sp->lifespan = lifespan;
+    sp->expires = now + lifespan;
+    sp->version = *version = __sync_add_and_fetch(&hp->nextVersion, 1);
+    sp->length = (int) len;
+    unlockBuckets(ss, buckets);
+
+    /* The written data becomes the decoded copy for this process */
+    putSession(ss->local->data, id, data, lifespan, *version, NULL);
+    return 0;
+}
+
+
+static void shmRemove(HttpSessionStore *store, cchar *id)
+{
+    ShmStore    *ss;
+    ShmSlot     *sp;
+    int         buckets[2];
+
+    ss = store->data;
+    if (slen(id) < SHM_ID_SIZE) {
+        getBuckets(ss, id, buckets);
+        lockBuckets(ss, buckets);
+        if ((sp = findSlot(ss, buckets, id, mprGetTime(), 0)) != 0) {
+            sp->length = 0;
+            mprAtomicAdd((int*) &ss->header->count, -1);
+        }
+        unlockBuckets(ss, buckets);
+    }
+    ss->local->remove(ss->local, id);
+}
+
+
+static int shmCount(HttpSessionStore *store)
+{
+    ShmStore    *ss;
+
+    ss = store->data;
+    return ss->header->count;
+}
+
+
+/*
+    Encode session data. Each member is a type byte and the null terminated key, followed by either the null
+    terminated string value or the encoded object. Objects are terminated by a zero byte. If buf is null, only
+    the encoded length is computed. Returns the encoded length or a negative error if it does not fit.
+ */
+static ssize encodeSession(MprHash *data, char *buf, ssize size)
+{
+    MprKey      *kp;
+    ssize       len, n;
+    int         type;
+
+    len = 0;
+    for (ITERATE_KEYS(data, kp)) {
+        if (kp->data == 0) {
+            continue;
+        }
+        type = (kp->type == MPR_JSON_OBJ || kp->type == MPR_JSON_ARRAY) ? kp->type : MPR_JSON_STRING;
+        n = slen(kp->key) + 1;
+        if (buf) {
+            if ((len + n + 1) > size) {
+                return MPR_ERR_WONT_FIT;
+            }
+            buf[len] = (char) type;
+            memcpy(&buf[len + 1], kp->key, n);
+        }
+        len += n + 1;
+        if (type == MPR_JSON_STRING) {
+            n = slen(kp->data) + 1;
+            if (buf) {
+                if ((len + n) > size) {
+                    return MPR_ERR_WONT_FIT;
+                }
+                memcpy(&buf[len], kp->data, n);
+            }
+        } else if ((n = encodeSession((MprHash*) kp->data, buf ? &buf[len] : 0, size - len)) < 0) {
+            return n;
+        }
+        len += n;
+    }
+    if (buf) {
+        if (len >= size) {
+            return MPR_ERR_WONT_FIT;
+        }
+        buf[len] = '\0';
+    }
+    return len + 1;
+}
+
+
+static MprHash *decodeSession(cchar **bufp, int list)
+{
+    MprHash     *hash;
+    MprKey      *kp;
+    cchar       *cp, *key;
+    void        *value;
+    int         type;
+
+    hash = mprCreateHash(BIT_MAX_SESSION_HASH, list ? MPR_HASH_LIST : 0);
+    for (cp = *bufp; *cp; ) {
+        type = *cp++;
+        key = cp;
+        cp += slen(key) + 1;
+        if (type == MPR_JSON_OBJ || type == MPR_JSON_ARRAY) {
+            value = decodeSession(&cp, type == MPR_JSON_ARRAY);
+        } else {
+            value = sclone(cp);
+            cp += slen(cp) + 1;
+        }
+        if ((kp = mprAddKey(hash, key, value)) != 0) {
+            kp->type = type;
+        }
+    }
+    *bufp = cp + 1;
+    return hash;
+}
+
+#else /* !BIT_UNIX_LIKE */
+
+PUBLIC HttpSessionStore *httpCreateSharedSessionStore(cchar *path, int maxSessions, ssize maxSize)
+{
+    mprError("Shared session stores are not supported on this platform");
+    return 0;
+}
+#endif /* BIT_UNIX_LIKE */
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details and other copyrights.
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
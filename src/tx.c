@@ -35,7 +35,7 @@ PUBLIC HttpTx *httpCreateTx(HttpConn *conn, MprHash *headers)
     if (headers) {
         tx->headers = headers;
     } else {
-        tx->headers = mprCreateHash(HTTP_SMALL_HASH_SIZE, MPR_HASH_CASELESS);
+        tx->headers = mprCreateHash(HTTP_SMALL_HASH_SIZE, MPR_HASH_CASELESS | MPR_HASH_OPEN);
         if (!conn->endpoint) {
             httpAddHeaderString(conn, "User-Agent", sclone(BIT_HTTP_SOFTWARE));
         }
@@ -47,7 +47,9 @@ PUBLIC HttpTx *httpCreateTx(HttpConn *conn, MprHash *headers)
 PUBLIC void httpDestroyTx(HttpTx *tx)
 {
     if (tx->file) {
-        mprCloseFile(tx->file);
+        if (!(tx->flags & HTTP_TX_SHARED_FILE)) {
+            mprCloseFile(tx->file);
+        }
         tx->file = 0;
     }
     if (tx->conn) {
@@ -64,6 +66,7 @@ static void manageTx(HttpTx *tx, int flags)
         mprMark(tx->cache);
         mprMark(tx->cacheBuffer);
         mprMark(tx->cachedContent);
+        mprMark(tx->cachedResponse);
         mprMark(tx->conn);
         mprMark(tx->connector);
         mprMark(tx->currentRange);
@@ -71,6 +74,8 @@ static void manageTx(HttpTx *tx, int flags)
         mprMark(tx->etag);
         mprMark(tx->errorDocument);
         mprMark(tx->file);
+        mprMark(tx->variant);
+        mprMark(tx->fileData);
         mprMark(tx->filename);
         mprMark(tx->handler);
         mprMark(tx->headers);
@@ -177,15 +182,15 @@ PUBLIC void httpAppendHeader(HttpConn *conn, cchar *key, cchar *fmt, ...)
     kp = mprLookupKeyEntry(conn->tx->headers, key);
     if (kp) {
         if (scaselessmatch(key, "Set-Cookie")) {
+            /* Duplicates are not chained in open addressing tables so search all entries */
             cookie = stok(sclone(value), "=", NULL);
-            while (kp) {
+            for (ITERATE_KEYS(conn->tx->headers, kp)) {
                 if (scaselessmatch(kp->key, "Set-Cookie")) {
                     if (sstarts(kp->data, cookie)) {
                         kp->data = value;
                         break;
                     }
                 }
-                kp = kp->next;
             }
             if (!kp) {
                 mprAddDuplicateKey(conn->tx->headers, key, value);
@@ -653,6 +658,11 @@ static void setHeaders(HttpConn *conn, HttpPacket *packet)
     } else if (tx->length < 0 && tx->chunkSize > 0) {
         httpSetHeaderString(conn, "Transfer-Encoding", "chunked");
 
+#if BIT_HTTP_HTTP2
+    } else if (tx->length < 0 && conn->net) {
+        /* The end of an HTTP/2 response body is signified by END_STREAM */
+#endif
+
     } else if (conn->endpoint) {
         /* Server must not emit a content length header for 1XX, 204 and 304 status */
         if (!((100 <= tx->status && tx->status <= 199) || tx->status == 204 || 
@@ -775,6 +785,12 @@ PUBLIC void httpWriteHeaders(HttpQueue *q, HttpPacket *packet)
         return;
     }
     setHeaders(conn, packet);
+#if BIT_HTTP_HTTP2
+    if (conn->net) {
+        httpCreateHttp2Headers(q, packet);
+        return;
+    }
+#endif
 
     if (conn->endpoint) {
         mprPutStringToBuf(buf, conn->protocol);
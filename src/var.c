@@ -11,6 +11,50 @@
 
 #define HTTP_VAR_HASH_SIZE  61           /* Hash size for vars and params */
 
+#define PARAM_ESCAPED       0x1          /* Value contains '+' or '%' escapes */
+#define PARAM_DECODED       0x2          /* Value is decoded and null terminated */
+#define PARAM_ADDED         0x4          /* Value is in (or superseded by) the params table */
+
+/*********************************** Locals ***********************************/
+/*
+    Index of the undecoded query and form params. Params are entered into the rx->params table only when the
+    complete table is required. Key and value pointers refer into private copies of the query and body content.
+    Values are decoded and null terminated in place, so the source must be writable and must not be visible to
+    anything else. The copy is a single allocation per source rather than an allocation per key and value.
+ */
+typedef struct HttpParam {
+    char            *key;               /* Decoded key. Not null terminated */
+    char            *value;             /* Value. Decoded in place on first use */
+    int             keyLen;
+    int             valueLen;
+    int             flags;
+    int             next;               /* Next param on the hash chain (index plus one) */
+    uint            code;               /* Hash of the decoded key */
+} HttpParam;
+
+typedef struct HttpParamIndex {
+    HttpParam       *params;            /* Params in the order received */
+    int             *chains;            /* Hash chain heads (index plus one) */
+    char            *query;             /* Copy of the query string */
+    char            *body;              /* Copy of the form body content */
+    int             count;              /* Number of params */
+    int             size;               /* Size of the params array */
+    int             pending;            /* Params not yet in the params table */
+    int             hashed;             /* Number of params on the hash chains */
+    int             mask;               /* Size of the chains array minus one */
+} HttpParamIndex;
+
+/********************************** Forwards **********************************/
+
+static void addJsonParams(HttpConn *conn);
+static MprHash *createParams(HttpConn *conn);
+static ssize decodeParam(char *buf, ssize len);
+static HttpParamIndex *getParamIndex(HttpConn *conn);
+static cchar *getParamValue(HttpParam *pp);
+static uint hashParam(cchar *key, ssize len);
+static void manageParamIndex(HttpParamIndex *index, int flags);
+static void removeIndexedParam(HttpConn *conn, cchar *var);
+
 /*********************************** Code *************************************/
 /*
     Define standard CGI variables
@@ -31,7 +75,7 @@ PUBLIC void httpCreateCGIParams(HttpConn *conn)
         /* Do only once */
         return;
     }
-    svars = rx->svars = mprCreateHash(HTTP_VAR_HASH_SIZE, 0);
+    svars = rx->svars = mprCreateHash(HTTP_VAR_HASH_SIZE, MPR_HASH_OPEN);
     tx = conn->tx;
     host = conn->host;
     sock = conn->sock;
@@ -102,126 +146,357 @@ PUBLIC void httpCreateCGIParams(HttpConn *conn)
 
 
 /*
-    Add variables to the vars environment store. This comes from the query string and urlencoded post data.
-    Make variables for each keyword in a query string. The buffer must be url encoded (ie. key=value&key2=value2..., 
-    spaces converted to '+' and all else should be %HEX encoded).
+    Add params from the query string or urlencoded post data to the param index. The buffer must be url encoded
+    (ie. key=value&key2=value2..., spaces converted to '+' and all else should be %HEX encoded). This makes a single
+    pass recording the key and value byte ranges. Keys are decoded in place when indexed. Values are decoded in place
+    only when requested via httpGetParam, so the buffer must be a private copy owned by the param index.
  */
-static void addParamsFromBuf(HttpConn *conn, cchar *buf, ssize len)
+static void addParamsFromBuf(HttpConn *conn, char *buf, ssize len)
 {
-    MprHash     *vars;
-    cchar       *oldValue;
-    char        *newValue, *decoded, *keyword, *value, *tok;
+    HttpParamIndex  *index;
+    HttpParam       *pp;
+    char            *cp, *end, *key, *value;
+    int             keyEscaped, valueEscaped;
+    ssize           keyLen;
 
     assert(conn);
-    vars = httpGetParams(conn);
-    decoded = mprAlloc(len + 1);
-    decoded[len] = '\0';
-    memcpy(decoded, buf, len);
-
-    keyword = stok(decoded, "&", &tok);
-    while (keyword != 0) {
-        if ((value = strchr(keyword, '=')) != 0) {
-            *value++ = '\0';
-            value = mprUriDecode(value);
+    index = getParamIndex(conn);
+
+    for (cp = buf, end = &buf[len]; cp < end; cp++) {
+        key = cp;
+        value = 0;
+        keyEscaped = valueEscaped = 0;
+        for (; cp < end && *cp != '&'; cp++) {
+            if (*cp == '=' && !value) {
+                value = cp + 1;
+            } else if (*cp == '%' || *cp == '+') {
+                if (value) {
+                    valueEscaped = 1;
+                } else {
+                    keyEscaped = 1;
+                }
+            }
+        }
+        keyLen = (value ? value - 1 : cp) - key;
+        if (keyEscaped) {
+            keyLen = decodeParam(key, keyLen);
+        }
+        if (keyLen <= 0) {
+            continue;
+        }
+        if (index->count >= index->size) {
+            index->size = max(index->size * 2, 16);
+            index->params = mprRealloc(index->params, index->size * sizeof(HttpParam));
+        }
+        pp = &index->params[index->count++];
+        pp->key = key;
+        pp->keyLen = (int) keyLen;
+        pp->code = hashParam(key, keyLen);
+        pp->next = 0;
+        if (value) {
+            pp->value = value;
+            pp->valueLen = (int) (cp - value);
+            pp->flags = valueEscaped ? PARAM_ESCAPED : 0;
         } else {
-            value = MPR->emptyString;
+            pp->value = MPR->emptyString;
+            pp->valueLen = 0;
+            pp->flags = PARAM_DECODED;
         }
-        keyword = mprUriDecode(keyword);
-
-        if (*keyword) {
-            /*
-                Append to existing keywords
-             */
-            oldValue = mprLookupKey(vars, keyword);
-            if (oldValue != 0 && *oldValue) {
-                if (*value) {
-                    newValue = sjoin(oldValue, " ", value, NULL);
-                    mprAddKey(vars, keyword, newValue);
-                }
-            } else {
-                /* No need to clone value as mprUriDecode already does this */
-                mprAddKey(vars, keyword, value);
+        index->pending++;
+    }
+}
+
+
+static HttpParamIndex *getParamIndex(HttpConn *conn)
+{
+    HttpRx      *rx;
+
+    rx = conn->rx;
+    if (rx->paramIndex == 0) {
+        rx->paramIndex = mprAllocObj(HttpParamIndex, manageParamIndex);
+    }
+    return rx->paramIndex;
+}
+
+
+static void manageParamIndex(HttpParamIndex *index, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(index->params);
+        mprMark(index->chains);
+        mprMark(index->query);
+        mprMark(index->body);
+    }
+}
+
+
+/*
+    Decode a url encoded range in place. Returns the decoded length.
+ */
+static ssize decodeParam(char *buf, ssize len)
+{
+    char    *ip, *op, *end;
+    int     num, i, c;
+
+    for (op = ip = buf, end = &buf[len]; ip < end; ip++, op++) {
+        if (*ip == '+') {
+            *op = ' ';
+
+        } else if (*ip == '%' && (end - ip) > 2 && isxdigit((uchar) ip[1]) && isxdigit((uchar) ip[2])) {
+            num = 0;
+            for (i = 1; i <= 2; i++) {
+                c = tolower((uchar) ip[i]);
+                num = (num * 16) + ((c >= 'a') ? 10 + c - 'a' : c - '0');
             }
+            *op = (char) num;
+            ip += 2;
+
+        } else {
+            *op = *ip;
         }
-        keyword = stok(0, "&", &tok);
     }
+    return op - buf;
 }
 
 
-#if KEEP
 /*
-    This operates without copying the buffer. It modifies the buffer.
+    Decode a param value in place on first use and null terminate
  */
-static void addParamsFromBufInsitu(HttpConn *conn, char *buf, ssize len)
+static cchar *getParamValue(HttpParam *pp)
 {
-    MprHash     *vars;
-    cchar       *oldValue;
-    char        *newValue, *keyword, *value, *tok;
+    if (!(pp->flags & PARAM_DECODED)) {
+        if (pp->flags & PARAM_ESCAPED) {
+            pp->valueLen = (int) decodeParam(pp->value, pp->valueLen);
+        }
+        pp->value[pp->valueLen] = '\0';
+        pp->flags |= PARAM_DECODED;
+    }
+    return pp->value;
+}
 
-    assert(conn);
-    vars = httpGetParams(conn);
 
-    keyword = stok(buf, "&", &tok);
-    while (keyword != 0) {
-        if ((value = strchr(keyword, '=')) != 0) {
-            *value++ = '\0';
-            mprUriDecodeBuf(value);
-        } else {
-            value = MPR->emptyString;
+/*
+    FNV-1a hash of the decoded key
+ */
+static uint hashParam(cchar *key, ssize len)
+{
+    uint    code;
+
+    for (code = 2166136261U; len-- > 0; key++) {
+        code = (code ^ (uchar) *key) * 16777619;
+    }
+    return code;
+}
+
+
+/*
+    Link params with the same hash onto chains in the order they were added. Chain links are indexes plus one.
+    This is done on the first lookup after params are added.
+ */
+static void hashParams(HttpParamIndex *index)
+{
+    HttpParam   *pp;
+    int         i, size;
+
+    if (index->hashed == index->count) {
+        return;
+    }
+    for (size = 16; size < index->count * 2; size *= 2) { }
+    if (size > index->mask + 1) {
+        index->chains = mprAlloc(size * sizeof(int));
+        index->mask = size - 1;
+    }
+    memset(index->chains, 0, (index->mask + 1) * sizeof(int));
+    for (i = index->count - 1; i >= 0; i--) {
+        pp = &index->params[i];
+        pp->next = index->chains[pp->code & index->mask];
+        index->chains[pp->code & index->mask] = i + 1;
+    }
+    index->hashed = index->count;
+}
+
+
+/*
+    Lookup a param without decoding other params. Indexed params are joined with a space to any value already in the
+    params table, in the order they were added, as for the complete params table. Params set via httpSetParam
+    supersede indexed params added before them.
+ */
+static cchar *lookupParam(HttpConn *conn, cchar *var)
+{
+    HttpParamIndex  *index;
+    HttpParam       *pp;
+    cchar           *value, *result;
+    ssize           len;
+    uint            code;
+    int             i, joined;
+
+    addJsonParams(conn);
+    result = conn->rx->params ? mprLookupKey(conn->rx->params, var) : 0;
+    if ((index = conn->rx->paramIndex) == 0 || index->pending == 0) {
+        return result;
+    }
+    hashParams(index);
+    len = slen(var);
+    code = hashParam(var, len);
+    joined = 0;
+    for (i = index->chains[code & index->mask]; i; i = pp->next) {
+        pp = &index->params[i - 1];
+        if (pp->code != code || pp->keyLen != len || (pp->flags & PARAM_ADDED) || memcmp(pp->key, var, len) != 0) {
+            continue;
         }
-        mprUriDecode(keyword);
-
-        if (*keyword) {
-            /*
-                Append to existing keywords
-             */
-            oldValue = mprLookupKey(vars, keyword);
-            if (oldValue != 0 && *oldValue) {
-                if (*value) {
-                    newValue = sjoin(oldValue, " ", value, NULL);
-                    mprAddKey(vars, keyword, newValue);
-                }
-            } else {
-                mprAddKey(vars, keyword, sclone(value));
+        value = getParamValue(pp);
+        if (!result || !*result) {
+            result = value;
+        } else if (*value) {
+            result = sjoin(result, " ", value, NULL);
+            joined = 1;
+        }
+    }
+    if (joined) {
+        /* Retain the joined value in the params table */
+        removeIndexedParam(conn, var);
+        mprAddKey(createParams(conn), var, result);
+    }
+    return result;
+}
+
+
+/*
+    Mark indexed params as superseded by a value in the params table
+ */
+static void removeIndexedParam(HttpConn *conn, cchar *var)
+{
+    HttpParamIndex  *index;
+    HttpParam       *pp;
+    ssize           len;
+    uint            code;
+    int             i;
+
+    if ((index = conn->rx->paramIndex) == 0 || index->pending == 0) {
+        return;
+    }
+    hashParams(index);
+    len = slen(var);
+    code = hashParam(var, len);
+    for (i = index->chains[code & index->mask]; i; i = pp->next) {
+        pp = &index->params[i - 1];
+        if (pp->code == code && pp->keyLen == len && !(pp->flags & PARAM_ADDED) && memcmp(pp->key, var, len) == 0) {
+            pp->flags |= PARAM_ADDED;
+            index->pending--;
+        }
+    }
+}
+
+
+/*
+    Enter all indexed params into the params table. Used when the caller requires the complete table.
+ */
+static void addIndexedParams(HttpConn *conn)
+{
+    HttpParamIndex  *index;
+    HttpParam       *pp;
+    MprHash         *vars;
+    cchar           *oldValue, *value;
+    int             i;
+
+    if ((index = conn->rx->paramIndex) == 0 || index->pending == 0) {
+        return;
+    }
+    vars = createParams(conn);
+    for (i = 0; i < index->count; i++) {
+        pp = &index->params[i];
+        if (pp->flags & PARAM_ADDED) {
+            continue;
+        }
+        value = getParamValue(pp);
+        pp->key[pp->keyLen] = '\0';
+        /*
+            Append to existing keywords
+         */
+        oldValue = mprLookupKey(vars, pp->key);
+        if (oldValue != 0 && *oldValue) {
+            if (*value) {
+                mprAddKey(vars, pp->key, sjoin(oldValue, " ", value, NULL));
             }
+        } else {
+            mprAddKey(vars, pp->key, sclone(value));
         }
-        keyword = stok(0, "&", &tok);
+        pp->flags |= PARAM_ADDED;
+    }
+    index->pending = 0;
+}
+
+
+/*
+    Enter the parsed JSON body into the params table. JSON values replace query params of the same name.
+ */
+static void addJsonParams(HttpConn *conn)
+{
+    HttpRx      *rx;
+
+    rx = conn->rx;
+    if (rx->jsonTape && (rx->flags & HTTP_ADDED_BODY_PARAMS) && !(rx->flags & HTTP_ADDED_JSON_PARAMS)) {
+        rx->flags |= HTTP_ADDED_JSON_PARAMS;
+        addIndexedParams(conn);
+        mprJsonTapeToHash(rx->jsonTape, createParams(conn));
     }
 }
-#endif
 
 
+static MprHash *createParams(HttpConn *conn)
+{
+    if (conn->rx->params == 0) {
+        conn->rx->params = mprCreateHash(HTTP_VAR_HASH_SIZE, MPR_HASH_OPEN);
+    }
+    return conn->rx->params;
+}
 
 
 PUBLIC void httpAddQueryParams(HttpConn *conn) 
 {
-    HttpRx      *rx;
+    HttpRx          *rx;
+    HttpParamIndex  *index;
 
     rx = conn->rx;
     if (rx->parsedUri->query && !(rx->flags & HTTP_ADDED_QUERY_PARAMS)) {
-        addParamsFromBuf(conn, rx->parsedUri->query, slen(rx->parsedUri->query));
+        /* The parsed URI query is retained for the request URI and logging and must not be modified, so index a copy */
+        index = getParamIndex(conn);
+        index->query = sclone(rx->parsedUri->query);
+        addParamsFromBuf(conn, index->query, slen(index->query));
         rx->flags |= HTTP_ADDED_QUERY_PARAMS;
     }
 }
 
 
+/*
+    Form body params are indexed in a private copy of the body content and decoded in place there as they are
+    accessed. The body content itself is not modified as handlers may still read the raw body from the read queue
+    or via httpGetBodyInput. For example, CGI passes the undecoded form body to the program.
+ */
 PUBLIC void httpAddBodyParams(HttpConn *conn)
 {
-    HttpRx      *rx;
-    HttpQueue   *q;
-    MprBuf      *content;
+    HttpRx          *rx;
+    HttpQueue       *q;
+    HttpParamIndex  *index;
+    MprBuf          *content;
 
     rx = conn->rx;
     q = conn->readq;
 
     if (rx->eof && !(rx->flags & HTTP_ADDED_BODY_PARAMS)) {
-        if (q->first && q->first->content) {
+        if (rx->jsonTape) {
+            /* The JSON body was parsed as it was received. It is converted to params on first use */
+            mprFinishJsonTape(rx->jsonTape);
+
+        } else if (q->first && q->first->content) {
             httpJoinPackets(q, -1);
             content = q->first->content;
             if (rx->form || rx->upload) {
                 mprAddNullToBuf(content);
                 mprTrace(6, "Form body data: length %d, \"%s\"", mprGetBufLength(content), mprGetBufStart(content));
-                addParamsFromBuf(conn, mprGetBufStart(content), mprGetBufLength(content));
+                index = getParamIndex(conn);
+                index->body = snclone(mprGetBufStart(content), mprGetBufLength(content));
+                addParamsFromBuf(conn, index->body, mprGetBufLength(content));
 
             } else if (sstarts(rx->mimeType, "application/json")) {
                 mprDeserializeInto(httpGetBodyInput(conn), httpGetParams(conn));
@@ -239,49 +514,48 @@ PUBLIC void httpAddJsonParams(HttpConn *conn)
     rx = conn->rx;
     if (rx->eof && sstarts(rx->mimeType, "application/json")) {
         if (!(rx->flags & HTTP_ADDED_BODY_PARAMS)) {
-            mprDeserializeInto(httpGetBodyInput(conn), httpGetParams(conn));
+            if (rx->jsonTape) {
+                mprFinishJsonTape(rx->jsonTape);
+            } else {
+                mprDeserializeInto(httpGetBodyInput(conn), httpGetParams(conn));
+            }
             rx->flags |= HTTP_ADDED_BODY_PARAMS;
         }
     }
 }
 
 
+/*
+    Get the complete params table. This decodes all pending indexed params.
+ */
 PUBLIC MprHash *httpGetParams(HttpConn *conn)
 { 
-    if (conn->rx->params == 0) {
-        conn->rx->params = mprCreateHash(HTTP_VAR_HASH_SIZE, 0);
-    }
-    return conn->rx->params;
+    addJsonParams(conn);
+    addIndexedParams(conn);
+    return createParams(conn);
 }
 
 
 PUBLIC int httpTestParam(HttpConn *conn, cchar *var)
 {
-    MprHash    *vars;
-
-    vars = httpGetParams(conn);
-    return vars && mprLookupKey(vars, var) != 0;
+    return lookupParam(conn, var) != 0;
 }
 
 
 PUBLIC cchar *httpGetParam(HttpConn *conn, cchar *var, cchar *defaultValue)
 {
-    MprHash     *vars;
     cchar       *value;
 
-    vars = httpGetParams(conn);
-    value = mprLookupKey(vars, var);
+    value = lookupParam(conn, var);
     return (value) ? value : defaultValue;
 }
 
 
 PUBLIC int httpGetIntParam(HttpConn *conn, cchar *var, int defaultValue)
 {
-    MprHash     *vars;
     cchar       *value;
 
-    vars = httpGetParams(conn);
-    value = mprLookupKey(vars, var);
+    value = lookupParam(conn, var);
     return (value) ? (int) stoi(value) : defaultValue;
 }
 
@@ -311,7 +585,8 @@ PUBLIC char *httpGetParamsString(HttpConn *conn)
     rx = conn->rx;
 
     if (rx->paramString == 0) {
-        if ((params = conn->rx->params) != 0) {
+        if (rx->params || rx->paramIndex || rx->jsonTape) {
+            params = httpGetParams(conn);
             if ((list = mprCreateList(mprGetHashLength(params), 0)) != 0) {
                 len = 0;
                 for (kp = 0; (kp = mprGetNextKey(params, kp)) != NULL; ) {
@@ -327,7 +602,10 @@ PUBLIC char *httpGetParamsString(HttpConn *conn)
                         strcpy(cp, kp->data); cp += slen(kp->data);
                         *cp++ = '&';
                     }
-                    cp[-1] = '\0';
+                    *cp = '\0';
+                    if (cp > buf) {
+                        cp[-1] = '\0';
+                    }
                     rx->paramString = buf;
                 }
             }
@@ -339,19 +617,17 @@ PUBLIC char *httpGetParamsString(HttpConn *conn)
 
 PUBLIC void httpSetParam(HttpConn *conn, cchar *var, cchar *value) 
 {
-    MprHash     *vars;
-
-    vars = httpGetParams(conn);
-    mprAddKey(vars, var, sclone(value));
+    addJsonParams(conn);
+    removeIndexedParam(conn, var);
+    mprAddKey(createParams(conn), var, sclone(value));
 }
 
 
 PUBLIC void httpSetIntParam(HttpConn *conn, cchar *var, int value) 
 {
-    MprHash     *vars;
-
-    vars = httpGetParams(conn);
-    mprAddKey(vars, var, sfmt("%d", value));
+    addJsonParams(conn);
+    removeIndexedParam(conn, var);
+    mprAddKey(createParams(conn), var, sfmt("%d", value));
 }
 
 
@@ -0,0 +1,33 @@
+/*
+    rate.tst - Open-loop load tests
+ */
+
+load("support.es")
+
+//  All requests scheduled for the duration are issued and completed
+let result = deserialize(run("--rate 100 --duration 1 --json /index.html"))
+assert(result.target == 100)
+assert(result.issued == 100)
+assert(result.completed == 100)
+assert(result.errors["4xx"] == 0 && result.errors["5xx"] == 0 && result.errors.timeout == 0)
+assert(result.errors.connect == 0 && result.errors.io == 0)
+assert(result.latency.p50 <= result.latency.p99 && result.latency.p99 <= result.latency.max)
+
+//  The rate is divided over the load threads
+result = deserialize(run("--threads 2 --rate 100 --duration 1 --json /index.html"))
+assert(result.issued == 100)
+assert(result.completed == 100)
+
+//  Errors are counted by kind
+result = deserialize(run("--continue --rate 50 --duration 1 --json /missing.html"))
+assert(result.completed == 50)
+assert(result.errors["4xx"] == 50)
+
+result = deserialize(run("--continue --host 127.0.0.1:9 --rate 20 --duration 1 --json /index.html"))
+assert(result.completed == 20)
+assert(result.errors.connect == 20)
+
+if (test.depth > 2) {
+    run("--rate 1000 --duration 5 --connections 32 /index.html")
+    run("--threads 4 --rate 2000 --duration 5 /big.txt")
+}
@@ -5,15 +5,75 @@
 
 /********************************** Includes **********************************/
 
-#include    "mpr.h"
+#include    "testHttp.h"
+
+/*********************************** Locals ***********************************/
+/*
+    Request state held while the test thread yields for socket I/O
+ */
+typedef struct TestRequest {
+    char            *headers;
+    char            *body;
+    MprBuf          *response;
+} TestRequest;
+
+static HttpEndpoint *endpoint;
+
+static void manageTestRequest(TestRequest *req, int flags);
 
 /****************************** Test Definitions ******************************/
 
 extern MprTestDef testHttpGen;
+extern MprTestDef testHttpParams;
+extern MprTestDef testHttp2;
+extern MprTestDef testHttpAuth;
+extern MprTestDef testHttpBatch;
+extern MprTestDef testHttpClient;
+extern MprTestDef testHttpHash;
+extern MprTestDef testHttpCache;
+extern MprTestDef testHttpRoute;
+extern MprTestDef testHttpJson;
+extern MprTestDef testHttpSession;
+extern MprTestDef testHttpFiles;
+#if BIT_UNIX_LIKE
+extern MprTestDef testHttpStore;
+#endif
+#if BIT_PACK_ZLIB
+extern MprTestDef testHttpCompress;
+#endif
+#if BIT_PACK_SSL
+extern MprTestDef testHttpSsl;
+#endif
+#if BIT_PACK_EST
+extern MprTestDef testHttpCrypto;
+#endif
 
 static MprTestDef *testGroups[] = 
 {
     &testHttpGen,
+    &testHttpParams,
+    &testHttp2,
+    &testHttpAuth,
+    &testHttpBatch,
+    &testHttpClient,
+    &testHttpHash,
+    &testHttpCache,
+    &testHttpRoute,
+    &testHttpJson,
+    &testHttpSession,
+    &testHttpFiles,
+#if BIT_UNIX_LIKE
+    &testHttpStore,
+#endif
+#if BIT_PACK_ZLIB
+    &testHttpCompress,
+#endif
+#if BIT_PACK_SSL
+    &testHttpSsl,
+#endif
+#if BIT_PACK_EST
+    &testHttpCrypto,
+#endif
     0
 };
  
@@ -27,6 +87,145 @@ static MprTestDef master = {
 
 /************************************* Code ***********************************/
 
+PUBLIC HttpRoute *testGetRoute()
+{
+    HttpRoute   *route;
+
+    if (!endpoint) {
+        httpCreate(HTTP_CLIENT_SIDE | HTTP_SERVER_SIDE);
+        if ((endpoint = httpCreateConfiguredEndpoint(".", ".", "127.0.0.1", TEST_PORT)) == 0) {
+            return 0;
+        }
+        mprAddRoot(endpoint);
+        route = httpGetHostDefaultRoute(mprGetFirstItem(endpoint->hosts));
+        /* The chunk filter is required to send responses that are finalized without a content length */
+        httpAddRouteFilter(route, "chunkFilter", NULL, HTTP_STAGE_RX | HTTP_STAGE_TX);
+        httpSetRouteHandler(route, "actionHandler");
+        if (httpStartEndpoint(endpoint) < 0) {
+            mprRemoveRoot(endpoint);
+            endpoint = 0;
+            return 0;
+        }
+    }
+    return httpGetHostDefaultRoute(mprGetFirstItem(endpoint->hosts));
+}
+
+
+static void stopEndpoint()
+{
+    if (endpoint) {
+        httpStopEndpoint(endpoint);
+        httpDestroyEndpoint(endpoint);
+        mprRemoveRoot(endpoint);
+        endpoint = 0;
+    }
+}
+
+
+PUBLIC int testConnect()
+{
+    struct sockaddr_in  addr;
+    int                 fd;
+
+    if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TEST_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    mprYield(MPR_YIELD_STICKY);
+    if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0) {
+        close(fd);
+        fd = -1;
+    }
+    mprResetYield();
+    return fd;
+}
+
+
+/*
+    Memory must not be allocated while the thread is yielded, so the request only yields around blocking socket
+    calls. Collection may run when the yield is reset, so the headers, body and response are copied and held by a
+    root before connecting.
+ */
+PUBLIC MprBuf *testRequest(cchar *headers, cchar *body, ssize pieceSize)
+{
+    TestRequest     *req;
+    struct pollfd   pfd;
+    char            chunk[32], block[BIT_MAX_BUFFER];
+    ssize           len, pos, n, rc;
+    int             fd, chunked;
+
+    req = mprAllocObj(TestRequest, manageTestRequest);
+    req->headers = sclone(headers);
+    req->body = sclone(body);
+    req->response = mprCreateBuf(0, 0);
+    mprAddRoot(req);
+    if ((fd = testConnect()) < 0) {
+        mprRemoveRoot(req);
+        return 0;
+    }
+    chunked = scontains(headers, "chunked") != 0;
+    len = slen(body);
+    if (pieceSize <= 0) {
+        pieceSize = max(len, 1);
+    }
+
+    mprYield(MPR_YIELD_STICKY);
+    rc = write(fd, req->headers, slen(req->headers));
+    for (pos = 0; rc >= 0 && pos < len; pos += n) {
+        n = min(pieceSize, len - pos);
+        if (chunked) {
+            fmt(chunk, sizeof(chunk), "\r\n%x\r\n", (int) n);
+            if ((rc = write(fd, chunk, slen(chunk))) < 0) {
+                break;
+            }
+        }
+        rc = write(fd, &req->body[pos], n);
+    }
+    if (chunked && rc >= 0) {
+        rc = write(fd, "\r\n0\r\n\r\n", 7);
+    }
+    mprResetYield();
+
+    while (1) {
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        mprYield(MPR_YIELD_STICKY);
+        rc = (poll(&pfd, 1, TEST_TIMEOUT) > 0) ? read(fd, block, sizeof(block)) : 0;
+        mprResetYield();
+        if (rc <= 0) {
+            break;
+        }
+        mprPutBlockToBuf(req->response, block, rc);
+    }
+    close(fd);
+    mprAddNullToBuf(req->response);
+    mprRemoveRoot(req);
+    return req->response;
+}
+
+
+PUBLIC int testGetStatus(MprBuf *response)
+{
+    if (!response || mprGetBufLength(response) < 12 || !sstarts(mprGetBufStart(response), "HTTP/1.1 ")) {
+        return 0;
+    }
+    return (int) stoi(&mprGetBufStart(response)[9]);
+}
+
+
+static void manageTestRequest(TestRequest *req, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(req->headers);
+        mprMark(req->body);
+        mprMark(req->response);
+    }
+}
+
+
 MAIN(testMain, int argc, char **argv, char **envp) 
 {
     Mpr             *mpr;
@@ -35,6 +234,8 @@ MAIN(testMain, int argc, char **argv, char **envp)
     int             rc;
 
     mpr = mprCreate(argc, argv, MPR_USER_EVENTS_THREAD);
+    /* Ignore SIGPIPE when peers close connections */
+    mprAddStandardSignals();
 
 #if VXWORKS || WINCE
     /*
@@ -75,6 +276,7 @@ MAIN(testMain, int argc, char **argv, char **envp)
      */
     rc = mprRunTests(ts);
     mprReportTestResults(ts);
+    stopEndpoint();
 
     return (rc == 0) ? 0 : 6;
 }
@@ -0,0 +1,78 @@
+/**
+    testHttp.h - shared endpoint and request helpers for the Http unit tests
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+#ifndef _h_TEST_HTTP
+#define _h_TEST_HTTP 1
+
+/********************************** Includes **********************************/
+
+#include    "http.h"
+
+/*********************************** Defines **********************************/
+
+#define TEST_PORT       18290
+#define TEST_URI        "http://127.0.0.1:18290"
+#define TEST_TIMEOUT    5000
+
+/********************************* Prototypes *********************************/
+/*
+    Get the default route of the test endpoint. The endpoint is created and started on first use. Groups define
+    their actions and add their own routes to this route's host.
+ */
+PUBLIC HttpRoute *testGetRoute();
+
+/*
+    Connect a blocking socket to the test endpoint. Returns the socket or -1 on errors.
+ */
+PUBLIC int testConnect();
+
+/*
+    Send a request on a new connection to the test endpoint and return the response after the server closes the
+    connection. The body is written in pieces of pieceSize bytes. If the headers specify chunked transfer encoding,
+    each piece is sent as a chunk and the headers must not be terminated by a blank line.
+ */
+PUBLIC MprBuf *testRequest(cchar *headers, cchar *body, ssize pieceSize);
+
+/*
+    Get the status code from a response returned by testRequest. Returns zero if the response is not valid.
+ */
+PUBLIC int testGetStatus(MprBuf *response);
+
+#endif /* _h_TEST_HTTP */
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -0,0 +1,676 @@
+/**
+    testHttp2.c - tests for HPACK and HTTP/2 framing and flow control
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "testHttp.h"
+
+/*********************************** Locals ***********************************/
+
+#define LARGE_SIZE      256
+
+/*
+    Frame received from the server
+ */
+typedef struct Frame {
+    int         type;
+    int         flags;
+    int         id;
+    int         len;
+    uchar       data[HTTP2_FRAME_SIZE + 1];
+} Frame;
+
+/*
+    Buffers used while the test thread yields for socket I/O must be held here so they are not collected
+ */
+typedef struct TestHttp2 {
+    HttpHpack       *encoder;
+    HttpHpack       *decoder;
+    MprList         *headers;
+    MprBuf          *buf;
+    MprBuf          *body;
+    Frame           *frame;
+    int             fd;
+} TestHttp2;
+
+static void manageTestHttp2(TestHttp2 *th, int flags);
+
+/************************************ Code ************************************/
+
+static void helloAction(HttpConn *conn)
+{
+    httpSetContentType(conn, "text/plain");
+    httpWrite(conn->writeq, "Hello World\n");
+    httpFinalize(conn);
+}
+
+
+static void largeAction(HttpConn *conn)
+{
+    char    buf[LARGE_SIZE];
+
+    memset(buf, 'x', sizeof(buf));
+    httpSetContentType(conn, "text/plain");
+    httpWriteBlock(conn->writeq, buf, sizeof(buf), HTTP_BLOCK);
+    httpFinalize(conn);
+}
+
+
+/*
+    Never read the request body. The request is completed when the client closes the connection.
+ */
+static void stallAction(HttpConn *conn)
+{
+}
+
+
+static int initHttp2(MprTestGroup *gp)
+{
+    TestHttp2   *th;
+
+    gp->data = th = mprAllocObj(TestHttp2, manageTestHttp2);
+    th->fd = -1;
+    if (testGetRoute() == 0) {
+        return MPR_ERR_CANT_OPEN;
+    }
+    httpDefineAction("/h2/hello", helloAction);
+    httpDefineAction("/h2/large", largeAction);
+    httpDefineAction("/h2/stall", stallAction);
+    return 0;
+}
+
+
+static void manageTestHttp2(TestHttp2 *th, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(th->encoder);
+        mprMark(th->decoder);
+        mprMark(th->headers);
+        mprMark(th->buf);
+        mprMark(th->body);
+        mprMark(th->frame);
+    }
+}
+
+
+/*
+    Return the value of a decoded header
+ */
+static cchar *getHeader(MprList *headers, cchar *name)
+{
+    MprKeyValue     *pair;
+    int             next;
+
+    for (ITERATE_ITEMS(headers, pair, next)) {
+        if (smatch(pair->key, name)) {
+            return pair->value;
+        }
+    }
+    return 0;
+}
+
+
+/*
+    Decode a hex encoded header block from RFC 7541 appendix C
+ */
+static ssize fromHex(cchar *hex, uchar *buf)
+{
+    ssize   len;
+    int     c;
+
+    for (len = 0; *hex; ) {
+        if (isspace((uchar) *hex)) {
+            hex++;
+            continue;
+        }
+        sscanf(hex, "%2x", &c);
+        buf[len++] = (uchar) c;
+        hex += 2;
+    }
+    return len;
+}
+
+
+static int decode(MprTestGroup *gp, HttpHpack *hp, cchar *hex)
+{
+    TestHttp2   *th;
+    uchar       block[256];
+    ssize       len;
+
+    th = gp->data;
+    th->headers = mprCreateList(0, 0);
+    len = fromHex(hex, block);
+    return httpHpackDecode(hp, th->headers, block, len, 8192);
+}
+
+
+/*
+    Requests from RFC 7541 C.3 (without Huffman coding) share the one dynamic table
+ */
+static void testHpackDecode(MprTestGroup *gp)
+{
+    TestHttp2   *th;
+    HttpHpack   *hp;
+
+    th = gp->data;
+    th->decoder = hp = httpCreateHpack(HTTP2_TABLE_SIZE);
+
+    tassert(decode(gp, hp, "828684410f7777772e6578616d706c652e636f6d") == 0);
+    tassert(mprGetListLength(th->headers) == 4);
+    tassert(smatch(getHeader(th->headers, ":method"), "GET"));
+    tassert(smatch(getHeader(th->headers, ":scheme"), "http"));
+    tassert(smatch(getHeader(th->headers, ":path"), "/"));
+    tassert(smatch(getHeader(th->headers, ":authority"), "www.example.com"));
+    tassert(hp->size == 57);
+
+    tassert(decode(gp, hp, "828684be58086e6f2d6361636865") == 0);
+    tassert(mprGetListLength(th->headers) == 5);
+    tassert(smatch(getHeader(th->headers, ":authority"), "www.example.com"));
+    tassert(smatch(getHeader(th->headers, "cache-control"), "no-cache"));
+    tassert(hp->size == 110);
+
+    tassert(decode(gp, hp, "828785bf400a637573746f6d2d6b65790c637573746f6d2d76616c7565") == 0);
+    tassert(smatch(getHeader(th->headers, ":scheme"), "https"));
+    tassert(smatch(getHeader(th->headers, ":path"), "/index.html"));
+    tassert(smatch(getHeader(th->headers, ":authority"), "www.example.com"));
+    tassert(smatch(getHeader(th->headers, "custom-key"), "custom-value"));
+    tassert(hp->size == 164);
+}
+
+
+/*
+    Requests from RFC 7541 C.4 (with Huffman coding)
+ */
+static void testHpackHuffman(MprTestGroup *gp)
+{
+    TestHttp2   *th;
+    HttpHpack   *hp;
+
+    th = gp->data;
+    th->decoder = hp = httpCreateHpack(HTTP2_TABLE_SIZE);
+
+    tassert(decode(gp, hp, "828684418cf1e3c2e5f23a6ba0ab90f4ff") == 0);
+    tassert(smatch(getHeader(th->headers, ":authority"), "www.example.com"));
+
+    tassert(decode(gp, hp, "828684be5886a8eb10649cbf") == 0);
+    tassert(smatch(getHeader(th->headers, "cache-control"), "no-cache"));
+
+    tassert(decode(gp, hp, "828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf") == 0);
+    tassert(smatch(getHeader(th->headers, "custom-key"), "custom-value"));
+    tassert(hp->size == 164);
+}
+
+
+static void testHpackRoundTrip(MprTestGroup *gp)
+{
+    TestHttp2   *th;
+    MprBuf      *buf;
+    ssize       first;
+    int         i;
+
+    th = gp->data;
+    th->encoder = httpCreateHpack(HTTP2_TABLE_SIZE);
+    th->decoder = httpCreateHpack(HTTP2_TABLE_SIZE);
+    buf = mprCreateBuf(0, 0);
+    first = 0;
+
+    for (i = 0; i < 2; i++) {
+        mprFlushBuf(buf);
+        httpHpackEncode(th->encoder, buf, ":status", "200");
+        httpHpackEncode(th->encoder, buf, "content-type", "text/html");
+        httpHpackEncode(th->encoder, buf, "x-custom", "Mixed Case Value with spaces");
+        httpHpackEncode(th->encoder, buf, "x-empty", "");
+        th->headers = mprCreateList(0, 0);
+        tassert(httpHpackDecode(th->decoder, th->headers, (uchar*) mprGetBufStart(buf), mprGetBufLength(buf),
+            8192) == 0);
+        tassert(mprGetListLength(th->headers) == 4);
+        tassert(smatch(getHeader(th->headers, ":status"), "200"));
+        tassert(smatch(getHeader(th->headers, "content-type"), "text/html"));
+        tassert(smatch(getHeader(th->headers, "x-custom"), "Mixed Case Value with spaces"));
+        tassert(smatch(getHeader(th->headers, "x-empty"), ""));
+        if (i == 0) {
+            first = mprGetBufLength(buf);
+        } else {
+            /* Repeated headers are sent as dynamic table references */
+            tassert(mprGetBufLength(buf) < first);
+        }
+    }
+    tassert(th->encoder->size == th->decoder->size);
+
+    /* A reduced table size is signalled to the decoder in the next header block */
+    httpSetHpackSize(th->encoder, 0);
+    mprFlushBuf(buf);
+    httpHpackEncode(th->encoder, buf, "x-custom", "Mixed Case Value with spaces");
+    th->headers = mprCreateList(0, 0);
+    tassert(httpHpackDecode(th->decoder, th->headers, (uchar*) mprGetBufStart(buf), mprGetBufLength(buf), 8192) == 0);
+    tassert(smatch(getHeader(th->headers, "x-custom"), "Mixed Case Value with spaces"));
+    tassert(th->decoder->size == 0);
+}
+
+
+static void testHpackErrors(MprTestGroup *gp)
+{
+    HttpHpack   *hp;
+
+    hp = httpCreateHpack(HTTP2_TABLE_SIZE);
+    mprAddRoot(hp);
+
+    /* Index zero and an index beyond the dynamic table */
+    tassert(decode(gp, hp, "80") < 0);
+    tassert(decode(gp, hp, "ff20") < 0);
+
+    /* Truncated literal and truncated integer */
+    tassert(decode(gp, hp, "400a637573746f6d") < 0);
+    tassert(decode(gp, hp, "7f") < 0);
+
+    /* Table size update larger than the maximum */
+    tassert(decode(gp, hp, "3fe21f") < 0);
+
+    /* Decoded headers larger than the limit */
+    tassert(decode(gp, hp, "828684410f7777772e6578616d706c652e636f6d") == 0);
+    tassert(httpHpackDecode(hp, mprCreateList(0, 0), (uchar*) "\x82\x86\x84", 3, 10) < 0);
+    mprRemoveRoot(hp);
+}
+
+
+static void putFrame(MprBuf *buf, int type, int flags, int id, cvoid *data, ssize len)
+{
+    mprPutCharToBuf(buf, (int) ((len >> 16) & 0xFF));
+    mprPutCharToBuf(buf, (int) ((len >> 8) & 0xFF));
+    mprPutCharToBuf(buf, (int) (len & 0xFF));
+    mprPutCharToBuf(buf, type);
+    mprPutCharToBuf(buf, flags);
+    mprPutCharToBuf(buf, (id >> 24) & 0x7F);
+    mprPutCharToBuf(buf, (id >> 16) & 0xFF);
+    mprPutCharToBuf(buf, (id >> 8) & 0xFF);
+    mprPutCharToBuf(buf, id & 0xFF);
+    if (len > 0) {
+        mprPutBlockToBuf(buf, data, len);
+    }
+}
+
+
+static void putUint32(uchar *data, uint value)
+{
+    data[0] = (uchar) (value >> 24);
+    data[1] = (uchar) (value >> 16);
+    data[2] = (uchar) (value >> 8);
+    data[3] = (uchar) value;
+}
+
+
+static int sendBuf(int fd, MprBuf *buf)
+{
+    ssize   rc;
+
+    mprYield(MPR_YIELD_STICKY);
+    while (mprGetBufLength(buf) > 0) {
+        if ((rc = write(fd, mprGetBufStart(buf), mprGetBufLength(buf))) <= 0) {
+            break;
+        }
+        mprAdjustBufStart(buf, rc);
+    }
+    mprResetYield();
+    return mprGetBufLength(buf) == 0 ? 0 : MPR_ERR_CANT_WRITE;
+}
+
+
+static int readBytes(int fd, uchar *buf, ssize len, int timeout)
+{
+    struct pollfd   pfd;
+    ssize           rc;
+
+    mprYield(MPR_YIELD_STICKY);
+    while (len > 0) {
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, timeout) <= 0 || (rc = read(fd, buf, len)) <= 0) {
+            break;
+        }
+        buf += rc;
+        len -= rc;
+    }
+    mprResetYield();
+    return len == 0 ? 0 : MPR_ERR_CANT_READ;
+}
+
+
+/*
+    Read the next frame. Returns an error on timeout or if the server closed the connection.
+ */
+static int readFrame(int fd, Frame *frame, int timeout)
+{
+    uchar   hdr[HTTP2_FRAME_HEADER_SIZE];
+
+    if (readBytes(fd, hdr, sizeof(hdr), timeout) < 0) {
+        return MPR_ERR_CANT_READ;
+    }
+    frame->len = (hdr[0] << 16) | (hdr[1] << 8) | hdr[2];
+    frame->type = hdr[3];
+    frame->flags = hdr[4];
+    frame->id = ((hdr[5] & 0x7F) << 24) | (hdr[6] << 16) | (hdr[7] << 8) | hdr[8];
+    if (frame->len > HTTP2_FRAME_SIZE || readBytes(fd, frame->data, frame->len, timeout) < 0) {
+        return MPR_ERR_CANT_READ;
+    }
+    return 0;
+}
+
+
+/*
+    Open a connection with the preface and an optional initial stream window setting
+ */
+static MprBuf *openConnection(MprTestGroup *gp, int window)
+{
+    TestHttp2   *th;
+    MprBuf      *buf;
+    uchar       settings[6];
+
+    th = gp->data;
+    th->encoder = httpCreateHpack(HTTP2_TABLE_SIZE);
+    th->decoder = httpCreateHpack(HTTP2_TABLE_SIZE);
+    th->fd = testConnect();
+    tassert(th->fd >= 0);
+
+    buf = th->buf = mprCreateBuf(0, 0);
+    mprPutStringToBuf(buf, HTTP2_PREFACE);
+    if (window >= 0) {
+        settings[0] = 0;
+        settings[1] = HTTP2_INITIAL_WINDOW;
+        putUint32(&settings[2], window);
+        putFrame(buf, HTTP2_SETTINGS_FRAME, 0, 0, settings, sizeof(settings));
+    } else {
+        putFrame(buf, HTTP2_SETTINGS_FRAME, 0, 0, NULL, 0);
+    }
+    return buf;
+}
+
+
+static void closeConnection(MprTestGroup *gp)
+{
+    TestHttp2   *th;
+
+    th = gp->data;
+    if (th->fd >= 0) {
+        close(th->fd);
+        th->fd = -1;
+    }
+}
+
+
+static void putRequest(MprTestGroup *gp, MprBuf *buf, int id, cchar *method, cchar *path, int flags)
+{
+    TestHttp2   *th;
+    MprBuf      *block;
+
+    th = gp->data;
+    block = mprCreateBuf(0, 0);
+    httpHpackEncode(th->encoder, block, ":method", method);
+    httpHpackEncode(th->encoder, block, ":scheme", "http");
+    httpHpackEncode(th->encoder, block, ":path", path);
+    httpHpackEncode(th->encoder, block, ":authority", "localhost");
+    putFrame(buf, HTTP2_HEADERS_FRAME, flags, id, mprGetBufStart(block), mprGetBufLength(block));
+}
+
+
+/*
+    Read frames until a GOAWAY and return its error code
+ */
+static int readGoaway(MprTestGroup *gp)
+{
+    TestHttp2   *th;
+    Frame       *frame;
+    int         code;
+
+    th = gp->data;
+    frame = th->frame = mprAlloc(sizeof(Frame));
+    code = -1;
+    while (readFrame(th->fd, frame, TEST_TIMEOUT) == 0) {
+        if (frame->type == HTTP2_GOAWAY_FRAME && frame->len >= 8) {
+            code = (frame->data[4] << 24) | (frame->data[5] << 16) | (frame->data[6] << 8) | frame->data[7];
+            break;
+        }
+    }
+    return code;
+}
+
+
+static void testHttp2Request(MprTestGroup *gp)
+{
+    TestHttp2   *th;
+    MprBuf      *buf, *body;
+    Frame       *frame;
+    int         status;
+
+    th = gp->data;
+    buf = openConnection(gp, -1);
+    putRequest(gp, buf, 1, "GET", "/h2/hello", HTTP2_END_HEADERS_FLAG | HTTP2_END_STREAM_FLAG);
+    tassert(sendBuf(th->fd, buf) == 0);
+
+    frame = th->frame = mprAlloc(sizeof(Frame));
+    body = th->body = mprCreateBuf(0, 0);
+    status = 0;
+    while (readFrame(th->fd, frame, TEST_TIMEOUT) == 0) {
+        if (frame->type == HTTP2_HEADERS_FRAME && frame->id == 1) {
+            th->headers = mprCreateList(0, 0);
+            tassert(httpHpackDecode(th->decoder, th->headers, frame->data, frame->len, 8192) == 0);
+            status = (int) stoi(getHeader(th->headers, ":status"));
+        } else if (frame->type == HTTP2_DATA_FRAME && frame->id == 1) {
+            mprPutBlockToBuf(body, (char*) frame->data, frame->len);
+        }
+        tassert(frame->type != HTTP2_RESET_FRAME && frame->type != HTTP2_GOAWAY_FRAME);
+        if (frame->id == 1 && (frame->flags & HTTP2_END_STREAM_FLAG)) {
+            break;
+        }
+    }
+    mprAddNullToBuf(body);
+    tassert(status == 200);
+    tassert(smatch(mprGetBufStart(body), "Hello World\n"));
+    closeConnection(gp);
+}
+
+
+/*
+    The server must not send more response data than the client's stream window allows
+ */
+static void testHttp2SendWindow(MprTestGroup *gp)
+{
+    TestHttp2   *th;
+    MprBuf      *buf;
+    Frame       *frame;
+    uchar       increment[4];
+    ssize       received;
+    int         ended;
+
+    th = gp->data;
+    buf = openConnection(gp, 16);
+    putRequest(gp, buf, 1, "GET", "/h2/large", HTTP2_END_HEADERS_FLAG | HTTP2_END_STREAM_FLAG);
+    tassert(sendBuf(th->fd, buf) == 0);
+
+    frame = th->frame = mprAlloc(sizeof(Frame));
+    received = 0;
+    ended = 0;
+    while (readFrame(th->fd, frame, 500) == 0) {
+        if (frame->type == HTTP2_DATA_FRAME && frame->id == 1) {
+            received += frame->len;
+            ended = frame->flags & HTTP2_END_STREAM_FLAG;
+        }
+    }
+    tassert(received == 16);
+    tassert(!ended);
+
+    /* Opening the stream window releases the rest of the response */
+    putUint32(increment, LARGE_SIZE);
+    putFrame(buf, HTTP2_WINDOW_FRAME, 0, 1, increment, sizeof(increment));
+    tassert(sendBuf(th->fd, buf) == 0);
+    while (!ended && readFrame(th->fd, frame, TEST_TIMEOUT) == 0) {
+        if (frame->type == HTTP2_DATA_FRAME && frame->id == 1) {
+            received += frame->len;
+            ended = frame->flags & HTTP2_END_STREAM_FLAG;
+        }
+    }
+    tassert(ended);
+    tassert(received == LARGE_SIZE);
+    closeConnection(gp);
+}
+
+
+/*
+    Send request body data on stream one and return the total of the window increments received for the stream
+ */
+static ssize receiveCredit(MprTestGroup *gp, ssize len)
+{
+    TestHttp2   *th;
+    MprBuf      *buf;
+    Frame       *frame;
+    uchar       data[HTTP2_FRAME_SIZE];
+    ssize       credit, n;
+
+    th = gp->data;
+    buf = openConnection(gp, -1);
+    putRequest(gp, buf, 1, "POST", "/h2/stall", HTTP2_END_HEADERS_FLAG);
+    memset(data, 'x', sizeof(data));
+    while (len > 0) {
+        n = min(len, sizeof(data));
+        putFrame(buf, HTTP2_DATA_FRAME, 0, 1, data, n);
+        len -= n;
+    }
+    tassert(sendBuf(th->fd, buf) == 0);
+
+    frame = th->frame = mprAlloc(sizeof(Frame));
+    credit = 0;
+    while (readFrame(th->fd, frame, 500) == 0) {
+        tassert(frame->type != HTTP2_RESET_FRAME && frame->type != HTTP2_GOAWAY_FRAME);
+        if (frame->type == HTTP2_WINDOW_FRAME && frame->id == 1 && frame->len == 4) {
+            credit += (frame->data[0] << 24) | (frame->data[1] << 16) | (frame->data[2] << 8) | frame->data[3];
+        }
+    }
+    closeConnection(gp);
+    return credit;
+}
+
+
+/*
+    Receive credit is returned for body data the stream can buffer and withheld while the stream read queue is full
+ */
+static void testHttp2ReceiveWindow(MprTestGroup *gp)
+{
+    /* Half the stream window fits in the read queue, so the stream credit is returned */
+    tassert(receiveCredit(gp, HTTP2_WINDOW / 2) == HTTP2_WINDOW / 2);
+
+    /* More than the read queue maximum and the handler never reads, so no credit is returned */
+    tassert(receiveCredit(gp, BIT_MAX_QBUFFER + HTTP2_FRAME_SIZE) == 0);
+}
+
+
+/*
+    Frames that violate the protocol are connection errors reported via GOAWAY
+ */
+static void testHttp2ConnectionErrors(MprTestGroup *gp)
+{
+    TestHttp2   *th;
+    MprBuf      *buf;
+    uchar       data[HTTP2_FRAME_SIZE + 1], settings[6];
+
+    th = gp->data;
+    memset(data, 0, sizeof(data));
+
+    /* DATA on stream zero */
+    buf = openConnection(gp, -1);
+    putFrame(buf, HTTP2_DATA_FRAME, 0, 0, "abc", 3);
+    tassert(sendBuf(th->fd, buf) == 0);
+    tassert(readGoaway(gp) == HTTP2_PROTOCOL_ERROR);
+    closeConnection(gp);
+
+    /* Frame larger than the maximum frame size */
+    buf = openConnection(gp, -1);
+    putFrame(buf, HTTP2_DATA_FRAME, 0, 1, data, sizeof(data));
+    tassert(sendBuf(th->fd, buf) == 0);
+    tassert(readGoaway(gp) == HTTP2_FRAME_SIZE_ERROR);
+    closeConnection(gp);
+
+    /* Zero window increment */
+    buf = openConnection(gp, -1);
+    putFrame(buf, HTTP2_WINDOW_FRAME, 0, 0, data, 4);
+    tassert(sendBuf(th->fd, buf) == 0);
+    tassert(readGoaway(gp) == HTTP2_PROTOCOL_ERROR);
+    closeConnection(gp);
+
+    /* Window increment that overflows the connection send window */
+    buf = openConnection(gp, -1);
+    putUint32(data, HTTP2_MAX_WINDOW);
+    putFrame(buf, HTTP2_WINDOW_FRAME, 0, 0, data, 4);
+    tassert(sendBuf(th->fd, buf) == 0);
+    tassert(readGoaway(gp) == HTTP2_FLOW_CONTROL_ERROR);
+    closeConnection(gp);
+
+    /* Initial window setting larger than the maximum window */
+    buf = openConnection(gp, -1);
+    settings[0] = 0;
+    settings[1] = HTTP2_INITIAL_WINDOW;
+    putUint32(&settings[2], (uint) HTTP2_MAX_WINDOW + 1);
+    putFrame(buf, HTTP2_SETTINGS_FRAME, 0, 0, settings, sizeof(settings));
+    tassert(sendBuf(th->fd, buf) == 0);
+    tassert(readGoaway(gp) == HTTP2_FLOW_CONTROL_ERROR);
+    closeConnection(gp);
+
+    /* Header block interrupted by a frame other than CONTINUATION */
+    buf = openConnection(gp, -1);
+    putRequest(gp, buf, 1, "GET", "/h2/hello", HTTP2_END_STREAM_FLAG);
+    putFrame(buf, HTTP2_PING_FRAME, 0, 0, data, 8);
+    tassert(sendBuf(th->fd, buf) == 0);
+    tassert(readGoaway(gp) == HTTP2_PROTOCOL_ERROR);
+    closeConnection(gp);
+}
+
+
+MprTestDef testHttp2 = {
+    "http2", 0, initHttp2, 0,
+    {
+        MPR_TEST(0, testHpackDecode),
+        MPR_TEST(0, testHpackHuffman),
+        MPR_TEST(0, testHpackRoundTrip),
+        MPR_TEST(0, testHpackErrors),
+        MPR_TEST(0, testHttp2Request),
+        MPR_TEST(0, testHttp2SendWindow),
+        MPR_TEST(0, testHttp2ReceiveWindow),
+        MPR_TEST(0, testHttp2ConnectionErrors),
+        MPR_TEST(0, 0),
+    },
+};
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
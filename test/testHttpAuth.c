@@ -0,0 +1,418 @@
+/**
+    testHttpAuth.c - tests for the verified credential cache and digest nonces
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "testHttp.h"
+
+/*********************************** Locals ***********************************/
+
+#define TEST_NONCES     4096            /* Size of the server digest nonce table */
+
+typedef struct TestAuth {
+    HttpRoute       *route;
+    HttpConn        *conn;
+    MprBuf          *response;
+    char            *nonce;
+    char            *other;
+} TestAuth;
+
+/*
+    Number of auth store verifications
+ */
+static int verified;
+
+static void manageTestAuth(TestAuth *ta, int flags);
+
+/************************************ Code ************************************/
+
+/*
+    Auth store that compares plain text passwords with the route users
+ */
+static bool testVerifyUser(HttpConn *conn, cchar *username, cchar *password)
+{
+    HttpUser    *user;
+
+    verified++;
+    if ((user = httpLookupUser(conn->rx->route->auth, username)) == 0 || !smatch(user->password, password)) {
+        return 0;
+    }
+    conn->user = user;
+    return 1;
+}
+
+
+/*
+    Auth store that creates the user on first login, as the PAM store does
+ */
+static bool createVerifyUser(HttpConn *conn, cchar *username, cchar *password)
+{
+    HttpAuth    *auth;
+
+    verified++;
+    if (!smatch(password, "system")) {
+        return 0;
+    }
+    auth = conn->rx->route->auth;
+    if ((conn->user = httpLookupUser(auth, username)) == 0) {
+        conn->user = httpAddUser(auth, username, 0, "user");
+    }
+    return 1;
+}
+
+
+static void digestAction(HttpConn *conn)
+{
+    httpSetContentType(conn, "text/plain");
+    httpWrite(conn->writeq, "user=%s\n", conn->username);
+    httpFinalize(conn);
+}
+
+
+static int initAuth(MprTestGroup *gp)
+{
+    HttpRoute   *route;
+
+    gp->data = mprAllocObj(TestAuth, manageTestAuth);
+    httpCreate(HTTP_CLIENT_SIDE | HTTP_SERVER_SIDE);
+    httpAddAuthStore("test", testVerifyUser);
+    httpAddAuthStore("testCreate", createVerifyUser);
+    httpSetAuthStoreCache("test", 1);
+    httpSetAuthStoreCache("testCreate", 1);
+
+    /*
+        Route requiring digest authentication with the internal store
+     */
+    if ((route = testGetRoute()) == 0) {
+        return MPR_ERR_CANT_OPEN;
+    }
+    route = httpCreateInheritedRoute(route);
+    httpSetRoutePattern(route, "^/auth/", 0);
+    httpSetAuthType(route->auth, "digest", 0);
+    httpSetAuthRealm(route->auth, "example.com");
+    httpAddUser(route->auth, "joshua", mprGetMD5("joshua:example.com:pass1"), "user");
+    httpAddRouteCondition(route, "auth", 0, 0);
+    httpFinalizeRoute(route);
+    httpDefineAction("/auth/digest", digestAction);
+    return 0;
+}
+
+
+static void manageTestAuth(TestAuth *ta, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(ta->route);
+        mprMark(ta->conn);
+        mprMark(ta->response);
+        mprMark(ta->nonce);
+        mprMark(ta->other);
+    }
+}
+
+
+static HttpRoute *createRoute(cchar *store)
+{
+    HttpRoute   *route;
+
+    route = httpCreateRoute(NULL);
+    httpSetAuthRealm(route->auth, "example.com");
+    httpSetAuthStore(route->auth, store);
+    return route;
+}
+
+
+/*
+    Login on a new request and return the number of store verifications used
+ */
+static int login(MprTestGroup *gp, cchar *username, cchar *password, bool *success)
+{
+    TestAuth    *ta;
+    int         before;
+
+    ta = gp->data;
+    ta->conn = httpCreateConn(MPR->httpService, NULL, gp->dispatcher);
+    ta->conn->rx->route = ta->route;
+    before = verified;
+    *success = httpLogin(ta->conn, username, password);
+    return verified - before;
+}
+
+
+static void testAuthCacheHits(MprTestGroup *gp)
+{
+    TestAuth        *ta;
+    HttpAuthCache   *cache;
+    uint64          hits;
+    bool            success;
+
+    ta = gp->data;
+    cache = ((Http*) MPR->httpService)->authCache;
+    tassert(cache != 0);
+    ta->route = createRoute("test");
+    httpAddUser(ta->route->auth, "joshua", "pass1", "user");
+
+    tassert(login(gp, "joshua", "pass1", &success) == 1 && success);
+    hits = cache->hits;
+    tassert(login(gp, "joshua", "pass1", &success) == 0 && success);
+    tassert(cache->hits == hits + 1);
+    tassert(ta->conn->user == httpLookupUser(ta->route->auth, "joshua"));
+
+    /* Failed verifications are not cached */
+    tassert(login(gp, "joshua", "wrong", &success) == 1 && !success);
+    tassert(login(gp, "joshua", "wrong", &success) == 1 && !success);
+    tassert(login(gp, "nobody", "pass1", &success) == 1 && !success);
+}
+
+
+/*
+    Adding users and changing roles do not flush verified credentials
+ */
+static void testAuthCacheRetained(MprTestGroup *gp)
+{
+    TestAuth    *ta;
+    HttpUser    *user;
+    bool        success;
+
+    ta = gp->data;
+    ta->route = createRoute("test");
+    user = httpAddUser(ta->route->auth, "joshua", "pass1", "user");
+    tassert(login(gp, "joshua", "pass1", &success) == 1 && success);
+
+    tassert(httpAddUser(ta->route->auth, "mary", "pass2", "user") != 0);
+    tassert(login(gp, "joshua", "pass1", &success) == 0 && success);
+    tassert(login(gp, "mary", "pass2", &success) == 1 && success);
+
+    /* Role changes take effect on the next request without verifying again */
+    tassert(httpAddRole(ta->route->auth, "admin", "manage") == 0);
+    user->roles = sclone("admin");
+    httpComputeUserAbilities(ta->route->auth, user);
+    tassert(login(gp, "joshua", "pass1", &success) == 0 && success);
+    tassert(httpCanUser(ta->conn, "manage"));
+    tassert(httpRemoveRole(ta->route->auth, "admin") == 0);
+    tassert(login(gp, "mary", "pass2", &success) == 0 && success);
+}
+
+
+/*
+    Removing or replacing a user invalidates only that user's credentials
+ */
+static void testAuthCacheInvalidation(MprTestGroup *gp)
+{
+    TestAuth    *ta;
+    bool        success;
+
+    ta = gp->data;
+    ta->route = createRoute("test");
+    httpAddUser(ta->route->auth, "joshua", "pass1", "user");
+    httpAddUser(ta->route->auth, "mary", "pass2", "user");
+    tassert(login(gp, "joshua", "pass1", &success) == 1 && success);
+    tassert(login(gp, "mary", "pass2", &success) == 1 && success);
+
+    tassert(httpRemoveUser(ta->route->auth, "joshua") == 0);
+    tassert(login(gp, "joshua", "pass1", &success) == 1 && !success);
+    tassert(login(gp, "mary", "pass2", &success) == 0 && success);
+
+    /* A replaced user must verify the new password and the old password is rejected */
+    httpAddUser(ta->route->auth, "joshua", "pass3", "user");
+    tassert(login(gp, "joshua", "pass1", &success) == 1 && !success);
+    tassert(login(gp, "joshua", "pass3", &success) == 1 && success);
+    tassert(login(gp, "joshua", "pass3", &success) == 0 && success);
+
+    /* Changing the store verification flushes all credentials */
+    httpSetAuthStoreVerify("test", testVerifyUser);
+    tassert(login(gp, "mary", "pass2", &success) == 1 && success);
+    httpFlushAuthCache(MPR->httpService);
+    tassert(login(gp, "mary", "pass2", &success) == 1 && success);
+}
+
+
+/*
+    Stores that create users when verifying are cached after the first login
+ */
+static void testAuthCacheCreatedUsers(MprTestGroup *gp)
+{
+    TestAuth    *ta;
+    bool        success;
+
+    ta = gp->data;
+    ta->route = createRoute("testCreate");
+    tassert(login(gp, "ralph", "system", &success) == 1 && success);
+    tassert(httpLookupUser(ta->route->auth, "ralph") != 0);
+    tassert(login(gp, "ralph", "system", &success) == 0 && success);
+    tassert(login(gp, "sally", "system", &success) == 1 && success);
+    tassert(login(gp, "ralph", "system", &success) == 0 && success);
+    tassert(login(gp, "sally", "other", &success) == 1 && !success);
+}
+
+
+/*
+    Send the request headers and return the response status. The response is held by the group data.
+ */
+static int request(MprTestGroup *gp, cchar *headers)
+{
+    TestAuth    *ta;
+
+    ta = gp->data;
+    ta->response = testRequest(headers, NULL, 0);
+    return testGetStatus(ta->response);
+}
+
+
+/*
+    Request without credentials and return the nonce from the login challenge
+ */
+static char *getNonce(MprTestGroup *gp)
+{
+    TestAuth    *ta;
+    cchar       *cp;
+
+    ta = gp->data;
+    if (request(gp, "GET /auth/digest HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n") !=
+            HTTP_CODE_UNAUTHORIZED || (cp = scontains(mprGetBufStart(ta->response), "nonce=\"")) == 0) {
+        return 0;
+    }
+    return snclone(&cp[7], 48);
+}
+
+
+/*
+    Get the sequence number from a nonce. This is the hex issue time followed by the hex sequence number.
+ */
+static uint getSeq(cchar *nonce)
+{
+    return (uint) stoiradix(snclone(&nonce[8], 8), 16, NULL);
+}
+
+
+/*
+    Request with digest credentials for the nonce and nonce count and return the response status
+ */
+static int digestRequest(MprTestGroup *gp, cchar *nonce, int nc)
+{
+    cchar       *ha1, *ha2, *cnonce, *digest, *headers;
+
+    ha1 = mprGetMD5("joshua:example.com:pass1");
+    ha2 = mprGetMD5("GET:/auth/digest");
+    cnonce = "0a4f113b";
+    digest = mprGetMD5(sfmt("%s:%s:%08x:%s:auth:%s", ha1, nonce, nc, cnonce, ha2));
+    headers = sfmt("GET /auth/digest HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n"
+        "Authorization: Digest username=\"joshua\", realm=\"example.com\", nonce=\"%s\", uri=\"/auth/digest\", "
+        "qop=auth, nc=%08x, cnonce=\"%s\", response=\"%s\"\r\n\r\n", nonce, nc, cnonce, digest);
+    return request(gp, headers);
+}
+
+
+/*
+    Each nonce count may be used once. Counts below the highest may arrive out of order.
+ */
+static void testDigestReplay(MprTestGroup *gp)
+{
+    TestAuth    *ta;
+
+    ta = gp->data;
+    ta->nonce = getNonce(gp);
+    tassert(ta->nonce != 0);
+    if (!ta->nonce) {
+        return;
+    }
+    tassert(digestRequest(gp, ta->nonce, 1) == HTTP_CODE_OK);
+    tassert(scontains(mprGetBufStart(ta->response), "user=joshua") != 0);
+    tassert(digestRequest(gp, ta->nonce, 1) != HTTP_CODE_OK);
+
+    tassert(digestRequest(gp, ta->nonce, 3) == HTTP_CODE_OK);
+    tassert(digestRequest(gp, ta->nonce, 2) == HTTP_CODE_OK);
+    tassert(digestRequest(gp, ta->nonce, 2) != HTTP_CODE_OK);
+    tassert(digestRequest(gp, ta->nonce, 3) != HTTP_CODE_OK);
+    tassert(digestRequest(gp, ta->nonce, 4) == HTTP_CODE_OK);
+
+    /* A forged nonce is rejected */
+    ta->nonce[47] = (ta->nonce[47] == '0') ? '1' : '0';
+    tassert(digestRequest(gp, ta->nonce, 5) != HTTP_CODE_OK);
+}
+
+
+/*
+    Nonces issued to anonymous requests do not displace authenticated nonces. A later nonce that authenticates
+    with the same table slot makes the earlier nonce stale.
+ */
+static void testDigestStale(MprTestGroup *gp)
+{
+    TestAuth    *ta;
+    uint        seq;
+    int         i;
+
+    ta = gp->data;
+    ta->nonce = getNonce(gp);
+    tassert(ta->nonce != 0);
+    if (!ta->nonce) {
+        return;
+    }
+    tassert(digestRequest(gp, ta->nonce, 1) == HTTP_CODE_OK);
+    seq = getSeq(ta->nonce);
+    for (i = 0; i < TEST_NONCES * 2; i++) {
+        if ((ta->other = getNonce(gp)) == 0 || getSeq(ta->other) == seq + TEST_NONCES) {
+            break;
+        }
+    }
+    tassert(ta->other != 0 && getSeq(ta->other) == seq + TEST_NONCES);
+    if (!ta->other) {
+        return;
+    }
+    tassert(digestRequest(gp, ta->nonce, 2) == HTTP_CODE_OK);
+
+    tassert(digestRequest(gp, ta->other, 1) == HTTP_CODE_OK);
+    tassert(digestRequest(gp, ta->nonce, 3) == HTTP_CODE_UNAUTHORIZED);
+    tassert(scontains(mprGetBufStart(ta->response), "stale=\"TRUE\"") != 0);
+    tassert(digestRequest(gp, ta->other, 2) == HTTP_CODE_OK);
+}
+
+
+MprTestDef testHttpAuth = {
+    "auth", 0, initAuth, 0,
+    {
+        MPR_TEST(0, testAuthCacheHits),
+        MPR_TEST(0, testAuthCacheRetained),
+        MPR_TEST(0, testAuthCacheInvalidation),
+        MPR_TEST(0, testAuthCacheCreatedUsers),
+        MPR_TEST(0, testDigestReplay),
+        MPR_TEST(0, testDigestStale),
+        MPR_TEST(0, 0),
+    },
+};
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -0,0 +1,206 @@
+/**
+    testHttpBatch.c - tests for asynchronous client request batches
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "testHttp.h"
+
+/*********************************** Locals ***********************************/
+
+#define TEST_CLOSED     "http://127.0.0.1:18294/batch/hello"     /* Port with no listener */
+#define BATCH_TIMEOUT   (10 * MPR_TICKS_PER_SEC)
+#define TEST_REQUESTS   20
+
+typedef struct TestBatch {
+    HttpBatch       *batch;
+    MprList         *requests;
+} TestBatch;
+
+/*
+    Number of completion callbacks
+ */
+static int callbacks;
+
+static void manageTestBatch(TestBatch *tb, int flags);
+
+/************************************ Code ************************************/
+
+static void helloAction(HttpConn *conn)
+{
+    httpSetContentType(conn, "text/plain");
+    httpWrite(conn->writeq, "Hello World\n");
+    httpFinalize(conn);
+}
+
+
+/*
+    Close the connection without a response
+ */
+static void closeAction(HttpConn *conn)
+{
+    httpDisconnect(conn);
+}
+
+
+/*
+    Never respond. The request is completed when the client closes the connection.
+ */
+static void slowAction(HttpConn *conn)
+{
+}
+
+
+static int initBatch(MprTestGroup *gp)
+{
+    gp->data = mprAllocObj(TestBatch, manageTestBatch);
+    if (testGetRoute() == 0) {
+        return MPR_ERR_CANT_OPEN;
+    }
+    httpDefineAction("/batch/hello", helloAction);
+    httpDefineAction("/batch/close", closeAction);
+    httpDefineAction("/batch/slow", slowAction);
+    return 0;
+}
+
+
+static void manageTestBatch(TestBatch *tb, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(tb->batch);
+        mprMark(tb->requests);
+    }
+}
+
+
+static void batchDone(HttpBatchRequest *req)
+{
+    callbacks++;
+}
+
+
+static HttpBatchRequest *issue(MprTestGroup *gp, cchar *uri, MprTicks timeout)
+{
+    TestBatch           *tb;
+    HttpBatchRequest    *req;
+
+    tb = gp->data;
+    req = httpBatchRequest(tb->batch, "GET", uri, NULL, timeout, batchDone, NULL);
+    mprAddItem(tb->requests, req);
+    return req;
+}
+
+
+/*
+    More requests than may be in flight are queued and all complete with a response
+ */
+static void testBatchRequests(MprTestGroup *gp)
+{
+    TestBatch           *tb;
+    HttpBatchRequest    *req;
+    int                 next;
+
+    tb = gp->data;
+    tb->batch = httpCreateBatch(NULL, 4);
+    tb->requests = mprCreateList(0, 0);
+    callbacks = 0;
+    for (next = 0; next < TEST_REQUESTS; next++) {
+        issue(gp, TEST_URI "/batch/hello", BATCH_TIMEOUT);
+    }
+    tassert(httpWaitBatch(tb->batch, BATCH_TIMEOUT) == 0);
+    tassert(callbacks == TEST_REQUESTS);
+    tassert(tb->batch->completed == TEST_REQUESTS);
+    tassert(tb->batch->failed == 0);
+    tassert(tb->batch->active == 0);
+    for (ITERATE_ITEMS(tb->requests, req, next)) {
+        tassert(req->done);
+        tassert(req->status == HTTP_CODE_OK);
+        tassert(smatch(mprGetBufStart(req->response), "Hello World\n"));
+        tassert(req->conn == 0);
+    }
+}
+
+
+/*
+    Requests that fail complete with an error status rather than never completing
+ */
+static void testBatchErrors(MprTestGroup *gp)
+{
+    TestBatch           *tb;
+    HttpBatchRequest    *closed, *refused, *timeout, *cancelled, *queued, *ok;
+
+    tb = gp->data;
+    tb->batch = httpCreateBatch(NULL, 2);
+    tb->requests = mprCreateList(0, 0);
+    callbacks = 0;
+
+    /* The slow requests hold both slots so the queued request is cancelled before it starts */
+    timeout = issue(gp, TEST_URI "/batch/slow", 250);
+    cancelled = issue(gp, TEST_URI "/batch/slow", BATCH_TIMEOUT);
+    queued = issue(gp, TEST_URI "/batch/hello", BATCH_TIMEOUT);
+    httpCancelBatchRequest(queued);
+
+    closed = issue(gp, TEST_URI "/batch/close", BATCH_TIMEOUT);
+    refused = issue(gp, TEST_CLOSED, BATCH_TIMEOUT);
+    ok = issue(gp, TEST_URI "/batch/hello", BATCH_TIMEOUT);
+    mprSleep(100);
+    httpCancelBatchRequest(cancelled);
+
+    tassert(httpWaitBatch(tb->batch, BATCH_TIMEOUT) == 0);
+    tassert(callbacks == 6);
+    tassert(closed->status == MPR_ERR_CANT_COMPLETE);
+    tassert(refused->status == MPR_ERR_CANT_CONNECT);
+    tassert(timeout->status == MPR_ERR_TIMEOUT);
+    tassert(cancelled->status == MPR_ERR_ABORTED);
+    tassert(queued->status == MPR_ERR_ABORTED);
+    tassert(ok->status == HTTP_CODE_OK);
+    tassert(tb->batch->completed == 1);
+    tassert(tb->batch->failed == 5);
+    tassert(tb->batch->active == 0);
+}
+
+
+MprTestDef testHttpBatch = {
+    "batch", 0, initBatch, 0,
+    {
+        MPR_TEST(0, testBatchRequests),
+        MPR_TEST(0, testBatchErrors),
+        MPR_TEST(0, 0),
+    },
+};
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
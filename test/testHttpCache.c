@@ -0,0 +1,218 @@
+/**
+    testHttpCache.c - tests for the sharded in-memory cache limits, eviction and pruning
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "testHttp.h"
+
+/*********************************** Locals ***********************************/
+
+#define CACHE_LIFESPAN  (60 * MPR_TICKS_PER_SEC)
+#define CACHE_MEMORY    (1024 * 1024)
+#define CACHE_WRITES    200             /* Enough keys to fill every shard */
+
+/************************************ Code ************************************/
+
+/*
+    Caches must be destroyed before they are released to stop the pruner timer which does not hold the cache
+ */
+static MprCache *createCache(int64 keys, int64 memory)
+{
+    MprCache    *cache;
+
+    cache = mprCreateCache(0);
+    mprSetCacheLimits(cache, keys, CACHE_LIFESPAN, memory, 0);
+    return cache;
+}
+
+
+static int cacheKeys(MprCache *cache)
+{
+    int     numKeys;
+
+    mprGetCacheStats(cache, &numKeys, NULL);
+    return numKeys;
+}
+
+
+static ssize cacheMemory(MprCache *cache)
+{
+    ssize   mem;
+
+    mprGetCacheStats(cache, NULL, &mem);
+    return mem;
+}
+
+
+/*
+    The key limit applies to the whole cache, including limits smaller than the number of shards
+ */
+static void testCacheKeyLimit(MprTestGroup *gp)
+{
+    MprCache    *cache;
+    char        *key;
+    int         i;
+
+    cache = createCache(4, CACHE_MEMORY);
+    for (i = 0; i < CACHE_WRITES; i++) {
+        key = sfmt("key-%d", i);
+        tassert(mprWriteCache(cache, key, "value", 0, CACHE_LIFESPAN, 0, 0) > 0);
+        tassert(cacheKeys(cache) <= 4);
+        /* The item just written is never evicted to make room for itself */
+        tassert(smatch(mprReadCache(cache, key, 0, 0), "value"));
+    }
+    tassert(cacheKeys(cache) == 4);
+    mprDestroyCache(cache);
+
+    cache = createCache(1, CACHE_MEMORY);
+    mprWriteCache(cache, "first", "value", 0, CACHE_LIFESPAN, 0, 0);
+    mprWriteCache(cache, "second", "value", 0, CACHE_LIFESPAN, 0, 0);
+    tassert(cacheKeys(cache) == 1);
+    tassert(mprReadCache(cache, "first", 0, 0) == 0);
+    tassert(smatch(mprReadCache(cache, "second", 0, 0), "value"));
+    mprDestroyCache(cache);
+}
+
+
+/*
+    Eviction starts when the whole cache reaches its limit, not when one shard reaches a share of it
+ */
+static void testCacheEvictAtLimit(MprTestGroup *gp)
+{
+    MprCache    *cache;
+    int         i;
+
+    cache = createCache(CACHE_WRITES, CACHE_MEMORY);
+    for (i = 0; i < CACHE_WRITES; i++) {
+        mprWriteCache(cache, sfmt("key-%d", i), "value", 0, CACHE_LIFESPAN, 0, 0);
+    }
+    tassert(cacheKeys(cache) == CACHE_WRITES);
+    for (i = 0; i < CACHE_WRITES; i++) {
+        tassert(mprReadCache(cache, sfmt("key-%d", i), 0, 0) != 0);
+    }
+    mprWriteCache(cache, "extra", "value", 0, CACHE_LIFESPAN, 0, 0);
+    tassert(cacheKeys(cache) == CACHE_WRITES);
+    tassert(mprReadCache(cache, "extra", 0, 0) != 0);
+
+    /* Removing keys releases their memory */
+    for (i = 0; i < CACHE_WRITES; i++) {
+        mprRemoveCache(cache, sfmt("key-%d", i));
+    }
+    mprRemoveCache(cache, "extra");
+    tassert(cacheKeys(cache) == 0);
+    tassert(cacheMemory(cache) == 0);
+    mprDestroyCache(cache);
+}
+
+
+/*
+    The memory limit applies to keys and values in all shards. Replacing a value updates the memory in use.
+ */
+static void testCacheMemoryLimit(MprTestGroup *gp)
+{
+    MprCache    *cache;
+    char        value[100];
+    int         i;
+
+    memset(value, 'x', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+    cache = createCache(CACHE_WRITES, 2000);
+    for (i = 0; i < CACHE_WRITES; i++) {
+        mprWriteCache(cache, sfmt("key-%d", i), value, 0, CACHE_LIFESPAN, 0, 0);
+        tassert(cacheMemory(cache) <= 2000);
+    }
+    tassert(cacheKeys(cache) > 0 && cacheKeys(cache) < 20);
+    mprDestroyCache(cache);
+
+    cache = createCache(CACHE_WRITES, CACHE_MEMORY);
+    mprWriteCache(cache, "key", value, 0, CACHE_LIFESPAN, 0, 0);
+    tassert(cacheMemory(cache) == 3 + 99);
+    mprWriteCache(cache, "key", "short", 0, CACHE_LIFESPAN, 0, 0);
+    tassert(cacheMemory(cache) == 3 + 5);
+    mprDestroyCache(cache);
+}
+
+
+/*
+    Expired items are not returned and are pruned in the background
+ */
+static void testCacheExpiry(MprTestGroup *gp)
+{
+    MprCache    *cache;
+    MprTicks    mark;
+    int         i;
+
+    /* The test thread yields while sleeping, so the cache is held as a root */
+    cache = mprCreateCache(0);
+    mprAddRoot(cache);
+    mprSetCacheLimits(cache, 0, 0, 0, 10);
+    for (i = 0; i < 10; i++) {
+        mprWriteCache(cache, sfmt("key-%d", i), "value", 0, 20, 0, 0);
+    }
+    mprWriteCache(cache, "keep", "value", 0, CACHE_LIFESPAN, 0, 0);
+    tassert(cacheKeys(cache) == 11);
+
+    mprSleep(50);
+    tassert(mprReadCache(cache, "key-0", 0, 0) == 0);
+    for (mark = mprGetTicks(); cacheKeys(cache) > 1 && mprGetElapsedTicks(mark) < TEST_TIMEOUT; ) {
+        mprSleep(10);
+    }
+    tassert(cacheKeys(cache) == 1);
+    tassert(mprReadCache(cache, "keep", 0, 0) != 0);
+
+    /* Pruning without the timer removes every item */
+    mprPruneCache(cache);
+    tassert(cacheKeys(cache) == 0);
+    tassert(cacheMemory(cache) == 0);
+    mprDestroyCache(cache);
+    mprRemoveRoot(cache);
+}
+
+
+MprTestDef testHttpCache = {
+    "cache", 0, 0, 0,
+    {
+        MPR_TEST(0, testCacheKeyLimit),
+        MPR_TEST(0, testCacheEvictAtLimit),
+        MPR_TEST(0, testCacheMemoryLimit),
+        MPR_TEST(0, testCacheExpiry),
+        MPR_TEST(0, 0),
+    },
+};
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -0,0 +1,384 @@
+/**
+    testHttpClient.c - tests for the client connection pool and resolver cache
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "testHttp.h"
+
+/*********************************** Locals ***********************************/
+
+#define POOL_MAX        2               /* Maximum idle sockets per host */
+#define POOL_IDLE       (60 * MPR_TICKS_PER_SEC)
+#define DNS_TTL         (60 * MPR_TICKS_PER_SEC)
+#define DNS_NEGATIVE    100             /* Failed lookups expire quickly so the test can observe expiry */
+#define DNS_MISSING     "missing.invalid"
+
+/*
+    Hosts file for the resolver cache. Names in the reserved "example" domain are never resolved by the system.
+ */
+static cchar *dnsHosts =
+    "# Test hosts\n"
+    "127.0.0.1   server.example\n"
+    "127.0.0.1   multi.example\n"
+    "127.0.0.2   multi.example    # Second address for round-robin\n"
+    "10.0.0.1    other.example alias.example\n"
+    "not-an-address ignored.example\n";
+
+typedef struct TestClient {
+    HttpConn    *conns[POOL_MAX + 1];
+    MprSocket   *sock;
+    char        *body;
+    char        *hosts;
+} TestClient;
+
+static void manageTestClient(TestClient *tc, int flags);
+static HttpConn *startUri(MprTestGroup *gp, int slot, cchar *uri, bool close);
+
+/************************************ Code ************************************/
+
+static void helloAction(HttpConn *conn)
+{
+    httpSetContentType(conn, "text/plain");
+    httpWrite(conn->writeq, "Hello World\n");
+    httpFinalize(conn);
+}
+
+
+static int initClient(MprTestGroup *gp)
+{
+    TestClient  *tc;
+
+    gp->data = tc = mprAllocObj(TestClient, manageTestClient);
+    if (testGetRoute() == 0) {
+        return MPR_ERR_CANT_OPEN;
+    }
+    httpDefineAction("/client/hello", helloAction);
+    tc->hosts = sfmt("/tmp/testHttpClient-%d.hosts", getpid());
+    if (mprWritePathContents(tc->hosts, dnsHosts, slen(dnsHosts), 0644) < 0) {
+        return MPR_ERR_CANT_WRITE;
+    }
+    return 0;
+}
+
+
+static int termClient(MprTestGroup *gp)
+{
+    TestClient  *tc;
+
+    tc = gp->data;
+    httpSetClientPool(MPR->httpService, 0, 0);
+    httpSetDnsCache(MPR->httpService, 0, 0);
+    if (tc->hosts) {
+        unlink(tc->hosts);
+    }
+    return 0;
+}
+
+
+static void manageTestClient(TestClient *tc, int flags)
+{
+    int     i;
+
+    if (flags & MPR_MANAGE_MARK) {
+        for (i = 0; i <= POOL_MAX; i++) {
+            mprMark(tc->conns[i]);
+        }
+        mprMark(tc->sock);
+        mprMark(tc->body);
+        mprMark(tc->hosts);
+    }
+}
+
+
+/*
+    Start a request on a new connection to the test endpoint. The connection is held in the given slot.
+ */
+static HttpConn *start(MprTestGroup *gp, int slot, bool close)
+{
+    return startUri(gp, slot, TEST_URI "/client/hello", close);
+}
+
+
+static HttpConn *startUri(MprTestGroup *gp, int slot, cchar *uri, bool close)
+{
+    TestClient  *tc;
+    HttpConn    *conn;
+
+    tc = gp->data;
+    tc->conns[slot] = conn = httpCreateConn(MPR->httpService, NULL, gp->dispatcher);
+    if (httpConnect(conn, "GET", uri, NULL) < 0) {
+        return 0;
+    }
+    if (close) {
+        /* Replaces the default keep-alive header defined when connecting */
+        httpSetHeaderString(conn, "Connection", "close");
+    }
+    httpFinalizeOutput(conn);
+    return conn;
+}
+
+
+/*
+    Wait for the request in the slot to complete and destroy the connection which returns the socket to the pool
+ */
+static int finish(MprTestGroup *gp, int slot)
+{
+    TestClient  *tc;
+    HttpConn    *conn;
+    int         status;
+
+    tc = gp->data;
+    status = 0;
+    tc->body = 0;
+    if ((conn = tc->conns[slot]) != 0) {
+        if (httpWait(conn, HTTP_STATE_COMPLETE, TEST_TIMEOUT) == 0) {
+            status = httpGetStatus(conn);
+            tc->body = httpReadString(conn);
+        }
+        httpDestroyConn(conn);
+        tc->conns[slot] = 0;
+    }
+    return status;
+}
+
+
+/*
+    A completed keep-alive socket is returned to the pool and checked out by the next request to the same host
+ */
+static void testPoolReuse(MprTestGroup *gp)
+{
+    TestClient      *tc;
+    HttpClientPool  *pool;
+    HttpConn        *conn;
+
+    tc = gp->data;
+    httpSetClientPool(MPR->httpService, 0, 0);
+    tassert(httpSetClientPool(MPR->httpService, POOL_MAX, POOL_IDLE) == 0);
+    pool = ((Http*) MPR->httpService)->clientPool;
+
+    conn = start(gp, 0, 0);
+    tassert(conn != 0);
+    tc->sock = conn ? conn->sock : 0;
+    tassert(finish(gp, 0) == HTTP_CODE_OK);
+    tassert(smatch(tc->body, "Hello World\n"));
+    tassert(pool->misses == 1 && pool->hits == 0);
+    tassert(pool->count == 1);
+
+    conn = start(gp, 0, 0);
+    tassert(conn != 0);
+    tassert(conn && conn->sock == tc->sock);
+    tassert(pool->hits == 1);
+    tassert(pool->count == 0);
+    tassert(finish(gp, 0) == HTTP_CODE_OK);
+    tassert(smatch(tc->body, "Hello World\n"));
+    tassert(pool->count == 1);
+    tc->sock = 0;
+}
+
+
+/*
+    At most maxPerHost idle sockets are retained. Sockets of requests that close the connection are not pooled.
+ */
+static void testPoolLimits(MprTestGroup *gp)
+{
+    HttpClientPool  *pool;
+    int             i;
+
+    httpSetClientPool(MPR->httpService, 0, 0);
+    httpSetClientPool(MPR->httpService, POOL_MAX, POOL_IDLE);
+    pool = ((Http*) MPR->httpService)->clientPool;
+
+    for (i = 0; i <= POOL_MAX; i++) {
+        tassert(start(gp, i, 0) != 0);
+    }
+    for (i = 0; i <= POOL_MAX; i++) {
+        tassert(finish(gp, i) == HTTP_CODE_OK);
+    }
+    tassert(pool->misses == POOL_MAX + 1);
+    tassert(pool->count == POOL_MAX);
+
+    httpSetClientPool(MPR->httpService, 0, 0);
+    httpSetClientPool(MPR->httpService, POOL_MAX, POOL_IDLE);
+    pool = ((Http*) MPR->httpService)->clientPool;
+    tassert(start(gp, 0, 1) != 0);
+    tassert(finish(gp, 0) == HTTP_CODE_OK);
+    tassert(pool->count == 0);
+}
+
+
+/*
+    Sockets idle for longer than the idle timeout are not reused and are closed when the pool is pruned
+ */
+static void testPoolIdleTimeout(MprTestGroup *gp)
+{
+    TestClient      *tc;
+    HttpClientPool  *pool;
+    HttpConn        *conn;
+
+    tc = gp->data;
+    httpSetClientPool(MPR->httpService, 0, 0);
+    httpSetClientPool(MPR->httpService, POOL_MAX, 100);
+    pool = ((Http*) MPR->httpService)->clientPool;
+
+    tassert(start(gp, 0, 0) != 0);
+    tassert(finish(gp, 0) == HTTP_CODE_OK);
+    tassert(pool->count == 1);
+    mprSleep(200);
+
+    /* Creating the connection updates the time. The expired socket is closed and a new socket is connected. */
+    conn = start(gp, 0, 0);
+    tassert(conn != 0);
+    tassert(pool->hits == 0 && pool->misses == 2);
+    tassert(pool->count == 0);
+    tassert(finish(gp, 0) == HTTP_CODE_OK);
+    tassert(pool->count == 1);
+
+    /* Pruning before the timeout retains the socket */
+    tassert(httpPruneClientPool(MPR->httpService) == 1);
+    mprSleep(200);
+    tc->conns[0] = httpCreateConn(MPR->httpService, NULL, gp->dispatcher);
+    tassert(httpPruneClientPool(MPR->httpService) == 0);
+    tassert(mprGetHashLength(pool->hosts) == 0);
+    httpDestroyConn(tc->conns[0]);
+    tc->conns[0] = 0;
+}
+
+
+/*
+    Create an empty resolver cache and preload the test hosts
+ */
+static HttpDnsCache *createDnsCache(MprTestGroup *gp, MprTicks negativeTtl)
+{
+    TestClient  *tc;
+
+    tc = gp->data;
+    httpSetDnsCache(MPR->httpService, 0, 0);
+    httpSetDnsCache(MPR->httpService, DNS_TTL, negativeTtl);
+    tassert(httpLoadDnsHosts(MPR->httpService, tc->hosts) == 5);
+    return ((Http*) MPR->httpService)->dnsCache;
+}
+
+
+/*
+    Preloaded hosts with several addresses are used in round-robin order. Numeric addresses are not cached.
+ */
+static void testDnsRoundRobin(MprTestGroup *gp)
+{
+    HttpDnsCache    *cache;
+    Http            *http;
+
+    http = MPR->httpService;
+    cache = createDnsCache(gp, DNS_NEGATIVE);
+
+    tassert(smatch(httpResolveHost(http, "multi.example"), "127.0.0.1"));
+    tassert(smatch(httpResolveHost(http, "multi.example"), "127.0.0.2"));
+    tassert(smatch(httpResolveHost(http, "MULTI.example"), "127.0.0.1"));
+    tassert(smatch(httpResolveHost(http, "alias.example"), "10.0.0.1"));
+    tassert(smatch(httpResolveHost(http, "other.example"), "10.0.0.1"));
+    tassert(cache->hits == 5);
+
+    tassert(smatch(httpResolveHost(http, "127.0.0.3"), "127.0.0.3"));
+    tassert(cache->hits == 5 && cache->misses == 0 && cache->lookups == 0);
+}
+
+
+/*
+    Failed lookups are cached until the negative period expires. Resolved hosts are cached.
+ */
+static void testDnsNegative(MprTestGroup *gp)
+{
+    HttpDnsCache    *cache;
+    Http            *http;
+
+    http = MPR->httpService;
+    cache = createDnsCache(gp, DNS_NEGATIVE);
+
+    tassert(httpResolveHost(http, DNS_MISSING) == 0);
+    tassert(cache->misses == 1 && cache->lookups == 1);
+    tassert(httpResolveHost(http, DNS_MISSING) == 0);
+    tassert(cache->negativeHits == 1 && cache->lookups == 1);
+
+    mprSleep(DNS_NEGATIVE * 2);
+    tassert(httpResolveHost(http, DNS_MISSING) == 0);
+    tassert(cache->misses == 2 && cache->lookups == 2);
+
+    /* The system resolver is only called once for a host that resolves */
+    tassert(smatch(httpResolveHost(http, "localhost"), "127.0.0.1"));
+    tassert(smatch(httpResolveHost(http, "localhost"), "127.0.0.1"));
+    tassert(cache->lookups == 3);
+    tassert(cache->misses == 3 && cache->hits == 1);
+}
+
+
+/*
+    Client connections resolve host names via the cache
+ */
+static void testDnsConnect(MprTestGroup *gp)
+{
+    TestClient      *tc;
+    HttpDnsCache    *cache;
+
+    tc = gp->data;
+    cache = createDnsCache(gp, DNS_NEGATIVE);
+    tassert(startUri(gp, 0, sfmt("http://server.example:%d/client/hello", TEST_PORT), 0) != 0);
+    tassert(finish(gp, 0) == HTTP_CODE_OK);
+    tassert(smatch(tc->body, "Hello World\n"));
+    tassert(cache->hits == 1);
+
+    /* The connection has no socket if the host cannot be resolved */
+    tassert(startUri(gp, 0, sfmt("http://%s:%d/client/hello", DNS_MISSING, TEST_PORT), 0) == 0);
+    httpDestroyConn(tc->conns[0]);
+    tc->conns[0] = 0;
+    tassert(cache->misses == 1);
+}
+
+
+MprTestDef testHttpClient = {
+    "client", 0, initClient, termClient,
+    {
+        MPR_TEST(0, testPoolReuse),
+        MPR_TEST(0, testPoolLimits),
+        MPR_TEST(0, testPoolIdleTimeout),
+        MPR_TEST(0, testDnsRoundRobin),
+        MPR_TEST(0, testDnsNegative),
+        MPR_TEST(0, testDnsConnect),
+        MPR_TEST(0, 0),
+    },
+};
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -0,0 +1,605 @@
+/**
+    testHttpCompress.c - tests for dynamic compression and the compressed variant cache
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "testHttp.h"
+#include    <utime.h>
+
+#if BIT_PACK_ZLIB
+#include    <zlib.h>
+
+/*********************************** Locals ***********************************/
+
+#define VARIANT_MAX     (1024 * 1024)
+#define TEXT_LINES      200             /* Compressible response of about 10K */
+#define TEXT_MIN        256             /* Minimum size to compress dynamic responses */
+#define STREAM_COUNT    20              /* Times the text is written to exceed the queue maximum */
+
+typedef struct TestCompress {
+    HttpRoute   *route;
+    HttpConn    *conn;
+    HttpConn    *held;
+    MprBuf      *response;
+    char        *dir;
+    char        *source;
+} TestCompress;
+
+static void manageTestCompress(TestCompress *tc, int flags);
+
+/************************************ Code ************************************/
+
+static char *textContent()
+{
+    MprBuf      *buf;
+    int         i;
+
+    buf = mprCreateBuf(0, 0);
+    for (i = 0; i < TEXT_LINES; i++) {
+        mprPutToBuf(buf, "Line %d of the dynamic response\n", i);
+    }
+    mprAddNullToBuf(buf);
+    return mprGetBufStart(buf);
+}
+
+
+static void textAction(HttpConn *conn)
+{
+    httpSetContentType(conn, "text/plain");
+    httpWrite(conn->writeq, "%s", textContent());
+    httpFinalize(conn);
+}
+
+
+/*
+    Write more than the queue maximum so the response is compressed as it streams. The text is held as blocking
+    writes may yield to the garbage collector.
+ */
+static void streamAction(HttpConn *conn)
+{
+    char    *text;
+    int     i;
+
+    text = textContent();
+    mprHold(text);
+    httpSetContentType(conn, "text/plain");
+    for (i = 0; i < STREAM_COUNT; i++) {
+        httpWriteBlock(conn->writeq, text, slen(text), HTTP_BLOCK);
+    }
+    mprRelease(text);
+    httpFinalize(conn);
+}
+
+
+static void imageAction(HttpConn *conn)
+{
+    httpSetContentType(conn, "image/png");
+    httpWrite(conn->writeq, "%s", textContent());
+    httpFinalize(conn);
+}
+
+
+static void smallAction(HttpConn *conn)
+{
+    httpSetContentType(conn, "text/plain");
+    httpWrite(conn->writeq, "Hello World\n");
+    httpFinalize(conn);
+}
+
+
+static int initCompress(MprTestGroup *gp)
+{
+    TestCompress    *tc;
+    HttpRoute       *route;
+
+    gp->data = tc = mprAllocObj(TestCompress, manageTestCompress);
+    if (testGetRoute() == 0) {
+        return MPR_ERR_CANT_OPEN;
+    }
+    tc->dir = sfmt("/tmp/testHttpCompress-%d", getpid());
+    tc->source = sfmt("%s.txt", tc->dir);
+    tc->route = httpCreateInheritedRoute(testGetRoute());
+    httpSetRouteDynamicCompression(tc->route, 6, 1);
+
+    httpDefineAction("/compress/text", textAction);
+    httpDefineAction("/compress/stream", streamAction);
+    httpDefineAction("/compress/image", imageAction);
+    httpDefineAction("/compress/small", smallAction);
+    route = httpCreateInheritedRoute(testGetRoute());
+    httpSetRoutePattern(route, "^/compress/", 0);
+    /* Filters in the order of configured routes. The test endpoint route only has the chunk filter. */
+    httpClearRouteStages(route, HTTP_STAGE_TX);
+    httpAddRouteFilter(route, "compressFilter", NULL, HTTP_STAGE_TX);
+    httpAddRouteFilter(route, "rangeFilter", NULL, HTTP_STAGE_TX);
+    httpAddRouteFilter(route, "chunkFilter", NULL, HTTP_STAGE_TX);
+    httpSetRouteDynamicCompression(route, 6, TEXT_MIN);
+    httpFinalizeRoute(route);
+    return 0;
+}
+
+
+static int termCompress(MprTestGroup *gp)
+{
+    TestCompress    *tc;
+    MprDirEntry     *dp;
+    int             next;
+
+    tc = gp->data;
+    httpSetCompressCache(MPR->httpService, NULL, 0);
+    for (ITERATE_ITEMS(mprGetPathFiles(tc->dir, MPR_PATH_RELATIVE), dp, next)) {
+        unlink(mprJoinPath(tc->dir, dp->name));
+    }
+    rmdir(tc->dir);
+    unlink(tc->source);
+    return 0;
+}
+
+
+static void manageTestCompress(TestCompress *tc, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(tc->route);
+        mprMark(tc->conn);
+        mprMark(tc->held);
+        mprMark(tc->response);
+        mprMark(tc->dir);
+        mprMark(tc->source);
+    }
+}
+
+
+/*
+    Get a response header value
+ */
+static char *getHeader(MprBuf *response, cchar *key)
+{
+    char    *cp, *end;
+
+    if ((cp = scontains(mprGetBufStart(response), sfmt("\r\n%s: ", key))) == 0) {
+        return 0;
+    }
+    cp += slen(key) + 4;
+    if ((end = strstr(cp, "\r\n")) == 0) {
+        return 0;
+    }
+    return snclone(cp, end - cp);
+}
+
+
+/*
+    Get a response from the dynamic compression route. Returns the body and its length which may include nulls.
+ */
+static char *get(MprTestGroup *gp, cchar *uri, cchar *accept, ssize *len)
+{
+    TestCompress    *tc;
+    char            *body;
+
+    tc = gp->data;
+    *len = 0;
+    tc->response = testRequest(sfmt("GET %s HTTP/1.1\r\nHost: 127.0.0.1\r\n%s%sConnection: close\r\n\r\n", uri,
+        accept ? "Accept-Encoding: " : "", accept ? sjoin(accept, "\r\n", NULL) : ""), NULL, 0);
+    if (testGetStatus(tc->response) != HTTP_CODE_OK || (body = scontains(mprGetBufStart(tc->response), "\r\n\r\n")) == 0) {
+        return 0;
+    }
+    body += 4;
+    *len = mprGetBufEnd(tc->response) - body;
+    return body;
+}
+
+
+/*
+    Inflate a gzip or zlib wrapped body. Returns NULL if the body is not a complete compressed stream.
+ */
+static char *inflateBody(cchar *body, ssize len, int gzip)
+{
+    z_stream    zs;
+    MprBuf      *buf;
+    int         rc;
+
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, gzip ? MAX_WBITS + 16 : MAX_WBITS) != Z_OK) {
+        return 0;
+    }
+    buf = mprCreateBuf(TEXT_LINES * 64 * STREAM_COUNT, -1);
+    zs.next_in = (uchar*) body;
+    zs.avail_in = (uInt) len;
+    zs.next_out = (uchar*) mprGetBufEnd(buf);
+    zs.avail_out = (uInt) mprGetBufSpace(buf) - 1;
+    rc = inflate(&zs, Z_FINISH);
+    mprAdjustBufEnd(buf, zs.total_out);
+    inflateEnd(&zs);
+    if (rc != Z_STREAM_END) {
+        return 0;
+    }
+    mprAddNullToBuf(buf);
+    return mprGetBufStart(buf);
+}
+
+
+/*
+    Remove the chunk framing from a body in place and return the new length. Chunks are preceded by a CRLF which for
+    the first chunk terminates the headers. Returns -1 if the framing is invalid.
+ */
+static ssize dechunk(char *body, ssize len)
+{
+    char    *cp, *end, *out;
+    ssize   size;
+
+    out = body;
+    for (cp = body, end = &body[len]; cp < end; ) {
+        if (cp > body && sncmp(cp, "\r\n", 2) == 0) {
+            cp += 2;
+        }
+        size = (ssize) stoiradix(cp, 16, NULL);
+        if ((cp = strstr(cp, "\r\n")) == 0 || (cp + 2 + size) > end) {
+            return -1;
+        }
+        if (size == 0) {
+            return out - body;
+        }
+        memmove(out, cp + 2, size);
+        out += size;
+        cp += 2 + size;
+    }
+    return -1;
+}
+
+
+/*
+    Responses are compressed with the preferred accepted encoding and have a compressed content length
+ */
+static void testCompressResponse(MprTestGroup *gp)
+{
+    TestCompress    *tc;
+    char            *body;
+    ssize           len;
+
+    tc = gp->data;
+    body = get(gp, "/compress/text", "gzip, deflate", &len);
+    tassert(body != 0);
+    if (body) {
+        tassert(smatch(getHeader(tc->response, "Content-Encoding"), "gzip"));
+        tassert(smatch(getHeader(tc->response, "Vary"), "Accept-Encoding"));
+        tassert(len < slen(textContent()));
+        if (getHeader(tc->response, "Content-Length")) {
+            tassert(stoi(getHeader(tc->response, "Content-Length")) == len);
+        }
+        tassert(smatch(inflateBody(body, len, 1), textContent()));
+    }
+
+    body = get(gp, "/compress/text", "deflate, gzip;q=0", &len);
+    tassert(body != 0);
+    if (body) {
+        tassert(smatch(getHeader(tc->response, "Content-Encoding"), "deflate"));
+        tassert(smatch(inflateBody(body, len, 0), textContent()));
+    }
+}
+
+
+/*
+    Responses larger than the queue are compressed as they stream and are sent using chunked transfer encoding
+ */
+static void testCompressStream(MprTestGroup *gp)
+{
+    TestCompress    *tc;
+    MprBuf          *expect;
+    char            *body, *text;
+    ssize           len;
+    int             i;
+
+    tc = gp->data;
+    body = get(gp, "/compress/stream", "gzip", &len);
+    tassert(body != 0);
+    if (body) {
+        text = textContent();
+        expect = mprCreateBuf(0, 0);
+        for (i = 0; i < STREAM_COUNT; i++) {
+            mprPutStringToBuf(expect, text);
+        }
+        mprAddNullToBuf(expect);
+        tassert(smatch(getHeader(tc->response, "Content-Encoding"), "gzip"));
+        tassert(smatch(getHeader(tc->response, "Transfer-Encoding"), "chunked"));
+        tassert(getHeader(tc->response, "Content-Length") == 0);
+        len = dechunk(body, len);
+        tassert(len > 0);
+        tassert(len < mprGetBufLength(expect));
+        tassert(smatch(inflateBody(body, len, 1), mprGetBufStart(expect)));
+    }
+}
+
+
+/*
+    Responses are not compressed without an acceptable encoding, for compressed mime types or below the minimum size.
+    The response still varies by encoding.
+ */
+static void testCompressSkipped(MprTestGroup *gp)
+{
+    TestCompress    *tc;
+    char            *body;
+    ssize           len;
+
+    tc = gp->data;
+    body = get(gp, "/compress/text", NULL, &len);
+    tassert(body != 0);
+    if (body) {
+        tassert(getHeader(tc->response, "Content-Encoding") == 0);
+        tassert(smatch(getHeader(tc->response, "Vary"), "Accept-Encoding"));
+        tassert(smatch(body, textContent()));
+    }
+
+    body = get(gp, "/compress/text", "gzip;q=0, br", &len);
+    tassert(body != 0);
+    if (body) {
+        tassert(getHeader(tc->response, "Content-Encoding") == 0);
+        tassert(smatch(body, textContent()));
+    }
+
+    body = get(gp, "/compress/image", "gzip", &len);
+    tassert(body != 0);
+    if (body) {
+        tassert(getHeader(tc->response, "Content-Encoding") == 0);
+        tassert(smatch(body, textContent()));
+    }
+
+    body = get(gp, "/compress/small", "gzip", &len);
+    tassert(body != 0);
+    if (body) {
+        tassert(getHeader(tc->response, "Content-Encoding") == 0);
+        tassert(smatch(body, "Hello World\n"));
+    }
+}
+
+
+/*
+    Write the source file with compressible content. The modification time is set so each version differs.
+ */
+static void writeSource(MprTestGroup *gp, int version)
+{
+    TestCompress    *tc;
+    MprBuf          *buf;
+    struct utimbuf  times;
+    int             i;
+
+    tc = gp->data;
+    buf = mprCreateBuf(0, 0);
+    for (i = 0; i < 1000; i++) {
+        mprPutToBuf(buf, "Version %d line %d of the compressible source file\n", version, i);
+    }
+    tassert(mprWritePathContents(tc->source, mprGetBufStart(buf), mprGetBufLength(buf), 0644) > 0);
+    times.actime = times.modtime = time(0) - 1000 + version;
+    utime(tc->source, &times);
+}
+
+
+/*
+    Prepare a request for the source file as httpMapFile would and map it to a compressed variant
+ */
+static HttpConn *mapSource(MprTestGroup *gp)
+{
+    TestCompress    *tc;
+    HttpConn        *conn;
+    HttpTx          *tx;
+
+    tc = gp->data;
+    tc->conn = conn = httpCreateConn(MPR->httpService, NULL, gp->dispatcher);
+    conn->rx->acceptEncoding = sclone("gzip");
+    tx = conn->tx;
+    tx->filename = sclone(tc->source);
+    tx->ext = sclone("txt");
+    tx->etag = sclone("\"etag\"");
+    mprGetPathInfo(tx->filename, &tx->fileInfo);
+    httpMapCompressedVariant(conn, tc->route);
+    return conn;
+}
+
+
+/*
+    Map the source until the variant is compressed by a worker. Returns the request holding the variant.
+ */
+static HttpConn *waitForVariant(MprTestGroup *gp)
+{
+    HttpConn    *conn;
+    MprTicks    mark;
+
+    mark = mprGetTicks();
+    do {
+        if ((conn = mapSource(gp))->tx->variant) {
+            return conn;
+        }
+        mprSleep(10);
+    } while (mprGetElapsedTicks(mark) < TEST_TIMEOUT);
+    return 0;
+}
+
+
+static cchar *variantName(MprPath *info, int64 size, MprTime modified)
+{
+    return sfmt("%Lx-%Lx-gzip-%Lx-%Lx.gz", info->dev, info->inode, size, (int64) modified);
+}
+
+
+/*
+    The first request queues compression. Later requests are mapped to the gzip variant with a weak ETag.
+ */
+static void testVariantCreated(MprTestGroup *gp)
+{
+    TestCompress    *tc;
+    HttpConn        *conn;
+    HttpTx          *tx;
+    MprPath         info;
+    char            *content;
+    ssize           len;
+
+    tc = gp->data;
+    writeSource(gp, 1);
+    tassert(httpSetCompressCache(MPR->httpService, tc->dir, VARIANT_MAX) == 0);
+    mprGetPathInfo(tc->source, &info);
+
+    conn = mapSource(gp);
+    tassert(conn->tx->variant == 0);
+    tassert(smatch(conn->tx->filename, tc->source));
+
+    conn = waitForVariant(gp);
+    tassert(conn != 0);
+    if (!conn) {
+        return;
+    }
+    tx = conn->tx;
+    tassert(smatch(tx->filename, mprJoinPath(tc->dir, variantName(&info, info.size, info.mtime))));
+    tassert(smatch(mprLookupKey(tx->headers, "Content-Encoding"), "gzip"));
+    tassert(smatch(tx->etag, "W/\"etag\""));
+    tassert(tx->fileInfo.size < info.size);
+
+    content = mprReadPathContents(tx->filename, &len);
+    tassert(len == tx->fileInfo.size);
+    tassert((uchar) content[0] == 0x1f && (uchar) content[1] == 0x8b);
+    httpReleaseCompressedVariant(tx);
+    tassert(mprPathExists(tx->filename, R_OK));
+}
+
+
+/*
+    A modified source is compressed again and the variant of the old version is removed when no longer in use
+ */
+static void testVariantModified(MprTestGroup *gp)
+{
+    TestCompress    *tc;
+    HttpConn        *conn;
+    MprPath         info;
+    cchar           *oldPath, *newPath;
+
+    tc = gp->data;
+    writeSource(gp, 1);
+    tassert(httpSetCompressCache(MPR->httpService, tc->dir, VARIANT_MAX) == 0);
+    tc->held = waitForVariant(gp);
+    tassert(tc->held != 0);
+    if (!tc->held) {
+        return;
+    }
+    oldPath = tc->held->tx->filename;
+
+    /* The old variant is still being sent by the held request */
+    writeSource(gp, 2);
+    mprGetPathInfo(tc->source, &info);
+    conn = mapSource(gp);
+    tassert(conn->tx->variant == 0);
+    tassert(mprPathExists(oldPath, R_OK));
+
+    conn = waitForVariant(gp);
+    tassert(conn != 0);
+    if (conn) {
+        newPath = conn->tx->filename;
+        tassert(smatch(newPath, mprJoinPath(tc->dir, variantName(&info, info.size, info.mtime))));
+        tassert(!smatch(newPath, oldPath));
+        httpReleaseCompressedVariant(conn->tx);
+    }
+    tassert(mprPathExists(oldPath, R_OK));
+    httpReleaseCompressedVariant(tc->held->tx);
+    tassert(!mprPathExists(oldPath, R_OK));
+    tc->held = 0;
+}
+
+
+/*
+    Variants in the cache directory from a prior run are reused and counted. Incomplete and unknown files are removed.
+ */
+static void testVariantScan(MprTestGroup *gp)
+{
+    TestCompress    *tc;
+    HttpVariants    *cache;
+    HttpConn        *conn;
+    MprPath         info;
+    struct utimbuf  times;
+    cchar           *path, *stale, *tmp, *junk;
+
+    tc = gp->data;
+    writeSource(gp, 3);
+    mprGetPathInfo(tc->source, &info);
+    httpSetCompressCache(MPR->httpService, NULL, 0);
+    mprMakeDir(tc->dir, 0700, -1, -1, 1);
+
+    path = mprJoinPath(tc->dir, variantName(&info, info.size, info.mtime));
+    stale = mprJoinPath(tc->dir, variantName(&info, info.size + 1, info.mtime - 100));
+    tmp = sfmt("%s.123.tmp", path);
+    junk = mprJoinPath(tc->dir, "junk.gz");
+    mprWritePathContents(stale, "stale", 5, 0600);
+    mprWritePathContents(path, "variant", 7, 0600);
+    mprWritePathContents(tmp, "partial", 7, 0600);
+    mprWritePathContents(junk, "junk", 4, 0600);
+    times.actime = times.modtime = time(0) - 100;
+    utime(stale, &times);
+
+    /* Variants of older versions of the source are removed */
+    tassert(httpSetCompressCache(MPR->httpService, tc->dir, VARIANT_MAX) == 0);
+    cache = ((Http*) MPR->httpService)->variants;
+    tassert(cache->size == 7);
+    tassert(mprGetHashLength(cache->items) == 1);
+    tassert(mprPathExists(path, R_OK));
+    tassert(!mprPathExists(stale, R_OK));
+    tassert(!mprPathExists(tmp, R_OK));
+    tassert(!mprPathExists(junk, R_OK));
+
+    /* The scanned variant is used without compressing again */
+    conn = mapSource(gp);
+    tassert(conn->tx->variant != 0);
+    tassert(smatch(conn->tx->filename, path));
+    httpReleaseCompressedVariant(conn->tx);
+
+    /* A bound smaller than the directory contents evicts variants */
+    tassert(httpSetCompressCache(MPR->httpService, tc->dir, 4) == 0);
+    cache = ((Http*) MPR->httpService)->variants;
+    tassert(cache->size == 0);
+    tassert(!mprPathExists(path, R_OK));
+}
+
+
+MprTestDef testHttpCompress = {
+    "compress", 0, initCompress, termCompress,
+    {
+        MPR_TEST(0, testCompressResponse),
+        MPR_TEST(0, testCompressStream),
+        MPR_TEST(0, testCompressSkipped),
+        MPR_TEST(0, testVariantCreated),
+        MPR_TEST(0, testVariantModified),
+        MPR_TEST(0, testVariantScan),
+        MPR_TEST(0, 0),
+    },
+};
+#endif /* BIT_PACK_ZLIB */
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -0,0 +1,271 @@
+/**
+    testHttpCrypto.c - tests for the EST AES and AES-GCM implementations
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "testHttp.h"
+
+#if BIT_PACK_EST
+#include    "est.h"
+
+/*********************************** Locals ***********************************/
+
+#define TEST_DATA       1000            /* Not a multiple of the block size or of four blocks */
+
+/*
+    GCM test case 4 from the GCM specification
+ */
+static char *gcmKey = "feffe9928665731c6d6a8f9467308308";
+static char *gcmIv = "cafebabefacedbaddecaf888";
+static char *gcmAdd = "feedfacedeadbeeffeedfacedeadbeefabaddad2";
+static char *gcmPlain =
+    "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+    "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39";
+static char *gcmCipher =
+    "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+    "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091";
+static char *gcmTag = "5bc94fbc3221a5db94fae95ae7121a47";
+
+/*
+    FIPS-197 appendix C.1 and C.3
+ */
+static char *aesPlain = "00112233445566778899aabbccddeeff";
+static char *aes128Cipher = "69c4e0d86a7b0430d8cdb78070b4c55a";
+static char *aes256Cipher = "8ea2b7ca516745bfeafc49904b496089";
+
+/************************************ Code ************************************/
+
+static int fromHex(cchar *hex, uchar *buf)
+{
+    int     len;
+
+    for (len = 0; hex[0] && hex[1]; hex += 2, len++) {
+        buf[len] = (uchar) stoiradix(snclone(hex, 2), 16, NULL);
+    }
+    return len;
+}
+
+
+/*
+    Return true if the CPU supports AES-NI. The portable table code is always tested.
+ */
+static bool hasAesni()
+{
+#if defined(EST_HAVE_AESNI)
+    return aesni_supports(AESNI_AES);
+#else
+    return 0;
+#endif
+}
+
+
+/*
+    Select the AES-NI or table implementation for contexts keyed after this call
+ */
+static void useAesni(bool on)
+{
+#if defined(EST_HAVE_AESNI)
+    aesni_enable(on);
+#endif
+}
+
+
+static void checkAes(MprTestGroup *gp)
+{
+    aes_context     aes;
+    uchar           key[32], plain[16], expect[16], out[16];
+    int             i;
+
+    for (i = 0; i < 32; i++) {
+        key[i] = (uchar) i;
+    }
+    fromHex(aesPlain, plain);
+
+    fromHex(aes128Cipher, expect);
+    aes_setkey_enc(&aes, key, 128);
+    aes_crypt_ecb(&aes, AES_ENCRYPT, plain, out);
+    tassert(memcmp(out, expect, 16) == 0);
+    aes_setkey_dec(&aes, key, 128);
+    aes_crypt_ecb(&aes, AES_DECRYPT, expect, out);
+    tassert(memcmp(out, plain, 16) == 0);
+
+    fromHex(aes256Cipher, expect);
+    aes_setkey_enc(&aes, key, 256);
+    aes_crypt_ecb(&aes, AES_ENCRYPT, plain, out);
+    tassert(memcmp(out, expect, 16) == 0);
+    aes_setkey_dec(&aes, key, 256);
+    aes_crypt_ecb(&aes, AES_DECRYPT, expect, out);
+    tassert(memcmp(out, plain, 16) == 0);
+}
+
+
+static void checkGcm(MprTestGroup *gp)
+{
+    gcm_context     gcm;
+    uchar           key[16], iv[12], add[20], plain[60], cipher[60], expect[60], tag[16], out[60];
+    int             len, addLen, ivLen;
+
+    fromHex(gcmKey, key);
+    ivLen = fromHex(gcmIv, iv);
+    addLen = fromHex(gcmAdd, add);
+    len = fromHex(gcmPlain, plain);
+
+    tassert(gcm_setkey(&gcm, key, 128) == 0);
+    tassert(gcm_crypt_and_tag(&gcm, GCM_ENCRYPT, len, iv, ivLen, add, addLen, plain, cipher, 16, tag) == 0);
+    fromHex(gcmCipher, expect);
+    tassert(memcmp(cipher, expect, len) == 0);
+    fromHex(gcmTag, expect);
+    tassert(memcmp(tag, expect, 16) == 0);
+
+    tassert(gcm_auth_decrypt(&gcm, len, iv, ivLen, add, addLen, tag, 16, cipher, out) == 0);
+    tassert(memcmp(out, plain, len) == 0);
+
+    /* A modified tag or ciphertext fails authentication and the output is cleared */
+    tag[0] ^= 1;
+    tassert(gcm_auth_decrypt(&gcm, len, iv, ivLen, add, addLen, tag, 16, cipher, out) == EST_ERR_GCM_AUTH_FAILED);
+    tassert(out[0] == 0 && out[len - 1] == 0);
+    tag[0] ^= 1;
+    cipher[len - 1] ^= 1;
+    tassert(gcm_auth_decrypt(&gcm, len, iv, ivLen, add, addLen, tag, 16, cipher, out) == EST_ERR_GCM_AUTH_FAILED);
+    gcm_free(&gcm);
+}
+
+
+/*
+    Known answer tests for the table implementation and for AES-NI if the CPU supports it
+ */
+static void testAesKnownAnswer(MprTestGroup *gp)
+{
+    useAesni(0);
+    checkAes(gp);
+    if (hasAesni()) {
+        useAesni(1);
+        checkAes(gp);
+    }
+    useAesni(1);
+}
+
+
+static void testGcmKnownAnswer(MprTestGroup *gp)
+{
+    useAesni(0);
+    checkGcm(gp);
+    if (hasAesni()) {
+        useAesni(1);
+        checkGcm(gp);
+    }
+    useAesni(1);
+}
+
+
+/*
+    Encrypt the data with CBC and GCM and return the GCM tag. The data is then decrypted and compared.
+ */
+static void cryptData(MprTestGroup *gp, uchar *data, int len, uchar *cbc, uchar *gcmOut, uchar *tag)
+{
+    aes_context     aes;
+    gcm_context     gcm;
+    uchar           key[32], iv[16], add[13], out[TEST_DATA], streamTag[16];
+    int             cbcLen, n;
+
+    memset(key, 0x42, sizeof(key));
+    memset(add, 0x17, sizeof(add));
+
+    /* CBC decryption runs four blocks at a time with AES-NI, so the length is not a multiple of four blocks */
+    cbcLen = len & ~15;
+    memset(iv, 0x24, sizeof(iv));
+    aes_setkey_enc(&aes, key, 256);
+    aes_crypt_cbc(&aes, AES_ENCRYPT, cbcLen, iv, data, cbc);
+    memset(iv, 0x24, sizeof(iv));
+    aes_setkey_dec(&aes, key, 256);
+    aes_crypt_cbc(&aes, AES_DECRYPT, cbcLen, iv, cbc, out);
+    tassert(memcmp(out, data, cbcLen) == 0);
+
+    /* GCM in pieces must match a single pass including a partial final block */
+    memset(iv, 0x24, sizeof(iv));
+    gcm_setkey(&gcm, key, 128);
+    gcm_crypt_and_tag(&gcm, GCM_ENCRYPT, len, iv, 12, add, sizeof(add), data, gcmOut, 16, tag);
+    n = 160;
+    tassert(gcm_starts(&gcm, GCM_ENCRYPT, iv, 12, add, sizeof(add)) == 0);
+    tassert(gcm_update(&gcm, n, data, out) == 0);
+    tassert(gcm_update(&gcm, len - n, &data[n], &out[n]) == 0);
+    tassert(gcm_finish(&gcm, streamTag, 16) == 0);
+    tassert(memcmp(out, gcmOut, len) == 0);
+    tassert(memcmp(streamTag, tag, 16) == 0);
+    tassert(gcm_auth_decrypt(&gcm, len, iv, 12, add, sizeof(add), tag, 16, gcmOut, out) == 0);
+    tassert(memcmp(out, data, len) == 0);
+    gcm_free(&gcm);
+}
+
+
+/*
+    The AES-NI and table implementations produce the same output for bulk data
+ */
+static void testAesniMatchesTable(MprTestGroup *gp)
+{
+    uchar   data[TEST_DATA], cbc[2][TEST_DATA], gcm[2][TEST_DATA], tag[2][16];
+    int     i;
+
+    if (!hasAesni()) {
+        return;
+    }
+    for (i = 0; i < TEST_DATA; i++) {
+        data[i] = (uchar) (i * 7 + (i >> 8));
+    }
+    useAesni(0);
+    cryptData(gp, data, TEST_DATA, cbc[0], gcm[0], tag[0]);
+    useAesni(1);
+    cryptData(gp, data, TEST_DATA, cbc[1], gcm[1], tag[1]);
+    tassert(memcmp(cbc[0], cbc[1], TEST_DATA & ~15) == 0);
+    tassert(memcmp(gcm[0], gcm[1], TEST_DATA) == 0);
+    tassert(memcmp(tag[0], tag[1], 16) == 0);
+}
+
+
+MprTestDef testHttpCrypto = {
+    "crypto", 0, 0, 0,
+    {
+        MPR_TEST(0, testAesKnownAnswer),
+        MPR_TEST(0, testGcmKnownAnswer),
+        MPR_TEST(0, testAesniMatchesTable),
+        MPR_TEST(0, 0),
+    },
+};
+#endif /* BIT_PACK_EST */
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
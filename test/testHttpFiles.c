@@ -0,0 +1,551 @@
+/**
+    testHttpFiles.c - tests for the static file cache and sending files
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "testHttp.h"
+
+/*********************************** Locals ***********************************/
+
+#define FILE_SIZE       (96 * 1024)
+#define LARGE_SIZE      (4 * 1024 * 1024)   /* Ranges from this file need many sendfile calls */
+
+typedef struct TestFiles {
+    HttpConn    *conn;
+    MprBuf      *response;
+    char        *path;
+    char        *other;
+    char        *content;
+} TestFiles;
+
+/*
+    File sent by the actions and the file handler
+ */
+static char *filesPath;
+
+/*
+    Minimal file handler registered by this group and whether it last used the send connector
+ */
+static HttpStage *fileHandler;
+static int usedSendConnector;
+
+static void manageTestFiles(TestFiles *tf, int flags);
+
+/************************************ Code ************************************/
+
+/*
+    Request sendfile from an action. The pipeline uses the net connector which relays to the send connector.
+ */
+static void sendAction(HttpConn *conn)
+{
+    HttpTx      *tx;
+
+    tx = conn->tx;
+    httpSetSendConnector(conn, filesPath);
+    if (httpGetCachedPathInfo(conn, tx->filename, &tx->fileInfo, NULL) < 0) {
+        httpError(conn, HTTP_CODE_NOT_FOUND, "Cannot find document");
+        return;
+    }
+    httpSetContentType(conn, "application/octet-stream");
+    httpSetEntityLength(conn, tx->fileInfo.size);
+    httpPutForService(conn->writeq, httpCreateEntityPacket(0, tx->fileInfo.size, 0), HTTP_DELAY_SERVICE);
+    httpFinalize(conn);
+}
+
+
+static ssize fillFile(HttpQueue *q, HttpPacket *packet, MprOff pos, ssize size)
+{
+    HttpTx      *tx;
+    ssize       nbytes;
+
+    tx = q->conn->tx;
+    if (!tx->file && (tx->file = mprOpenFile(tx->filename, O_RDONLY | O_BINARY, 0)) == 0) {
+        return MPR_ERR_CANT_OPEN;
+    }
+    if (!packet->content && (packet->content = mprCreateBuf(size, -1)) == 0) {
+        return MPR_ERR_MEMORY;
+    }
+    if (mprSeekFile(tx->file, SEEK_SET, pos) != pos || 
+            (nbytes = mprReadFile(tx->file, mprGetBufEnd(packet->content), size)) != size) {
+        return MPR_ERR_CANT_READ;
+    }
+    mprAdjustBufEnd(packet->content, nbytes);
+    packet->esize = 0;
+    return nbytes;
+}
+
+
+static int rewriteFile(HttpConn *conn)
+{
+    HttpTx      *tx;
+
+    tx = conn->tx;
+    tx->filename = sclone(filesPath);
+    if (httpGetCachedPathInfo(conn, tx->filename, &tx->fileInfo, NULL) == 0) {
+        httpSetEntityLength(conn, tx->fileInfo.size);
+    }
+    return 0;
+}
+
+
+static void startFile(HttpQueue *q)
+{
+    HttpConn    *conn;
+    HttpTx      *tx;
+
+    conn = q->conn;
+    tx = conn->tx;
+    usedSendConnector = tx->connector == conn->http->sendConnector;
+    httpPutForService(q, httpCreateEntityPacket(0, tx->fileInfo.size, fillFile), HTTP_DELAY_SERVICE);
+    httpFinalize(conn);
+}
+
+
+static int initFiles(MprTestGroup *gp)
+{
+    TestFiles   *tf;
+    Http        *http;
+    HttpRoute   *route;
+    ssize       i;
+
+    gp->data = tf = mprAllocObj(TestFiles, manageTestFiles);
+    if (testGetRoute() == 0) {
+        return MPR_ERR_CANT_OPEN;
+    }
+    tf->path = sfmt("/tmp/testHttpFiles-%d.dat", getpid());
+    tf->other = sfmt("/tmp/testHttpFiles-%d.txt", getpid());
+    tf->content = mprAlloc(FILE_SIZE + 1);
+    for (i = 0; i < FILE_SIZE; i++) {
+        tf->content[i] = 'a' + (i % 26);
+    }
+    tf->content[FILE_SIZE] = '\0';
+    if (mprWritePathContents(tf->path, tf->content, FILE_SIZE, 0644) != FILE_SIZE) {
+        return MPR_ERR_CANT_WRITE;
+    }
+    filesPath = tf->path;
+    http = MPR->httpService;
+    httpSetFileCache(http, 16, 60 * MPR_TICKS_PER_SEC);
+    httpDefineAction("/files/send", sendAction);
+
+    /*
+        The file handler is provided by appweb. Register a minimal one so the send connector can be selected for
+        ranged responses.
+     */
+    if (!http->fileHandler) {
+        fileHandler = httpCreateHandler(http, "fileHandler", NULL);
+        fileHandler->rewrite = rewriteFile;
+        fileHandler->start = startFile;
+        http->fileHandler = fileHandler;
+    }
+    route = httpCreateInheritedRoute(testGetRoute());
+    httpSetRoutePattern(route, "^/range/", 0);
+    httpClearRouteStages(route, HTTP_STAGE_TX);
+    httpAddRouteFilter(route, "rangeFilter", NULL, HTTP_STAGE_TX);
+    httpAddRouteFilter(route, "chunkFilter", NULL, HTTP_STAGE_TX);
+    httpSetRouteHandler(route, "fileHandler");
+    httpFinalizeRoute(route);
+    return 0;
+}
+
+
+static int termFiles(MprTestGroup *gp)
+{
+    TestFiles   *tf;
+
+    tf = gp->data;
+    httpSetFileCache(MPR->httpService, 0, 0);
+    if (fileHandler && ((Http*) MPR->httpService)->fileHandler == fileHandler) {
+        ((Http*) MPR->httpService)->fileHandler = 0;
+    }
+    if (tf->path) {
+        unlink(tf->path);
+    }
+    if (tf->other) {
+        unlink(tf->other);
+    }
+    return 0;
+}
+
+
+static void manageTestFiles(TestFiles *tf, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(tf->conn);
+        mprMark(tf->response);
+        mprMark(tf->path);
+        mprMark(tf->other);
+        mprMark(tf->content);
+    }
+}
+
+
+/*
+    Get a response and return the body. Returns NULL if the status is not expected.
+ */
+static char *get(MprTestGroup *gp, cchar *uri, cchar *extra, int status)
+{
+    TestFiles   *tf;
+    char        *body;
+
+    tf = gp->data;
+    tf->response = testRequest(sfmt("GET %s HTTP/1.1\r\nHost: 127.0.0.1\r\n%sConnection: close\r\n\r\n", uri,
+        extra ? extra : ""), NULL, 0);
+    if (testGetStatus(tf->response) != status || (body = scontains(mprGetBufStart(tf->response), "\r\n\r\n")) == 0) {
+        return 0;
+    }
+    return &body[4];
+}
+
+
+/*
+    The open file shared through the file cache stays open after each request so it can be sent again
+ */
+static void testSharedFile(MprTestGroup *gp)
+{
+    TestFiles   *tf;
+    char        *body;
+    int         i;
+
+    tf = gp->data;
+    for (i = 0; i < 3; i++) {
+        body = get(gp, "/files/send", NULL, HTTP_CODE_OK);
+        tassert(body != 0);
+        tassert(smatch(body, tf->content));
+    }
+}
+
+
+/*
+    Get a response header value
+ */
+static char *getHeader(MprBuf *response, cchar *key)
+{
+    char    *cp, *end;
+
+    if ((cp = scontains(mprGetBufStart(response), sfmt("\r\n%s: ", key))) == 0) {
+        return 0;
+    }
+    cp += slen(key) + 4;
+    if ((end = strstr(cp, "\r\n")) == 0) {
+        return 0;
+    }
+    return snclone(cp, end - cp);
+}
+
+
+/*
+    A single range is sent from the file with a content length and range
+ */
+static void testSingleRange(MprTestGroup *gp)
+{
+    TestFiles   *tf;
+    char        *body;
+
+    tf = gp->data;
+    usedSendConnector = 0;
+    body = get(gp, "/range/file", "Range: bytes=100-1123\r\n", HTTP_CODE_PARTIAL);
+    tassert(body != 0);
+    tassert(usedSendConnector);
+    if (body) {
+        tassert(smatch(getHeader(tf->response, "Content-Length"), "1024"));
+        tassert(smatch(getHeader(tf->response, "Content-Range"), sfmt("bytes 100-1123/%d", FILE_SIZE)));
+        tassert(slen(body) == 1024);
+        tassert(strncmp(body, &tf->content[100], 1024) == 0);
+    }
+
+    /* Suffix range for the last bytes */
+    body = get(gp, "/range/file", "Range: bytes=-10\r\n", HTTP_CODE_PARTIAL);
+    tassert(body != 0);
+    if (body) {
+        tassert(smatch(body, &tf->content[FILE_SIZE - 10]));
+    }
+
+    /* Without a range, the entire file is sent with the file length */
+    body = get(gp, "/range/file", NULL, HTTP_CODE_OK);
+    tassert(body != 0);
+    tassert(usedSendConnector);
+    if (body) {
+        tassert(smatch(getHeader(tf->response, "Content-Length"), itos(FILE_SIZE)));
+        tassert(smatch(body, tf->content));
+    }
+}
+
+
+/*
+    Multiple ranges are sent from the file as a multipart response with a boundary before each range
+ */
+static void testMultipartRange(MprTestGroup *gp)
+{
+    TestFiles   *tf;
+    MprBuf      *expect;
+    cchar       *type, *boundary;
+    char        *body;
+    int         ranges[][2] = { { 0, 9 }, { 500, 4595 }, { FILE_SIZE - 20, FILE_SIZE - 1 } };
+    int         i;
+
+    tf = gp->data;
+    usedSendConnector = 0;
+    body = get(gp, "/range/file", sfmt("Range: bytes=0-9,500-4595,-20\r\n"), HTTP_CODE_PARTIAL);
+    tassert(body != 0);
+    tassert(usedSendConnector);
+    if (!body) {
+        return;
+    }
+    type = getHeader(tf->response, "Content-Type");
+    tassert(sstarts(type, "multipart/byteranges; boundary="));
+    boundary = &type[31];
+    tassert(*boundary);
+
+    expect = mprCreateBuf(0, 0);
+    for (i = 0; i < 3; i++) {
+        mprPutToBuf(expect, "\r\n--%s\r\nContent-Range: bytes %d-%d/%d\r\n\r\n", boundary, ranges[i][0], ranges[i][1],
+            FILE_SIZE);
+        mprPutBlockToBuf(expect, &tf->content[ranges[i][0]], ranges[i][1] - ranges[i][0] + 1);
+    }
+    mprPutToBuf(expect, "\r\n--%s--\r\n", boundary);
+    mprAddNullToBuf(expect);
+    tassert(smatch(getHeader(tf->response, "Content-Length"), itos(mprGetBufLength(expect))));
+    tassert(smatch(body, mprGetBufStart(expect)));
+}
+
+
+/*
+    Path information and ETags are answered from the cache without a stat until the revalidation period expires.
+    Missing paths are also cached.
+ */
+static void testFileCacheInfo(MprTestGroup *gp)
+{
+    TestFiles       *tf;
+    HttpFileCache   *cache;
+    MprPath         info, cached;
+    cchar           *etag, *missing;
+
+    tf = gp->data;
+    httpSetFileCache(MPR->httpService, 16, 60 * MPR_TICKS_PER_SEC);
+    cache = ((Http*) MPR->httpService)->fileCache;
+    tf->conn = httpCreateConn(MPR->httpService, NULL, gp->dispatcher);
+    mprWritePathContents(tf->other, "Hello World\n", 12, 0644);
+    mprGetPathInfo(tf->other, &info);
+
+    tassert(httpGetCachedPathInfo(tf->conn, tf->other, &cached, &etag) == 0);
+    tassert(cache->misses == 1 && cache->hits == 0);
+    tassert(cached.size == 12 && cached.inode == info.inode && cached.mtime == info.mtime);
+    tassert(smatch(etag, sfmt("\"%Lx-%Lx-%Lx\"", (int64) info.inode, (int64) info.size, (int64) info.mtime)));
+
+    tassert(httpGetCachedPathInfo(tf->conn, tf->other, &cached, &etag) == 0);
+    tassert(cache->misses == 1 && cache->hits == 1);
+    tassert(cached.size == 12);
+
+    missing = sfmt("%s.missing", tf->other);
+    tassert(httpGetCachedPathInfo(tf->conn, missing, &cached, NULL) < 0);
+    tassert(httpGetCachedPathInfo(tf->conn, missing, &cached, NULL) < 0);
+    tassert(cache->misses == 2 && cache->hits == 2);
+
+    /* Modifications are not seen until the entry is revalidated */
+    mprWritePathContents(tf->other, "Hello\n", 6, 0644);
+    tassert(httpGetCachedPathInfo(tf->conn, tf->other, &cached, NULL) == 0);
+    tassert(cached.size == 12);
+    httpSetFileCache(MPR->httpService, 16, 60 * MPR_TICKS_PER_SEC);
+}
+
+
+/*
+    With a zero revalidation period, modifications are detected on the next request. The shared open file is replaced
+    and the number of cached files is bounded.
+ */
+static void testFileCacheRevalidate(MprTestGroup *gp)
+{
+    TestFiles       *tf;
+    HttpFileCache   *cache;
+    MprPath         cached;
+    MprFile         *file;
+    cchar           *etag;
+    int             i;
+
+    tf = gp->data;
+    httpSetFileCache(MPR->httpService, 2, 0);
+    cache = ((Http*) MPR->httpService)->fileCache;
+    tf->conn = httpCreateConn(MPR->httpService, NULL, gp->dispatcher);
+    mprWritePathContents(tf->other, "Hello World\n", 12, 0644);
+
+    tassert(httpGetCachedPathInfo(tf->conn, tf->other, &cached, &etag) == 0);
+    tassert(cached.size == 12);
+    file = httpOpenCachedFile(tf->conn, tf->other);
+    tassert(file != 0);
+    tassert(tf->conn->tx->flags & HTTP_TX_SHARED_FILE);
+    tassert(httpOpenCachedFile(tf->conn, tf->other) == file);
+
+    mprWritePathContents(tf->other, "Hello\n", 6, 0644);
+    tassert(httpGetCachedPathInfo(tf->conn, tf->other, &cached, NULL) == 0);
+    tassert(cached.size == 6);
+    tassert(cache->hits == 0);
+    tassert(httpOpenCachedFile(tf->conn, tf->other) != file);
+
+    for (i = 0; i < 4; i++) {
+        httpGetCachedPathInfo(tf->conn, sfmt("%s.%d", tf->other, i), &cached, NULL);
+        tassert(mprGetHashLength(cache->files) <= 2);
+    }
+    httpSetFileCache(MPR->httpService, 16, 60 * MPR_TICKS_PER_SEC);
+}
+
+
+/*
+    Small files are sent from memory after the first request. The content of the least recently used file is discarded
+    when over the memory limit and larger files are not held.
+ */
+static void testFileContent(MprTestGroup *gp)
+{
+    TestFiles       *tf;
+    HttpFileCache   *cache;
+    HttpStats       stats;
+    char            *body, *small;
+
+    tf = gp->data;
+    httpSetFileCache(MPR->httpService, 16, 0);
+    httpSetFileCacheContent(MPR->httpService, 1024, 16);
+    cache = ((Http*) MPR->httpService)->fileCache;
+    small = sfmt("%s.small", tf->other);
+    mprWritePathContents(tf->other, "Hello World\n", 12, 0644);
+    mprWritePathContents(small, "Hello\n", 6, 0644);
+    filesPath = tf->other;
+
+    body = get(gp, "/files/send", NULL, HTTP_CODE_OK);
+    tassert(smatch(body, "Hello World\n"));
+    tassert(cache->contentMisses == 1 && cache->contentHits == 0);
+    tassert(cache->memory == 12);
+
+    body = get(gp, "/files/send", NULL, HTTP_CODE_OK);
+    tassert(smatch(body, "Hello World\n"));
+    tassert(cache->contentMisses == 1 && cache->contentHits == 1);
+    httpGetStats(&stats);
+    tassert(stats.fileContentHits == 1);
+    tassert(stats.fileContentMemory == 12);
+
+    /* A modified file is read again */
+    mprWritePathContents(tf->other, "Goodbye World\n", 14, 0644);
+    body = get(gp, "/files/send", NULL, HTTP_CODE_OK);
+    tassert(smatch(body, "Goodbye World\n"));
+    tassert(cache->contentMisses == 2);
+    tassert(cache->memory == 14);
+
+    /* Over the memory limit, the content of the other file is discarded */
+    filesPath = small;
+    body = get(gp, "/files/send", NULL, HTTP_CODE_OK);
+    tassert(smatch(body, "Hello\n"));
+    tassert(cache->memory == 6);
+
+    /* Files larger than the maximum are sent from the file */
+    filesPath = tf->path;
+    body = get(gp, "/files/send", NULL, HTTP_CODE_OK);
+    tassert(smatch(body, tf->content));
+    tassert(cache->memory == 6);
+    tassert(cache->contentMisses == 3);
+
+    unlink(small);
+    httpSetFileCache(MPR->httpService, 16, 60 * MPR_TICKS_PER_SEC);
+}
+
+
+/*
+    Large ranges fill the socket and are resumed by later sendfile calls from the range offsets
+ */
+static void testLargeRange(MprTestGroup *gp)
+{
+    TestFiles   *tf;
+    MprBuf      *expect;
+    cchar       *type, *boundary;
+    char        *body, *content;
+    int         ranges[][2] = { { 1, 1500000 }, { 2000000, LARGE_SIZE - 1 } };
+    int         i;
+
+    tf = gp->data;
+    content = mprAlloc(LARGE_SIZE + 1);
+    for (i = 0; i < LARGE_SIZE; i++) {
+        /* Printable and not periodic over short distances so misplaced offsets are detected */
+        content[i] = (char) (33 + ((i ^ (i >> 9)) % 90));
+    }
+    content[LARGE_SIZE] = '\0';
+    mprAddRoot(content);
+    tassert(mprWritePathContents(tf->other, content, LARGE_SIZE, 0644) == LARGE_SIZE);
+    filesPath = tf->other;
+
+    usedSendConnector = 0;
+    body = get(gp, "/range/file", "Range: bytes=1-3000000\r\n", HTTP_CODE_PARTIAL);
+    tassert(body != 0);
+    tassert(usedSendConnector);
+    if (body) {
+        tassert(slen(body) == 3000000);
+        tassert(strncmp(body, &content[1], 3000000) == 0);
+    }
+
+    body = get(gp, "/range/file", "Range: bytes=1-1500000,2000000-\r\n", HTTP_CODE_PARTIAL);
+    tassert(body != 0);
+    if (body) {
+        type = getHeader(tf->response, "Content-Type");
+        boundary = &type[31];
+        expect = mprCreateBuf(0, 0);
+        for (i = 0; i < 2; i++) {
+            mprPutToBuf(expect, "\r\n--%s\r\nContent-Range: bytes %d-%d/%d\r\n\r\n", boundary, ranges[i][0],
+                ranges[i][1], LARGE_SIZE);
+            mprPutBlockToBuf(expect, &content[ranges[i][0]], ranges[i][1] - ranges[i][0] + 1);
+        }
+        mprPutToBuf(expect, "\r\n--%s--\r\n", boundary);
+        mprAddNullToBuf(expect);
+        tassert(smatch(body, mprGetBufStart(expect)));
+    }
+    mprRemoveRoot(content);
+    filesPath = tf->path;
+    unlink(tf->other);
+}
+
+
+MprTestDef testHttpFiles = {
+    "files", 0, initFiles, termFiles,
+    {
+        MPR_TEST(0, testSharedFile),
+        MPR_TEST(0, testSingleRange),
+        MPR_TEST(0, testMultipartRange),
+        MPR_TEST(0, testLargeRange),
+        MPR_TEST(0, testFileCacheInfo),
+        MPR_TEST(0, testFileCacheRevalidate),
+        MPR_TEST(0, testFileContent),
+        MPR_TEST(0, 0),
+    },
+};
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -0,0 +1,201 @@
+/**
+    testHttpHash.c - tests for the open addressing hash tables used for request-local data
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "testHttp.h"
+
+/*********************************** Locals ***********************************/
+
+#define HASH_KEYS       1000            /* Enough keys to resize a default table several times */
+#define ITERATE_COUNT   200
+
+/************************************ Code ************************************/
+
+static char *keyName(int i)
+{
+    return sfmt("key-%d", i);
+}
+
+
+static void testOpenHashKeys(MprTestGroup *gp)
+{
+    MprHash     *hash;
+    MprKey      *kp;
+    int         count;
+
+    hash = mprCreateHash(0, MPR_HASH_OPEN | MPR_HASH_CASELESS);
+    tassert(hash != 0);
+    tassert(mprGetHashLength(hash) == 0);
+    tassert(mprLookupKey(hash, "missing") == 0);
+
+    tassert(mprAddKey(hash, "Content-Type", "text/plain") != 0);
+    tassert(mprAddKey(hash, "Content-Length", "42") != 0);
+    tassert(mprGetHashLength(hash) == 2);
+    tassert(smatch(mprLookupKey(hash, "content-type"), "text/plain"));
+    tassert(smatch(mprLookupKey(hash, "CONTENT-LENGTH"), "42"));
+
+    /* Adding an existing key replaces the value */
+    tassert(mprAddKey(hash, "content-type", "text/html") != 0);
+    tassert(mprGetHashLength(hash) == 2);
+    tassert(smatch(mprLookupKey(hash, "Content-Type"), "text/html"));
+
+    /* Duplicates are all visible to iteration */
+    tassert(mprAddDuplicateKey(hash, "Set-Cookie", "a=1") != 0);
+    tassert(mprAddDuplicateKey(hash, "Set-Cookie", "b=2") != 0);
+    tassert(mprGetHashLength(hash) == 4);
+    count = 0;
+    for (ITERATE_KEYS(hash, kp)) {
+        if (smatch(kp->key, "Set-Cookie")) {
+            tassert(smatch(kp->data, "a=1") || smatch(kp->data, "b=2"));
+            count++;
+        }
+    }
+    tassert(count == 2);
+
+    tassert(mprRemoveKey(hash, "Content-Length") == 0);
+    tassert(mprRemoveKey(hash, "Content-Length") == MPR_ERR_CANT_FIND);
+    tassert(mprLookupKey(hash, "Content-Length") == 0);
+    tassert(mprGetHashLength(hash) == 3);
+
+    /* As for chained tables, clones keep one entry for duplicate keys */
+    hash = mprCloneHash(hash);
+    tassert((hash->flags & MPR_HASH_OPEN) != 0);
+    tassert(mprGetHashLength(hash) == 2);
+    tassert(smatch(mprLookupKey(hash, "content-type"), "text/html"));
+    tassert(mprLookupKey(hash, "set-cookie") != 0);
+}
+
+
+/*
+    The table is resized as keys are added. Removed slots are reused and every key remains reachable.
+ */
+static void testOpenHashResize(MprTestGroup *gp)
+{
+    MprHash     *hash;
+    int         i, size;
+
+    hash = mprCreateHash(0, MPR_HASH_OPEN);
+    size = hash->size;
+    tassert((size & (size - 1)) == 0);
+
+    for (i = 0; i < HASH_KEYS; i++) {
+        tassert(mprAddKey(hash, keyName(i), itos(i)) != 0);
+    }
+    tassert(mprGetHashLength(hash) == HASH_KEYS);
+    tassert(hash->size > size);
+    tassert((hash->size & (hash->size - 1)) == 0);
+    tassert(hash->size > HASH_KEYS);
+    for (i = 0; i < HASH_KEYS; i++) {
+        tassert(smatch(mprLookupKey(hash, keyName(i)), itos(i)));
+    }
+
+    for (i = 1; i < HASH_KEYS; i += 2) {
+        tassert(mprRemoveKey(hash, keyName(i)) == 0);
+    }
+    tassert(mprGetHashLength(hash) == HASH_KEYS / 2);
+    size = hash->size;
+    for (i = 1; i < HASH_KEYS; i += 2) {
+        tassert(mprAddKey(hash, keyName(i), itos(-i)) != 0);
+    }
+    tassert(mprGetHashLength(hash) == HASH_KEYS);
+    tassert(hash->size == size);
+    for (i = 0; i < HASH_KEYS; i++) {
+        tassert(smatch(mprLookupKey(hash, keyName(i)), itos((i & 1) ? -i : i)));
+    }
+}
+
+
+/*
+    Keys may be removed while iterating. Every key is visited once and removed keys are not found again.
+ */
+static void testOpenHashRemoveIterate(MprTestGroup *gp)
+{
+    MprHash     *hash;
+    MprKey      *kp;
+    char        visited[ITERATE_COUNT];
+    int         i, count;
+
+    hash = mprCreateHash(0, MPR_HASH_OPEN);
+    for (i = 0; i < ITERATE_COUNT; i++) {
+        mprAddKey(hash, keyName(i), ITOP(i));
+    }
+    memset(visited, 0, sizeof(visited));
+    count = 0;
+    for (ITERATE_KEYS(hash, kp)) {
+        i = (int) PTOI(kp->data);
+        tassert(i >= 0 && i < ITERATE_COUNT && !visited[i]);
+        visited[i] = 1;
+        count++;
+        if ((i % 2) == 0) {
+            tassert(mprRemoveKey(hash, kp->key) == 0);
+        }
+    }
+    tassert(count == ITERATE_COUNT);
+    tassert(mprGetHashLength(hash) == ITERATE_COUNT / 2);
+
+    count = 0;
+    for (ITERATE_KEYS(hash, kp)) {
+        tassert((PTOI(kp->data) % 2) == 1);
+        count++;
+    }
+    tassert(count == ITERATE_COUNT / 2);
+    for (i = 0; i < ITERATE_COUNT; i++) {
+        tassert((mprLookupKeyEntry(hash, keyName(i)) != 0) == (i % 2));
+    }
+
+    /* Removing every key during iteration empties the table */
+    for (ITERATE_KEYS(hash, kp)) {
+        mprRemoveKey(hash, kp->key);
+    }
+    tassert(mprGetHashLength(hash) == 0);
+    tassert(mprGetFirstKey(hash) == 0);
+}
+
+
+MprTestDef testHttpHash = {
+    "hash", 0, 0, 0,
+    {
+        MPR_TEST(0, testOpenHashKeys),
+        MPR_TEST(0, testOpenHashResize),
+        MPR_TEST(0, testOpenHashRemoveIterate),
+        MPR_TEST(0, 0),
+    },
+};
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -0,0 +1,344 @@
+/**
+    testHttpJson.c - tests for the streaming JSON tape parser and JSON request bodies
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "testHttp.h"
+
+/*********************************** Locals ***********************************/
+
+#define LARGE_SIZE      (256 * 1024)
+
+typedef struct TestJson {
+    MprJsonTape     *tape;
+    MprBuf          *response;
+    char            *doc;
+} TestJson;
+
+/*
+    Documents converted with the tape must give the same object tree as mprDeserialize
+ */
+static cchar *documents[] = {
+    "{}",
+    "[]",
+    " { \"a\" : \"1\" , \"b\":[1, 2.5e3, true, false, null], \"c\":{\"d\":{\"e\":[[],{}]}} } ",
+    "{\"name\":\"x\",\"list\":[{\"id\":1},{\"id\":2,\"tags\":[\"a\",\"b\"]}],\"empty\":\"\",\"n\":-12}",
+    "{\"trailing\":[1,2,],\"obj\":{\"a\":1,},}",
+    "{\"path\":\"C:\\\\temp\\\\\",\"unicode\":\"\\u00e9t\\u00e9\",\"tab\":\"a\\tb\"}",
+    "[\"top\", {\"level\":\"array\"}, [1, [2, [3]]]]",
+    "{\"dup\":\"first\",\"dup\":\"second\"}",
+    "{\n\t\"lines\" : \"one\",\r\n\t\"more\" : { \"x\" : 1 }\n}",
+    /* Keys and values that span the 64 byte index blocks */
+    "{\"a-key-that-is-longer-than-the-sixty-four-byte-index-block-of-the-tape-parser\":\"long key\","
+        "\"value\":\"a value that is also longer than sixty four bytes so it spans more than one index block\","
+        "\"number\":1234567890123456789012345678901234567890123456789012345678901234567890}",
+    /* Nesting deeper than the initial parser stack */
+    "{\"a\":[[[[[[[[[[[[[[[[[[[[[[[[{\"deep\":\"yes\"}]]]]]]]]]]]]]]]]]]]]]]]}",
+    /* Syntax not supported by the tape is converted with mprDeserialize */
+    "{'single':'quotes'}",
+    "{unquoted: 1, key: \"value\"}",
+    "{\"a\":1 /* comment */ , \"b\":2}",
+    0
+};
+
+static void manageTestJson(TestJson *tj, int flags);
+
+/************************************ Code ************************************/
+
+/*
+    Echo the user and nested city params and a digest of the request body. The params are entered before the body
+    is read so the body must not be modified by converting the tape.
+ */
+static void echoAction(HttpConn *conn)
+{
+    cchar       *body, *city;
+
+    if ((city = mprQueryJsonString(httpGetParams(conn), "address.city")) == 0) {
+        city = "-";
+    }
+    body = httpGetBodyInput(conn);
+    httpSetContentType(conn, "text/plain");
+    httpWrite(conn->writeq, "user=%s city=%s body=%s\n", httpGetParam(conn, "user", "-"), city,
+        body ? mprGetMD5(body) : "-");
+    httpFinalize(conn);
+}
+
+
+static int initJson(MprTestGroup *gp)
+{
+    gp->data = mprAllocObj(TestJson, manageTestJson);
+    if (testGetRoute() == 0) {
+        return MPR_ERR_CANT_OPEN;
+    }
+    httpDefineAction("/json/echo", echoAction);
+    return 0;
+}
+
+
+static void manageTestJson(TestJson *tj, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(tj->tape);
+        mprMark(tj->response);
+        mprMark(tj->doc);
+    }
+}
+
+
+static MprJsonTape *writeTape(cchar *doc, ssize len, ssize pieceSize)
+{
+    MprJsonTape     *tape;
+    ssize           pos, n;
+
+    tape = mprCreateJsonTape(len);
+    for (pos = 0; pos < len; pos += n) {
+        n = min(pieceSize, len - pos);
+        mprWriteJsonTape(tape, &doc[pos], n);
+    }
+    mprFinishJsonTape(tape);
+    return tape;
+}
+
+
+/*
+    Write each document in pieces of every size and compare with mprDeserialize
+ */
+static void testTapePieces(MprTestGroup *gp)
+{
+    TestJson    *tj;
+    cchar       *doc, *expected, *actual, *str;
+    ssize       len, pieceSize;
+    int         i, same;
+
+    tj = gp->data;
+    for (i = 0; documents[i]; i++) {
+        doc = documents[i];
+        for (str = doc; isspace((uchar) *str); str++) ;
+        expected = mprSerialize(mprDeserialize(str), 0);
+        len = slen(doc);
+        same = 1;
+        for (pieceSize = 1; pieceSize <= len && same; pieceSize++) {
+            tj->tape = writeTape(doc, len, pieceSize);
+            actual = mprSerialize(mprJsonTapeToHash(tj->tape, NULL), 0);
+            same = smatch(actual, expected) && smatch(tj->tape->doc, doc);
+        }
+        tassert(same);
+    }
+    tj->tape = 0;
+}
+
+
+static void testTapeQuery(MprTestGroup *gp)
+{
+    TestJson    *tj;
+    cchar       *doc;
+    ssize       len, pieceSize;
+    int         ok;
+
+    tj = gp->data;
+
+    /* Escaped quotes and backslashes are found across piece boundaries */
+    doc = "{\"a\":\"x\\\"y\\\\\",\"b\":{\"c\":\"\\\\\\\"\"},\"d\":[1],\"dup\":\"one\",\"dup\":\"two\",\"n\":42}";
+    len = slen(doc);
+    ok = 1;
+    for (pieceSize = 1; pieceSize <= len && ok; pieceSize++) {
+        tj->tape = writeTape(doc, len, pieceSize);
+        ok = smatch(mprQueryJsonTape(tj->tape, "a"), "x\\\"y\\\\") &&
+            smatch(mprQueryJsonTape(tj->tape, "b.c"), "\\\\\\\"") &&
+            smatch(mprQueryJsonTape(tj->tape, "dup"), "two") &&
+            smatch(mprQueryJsonTape(tj->tape, "n"), "42");
+    }
+    tassert(ok);
+
+    /* Objects, arrays and missing properties are not string values */
+    tassert(mprQueryJsonTape(tj->tape, "d") == 0);
+    tassert(mprQueryJsonTape(tj->tape, "b") == 0);
+    tassert(mprQueryJsonTape(tj->tape, "b.missing") == 0);
+    tassert(mprQueryJsonTape(tj->tape, "a.b") == 0);
+    tassert(mprQueryJsonTape(tj->tape, "missing") == 0);
+
+    /* Unsupported syntax is queried via mprDeserialize */
+    tj->tape = writeTape("{key: 'value'}", 14, 5);
+    tassert(smatch(mprQueryJsonTape(tj->tape, "key"), "value"));
+    tj->tape = 0;
+}
+
+
+static void testTapeErrors(MprTestGroup *gp)
+{
+    TestJson    *tj;
+
+    tj = gp->data;
+    tj->tape = mprCreateJsonTape(0);
+    tassert(mprFinishJsonTape(tj->tape) == MPR_ERR_BAD_FORMAT);
+
+    tassert(mprFinishJsonTape(writeTape("{\"a\":[1,2}", 10, 3)) == MPR_ERR_BAD_FORMAT);
+    tassert(mprFinishJsonTape(writeTape("{\"a\":\"open", 10, 4)) == MPR_ERR_BAD_FORMAT);
+    tassert(mprFinishJsonTape(writeTape("{\"a\":1", 6, 1)) == MPR_ERR_BAD_FORMAT);
+
+    /* Writing in pieces after a failure does not fail again and the document text is kept */
+    tj->tape = mprCreateJsonTape(0);
+    tassert(mprWriteJsonTape(tj->tape, "{'a'", 4) == 0);
+    tassert(mprWriteJsonTape(tj->tape, ":'b'}", 5) == 0);
+    tassert(mprFinishJsonTape(tj->tape) == MPR_ERR_BAD_FORMAT);
+    tassert(smatch(tj->tape->doc, "{'a':'b'}"));
+    tassert(smatch(mprLookupKey(mprJsonTapeToHash(tj->tape, NULL), "a"), "b"));
+    tj->tape = 0;
+}
+
+
+/*
+    The tape buffer refers to the document text without copying
+ */
+static void testTapeBuf(MprTestGroup *gp)
+{
+    TestJson    *tj;
+    MprBuf      *buf;
+    cchar       *doc;
+
+    tj = gp->data;
+    doc = "{\"user\":\"admin\",\"list\":[1,2,3]}";
+    tj->tape = writeTape(doc, slen(doc), 7);
+    mprJsonTapeToHash(tj->tape, NULL);
+    buf = mprGetJsonTapeBuf(tj->tape);
+    tassert(buf != 0);
+    tassert(mprGetBufStart(buf) == tj->tape->doc);
+    tassert(mprGetBufLength(buf) == slen(doc));
+    mprAddNullToBuf(buf);
+    tassert(smatch(mprGetBufStart(buf), doc));
+    tj->tape = 0;
+}
+
+
+static char *postJson(MprTestGroup *gp, cchar *body, ssize pieceSize, int chunked)
+{
+    TestJson    *tj;
+    cchar       *headers;
+
+    tj = gp->data;
+    if (chunked) {
+        headers = "POST /json/echo HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Type: application/json\r\n"
+            "Transfer-Encoding: chunked\r\nConnection: close\r\n";
+    } else {
+        headers = sfmt("POST /json/echo HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Type: application/json\r\n"
+            "Content-Length: %d\r\nConnection: close\r\n\r\n", (int) slen(body));
+    }
+    if ((tj->response = testRequest(headers, body, pieceSize)) == 0) {
+        return 0;
+    }
+    return mprGetBufStart(tj->response);
+}
+
+
+/*
+    JSON request bodies are parsed into params as received and are still available to the handler unmodified
+ */
+static void testJsonRequest(MprTestGroup *gp)
+{
+    cchar       *body;
+    char        *response;
+
+    body = "{\"user\":\"admin\",\"address\":{\"city\":\"Seattle\",\"zip\":\"98101\"},\"list\":[1,2]}";
+    response = postJson(gp, body, 5, 0);
+    tassert(scontains(response, "200 OK") != 0);
+    tassert(scontains(response, "user=admin city=Seattle ") != 0);
+    tassert(scontains(response, mprGetMD5(body)) != 0);
+
+    response = postJson(gp, body, 3, 1);
+    tassert(scontains(response, "user=admin city=Seattle ") != 0);
+    tassert(scontains(response, mprGetMD5(body)) != 0);
+
+    /* Unsupported syntax is still entered into params */
+    body = "{user: 'guest', 'address': {'city': 'Paris'}}";
+    response = postJson(gp, body, 8, 0);
+    tassert(scontains(response, "user=guest city=Paris ") != 0);
+    tassert(scontains(response, mprGetMD5(body)) != 0);
+
+    /* Incomplete bodies are converted as far as mprDeserialize can and returned as sent */
+    body = "{\"user\":";
+    response = postJson(gp, body, 8, 0);
+    tassert(scontains(response, " city=- ") != 0);
+    tassert(scontains(response, mprGetMD5(body)) != 0);
+}
+
+
+/*
+    Bodies larger than the read queue are consumed into the tape and do not stall the connection
+ */
+static void testLargeJsonRequest(MprTestGroup *gp)
+{
+    TestJson    *tj;
+    MprBuf      *buf;
+    char        *response;
+    int         i;
+
+    tj = gp->data;
+    buf = mprCreateBuf(LARGE_SIZE + 1024, 0);
+    mprPutStringToBuf(buf, "{\"user\":\"bulk\",\"records\":[");
+    for (i = 0; mprGetBufLength(buf) < LARGE_SIZE; i++) {
+        mprPutToBuf(buf, "%s{\"id\":%d,\"name\":\"item %d\",\"tags\":[\"red\",\"large\"]}", i ? "," : "", i, i);
+    }
+    mprPutStringToBuf(buf, "],\"address\":{\"city\":\"Sydney\"}}");
+    mprAddNullToBuf(buf);
+    tj->doc = sclone(mprGetBufStart(buf));
+
+    response = postJson(gp, tj->doc, 16 * 1024, 0);
+    tassert(scontains(response, "user=bulk city=Sydney ") != 0);
+    tassert(scontains(response, mprGetMD5(tj->doc)) != 0);
+
+    response = postJson(gp, tj->doc, 16 * 1024, 1);
+    tassert(scontains(response, "user=bulk city=Sydney ") != 0);
+    tassert(scontains(response, mprGetMD5(tj->doc)) != 0);
+    tj->doc = 0;
+}
+
+
+MprTestDef testHttpJson = {
+    "json", 0, initJson, 0,
+    {
+        MPR_TEST(0, testTapePieces),
+        MPR_TEST(0, testTapeQuery),
+        MPR_TEST(0, testTapeErrors),
+        MPR_TEST(0, testTapeBuf),
+        MPR_TEST(0, testJsonRequest),
+        MPR_TEST(0, testLargeJsonRequest),
+        MPR_TEST(0, 0),
+    },
+};
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -0,0 +1,223 @@
+/**
+    testHttpParams.c - tests for query and form request params
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "http.h"
+
+/*********************************** Locals ***********************************/
+
+typedef struct TestParams {
+    Http        *http;
+    HttpConn    *conn;
+} TestParams;
+
+static void manageTestParams(TestParams *tp, int flags);
+
+/************************************ Code ************************************/
+
+static int initParams(MprTestGroup *gp)
+{
+    TestParams  *tp;
+
+    gp->data = tp = mprAllocObj(TestParams, manageTestParams);
+    return 0;
+}
+
+
+static void manageTestParams(TestParams *tp, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(tp->http);
+        mprMark(tp->conn);
+    }
+}
+
+
+/*
+    Prepare a new request with an optional query and urlencoded form body
+ */
+static HttpConn *createRequest(MprTestGroup *gp, cchar *query, cchar *form)
+{
+    TestParams  *tp;
+    HttpConn    *conn;
+    HttpPacket  *packet;
+
+    tp = gp->data;
+    tp->http = httpCreate(HTTP_CLIENT_SIDE | HTTP_SERVER_SIDE);
+    tp->conn = conn = httpCreateConn(tp->http, NULL, gp->dispatcher);
+    conn->rx->parsedUri = httpCreateUri(sfmt("/params%s%s", query ? "?" : "", query ? query : ""), 0);
+    conn->rx->eof = 1;
+    if (form) {
+        conn->rx->form = 1;
+        packet = httpCreateDataPacket(slen(form));
+        mprPutStringToBuf(packet->content, form);
+        httpPutForService(conn->readq, packet, HTTP_DELAY_SERVICE);
+    }
+    return conn;
+}
+
+
+static void testQueryParams(MprTestGroup *gp)
+{
+    HttpConn    *conn;
+
+    conn = createRequest(gp, "name=John+Smith&greeting=Hello%2C%20World%21&empty=&flag&tag=a&tag=b", 0);
+    httpAddQueryParams(conn);
+    tassert(smatch(httpGetParam(conn, "name", 0), "John Smith"));
+    tassert(smatch(httpGetParam(conn, "greeting", 0), "Hello, World!"));
+    tassert(smatch(httpGetParam(conn, "empty", 0), ""));
+    tassert(smatch(httpGetParam(conn, "flag", 0), ""));
+    tassert(smatch(httpGetParam(conn, "tag", 0), "a b"));
+    tassert(httpGetParam(conn, "missing", 0) == 0);
+    tassert(httpTestParam(conn, "name"));
+    tassert(!httpTestParam(conn, "missing"));
+
+    /* The parsed URI query is not modified */
+    tassert(smatch(conn->rx->parsedUri->query, "name=John+Smith&greeting=Hello%2C%20World%21&empty=&flag&tag=a&tag=b"));
+}
+
+
+static void testEscapedKeys(MprTestGroup *gp)
+{
+    HttpConn    *conn;
+
+    conn = createRequest(gp, "first%20name=John&a%2Bb=sum&=novalue&bad%zz=1", 0);
+    httpAddQueryParams(conn);
+    tassert(smatch(httpGetParam(conn, "first name", 0), "John"));
+    tassert(smatch(httpGetParam(conn, "a+b", 0), "sum"));
+    tassert(smatch(httpGetParam(conn, "bad%zz", 0), "1"));
+    tassert(httpGetParam(conn, "", 0) == 0);
+}
+
+
+static void testFormParams(MprTestGroup *gp)
+{
+    HttpConn    *conn;
+    MprHash     *params;
+    cchar       *form;
+
+    form = "name=John+Smith&address=300+Park+Avenue&tag=x&tag=&tag=y";
+    conn = createRequest(gp, 0, form);
+    httpAddBodyParams(conn);
+    tassert(smatch(httpGetParam(conn, "address", 0), "300 Park Avenue"));
+    tassert(smatch(httpGetParam(conn, "tag", 0), "x y"));
+    tassert(httpGetIntParam(conn, "missing", 42) == 42);
+
+    params = httpGetParams(conn);
+    tassert(mprGetHashLength(params) == 3);
+    tassert(smatch(mprLookupKey(params, "name"), "John Smith"));
+    tassert(smatch(mprLookupKey(params, "tag"), "x y"));
+
+    /* Decoding params must not modify the raw body content */
+    tassert(smatch(mprGetBufStart(conn->readq->first->content), form));
+    tassert(smatch(httpGetParamsString(conn), "address=300 Park Avenue&name=John Smith&tag=x y"));
+}
+
+
+/*
+    Query params are followed by form params of the same name, and values are joined in that order
+ */
+static void testQueryAndFormJoined(MprTestGroup *gp)
+{
+    HttpConn    *conn;
+
+    conn = createRequest(gp, "name=query&only=q", "name=form&body=b");
+    httpAddQueryParams(conn);
+    httpAddBodyParams(conn);
+    tassert(smatch(httpGetParam(conn, "name", 0), "query form"));
+    tassert(smatch(httpGetParam(conn, "only", 0), "q"));
+    tassert(smatch(httpGetParam(conn, "body", 0), "b"));
+
+    conn = createRequest(gp, "name=query", "name=form");
+    httpAddQueryParams(conn);
+    httpAddBodyParams(conn);
+    tassert(smatch(mprLookupKey(httpGetParams(conn), "name"), "query form"));
+}
+
+
+/*
+    A set param replaces params added before it. Params added after it are joined to it.
+ */
+static void testSetParamPrecedence(MprTestGroup *gp)
+{
+    HttpConn    *conn;
+
+    conn = createRequest(gp, "name=query&id=7", "name=form&id=8");
+    httpAddQueryParams(conn);
+    httpSetParam(conn, "name", "route");
+    tassert(smatch(httpGetParam(conn, "name", 0), "route"));
+
+    httpAddBodyParams(conn);
+    tassert(smatch(httpGetParam(conn, "name", 0), "route form"));
+    tassert(smatch(httpGetParam(conn, "id", 0), "7 8"));
+
+    httpSetParam(conn, "id", "9");
+    tassert(smatch(httpGetParam(conn, "id", 0), "9"));
+    tassert(httpGetIntParam(conn, "id", 0) == 9);
+    tassert(smatch(mprLookupKey(httpGetParams(conn), "name"), "route form"));
+    tassert(smatch(mprLookupKey(httpGetParams(conn), "id"), "9"));
+
+    /* The complete table gives the same result without prior lookups */
+    conn = createRequest(gp, "name=query", "name=form");
+    httpAddQueryParams(conn);
+    httpSetParam(conn, "name", "route");
+    httpAddBodyParams(conn);
+    tassert(smatch(mprLookupKey(httpGetParams(conn), "name"), "route form"));
+
+    /* An empty set value is replaced by later params */
+    conn = createRequest(gp, 0, "name=form");
+    httpSetParam(conn, "name", "");
+    httpAddBodyParams(conn);
+    tassert(smatch(httpGetParam(conn, "name", 0), "form"));
+}
+
+
+MprTestDef testHttpParams = {
+    "params", 0, initParams, 0,
+    {
+        MPR_TEST(0, testQueryParams),
+        MPR_TEST(0, testEscapedKeys),
+        MPR_TEST(0, testFormParams),
+        MPR_TEST(0, testQueryAndFormJoined),
+        MPR_TEST(0, testSetParamPrecedence),
+        MPR_TEST(0, 0),
+    },
+};
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
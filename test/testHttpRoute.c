@@ -0,0 +1,233 @@
+/**
+    testHttpRoute.c - tests for route method matching and interned strings
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "testHttp.h"
+
+/*********************************** Locals ***********************************/
+
+typedef struct TestRoute {
+    MprBuf      *response;
+} TestRoute;
+
+static void manageTestRoute(TestRoute *tr, int flags);
+
+/************************************ Code ************************************/
+
+/*
+    Respond with the name of the matching route in a header so it is also returned for HEAD requests.
+    The test endpoint default route is not named.
+ */
+static void routeAction(HttpConn *conn)
+{
+    cchar   *name;
+
+    name = conn->rx->route->name ? conn->rx->route->name : "default";
+    httpSetHeaderString(conn, "X-Route", name);
+    httpSetContentType(conn, "text/plain");
+    httpWrite(conn->writeq, "%s\n", name);
+    httpFinalize(conn);
+}
+
+
+static void addRoute(cchar *name, cchar *methods)
+{
+    HttpRoute   *route;
+
+    httpDefineAction(sfmt("/method/%s", name), routeAction);
+    route = httpCreateInheritedRoute(testGetRoute());
+    httpSetRouteName(route, name);
+    httpSetRoutePattern(route, sfmt("^/method/%s$", name), 0);
+    httpSetRouteMethods(route, methods);
+    httpFinalizeRoute(route);
+}
+
+
+static int initRoute(MprTestGroup *gp)
+{
+    gp->data = mprAllocObj(TestRoute, manageTestRoute);
+    if (testGetRoute() == 0) {
+        return MPR_ERR_CANT_OPEN;
+    }
+    addRoute("get", "GET");
+    addRoute("any", "ALL");
+    addRoute("custom", "PROPFIND");
+    return 0;
+}
+
+
+static void manageTestRoute(TestRoute *tr, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(tr->response);
+    }
+}
+
+
+/*
+    Issue a request and return the name of the matching route or NULL if no route matched
+ */
+static cchar *matchRoute(MprTestGroup *gp, cchar *method, cchar *name)
+{
+    TestRoute   *tr;
+    cchar       *start, *end;
+
+    tr = gp->data;
+    tr->response = testRequest(sfmt("%s /method/%s HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n",
+        method, name), NULL, 0);
+    if (testGetStatus(tr->response) != HTTP_CODE_OK) {
+        return 0;
+    }
+    if ((start = scontains(mprGetBufStart(tr->response), "X-Route: ")) == 0) {
+        return 0;
+    }
+    start += 9;
+    if ((end = strchr(start, '\r')) == 0) {
+        return 0;
+    }
+    return snclone(start, end - start);
+}
+
+
+/*
+    Route method masks include the methods with rx flags. All methods set every flag.
+ */
+static void testRouteMethodMask(MprTestGroup *gp)
+{
+    HttpRoute   *route, *child;
+
+    tassert(httpGetMethodFlag("GET") == HTTP_GET);
+    tassert(httpGetMethodFlag("DELETE") == HTTP_DELETE);
+    tassert(httpGetMethodFlag("PROPFIND") == 0);
+
+    route = httpCreateInheritedRoute(testGetRoute());
+    httpSetRouteMethods(route, "GET, POST");
+    tassert(route->methodMask == (HTTP_GET | HTTP_POST));
+    httpAddRouteMethods(route, "PUT PROPFIND");
+    tassert(route->methodMask == (HTTP_GET | HTTP_POST | HTTP_PUT));
+    httpSetRouteMethods(route, "ALL");
+    tassert(route->methodMask == HTTP_METHOD_MASK);
+    httpSetRouteMethods(route, "PROPFIND");
+    tassert(route->methodMask == 0);
+
+    /* Removing methods from an inherited route does not change the parent */
+    httpSetRouteMethods(route, "GET, POST, DELETE");
+    child = httpCreateInheritedRoute(route);
+    tassert(child->methodMask == route->methodMask);
+    httpRemoveRouteMethods(child, "DELETE");
+    tassert(child->methodMask == (HTTP_GET | HTTP_POST));
+    tassert(route->methodMask == (HTTP_GET | HTTP_POST | HTTP_DELETE));
+    tassert(mprLookupKey(route->methods, "DELETE") != 0);
+}
+
+
+/*
+    HEAD requests match GET routes. Routes for all methods match methods with and without rx flags.
+    Requests that no route accepts fall through to the default route for GET and POST and are otherwise rejected.
+ */
+static void testRouteMethods(MprTestGroup *gp)
+{
+    TestRoute   *tr;
+
+    tr = gp->data;
+    tassert(smatch(matchRoute(gp, "GET", "get"), "get"));
+    tassert(smatch(matchRoute(gp, "HEAD", "get"), "get"));
+    tassert(smatch(matchRoute(gp, "POST", "get"), "default"));
+    tassert(matchRoute(gp, "DELETE", "get") == 0);
+    tassert(testGetStatus(tr->response) == HTTP_CODE_BAD_METHOD);
+    tassert(matchRoute(gp, "PROPFIND", "get") == 0);
+
+    tassert(smatch(matchRoute(gp, "GET", "any"), "any"));
+    tassert(smatch(matchRoute(gp, "HEAD", "any"), "any"));
+    tassert(smatch(matchRoute(gp, "DELETE", "any"), "any"));
+    tassert(smatch(matchRoute(gp, "PROPFIND", "any"), "any"));
+
+    /* Methods without rx flags are matched by name */
+    tassert(smatch(matchRoute(gp, "PROPFIND", "custom"), "custom"));
+    tassert(smatch(matchRoute(gp, "GET", "custom"), "default"));
+    tassert(smatch(matchRoute(gp, "HEAD", "custom"), "default"));
+    tassert(matchRoute(gp, "DELETE", "custom") == 0);
+}
+
+
+/*
+    Equal atoms are the same pointer. Other strings are copied.
+ */
+static void testAtoms(MprTestGroup *gp)
+{
+    cchar   *atom, *str;
+    char    block[16];
+
+    atom = httpLookupAtom("GET");
+    tassert(atom != 0);
+    tassert(httpIntern("GET") == atom);
+    tassert(httpInternBlock("GET /index.html", 3) == atom);
+    tassert(httpLookupAtom("get") == 0);
+
+    tassert(httpLookupAtom("Content-Type") != 0);
+    tassert(httpLookupAtom("content-type") != 0);
+    tassert(httpLookupAtom("Content-Type") != httpLookupAtom("content-type"));
+
+    str = httpIntern("X-Custom-Header");
+    tassert(smatch(str, "X-Custom-Header"));
+    tassert(httpLookupAtom("X-Custom-Header") == 0);
+    tassert(httpIntern("X-Custom-Header") != str);
+
+    scopy(block, sizeof(block), "text/plain;");
+    tassert(httpInternBlock(block, 10) == httpLookupAtom("text/plain"));
+    str = httpInternBlock(block, 5);
+    tassert(smatch(str, "text/"));
+
+    atom = httpAddAtom("X-Test-Atom");
+    tassert(httpAddAtom("X-Test-Atom") == atom);
+    tassert(httpIntern("X-Test-Atom") == atom);
+}
+
+
+MprTestDef testHttpRoute = {
+    "route", 0, initRoute, 0,
+    {
+        MPR_TEST(0, testRouteMethodMask),
+        MPR_TEST(0, testRouteMethods),
+        MPR_TEST(0, testAtoms),
+        MPR_TEST(0, 0),
+    },
+};
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
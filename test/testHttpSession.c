@@ -0,0 +1,428 @@
+/**
+    testHttpSession.c - tests for session serialization, session stores and session versioning
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "http.h"
+
+/*********************************** Locals ***********************************/
+
+#define LIFESPAN    (60 * 1000)
+#define MAX_SIZE    1024
+
+typedef struct TestSession {
+    HttpRoute           *route;
+    HttpSessionStore    *store;
+    HttpSessionStore    *other;
+    HttpConn            *first;
+    HttpConn            *second;
+    MprHash             *data;
+    char                *path;
+} TestSession;
+
+static cchar *document =
+    "{\"user\":\"admin\",\"profile\":{\"name\":\"Example User\",\"locale\":\"en-US\"},"
+    "\"cart\":[{\"sku\":\"A100\",\"qty\":\"2\"},{\"sku\":\"B200\",\"qty\":\"1\"}],\"empty\":\"\"}";
+
+static void manageTestSession(TestSession *ts, int flags);
+
+/************************************ Code ************************************/
+
+static int initSession(MprTestGroup *gp)
+{
+    TestSession     *ts;
+
+    gp->data = ts = mprAllocObj(TestSession, manageTestSession);
+    httpCreate(HTTP_CLIENT_SIDE | HTTP_SERVER_SIDE);
+    ts->route = httpCreateRoute(NULL);
+    ts->path = sfmt("/tmp/testHttpSession-%d.shm", getpid());
+    return 0;
+}
+
+
+static int termSession(MprTestGroup *gp)
+{
+    TestSession     *ts;
+
+    ts = gp->data;
+    unlink(ts->path);
+    return 0;
+}
+
+
+static void manageTestSession(TestSession *ts, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(ts->route);
+        mprMark(ts->store);
+        mprMark(ts->other);
+        mprMark(ts->first);
+        mprMark(ts->second);
+        mprMark(ts->data);
+        mprMark(ts->path);
+    }
+}
+
+
+/*
+    Compare session data regardless of the order of keys
+ */
+static int sameData(MprHash *a, MprHash *b)
+{
+    MprKey      *kp, *other;
+
+    if (!a || !b || mprGetHashLength(a) != mprGetHashLength(b)) {
+        return 0;
+    }
+    for (ITERATE_KEYS(a, kp)) {
+        if ((other = mprLookupKeyEntry(b, kp->key)) == 0 || other->type != kp->type) {
+            return 0;
+        }
+        if (kp->type == MPR_JSON_STRING) {
+            if (!smatch(kp->data, other->data)) {
+                return 0;
+            }
+        } else if (!sameData((MprHash*) kp->data, (MprHash*) other->data)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+/*
+    Round trip and compare and set versioning common to all stores. The other store may be a second view of the
+    same sessions, as another server process would have.
+ */
+static void checkStore(MprTestGroup *gp, HttpSessionStore *store, HttpSessionStore *other)
+{
+    TestSession     *ts;
+    MprHash         *data;
+    int64           version, first, stale;
+
+    ts = gp->data;
+    ts->data = mprDeserialize(document);
+
+    version = 0;
+    tassert(store->write(store, "one", ts->data, LIFESPAN, &version) == 0);
+    tassert(version > 0);
+    first = version;
+
+    data = other->read(other, "one", &version);
+    tassert(sameData(data, ts->data));
+    tassert(version == first);
+    tassert(mprGetHashLength(mprLookupKey(data, "cart")) == 2);
+    tassert(smatch(mprLookupKey(mprLookupKey(data, "profile"), "locale"), "en-US"));
+
+    /* A write with the version that was read succeeds and creates a new version */
+    ts->data = mprDeserialize(document);
+    mprAddKey(ts->data, "user", sclone("guest"));
+    tassert(other->write(other, "one", ts->data, LIFESPAN, &version) == 0);
+    tassert(version > first);
+    data = store->read(store, "one", &version);
+    tassert(smatch(mprLookupKey(data, "user"), "guest"));
+
+    /* A write with a stale version is rejected and does not modify the session */
+    stale = first;
+    data = mprDeserialize("{\"user\":\"stale\"}");
+    tassert(store->write(store, "one", data, LIFESPAN, &stale) == MPR_ERR_BAD_STATE);
+    data = other->read(other, "one", &version);
+    tassert(smatch(mprLookupKey(data, "user"), "guest"));
+
+    /* Writing a new session over an existing one is also a conflict */
+    stale = 0;
+    tassert(store->write(store, "one", ts->data, LIFESPAN, &stale) == MPR_ERR_BAD_STATE);
+
+    /* Removal is seen by both views and the session may then be created again */
+    other->remove(other, "one");
+    tassert(store->read(store, "one", &version) == 0);
+    tassert(other->read(other, "one", &version) == 0);
+    version = 0;
+    tassert(store->write(store, "one", ts->data, LIFESPAN, &version) == 0);
+    tassert(store->count(store) == 1);
+
+    /* Expired sessions are not returned and may be created again */
+    version = 0;
+    tassert(store->write(store, "short", ts->data, 1, &version) == 0);
+    mprSleep(20);
+    tassert(other->read(other, "short", &version) == 0);
+    version = 0;
+    tassert(store->write(store, "short", ts->data, LIFESPAN, &version) == 0);
+
+    store->remove(store, "one");
+    store->remove(store, "short");
+}
+
+
+static void testMemoryStore(MprTestGroup *gp)
+{
+    TestSession     *ts;
+
+    ts = gp->data;
+    ts->store = httpCreateMemorySessionStore(4);
+    tassert(ts->store != 0);
+    checkStore(gp, ts->store, ts->store);
+    tassert(ts->store->count(ts->store) == 0);
+}
+
+
+static void testSharedStore(MprTestGroup *gp)
+{
+#if BIT_UNIX_LIKE
+    TestSession     *ts;
+    MprHash         *data;
+    char            *big;
+    int64           version;
+
+    ts = gp->data;
+    unlink(ts->path);
+    ts->store = httpCreateSharedSessionStore(ts->path, 64, MAX_SIZE);
+    ts->other = httpCreateSharedSessionStore(ts->path, 64, MAX_SIZE);
+    tassert(ts->store != 0 && ts->other != 0);
+    if (!ts->store || !ts->other) {
+        return;
+    }
+    checkStore(gp, ts->store, ts->other);
+
+    /* Stores with different limits cannot share the file */
+    tassert(httpCreateSharedSessionStore(ts->path, 32, MAX_SIZE) == 0);
+
+    /* Sessions that are too large are rejected */
+    big = mprAlloc(MAX_SIZE + 1);
+    memset(big, 'x', MAX_SIZE);
+    big[MAX_SIZE] = '\0';
+    data = mprCreateHash(0, 0);
+    mprAddKey(data, "big", big);
+    version = 0;
+    tassert(ts->store->write(ts->store, "big", data, LIFESPAN, &version) == MPR_ERR_WONT_FIT);
+    tassert(ts->other->read(ts->other, "big", &version) == 0);
+    ts->other = 0;
+#endif
+}
+
+
+/*
+    Prepare a request for a session
+ */
+static HttpConn *createRequest(MprTestGroup *gp, cchar *id)
+{
+    TestSession     *ts;
+    HttpConn        *conn;
+
+    ts = gp->data;
+    conn = httpCreateConn(MPR->httpService, NULL, gp->dispatcher);
+    conn->rx->route = ts->route;
+    if (id) {
+        conn->rx->cookie = sfmt("%s=%s", HTTP_SESSION_COOKIE, id);
+    }
+    return conn;
+}
+
+
+/*
+    Serializing into a buffer matches mprSerialize, including single quotes escaped either side of 16 byte blocks
+ */
+static void testSerialize(MprTestGroup *gp)
+{
+    MprHash     *data, *copy;
+    MprBuf      *buf;
+    cchar       *str;
+    char        *quotes;
+    ssize       len;
+
+    data = mprDeserialize(document);
+    mprAddKey(data, "quoted", sclone("it's a value with 'quotes' either side of the sixteen byte block's end"));
+    quotes = mprAlloc(41);
+    memset(quotes, '\'', 40);
+    quotes[40] = '\0';
+    mprAddKey(data, "quotes", quotes);
+
+    str = mprSerialize(data, 0);
+    tassert(scontains(str, sreplace(quotes, "'", "\\'")) != 0);
+    tassert(scontains(str, "it\\'s a value with \\'quotes\\' either side of the sixteen byte block\\'s end") != 0);
+    buf = mprCreateBuf(0, 0);
+    mprPutStringToBuf(buf, "prefix:");
+    len = mprSerializeInto(data, buf, 0);
+    tassert(len == slen(str));
+    tassert(mprGetBufLength(buf) == len + 7);
+    tassert(smatch(mprGetBufStart(buf), sjoin("prefix:", str, NULL)));
+
+    /* Reusing the buffer gives the same output */
+    mprFlushBuf(buf);
+    tassert(mprSerializeInto(data, buf, 0) == len);
+    tassert(smatch(mprGetBufStart(buf), str));
+
+    mprFlushBuf(buf);
+    str = mprSerialize(data, MPR_JSON_PRETTY | MPR_JSON_QUOTES);
+    tassert(mprSerializeInto(data, buf, MPR_JSON_PRETTY | MPR_JSON_QUOTES) == slen(str));
+    tassert(smatch(mprGetBufStart(buf), str));
+
+    data = mprDeserialize(document);
+    copy = mprDeserialize(mprSerialize(data, 0));
+    tassert(sameData(data, copy));
+}
+
+
+/*
+    Sessions are only written when modified. Reading a variable leaves the stored version unchanged.
+ */
+static void testSessionDirty(MprTestGroup *gp)
+{
+    TestSession     *ts;
+    HttpConn        *conn;
+    MprHash         *obj;
+    cchar           *id;
+    int64           version, current;
+
+    ts = gp->data;
+    ts->store = ((Http*) MPR->httpService)->sessionStore;
+
+    conn = ts->first = createRequest(gp, 0);
+    tassert(httpGetSession(conn, 1) != 0);
+    tassert(httpWriteSession(conn) == 0);
+    id = httpGetSessionID(conn);
+    tassert(ts->store->read(ts->store, id, &version) != 0);
+
+    conn = ts->first = createRequest(gp, id);
+    tassert(httpGetSessionVar(conn, "user", 0) == 0);
+    tassert(httpWriteSession(conn) == 0);
+    tassert(ts->store->read(ts->store, id, &current) != 0);
+    tassert(current == version);
+
+    conn = ts->first = createRequest(gp, id);
+    obj = mprCreateHash(0, 0);
+    mprAddKey(obj, "theme", sclone("dark"));
+    tassert(httpSetSessionVar(conn, "user", "admin") == 0);
+    httpSetSessionObj(conn, "prefs", obj);
+    tassert(httpWriteSession(conn) == 0);
+    tassert(ts->store->read(ts->store, id, &current) != 0);
+    tassert(current != version);
+    version = current;
+
+    /* The caller may modify a returned object, so getting one marks the session as modified */
+    conn = ts->first = createRequest(gp, id);
+    tassert(httpGetSessionObj(conn, "prefs") != 0);
+    tassert(httpWriteSession(conn) == 0);
+    tassert(ts->store->read(ts->store, id, &current) != 0);
+    tassert(current != version);
+
+    httpDestroySession(conn);
+    ts->first = 0;
+}
+
+
+/*
+    Concurrent requests for the one session each keep their own changes
+ */
+static void testSessionMerge(MprTestGroup *gp)
+{
+    TestSession     *ts;
+    HttpConn        *conn;
+    MprHash         *obj;
+    cchar           *id;
+
+    ts = gp->data;
+    ts->store = ((Http*) MPR->httpService)->sessionStore;
+
+    conn = ts->first = createRequest(gp, 0);
+    tassert(httpSetSessionVar(conn, "user", "admin") == 0);
+    tassert(httpSetSessionVar(conn, "count", "1") == 0);
+    tassert(httpSetSessionVar(conn, "old", "x") == 0);
+    tassert(httpWriteSession(conn) == 0);
+    id = httpGetSessionID(conn);
+    tassert(id != 0);
+
+    /* Two requests read the same version */
+    ts->first = createRequest(gp, id);
+    ts->second = createRequest(gp, id);
+    tassert(smatch(httpGetSessionVar(ts->first, "user", 0), "admin"));
+    tassert(smatch(httpGetSessionVar(ts->second, "user", 0), "admin"));
+
+    httpSetSessionVar(ts->first, "count", "2");
+    httpSetSessionVar(ts->first, "first", "yes");
+    httpSetSessionVar(ts->second, "count", "3");
+    httpSetSessionVar(ts->second, "second", "yes");
+    httpRemoveSessionVar(ts->second, "old");
+    obj = mprCreateHash(0, 0);
+    mprAddKey(obj, "theme", sclone("dark"));
+    httpSetSessionObj(ts->second, "prefs", obj);
+
+    tassert(httpWriteSession(ts->first) == 0);
+    tassert(httpWriteSession(ts->second) == 0);
+
+    /* A later request sees both sets of changes. The last writer wins for keys both modified. */
+    conn = ts->first = createRequest(gp, id);
+    tassert(smatch(httpGetSessionVar(conn, "user", 0), "admin"));
+    tassert(smatch(httpGetSessionVar(conn, "first", 0), "yes"));
+    tassert(smatch(httpGetSessionVar(conn, "second", 0), "yes"));
+    tassert(smatch(httpGetSessionVar(conn, "count", 0), "3"));
+    tassert(httpGetSessionVar(conn, "old", 0) == 0);
+    tassert((obj = httpGetSessionObj(conn, "prefs")) != 0);
+    tassert(smatch(mprLookupKey(obj, "theme"), "dark"));
+
+    /* Unmodified sessions are not written and keep their version */
+    ts->second = createRequest(gp, id);
+    httpGetSessionVar(ts->second, "user", 0);
+    tassert(httpWriteSession(ts->second) == 0);
+    tassert(httpWriteSession(ts->first) == 0);
+
+    /* A session removed by another request is written again with this request's data */
+    ts->second = createRequest(gp, id);
+    httpSetSessionVar(ts->second, "after", "removed");
+    ts->store->remove(ts->store, id);
+    tassert(httpWriteSession(ts->second) == 0);
+    conn = ts->first = createRequest(gp, id);
+    tassert(smatch(httpGetSessionVar(conn, "after", 0), "removed"));
+    httpDestroySession(conn);
+    ts->first = ts->second = 0;
+}
+
+
+MprTestDef testHttpSession = {
+    "session", 0, initSession, termSession,
+    {
+        MPR_TEST(0, testSerialize),
+        MPR_TEST(0, testMemoryStore),
+        MPR_TEST(0, testSharedStore),
+        MPR_TEST(0, testSessionDirty),
+        MPR_TEST(0, testSessionMerge),
+        MPR_TEST(0, 0),
+    },
+};
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -0,0 +1,562 @@
+/**
+    testHttpSsl.c - tests for the SSL session cache and session resumption
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "testHttp.h"
+
+#if BIT_PACK_SSL
+/*********************************** Locals ***********************************/
+
+#define TEST_SESSIONS   256
+#define TEST_SSL_PORT   18291
+#define TEST_SSL_URI    "https://127.0.0.1:18291"
+
+typedef struct TestSsl {
+    HttpEndpoint    *endpoint;
+    HttpConn        *conn;
+    MprSsl          *ssl;
+    char            *body;
+    char            *filePath;
+} TestSsl;
+
+/*
+    File sent by the file handler and the connector and socket flags of the last file response
+ */
+static char *filePath;
+static HttpStage *fileConnector;
+static int fileSockFlags;
+
+static void manageTestSsl(TestSsl *ts, int flags);
+
+/************************************ Code ************************************/
+
+static void helloAction(HttpConn *conn)
+{
+    httpSetContentType(conn, "text/plain");
+    httpWrite(conn->writeq, "Hello World\n");
+    httpFinalize(conn);
+}
+
+
+static int rewriteFile(HttpConn *conn)
+{
+    HttpTx      *tx;
+
+    tx = conn->tx;
+    tx->filename = sclone(filePath);
+    if (mprGetPathInfo(tx->filename, &tx->fileInfo) == 0) {
+        httpSetEntityLength(conn, tx->fileInfo.size);
+    }
+    return 0;
+}
+
+
+/*
+    Minimal file handler. The send connector transmits the file itself. Otherwise the file is read into memory.
+ */
+static void startFile(HttpQueue *q)
+{
+    HttpConn    *conn;
+    HttpTx      *tx;
+    char        *data;
+    ssize       len;
+
+    conn = q->conn;
+    tx = conn->tx;
+    fileConnector = tx->connector;
+    fileSockFlags = conn->sock->flags;
+    if (tx->connector == conn->http->sendConnector) {
+        httpPutForService(q, httpCreateEntityPacket(0, tx->fileInfo.size, NULL), HTTP_DELAY_SERVICE);
+    } else if ((data = mprReadPathContents(tx->filename, &len)) != 0) {
+        httpWriteBlock(q, data, len, HTTP_BUFFER);
+    }
+    httpFinalize(conn);
+}
+
+
+/*
+    Find a certificate or key in the test directory. Tests may be run from the top, test or test/api directories.
+ */
+static char *findTestFile(cchar *name)
+{
+    cchar   *dirs[] = { ".", "test", "..", NULL };
+    char    *path;
+    int     i;
+
+    for (i = 0; dirs[i]; i++) {
+        path = mprJoinPath(dirs[i], name);
+        if (mprPathExists(path, R_OK)) {
+            return path;
+        }
+    }
+    return 0;
+}
+
+
+/*
+    Create a secure endpoint using the test certificate
+ */
+static int initSsl(MprTestGroup *gp)
+{
+    TestSsl     *ts;
+    MprSsl      *ssl;
+    HttpRoute   *route;
+    HttpStage   *handler;
+    char        *certFile, *keyFile;
+
+    gp->data = ts = mprAllocObj(TestSsl, manageTestSsl);
+    if (testGetRoute() == 0) {
+        return MPR_ERR_CANT_OPEN;
+    }
+#if BIT_PACK_EST
+    if (!MPR->socketService->providers) {
+        /* The test program is linked with the SSL library rather than loading it as a module */
+        if (mprCreateEstModule() < 0) {
+            return MPR_ERR_CANT_INITIALIZE;
+        }
+        MPR->socketService->sslProvider = sclone("est");
+    }
+#endif
+    certFile = findTestFile("test.crt");
+    keyFile = findTestFile("test.key");
+    if (!certFile || !keyFile || !findTestFile("ca.crt") || !findTestFile("testca.crt")) {
+        mprError("Cannot find the test certificates");
+        return MPR_ERR_CANT_FIND;
+    }
+    ssl = mprCreateSsl(1);
+    mprSetSslCertFile(ssl, certFile);
+    mprSetSslKeyFile(ssl, keyFile);
+    if ((ts->endpoint = httpCreateConfiguredEndpoint(".", ".", "127.0.0.1", TEST_SSL_PORT)) == 0) {
+        return MPR_ERR_CANT_CREATE;
+    }
+    httpSecureEndpoint(ts->endpoint, ssl);
+    route = httpGetHostDefaultRoute(mprGetFirstItem(ts->endpoint->hosts));
+    httpSetRouteHandler(route, "actionHandler");
+    httpDefineAction("/ssl/hello", helloAction);
+
+    ts->filePath = filePath = certFile;
+    handler = httpCreateHandler(MPR->httpService, "sslFileHandler", NULL);
+    handler->rewrite = rewriteFile;
+    handler->start = startFile;
+    route = httpCreateInheritedRoute(route);
+    httpSetRoutePattern(route, "^/ssl/file", 0);
+    httpClearRouteStages(route, HTTP_STAGE_TX);
+    httpSetRouteHandler(route, "sslFileHandler");
+    httpFinalizeRoute(route);
+    if (httpStartEndpoint(ts->endpoint) < 0) {
+        return MPR_ERR_CANT_OPEN;
+    }
+    return 0;
+}
+
+
+static int termSsl(MprTestGroup *gp)
+{
+    TestSsl     *ts;
+
+    ts = gp->data;
+    if (ts->endpoint) {
+        httpStopEndpoint(ts->endpoint);
+        httpDestroyEndpoint(ts->endpoint);
+        ts->endpoint = 0;
+    }
+    return 0;
+}
+
+
+static void manageTestSsl(TestSsl *ts, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(ts->endpoint);
+        mprMark(ts->conn);
+        mprMark(ts->ssl);
+        mprMark(ts->body);
+        mprMark(ts->filePath);
+    }
+}
+
+
+/*
+    Create a client SSL configuration with a certificate authority from the test directory. Sessions are cached per 
+    configuration, so tests that need a full handshake use a configuration not used by other tests.
+ */
+static MprSsl *createClientSsl(MprTestGroup *gp, cchar *caFile, bool verify)
+{
+    TestSsl     *ts;
+
+    ts = gp->data;
+    ts->ssl = mprCreateSsl(0);
+    mprSetSslCaFile(ts->ssl, findTestFile(caFile));
+    mprVerifySslPeer(ts->ssl, verify);
+    mprVerifySslIssuer(ts->ssl, verify);
+    return ts->ssl;
+}
+
+
+/*
+    Issue a request on a new secure connection and return the response status. Returns zero if the connection fails.
+ */
+static int secureGet(MprTestGroup *gp, MprSsl *ssl, cchar *uri)
+{
+    TestSsl     *ts;
+    int         status;
+
+    ts = gp->data;
+    status = 0;
+    ts->body = 0;
+    ts->conn = httpCreateConn(MPR->httpService, NULL, gp->dispatcher);
+    if (httpConnect(ts->conn, "GET", sjoin(TEST_SSL_URI, uri, NULL), ssl) == 0) {
+        httpFinalizeOutput(ts->conn);
+        if (httpWait(ts->conn, HTTP_STATE_COMPLETE, TEST_TIMEOUT) == 0) {
+            status = httpGetStatus(ts->conn);
+            ts->body = httpReadString(ts->conn);
+        }
+    }
+    httpDestroyConn(ts->conn);
+    ts->conn = 0;
+    return status;
+}
+
+
+/*
+    Return the number of server private key operations. Only full handshakes use the private key.
+ */
+static int64 privateKeyOps()
+{
+    MprSslCryptoStats   stats;
+
+    mprGetSslCryptoStats(&stats);
+    return stats.submitted + stats.overflow;
+}
+
+
+static int store(MprSslCache *cache, cchar *id, cchar *data)
+{
+    return mprStoreSslSession(cache, (cuchar*) id, slen(id), data, slen(data) + 1);
+}
+
+
+/*
+    Return true if a session is in the cache and holds the expected data
+ */
+static bool lookup(MprSslCache *cache, cchar *id, cchar *data)
+{
+    char    buf[80];
+
+    if (mprLookupSslSession(cache, (cuchar*) id, slen(id), buf, sizeof(buf)) != slen(data) + 1) {
+        return 0;
+    }
+    return smatch(buf, data);
+}
+
+
+/*
+    Find a session ID in the same stripe as the given ID. With one session per stripe, storing an ID in the same
+    stripe evicts the first session.
+ */
+static char *findSameStripe(cchar *id, int start)
+{
+    MprSslCache         *probe;
+    MprSslCacheStats    stats;
+    char                *candidate;
+    int                 i;
+
+    for (i = start; i < start + 100 * MPR_SSL_CACHE_STRIPES; i++) {
+        probe = mprCreateSslCache(MPR_SSL_CACHE_STRIPES, 0);
+        candidate = sfmt("session-%d", i);
+        store(probe, id, "probe");
+        store(probe, candidate, "probe");
+        mprGetSslCacheStats(probe, &stats);
+        if (stats.evictions == 1) {
+            return candidate;
+        }
+    }
+    return 0;
+}
+
+
+/*
+    Sessions are found in their stripe after many stores, replaced by ID, and removed
+ */
+static void testSslCacheLookup(MprTestGroup *gp)
+{
+    MprSslCache         *cache;
+    MprSslCacheStats    stats;
+    char                buf[4];
+    int                 i;
+
+    cache = mprCreateSslCache(TEST_SESSIONS * 2, 0);
+    mprAddRoot(cache);
+    for (i = 0; i < TEST_SESSIONS; i++) {
+        tassert(store(cache, sfmt("id-%d", i), sfmt("data-%d", i)) == 0);
+    }
+    for (i = 0; i < TEST_SESSIONS; i++) {
+        tassert(lookup(cache, sfmt("id-%d", i), sfmt("data-%d", i)));
+    }
+    tassert(!lookup(cache, "unknown", "data"));
+    mprGetSslCacheStats(cache, &stats);
+    tassert(stats.sessions == TEST_SESSIONS);
+    tassert(stats.inserts == TEST_SESSIONS);
+    tassert(stats.hits == TEST_SESSIONS);
+    tassert(stats.misses == 1);
+    tassert(stats.evictions == 0);
+
+    /* Storing an existing ID replaces the session */
+    tassert(store(cache, "id-0", "replaced") == 0);
+    tassert(lookup(cache, "id-0", "replaced"));
+    mprGetSslCacheStats(cache, &stats);
+    tassert(stats.sessions == TEST_SESSIONS);
+
+    /* The buffer must hold the session state */
+    tassert(mprLookupSslSession(cache, (cuchar*) "id-1", 4, buf, sizeof(buf)) == MPR_ERR_WONT_FIT);
+
+    mprRemoveSslSession(cache, (cuchar*) "id-1", 4);
+    tassert(!lookup(cache, "id-1", "data-1"));
+    tassert(store(cache, "", "data") == MPR_ERR_BAD_ARGS);
+    mprRemoveRoot(cache);
+}
+
+
+/*
+    A full stripe evicts the least recently used session
+ */
+static void testSslCacheLru(MprTestGroup *gp)
+{
+    MprSslCache         *cache, *bounded;
+    MprSslCacheStats    stats;
+    char                *first, *second;
+    int                 i;
+
+    first = findSameStripe("lru", 0);
+    second = first ? findSameStripe("lru", (int) stoi(&first[8]) + 1) : 0;
+    tassert(first && second);
+    if (!first || !second) {
+        return;
+    }
+    /* Two sessions per stripe */
+    cache = mprCreateSslCache(MPR_SSL_CACHE_STRIPES * 2, 0);
+    mprAddRoot(cache);
+    tassert(store(cache, "lru", "lru") == 0);
+    tassert(store(cache, first, "first") == 0);
+
+    /* Using the oldest session makes the other session the least recently used */
+    tassert(lookup(cache, "lru", "lru"));
+    tassert(store(cache, second, "second") == 0);
+    tassert(lookup(cache, "lru", "lru"));
+    tassert(!lookup(cache, first, "first"));
+    tassert(lookup(cache, second, "second"));
+
+    mprGetSslCacheStats(cache, &stats);
+    tassert(stats.evictions == 1);
+    tassert(stats.sessions == 2);
+
+    mprRemoveRoot(cache);
+
+    /* The cache never holds more than its limit */
+    bounded = mprCreateSslCache(MPR_SSL_CACHE_STRIPES * 2, 0);
+    for (i = 0; i < TEST_SESSIONS; i++) {
+        store(bounded, sfmt("id-%d", i), "data");
+    }
+    mprGetSslCacheStats(bounded, &stats);
+    tassert(stats.sessions <= MPR_SSL_CACHE_STRIPES * 2);
+    tassert(stats.evictions == TEST_SESSIONS - stats.sessions);
+}
+
+
+/*
+    Expired sessions are not returned and are removed from the cache
+ */
+static void testSslCacheExpiry(MprTestGroup *gp)
+{
+    MprSslCache         *cache;
+    MprSslCacheStats    stats;
+
+    cache = mprCreateSslCache(0, 50);
+    mprAddRoot(cache);
+    tassert(store(cache, "expire", "data") == 0);
+    tassert(store(cache, "sweep", "data") == 0);
+    tassert(lookup(cache, "expire", "data"));
+    mprSleep(100);
+    tassert(!lookup(cache, "expire", "data"));
+
+    mprGetSslCacheStats(cache, &stats);
+    tassert(stats.expired == 1);
+    tassert(stats.misses == 1);
+    tassert(stats.sessions == 1);
+
+    /* An expired session is replaced by a new session with the same ID */
+    tassert(store(cache, "sweep", "new") == 0);
+    tassert(lookup(cache, "sweep", "new"));
+    mprRemoveRoot(cache);
+}
+
+
+#if BIT_PACK_EST
+/*
+    A client resumes its session with the server on the next connection. The resumed handshake is a short
+    handshake that does not use the server private key.
+ */
+static void testSslResume(MprTestGroup *gp)
+{
+    MprSsl      *ssl;
+    int64       ops;
+
+    ssl = createClientSsl(gp, "ca.crt", 0);
+    ops = privateKeyOps();
+    tassert(secureGet(gp, ssl, "/ssl/hello") == HTTP_CODE_OK);
+    tassert(privateKeyOps() == ops + 1);
+    tassert(secureGet(gp, ssl, "/ssl/hello") == HTTP_CODE_OK);
+    tassert(secureGet(gp, ssl, "/ssl/hello") == HTTP_CODE_OK);
+    tassert(privateKeyOps() == ops + 1);
+}
+
+
+/*
+    A session is only saved for resumption once the peer certificate is verified. Otherwise a later connection
+    could resume the session without presenting a certificate and so skip verification.
+ */
+static void testSslUnverifiedSession(MprTestGroup *gp)
+{
+    MprSsl      *ssl;
+
+    /* The test certificates have expired */
+    ssl = createClientSsl(gp, "ca.crt", 1);
+    tassert(secureGet(gp, ssl, "/ssl/hello") == 0);
+    tassert(secureGet(gp, ssl, "/ssl/hello") == 0);
+}
+
+
+/*
+    Server private key operations run on the crypto workers. The operation overflows to the socket dispatcher if no 
+    worker thread is available. A client that rejects the certificate never resumes, so every connection is a full 
+    handshake.
+ */
+static void testSslCryptoWorkers(MprTestGroup *gp)
+{
+    MprSslCryptoStats   before, after;
+    MprSsl              *ssl;
+    int                 i;
+
+    ssl = createClientSsl(gp, "ca.crt", 1);
+    for (i = 0; i < 2; i++) {
+        mprGetSslCryptoStats(&before);
+        tassert(secureGet(gp, ssl, "/ssl/hello") == 0);
+        mprGetSslCryptoStats(&after);
+        tassert(after.workers == BIT_MAX_SSL_CRYPTO_WORKERS);
+        tassert((after.submitted + after.overflow) == (before.submitted + before.overflow + 1));
+        tassert((after.completed - before.completed) == (after.submitted - before.submitted));
+        tassert(after.queued == 0);
+        tassert(after.cryptoTime >= before.cryptoTime);
+    }
+}
+
+
+/*
+    With no crypto workers, private key operations run on the socket dispatcher. This runs before tests where the 
+    client rejects the certificate, as the server may record those handshakes after the client has closed.
+ */
+static void testSslCryptoInline(MprTestGroup *gp)
+{
+    MprSslCryptoStats   before, after;
+    MprSsl              *ssl;
+
+    ssl = createClientSsl(gp, "testca.crt", 0);
+    mprSetSslCryptoWorkers(0);
+    mprGetSslCryptoStats(&before);
+    tassert(secureGet(gp, ssl, "/ssl/hello") == HTTP_CODE_OK);
+    mprGetSslCryptoStats(&after);
+    mprSetSslCryptoWorkers(BIT_MAX_SSL_CRYPTO_WORKERS);
+
+    tassert(after.workers == 0);
+    tassert(after.handshakes == before.handshakes + 1);
+    tassert(after.submitted == before.submitted);
+    tassert(after.overflow == before.overflow);
+}
+
+
+/*
+    Static files are sent with sendfile over TLS only if kernel TLS encrypts socket writes. EST cannot use kernel 
+    TLS, so its sockets keep user-space encryption and file responses use the net connector.
+ */
+static void testSslKernelTls(MprTestGroup *gp)
+{
+    TestSsl     *ts;
+    Http        *http;
+    HttpStage   *fileHandler;
+    MprSsl      *ssl;
+    int         status;
+
+    ts = gp->data;
+    http = MPR->httpService;
+    ssl = ts->endpoint->ssl;
+    mprSetSslKernelTls(ssl, 1);
+    fileHandler = http->fileHandler;
+    http->fileHandler = httpLookupStage(http, "sslFileHandler");
+    fileConnector = 0;
+    status = secureGet(gp, createClientSsl(gp, "ca.crt", 0), "/ssl/file");
+    http->fileHandler = fileHandler;
+    mprSetSslKernelTls(ssl, 0);
+
+    tassert(status == HTTP_CODE_OK);
+    tassert(smatch(ts->body, mprReadPathContents(ts->filePath, NULL)));
+    tassert(!(fileSockFlags & MPR_SOCKET_KTLS_TX));
+    tassert(fileConnector == http->netConnector);
+}
+#endif
+
+
+MprTestDef testHttpSsl = {
+    "ssl", 0, initSsl, termSsl,
+    {
+        MPR_TEST(0, testSslCacheLookup),
+        MPR_TEST(0, testSslCacheLru),
+        MPR_TEST(0, testSslCacheExpiry),
+#if BIT_PACK_EST
+        MPR_TEST(0, testSslResume),
+        MPR_TEST(0, testSslCryptoInline),
+        MPR_TEST(0, testSslUnverifiedSession),
+        MPR_TEST(0, testSslCryptoWorkers),
+        MPR_TEST(0, testSslKernelTls),
+#endif
+        MPR_TEST(0, 0),
+    },
+};
+#endif /* BIT_PACK_SSL */
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */
@@ -0,0 +1,309 @@
+/**
+    testHttpStore.c - tests for the persistent response store
+    Copyright (c) All Rights Reserved. See details at the end of the file.
+ */
+
+/********************************** Includes **********************************/
+
+#include    "testHttp.h"
+
+#if BIT_UNIX_LIKE
+/*********************************** Locals ***********************************/
+
+#define STORE_LIFESPAN  (60 * 60 * 1000)
+#define STORE_SIZE      ((MprOff) 16 * 1024 * 1024)
+#define STORE_SMALL     ((MprOff) 64 * 1024)     /* Small enough to compact after a few writes */
+#define STORE_COUNT     20
+#define BODY_SIZE       4096
+
+typedef struct TestStore {
+    HttpResponseStore   *store;
+    char                *path;
+    MprTime             modified;
+} TestStore;
+
+static void manageTestStore(TestStore *ts, int flags);
+
+/************************************ Code ************************************/
+
+static void removeStore(TestStore *ts)
+{
+    unlink(ts->path);
+    unlink(sjoin(ts->path, ".index", NULL));
+}
+
+
+static int initStore(MprTestGroup *gp)
+{
+    TestStore   *ts;
+
+    gp->data = ts = mprAllocObj(TestStore, manageTestStore);
+    httpCreate(HTTP_CLIENT_SIDE | HTTP_SERVER_SIDE);
+    ts->path = sfmt("/tmp/testHttpStore-%d.data", getpid());
+    /* Stored times have a resolution of seconds */
+    ts->modified = mprGetTime() / MPR_TICKS_PER_SEC * MPR_TICKS_PER_SEC;
+    return 0;
+}
+
+
+static int termStore(MprTestGroup *gp)
+{
+    TestStore   *ts;
+
+    ts = gp->data;
+    ts->store = 0;
+    removeStore(ts);
+    return 0;
+}
+
+
+static void manageTestStore(TestStore *ts, int flags)
+{
+    if (flags & MPR_MANAGE_MARK) {
+        mprMark(ts->store);
+        mprMark(ts->path);
+    }
+}
+
+
+static char *keyName(int i)
+{
+    return sfmt("/store/key-%d", i);
+}
+
+
+/*
+    Create a response with headers as saved by the cache filter and a body unique to the key
+ */
+static char *createContent(cchar *key, ssize *len)
+{
+    MprBuf      *buf;
+    int         i;
+
+    buf = mprCreateBuf(BODY_SIZE + 256, 0);
+    mprPutToBuf(buf, "X-Status: 200\nContent-Type: text/html\nX-Key: %s\n\n", key);
+    for (i = 0; mprGetBufLength(buf) < BODY_SIZE; i++) {
+        mprPutToBuf(buf, "<p>%s line %d</p>\n", key, i);
+    }
+    *len = mprGetBufLength(buf);
+    return mprMemdup(mprGetBufStart(buf), *len);
+}
+
+
+static int writeResponse(TestStore *ts, cchar *key)
+{
+    char    *data;
+    ssize   len;
+
+    data = createContent(key, &len);
+    return httpWriteResponseStore(ts->store, key, data, len, ts->modified, STORE_LIFESPAN);
+}
+
+
+/*
+    Check a stored response matches its content, including the body in the data file as sent by sendfile
+ */
+static bool matchResponse(TestStore *ts, cchar *key)
+{
+    HttpCachedResponse  *response;
+    char                *data, *body;
+    ssize               len, headerLen;
+
+    if ((response = httpReadResponseStore(ts->store, key)) == 0) {
+        return 0;
+    }
+    data = createContent(key, &len);
+    headerLen = slen(response->headers);
+    if (headerLen + response->length != len || memcmp(response->headers, data, headerLen) != 0 ||
+            memcmp(response->body, &data[headerLen], response->length) != 0 || response->modified != ts->modified) {
+        return 0;
+    }
+    body = mprAlloc(response->length);
+    return pread(response->file->fd, body, response->length, response->pos) == response->length &&
+        memcmp(body, &data[headerLen], response->length) == 0;
+}
+
+
+/*
+    Open the store as after a server restart
+ */
+static HttpResponseStore *reopen(TestStore *ts, MprOff maxSize)
+{
+    ts->store = httpOpenResponseStore(ts->path, maxSize);
+    return ts->store;
+}
+
+
+/*
+    Current responses are loaded when the store is reopened. Expired, removed and superseded responses are not.
+ */
+static void testStoreReopen(MprTestGroup *gp)
+{
+    TestStore           *ts;
+    HttpCachedResponse  *response;
+    int                 i;
+
+    ts = gp->data;
+    removeStore(ts);
+    tassert(reopen(ts, STORE_SIZE) != 0);
+    for (i = 0; i < STORE_COUNT; i++) {
+        tassert(writeResponse(ts, keyName(i)) == 0);
+    }
+    tassert(httpWriteResponseStore(ts->store, "short", "X-Status: 200\n\nshort", 20, ts->modified, 1) == 0);
+    tassert(httpWriteResponseStore(ts->store, "removed", "removed", 7, ts->modified, STORE_LIFESPAN) == 0);
+    tassert(httpWriteResponseStore(ts->store, "plain", "no headers", 10, ts->modified, STORE_LIFESPAN) == 0);
+    tassert(httpRemoveResponseStore(ts->store, "removed"));
+    tassert(httpReadResponseStore(ts->store, "removed") == 0);
+    tassert(httpWriteResponseStore(ts->store, keyName(0), "X-Status: 200\n\nold", 18, ts->modified,
+        STORE_LIFESPAN) == 0);
+    tassert(writeResponse(ts, keyName(0)) == 0);
+    mprSleep(5);
+
+    tassert(reopen(ts, STORE_SIZE) != 0);
+    for (i = 0; i < STORE_COUNT; i++) {
+        tassert(matchResponse(ts, keyName(i)));
+    }
+    tassert(httpReadResponseStore(ts->store, "short") == 0);
+    tassert(httpReadResponseStore(ts->store, "removed") == 0);
+    tassert((response = httpReadResponseStore(ts->store, "plain")) != 0);
+    if (response) {
+        tassert(*response->headers == '\0');
+        tassert(response->length == 10 && memcmp(response->body, "no headers", 10) == 0);
+    }
+}
+
+
+/*
+    A partially written index entry is ignored and later writes are loaded after it is truncated
+ */
+static void testStoreDamagedIndex(MprTestGroup *gp)
+{
+    TestStore   *ts;
+    MprFile     *file;
+    char        junk[20];
+
+    ts = gp->data;
+    file = mprOpenFile(sjoin(ts->path, ".index", NULL), O_WRONLY | O_APPEND, 0);
+    tassert(file != 0);
+    if (!file) {
+        return;
+    }
+    memset(junk, 0x5a, sizeof(junk));
+    mprWriteFile(file, junk, sizeof(junk));
+    mprCloseFile(file);
+
+    tassert(reopen(ts, STORE_SIZE) != 0);
+    tassert(matchResponse(ts, keyName(STORE_COUNT - 1)));
+    tassert(writeResponse(ts, "after") == 0);
+
+    tassert(reopen(ts, STORE_SIZE) != 0);
+    tassert(matchResponse(ts, "after"));
+    tassert(matchResponse(ts, keyName(STORE_COUNT - 1)));
+}
+
+
+/*
+    A record with damaged content is discarded when read. Other records are not affected.
+ */
+static void testStoreDamagedRecord(MprTestGroup *gp)
+{
+    TestStore           *ts;
+    HttpCachedResponse  *response;
+
+    ts = gp->data;
+    tassert(reopen(ts, STORE_SIZE) != 0);
+    tassert((response = httpReadResponseStore(ts->store, keyName(1))) != 0);
+    if (!response) {
+        return;
+    }
+    tassert(pwrite(response->file->fd, "X", 1, response->pos + 10) == 1);
+
+    tassert(reopen(ts, STORE_SIZE) != 0);
+    tassert(httpReadResponseStore(ts->store, keyName(1)) == 0);
+    tassert(matchResponse(ts, keyName(2)));
+
+    /* The discarded record stays removed */
+    tassert(reopen(ts, STORE_SIZE) != 0);
+    tassert(httpReadResponseStore(ts->store, keyName(1)) == 0);
+    tassert(matchResponse(ts, keyName(0)));
+}
+
+
+/*
+    Responses survive compaction of a full data file. A store full of current responses rejects writes.
+ */
+static void testStoreCompact(MprTestGroup *gp)
+{
+    TestStore   *ts;
+    char        *data;
+    ssize       len;
+    int         i;
+
+    ts = gp->data;
+    removeStore(ts);
+    tassert(reopen(ts, STORE_SMALL) != 0);
+    for (i = 0; i < 200; i++) {
+        if (writeResponse(ts, keyName(i % 4)) < 0) {
+            tassert(0);
+            break;
+        }
+    }
+    tassert(reopen(ts, STORE_SMALL) != 0);
+    for (i = 0; i < 4; i++) {
+        tassert(matchResponse(ts, keyName(i)));
+    }
+    for (i = 4; i < 40; i++) {
+        writeResponse(ts, keyName(i));
+    }
+    data = createContent("full", &len);
+    tassert(httpWriteResponseStore(ts->store, "full", data, len, ts->modified, STORE_LIFESPAN) == MPR_ERR_WONT_FIT);
+    removeStore(ts);
+}
+
+
+MprTestDef testHttpStore = {
+    "store", 0, initStore, termStore,
+    {
+        MPR_TEST(0, testStoreReopen),
+        MPR_TEST(0, testStoreDamagedIndex),
+        MPR_TEST(0, testStoreDamagedRecord),
+        MPR_TEST(0, testStoreCompact),
+        MPR_TEST(0, 0),
+    },
+};
+#endif /* BIT_UNIX_LIKE */
+
+/*
+    @copy   default
+
+    Copyright (c) Embedthis Software LLC, 2003-2013. All Rights Reserved.
+
+    This software is distributed under commercial and open source licenses.
+    You may use the Embedthis Open Source license or you may acquire a
+    commercial license from Embedthis Software. You agree to be fully bound
+    by the terms of either license. Consult the LICENSE.md distributed with
+    this software for full details.
+
+    This software is open source; you can redistribute it and/or modify it
+    under the terms of the GNU General Public License as published by the
+    Free Software Foundation; either version 2 of the License, or (at your
+    option) any later version. See the GNU General Public License for more
+    details at: http://embedthis.com/downloads/gplLicense.html
+
+    This program is distributed WITHOUT ANY WARRANTY; without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+    This GPL license does NOT permit incorporating this software into
+    proprietary programs. If you are unable to comply with the GPL, you must
+    acquire a commercial license to use this software. Commercial licenses
+    for this software and support services are available from Embedthis
+    Software at http://embedthis.com
+
+    Local variables:
+    tab-width: 4
+    c-basic-offset: 4
+    End:
+    vim: sw=4 ts=4 expandtab
+
+    @end
+ */